@@ -0,0 +1,120 @@
+#include "definitions.h"
+
+// The fixed velocity field.
+const double ADVECTION_X = 1.0;
+const double ADVECTION_Y = 0.3;
+
+BenchmarkDGWeakForm::BenchmarkDGWeakForm() : WeakForm<double>(1)
+{
+  add_matrix_form(new DGMatrixFormVol(0, 0));
+  add_vector_form(new DGVectorFormVol(0));
+  add_matrix_form_surf(new DGMatrixFormSurface(0, 0));
+  add_matrix_form_DG(new DGMatrixFormInterface(0, 0));
+}
+
+WeakForm<double>* BenchmarkDGWeakForm::clone() const
+{
+  return new BenchmarkDGWeakForm(*this);
+}
+
+double BenchmarkDGWeakForm::DGMatrixFormVol::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+                                                   Geom<double> *e, Func<double> **ext) const
+{
+  double result = 0.;
+  for (int i = 0; i < n; i++)
+    result += -wt[i] * u->val[i] * static_cast<BenchmarkDGWeakForm*>(wf)->a_dot_v(v->dx[i], v->dy[i]);
+  return result;
+}
+
+Ord BenchmarkDGWeakForm::DGMatrixFormVol::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                                              Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return wt[0] * u->val[0] * (v->dx[0] + v->dy[0]);
+}
+
+MatrixFormVol<double>* BenchmarkDGWeakForm::DGMatrixFormVol::clone() const
+{
+  return new BenchmarkDGWeakForm::DGMatrixFormVol(*this);
+}
+
+double BenchmarkDGWeakForm::DGVectorFormVol::value(int n, double *wt, Func<double> *u_ext[], Func<double> *v,
+                                                   Geom<double> *e, Func<double> **ext) const
+{
+  double result = 0.;
+  for (int i = 0; i < n; i++)
+    result += wt[i] * v->val[i];
+  return result;
+}
+
+Ord BenchmarkDGWeakForm::DGVectorFormVol::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                                              Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return wt[0] * v->val[0];
+}
+
+VectorFormVol<double>* BenchmarkDGWeakForm::DGVectorFormVol::clone() const
+{
+  return new BenchmarkDGWeakForm::DGVectorFormVol(*this);
+}
+
+double BenchmarkDGWeakForm::DGMatrixFormSurface::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+                                                       Geom<double> *e, Func<double> **ext) const
+{
+  double result = 0.;
+  for (int i = 0; i < n; i++)
+  {
+    double a_dot_n = static_cast<BenchmarkDGWeakForm*>(wf)->a_dot_v(e->nx[i], e->ny[i]);
+    result += wt[i] * static_cast<BenchmarkDGWeakForm*>(wf)->upwind_flux(u->val[i], 0., a_dot_n) * v->val[i];
+  }
+  return result;
+}
+
+Ord BenchmarkDGWeakForm::DGMatrixFormSurface::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                                                  Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return wt[0] * u->val[0] * v->val[0];
+}
+
+MatrixFormSurf<double>* BenchmarkDGWeakForm::DGMatrixFormSurface::clone() const
+{
+  return new BenchmarkDGWeakForm::DGMatrixFormSurface(*this);
+}
+
+double BenchmarkDGWeakForm::DGMatrixFormInterface::value(int n, double *wt, DiscontinuousFunc<double> *u, DiscontinuousFunc<double> *v,
+                                                         Geom<double> *e, DiscontinuousFunc<double> **ext) const
+{
+  double result = 0.;
+  for (int i = 0; i < n; i++)
+  {
+    double a_dot_n = static_cast<BenchmarkDGWeakForm*>(wf)->a_dot_v(e->nx[i], e->ny[i]);
+    double jump_v = (v->fn_central == NULL ? -v->val_neighbor[i] : v->val[i]);
+    if(u->fn_central == NULL)
+      result += wt[i] * static_cast<BenchmarkDGWeakForm*>(wf)->upwind_flux(0., u->val_neighbor[i], a_dot_n) * jump_v;
+    else
+      result += wt[i] * static_cast<BenchmarkDGWeakForm*>(wf)->upwind_flux(u->val[i], 0., a_dot_n) * jump_v;
+  }
+  return result;
+}
+
+Ord BenchmarkDGWeakForm::DGMatrixFormInterface::ord(int n, double *wt, DiscontinuousFunc<Ord> *u, DiscontinuousFunc<Ord> *v,
+                                                    Geom<Ord> *e, DiscontinuousFunc<Ord> **ext) const
+{
+  Ord jump_v = (v->fn_central == NULL ? v->val_neighbor[0] : v->val[0]);
+  Ord val_u = (u->fn_central == NULL ? u->val_neighbor[0] : u->val[0]);
+  return wt[0] * val_u * jump_v;
+}
+
+MatrixFormDG<double>* BenchmarkDGWeakForm::DGMatrixFormInterface::clone() const
+{
+  return new BenchmarkDGWeakForm::DGMatrixFormInterface(*this);
+}
+
+double BenchmarkDGWeakForm::a_dot_v(double vx, double vy) const
+{
+  return ADVECTION_X * vx + ADVECTION_Y * vy;
+}
+
+double BenchmarkDGWeakForm::upwind_flux(double u_cent, double u_neib, double a_dot_n) const
+{
+  return a_dot_n * (a_dot_n >= 0 ? u_cent : u_neib);
+}
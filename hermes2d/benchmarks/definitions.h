@@ -0,0 +1,71 @@
+#include "hermes2d.h"
+
+/* Namespaces used */
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+/* Linear advection in a constant velocity field, discretized with the upwind
+   flux - the DG assembling benchmark. A stripped-down version of the weak form
+   of the 10-linear-advection-dg-adapt test example: constant velocity, zero
+   inflow, so that the benchmark needs no boundary data. */
+
+class BenchmarkDGWeakForm : public WeakForm<double>
+{
+public:
+  BenchmarkDGWeakForm();
+  WeakForm<double>* clone() const;
+
+private:
+  class DGMatrixFormVol : public MatrixFormVol<double>
+  {
+  public:
+    DGMatrixFormVol(int i, int j) : MatrixFormVol<double>(i, j) {};
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    MatrixFormVol<double>* clone() const;
+  };
+
+  class DGVectorFormVol : public VectorFormVol<double>
+  {
+  public:
+    DGVectorFormVol(int i) : VectorFormVol<double>(i) {};
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    VectorFormVol<double>* clone() const;
+  };
+
+  class DGMatrixFormSurface : public MatrixFormSurf<double>
+  {
+  public:
+    DGMatrixFormSurface(int i, int j) : MatrixFormSurf<double>(i, j) {};
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    MatrixFormSurf<double>* clone() const;
+  };
+
+  class DGMatrixFormInterface : public MatrixFormDG<double>
+  {
+  public:
+    DGMatrixFormInterface(int i, int j) : MatrixFormDG<double>(i, j) {};
+
+    virtual double value(int n, double *wt, DiscontinuousFunc<double> *u, DiscontinuousFunc<double> *v, Geom<double> *e, DiscontinuousFunc<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, DiscontinuousFunc<Ord> *u, DiscontinuousFunc<Ord> *v, Geom<Ord> *e, DiscontinuousFunc<Ord> **ext) const;
+
+    MatrixFormDG<double>* clone() const;
+  };
+
+  double a_dot_v(double vx, double vy) const;
+
+  double upwind_flux(double u_cent, double u_neib, double a_dot_n) const;
+};
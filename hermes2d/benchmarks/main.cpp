@@ -0,0 +1,350 @@
+#define HERMES_REPORT_ALL
+#include "definitions.h"
+
+// Microbenchmark suite for the hot paths of the library, intended for
+// regression tracking across releases. All benchmarks run on a fixed,
+// deterministically refined unit-square mesh - there is no randomness, so
+// the timings of two builds are directly comparable.
+//
+// Benchmarks:
+//   - Space::assign_dofs (H1),
+//   - Traverse iteration over the mesh,
+//   - DiscreteProblem::assemble of an H1 (Poisson), an Hcurl (curl-curl)
+//     and a DG (upwind advection) problem,
+//   - the matrix solver on the assembled Poisson system,
+//   - Adapt::calc_err_est,
+//   - Linearizer::process_solution.
+//
+// Reported are milliseconds per repetition and nanoseconds per active
+// element; the matrix solver benchmark also reports the throughput on the
+// matrix and vector data it touches.
+//
+// For regression tracking across releases the run can also be recorded and
+// checked in a machine-readable way:
+//   benchmarks --append <file>
+//     appends one tab-separated record per benchmark to <file>:
+//     git describe of the build, benchmark id, ns/element, peak RSS in kB.
+//   benchmarks --compare <file> [--tolerance <percent>]
+//     compares this run against the most recent record of each benchmark in
+//     <file> and exits nonzero when one got slower by more than the given
+//     tolerance (default 10 %, meant to stay above timer and machine noise),
+//     so CI can gate on the exit code. Both options may be combined; the
+//     comparison runs before the new records are appended.
+
+#include <vector>
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace Hermes::Hermes2D::Views;
+
+#ifndef BENCHMARK_GIT_DESCRIBE
+#define BENCHMARK_GIT_DESCRIBE "unknown"
+#endif
+
+const int INIT_REF_NUM = 6;                       // 4^INIT_REF_NUM active elements.
+const int P_INIT = 2;                             // Polynomial degree of the H1 / Hcurl benchmarks.
+const int P_INIT_DG = 1;                          // Polynomial degree of the DG benchmark.
+
+static Hermes::Mixins::TimeMeasurable timer;
+
+// One measured result, kept for the --append / --compare handling.
+struct BenchmarkRecord
+{
+  std::string name;
+  double ns_per_element;
+};
+
+static std::vector<BenchmarkRecord> results;
+
+static void report(const char* name, double seconds, int reps, int elements, double mbytes = 0.)
+{
+  double ns_per_element = 1e9 * seconds / (double(reps) * elements);
+  printf("  %-32s %10.3f ms/rep %10.1f ns/element", name, 1e3 * seconds / reps, ns_per_element);
+  if(mbytes > 0.)
+    printf(" %10.1f MB/s", mbytes * reps / seconds);
+  printf("\n");
+
+  BenchmarkRecord record;
+  record.name = name;
+  record.ns_per_element = ns_per_element;
+  results.push_back(record);
+}
+
+// Peak resident set size of this process in kilobytes, 0 where unavailable.
+static long get_peak_rss_kb()
+{
+#ifndef WIN32
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+  return 0;
+}
+
+// Appends the records of this run to the results file.
+static bool append_results(const char* file_name)
+{
+  FILE* f = fopen(file_name, "at");
+  if(f == NULL)
+  {
+    printf("Cannot open '%s' for appending.\n", file_name);
+    return false;
+  }
+  long peak_rss = get_peak_rss_kb();
+  for(unsigned int i = 0; i < results.size(); i++)
+    fprintf(f, "%s\t%s\t%.2f\t%ld\n", BENCHMARK_GIT_DESCRIBE, results[i].name.c_str(), results[i].ns_per_element, peak_rss);
+  fclose(f);
+  return true;
+}
+
+// Compares this run against the most recent record of each benchmark in the
+// results file. Returns the number of benchmarks slower by more than the
+// tolerance (in percent).
+static int compare_results(const char* file_name, double tolerance)
+{
+  FILE* f = fopen(file_name, "rt");
+  if(f == NULL)
+  {
+    printf("Cannot open '%s' for comparison.\n", file_name);
+    return 0;
+  }
+
+  // the last record of each benchmark id wins
+  std::vector<BenchmarkRecord> previous;
+  char line[512];
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    // fields are tab-separated: git describe, id, ns/element, peak RSS
+    char* id = strchr(line, '\t');
+    if(id == NULL) continue;
+    id++;
+    char* value = strchr(id, '\t');
+    if(value == NULL) continue;
+    *value++ = '\0';
+
+    BenchmarkRecord record;
+    record.name = id;
+    record.ns_per_element = atof(value);
+
+    unsigned int j;
+    for(j = 0; j < previous.size(); j++)
+      if(previous[j].name == record.name)
+      {
+        previous[j] = record;
+        break;
+      }
+    if(j == previous.size())
+      previous.push_back(record);
+  }
+  fclose(f);
+
+  int regressions = 0;
+  for(unsigned int i = 0; i < results.size(); i++)
+    for(unsigned int j = 0; j < previous.size(); j++)
+      if(previous[j].name == results[i].name)
+      {
+        double change = 100. * (results[i].ns_per_element / previous[j].ns_per_element - 1.);
+        if(change > tolerance)
+        {
+          printf("REGRESSION  %-32s %.1f -> %.1f ns/element (+%.1f %%, tolerance %.1f %%)\n",
+            results[i].name.c_str(), previous[j].ns_per_element, results[i].ns_per_element, change, tolerance);
+          regressions++;
+        }
+        break;
+      }
+  if(regressions == 0)
+    printf("No regressions beyond %.1f %% against '%s'.\n", tolerance, file_name);
+  return regressions;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* append_file = NULL;
+  const char* compare_file = NULL;
+  double tolerance = 10.;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "--append") == 0 && i + 1 < argc)
+      append_file = argv[++i];
+    else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+      compare_file = argv[++i];
+    else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+      tolerance = atof(argv[++i]);
+    else
+    {
+      printf("Usage: %s [--append <file>] [--compare <file>] [--tolerance <percent>]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  // The fixed benchmark mesh: a unit square, uniformly refined.
+  Hermes::Hermes2D::Mesh mesh;
+  double2 vertices[4] = { { 0., 0. }, { 1., 0. }, { 1., 1. }, { 0., 1. } };
+  int4 quad_elements[1] = { { 0, 1, 2, 3 } };
+  std::string quad_markers[1] = { "Bulk" };
+  int2 boundary_edges[4] = { { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 } };
+  std::string boundary_markers[4] = { "Bdy", "Bdy", "Bdy", "Bdy" };
+  mesh.create(4, vertices, 0, NULL, NULL, 1, quad_elements, quad_markers, 4, boundary_edges, boundary_markers);
+
+  for(int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  int num_elements = mesh.get_num_active_elements();
+  printf("Benchmark mesh: %d active elements.\n", num_elements);
+
+  try
+  {
+    // Space::assign_dofs.
+    DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+    EssentialBCs<double> bcs(&bc_essential);
+    H1Space<double> space(&mesh, &bcs, P_INIT);
+    {
+      const int reps = 100;
+      timer.tick();
+      for(int i = 0; i < reps; i++)
+        space.assign_dofs();
+      timer.tick();
+      report("Space::assign_dofs (H1)", timer.last(), reps, num_elements);
+    }
+
+    // Mesh iteration. The Traverse class itself is internal (all of its
+    // interface is private, only accessible to its friends), so the element
+    // iteration is timed through the public Mesh interface it is built on.
+    {
+      const int reps = 1000;
+      // the sum prevents the compiler from dropping the loop
+      long checksum = 0;
+      timer.tick();
+      for(int i = 0; i < reps; i++)
+      {
+        Element* e;
+        for_all_active_elements(e, &mesh)
+          checksum += e->id;
+      }
+      timer.tick();
+      report("mesh iteration (active elements)", timer.last(), reps, num_elements);
+      if(checksum < 0)
+        printf("%ld\n", checksum);
+    }
+
+    // DiscreteProblem::assemble, H1 (Poisson).
+    WeakFormsH1::DefaultWeakFormPoisson<double> wf(HERMES_ANY, new Hermes::Hermes1DFunction<double>(1.0), new Hermes::Hermes2DFunction<double>(-1.0));
+    DiscreteProblemLinear<double> dp(&wf, &space);
+    SparseMatrix<double>* matrix = create_matrix<double>();
+    Vector<double>* rhs = create_vector<double>();
+    {
+      const int reps = 5;
+      timer.tick();
+      for(int i = 0; i < reps; i++)
+        dp.assemble(matrix, rhs);
+      timer.tick();
+      report("assemble H1 (Poisson)", timer.last(), reps, num_elements);
+    }
+
+    // Matrix solver on the assembled Poisson system.
+    {
+      const int reps = 5;
+      Hermes::Solvers::LinearMatrixSolver<double>* solver = create_linear_solver<double>(matrix, rhs);
+      timer.tick();
+      for(int i = 0; i < reps; i++)
+        solver->solve();
+      timer.tick();
+      // The data the solver reads: the CSC arrays and the right-hand side.
+      double mbytes = 0.;
+      try
+      {
+        mbytes = (matrix->get_nnz() * (sizeof(double) + sizeof(int)) + matrix->get_size() * (sizeof(int) + sizeof(double))) / 1048576.;
+      }
+      catch(Hermes::Exceptions::Exception&)
+      {
+        // The selected matrix type does not report its number of nonzeros.
+      }
+      report("matrix solver (Poisson)", timer.last(), reps, num_elements, mbytes);
+
+      // Adapt::calc_err_est.
+      Solution<double> sln;
+      Solution<double>::vector_to_solution(solver->get_sln_vector(), &space, &sln);
+      {
+        const int err_reps = 10;
+        Adapt<double> adaptivity(&space);
+        timer.tick();
+        for(int i = 0; i < err_reps; i++)
+          adaptivity.calc_err_est(&sln, &sln);
+        timer.tick();
+        report("Adapt::calc_err_est", timer.last(), err_reps, num_elements);
+      }
+
+      // Linearizer::process_solution.
+      {
+        const int lin_reps = 10;
+        Linearizer linearizer;
+        timer.tick();
+        for(int i = 0; i < lin_reps; i++)
+          linearizer.process_solution(&sln);
+        timer.tick();
+        report("Linearizer::process_solution", timer.last(), lin_reps, num_elements);
+      }
+
+      delete solver;
+    }
+    delete matrix;
+    delete rhs;
+
+    // DiscreteProblem::assemble, Hcurl (curl-curl plus mass).
+    {
+      const int reps = 3;
+      HcurlSpace<double> hcurl_space(&mesh, P_INIT);
+      WeakForm<double> wf_hcurl(1);
+      wf_hcurl.add_matrix_form(new WeakFormsHcurl::DefaultJacobianCurlCurl<double>(0, 0));
+      wf_hcurl.add_matrix_form(new WeakFormsHcurl::DefaultMatrixFormVol<double>(0, 0));
+      wf_hcurl.add_vector_form(new WeakFormsHcurl::DefaultVectorFormVol<double>(0));
+      DiscreteProblemLinear<double> dp_hcurl(&wf_hcurl, &hcurl_space);
+      SparseMatrix<double>* matrix_hcurl = create_matrix<double>();
+      Vector<double>* rhs_hcurl = create_vector<double>();
+      timer.tick();
+      for(int i = 0; i < reps; i++)
+        dp_hcurl.assemble(matrix_hcurl, rhs_hcurl);
+      timer.tick();
+      report("assemble Hcurl (curl-curl)", timer.last(), reps, num_elements);
+      delete matrix_hcurl;
+      delete rhs_hcurl;
+    }
+
+    // DiscreteProblem::assemble, DG (upwind advection).
+    {
+      const int reps = 5;
+      L2Space<double> l2_space(&mesh, P_INIT_DG);
+      BenchmarkDGWeakForm wf_dg;
+      DiscreteProblemLinear<double> dp_dg(&wf_dg, &l2_space);
+      SparseMatrix<double>* matrix_dg = create_matrix<double>();
+      Vector<double>* rhs_dg = create_vector<double>();
+      timer.tick();
+      for(int i = 0; i < reps; i++)
+        dp_dg.assemble(matrix_dg, rhs_dg);
+      timer.tick();
+      report("assemble DG (advection)", timer.last(), reps, num_elements);
+      delete matrix_dg;
+      delete rhs_dg;
+    }
+  }
+  catch(Hermes::Exceptions::Exception& e)
+  {
+    e.print_msg();
+    return -1;
+  }
+  catch(std::exception& e)
+  {
+    std::cout << e.what();
+    return -1;
+  }
+
+  int regressions = 0;
+  if(compare_file != NULL)
+    regressions = compare_results(compare_file, tolerance);
+  if(append_file != NULL)
+    if(!append_results(append_file))
+      return -1;
+
+  return regressions == 0 ? 0 : 1;
+}
@@ -127,6 +127,37 @@ namespace Hermes
       void set_norm_form(int i, int j, MatrixFormVolError* form);
       void set_norm_form(MatrixFormVolError* form);   ///< i = j = 0
 
+      /// Deterministic parallel error calculation: the contribution of every state
+      /// is kept on its own and the totals together with the element errors are
+      /// summed in the fixed state order once the parallel loop finishes. The
+      /// results are then bitwise identical between runs no matter how many
+      /// threads were used, at the cost of one pair of doubles per state and
+      /// component.
+      inline void set_deterministic_error_calculation() { this->deterministic_error_calculation = true; }
+
+      /// Fast error estimation: the error and norm integrals are evaluated at
+      /// roughly the solution order instead of the doubled order of the error
+      /// product, about halving the number of quadrature points. Refinement
+      /// decisions only need a couple of significant digits of the relative
+      /// error, so this is usually safe for the intermediate iterations; turn
+      /// it off again (the default) before the final accept/reject estimate.
+      inline void set_fast_error_estimation(bool to_set = true) { this->fast_error_estimation = to_set; }
+
+      /// Record the accepted refinements of every subsequent adapt() call into the
+      /// given file, appending one block per call. A later run starting from the
+      /// same initial meshes can replay the file with replay_refinement_trace()
+      /// and begin adapting from the refined spaces straight away - useful in
+      /// parameter sweeps that re-run near-identical adaptivity campaigns.
+      void set_refinement_trace_recording(const char* file_name);
+
+      /// Replay a refinement trace recorded by a previous run: the stored blocks
+      /// are applied through the bulk-refinement path, one adapt() call worth of
+      /// refinements at a time, and the dofs are reassigned at the end. The
+      /// spaces have to stand on the same meshes the trace was recorded on.
+      /// @param[in] file_name The trace file, \sa set_refinement_trace_recording().
+      /// @return The number of replayed blocks.
+      int replay_refinement_trace(const char* file_name);
+
       /// Type-safe version of calc_err_est() for one solution.
       /// @param[in] solutions_for_adapt - if sln and rsln are the solutions error of which is used in the function adapt().
       double calc_err_est(Solution<Scalar>*sln, Solution<Scalar>*rsln, bool solutions_for_adapt = true,
@@ -211,6 +242,12 @@ namespace Hermes
       Hermes::vector<ElementReference> regular_queue; ///< A queue of elements which should be processes. The queue had to be filled by the method fill_regular_queue().
       std::vector<ElementToRefine> last_refinements; ///< A vector of refinements generated during the last finished execution of the method adapt().
 
+      /// Appends one block of accepted refinements to the trace file.
+      /// \sa set_refinement_trace_recording()
+      void record_refinement_trace(const std::vector<ElementToRefine>& elems_to_refine);
+
+      std::string refinement_trace_file_name; ///< Empty when the recording is off. \sa set_refinement_trace_recording()
+
       /// Fixes refinements of a mesh which is shared among multiple components of a multimesh.
       /** If a mesh is shared among components, it has to be refined similarly in order to avoid inconsistency.
       *  \param[in] meshes An array of meshes of components.
@@ -230,6 +267,8 @@ namespace Hermes
       int num_act_elems;                    ///< A total number of active elements across all provided meshes.
       Solution<Scalar>* sln[H2D_MAX_COMPONENTS];    ///< Coarse solution.
       Solution<Scalar>* rsln[H2D_MAX_COMPONENTS];   ///< Reference solutions.
+      bool deterministic_error_calculation; ///< \sa set_deterministic_error_calculation()
+      bool fast_error_estimation;           ///< \sa set_fast_error_estimation()
       bool have_errors;                     ///< True if errors of elements were calculated.
       bool have_coarse_solutions;           ///< True if the coarse solutions were set.
       bool have_reference_solutions;        ///< True if the reference solutions were set.
@@ -0,0 +1,148 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+#ifndef __H2D_ADAPTIVITY_PIPELINE_H
+#define __H2D_ADAPTIVITY_PIPELINE_H
+
+#include "adapt.h"
+#include "../function/solution.h"
+#include "../projections/ogprojection.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// @ingroup g_adapt
+    /// Driver for the assemble-solve-estimate-adapt loop that overlaps
+    /// independent stages of consecutive iterations.
+    ///
+    /// Within one iteration the stages form a strict chain - the selector
+    /// needs the complete error estimate, the refinements invalidate the
+    /// element arrays the estimate was computed on, and the next reference
+    /// mesh is derived from the refined coarse mesh - so there is nothing
+    /// to overlap there. What can run concurrently is the teardown of the
+    /// previous iteration: once the new reference solution has been copied
+    /// out of the solver, the retired reference space, mesh, matrix and
+    /// factorization are only waiting to be deleted, and for large problems
+    /// freeing them (UMFPACK numeric objects in particular) takes a
+    /// noticeable fraction of an iteration. The driver hands them to a
+    /// background thread and proceeds with the projection, error estimation
+    /// and refinement selection while they are being dismantled. On Windows
+    /// the teardown runs inline and the loop degenerates to the usual
+    /// sequential form.
+    ///
+    /// The driver covers the common single-space linear case and solves the
+    /// reference problems with UMFPACK; it throws when the library is built
+    /// without it.
+    template<typename Scalar>
+    class HERMES_API AdaptivityPipeline : public Hermes::Mixins::Loggable
+    {
+    public:
+      /// Constructor.
+      /// \param[in] wf The weak formulation.
+      /// \param[in] space The coarse space; refined in place by the loop.
+      /// \param[in] adaptivity The error calculator / refinement executor for the space.
+      /// \param[in] selector The refinement selector passed to Adapt::adapt().
+      AdaptivityPipeline(const WeakForm<Scalar>* wf, Space<Scalar>* space,
+        Adapt<Scalar>* adaptivity, RefinementSelectors::Selector<Scalar>* selector);
+      virtual ~AdaptivityPipeline();
+
+      /// Relative error estimate (in percent) under which the loop stops.
+      void set_tolerance(double error_stop);
+
+      /// Upper bound on the number of iterations.
+      void set_max_iterations(int max_iterations);
+
+      /// Polynomial order increase of the reference spaces, \sa Space::ReferenceSpaceCreator.
+      void set_order_increase(unsigned int order_increase);
+
+      /// Parameters forwarded to Adapt::adapt().
+      void set_adapt_parameters(double threshold, int strat = 0, int regularize = -1);
+
+      /// Runs the loop, \return the number of iterations performed.
+      int run();
+
+      /// The coarse solution of the last finished iteration.
+      Solution<Scalar>* get_solution();
+
+      /// The reference solution of the last finished iteration.
+      Solution<Scalar>* get_ref_solution();
+
+      /// The error estimate (in percent) of the last finished iteration.
+      double get_error_estimate() const;
+
+    protected:
+      /// Assembles and solves the problem on ref_space, storing the result
+      /// in ref_sln and the solver structures in matrix / rhs / solver.
+      void solve_reference(Space<Scalar>* ref_space);
+
+      /// Reference-level structures of a finished iteration, deleted in the background.
+      struct RetiredIteration
+      {
+        Space<Scalar>* ref_space;
+        Mesh* ref_mesh;
+        SparseMatrix<Scalar>* matrix;
+        Vector<Scalar>* rhs;
+        Hermes::Solvers::LinearMatrixSolver<Scalar>* solver;
+      };
+
+      /// Hands the structures of the previous iteration to the teardown thread
+      /// (deletes them inline where pthreads are not available).
+      void retire(Space<Scalar>* ref_space, Mesh* ref_mesh, SparseMatrix<Scalar>* matrix,
+        Vector<Scalar>* rhs, Hermes::Solvers::LinearMatrixSolver<Scalar>* solver);
+
+      /// Waits for a pending teardown to finish.
+      void join_teardown();
+
+      static void* teardown_worker(void* data);
+
+      const WeakForm<Scalar>* wf;
+      Space<Scalar>* space;
+      Adapt<Scalar>* adaptivity;
+      RefinementSelectors::Selector<Scalar>* selector;
+
+      OGProjection<Scalar> projection;
+      Solution<Scalar> sln;
+      Solution<Scalar> ref_sln;
+
+      /// Solver structures of the iteration in progress, handed over to
+      /// RetiredIteration once the next reference solution exists.
+      SparseMatrix<Scalar>* matrix;
+      Vector<Scalar>* rhs;
+      Hermes::Solvers::LinearMatrixSolver<Scalar>* solver;
+
+      /// The reference space / mesh of the last iteration; kept alive because
+      /// ref_sln refers to them, deleted by the destructor or the next run().
+      Space<Scalar>* last_ref_space;
+      Mesh* last_ref_mesh;
+
+      double error_stop;
+      int max_iterations;
+      unsigned int order_increase;
+      double threshold;
+      int strat;
+      int regularize;
+      double error_estimate;
+
+#ifndef _WIN32
+      pthread_t teardown_thread;
+      bool teardown_pending;
+#endif
+    };
+  }
+}
+#endif
@@ -127,16 +127,21 @@ namespace Hermes
       ///
       /// Functions used for evaluating the actual error estimator forms for an active element or edge segment.
       ///
+      /// The array \c current_slns holds the solutions the forms are evaluated with - each
+      /// thread of the parallel sweep in \c calc_err_internal supplies its own clones here.
       double eval_volumetric_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
-                                       RefMap* rm);
+                                       RefMap* rm,
+                                       Solution<Scalar>** current_slns);
       double eval_boundary_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
                                      RefMap* rm,
-                                     SurfPos* surf_pos);
+                                     SurfPos* surf_pos,
+                                     Solution<Scalar>** current_slns);
       double eval_interface_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
                                       RefMap *rm,
                                       SurfPos* surf_pos,
                                       LightArray<NeighborSearch<Scalar>*>& neighbor_searches,
-                                      int neighbor_index);
+                                      int neighbor_index,
+                                      Solution<Scalar>** current_slns);
       double eval_solution_norm(typename Adapt<Scalar>::MatrixFormVolError* form,
                                 RefMap* rm,
                                 MeshFunction<Scalar>* sln);
@@ -169,6 +174,14 @@ namespace Hermes
       /// (<c>ignore_visited_segments == true</c>).
       bool ignore_visited_segments;
 
+      /// Per-marker quadrature order caps, keyed by the internal markers.
+      /// See set_interface_order_limit() / set_boundary_order_limit().
+      std::map<int, int> element_marker_order_limits;
+      std::map<int, int> boundary_marker_order_limits;
+
+      /// See set_interface_order_reduction().
+      bool interface_order_reduction;
+
       /// Calculates error estimates for each solution component, the total error estimate, and possibly also
       /// their normalizations. If called with a pair of solutions, the version from Adapt is used (this is e.g.
       /// done when comparing approximate solution to the exact one - in this case, we do not want to compute
@@ -244,6 +257,25 @@ namespace Hermes
         return &this->boundary_markers_conversion;
       }
 
+      /// Caps the quadrature order the interface estimators use on edges lying
+      /// between two elements with the given element (material) marker. The cap is
+      /// only applied when both elements adjacent to the edge have a capped marker;
+      /// edges at material interfaces keep the automatically determined order.
+      /// Useful when large homogeneous regions do not need the conservative order
+      /// the forms report.
+      void set_interface_order_limit(std::string element_marker, int order);
+
+      /// Caps the quadrature order the boundary estimators use on edges with the
+      /// given boundary marker.
+      void set_boundary_order_limit(std::string boundary_marker, int order);
+
+      /// Enables / disables (default) the automatic quadrature order reduction on
+      /// interfaces between elements of equal polynomial order with straight
+      /// (non-curved) geometry. On such edges the integrand is a polynomial of
+      /// exactly the order the estimator form reports and the padding added for the
+      /// inverse reference map is dropped.
+      void set_interface_order_reduction(bool to_set);
+
       /// Append volumetric error estimator form.
       ///
       /// For example, element residual norms may be represented by such a form.
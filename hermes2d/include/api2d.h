@@ -39,7 +39,8 @@ namespace Hermes
     {
       numThreads,
 			xmlSchemasDirPath,
-			precalculatedFormsDirPath
+			precalculatedFormsDirPath,
+			useOpenAddressingHashTables
     };
 
     /// API Class containing settings for the whole Hermes2D.
@@ -47,12 +47,21 @@ namespace Hermes
       /// Copy constructor.
       AsmList(const AsmList<Scalar> & other);
 
+      /// Capacity of the inline storage. Sized so that the assembly lists of the common
+      /// low-order elements (up to p = 6 on quads) fit without touching the heap; only
+      /// lists that outgrow it switch to malloc'ed arrays in enlarge().
+      static const unsigned int inline_cap = 64;
+
       int* idx;      ///< array of shape function indices
       int* dof;      ///< array of basis function numbers (DOFs)
       Scalar* coef;  ///< array of coefficients
       unsigned int cnt;       ///< the number of items in the arrays idx, dof and coef
       unsigned int cap;       ///< internal
 
+      int idx_buf[inline_cap];     ///< inline storage backing idx for small lists
+      int dof_buf[inline_cap];     ///< inline storage backing dof for small lists
+      Scalar coef_buf[inline_cap]; ///< inline storage backing coef for small lists
+
       /// Adds a record for one basis function (shape functions index, basis functions index, coefficient).
       void add_triplet(int i, int d, Scalar c);
 
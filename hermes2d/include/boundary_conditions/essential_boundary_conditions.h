@@ -68,7 +68,21 @@ namespace Hermes
       /// Get the current time for time-dependent boundary conditions.
       double get_current_time() const;
 
+      /// Marks the condition as constant in time. A space then caches the edge
+      /// coefficients projected from this condition and reuses them in
+      /// update_essential_bc_values() for as long as the space itself does not
+      /// change (i.e., its sequence number stays), instead of re-evaluating the
+      /// condition along every boundary edge each time step. Off by default;
+      /// DefaultEssentialBCConst marks itself automatically.
+      void set_time_invariant(bool to_set = true);
+
+      /// Returns true if the condition has been marked as constant in time.
+      bool is_time_invariant() const;
+
     protected:
+      /// True if the condition declared itself constant in time, see set_time_invariant().
+      bool time_invariant;
+
       /// Special case of a constant function.
       Scalar value_const;
 
@@ -74,8 +74,22 @@ namespace Hermes
         onlyNumber
       };
 
+      /// Choose a file format of the stored records.
+      enum RecordFileFormat
+      {
+        /// XML files (the default). Portable, but slow to write and large on disk.
+        fileFormatXML,
+        /// Compact binary snapshots (MeshReaderH2DBin, Space::save_bin, Solution::save_bin).
+        /// Much faster to write and smaller, intended for frequent checkpoints of large
+        /// calculations. Meshes with curved boundaries are not supported.
+        fileFormatBinary
+      };
+
       CalculationContinuity(IdentificationMethod identification_method);
 
+      /// Waits for a still running background writer (see set_asynchronous_saving()).
+      ~CalculationContinuity();
+
       /// One record of the calculation. Stores every information to resume a calculation from this one point.
       class HERMES_API Record
       {
@@ -178,6 +192,27 @@ namespace Hermes
       /// Returns the count of records.
       int get_num() const;
 
+      /// Setting of the file format used by all records saved / loaded from now on.
+      /// A record has to be loaded with the same format it was saved with.
+      static void set_record_file_format(RecordFileFormat record_file_formatToSet);
+
+      /// Turns on writing of records on a background thread (off by default).
+      /// add_record() then only snapshots the meshes and the solution coefficient
+      /// vectors into staging copies and returns; the files are written while the
+      /// calculation proceeds with the next time step. Spaces, lacking a deep-copy
+      /// facility, are still written directly, but these files hold just the
+      /// element orders and are small. Before staging the next record,
+      /// add_record() waits until the previous one is on the disk and re-throws
+      /// an exception the writer might have raised. Works with both file formats.
+      static void set_asynchronous_saving(bool to_set = true);
+
+      /// Blocks until the background writer (if any is running) has finished the
+      /// last record; an exception raised during the writing is re-thrown here.
+      /// Has to be called before loading the last record back or before the data
+      /// is needed complete on the disk (e.g. right before the process may get
+      /// preempted); the destructor calls it as well.
+      void wait_for_last_record();
+
       /// Setting of the names for the file stored.
       static void set_mesh_file_name(std::string mesh_file_nameToSet);
       static void set_space_file_name(std::string space_file_nameToSet);
@@ -186,6 +221,36 @@ namespace Hermes
       static void set_error_file_name(std::string error_file_nameToSet);
 
     private:
+      /// Format of the files stored.
+      static RecordFileFormat record_file_format;
+
+      /// Switch to writing of records on a background thread.
+      static bool asynchronous_saving;
+
+      /// Staging snapshot handed over to the background writer.
+      struct WriterTask
+      {
+        Record* record;
+        Hermes::vector<Mesh*> meshes;
+        Hermes::vector<Solution<Scalar>*> solutions;
+        double time_step;
+        double time_step_n_minus_one;
+        double error;
+        bool failed;
+        std::string error_message;
+      };
+
+      /// Snapshots the passed entities into a WriterTask and starts the
+      /// background writer for it.
+      void start_writer(Record* record, Hermes::vector<Mesh*> meshes, Hermes::vector<Solution<Scalar>*> slns, double time_step, double time_step_n_minus_one, double error);
+
+      /// Entry point of the background writer thread.
+      static void* writer_thread_func(void* continuity);
+
+      pthread_t writer_thread;
+      bool writer_running;
+      WriterTask* writer_task;
+
       /// Names for the file stored.
       static std::string mesh_file_name;
       static std::string space_file_name;
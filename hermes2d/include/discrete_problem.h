@@ -89,6 +89,165 @@ namespace Hermes
       /// If the cache should not be used for any reason.
       inline void set_do_not_use_cache() { this->do_not_use_cache = true; }
 
+      /// If per-thread scatter matrices should be used in parallel assembling.
+      /// Every thread then inserts local stiffness matrices into its own copy of the
+      /// matrix structure and the copies are summed once after all states are assembled,
+      /// so that the threads do not synchronize on individual matrix entries.
+      inline void set_use_scatter_matrices() { this->use_scatter_matrices = true; }
+
+      /// Deterministic parallel assembling: the results are bitwise identical between
+      /// runs regardless of the number of threads. All contributions are scattered
+      /// into per-thread copies of the matrix and the right-hand side, the state
+      /// stream is cut into fixed blocks, and every block enters the shared
+      /// structures in its fixed order once the thread that assembled it gets its
+      /// turn - so the floating-point summation order never depends on the
+      /// scheduling. Requires the states cache (\sa set_states_cache()) for a
+      /// reproducible state stream and cannot be combined with an assembling
+      /// deadline, whose cost-based ordering varies between runs. Costs roughly
+      /// the scatter copies plus the ordered flushes.
+      inline void set_deterministic_assembling() { this->deterministic_assembling = true; }
+
+      /// Assert that the dof structure of the spaces does not change between assemblings,
+      /// even when their seq numbers do (e.g. when time-dependent essential boundary
+      /// conditions are updated every time step). The sparse structure is then created
+      /// only once and subsequent assemblings skip straight to zero() and the numeric fill.
+      inline void set_reuse_matrix_structure() { this->reuse_matrix_structure = true; }
+
+      /// Incremental re-assembly: the scattered local contributions of every state are
+      /// stored and states untouched by the last adaptation replay them instead of
+      /// re-integrating. The caller asserts that the form values on unchanged elements
+      /// are identical between the assemblings (linear problems, or a projected previous
+      /// solution). Not available for DG forms.
+      inline void set_incremental_assembling() { this->incremental_assembling = true; }
+
+      /// Residual-only fast path: when only the right-hand side is assembled and a state
+      /// has no valid cache entry, the state is integrated with the quadrature order the
+      /// vector forms alone imply, without building the cache record a full assembly
+      /// prepares (precalculated trial functions for the matrix forms at their higher
+      /// order). Newton's method with a lagged Jacobian then pays vector-form-sized
+      /// residual evaluations instead of Jacobian-sized ones. Not available for DG forms.
+      inline void set_vector_only_fast_path() { this->vector_only_fast_path = true; }
+
+      /// Keep the flat array of multimesh traversal states between the assemblings.
+      /// In a Picard / Newton loop the same mesh tuple is traversed on every iteration;
+      /// with the cache on, the union decomposition is derived once and replayed (keyed
+      /// by the mesh sequence numbers) until some mesh changes. \sa Traverse::set_states_cache().
+      inline void set_states_cache() { this->states_cache = true; this->traverse_master.set_states_cache(true); }
+
+      /// Evaluate the Ord shadow arithmetic of every form once per distinct order
+      /// signature per assembly instead of once per element. Elements whose shape
+      /// function, previous-iteration solution and external function orders agree
+      /// resolve to the same quadrature order, so the memoized result is exact; the
+      /// caller asserts that no ord() override depends on anything beyond its
+      /// arguments. Worthwhile for forms with many terms.
+      inline void set_order_cache() { this->order_cache = true; }
+
+      /// Signature-grouped assembling (default: off). The assembly states are
+      /// reordered so that elements sharing the same mode and element-order
+      /// tuple are processed back to back. Within such a group every state
+      /// requests the same quadrature rule and the same shape-function orders,
+      /// so the precalculated tables and the order-dependent setup stay hot
+      /// instead of being re-derived on each change of order - typically a win
+      /// on meshes mixing a few distinct orders over many elements. The order
+      /// within each group keeps the traversal (mesh) ordering. Cost-priority
+      /// scheduling (a cost map from set_element_cost_accounting() together
+      /// with the assembling deadline) takes precedence over the grouping.
+      inline void set_batch_assembling() { this->batch_assembling = true; }
+
+      /// Split assembling of semilinear problems (default: off). The contributions
+      /// of forms marked linear (\sa Form::set_linear()) are assembled once, kept
+      /// in an internal matrix / vector pair and added to the result of every
+      /// subsequent assembling, which then integrates only the remaining forms.
+      /// The cached part is rebuilt whenever the spaces change and - for cached
+      /// forms marked time-dependent - whenever the time of the weak formulation
+      /// changes. Forms depending on their external functions
+      /// (\sa Form::set_ext_dependent()) are never cached, since the functions can
+      /// change without the assembling noticing. Not available together with DG
+      /// forms, matrix-free operation, incremental re-assembly or the assembling
+      /// deadline.
+      inline void set_split_assembling() { this->split_assembling = true; }
+
+      /// Drops the cached linear part of split assembling, forcing its re-assembly
+      /// on the next call. To be called when the data of a cached form changed in
+      /// a way the automatic validity checks cannot see.
+      void invalidate_split_assembling_cache();
+
+      /// Keep the u_ext Solutions between the assemblings instead of constructing
+      /// them anew for every call. As long as the spaces have not changed (checked
+      /// through their seq numbers), the retained Solutions already hold the right
+      /// element orders and array layout, so refreshing them with the new coefficient
+      /// vector skips all the per-call setup. Meant for Newton loops and Runge-Kutta
+      /// stage assemblings, where assemble() runs many times over fixed spaces.
+      inline void set_u_ext_pooling() { this->u_ext_pooling = true; }
+
+      /// Turn on adaptive quadrature order reduction (default: off). The Ord
+      /// calculus counts the previous-iterate solutions at the full element
+      /// order, but on elements where their monomial coefficients have decayed
+      /// (see Solution::get_effective_element_order()) the integrand is of
+      /// effectively lower degree. With this mode on, the element integration
+      /// order is lowered by the largest per-solution difference between the
+      /// stored and the effective order. rel_tolerance is the relative
+      /// coefficient magnitude below which a degree counts as decayed.
+      inline void set_adaptive_quadrature(double rel_tolerance = 1e-12)
+      {
+        this->adaptive_quadrature = true;
+        this->adaptive_quadrature_tolerance = rel_tolerance;
+      }
+
+      /// Turn on per-element cost accounting (default: off). Every assembled
+      /// state is timed and its wall-clock cost is accumulated per id of the
+      /// state's representative element, giving a spatial map of where the
+      /// assembly time goes - input for load-balancing diagnostics and for
+      /// tuning the parallel chunking. The map is rebuilt by every
+      /// assemble() call; retrieve it through get_element_costs() or export
+      /// it with dump_element_costs_vtk().
+      inline void set_element_cost_accounting() { this->element_cost_accounting = true; }
+
+      /// The cost map of the last accounted assembling (in seconds), indexed
+      /// by the representative element ids of the traversal - with a single
+      /// mesh simply by its element ids. NULL before the first accounted
+      /// assembling. \sa set_element_cost_accounting().
+      double* get_element_costs() const;
+
+      /// Number of entries of the cost map.
+      int get_element_costs_size() const;
+
+      /// Set a wall-clock budget in seconds for assemble() (default: off; pass 0
+      /// to turn it off again). With a budget set, the states are processed in
+      /// priority order - descending cost from the last accounted assembling
+      /// (\sa set_element_cost_accounting()), natural order when no cost map
+      /// exists yet - and the pass stops once the budget is spent. The
+      /// assembled structures then hold a usable partial update built from the
+      /// most expensive states; the states that were left over are remembered
+      /// and the next assemble() call continues with them without zeroing the
+      /// structures, so repeated calls complete the update incrementally.
+      /// Whether anything is left is reported by assembling_complete().
+      /// Implies the states cache, since the streaming traversal can neither
+      /// be reordered nor restarted in the middle.
+      inline void set_assembling_deadline(double seconds)
+      {
+        this->assembling_deadline = seconds;
+        if(seconds > 0.0)
+          this->set_states_cache();
+      }
+
+      /// False when the last deadline-bounded assemble() ran out of its budget
+      /// and left states unprocessed. \sa set_assembling_deadline().
+      bool assembling_complete() const;
+
+      /// The number of states the last assemble() left unprocessed.
+      int get_num_unassembled_states() const;
+
+      /// Drops the remembered unprocessed states: the next assemble() starts
+      /// a fresh full pass (and zeroes the structures as usual).
+      void reset_assembling_resume();
+
+      /// Export the cost map of the last accounted assembling in VTK format:
+      /// the active elements of the first space's mesh as cells carrying the
+      /// cost as CELL_DATA. Complements the point-data exports of
+      /// Views::Linearizer, since the accounted cost is constant per element.
+      void dump_element_costs_vtk(const char* filename) const;
+
       /// Get the weak forms.
       const WeakForm<Scalar>* get_weak_formulation() const;
 
@@ -127,6 +286,13 @@ namespace Hermes
       void assemble(Scalar* coeff_vec, Vector<Scalar>* rhs = NULL,
         bool force_diagonal_blocks = false, Table* block_weights = NULL);
 
+      /// Matrix-free application of the operator: calculates y = A x where A is the matrix
+      /// that assemble() would produce for the linearization point coeff_vec, element by
+      /// element, without ever materializing the global matrix. Memory consumption drops
+      /// from O(nnz) to O(ndof), which pays off for high polynomial degrees, e.g. when
+      /// feeding an iterative matrix solver. DG forms are not supported.
+      virtual void apply(const Scalar* x, Scalar* y, Scalar* coeff_vec = NULL);
+
       /// Light version passing NULL for the coefficient vector. External solutions
       /// are initialized with zeros.
       virtual void assemble(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs = NULL, bool force_diagonal_blocks = false,
@@ -149,6 +315,16 @@ namespace Hermes
       void deinit_assembling(PrecalcShapeset*** pss , PrecalcShapeset*** spss, RefMap*** refmaps, Solution<Scalar>*** u_ext, AsmList<Scalar>*** als, WeakForm<Scalar>** weakforms);
 
       /// The form will be assembled.
+      /// Resolves the string marker filters (areas) of all forms of the given weak
+      /// formulation instance into internal marker ids on the meshes of the spaces
+      /// the forms couple, so that form_to_be_assembled() compares plain integers
+      /// instead of querying the string-keyed conversion maps per element. Called
+      /// from init_assembling() on every thread instance of the weak formulation.
+      void resolve_form_areas(WeakForm<Scalar>* wf_instance);
+      /// Resolution of the areas of a single form. The second conversion is NULL
+      /// for vector forms, which filter on the mesh of a single space.
+      void resolve_form_areas(Form<Scalar>* form, const Mesh::MarkersConversion& conversion_m, const Mesh::MarkersConversion* conversion_n);
+
       bool form_to_be_assembled(MatrixForm<Scalar>* form, Traverse::State* current_state);
       bool form_to_be_assembled(MatrixFormVol<Scalar>* form, Traverse::State* current_state);
       bool form_to_be_assembled(MatrixFormSurf<Scalar>* form, Traverse::State* current_state);
@@ -182,25 +358,67 @@ namespace Hermes
         Traverse::State* current_state, AsmList<Scalar>** current_alsSurface, WeakForm<Scalar>* current_wf);
       
       /// Assemble one state.
-      void assemble_one_state(PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, 
+      void assemble_one_state(PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, Solution<Scalar>** current_u_ext,
         AsmList<Scalar>** current_als, Traverse::State* current_state, WeakForm<Scalar>* current_wf);
 
+      /// Assemble the vector forms of one state at their own integration order, bypassing
+      /// the cache. Used by the residual-only fast path, see set_vector_only_fast_path().
+      void assemble_one_state_vector_only(PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, Solution<Scalar>** current_u_ext,
+        AsmList<Scalar>** current_als, Traverse::State* current_state, AsmList<Scalar>** current_alsSurface, WeakForm<Scalar>* current_wf);
+
       /// Adjusts order to refmaps.
       void adjust_order_to_refmaps(Form<Scalar> *form, int& order, Hermes::Ord* o, RefMap** current_refmaps);
 
       /// Matrix volumetric forms - calculate the integration order.
       int calc_order_matrix_form(MatrixForm<Scalar>* mfv, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, Traverse::State* current_state);
 
+      /// Per-edge table of evaluated traces of the form-specific external functions,
+      /// keyed by (function, integration order). Several surface forms on one marker
+      /// typically list the same external functions; with the table passed down from
+      /// the surface loop, each distinct trace is initialized once per edge visit and
+      /// the forms get views into it. The surface loop owns the table and releases
+      /// the entries after the edge.
+      typedef std::map<std::pair<MeshFunction<Scalar>*, int>, Func<Scalar>*> SharedSurfaceTraces;
+
       /// Matrix volumetric forms - assemble the form.
+      /// \param[in] shared_traces If not NULL, traces of the form-specific external functions
+      /// are looked up / deposited there instead of being initialized and freed locally.
+      /// Flattens the per-point data of one initialized shape function into the
+      /// basis signature of a constant-coefficient cache record; with
+      /// signature == NULL the entries are only counted.
+      /// \sa ConstCoeffCacheRecord::fn_signature.
+      static int append_fn_signature(Func<double>* fn, int np, double* signature, int pos);
+
+      /// The basis signature of a whole local matrix: all test functions followed
+      /// by all basis functions, \sa append_fn_signature().
+      static int build_const_coeff_signature(Func<double>** test_fns, int cnt_i, Func<double>** base_fns, int cnt_j, int np, double* signature);
+
       virtual void assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
-      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
+      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights,
+      SharedSurfaceTraces* shared_traces = NULL);
+
+      /// Returns the zeroed local stiffness buffer of the calling thread, grown to at
+      /// least the given size. A multi-component weak form evaluates one local matrix
+      /// per block form per element; keeping one buffer per thread avoids an allocation
+      /// and deallocation for each of them. Returns NULL outside of assemble(), the
+      /// caller then allocates (and owns) the matrix as before.
+      Scalar** get_local_stiffness_scratch(unsigned int size);
 
       /// Vector volumetric forms - calculate the integration order.
       int calc_order_vector_form(VectorForm<Scalar>* mfv, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, Traverse::State* current_state);
 
       /// Vector volumetric forms - assemble the form.
-      void assemble_vector_form(VectorForm<Scalar>* form, int order, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext, 
-      AsmList<Scalar>* current_als, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
+      /// \param[in] shared_traces \sa assemble_matrix_form().
+      void assemble_vector_form(VectorForm<Scalar>* form, int order, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
+      AsmList<Scalar>* current_als, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights,
+      SharedSurfaceTraces* shared_traces = NULL);
+
+      /// \ingroup Helper methods inside {calc_order_*, assemble_*}
+      /// Appends the orders of the previous-iteration solutions and of the external
+      /// functions of a form to the signature (edge orders on surface states). Together
+      /// with the shape function orders appended by the callers, the signature determines
+      /// the result of the Ord shadow evaluation. \sa set_order_cache().
+      void calc_order_signature(Form<Scalar> *form, Solution<Scalar>** current_u_ext, Traverse::State* current_state, std::vector<int>& signature);
 
       /// \ingroup Helper methods inside {calc_order_*, assemble_*}
       /// Calculates orders for external functions.
@@ -247,12 +465,30 @@ namespace Hermes
       /// If other conditions apply.
       bool have_matrix;
 
+      /// The caller asserted an unchanged dof structure.
+      /// \sa set_reuse_matrix_structure()
+      bool reuse_matrix_structure;
+
+      /// The matrix instance the current sparse structure was created in.
+      SparseMatrix<Scalar>* structure_mat;
+
       /// There is a matrix form set on DG_INNER_EDGE area or not.
       bool DG_matrix_forms_present;
 
       /// There is a vector form set on DG_INNER_EDGE area or not.
       bool DG_vector_forms_present;
 
+      /// Reuse the u_ext Solutions across assemblings. \sa set_u_ext_pooling()
+      bool u_ext_pooling;
+
+      /// The retained u_ext Solutions, one array per thread, and the space seq
+      /// numbers they were built for. NULL until the first pooled assembling.
+      Solution<Scalar>*** u_ext_pool;
+      Hermes::vector<int> u_ext_pool_seqs;
+
+      /// Deletes the retained u_ext Solutions.
+      void free_u_ext_pool();
+
       /// Turn on Runge-Kutta specific handling of external functions.
       bool RungeKutta;
 
@@ -262,6 +498,23 @@ namespace Hermes
       /// Storing assembling info.
       SparseMatrix<Scalar>* current_mat;
       Vector<Scalar>* current_rhs;
+
+      /// Per-thread scatter matrices (NULL when the feature is not in use).
+      /// \sa set_use_scatter_matrices()
+      bool use_scatter_matrices;
+      SparseMatrix<Scalar>** scatter_mat;
+
+      /// Deterministic parallel assembling (NULL / 0 when the feature is not in use).
+      /// \sa set_deterministic_assembling()
+      bool deterministic_assembling;
+      Vector<Scalar>** scatter_rhs;
+      int deterministic_next_chunk;
+
+      /// Matrix-free operator application.
+      /// \sa apply()
+      bool matrix_free_apply;
+      const Scalar* apply_x;
+      Scalar** apply_y;
       bool current_force_diagonal_blocks;
       Table* current_block_weights;
 
@@ -294,12 +547,153 @@ namespace Hermes
         int* asmlistSurfaceCnt;
       };
 
+      /// Cache of local stiffness matrices of constant-coefficient volumetric forms.
+      /// Elements with an identical signature (mode, order, assembly lists, Jacobian
+      /// factors and baked basis data) share one record, so the quadrature loop runs
+      /// only once per signature.
+      /// \sa MatrixFormVol::set_const_coefficient()
+      class ConstCoeffCacheRecord
+      {
+      public:
+        void clear();
+        Scalar** values;
+        int cnt_i;
+        int cnt_j;
+        int* idx_i;
+        int* idx_j;
+        int n_quadrature_points;
+        double* jacobian_x_weights;
+        /// Per-point physical basis data (values and derivatives of every test and
+        /// basis function) flattened into one array. det(J) x weights alone does not
+        /// determine the local matrix of a form integrating derivatives - the
+        /// physical derivatives carry the inverse reference map of the element, and
+        /// two equal-area elements of different shapes would otherwise collide - so
+        /// the complete baked data enters the hit verification.
+        double* fn_signature;
+        int signature_length;
+        double signature_scale; ///< Largest magnitude in #fn_signature, sets the comparison tolerance.
+      };
+
+      std::map<uint64_t, ConstCoeffCacheRecord*> const_coeff_cache;
+
+      /// Scattered local contributions of one state, kept for incremental re-assembly.
+      /// The entries are stored as positions into the concatenated assembly lists of
+      /// the state, so they survive the global dof renumbering done by assign_dofs().
+      /// \sa set_incremental_assembling()
+      class StateContributionRecord
+      {
+      public:
+        StateContributionRecord();
+        Hermes::vector<int> matrix_pos_i;
+        Hermes::vector<int> matrix_pos_j;
+        Hermes::vector<Scalar> matrix_values;
+        Hermes::vector<int> rhs_pos;
+        Hermes::vector<Scalar> rhs_values;
+        /// Assembly list coefficients at recording time, for the validity check.
+        Hermes::vector<Scalar> coefs;
+        /// Which parts were assembled when the record was taken.
+        bool has_matrix;
+        bool has_rhs;
+      };
+
+      /// Record the local matrix contribution of the state being recorded.
+      void record_local_matrix(Scalar** local_matrix, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j);
+
+      /// Record one right-hand side contribution of the state being recorded.
+      void record_local_rhs(int dof, Scalar value);
+
+      /// Incremental re-assembly.
+      /// \sa set_incremental_assembling()
+      bool incremental_assembling;
+
+      /// Traversal states cache.
+      /// \sa set_states_cache()
+      bool states_cache;
+
+      /// Integration order memoization.
+      /// \sa set_order_cache()
+      bool order_cache;
+
+      /// Signature-grouped assembling.
+      /// \sa set_batch_assembling()
+      bool batch_assembling;
+
+      /// Coefficient-decay based quadrature order reduction.
+      /// \sa set_adaptive_quadrature()
+      bool adaptive_quadrature;
+      double adaptive_quadrature_tolerance;
+
+      /// Per-element cost accounting.
+      /// \sa set_element_cost_accounting()
+      bool element_cost_accounting;
+      /// The accumulated cost map, indexed by element id.
+      double* element_costs;
+      int element_costs_size;
+
+      /// Deadline-bounded assembling.
+      /// \sa set_assembling_deadline()
+      double assembling_deadline;
+      /// Indices (into the cached state stream) of the states the last
+      /// deadline-bounded pass left unprocessed, in priority order.
+      Hermes::vector<int> unassembled_states;
+      /// Identification of the state stream the remembered indices belong to;
+      /// a different stream (mesh change) invalidates the resume.
+      Traverse::State** deadline_states;
+      int deadline_num_states;
+      /// True between the resume decision and its validation in assemble() -
+      /// create_sparse_structure() must not zero the partially built structures.
+      bool deadline_resume_pending;
+
+      /// Per-thread local stiffness buffers, existing only during assemble().
+      /// \sa get_local_stiffness_scratch()
+      Scalar*** local_stiffness_scratch;
+      unsigned int* local_stiffness_scratch_size;
+
+      /// The master Traverse of assemble(). A member (instead of a local) so that
+      /// its states cache survives between the assemblings.
+      Traverse traverse_master;
+
+      /// Stored contributions, indexed by the id of the representing element of the state,
+      /// then by its sub-element index.
+      std::map<uint64_t, StateContributionRecord*>** state_contributions;
+
+      /// Per-thread record being filled for the current state (NULL = not recording).
+      StateContributionRecord** recording_contribution;
+
+      /// Per-thread dof -> position translation for the state being recorded.
+      std::map<int, int>* recording_dof_pos;
+
       std::map<uint64_t, CacheRecordPerSubIdx*>*** cache_records_sub_idx;
       CacheRecordPerElement*** cache_records_element;
       bool** cache_element_stored;
       int cache_size;
       bool do_not_use_cache;
 
+      /// See set_vector_only_fast_path().
+      bool vector_only_fast_path;
+
+      /// Split assembling. \sa set_split_assembling()
+      bool split_assembling;
+      /// Restriction of the current pass: 0 = all forms, 1 = the cacheable linear
+      /// forms only (the cache re-build), 2 = the remaining forms only.
+      int split_assembling_pass;
+      /// The cached contributions of the linear forms and the conditions they
+      /// were assembled under.
+      SparseMatrix<Scalar>* split_linear_mat;
+      Vector<Scalar>* split_linear_rhs;
+      Hermes::vector<int> split_linear_sp_seqs;
+      double split_linear_time;
+
+      /// Decides whether a form belongs to the cached linear part.
+      /// \sa set_split_assembling()
+      bool form_cacheable(Form<Scalar>* form) const;
+
+      /// Removes the forms of the other part (given by split_assembling_pass) from
+      /// the assembling lists of the given cloned weak formulation instance. The
+      /// form objects stay in the instance's list of all forms, whose indexing the
+      /// assembling relies on, and are freed with the instance.
+      void split_restrict_forms(WeakForm<Scalar>* wf_instance);
+
       /// Exception caught in a parallel region.
       Hermes::Exceptions::Exception* caughtException;
     
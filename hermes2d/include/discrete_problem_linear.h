@@ -52,7 +52,8 @@ namespace Hermes
       /// Methods different to those of the parent class.
       /// Matrix forms.
       virtual void assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
-      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
+      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights,
+      typename DiscreteProblem<Scalar>::SharedSurfaceTraces* shared_traces = NULL);
 
       template<typename T> friend class KellyTypeAdapt;
       template<typename T> friend class NewtonSolver;
@@ -71,6 +71,23 @@ namespace Hermes
         return value (x, y);
       };
 
+      /// Batched evaluation of the value at n points. The default runs the
+      /// point-wise value() in a loop; override it to route the evaluation
+      /// through a vectorized implementation - special functions (Bessel etc.)
+      /// evaluated over whole arrays by vector math libraries are typically
+      /// several times faster than n virtual calls. The batch is used whenever
+      /// the solution is precalculated at the quadrature points, which includes
+      /// projection onto a space and error computation against the reference.
+      virtual void values (const double* x, const double* y, int n, Scalar* out) const;
+
+      /// Batched variant of exact_function(). The default obtains the values
+      /// through the values() batch and the derivatives point by point, so
+      /// overriding values() alone already vectorizes the value part; override
+      /// this one as well to batch the derivatives too. All the output arrays
+      /// hold n entries.
+      virtual void exact_functions (const double* x, const double* y, int n,
+        Scalar* out, Scalar* out_dx, Scalar* out_dy) const;
+
       /// Function returning the integration order that
       /// should be used when integrating the function.
       virtual Hermes::Ord ord(Hermes::Ord x, Hermes::Ord y) const = 0;
@@ -98,6 +115,15 @@ namespace Hermes
         return value (x, y);
       };
 
+      /// Batched variant of exact_function() for the two components, filled
+      /// into separate arrays of n entries each. The default loops the
+      /// point-wise evaluation; overriding it allows routing the whole batch
+      /// through a vectorized special-function implementation, see
+      /// ExactSolutionScalar::values().
+      virtual void exact_functions (const double* x, const double* y, int n,
+        Scalar* out_0, Scalar* out_1, Scalar* out_dx_0, Scalar* out_dx_1,
+        Scalar* out_dy_0, Scalar* out_dy_1) const;
+
       /// Function returning the integration order that
       /// should be used when integrating the function.
       virtual Hermes::Ord ord(Hermes::Ord x, Hermes::Ord y) const = 0;
@@ -117,6 +143,9 @@ namespace Hermes
       virtual Ord ord(Ord x, Ord y) const;
       virtual MeshFunction<Scalar>* clone() const;
 
+      /// Reports the constant, see MeshFunction::get_constant_values().
+      virtual bool get_constant_values(Scalar* values) const;
+
       /// Saves the exact solution to an XML file.
       void save(const char* filename) const;
 
@@ -138,6 +167,9 @@ namespace Hermes
       virtual Ord ord(Ord x, Ord y) const;
       virtual MeshFunction<Scalar>* clone() const;
 
+      /// Reports the zero value, see MeshFunction::get_constant_values().
+      virtual bool get_constant_values(Scalar* values) const;
+
       /// Saves the exact solution to an XML file.
       void save(const char* filename) const;
     };
@@ -156,6 +188,9 @@ namespace Hermes
       virtual Ord ord(Ord x, Ord y) const;
       virtual MeshFunction<Scalar>* clone() const;
 
+      /// Reports the constants, see MeshFunction::get_constant_values().
+      virtual bool get_constant_values(Scalar* values) const;
+
       /// Saves the exact solution to an XML file.
       void save(const char* filename) const;
     protected:
@@ -177,6 +212,9 @@ namespace Hermes
       virtual Ord ord(Ord x, Ord y) const;
       virtual MeshFunction<Scalar>* clone() const;
 
+      /// Reports the zero values, see MeshFunction::get_constant_values().
+      virtual bool get_constant_values(Scalar* values) const;
+
       /// Saves the exact solution to an XML file.
       void save(const char* filename) const;
     };
@@ -45,6 +45,17 @@ namespace Hermes
 
       virtual void reinit();
 
+      /// Turns caching of this filter's results across element visits on / off
+      /// (default: off). With caching on, the precalculated tables of the last
+      /// four visited elements are kept (the same scheme Solution uses) instead
+      /// of being discarded on every set_active_element() call, so a filter
+      /// consumed by several modules within one iteration - e.g. a MagFilter
+      /// read by both Adapt and a Linearizer - evaluates each element only
+      /// once. The cache is dropped as soon as a source function changes, as
+      /// detected through Solution::get_sln_seq(); for sources that are not
+      /// Solutions the sequence number of their mesh is used instead.
+      void set_result_caching(bool to_set = true);
+
       /// State querying helpers.
       inline std::string getClassName() const { return "Filter"; }
 
@@ -82,6 +93,33 @@ namespace Hermes
       std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*> tables[H2D_MAX_QUADRATURES];
 #endif
 
+      /// Element-keyed variant of the tables above, used instead of them when
+      /// result caching is on. The four slots form the same element cache as
+      /// in Solution::set_active_element(). \sa set_result_caching().
+#ifdef _MSC_VER // For Visual Studio compiler the latter does not compile.
+      std::map<uint64_t, LightArray<Node*>*>* elem_tables[H2D_MAX_QUADRATURES][4];
+#else
+      std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>* elem_tables[H2D_MAX_QUADRATURES][4];
+#endif
+
+      /// Elements the slots of elem_tables belong to.
+      Element* table_elems[H2D_MAX_QUADRATURES][4];
+
+      int oldest_table[H2D_MAX_QUADRATURES];
+
+      /// Sequence numbers of the source functions at the time the cached
+      /// tables were computed. \sa set_result_caching().
+      int source_seqs[H2D_MAX_COMPONENTS];
+
+      /// \sa set_result_caching().
+      bool result_caching;
+
+      /// Returns the current sequence number of the i-th source function.
+      int get_source_seq(int i) const;
+
+      /// Frees the element-keyed tables. \sa set_result_caching().
+      void free_elem_tables();
+
       bool unimesh;
 
       UniData** unidata;
@@ -121,6 +159,15 @@ namespace Hermes
 
       virtual Func<Scalar>* get_pt_value(double x, double y, Element* e = NULL);
 
+      /// Turns fused evaluation of nested filters on / off (default: off).
+      /// When on and an input of this filter is itself a SimpleFilter used
+      /// through its values (item H2D_FN_VAL_0), the whole chain is evaluated
+      /// in one pass per element: the nested combining functions write into
+      /// scratch buffers consumed immediately by this filter, instead of each
+      /// filter in the chain materializing its own precalculated table.
+      /// Scalar-valued chains only; other inputs keep the table-based path.
+      void set_fused_evaluation(bool to_set = true);
+
     protected:
       int item[H2D_MAX_COMPONENTS];
 
@@ -129,6 +176,13 @@ namespace Hermes
       void init_components();
       virtual void precalculate(int order, int mask);
 
+      /// Fills 'out' with the value table of this filter for the given
+      /// quadrature order without storing it in this filter's tables,
+      /// recursing into nested SimpleFilters. \sa set_fused_evaluation().
+      void calc_value_table(int order, int np, Scalar* out);
+
+      /// \sa set_fused_evaluation().
+      bool fused_evaluation;
     };
 
     /// @ingroup meshFunctions
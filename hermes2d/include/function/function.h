@@ -155,7 +155,18 @@ namespace Hermes
       /// \param mask[in] A combination of one or more of the constants H2D_FN_VAL, H2D_FN_DX, H2D_FN_DY,
       ///   H2D_FN_DXX, H2D_FN_DYY, H2D_FN_DXY specifying the values which should be precalculated. The default is
       ///   H2D_FN_VAL | H2D_FN_DX | H2D_FN_DY. You can also use H2D_FN_ALL to precalculate everything.
-      void set_quad_order(unsigned int order, int mask = H2D_FN_DEFAULT);
+      virtual void set_quad_order(unsigned int order, int mask = H2D_FN_DEFAULT);
+
+      /// Precalculates the tables of the whole current transform chain at once.
+      /// Walks the transform stack from the untransformed element down to the current
+      /// sub-element and fills every per-sub-element Node table that misses the given
+      /// integration rule, so that subsequent pop_transform() / set_transform() calls
+      /// within the chain find their values already computed. Intended for multi-mesh
+      /// assembling with deep sub-element transforms, where the levels of one chain are
+      /// revisited many times during a single traversal. The method finishes at the
+      /// current level, i.e. it has the same effect on the visible state as a plain
+      /// set_quad_order() call with the same arguments.
+      virtual void precalculate_transform_chain(unsigned int order, int mask = H2D_FN_DEFAULT);
 
       Scalar* get_values(int a, int b);
 
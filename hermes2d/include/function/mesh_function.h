@@ -62,6 +62,26 @@ namespace Hermes
       /// Return the value at the coordinates x,y.
       virtual Func<Scalar>* get_pt_value(double x, double y, Element* e = NULL) = 0;
 
+      /// Evaluate the function at n points at once.
+      /// The points are grouped by their containing element first, so that every
+      /// element is located in the mesh only once and then passed as the hint to
+      /// get_pt_value() for all of its points. The value at the i-th point is
+      /// stored in out[i]; the item parameter selects the component and the
+      /// value type (function value or a first derivative) the same way as in
+      /// get_values(). Points outside the domain yield zero. Intended for
+      /// post-processing probes over many points, where the per-point element
+      /// lookup dominates.
+      virtual void eval_points(const double* x, const double* y, int n, Scalar* out, int item = H2D_FN_VAL_0);
+
+      /// A function that is constant in space may report so here by filling in
+      /// the component values (1 or 2 of them, see get_num_components()) and
+      /// returning true. init_fn() then fills the Func arrays straight from
+      /// the constants and skips the per-element value table precalculation;
+      /// the forms see the same values either way. User code (filters, forms)
+      /// may query this too, e.g. to skip terms multiplied by a known zero.
+      /// The base class returns false.
+      virtual bool get_constant_values(Scalar* values) const { return false; }
+
       /// Cloning function - for parallel OpenMP blocks.
       /// Designed to return an identical clone of this instance.
       virtual MeshFunction<Scalar>* clone() const
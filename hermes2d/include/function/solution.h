@@ -73,7 +73,7 @@ namespace Hermes
     /// 'p' is the polynomial degree.
     ///
     template<typename Scalar>
-    class HERMES_API Solution : public MeshFunction<Scalar>, public Hermes2D::Mixins::XMLParsing
+    class HERMES_API Solution : public MeshFunction<Scalar>, public Hermes2D::Mixins::XMLParsing, public Hermes::MemoryAccounted
     {
     public:
       Solution();
@@ -101,6 +101,36 @@ namespace Hermes
       /// restores the solution in the memory.
       void load(const char* filename, Space<Scalar>* space);
 
+      /// Saves the solution in a compact binary format: a small versioned header followed by the
+      /// raw monomial coefficient and element order arrays. Much faster and smaller than the XML
+      /// save(), intended for frequent checkpointing of large calculations. The format is tied
+      /// to the scalar type (real / complex); exact solutions cannot be stored this way.
+      void save_bin(const char* filename) const;
+
+      /// Loads the solution from a file previously created by Solution::save_bin().
+      void load_bin(const char* filename, Space<Scalar>* space);
+
+      /// Turn on or off the lazy per-element conversion mode. Off by default.
+      /// When on, set_coeff_vector() (and therefore vector_to_solution()) only lays out
+      /// the coefficient tables and keeps the dof vector; the monomial coefficients of
+      /// an element are computed on its first access. Repeatedly rebuilt solutions of
+      /// which only a part is ever evaluated - Newton / Picard iterates, solutions that
+      /// are only visualized or probed along a line - then skip the conversion of the
+      /// untouched elements altogether. Copies made by clone() do not copy the monomial
+      /// tables at all, each converts just the elements it visits. The space passed to
+      /// set_coeff_vector() has to stay alive while unconverted elements remain.
+      /// \param[in] onOff on(true) - convert lazily, off(false) - convert everything up front.
+      void use_lazy_conversion(bool onOff);
+
+      /// Turn on or off the memory-mapped loading in load_bin(). Off by default.
+      /// When on (POSIX systems only), load_bin() maps the file copy-on-write and points the
+      /// internal coefficient and element order arrays directly at the mapping instead of
+      /// copying them, which makes reloading a saved state near-instant. The mapping is held
+      /// until the solution is freed; writes to the arrays stay private to this process.
+      /// On platforms without mmap the flag is ignored and load_bin() reads the file as usual.
+      /// \param[in] onOff on(true) - map the file, off(false) - read the file.
+      void set_mmap_loading(bool onOff);
+
       /// Returns solution value or derivatives at element e, in its reference domain point (xi1, xi2).
       /// 'item' controls the returned value: 0 = value, 1 = dx, 2 = dy, 3 = dxx, 4 = dyy, 5 = dxy.
       /// NOTE: This function should be used for postprocessing only, it is not effective
@@ -120,6 +150,15 @@ namespace Hermes
       /// enough for calculations.
       Scalar** get_ref_values_transformed(Element* e, double x, double y);
 
+      /// Returns the effective polynomial degree of the solution on element e: the
+      /// lowest degree such that all monomial coefficients of higher degrees are,
+      /// relatively to the largest coefficient on the element, below rel_tolerance.
+      /// For smooth solutions this is often lower than the element order of the
+      /// space the solution was obtained in, which is used by the adaptive
+      /// quadrature mode of DiscreteProblem. Returns -1 when the solution does not
+      /// come from a coefficient vector.
+      int get_effective_element_order(Element* e, double rel_tolerance) const;
+
       /// Returns solution value or derivatives at the physical domain point (x, y).
       /// 'item' controls the returned value: H2D_FN_VAL_0, H2D_FN_VAL_1, H2D_FN_DX_0, H2D_FN_DX_1, H2D_FN_DY_0, ....
       /// NOTE: This function should be used for postprocessing only, it is not effective
@@ -133,8 +172,23 @@ namespace Hermes
       /// Returns solution type.
       inline SolutionType get_type() const { return sln_type; };
 
+      /// Deep memory usage: the monomial coefficient and element index arrays
+      /// plus the precalculated value tables inherited from Function.
+      /// \sa Hermes::Api::register_memory_report().
+      virtual size_t get_memory_bytes() const;
+
       inline SpaceType get_space_type() const { return space_type; };
 
+      /// Monotone change stamp of the stored data, raised whenever the contents of
+      /// this solution change (set_coeff_vector(), copy(), assign(), multiply(),
+      /// freeing). Remember the value and ask has_changed_since() later to find out
+      /// cheaply whether e.g. an export can be skipped.
+      inline int get_sln_seq() const { return sln_seq; };
+
+      /// True if the contents have changed since the given stamp was obtained from
+      /// get_sln_seq(), \sa Mesh::has_changed_since() and Space::has_changed_since().
+      inline bool has_changed_since(int sln_seq) const { return this->sln_seq != sln_seq; };
+
       /// Passes solution components calculated from solution vector as Solutions.
       static void vector_to_solutions(const Scalar* solution_vector, Hermes::vector<const Space<Scalar> *> spaces,
           Hermes::vector<Solution<Scalar>*> solutions,
@@ -224,6 +278,55 @@ namespace Hermes
       int num_coeffs, num_elems;
       int num_dofs;
 
+      /// The dof coefficient vector this solution was built from in set_coeff_vector(),
+      /// remembered together with the sequence numbers of the dof assignment it belongs to.
+      /// OGProjection uses it to short-circuit a projection of the solution back onto the
+      /// space it already lives on. NULL for solutions from other sources.
+      Scalar* space_coeffs;
+      int space_coeffs_count;
+      int space_seq;
+      int space_mesh_seq;
+      bool space_coeffs_dir_lift;
+
+      /// \sa get_sln_seq().
+      int sln_seq;
+
+      /// True if space_coeffs is a valid coefficient vector in 'space', i.e. this solution
+      /// was built on the same dof assignment (space and mesh sequence numbers, space type
+      /// and dof count all agree) with the Dirichlet lift added.
+      bool has_coeff_vector_for(const Space<Scalar>* space) const;
+
+      /// Convert lazily instead of in set_coeff_vector(). See use_lazy_conversion().
+      bool lazy_conversion;
+      /// Per-element flags saying whose monomial coefficients are already computed.
+      /// NULL unless the solution was built in the lazy mode.
+      char* elem_converted;
+      /// The space the pending conversions read their assembly lists from.
+      const Space<Scalar>* lazy_space;
+      /// Points into space_coeffs - the dof vector the pending conversions are anchored
+      /// in, so the vector passed to set_coeff_vector() may be freed right away.
+      const Scalar* lazy_coeff_vec;
+      /// Shapeset tables for the pending conversions, created on the first one.
+      PrecalcShapeset* lazy_pss;
+      bool lazy_add_dir_lift;
+
+      /// Computes the monomial coefficients of a single element from the remembered
+      /// dof vector, \sa use_lazy_conversion(). Called on the first access to the element.
+      void convert_element(Element* e);
+
+      /// Converts every element whose conversion is still pending. Called before
+      /// operations that read the monomial tables wholesale (multiply(), the save methods).
+      void convert_pending_elements();
+
+      /// Use mmap in load_bin(). See set_mmap_loading().
+      bool mmap_loading;
+      /// Base address of the file mapping holding the arrays of a memory-mapped solution, NULL otherwise.
+      void* mapped_data;
+      /// Length of the file mapping.
+      size_t mapped_size;
+      /// Releases the file mapping (if any) together with the arrays pointing into it.
+      void free_mapped_data();
+
       void transform_values(int order, struct Function<Scalar>::Node* node, int newmask, int oldmask, int np);
 
       virtual void precalculate(int order, int mask);
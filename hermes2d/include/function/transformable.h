@@ -123,6 +123,7 @@ namespace Hermes
       template<typename T> friend class DiscreteProblem;
       template<typename T> friend class DiscreteProblemLinear;
       template<typename T> friend class NeighborSearch;
+      template<typename T> friend class LocalProjection;
       friend class CurvMap;
       friend class Traverse;
       friend class Views::Vectorizer;
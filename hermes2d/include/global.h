@@ -96,7 +96,13 @@ namespace Hermes
     class Quad2DStd;
 
     /// How many bits the encoded_order number takes.
+    /// One extra bit is needed with EXTREME_QUAD, where the directional
+    /// orders go beyond 31 (\sa g_max_quad).
+#ifdef EXTREME_QUAD
+    const int H2D_ORDER_BITS = 6;
+#else
     const int H2D_ORDER_BITS = 5;
+#endif
     const int H2D_ORDER_MASK = (1 << H2D_ORDER_BITS) - 1;
 
     /// Macros for combining quad horizontal and vertical encoded_orders.
@@ -129,6 +135,20 @@ namespace Hermes
       static double calc_abs_errors(Hermes::vector<Solution<Scalar>*> slns1, Hermes::vector<Solution<Scalar>*> slns2);
       static double calc_rel_errors(Hermes::vector<Solution<Scalar>*> slns1, Hermes::vector<Solution<Scalar>*> slns2);
 
+      /// Parallel counterparts of calc_abs_error() / calc_norm(), sharing the
+      /// element loop between threads through the precomputed state stream of
+      /// Traverse (the same partitioning the assembling and adaptivity loops use).
+      /// Each state writes its contribution into its own slot and the reduction is
+      /// a serial compensated summation over the state order, so the result is
+      /// identical for any number of threads. The functions must implement clone().
+      static double calc_abs_error_parallel(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, int norm_type);
+      static double calc_norm_parallel(MeshFunction<Scalar>* sln, int norm_type);
+
+      /// Parallel counterparts of calc_norms() / calc_abs_errors() / calc_rel_errors().
+      static double calc_norms_parallel(Hermes::vector<Solution<Scalar>*> slns);
+      static double calc_abs_errors_parallel(Hermes::vector<Solution<Scalar>*> slns1, Hermes::vector<Solution<Scalar>*> slns2);
+      static double calc_rel_errors_parallel(Hermes::vector<Solution<Scalar>*> slns1, Hermes::vector<Solution<Scalar>*> slns2);
+
       static double error_fn_l2(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, RefMap* ru, RefMap* rv);
       static double norm_fn_l2(MeshFunction<Scalar>* sln, RefMap* ru);
 
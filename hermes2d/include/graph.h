@@ -34,6 +34,7 @@ namespace Hermes
     public:
 
       Graph(const char* title = NULL, const char* x_axis_name = NULL, const char* y_axis_name = NULL);
+      ~Graph();
 
       void set_captions(const char* title = NULL, const char* x_axis_name = NULL, const char* y_axis_name = NULL);
 
@@ -54,6 +55,22 @@ namespace Hermes
       virtual void save(const char* filename) = 0;
       void save_numbered(const char* filename, int number);
 
+      /// Starts recording the added values into the given file, opened in append
+      /// mode. add_values() then only copies the point into a memory buffer, which
+      /// a background thread flushes to the file - the simulation thread never
+      /// waits for the disk. With binary on (the default), each point is appended
+      /// as a raw (int row, double x, double y) record; otherwise as a text line.
+      void set_recording(const char* filename, bool binary = true);
+
+      /// Flushes the remaining buffered points, stops the background thread and
+      /// closes the recording file. Also called by the destructor.
+      void stop_recording();
+
+      /// Reads the points back from a file written by set_recording() and adds
+      /// them to the rows, so that a recorded history can be saved in any of the
+      /// graph formats. Missing rows are created with default styles.
+      void load_recording(const char* filename, bool binary = true);
+
     protected:
 
       std::string title, xname, yname;
@@ -71,6 +88,35 @@ namespace Hermes
       };
 
       Hermes::vector<Row> rows;
+
+      /// One buffered point of the recording (see set_recording()).
+      struct Record
+      {
+        int row;
+        double x, y;
+      };
+
+      /// Appends the point to the recording buffer and wakes the flushing thread
+      /// once the buffer is half full.
+      void record_values(int row, double x, double y);
+      /// Entry point of the flushing thread.
+      static void* recording_thread_fn(void* graph);
+      /// Writes out one batch of records. Runs on the flushing thread.
+      void write_records(Record* records, int count);
+
+      bool recording;
+      bool recording_binary;
+      FILE* recording_file;
+      /// Double buffer: values are appended to the front buffer while the
+      /// flushing thread writes the back one.
+      Record* recording_front;
+      Record* recording_back;
+      int recording_capacity;
+      int recording_count;
+      bool recording_stop;
+      pthread_t recording_thread;
+      pthread_mutex_t recording_mutex;
+      pthread_cond_t recording_cond;
     };
 
     ///  Outputs just two numbers per row.
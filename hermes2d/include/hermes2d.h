@@ -23,6 +23,8 @@
 #include "newton_solver.h"
 #include "picard_solver.h"
 #include "linear_solver.h"
+#include "static_condensation.h"
+#include "multigrid_solver.h"
 #include "calculation_continuity.h"
 
 #include "boundary_conditions/essential_boundary_conditions.h"
@@ -35,6 +37,7 @@
 #include "mesh/mesh.h"
 #include "mesh/mesh_reader.h"
 #include "mesh/mesh_reader_h2d.h"
+#include "mesh/mesh_reader_h2d_bin.h"
 #include "mesh/mesh_reader_h2d_xml.h"
 #include "mesh/mesh_reader_h1d_xml.h"
 #include "mesh/mesh_reader_exodusii.h"
@@ -52,6 +55,7 @@
 #include "shapeset/shapeset_hd_all.h"
 #include "shapeset/shapeset_l2_all.h"
 
+#include "mesh/mesh_partitioner.h"
 #include "mesh/refmap.h"
 #include "mesh/traverse.h"
 
@@ -92,6 +96,7 @@
 #include "refinement_selectors/hcurl_proj_based_selector.h"
 
 #include "adapt/adapt.h"
+#include "adapt/adaptivity_pipeline.h"
 #include "adapt/kelly_type_adapt.h"
 #include "neighbor.h"
 #include "projections/localprojection.h"
@@ -104,6 +109,7 @@
 #if defined (AGROS)
 // No inclusions here.
 #else
+#include "weakform_library/inlined_kernels.h"
 #include "weakform_library/weakforms_elasticity.h"
 #include "weakform_library/weakforms_h1.h"
 #include "weakform_library/weakforms_hcurl.h"
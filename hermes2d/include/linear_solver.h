@@ -100,7 +100,47 @@ namespace Hermes
 
       /// Get the Residual.
       Vector<Scalar>* get_residual();
+
+      /// Turns static condensation on / off (default: off).
+      /// When on, the interior (bubble) DOFs are eliminated element-locally
+      /// from the assembled system (see StaticCondensation), only the reduced
+      /// interface system is passed to the matrix solver, and the eliminated
+      /// values are recovered by back-substitution afterwards. For higher
+      /// polynomial degrees this shrinks the system the direct solver sees
+      /// considerably. Requires a CSC-based matrix solver (e.g. UMFPACK).
+      void set_static_condensation(bool to_set = true);
+
+      /// Turns pipelined assembling on / off (default: off).
+      /// When on, the matrix of the NEXT time level is assembled on spare
+      /// threads while the matrix solver factorizes the current one; the
+      /// following call to solve() then only adds the pre-assembled matrix
+      /// and assembles the right-hand side. The caller asserts that the
+      /// matrix coefficients depend on time only (not on the solution), that
+      /// the essential boundary condition values do not change in time, and
+      /// that the time is advanced exactly by the weak form's current time
+      /// step between solve() calls - on any mismatch the pre-assembled
+      /// matrix is discarded and a full assembly is done instead.
+      void set_pipelined_assembling(bool to_set = true);
+
+      /// Turns handling of the constant nullspace on / off (default: off).
+      /// For pure-Neumann problems the assembled matrix is singular - the
+      /// constants lie in its nullspace - and pinning one DOF by hand both
+      /// distorts the conditioning and breaks the symmetric scaling. When
+      /// on, solve() borders the system with one Lagrange multiplier row
+      /// and column of ones enforcing a zero mean of the solution vector,
+      /// solves the regular bordered system and returns its first ndof
+      /// entries; the returned solution is the mean-free representative.
+      /// The bordered matrix and its solver are kept between solve() calls,
+      /// so when the sparsity pattern of the assembled matrix does not
+      /// change, the symbolic factorization is reused. Cannot be combined
+      /// with static condensation or pipelined assembling. Requires a
+      /// CSC-based matrix solver (e.g. UMFPACK).
+      void set_constant_nullspace(bool to_set = true);
     protected:
+      /// Solves the bordered system of the constant nullspace handling,
+      /// \sa set_constant_nullspace().
+      void solve_with_constant_nullspace();
+
       DiscreteProblemLinear<Scalar>* dp; ///< FE problem being solved.
 
       /// The solution vector.
@@ -114,7 +154,52 @@ namespace Hermes
 
       /// Linear solver.
       LinearMatrixSolver<Scalar>* matrix_solver;
-      
+
+      /// Solve the condensed system instead of the full one.
+      bool static_condensation;
+
+      /// The solution vector in the static condensation mode - there it is
+      /// owned by this instance, not by the matrix solver.
+      Scalar* condensed_sln_vector;
+
+      /// Overlap the assembly of the next time level's matrix with the
+      /// current factorization.
+      bool pipelined_assembling;
+
+      /// Secondary discrete problem assembling the next time level's matrix.
+      /// A separate instance is used so that the primary one keeps the sparse
+      /// structure of this->jacobian. Created lazily.
+      DiscreteProblemLinear<Scalar>* dp_pre;
+
+      /// Matrix pre-assembled for the next time level.
+      SparseMatrix<Scalar>* jacobian_pre;
+
+      /// Dirichlet lift part of the right-hand side pre-assembled for the
+      /// next time level. It originates in the matrix forms and would be lost
+      /// in a right-hand-side-only assembly.
+      Vector<Scalar>* dirichlet_lift_pre;
+
+      /// Time for which jacobian_pre was assembled; checked against the weak
+      /// form's current time before the pre-assembled matrix is used.
+      double pre_assembled_time;
+
+      /// True when jacobian_pre holds a complete matrix.
+      bool pre_assembled_valid;
+
+      /// Border the system with the mean-value Lagrange constraint.
+      bool constant_nullspace;
+
+      /// The bordered matrix, right-hand side and solver of the constant
+      /// nullspace handling, kept between solve() calls so an unchanged
+      /// sparsity pattern reuses the symbolic factorization.
+      SparseMatrix<Scalar>* bordered_matrix;
+      Vector<Scalar>* bordered_rhs;
+      LinearMatrixSolver<Scalar>* bordered_solver;
+
+      /// The solution vector in the constant nullspace mode - there it is
+      /// owned by this instance, not by the matrix solver.
+      Scalar* nullspace_sln_vector;
+
       /// This instance owns its DP.
       const bool own_dp;
     };
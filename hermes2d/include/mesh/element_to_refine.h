@@ -62,6 +62,7 @@ namespace Hermes
       *  \param[in] dest A destination array.
       *  \param[in] src A source arrapy. */
       static void copy_orders(int* dest, const int* src);
+      friend class Mesh;
       template<typename T> friend class Adapt;
       template<typename T> friend class RefinementSelectors::Selector;
       template<typename T> friend class RefinementSelectors::HOnlySelector;
@@ -37,6 +37,9 @@ namespace Hermes
     ///
     /// HashTable is a base class for Mesh. It serves as a container for all nodes
     /// of a mesh. Moreover, it has node searching functions based on hash tables.
+    /// Two backends are available: the default chained buckets, and a flat
+    /// open-addressing table selected through the useOpenAddressingHashTables
+    /// API parameter (see Api2D), which avoids pointer chasing during refinement.
     ///
     class HERMES_API HashTable : public Hermes::Mixins::Loggable
     {
@@ -111,8 +114,53 @@ namespace Hermes
       /// Creates a copy of a hash synonym list.
       void copy_list(Node** ptr, Node* node);
 
+      /// Flat open-addressing table with inline key/value storage, used instead of
+      /// the chained buckets when the useOpenAddressingHashTables API parameter is set.
+      /// Slots with p1 == -1 are empty, slots with p1 == -2 have been deleted
+      /// (probing continues past them and they can be reused).
+      struct FlatTable
+      {
+        int* p1; ///< First parent id (the smaller one).
+        int* p2; ///< Second parent id.
+        int* id; ///< Id of the stored node.
+        int capacity; ///< Number of slots; always a power of two.
+        int count; ///< Number of slots in use, deleted ones included.
+        int mask; ///< capacity - 1.
+      };
+
+      bool flat_tables; ///< True if the open-addressing backend is selected.
+
+      FlatTable v_flat; ///< Vertex node flat table.
+      FlatTable e_flat; ///< Edge node flat table.
+
+      void flat_init(FlatTable& table, int size);
+      void flat_free(FlatTable& table);
+
+      /// Doubles the capacity of the table and re-inserts the live entries.
+      void flat_grow(FlatTable& table);
+
+    protected:
+      /// Pre-grows the node tables for a known number of upcoming vertex and
+      /// edge node insertions, so that a bulk operation (Mesh::refine_elements())
+      /// does not rehash repeatedly. A no-op with the chained backend, whose
+      /// bucket count is fixed.
+      void reserve_nodes(int num_vertex, int num_edge);
+
+      /// Bytes held by the node storage: the node array plus the bucket
+      /// pointers (or the flat tables, whichever backend is active).
+      size_t get_node_table_bytes() const;
+
+    private:
+
+      /// Returns the id of the node with parent ids p1 and p2, or -1 if it is not stored.
+      int flat_lookup(const FlatTable& table, int p1, int p2) const;
+
+      void flat_insert(FlatTable& table, int p1, int p2, int id);
+      void flat_remove(FlatTable& table, int p1, int p2, int id);
+
       friend struct Node;
       friend class MeshReaderH2D;
+      friend class MeshReaderH2DBin;
       template<typename Scalar> friend class NeighborSearch;
       template<typename Scalar> friend class Space;
       template<typename Scalar> friend class H1Space;
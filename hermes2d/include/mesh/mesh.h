@@ -19,8 +19,17 @@
 #include "../global.h"
 #include "curved.h"
 #include "hash.h"
+#include "element_to_refine.h"
 #include "../mixins2d.h"
 
+/// Software prefetch hint for data that is about to be touched,
+/// a no-op where the intrinsic is not available.
+#if defined(__GNUC__)
+#define H2D_PREFETCH(address) __builtin_prefetch((const void*)(address))
+#else
+#define H2D_PREFETCH(address) ((void)0)
+#endif
+
 namespace Hermes
 {
   namespace Hermes2D
@@ -38,7 +47,11 @@ namespace Hermes
     template<typename Scalar> class KellyTypeAdapt;
     struct MItem;
     struct Rect;
+    class Mesh;
     extern unsigned g_mesh_seq;
+    /// Bumps the global mesh sequence counter, publishing the change of 'mesh'
+    /// on the central change bus first. \sa Hermes::ChangeBus.
+    extern HERMES_API unsigned bump_mesh_seq(const Mesh* mesh);
 
     namespace RefinementSelectors
     {
@@ -196,6 +209,7 @@ namespace Hermes
       friend class Mesh;
       friend class MeshReader;
       friend class MeshReaderH2D;
+      friend class MeshReaderH2DBin;
       friend class MeshReaderH1DXML;
       friend class MeshReaderH2DXML;
       friend class PrecalcShapeset;
@@ -246,12 +260,17 @@ namespace Hermes
     ///&nbsp;e.print_msg();
     ///&nbsp;return -1;
     /// }
-    class HERMES_API Mesh : public HashTable, public Hermes::Hermes2D::Mixins::StateQueryable
+    class HERMES_API Mesh : public HashTable, public Hermes::Hermes2D::Mixins::StateQueryable, public Hermes::MemoryAccounted
     {
     public:
       Mesh();
       virtual ~Mesh();
 
+      /// Deep memory usage: the element array, the node storage and the hash
+      /// tables. Curvilinear coefficient data of curved elements is counted
+      /// by the map structures only. \sa Hermes::Api::register_memory_report().
+      virtual size_t get_memory_bytes() const;
+
       /// Initializes the mesh.
       /// \param size[in] Hash table size; must be a power of two.
       void init(int size = H2D_DEFAULT_HASH_SIZE);
@@ -311,6 +330,15 @@ namespace Hermes
       /// refine vertically.
       void refine_element_id(int id, int refinement = 0);
 
+      /// Refines a batch of elements at once. Entries proposing a P-refinement
+      /// and entries whose element is not active any more (e.g., already refined
+      /// through another component sharing this mesh) are skipped. Compared with
+      /// calling refine_element_id() in a loop, the refinements are sorted by the
+      /// element id so that the pass through the element array is as local as
+      /// possible, the node tables are pre-sized for the newly created vertex and
+      /// edge nodes, and the mesh sequence number is raised only once at the end.
+      void refine_elements(const std::vector<ElementToRefine>& elems_to_refine);
+
       /// Refines all elements.
       /// \param refinement[in] Same meaning as in refine_element_id().
       void refine_all_elements(int refinement = 0, bool mark_as_initial = false);
@@ -361,12 +389,161 @@ namespace Hermes
       /// refine_all_elements().
       void unrefine_all_elements(bool keep_initial_refinements = true);
 
+      /// Compacts the element storage: elements are renumbered so that the unused
+      /// slots left behind by refine / unrefine cycles disappear and element ids
+      /// become contiguous again. All element tree links and the node-to-element
+      /// back-links are remapped; the nodes themselves (and thus the hash table)
+      /// stay in place. Since the element ids change, the mesh sequence number is
+      /// bumped and any Space / Solution built on top of the mesh has to be
+      /// re-created - call this between adaptation campaigns, not inside one.
+      void compact();
+
       /// For internal use.
       Element* get_element_fast(int id) const;
 
+      /// Contiguous per-active-element data, a struct-of-arrays complement to
+      /// Array<Element>. Hot loops that only need ids, markers, modes or corner
+      /// coordinates can run over these packed arrays instead of chasing Element
+      /// pointers across the heap.
+      struct HERMES_API ActiveElementsCache
+      {
+        ActiveElementsCache();
+        ~ActiveElementsCache();
+        /// Frees the arrays.
+        void free();
+
+        int count;            ///< Number of active elements.
+        int* id;              ///< Element ids, in the for_all_active_elements() order.
+        int* marker;          ///< Element markers.
+        char* nvert;          ///< Numbers of vertices (3 or 4).
+        double* vertex_x;     ///< Corner x-coordinates, four slots per element.
+        double* vertex_y;     ///< Corner y-coordinates, four slots per element.
+        unsigned seq;         ///< Mesh::seq the arrays were built for.
+      };
+
+      /// Returns the packed active-element arrays, rebuilding them first if the
+      /// mesh has changed (the sequence number differs) since the last call.
+      const ActiveElementsCache* get_active_elements_cache();
+
+      /// Uniform grid over the bounding boxes of the active elements, used to find
+      /// the element containing a physical point without scanning the whole mesh
+      /// (see RefMap::element_on_physical_coordinates). Elements spanning several
+      /// cells are stored in each of them; bounding boxes of curved elements are
+      /// inflated, and a caller must still fall back to a full scan when the grid
+      /// yields no match.
+      struct HERMES_API ElementSearchGrid
+      {
+        ElementSearchGrid();
+        ~ElementSearchGrid();
+        /// Frees the arrays.
+        void free();
+
+        double min_x, min_y;  ///< Lower left corner of the grid.
+        double cell_size_x, cell_size_y;
+        int nx, ny;           ///< Numbers of cells in each direction.
+        int* cell_start;      ///< Start of each cell's id range in cell_elements, nx*ny + 1 entries.
+        int* cell_elements;   ///< Active element ids, grouped by cell.
+        unsigned seq;         ///< Mesh::seq the grid was built for.
+      };
+
+      /// Returns the element search grid, rebuilding it first if the mesh has
+      /// changed (the sequence number differs) since the last call.
+      const ElementSearchGrid* get_element_search_grid();
+
+      /// Compact CSR-style adjacency of the active elements over their edges:
+      /// row id of neighbor_start delimits the ids of the same-level active
+      /// edge neighbors of the element with that id in neighbor_ids. Edge
+      /// sweeps can read a row and issue software prefetches (H2D_PREFETCH)
+      /// for the neighbor data ahead of the pointer chase through the edge
+      /// nodes. Boundary edges and hanging-node interfaces contribute no
+      /// entries - the structure is a prefetch hint, not a replacement for
+      /// NeighborSearch.
+      struct HERMES_API ElementAdjacency
+      {
+        ElementAdjacency();
+        ~ElementAdjacency();
+        /// Frees the arrays.
+        void free();
+
+        int size;             ///< Number of rows, get_max_element_id().
+        int* neighbor_start;  ///< Start of each row's id range in neighbor_ids, size + 1 entries.
+        int* neighbor_ids;    ///< Neighbor element ids, grouped by central element id.
+        unsigned seq;         ///< Mesh::seq the arrays were built for.
+      };
+
+      /// Returns the element adjacency, rebuilding it first if the mesh has
+      /// changed (the sequence number differs) since the last call. Safe to
+      /// call concurrently - the rebuild runs in a critical section.
+      const ElementAdjacency* get_element_adjacency();
+
+      /// Cached result of neighbor discovery across one inner edge of an active
+      /// element (see NeighborSearch::set_active_edge): the neighborhood type,
+      /// the neighbors with their local edge numbers and relative orientations,
+      /// and the transformation chains leading to them. A NeighborSearch can be
+      /// initialized from this record without walking the refinement tree again.
+      struct HERMES_API EdgeNeighborhood
+      {
+        EdgeNeighborhood();
+        ~EdgeNeighborhood();
+
+        /// One neighbor across the edge.
+        struct HERMES_API Record
+        {
+          Record();
+
+          int neighbor_id;                ///< Id of the neighbor element.
+          int local_num_of_edge;          ///< Local number of the shared edge on the neighbor.
+          bool orientation;               ///< Relative orientation of the neighbor edge w.r.t. the central element's edge.
+          unsigned int central_n_levels;  ///< Length of central_transf (nonzero only in a go-down neighborhood).
+          unsigned int* central_transf;   ///< Transformation chain pushed to the central element.
+          unsigned int neighbor_n_levels; ///< Length of neighbor_transf (nonzero only in a go-up neighborhood).
+          unsigned int* neighbor_transf;  ///< Transformation chain pushed to the neighbor element.
+        };
+
+        int type;                 ///< NeighborSearch<Scalar>::NeighborhoodType of the stored neighborhood.
+        unsigned int n_neighbors; ///< Number of neighbors across the edge.
+        Record* records;          ///< One record per neighbor.
+      };
+
+      /// Table of cached edge neighborhoods, indexed by element id * 4 + local
+      /// edge number. Entries are filled lazily as NeighborSearch visits inner
+      /// edges and the whole table is dropped when the mesh changes.
+      struct HERMES_API NeighborhoodCache
+      {
+        NeighborhoodCache();
+        ~NeighborhoodCache();
+        /// Frees the table including the stored entries.
+        void free();
+
+        EdgeNeighborhood** entries; ///< get_max_element_id() * 4 slots, NULL where not visited yet.
+        int size;                   ///< Number of slots in entries.
+        unsigned seq;               ///< Mesh::seq the table was built for.
+      };
+
+      /// Turns caching of edge neighborhoods for this mesh on / off.
+      /// Defaults to off; when on, repeated DG assembly passes over an
+      /// unchanged mesh reuse the neighbor search results of the first pass.
+      void set_neighborhood_caching(bool to_set = true);
+
+      /// Returns whether caching of edge neighborhoods is on.
+      bool get_neighborhood_caching() const;
+
+      /// Returns the cached neighborhood of the given edge, or NULL when caching
+      /// is off or the edge has not been visited since the last mesh change.
+      EdgeNeighborhood* get_cached_neighborhood(int element_id, int edge);
+
+      /// Stores a neighborhood record for the given edge, taking ownership of it.
+      /// The record is dropped when caching is off or the slot is already filled.
+      void cache_neighborhood(int element_id, int edge, EdgeNeighborhood* neighborhood);
+
       /// For internal use.
       unsigned get_seq() const;
 
+      /// True if the mesh has been modified (refined, coarsened, loaded, ...) since
+      /// the given stamp was obtained from get_seq(). Intended for cheap change
+      /// detection in export and monitoring code, \sa Solution::has_changed_since().
+      bool has_changed_since(unsigned seq) const;
+
       /// For internal use.
       void set_seq(unsigned seq);
 
@@ -386,6 +563,15 @@ namespace Hermes
         /// THIS IS THE METHOD TO OVERLOAD FOR CUSTOM CREATING OF A REFERENCE MESH.
         virtual Mesh* create_ref_mesh();
 
+        /// Creation reusing the reference mesh of the previous iteration.
+        /// When the coarse mesh has not changed since previous_ref_mesh was
+        /// created from it (checked through the seq number stamped on it),
+        /// previous_ref_mesh is returned unchanged and the whole copy and
+        /// refinement is skipped; otherwise it is rebuilt in place. The
+        /// ownership of the passed mesh transfers to the returned one, so the
+        /// usual 'delete ref_mesh' of the caller stays correct.
+        virtual Mesh* create_ref_mesh(Mesh* previous_ref_mesh);
+
       private:
         /// Storage.
         Mesh* coarse_mesh;
@@ -430,6 +616,25 @@ namespace Hermes
       int nactive;
       unsigned seq;
 
+      /// Seq of the coarse mesh this mesh was built from by
+      /// ReferenceMeshCreator, (unsigned) -1 for all other meshes.
+      /// \sa ReferenceMeshCreator::create_ref_mesh(Mesh*)
+      unsigned ref_source_seq;
+
+      ActiveElementsCache active_elements_cache;
+
+      ElementSearchGrid element_search_grid;
+
+      ElementAdjacency element_adjacency;
+
+      bool neighborhood_caching;
+
+      /// True while refine_elements() runs; refine_element() then leaves the
+      /// sequence number alone and it is raised once at the end of the batch.
+      bool bulk_refinement;
+
+      NeighborhoodCache neighborhood_cache;
+
       int nbase, ntopvert;
       int ninitial;
 
@@ -545,6 +750,7 @@ namespace Hermes
       BoundaryMarkersConversion boundary_markers_conversion;
 
       friend class MeshReaderH2D;
+      friend class MeshReaderH2DBin;
       friend class MeshReaderH2DXML;
       friend class MeshReaderH1DXML;
       friend class MeshReaderExodusII;
@@ -726,6 +932,15 @@ namespace Hermes
               if(((e) = (mesh)->get_element_fast(_id))->used) \
                 if((e)->active)
 
+    /// O(active) variant of for_all_active_elements(): walks the maintained list of
+    /// active element ids (\sa Mesh::get_active_elements_cache) instead of skipping
+    /// the unused and inactive slots one by one. The list is a snapshot of the mesh
+    /// state - do not use it when the loop body refines or unrefines elements.
+    #define for_all_active_elements_fast(e, mesh) \
+            for (const Hermes::Hermes2D::Mesh::ActiveElementsCache* _cache = (mesh)->get_active_elements_cache(); _cache != NULL; _cache = NULL) \
+              for (int _idx = 0; _idx < _cache->count; _idx++) \
+                if(((e) = (mesh)->get_element_fast(_cache->id[_idx]))->active)
+
     #define for_all_inactive_elements(e, mesh) \
             for (int _id = 0, _max = (mesh)->get_max_element_id(); _id < _max; _id++) \
               if(((e) = (mesh)->get_element_fast(_id))->used) \
@@ -0,0 +1,86 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_MESH_PARTITIONER_H
+#define __H2D_MESH_PARTITIONER_H
+
+#include "mesh.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// \brief Splits a mesh into a requested number of balanced parts.
+    ///
+    /// The partitioner works on the graph the active elements form through their
+    /// shared vertices (Element::vn) and splits it by recursive graph bisection:
+    /// the elements are ordered by their graph distance from a pseudo-peripheral
+    /// element and the ordering is cut so that the element counts of the two
+    /// halves match the number of partitions each half will be bisected into.
+    /// The resulting parts are balanced to within one element and connected
+    /// wherever the mesh itself is. The assignment depends only on the mesh, so
+    /// every process of a distributed calculation arrives at the same
+    /// partitioning without any communication. Intended as the
+    /// domain-decomposition base for distributing assembling and the algebraic
+    /// systems over several processes.
+    class HERMES_API MeshPartitioner
+    {
+    public:
+      /// \param[in] mesh the mesh whose active elements are to be partitioned.
+      /// \param[in] num_partitions the requested number of parts.
+      MeshPartitioner(const Mesh* mesh, int num_partitions);
+      ~MeshPartitioner();
+
+      /// Calculates the partitioning of the active elements.
+      void calculate();
+
+      /// Returns the partition the active element with the passed id was
+      /// assigned to.
+      int get_partition(int element_id) const;
+
+      /// Returns the number of active elements assigned to the passed partition.
+      int get_partition_size(int partition) const;
+
+      /// Returns the number of element pairs that share a vertex but belong to
+      /// different partitions - a measure of the coupling (and of the future
+      /// communication volume) between the parts.
+      int get_interface_links() const;
+
+    private:
+      /// Builds the vertex-sharing adjacency of the active elements.
+      void build_adjacency();
+
+      /// Distributes the passed elements over partition_count partitions
+      /// starting at first_partition, bisecting recursively.
+      void bisect(std::vector<int>& elements, int first_partition, int partition_count);
+
+      /// Orders the passed elements breadth-first from a pseudo-peripheral
+      /// element of the sub-graph they form; disconnected remainders are
+      /// appended, each ordered from its own seed.
+      void order_breadth_first(const std::vector<int>& elements, std::vector<int>& ordered);
+
+      const Mesh* mesh;
+      int num_partitions;
+      bool calculated;
+
+      int* partition;       ///< Partition numbers, indexed by element id.
+      int* partition_sizes;
+      std::vector<std::vector<int> > adjacency; ///< Neighbor element ids, indexed by element id.
+      int* visited_stamp;   ///< Scratch marker for the breadth-first ordering.
+      int current_stamp;
+    };
+  }
+}
+#endif
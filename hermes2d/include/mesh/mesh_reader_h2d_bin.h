@@ -0,0 +1,125 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#ifndef _MESH_READER_H2D_BIN_H_
+#define _MESH_READER_H2D_BIN_H_
+
+#include "mesh_reader.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Mesh reader and writer of a compact binary format.
+    ///
+    /// @ingroup mesh_readers
+    /// The file starts with a magic / version header, followed by fixed-size
+    /// vertex, element, boundary and refinement arrays and the marker string
+    /// tables. There is no parsing and no validation pass, so large meshes
+    /// load in a fraction of the time the text or XML readers need, and the
+    /// fixed-size arrays can be memory-mapped by external tools.
+    /// Curvilinear (NURBS) boundaries are not representable in this format,
+    /// save() throws on curved meshes - use MeshReaderH2D or MeshReaderH2DXML
+    /// for those.
+    ///
+    /// Typical usage:
+    /// Hermes::Hermes2D::Mesh mesh;
+    /// Hermes::Hermes2D::MeshReaderH2DBin mloader;
+    /// try
+    /// {
+    ///&nbsp;mloader.load("compressor.meshb", &mesh);
+    /// }
+    /// catch(Exceptions::MeshLoadFailureException& e)
+    /// {
+    ///&nbsp;e.print_msg();
+    ///&nbsp;return -1;
+    /// }
+    class HERMES_API MeshReaderH2DBin : public MeshReader
+    {
+    public:
+      MeshReaderH2DBin();
+      virtual ~MeshReaderH2DBin();
+
+      virtual bool load(const char *filename, Mesh *mesh);
+      virtual bool save(const char *filename, Mesh *mesh);
+
+#ifndef WIN32
+      /// Publish the mesh into a named POSIX shared memory segment (a name
+      /// like "/sweep_base_mesh"). The segment holds the flat binary records
+      /// of this format, so one process writes it once and every other
+      /// process on the node reads the same physical pages - the snapshot is
+      /// not duplicated per process. attach_shm() in the followers replays
+      /// the records without touching the filesystem; being a binary replay,
+      /// it takes milliseconds where parsing a mesh file takes seconds.
+      /// Note that each attaching process still builds its own pointer-linked
+      /// Mesh from the records - the Mesh structures themselves cannot be
+      /// mapped at differing addresses. The same curved-boundary restriction
+      /// as for save() applies.
+      bool publish_shm(const char *name, Mesh *mesh);
+
+      /// Load a mesh from a segment written by publish_shm().
+      bool attach_shm(const char *name, Mesh *mesh);
+
+      /// Remove a published segment; existing attachments stay valid.
+      static void unlink_shm(const char *name);
+#endif
+
+    protected:
+      /// The stream-level writer and reader behind the file and the shared
+      /// memory front ends. load_stream() leaves closing the stream to the
+      /// caller, also when it throws; origin names the source in error messages.
+      void save_stream(FILE* f, Mesh *mesh);
+      void load_stream(FILE* f, Mesh *mesh, const char* origin);
+      /// Header of the binary mesh file.
+      struct BinHeader
+      {
+        char magic[8];       ///< "H2DMESHB"
+        int version;         ///< Format version, currently 1.
+        int n_vert;          ///< Number of top-level vertices.
+        int n_el;            ///< Number of base element records (including unused slots).
+        int n_bdy;           ///< Number of boundary edge records.
+        int n_ref;           ///< Number of refinement records.
+        int n_el_markers;    ///< Number of element marker strings.
+        int n_bdy_markers;   ///< Number of boundary marker strings.
+      };
+
+      /// One base element record. Triangles and unused slots are padded to the
+      /// record size, so the array can be indexed directly.
+      struct BinElement
+      {
+        int vert[4];         ///< Vertex ids, vert[3] == -1 for triangles, vert[0] == -1 for unused slots.
+        int marker;          ///< Index into the element marker table.
+      };
+
+      /// One boundary edge record.
+      struct BinBoundary
+      {
+        int vert[2];         ///< Vertex ids of the edge.
+        int marker;          ///< Index into the boundary marker table.
+      };
+
+      /// One refinement record.
+      struct BinRefinement
+      {
+        int id;              ///< Element id.
+        int type;            ///< Refinement type as taken by Mesh::refine_element_id().
+      };
+
+      /// Collects the refinement records in the order in which load() replays them.
+      void save_refinements(Mesh *mesh, Element* e, int id, std::vector<BinRefinement>& refinements);
+    };
+  }
+}
+#endif
@@ -27,6 +27,7 @@ namespace Hermes
   {
     class Element;
     class Mesh;
+    class CurvMap;
     namespace Views{
       class Orderizer;
       class Linearizer;
@@ -118,6 +119,25 @@ namespace Hermes
       /// its inverse matrix.
       double2x2* get_const_inv_ref_map();
 
+      /// Enables / disables the geometry cache shared by all RefMap instances.
+      /// With the cache enabled, the inverse reference maps, Jacobians,
+      /// second-derivative tables and physical coordinates of the integration
+      /// points are kept per (element,
+      /// sub-element, order), so revisiting an element - by another assembling
+      /// thread, for error estimation or for linearization - copies the tables
+      /// instead of recomputing them. This includes curved elements, whose
+      /// tables (sums over all edge and bubble shapes of the reference map)
+      /// are by far the most expensive; their entries carry a signature of the
+      /// curved map they were built for and are never returned for an element
+      /// whose curvature changed.
+      /// \sa free_geometry_cache()
+      static void use_geometry_cache(bool use = true);
+
+      /// Frees all entries of the shared geometry cache. Cached tables are
+      /// verified against the element vertices before being returned, so this
+      /// only reclaims memory after a mesh change, stale entries are never used.
+      static void free_geometry_cache();
+
       H1ShapesetJacobi ref_map_shapeset;
       PrecalcShapeset ref_map_pss;
     private:
@@ -130,6 +150,15 @@ namespace Hermes
       /// Calculates the second reference map at a particular point (xi1, xi2).
       void second_ref_map_at_point(double xi1, double xi2, double& x, double& y, double3x2& mm);
 
+      /// Precalculates the second-derivative tables of the reference map at the
+      /// points of the given quadrature order. Mirrors calc_inv_ref_map(): affine
+      /// elements (straight triangles and parallelogram quads) have identically
+      /// vanishing second map derivatives and receive a zero table outright, a
+      /// straight-edged bilinear quad keeps a single constant mixed derivative;
+      /// only curved elements run the shapeset table machinery, with their
+      /// results shared through the geometry cache.
+      void calc_second_ref_map(int order);
+
       /// See Transformable::push_transform()
       virtual void push_transform(int son);
 
@@ -201,14 +230,61 @@ namespace Hermes
         }
       }
 
+      /// Precalculates the inverse Jacobi matrices and jacobians at the points
+      /// of the given quadrature order. Straight-edged elements take an analytic
+      /// path (constant matrix for triangles, bilinear for quads); only curved
+      /// elements go through the shapeset table machinery.
       void calc_inv_ref_map(int order);
 
+      /// Key of the shared geometry cache. The element id alone does not
+      /// identify the geometry, entries additionally store the vertices.
+      struct GeometryCacheKey
+      {
+        int element_id;
+        int order;
+        uint64_t sub_idx;
+        int mode;
+        bool operator<(const GeometryCacheKey& other) const;
+      };
+
+      /// One entry of the shared geometry cache. The tables are filled lazily,
+      /// a pointer stays NULL until the corresponding table is first computed.
+      struct GeometryCacheEntry
+      {
+        int np;
+        double x[H2D_MAX_NUMBER_VERTICES];
+        double y[H2D_MAX_NUMBER_VERTICES];
+        /// Curvature signature - the curved map the entry was built for,
+        /// together with its order and sample coefficients. NULL curv marks a
+        /// straight-edged element.
+        CurvMap* curv;
+        int curv_order, curv_nc;
+        double2 curv_coeff_first, curv_coeff_last;
+        double* jacobian;
+        double2x2* inv_ref_map;
+        /// Second-derivative tables of forms using second derivatives
+        /// (H2D_USE_SECOND_DERIVATIVES); only curved elements ever store them,
+        /// straight-edged elements take an analytic path.
+        double3x2* second_ref_map;
+        double* phys_x;
+        double* phys_y;
+      };
+
+      static bool geometry_cache_enabled;
+
+      static std::map<GeometryCacheKey, GeometryCacheEntry*> geometry_cache;
+
+      /// Looks up (and with create == true, inserts) the cache entry of the
+      /// active element for the passed key, verifying it against the element
+      /// vertices and curvature - a mismatched entry is treated as absent and,
+      /// when creating, replaced. To be called inside the
+      /// refmap_geometry_cache critical section only.
+      GeometryCacheEntry* get_geometry_cache_entry(const GeometryCacheKey& cache_key, int np, bool create);
+
       /// Quickly calculates the (hard-coded) reference mapping for elements with constant jacobians
       /// (ie., linear triangles and linear parallelogram quads).
       void calc_const_inv_ref_map();
 
-      void calc_second_ref_map(int order);
-
       static bool is_parallelogram(Element* e);
 
       void calc_phys_x(int order);
@@ -245,6 +321,7 @@ namespace Hermes
       template<typename T> friend class ExactSolutionVector;
       template<typename T> friend class Adapt;
       template<typename T> friend class KellyTypeAdapt;
+      template<typename T> friend class LocalProjection;
       friend class Views::Orderizer;
       friend class Views::Vectorizer;
       friend class Views::Linearizer;
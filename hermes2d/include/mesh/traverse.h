@@ -70,6 +70,17 @@ namespace Hermes
       uint64_t l, b, r, t;
     };
 
+    /// @ingroup inner
+    /// A paired element view of one inner mesh face, \sa Traverse::get_face_states().
+    struct HERMES_API FaceState
+    {
+      Element* left;   ///< The element the face is reported from (the lower id of a conforming pair).
+      Element* right;  ///< The conforming active neighbor across the face, NULL for an irregular face.
+      int left_surf;   ///< Local edge number of the face within left.
+      int right_surf;  ///< Local edge number within right, -1 when right == NULL.
+      int marker;      ///< Marker of the shared edge node.
+    };
+
     /// @ingroup inner
     /// Traverse is a multi-mesh traversal utility class. Given N meshes sharing the
     /// same base mesh it walks through all (pseudo-)elements of the union of all
@@ -79,6 +90,18 @@ namespace Hermes
     {
     public:
       Traverse(bool master = false);
+      ~Traverse();
+
+      /// Enables / disables reordering of the precomputed state streams along a
+      /// Hilbert space-filling curve (default: off). Consecutive states then
+      /// correspond to geometrically close elements, whose degrees of freedom
+      /// tend to share matrix rows and columns - the scatters of the assembling
+      /// loops stay within the cached part of the matrix instead of jumping in
+      /// tree order across the domain. Applies to the streams returned by
+      /// get_states(), which is what the assembling, adaptivity and projection
+      /// loops traverse (and chunk between threads); the stack-driven
+      /// get_next_state() walk streams its states and cannot be reordered.
+      static void use_space_filling_curve(bool use);
     private:
       class State
       {
@@ -101,9 +124,13 @@ namespace Hermes
         int isurf;
       friend class Traverse;
       friend class Views::Linearizer;
+      template<typename Scalar> friend class LocalProjection;
       friend class Views::Vectorizer;
       template<typename Scalar> friend class DiscreteProblem;
       template<typename Scalar> friend class DiscreteProblemLinear;
+      template<typename Scalar> friend class Adapt;
+      template<typename Scalar> friend class KellyTypeAdapt;
+      template<typename Scalar> friend class Global;
       };
 
       void begin(int n, const Mesh** meshes, Transformable** fn = NULL);
@@ -111,6 +138,43 @@ namespace Hermes
 
       State* get_next_state(int* top_by_ref = NULL, int* id_by_ref = NULL);
       int get_num_states(Hermes::vector<const Mesh*> meshes);
+
+      /// Preparation for parallel processing - precomputes all leaf states up front,
+      /// so that N threads can claim them by index (e.g. through an atomic counter or
+      /// an OpenMP for loop) without any synchronization on this instance.
+      /// The returned states are stand-alone deep copies independent of the internal stack.
+      /// \param[in] meshes The meshes to traverse.
+      /// \param[out] states_count Number of states returned.
+      State** get_states(Hermes::vector<const Mesh*> meshes, int& states_count);
+
+      /// Face-oriented traversal for face-term-only passes (DG assembling,
+      /// Kelly-type error estimation): enumerates the inner faces of a single
+      /// mesh straight from the edge connectivity, without deriving the union
+      /// volume state stream first. A conforming face is reported exactly once,
+      /// with both element views paired and the local edge numbers giving the
+      /// orientation; a face with an irregular (hanging-node) neighborhood is
+      /// reported from each active element touching it, with right == NULL, and
+      /// the caller resolves it through NeighborSearch as before. The returned
+      /// array is allocated with new[] and owned by the caller.
+      static FaceState* get_face_states(const Mesh* mesh, int& states_count);
+
+      /// Deallocates an array of states obtained from get_states().
+      /// Must not be called on an array owned by the states cache, \sa set_states_cache().
+      static void free_states(State** states, int states_count);
+
+      /// Turns the caching of the state stream on / off (default: off).
+      /// With the cache on, get_states() remembers the computed flat state array
+      /// together with the sequence numbers of the traversed meshes. As long as none
+      /// of the meshes changes, subsequent calls replay the remembered array instead
+      /// of re-deriving the union decomposition. The returned array is then owned by
+      /// this instance (valid until the meshes change or the instance is destroyed)
+      /// and must not be passed to free_states().
+      void set_states_cache(bool to_set);
+
+      /// Applies the active elements and sub-element transformations recorded in a
+      /// state to the functions passed to begin(). get_next_state() does this as it
+      /// walks; when replaying a cached state stream, it has to be done explicitly.
+      void apply_state(State* s);
       inline Element*  get_base() const { return base; }
 
       void init_transforms(State* s, int i);
@@ -140,8 +204,26 @@ namespace Hermes
 
       void free_state(State* state);
 
+      /// Drops the remembered state stream, \sa set_states_cache().
+      void free_states_cache();
+
+      /// Reorders a gathered state stream by the Hilbert index of the
+      /// representative element centroids, \sa use_space_filling_curve().
+      void sort_states_by_sfc(Hermes::vector<State*>& states);
+
+      /// \sa use_space_filling_curve().
+      static bool sfc_ordering_enabled;
+
       bool master;
 
+      /// \sa set_states_cache().
+      bool states_cache;
+      State** cached_states;
+      int cached_states_count;
+      /// Sequence numbers of the meshes the cached states were derived from.
+      unsigned int* cached_seqs;
+      int cached_seqs_count;
+
       Mesh* unimesh;
       template<typename T> friend class Adapt;
       template<typename T> friend class KellyTypeAdapt;
@@ -150,6 +232,7 @@ namespace Hermes
       template<typename T> friend class Filter;
       template<typename T> friend class SimpleFilter;
       template<typename T> friend class Global;
+      template<typename T> friend class LocalProjection;
       friend class Views::Orderizer;
       friend class Views::Vectorizer;
       friend class Views::Linearizer;
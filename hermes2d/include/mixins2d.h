@@ -114,6 +114,14 @@ namespace Hermes
         void set_rhs_number_format(char* number_format);
         
       protected:
+        /// Opens the file the matrix of the given iteration is dumped into.
+        /// The extension (".m" for the matlab format, ".mtx" for Matrix Market,
+        /// ".bin" for the raw binary dump) and text vs. binary open mode are
+        /// derived from the selected format.
+        FILE* open_matrix_file(int iteration) const;
+        /// Same as open_matrix_file(), for the rhs dump.
+        FILE* open_rhs_file(int iteration) const;
+
         bool print_matrix_zero_values;
         bool output_matrixOn;
         int output_matrixIterations;
@@ -0,0 +1,281 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+#ifndef __H2D_MULTIGRID_SOLVER_H
+#define __H2D_MULTIGRID_SOLVER_H
+
+#include "global.h"
+#include "space/space.h"
+#include "weakform/weakform.h"
+#include <vector>
+#include <map>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// The smoother run on each level of the multigrid hierarchy,
+    /// \sa MultigridSolver::set_smoother().
+    enum MultigridSmootherType
+    {
+      H2D_SMOOTHER_JACOBI,       ///< Damped Jacobi, \sa MultigridSolver::set_jacobi_weight().
+      H2D_SMOOTHER_GAUSS_SEIDEL  ///< Forward Gauss-Seidel.
+    };
+
+    /// @ingroup userSolvingAPI
+    /// Geometric multigrid solver built on the mesh refinement hierarchy.
+    ///
+    /// Takes a weak formulation and a sequence of first-order H1 spaces on
+    /// nested meshes (each mesh a copy of the previous one with elements
+    /// refined), ordered from the coarsest to the finest. The transfer
+    /// operators are constructed from the vertex parentage the refinement
+    /// routines record (Node::p1, Node::p2): a vertex created by refinement
+    /// is the midpoint of its two parents, so its coarse-level value is the
+    /// average of theirs, applied recursively until coarse vertices are
+    /// reached. Restriction is the transpose of this prolongation.
+    ///
+    /// Each level is assembled with DiscreteProblemLinear and smoothed with
+    /// damped Jacobi or Gauss-Seidel sweeps working directly on the CSC
+    /// arrays; the coarsest system is solved directly. The V-cycle iteration
+    /// converges in O(N) operations for elliptic (Poisson-like) problems,
+    /// where a direct solve scales superlinearly. A single V-cycle is also
+    /// exposed through apply_vcycle() so the class can serve as a
+    /// preconditioner operation inside an outer Krylov iteration.
+    ///
+    /// Limitations: one space per level (scalar equations), essential
+    /// boundary values are treated as fixed (the correction there is zero)
+    /// and hanging-node constrained vertices are skipped by the transfer,
+    /// so regularized meshes are preferable.
+    template<typename Scalar>
+    class HERMES_API MultigridSolver : public Hermes::Mixins::Loggable
+    {
+    public:
+      /// \param[in] wf The weak formulation, shared by all the levels.
+      /// \param[in] spaces The level spaces, ordered coarsest to finest,
+      /// defined on nested meshes. At least two levels are required.
+      MultigridSolver(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar>*> spaces);
+      ~MultigridSolver();
+
+      /// Select the smoother (default: Gauss-Seidel).
+      void set_smoother(MultigridSmootherType smoother);
+
+      /// Numbers of smoothing sweeps before the restriction and after the
+      /// prolongation (default: 2 and 2).
+      void set_smoothing_sweeps(int pre_sweeps, int post_sweeps);
+
+      /// Damping factor of the Jacobi smoother (default: 2/3).
+      void set_jacobi_weight(double weight);
+
+      /// Relative residual tolerance stopping the V-cycle iteration (default: 1e-8).
+      void set_tolerance(double tolerance);
+
+      /// Maximum number of V-cycles of solve() (default: 100).
+      void set_max_iters(int max_iters);
+
+      /// Assembles all the levels (on the first call), then iterates V-cycles
+      /// on the finest system until the relative residual drops below the
+      /// tolerance or the maximum number of cycles is reached.
+      void solve();
+
+      /// The finest-level solution vector of the last solve().
+      Scalar* get_sln_vector();
+
+      /// Number of V-cycles the last solve() performed.
+      int get_num_iters() const;
+
+      /// Final residual norm of the last solve().
+      double get_residual_norm() const;
+
+      /// Runs one V-cycle for the given finest-level right-hand side, starting
+      /// from a zero initial guess: out = M^{-1} rhs with M the multigrid
+      /// operator. This is the preconditioning operation for an outer Krylov
+      /// method. Assembles the levels on the first call.
+      /// \param[in] rhs Right-hand side (residual) vector, length of the finest space's ndof.
+      /// \param[out] out The result, same length.
+      void apply_vcycle(const Scalar* rhs, Scalar* out);
+
+    protected:
+      /// Data of one level of the hierarchy: the assembled matrix, the level
+      /// vectors of the V-cycle and the prolongation from the next coarser
+      /// level stored by rows of the fine DOFs (identity weights omitted).
+      struct Level
+      {
+        const Space<Scalar>* space;
+        int ndof;
+        SparseMatrix<Scalar>* mat;
+        Scalar* x;     ///< Iterate / correction.
+        Scalar* b;     ///< Level right-hand side.
+        Scalar* r;     ///< Residual work vector.
+        Scalar* diag;  ///< Matrix diagonal, extracted for the smoothers.
+        int* prol_ptr;     ///< Row pointers, length ndof + 1. NULL on the coarsest level.
+        int* prol_dof;     ///< Coarse DOF indices of the entries.
+        double* prol_weight; ///< Entry weights.
+      };
+
+      /// Assembles the matrices and the finest right-hand side, extracts the
+      /// diagonals and builds the transfer operators. Run once, on demand.
+      void assemble();
+
+      /// Builds the prolongation of the given level (> 0) from the next
+      /// coarser one, from the vertex parent records of the fine mesh.
+      void build_transfer(int level);
+
+      /// Distributes the value of the fine vertex node with the given id onto
+      /// coarse DOFs: directly if the vertex exists on the coarse mesh,
+      /// through the parent vertices with halved weight otherwise.
+      void resolve_coarse_dofs(Mesh* fine_mesh, const Space<Scalar>* coarse_space,
+        int node_id, double weight, std::map<int, double>& target);
+
+      /// Runs the configured number of smoothing sweeps on the level system.
+      void smooth(int level, int sweeps);
+
+      /// Computes the level residual r = b - A x.
+      void compute_residual(int level);
+
+      /// The recursive V-cycle on the given level.
+      void v_cycle(int level);
+
+      /// Direct solve of the coarsest system.
+      void solve_coarsest();
+
+      const WeakForm<Scalar>* wf;
+      std::vector<Level> levels;
+      bool assembled;
+
+      /// The assembled finest right-hand side.
+      Vector<Scalar>* rhs;
+      /// The direct solver of the coarsest system, kept so its factorization is reused.
+      Hermes::Solvers::LinearMatrixSolver<Scalar>* coarse_solver;
+      /// Right-hand side vector the coarse solver is bound to.
+      Vector<Scalar>* coarse_rhs;
+
+      MultigridSmootherType smoother;
+      int pre_sweeps, post_sweeps;
+      double jacobi_weight;
+      double tolerance;
+      int max_iters;
+
+      int num_iters;
+      double residual_norm;
+    };
+
+    /// @ingroup userSolvingAPI
+    /// Two-level p-hierarchical solver for high-order H1 spaces.
+    ///
+    /// The complement of MultigridSolver for p-refined problems: instead of a
+    /// mesh hierarchy it uses the polynomial hierarchy of a single space. The
+    /// vertex functions of the H1 shapeset span the piecewise-linear (p = 1)
+    /// subspace of the full space, so the coarse embedding is a plain index
+    /// selection of the vertex DOFs and the coarse operator is the
+    /// corresponding principal submatrix of the assembled matrix - no
+    /// interpolation is involved. A cycle smooths on the full-order system
+    /// (damped Jacobi or Gauss-Seidel), solves the p = 1 correction directly
+    /// and smooths again, which removes the conditioning growth with the
+    /// polynomial degree that otherwise forces high-order runs onto direct
+    /// solvers. One cycle is exposed through apply_cycle() for use as a
+    /// preconditioner operation inside an outer Krylov iteration.
+    template<typename Scalar>
+    class HERMES_API PMultigridSolver : public Hermes::Mixins::Loggable
+    {
+    public:
+      /// \param[in] wf The weak formulation.
+      /// \param[in] space The full (high-order) H1 space.
+      PMultigridSolver(const WeakForm<Scalar>* wf, const Space<Scalar>* space);
+      ~PMultigridSolver();
+
+      /// Select the smoother (default: Gauss-Seidel).
+      void set_smoother(MultigridSmootherType smoother);
+
+      /// Numbers of smoothing sweeps before and after the coarse correction
+      /// (default: 2 and 2).
+      void set_smoothing_sweeps(int pre_sweeps, int post_sweeps);
+
+      /// Damping factor of the Jacobi smoother (default: 2/3).
+      void set_jacobi_weight(double weight);
+
+      /// Relative residual tolerance stopping the iteration of solve() (default: 1e-8).
+      void set_tolerance(double tolerance);
+
+      /// Maximum number of cycles of solve() (default: 100).
+      void set_max_iters(int max_iters);
+
+      /// Assembles the system (on the first call), then iterates two-level
+      /// cycles until the relative residual drops below the tolerance or the
+      /// maximum number of cycles is reached.
+      void solve();
+
+      /// The solution vector of the last solve().
+      Scalar* get_sln_vector();
+
+      /// Number of cycles the last solve() performed.
+      int get_num_iters() const;
+
+      /// Final residual norm of the last solve().
+      double get_residual_norm() const;
+
+      /// Runs one cycle for the given right-hand side, starting from a zero
+      /// initial guess: out = M^{-1} rhs with M the two-level operator. This
+      /// is the preconditioning operation for an outer Krylov method.
+      /// Assembles the system on the first call.
+      void apply_cycle(const Scalar* rhs, Scalar* out);
+
+    protected:
+      /// Assembles the full system, selects the vertex DOFs, extracts their
+      /// principal submatrix as the coarse operator and factorizes it.
+      void assemble();
+
+      /// Runs the configured number of smoothing sweeps on the full system.
+      void smooth(int sweeps);
+
+      /// Computes the residual r = b - A x.
+      void compute_residual();
+
+      /// One two-level cycle: smooth, p = 1 correction, smooth.
+      void cycle();
+
+      const WeakForm<Scalar>* wf;
+      const Space<Scalar>* space;
+      int ndof;
+      bool assembled;
+
+      SparseMatrix<Scalar>* mat;
+      /// The assembled right-hand side.
+      Vector<Scalar>* rhs;
+      Scalar* x;     ///< Iterate.
+      Scalar* b;     ///< Right-hand side of the current cycle iteration.
+      Scalar* r;     ///< Residual work vector.
+      Scalar* diag;  ///< Matrix diagonal, extracted for the smoothers.
+
+      int coarse_ndof;
+      int* coarse_dof;     ///< Full-system DOF number of each coarse DOF.
+      int* full_to_coarse; ///< Coarse DOF number of each full DOF, -1 for non-vertex DOFs.
+      /// The vertex-DOF principal submatrix.
+      SparseMatrix<Scalar>* coarse_mat;
+      /// Its direct solver, kept so the factorization is reused.
+      Hermes::Solvers::LinearMatrixSolver<Scalar>* coarse_solver;
+      /// Right-hand side vector the coarse solver is bound to.
+      Vector<Scalar>* coarse_rhs;
+
+      MultigridSmootherType smoother;
+      int pre_sweeps, post_sweeps;
+      double jacobi_weight;
+      double tolerance;
+      int max_iters;
+
+      int num_iters;
+      double residual_norm;
+    };
+  }
+}
+#endif
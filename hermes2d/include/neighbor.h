@@ -408,6 +408,15 @@ namespace Hermes
       /// Cleaning of internal structures before a new edge is set as active.
       void reset_neighb_info();
 
+      /// Fill in the neighborhood information from a record cached on the mesh
+      /// (see Mesh::EdgeNeighborhood), skipping the tree traversal performed by
+      /// \c set_active_edge on a cache miss.
+      void init_from_neighborhood_cache(const Mesh::EdgeNeighborhood* cached);
+
+      /// Store the just-computed neighborhood of the active edge into the mesh
+      /// cache, so that subsequent searches over the same edge find it there.
+      void store_neighborhood_cache();
+
       /*** Quadrature on the active edge. ***/
       Quad2D* quad;
 
@@ -182,6 +182,18 @@ namespace Hermes
       /// \param[in] steps Number of steps.
       void set_necessary_successful_steps_to_increase(unsigned int steps);
 
+      /// Turn on or off the automatic refresh of the Jacobian kept by solve_keep_jacobian().
+      /// By default the policy is off and solve_keep_jacobian() freezes the Jacobian for the whole
+      /// calculation (the original behavior). With the policy on, the kept Jacobian is reused only
+      /// while the residual norm keeps contracting well enough, i.e. while the current residual
+      /// norm stays below ratio times the previous one. When the contraction stalls, the Jacobian
+      /// is reassembled at the current iterate and refactorized (reusing the matrix reordering),
+      /// and the reuse starts over. This is the usual modified-Newton trade-off: an occasional
+      /// reassembly and factorization against extra nonlinear iterations with a stale Jacobian.
+      /// \param[in] onOff on(true) - refresh on stall, off(false) - never refresh.
+      /// \param[in] ratio The worst acceptable contraction of the residual norm per step, must be positive. Ignored when switching off.
+      void set_jacobian_refresh_policy(bool onOff, double ratio = 0.5);
+
       /// Set the weak forms.
       void set_weak_formulation(const WeakForm<Scalar>* wf);
 
@@ -226,6 +238,11 @@ namespace Hermes
       double sufficient_improvement_factor;
       /// necessary number of steps to increase back the damping coeff.
       unsigned int necessary_successful_steps_to_increase;
+
+      /// Refresh the kept jacobian when convergence stalls (see set_jacobian_refresh_policy()).
+      bool jacobian_refresh;
+      /// The worst acceptable residual contraction per step before the kept jacobian is refreshed.
+      double jacobian_refresh_ratio;
     };
   }
 }
@@ -127,7 +127,12 @@ namespace Hermes
     protected:
       void init();
       
-      static void calculate_anderson_coeffs(Scalar** previous_vectors, Scalar* anderson_coeffs, int num_last_vectors_used, int ndof);
+      /// Solves the small least-squares problem of the Anderson mixing. The
+      /// residuals of the stored iteration history are passed in directly -
+      /// solve() keeps them in a ring of preallocated buffers updated with one
+      /// new residual per iteration, so no residual is ever recomputed from
+      /// the vector history here.
+      static void calculate_anderson_coeffs(Scalar** previous_residuals, Scalar* anderson_coeffs, int num_last_vectors_used, int ndof);
       
       bool verbose_output_linear_solver;
 
@@ -53,6 +53,33 @@ namespace Hermes
           Hermes::vector<Solution<Scalar>*> source_slns, Hermes::vector<Solution<Scalar>*> target_slns,
           Hermes::vector<ProjNormType> proj_norms = Hermes::vector<ProjNormType>(), bool delete_old_mesh = false);
 
+      /// Element-local transfer of a solution into a coarser space: the source
+      /// coefficients are restricted to the coarse basis by a small dense L2
+      /// solve per element, without any global assembly. The source mesh has to
+      /// be a refinement of the mesh of the space - this holds after
+      /// derefinement as well as for the reference solution of an adaptivity
+      /// step, so in adapt loops this replaces the global
+      /// OGProjection::project_global() solve before Adapt::calc_err_est().
+      /// Every son element is integrated on the parent through the common
+      /// sub-element transformations. Coefficients of basis functions shared by
+      /// several elements are averaged.
+      static void transfer_to_coarse(const Space<Scalar>* space, MeshFunction<Scalar>* meshfn,
+          Scalar* target_vec);
+
+      /// Wrapper of transfer_to_coarse() that delivers a Solution instead of a
+      /// coefficient vector.
+      static void transfer_to_coarse(const Space<Scalar>* space, Solution<Scalar>* source_sln,
+          Solution<Scalar>* target_sln);
+
+      /// Wrapper of transfer_to_coarse() that takes multiple MeshFunctions.
+      static void transfer_to_coarse(Hermes::vector<const Space<Scalar>*> spaces,
+          Hermes::vector<MeshFunction<Scalar>*> meshfns, Scalar* target_vec);
+
+      /// Wrapper of transfer_to_coarse() that delivers Solutions instead of a
+      /// coefficient vector.
+      static void transfer_to_coarse(Hermes::vector<const Space<Scalar>*> spaces,
+          Hermes::vector<Solution<Scalar>*> source_slns, Hermes::vector<Solution<Scalar>*> target_slns);
+
     protected:
       static int ndof;
     };
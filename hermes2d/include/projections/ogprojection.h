@@ -19,6 +19,7 @@
 #include "../function/solution.h"
 #include "../forms.h"
 #include "../weakform/weakform.h"
+#include "solvers/linear_matrix_solver.h"
 
 namespace Hermes
 {
@@ -35,9 +36,35 @@ namespace Hermes
     {
     public:
       OGProjection();
+      ~OGProjection();
+
+      /// Keeps the assembled projection matrix together with its factorization between
+      /// successive norm-based projections and reassembles only the right-hand side, as
+      /// long as the target space keeps its sequence number and the norm stays the same.
+      /// Projections with custom forms always assemble from scratch.
+      void set_reuse_projection_matrix();
+
+      /// Replaces the solve of an L2 projection with a scale by the lumped (row-summed)
+      /// mass matrix diagonal. This is an approximation of the projection - cheap and
+      /// often sufficient, e.g. for transferring a previous time level. Other norms are
+      /// not affected. The lumped diagonal is cached on the space sequence number just
+      /// like the matrix above.
+      void set_lumped_l2_projection();
+
+      /// Solves the L2 projection onto a discontinuous (L2) space through a
+      /// block-diagonal mass matrix instead of the global sparse path: the
+      /// DOFs of an L2 space never couple across elements, so the mass matrix
+      /// falls apart into per-element dense blocks that are factorized and
+      /// solved independently in parallel (see Algebra::BlockDiagonalMatrix).
+      /// Unlike the lumping above this is the exact projection. Spaces and
+      /// norms other than L2 are not affected.
+      void set_block_diagonal_l2_projection();
+
+      /// Drops the cached projection matrix / lumped diagonal.
+      void free_cache();
 
       /// Main functionality is in the protected method project_internal().
-      
+
       /// This method allows to specify your own OG-projection form.
       void project_global(const Space<Scalar>* space,
           MatrixFormVol<Scalar>* custom_projection_jacobian,
@@ -109,6 +136,27 @@ namespace Hermes
       /// PDE, the PDE will just be solved.
       void project_internal(const Space<Scalar>* space, WeakForm<Scalar>* proj_wf, Scalar* target_vec);
 
+      /// Norm-based projection going through the matrix cache (and optionally the mass
+      /// lumping). See set_reuse_projection_matrix() and set_lumped_l2_projection().
+      void project_cached(const Space<Scalar>* space, WeakForm<Scalar>* proj_wf, Scalar* target_vec, ProjNormType norm);
+
+      /// L2 projection through the block-diagonal mass matrix.
+      /// See set_block_diagonal_l2_projection().
+      void project_block_diagonal(const Space<Scalar>* space, WeakForm<Scalar>* proj_wf, Scalar* target_vec);
+
+      bool reuse_projection_matrix;
+      bool lumped_l2_projection;
+      bool block_diagonal_l2_projection;
+
+      /// The cached projection system and the key it is valid for.
+      SparseMatrix<Scalar>* cached_matrix;
+      Vector<Scalar>* cached_rhs;
+      Hermes::Solvers::LinearMatrixSolver<Scalar>* cached_solver;
+      Scalar* cached_lumped_diagonal;
+      int cached_space_seq;
+      int cached_ndof;
+      ProjNormType cached_norm;
+
       /// Jacobian matrix (same as stiffness matrix since projections are linear).
       class ProjectionMatrixFormVol : public MatrixFormVol<Scalar>
       {
@@ -31,7 +31,15 @@ namespace Hermes
     static int H2D_GIP1D_X = 0;
     static int H2D_GIP1D_W = 1;
 
+    /// Maximum order of the Gauss quadrature on quads (and of the 1D rules).
+    /// The EXTREME_QUAD configure option raises the cap for high-order
+    /// (spectral-style) runs; the tensor-product tables beyond the default
+    /// are generated from the stored 1D rules when the quadrature is built.
+#ifdef EXTREME_QUAD
+    const int g_max_quad = 40;
+#else
     const int g_max_quad = 24;
+#endif
     const int g_max_tri = 20;
 
     /// Quad1D is a base class for all 1D quadrature points.
@@ -62,8 +70,33 @@ namespace Hermes
     class HERMES_API Quad2D
     {
     public:
+      Quad2D()
+      {
+        soa_tables[0] = soa_tables[1] = NULL;
+      }
+
       inline int get_num_points(int order, ElementMode2D mode)  const { assert(order < num_tables[mode]); return np[mode][order]; };
       inline double3* get_points(int order, ElementMode2D mode) const { assert(order < num_tables[mode]); return tables[mode][order]; }
+
+      /// Returns the points of the rule in a structure-of-arrays layout: separate
+      /// x[], y[] and w[] arrays, each aligned to HERMES_SIMD_ALIGNMENT, so that
+      /// vectorized integration kernels can use aligned SIMD reads. The padding
+      /// entries of w[] are zero - a loop rounded up to whole vectors adds nothing.
+      /// Only quadratures which build the layout offer it (Quad2DStd does);
+      /// returns false otherwise and the caller falls back to the double3 layout.
+      inline bool get_points(int order, ElementMode2D mode, const double*& x, const double*& y, const double*& w) const
+      {
+        assert(order < num_tables[mode]);
+        if(soa_tables[mode] == NULL || soa_tables[mode][order] == NULL)
+          return false;
+        // each section is padded to a whole number of aligned blocks
+        int stride = (np[mode][order] + soa_pad - 1) & ~(soa_pad - 1);
+        x = soa_tables[mode][order];
+        y = x + stride;
+        w = y + stride;
+        return true;
+      }
+
       inline int get_edge_points(int edge, int order, ElementMode2D mode) {assert(order < num_tables[mode]);  return  max_order[mode]+1 + (3*(1-mode) + 4*mode)*order + edge;}
 
       inline int get_max_order(ElementMode2D mode) const { return max_order[mode]; }
@@ -73,6 +106,21 @@ namespace Hermes
       inline double2* get_ref_vertex(int n, ElementMode2D mode) { return &ref_vert[mode][n]; }
 
     protected:
+      /// Builds the aligned structure-of-arrays copies of 'tables'. Called by
+      /// the quadratures offering the layout (see the get_points() overload)
+      /// once their double3 tables and point counts are filled in.
+      void build_soa_tables();
+
+      /// Frees the tables built by build_soa_tables().
+      void free_soa_tables();
+
+      /// Number of doubles per HERMES_SIMD_ALIGNMENT-sized block.
+      static const int soa_pad = HERMES_SIMD_ALIGNMENT / sizeof(double);
+
+      /// Per mode and order, one aligned block [x | y | w], each section padded
+      /// to a multiple of soa_pad entries; NULL where not built.
+      double** soa_tables[2];
+
       double3*** tables;
       int** np;
 
@@ -74,6 +74,45 @@ namespace Hermes
         TrfShape* cached_shape_ortho_vals; ///< Precalculated valus of orthogonalized shape functions.
         TrfShape* cached_shape_vals; ///< Precalculate values of shape functions.
 
+        /// Fills the tables above for the given mode, if they have not been filled yet.
+        /// Called lazily from calc_projection_errors(); Adapt::adapt() calls it before its
+        /// parallel selection loop, so that the selector clones sharing the tables only read them.
+        void precalc_cached_shape_vals(ElementMode2D mode);
+
+        /// Enables reuse of candidate projection errors between subsequent runs of the
+        /// adaptivity loop (off by default). The errors of all candidates examined on an
+        /// element are stored together with a cheap signature of the reference solution
+        /// there; when, in a later run, the element has the same refinement configuration
+        /// and examined order ranges and the signature has drifted relatively less than
+        /// the tolerance (set_candidate_eval_delta()), the stored errors are used and all
+        /// the projections are skipped. Meant for evolution problems where large parts of
+        /// the mesh stabilize after a few steps. Costs about 10 kB of memory per cached
+        /// element.
+        void set_candidate_eval_caching(bool to_set = true);
+
+        /// Sets the relative drift of the reference solution signature under which the
+        /// cached candidate errors are considered valid, see set_candidate_eval_caching().
+        /// The default value is 1e-3.
+        void set_candidate_eval_delta(double delta);
+
+        /// A record of the candidate error cache, see set_candidate_eval_caching().
+        struct CandProjErrorCacheEntry {
+          int config[14]; ///< Refinement configuration of the element and the ranges of the examined orders.
+          double signature; ///< A signature of the reference solution on the element.
+          CandElemProjError herr[H2D_MAX_ELEMENT_SONS]; ///< Stored errors of elements of H-candidates.
+          CandElemProjError perr; ///< Stored errors of elements of P-candidates.
+          CandElemProjError anisoerr[H2D_MAX_ELEMENT_SONS]; ///< Stored errors of elements of ANISO-candidates.
+        };
+
+        bool candidate_eval_caching; ///< True if the caching of candidate errors between adaptivity runs is on.
+        double candidate_eval_delta; ///< The tolerance of the signature drift, see set_candidate_eval_delta().
+
+        /// The cache of candidate errors, keyed by the element ID. Owned by the selector
+        /// which created it; Adapt::adapt() points the clones of the selector to the cache
+        /// of the master, so that all threads share one cache, in the same way as the
+        /// shape value tables above.
+        std::map<int, CandProjErrorCacheEntry*>* cand_proj_error_cache;
+
       protected: //evaluated shape basis
         /// A transform shaped function expansions.
         /** The contents of the class can be accessed through an array index operator.
@@ -225,9 +264,18 @@ namespace Hermes
         *  is the horizontal and the vertical order respectively.
         *
         *  All matrices are square dense matrices and they have to be created through the function new_matrix().
-        *  If record is NULL, the corresponding matrix has to be calculated. */
+        *  If record is NULL, the corresponding matrix has to be calculated.
+        *  The matrices are stored already LU-factorized (the factorization depends only
+        *  on the shape set and the integration points, not on the element), so every
+        *  candidate evaluation just back-substitutes its right-hand side. */
         ProjMatrixCache proj_matrix_cache[H2D_NUM_MODES];
 
+        /// A projection matrix pivot cache type, \sa proj_matrix_cache.
+        typedef int* ProjMatrixPivotCache[H2DRS_MAX_ORDER + 2][H2DRS_MAX_ORDER + 2];
+
+        /// Pivot vectors of the LU factorizations stored in proj_matrix_cache.
+        ProjMatrixPivotCache proj_matrix_pivot_cache[H2D_NUM_MODES];
+
         /// An array of cached right-hand side values.
         /** The first index is an index of the shape function.
         *
@@ -21,6 +21,7 @@
 #include "function/filter.h"
 #include "exceptions.h"
 #include "mixins2d.h"
+#include "solvers/block_diagonal_matrix.h"
 namespace Hermes
 {
   namespace Hermes2D
@@ -112,6 +113,34 @@ namespace Hermes
       void rk_time_step_newton(Solution<Scalar>* sln_time_prev, Solution<Scalar>* sln_time_new);
 
       void set_freeze_jacobian();
+
+      /// Replaces the stage mass solves by a diagonal lumped mass vector; only
+      /// available with explicit Butcher's tables and H1 / L2 spaces. The lumped
+      /// vector is obtained by row-sum lumping of the mass matrix, assembled once
+      /// per space sequence, and each stage then costs one residual assembly and
+      /// a vector scale - no stage Jacobian is assembled or factorized at all.
+      /// Must be called before the first call to rk_time_step_newton().
+      void set_lumped_mass_matrix();
+
+      /// Replaces the stage mass solves by dense per-element block solves; only
+      /// available with explicit Butcher's tables and L2 spaces, whose DOFs never
+      /// couple across elements. The mass matrix is assembled once per space
+      /// sequence into an Algebra::BlockDiagonalMatrix and factorized block by
+      /// block in parallel; unlike the lumping above this is the exact mass
+      /// inverse, so it does not change the scheme. Each stage then costs one
+      /// residual assembly and the batched block back-substitutions - no global
+      /// sparse solve at all. Must be called before the first call to
+      /// rk_time_step_newton().
+      void set_block_diagonal_mass_matrix();
+
+      /// Keep the stage Jacobian matrix and its factorization from the previous call
+      /// to rk_time_step_newton() whenever neither the time step nor the spaces have
+      /// changed in between, instead of reassembling and refactorizing at the start
+      /// of every call. Only effective together with set_freeze_jacobian(). Meant
+      /// mainly for adaptive time stepping, where long runs of equal accepted steps
+      /// occur (see RungeKuttaTimeStepController).
+      void set_reuse_jacobian_across_steps();
+
       void set_newton_tol(double newton_tol);
       void set_newton_max_iter(int newton_max_iter);
       void set_newton_damping_coeff(double newton_damping_coeff);
@@ -157,6 +186,14 @@ namespace Hermes
       /// Updates the augmented weak formulation.
       void update_stage_wf(Hermes::vector<Solution<Scalar>*> slns_time_prev);
 
+      /// Recomputes the lumped mass vector (row sums of the mass matrix) when the
+      /// spaces changed since it was last computed; otherwise does nothing.
+      void update_lumped_mass_vector();
+
+      /// Reassembles and refactorizes the block-diagonal mass matrix when the
+      /// spaces changed since it was last computed; otherwise does nothing.
+      void update_block_mass_matrix();
+
       // Prepare u_ext_vec.
       void prepare_u_ext_vec();
 
@@ -194,6 +231,25 @@ namespace Hermes
       WeakForm<Scalar> stage_wf_left;
       DiscreteProblem<Scalar>* stage_dp_left;
 
+      /// Single-stage residual weak formulation for the explicit lumped-mass path
+      /// (size ndof, the stage time is set before each stage evaluation).
+      WeakForm<Scalar> stage_wf_explicit;
+      DiscreteProblem<Scalar>* stage_dp_explicit;
+
+      /// Use the lumped mass explicit path, see set_lumped_mass_matrix().
+      bool lumped_mass;
+      /// Row sums of the mass matrix, length ndof.
+      Scalar* lumped_mass_vector;
+      /// The space seqs the current lumped mass vector was computed with.
+      Hermes::vector<unsigned int> lumped_mass_spaces_seqs;
+
+      /// Use the block-diagonal mass explicit path, see set_block_diagonal_mass_matrix().
+      bool block_diagonal_mass;
+      /// The factorized per-element mass blocks.
+      Algebra::BlockDiagonalMatrix<Scalar>* block_mass_matrix;
+      /// The space seqs the current block mass matrix was computed with.
+      Hermes::vector<unsigned int> block_mass_spaces_seqs;
+
       bool start_from_zero_K_vector;
       bool block_diagonal_jacobian;
       bool residual_as_vector;
@@ -203,6 +259,12 @@ namespace Hermes
 
       bool do_global_projections;
       bool freeze_jacobian;
+      /// Reuse the stage Jacobian across calls with an unchanged time step and spaces.
+      bool reuse_jacobian_across_steps;
+      /// The time step the current stage Jacobian was assembled with.
+      double jacobian_time_step;
+      /// The space seqs the current stage Jacobian was assembled with.
+      Hermes::vector<unsigned int> jacobian_spaces_seqs;
       double newton_tol;
       int newton_max_iter;
       double newton_damping_coeff;
@@ -223,6 +285,75 @@ namespace Hermes
       ///< The filters to reinitialize in every Newton's loop
       Hermes::vector<Filter<Scalar>*> filters_to_reinit;
     };
+
+    /// @ingroup userSolvingAPI
+    /// Adaptive time step controller for embedded Runge-Kutta methods.
+    /// Drives RungeKutta::rk_time_step_newton() with the temporal error estimate
+    /// coming from the second B-row of an embedded Butcher table: a step whose
+    /// relative error estimate exceeds the tolerance is rejected and repeated with
+    /// a smaller time step, an accepted step proposes the next step size by the
+    /// standard PI (proportional-integral) formula. Small step increases are
+    /// suppressed, so that runs of equal accepted steps can reuse the stage matrix
+    /// factorization when RungeKutta::set_reuse_jacobian_across_steps() is on.<br>
+    /// Typical usage:<br>
+    /// RungeKuttaTimeStepController<double> controller(&runge_kutta, &bt, 2, 1e-3);<br>
+    /// runge_kutta.set_time_step(initial_time_step);<br>
+    /// while(current_time < T)<br>
+    ///&nbsp;current_time += controller.do_time_step(&sln_time_prev, &sln_time_new, &error_fn);<br>
+    template<typename Scalar>
+    class HERMES_API RungeKuttaTimeStepController : public Hermes::Mixins::Loggable
+    {
+    public:
+      /// Constructor.
+      /// \param[in] runge_kutta The solver to drive. Its current time and time step are used and updated.
+      /// \param[in] bt The embedded Butcher table the solver was constructed with (nonzero B2 row required).
+      /// \param[in] order The lower of the two orders of the embedded pair (drives the step size exponents).
+      /// \param[in] tolerance The relative temporal error tolerance.
+      RungeKuttaTimeStepController(RungeKutta<Scalar>* runge_kutta, ButcherTable* bt, unsigned int order, double tolerance);
+
+      /// Set the relative temporal error tolerance.
+      void set_tolerance(double tolerance);
+
+      /// Set the minimum and maximum allowed time step.
+      /// Defaults: 1e-12 and 1e12. An exception is thrown when rejections push the step below the minimum.
+      void set_time_step_bounds(double min_time_step, double max_time_step);
+
+      /// Set the safety factor of the step size formula.
+      /// Default: 0.9.
+      void set_safety_factor(double factor);
+
+      /// Set the smallest step increase that is actually applied; proposed increases below
+      /// this threshold keep the step unchanged so that the stage matrix factorization
+      /// stays reusable. Default: 1.2. Must be > 1.0.
+      void set_step_increase_threshold(double threshold);
+
+      /// Make one accepted time step: repeats rejected attempts with a smaller time step
+      /// until the error estimate meets the tolerance, then advances the solver's time
+      /// and proposes the next time step. Returns the step size actually used.
+      double do_time_step(Hermes::vector<Solution<Scalar>*> slns_time_prev,
+        Hermes::vector<Solution<Scalar>*> slns_time_new,
+        Hermes::vector<Solution<Scalar>*> error_fns);
+
+      /// Make one accepted time step, version for one equation.
+      double do_time_step(Solution<Scalar>* sln_time_prev, Solution<Scalar>* sln_time_new,
+        Solution<Scalar>* error_fn);
+
+    protected:
+      RungeKutta<Scalar>* runge_kutta;
+      ButcherTable* bt;
+      /// The lower order of the embedded pair.
+      unsigned int order;
+      double tolerance;
+      double min_time_step;
+      double max_time_step;
+      double safety_factor;
+      double step_increase_threshold;
+      /// Exponents of the PI formula, set from the order.
+      double pi_alpha;
+      double pi_beta;
+      /// Error estimate of the last accepted step (the integral part of the PI formula).
+      double last_error;
+    };
   }
 }
 #endif
\ No newline at end of file
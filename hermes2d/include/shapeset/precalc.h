@@ -30,7 +30,7 @@ namespace Hermes
     /// PrecalcShapeset is a cache of precalculated shape function values.
     ///
     ///
-    class HERMES_API PrecalcShapeset : public Function<double>
+    class HERMES_API PrecalcShapeset : public Function<double>, public Hermes::MemoryAccounted
     {
     public:
       /// Returns type of space
@@ -62,6 +62,81 @@ namespace Hermes
       /// \param index[in] Shape index.
       void set_active_shape(int index);
 
+      /// Batched evaluation of a whole list of shape functions (e.g. the indices of an
+      /// AsmList) at the quadrature points of the given integration rule order, on the
+      /// active element and with the current sub-element transform applied. The transform
+      /// of the quadrature points is done once and shared by all the shapes, instead of
+      /// once per set_active_shape() / get_values() pair.
+      /// Results are stored contiguously as [shape][point], i.e. the value of shape s at
+      /// point i goes to values[s * np + i]; each output array must hold num_shapes * np
+      /// doubles, np being the point count of the rule. dx and dy may be NULL if the
+      /// derivatives are not needed. The node cache is bypassed entirely.
+      /// \param indices[in] Shape indices, constrained (negative) indices are allowed.
+      /// \param num_shapes[in] Number of shape indices.
+      /// \param order[in] Integration rule order.
+      /// \param component[in] Shapeset component, 0 for scalar shapesets, 0 or 1 for vector ones.
+      void precalculate_shape_block(const int* indices, int num_shapes, int order,
+        double* values, double* dx, double* dy, int component = 0);
+
+      /// Limits the total memory occupied by the precalculated value tables.
+      /// By default (limit == 0) the tables are only freed on destruction and can grow
+      /// without bound in long runs with deep sub-element transform chains. With a
+      /// positive limit set, the tables of the least recently activated shapes are
+      /// freed inside set_active_shape() whenever the total exceeds the limit; the
+      /// shape being activated and the master's active shape are never evicted.
+      /// Called on a slave instance, this sets the limit of the master holding the tables.
+      /// \param bytes[in] The limit in bytes, 0 turns the eviction off.
+      void set_cache_size_limit(int bytes);
+
+      /// Returns the number of bytes currently occupied by the precalculated value
+      /// tables (those of the master instance, if this is a slave).
+      int get_cache_bytes() const;
+
+      /// Deep memory usage: the precalculated value tables plus the object
+      /// itself. Slaves report their master's tables, so registering both
+      /// with Hermes::Api counts them twice.
+      virtual size_t get_memory_bytes() const;
+
+      /// Turns the thread-safe sharing of the master's tables on / off (default: off).
+      /// When on, a single set of precalculated tables serves all threads: lookups
+      /// are done without locking and a newly computed table is fully built first
+      /// and then published by a single pointer store inside a critical section,
+      /// with the table it replaces retired (kept until destruction) for the
+      /// threads which may still be reading it. Each thread still needs its own
+      /// (slave) PrecalcShapeset instance - only the tables are shared.
+      /// While sharing is on, the cache size limit (set_cache_size_limit()) is
+      /// not enforced, since eviction could free a table another thread reads.
+      /// Called on a slave instance, this sets the mode of its master.
+      void set_thread_safe_sharing(bool to_set = true);
+
+      /// See Function::set_quad_order. Reimplemented so that in the thread-safe
+      /// sharing mode the Node tables are only published by precalculate() inside
+      /// the critical section, never re-stored from here.
+      virtual void set_quad_order(unsigned int order, int mask = H2D_FN_DEFAULT);
+
+      /// See Function::precalculate_transform_chain. Reimplemented so that the table
+      /// re-attachment of each level goes through update_nodes_ptr_shared() and thus
+      /// stays valid in the thread-safe sharing mode.
+      virtual void precalculate_transform_chain(unsigned int order, int mask = H2D_FN_DEFAULT);
+
+      /// Writes the precalculated value tables into a binary cache file, so
+      /// that a later run can load them with load_cache() instead of
+      /// recomputing them. The tables only depend on the shapeset and the
+      /// quadrature, not on the mesh, so the file is stamped with the shapeset
+      /// id, the number of components and the signature of the quadrature
+      /// tables and stays valid across runs. Call on the master instance,
+      /// typically at the end of a job, e.g. by rank 0 only.
+      void save_cache(const char* filename);
+
+      /// Loads value tables written by save_cache(). Returns false and leaves
+      /// the instance unchanged when the file is missing or was written for a
+      /// different shapeset / quadrature; the tables are then built on demand
+      /// as usual and can be re-saved. Every process of a node may load the
+      /// same file - after the first one the reads are served from the OS page
+      /// cache, so the disk is hit once per node. Call on the master instance
+      /// before the tables are in (possibly multi-threaded) use.
+      bool load_cache(const char* filename);
+
     private:
       virtual void set_quad_2d(Quad2D* quad_2d);
 
@@ -107,6 +182,36 @@ namespace Hermes
 
       int max_index[H2D_NUM_MODES];
 
+      /// Frees the value tables of the least recently activated shapes until the cache
+      /// fits cache_size_limit again. keep_key is the key of the shape being activated
+      /// and is never evicted, and neither is this (master) instance's active shape.
+      /// Master instance only.
+      void evict_cache(unsigned keep_key);
+
+      int cache_size_limit; ///< Byte limit for the value tables, 0 = unlimited. Master instance only.
+      int cache_bytes;      ///< Bytes currently held in 'tables'. Master instance only.
+      unsigned cache_stamp; ///< Activation counter driving the least-recently-used ordering.
+      unsigned active_key;  ///< Key of the currently active shape, protected from eviction.
+      std::map<unsigned, unsigned> cache_stamps; ///< Shape key -> last activation stamp.
+
+      /// Thread-safe variant of Function::update_nodes_ptr(): sub-element tables
+      /// are immutable once published, a miss re-reads the current table and
+      /// inserts by copy-and-swap inside a critical section, retiring the copy
+      /// it replaces. Falls back to the plain version when sharing is off.
+      void update_nodes_ptr_shared();
+
+      bool thread_safe_sharing; ///< Share the tables between threads, see set_thread_safe_sharing(). Master instance only.
+
+      /// Sub-element tables replaced by copy-and-swap in the thread-safe sharing
+      /// mode. Their entries are shared with the current tables; the map objects
+      /// themselves are kept here until free(). Master instance only.
+      Hermes::vector<std::map<uint64_t, LightArray<Node*>*>*> retired_sub_tables;
+
+      /// Nodes replaced by mask-extended ones in the thread-safe sharing mode,
+      /// kept until free() for the threads which may still be reading them.
+      /// Master instance only.
+      Hermes::vector<Node*> retired_nodes;
+
       PrecalcShapeset* master_pss;
 
       /// Returns true iff this is a precalculated shapeset for test functions.
@@ -128,6 +233,7 @@ namespace Hermes
       template<typename T> friend class DiscontinuousFunc;
       template<typename T> friend class DiscreteProblem;
       template<typename T> friend class NeighborSearch;
+      template<typename T> friend class LocalProjection;
       friend class CurvMap;
     };
   }
@@ -86,6 +86,7 @@ namespace Hermes
     class HERMES_API Shapeset : public Hermes::Mixins::Loggable
     {
     public:
+      Shapeset();
       ~Shapeset();
 
       /// Shape-function function type. Internal.
@@ -102,8 +103,18 @@ namespace Hermes
       int get_num_components() const;
 
       /// Returns the maximum poly degree for all shape functions.
+      /// Takes a cap set through set_order_cap() into account.
       int get_max_order() const;
 
+      /// Caps the polynomial degree reported by get_max_order(). Spaces clamp element
+      /// orders to this value, so the precalculated function values and constrained edge
+      /// combinations of the degrees above the cap are never materialized. The cap may be
+      /// raised (or removed by passing -1) at any time, e.g. when hp-adaptivity is about
+      /// to need higher degrees - the skipped table sections are then filled lazily on
+      /// first use as usual.
+      void set_order_cap(int cap);
+      int get_order_cap() const;
+
       /// Returns the highest shape function index.
       virtual int get_max_index(ElementMode2D mode) = 0;
 
@@ -133,6 +144,14 @@ namespace Hermes
       /// domain, component is 0 for Scalar shapesets and 0 or 1 for vector shapesets.
       double get_value(int n, int index, double x, double y, int component, ElementMode2D mode);
 
+      /// Batch variant of get_value(): evaluates one shape function at a whole
+      /// array of points in a single call. The function pointer is resolved from
+      /// the tables once and the points are swept in one tight loop over
+      /// contiguous arrays, instead of re-dispatching per point - this is the
+      /// innermost loop of the PrecalcShapeset table construction. Constrained
+      /// (combined) shape functions fall back to the per-point path.
+      void get_values(int n, int index, const double* x, const double* y, int np, int component, ElementMode2D mode, double* out);
+
       double get_fn_value (int index, double x, double y, int component, ElementMode2D mode);
       double get_dx_value (int index, double x, double y, int component, ElementMode2D mode);
       double get_dy_value (int index, double x, double y, int component, ElementMode2D mode);
@@ -156,6 +175,8 @@ namespace Hermes
 
       double2 ref_vert[H2D_MAX_SOLUTION_COMPONENTS][H2D_MAX_NUMBER_VERTICES];
       int max_order;
+      /// \sa set_order_cap(). -1 means no cap.
+      int order_cap;
       int num_components;
 
       int ebias; ///< 2 for H1 shapesets, 0 for H(curl) shapesets. It is the order of the
@@ -221,6 +242,32 @@ namespace Hermes
       template<typename Scalar> friend class HcurlSpace;
       template<typename Scalar> friend class HdivSpace;
     };
+
+    /// @ingroup spaces
+    /// \brief Process-wide registry of the default shapesets, one shared instance
+    /// per space type.
+    ///
+    /// Shapesets carry only the shape function definitions plus lazily built
+    /// caches and every default-constructed instance of one type is identical,
+    /// so a space that is not given a shapeset explicitly obtains the shared
+    /// instance from here instead of creating a private copy. The returned
+    /// instances are to be treated as immutable - a caller who needs to alter
+    /// a shapeset (e.g. via set_order_cap()) must construct an own instance
+    /// and pass it to the space.
+    class HERMES_API ShapesetRegistry
+    {
+    public:
+      /// Returns the shared default shapeset of the given space type,
+      /// creating it on first use.
+      static Shapeset* get_default_shapeset(SpaceType type);
+
+      /// Deletes the shared instances. Only to be called when no space
+      /// referring to them exists anymore.
+      static void free_shapesets();
+
+    private:
+      static Shapeset* shapesets[4];
+    };
   }
 }
 #endif
\ No newline at end of file
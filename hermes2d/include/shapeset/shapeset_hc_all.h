@@ -39,6 +39,24 @@ namespace Hermes
       static const int max_index[H2D_NUM_MODES];
     };
 
+    // The two experimental eigen-based shapesets below consist of several hundred
+    // thousand lines of generated code (shapeset_hc_eigen2.cpp, shapeset_hc_gradeigen.cpp).
+    // They are kept out of the build on purpose - the sources are not listed in
+    // CMakeLists.txt - so that the library does not carry their tables; to experiment
+    // with them, uncomment the declarations and add the two files to the build.
+    //
+    // Note on the footprint of these shapesets: what resides in memory is not numeric
+    // coefficient tables but the generated evaluation code itself - every shape function
+    // is emitted as a separate tiny C function (including thousands of identical zero
+    // components and separate copies for each edge orientation), plus the function
+    // pointer tables dispatching to them. A compressed representation would therefore
+    // have to replace the generator output with a data-driven evaluator - per-function
+    // lists of (coefficient, 1-D factor) terms over the shared legendre/lobatto/
+    // eigen-Laplace families, with the orientation sign and argument flip applied at
+    // evaluation time - rather than compress any existing in-memory arrays. That is a
+    // change to the (external) generator, not to this tree; until then, keeping the
+    // files out of the build is what actually keeps the footprint down.
+
     /*
     // Experimental.
     /// @ingroup spaces
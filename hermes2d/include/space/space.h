@@ -102,7 +102,7 @@ namespace Hermes
     /// The handling of irregular meshes is desribed in H1Space and HcurlSpace.<br>
     ///
     template<typename Scalar>
-    class HERMES_API Space : public Hermes::Mixins::Loggable, public Hermes::Hermes2D::Mixins::StateQueryable, public Hermes::Hermes2D::Mixins::XMLParsing
+    class HERMES_API Space : public Hermes::Mixins::Loggable, public Hermes::Hermes2D::Mixins::StateQueryable, public Hermes::Hermes2D::Mixins::XMLParsing, public Hermes::MemoryAccounted
     {
     public:
       Space();
@@ -152,6 +152,12 @@ namespace Hermes
       /// \brief Returns the number of basis functions contained in the space.
       int get_num_dofs() const;
 
+      /// Deep memory usage: the node and element data tables, which dominate
+      /// the space storage. Boundary-projection coefficient arrays hanging
+      /// off individual nodes are not walked.
+      /// \sa Hermes::Api::register_memory_report().
+      virtual size_t get_memory_bytes() const;
+
       /// \brief Returns the number of basis functions contained in the spaces.
       static int get_num_dofs(Hermes::vector<const Space<Scalar>*> spaces);
       static int get_num_dofs(Hermes::vector<Space<Scalar>*> spaces);
@@ -186,6 +192,20 @@ namespace Hermes
       /// Loads a space from a file.
       static Space<Scalar>* load(const char *filename, Mesh* mesh, bool validate, EssentialBCs<Scalar>* essential_bcs = NULL, Shapeset* shapeset = NULL);
 
+      /// Saves this space into a file in a compact binary format: a small versioned header
+      /// followed by the raw element data records and, since format version 2, the resolved
+      /// DOF numbering. Much faster than the XML save(), intended for frequent checkpointing
+      /// of large calculations.
+      bool save_bin(const char *filename) const;
+
+      /// Loads a space from a file previously created by Space::save_bin().
+      /// When the mesh structurally matches the one the space was saved with, the stored
+      /// DOF numbering is restored directly and only the boundary condition projections and
+      /// constraint coefficient lists are recomputed - the assign_dofs() numbering is
+      /// skipped entirely. On a mismatching mesh (or a version 1 file) the DOFs are
+      /// assigned from the element orders as before.
+      static Space<Scalar>* load_bin(const char *filename, Mesh* mesh, EssentialBCs<Scalar>* essential_bcs = NULL, Shapeset* shapeset = NULL);
+
       /// Obtains an assembly list for the given element.
       virtual void get_element_assembly_list(Element* e, AsmList<Scalar>* al, unsigned int first_dof = 0) const;
 
@@ -229,6 +249,15 @@ namespace Hermes
       /// intended primarily for internal use.
       virtual void set_element_order_internal(int id, int order);
 
+      /// Groups several set_element_order_internal() calls into one update.
+      /// Between begin and end the per-call table-resize checks and space
+      /// sequence bumps are skipped: the tables are resized once up front and
+      /// the sequence number is incremented once by end_order_updates(), so
+      /// applying thousands of order changes costs one invalidation instead
+      /// of one per element.
+      void begin_order_updates();
+      void end_order_updates();
+
       /// \brief Builds basis functions and assigns DOF numbers to them.
       /// \details This functions must be called \b after assigning element orders, and \b before
       /// using the space in a computation, otherwise an error will occur.
@@ -240,6 +269,34 @@ namespace Hermes
       /// \brief Assings the degrees of freedom to all Spaces in the Hermes::vector.
       static int assign_dofs(Hermes::vector<Space<Scalar>*> spaces);
 
+      /// Turns on / off the bandwidth-reducing DOF renumbering pass in assign_dofs().
+      /// When enabled, the DOFs are renumbered by the reverse Cuthill-McKee algorithm
+      /// run on the connectivity implied by the element assembly lists, which reduces
+      /// the matrix bandwidth and with it the fill-in of direct factorizations.
+      /// Off by default.
+      void set_bandwidth_reduction(bool to_set = true);
+
+      /// Turns on / off the caching of the element assembly lists. Off by default.
+      /// When enabled, get_element_assembly_list() builds the lists of all active elements
+      /// once (stored contiguously, so repeated iteration is cache-friendly) and later
+      /// visits of an element only copy its cached triplets, instead of re-resolving the
+      /// constrained nodes every time. The cache is invalidated whenever the DOFs are
+      /// reassigned or the essential boundary condition values are updated.
+      /// L2Space builds its trivial assembly lists directly and does not use the cache.
+      void set_assembly_list_caching(bool to_set = true);
+
+      /// Lets this space reuse the essential BC edge projections computed by another
+      /// space instead of recomputing them. Meant for systems where several components
+      /// on the same mesh carry the identical conditions (e.g. symmetric elasticity
+      /// constraints): set the first component space as the source of the others and
+      /// only one of them pays for the projections. A projection is taken over only
+      /// when it is provably the same - the source must use the same mesh, space type
+      /// and shapeset, the edge must carry the very same (time-invariant) boundary
+      /// condition object and have the same polynomial order in both spaces; edges
+      /// failing any of these checks fall back to the usual computation.
+      /// Pass NULL to turn the sharing off.
+      void set_bc_projection_source(Space<Scalar>* source);
+
       virtual Scalar* get_bc_projection(SurfPos* surf_pos, int order, EssentialBoundaryCondition<Scalar> *bc) = 0;
 
       static void update_essential_bc_values(Hermes::vector<Space<Scalar>*> spaces, double time);
@@ -281,6 +338,15 @@ namespace Hermes
       /// Returns the total (global) number of bubble functions.
       int get_bubble_functions_count();
 
+      /// Sequence number raised on every change of the space. Used by DiscreteProblem
+      /// to detect changes in the space; together with has_changed_since() it serves
+      /// as a cheap change stamp for export and monitoring code.
+      int get_seq() const;
+
+      /// True if the space has been changed (orders set, DOFs reassigned, ...) since
+      /// the given stamp was obtained from get_seq(), \sa Mesh::has_changed_since().
+      bool has_changed_since(int seq) const;
+
     protected:
       /// Number of degrees of freedom (dimension of the space).
       int ndof;
@@ -304,6 +370,8 @@ namespace Hermes
       int stride;
       int seq, mesh_seq;
       int was_assigned;
+      /// True inside a begin_order_updates() / end_order_updates() pair.
+      bool order_update_batch;
 
       struct BaseComponent
       {
@@ -363,21 +431,76 @@ namespace Hermes
 
       void update_orders_recurrent(Element* e, int order);
 
+      /// The numbering part of assign_dofs(): resets the assignment and numbers the vertex,
+      /// edge and bubble DOFs. Cheap; kept separate so that the static assign_dofs() overload
+      /// can chain the numbering of several spaces serially and then run the expensive
+      /// finalization of the individual spaces in parallel.
+      int assign_dofs_only(int first_dof = 0, int stride = 1);
+
+      /// The finalization part of assign_dofs(): the optional bandwidth-reducing renumbering,
+      /// boundary condition projections, constraint resolution and post-processing.
+      /// Only touches this space.
+      void finalize_dof_assignment();
+
       virtual void reset_dof_assignment(); ///< Resets assignment of DOF to an unassigned state.
       virtual void assign_vertex_dofs() = 0;
       virtual void assign_edge_dofs() = 0;
       virtual void assign_bubble_dofs() = 0;
 
+      /// Renumbers the assigned DOFs by the reverse Cuthill-McKee algorithm. The groups
+      /// of DOFs belonging to one node or element interior stay consecutive, only the
+      /// order of the groups changes. Called from assign_dofs() when the renumbering
+      /// was enabled by set_bandwidth_reduction().
+      void reorder_dofs_cuthill_mckee();
+
+      /// True if assign_dofs() runs the reverse Cuthill-McKee renumbering pass.
+      bool bandwidth_reduction;
+
       virtual void get_vertex_assembly_list(Element* e, int iv, AsmList<Scalar>* al) const = 0;
       virtual void get_boundary_assembly_list_internal(Element* e, int surf_num, AsmList<Scalar>* al) const = 0;
       virtual void get_bubble_assembly_list(Element* e, AsmList<Scalar>* al) const;
 
+      /// True if get_element_assembly_list() caches the lists. See set_assembly_list_caching().
+      bool asm_list_caching;
+      /// Cache of the element assembly lists. The (idx, dof, coef) triplets of all active
+      /// elements are stored in one contiguous block, element id owning the range
+      /// [asm_list_cache_start[id], asm_list_cache_start[id + 1]).
+      int* asm_list_cache_idx;
+      int* asm_list_cache_dof;
+      Scalar* asm_list_cache_coef;
+      int* asm_list_cache_start;
+      /// Number of element ids the start array covers.
+      int asm_list_cache_size;
+      /// Sequence number of the space the cache was built for.
+      int asm_list_cache_seq;
+
+      /// Builds the assembly list cache by a single pass over the active elements.
+      void build_asm_list_cache();
+      /// Releases the assembly list cache.
+      void free_asm_list_cache();
+
       double** proj_mat;
       double*  chol_p;
 
       /// Used for bc projection.
       Hermes::vector<void*> bc_data;
 
+      /// Cached edge projections of boundary conditions marked as constant in time
+      /// (see EssentialBoundaryCondition::set_time_invariant()), keyed by the edge
+      /// node id. The entries stay valid as long as the space sequence number does
+      /// not change; update_essential_bc_values() flushes them otherwise.
+      std::map<int, Scalar*> bc_proj_cache;
+      /// Sequence number of the space the cached projections were computed for.
+      int bc_proj_cache_seq;
+      /// True after a completed update_essential_bc_values() run; together with an
+      /// unchanged sequence number this lets the update be skipped entirely when
+      /// all the conditions are time-invariant.
+      bool bc_proj_cache_valid;
+
+      /// Space whose cached edge projections may be reused by this one.
+      /// \sa set_bc_projection_source().
+      Space<Scalar>* bc_proj_source;
+
       void precalculate_projection_matrix(int nv, double**& mat, double*& p);
       void update_edge_bc(Element* e, SurfPos* surf_pos);
 
@@ -392,8 +515,6 @@ namespace Hermes
 
       void free_bc_data();
 
-      /// Internal. Used by DiscreteProblem to detect changes in the space.
-      int get_seq() const;
       template<typename T> friend class OGProjection;
       template<typename T> friend class NewtonSolver;
       template<typename T> friend class PicardSolver;
@@ -412,6 +533,8 @@ namespace Hermes
       template<typename T> friend class Views::VectorBaseView;
       friend class Adapt<Scalar>;
       friend class DiscreteProblem<Scalar>;
+      template<typename T> friend class MultigridSolver;
+      template<typename T> friend class PMultigridSolver;
       template<typename T> friend class CalculationContinuity;
     };
   }
@@ -88,6 +88,24 @@ namespace Hermes
 			typename Space<Scalar>::BaseComponent* merge_baselists(typename Space<Scalar>::BaseComponent* l1, int n1, typename Space<Scalar>::BaseComponent* l2, int n2,
 				Node* edge, typename Space<Scalar>::BaseComponent*& edge_dofs, int& ncomponents);
 
+			/// Pooled storage of the constrained-node coefficient lists built by
+			/// merge_baselists(). The lists live in a few large chunks instead of one
+			/// heap block per node; update_constraints() resets the pool and reuses
+			/// the chunks, so repeated dof assignments on a deeply refined mesh stop
+			/// allocating once the pool has grown to the needed size.
+			typename Space<Scalar>::BaseComponent* baselist_pool_allocate(int count);
+			/// Gives the unused tail of the last baselist_pool_allocate() block back.
+			void baselist_pool_return(int count);
+			/// Makes the whole pool available again, keeping the chunks.
+			void baselist_pool_reset();
+			/// Releases the chunks.
+			void baselist_pool_free();
+
+			Hermes::vector<typename Space<Scalar>::BaseComponent*> baselist_pool_chunks;
+			Hermes::vector<int> baselist_pool_chunk_sizes;
+			int baselist_pool_current; ///< The chunk being filled.
+			int baselist_pool_used; ///< Components used in the current chunk.
+
 			void update_constrained_nodes(Element* e, EdgeInfo* ei0, EdgeInfo* ei1, EdgeInfo* ei2, EdgeInfo* ei3);
 
 			virtual void update_constraints();
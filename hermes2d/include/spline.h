@@ -51,6 +51,14 @@ namespace Hermes
       /// One-dimensional function derivative integration order.
       Hermes::Ord derivative(Hermes::Ord x) const {return Hermes::Ord(2);};
 
+      /// Evaluates the spline at n points at once, which is the preferred way
+      /// of evaluating material curves at all quadrature points of an element.
+      /// When the input points are ascending (quadrature points are), the knot
+      /// interval is tracked from one point to the next instead of being
+      /// searched for, and on equidistant grid points the search degenerates
+      /// to index arithmetic altogether - see calculate_coeffs().
+      void get_values(const double* x_in, int n, double* values_out) const;
+
       /// Plots the spline in format for Pylab (just pairs
       /// x-coordinate and value per line). The interval of definition
       /// of the spline will be extended by "extension" both to the left
@@ -62,8 +70,15 @@ namespace Hermes
     protected:
       /// Uses a bisection method to locale interval where a given point lies.
       /// Returns false if point lies outside.
+      /// On equidistant grid points (see uniform_knots) the interval index is
+      /// computed directly instead.
       bool find_interval(double x_in, int& m) const;
 
+      /// True if the grid points are equidistant, detected in calculate_coeffs().
+      bool uniform_knots;
+      /// Reciprocal of the grid step, valid if uniform_knots is set.
+      double uniform_step_inverse;
+
       /// Extrapolate the value of the spline outside of its interval of definition.
       double extrapolate_value(double point_end, double value_end, double derivative_end, double x_in) const;
       /// Grid points, ordered.
@@ -0,0 +1,103 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+#ifndef __H2D_STATIC_CONDENSATION_H
+#define __H2D_STATIC_CONDENSATION_H
+
+#include "global.h"
+#include "space/space.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// @ingroup userSolvingAPI
+    /// Element-local elimination (static condensation) of interior DOFs.
+    ///
+    /// For higher polynomial degrees most DOFs of an element are bubble
+    /// functions whose support is a single element, so they couple only with
+    /// DOFs of that element. This class eliminates them from an assembled
+    /// system: condense() forms the element-wise Schur complements on the
+    /// remaining (interface) DOFs and builds a reduced matrix and right-hand
+    /// side for the linear solver, recover() then computes the eliminated
+    /// values from the interface solution by back-substitution.
+    ///
+    /// The candidate DOFs are found from the assembly lists (a DOF belonging
+    /// to a single element's list) and each candidate is verified against the
+    /// sparsity pattern of the assembled matrix, so DOFs that in fact couple
+    /// across elements - e.g. through DG surface forms - are kept in the
+    /// reduced system automatically.
+    template<typename Scalar>
+    class HERMES_API StaticCondensation
+    {
+    public:
+      StaticCondensation(Hermes::vector<const Space<Scalar>*> spaces);
+      StaticCondensation(const Space<Scalar>* space);
+      ~StaticCondensation();
+
+      /// Condenses the assembled system.
+      /// Classifies the DOFs, builds the per-element Schur complements and
+      /// assembles the reduced matrix / rhs available through the getters.
+      /// The matrix must come from a CSC-based solver (e.g. UMFPACK).
+      void condense(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs);
+
+      /// Returns the reduced matrix built by condense().
+      SparseMatrix<Scalar>* get_reduced_matrix();
+
+      /// Returns the reduced right-hand side built by condense().
+      Vector<Scalar>* get_reduced_rhs();
+
+      /// Returns the number of DOFs of the reduced system.
+      int get_reduced_ndof() const;
+
+      /// Expands the solution of the reduced system to the full DOF vector,
+      /// computing the condensed entries by element-local back-substitution.
+      /// \param[in] reduced_sln_vector Solution of the reduced system (length get_reduced_ndof()).
+      /// \param[out] full_sln_vector Full solution vector (length Space::get_num_dofs() of the spaces).
+      void recover(Scalar* reduced_sln_vector, Scalar* full_sln_vector);
+
+    protected:
+      /// Data kept for one element with condensed DOFs: the eliminated and
+      /// interface DOF numbers, W = K_bb^{-1} K_bi and g_b = K_bb^{-1} f_b.
+      /// The recovery is then x_b = g_b - W x_i.
+      struct ElementRecord
+      {
+        ElementRecord();
+        ~ElementRecord();
+
+        int n_condensed;      ///< Number of condensed DOFs of the element.
+        int n_interface;      ///< Number of kept DOFs of the element.
+        int* condensed_dofs;  ///< Global numbers of the condensed DOFs.
+        int* interface_dofs;  ///< Global numbers of the kept DOFs.
+        Scalar** W;           ///< K_bb^{-1} K_bi, n_condensed x n_interface.
+        Scalar* g;            ///< K_bb^{-1} f_b, n_condensed entries.
+      };
+
+      /// Frees the element records and the reduced system.
+      void free();
+
+      Hermes::vector<const Space<Scalar>*> spaces;
+
+      int ndof;              ///< Number of DOFs of the full system.
+      int reduced_ndof;      ///< Number of DOFs of the reduced system.
+      int* reduced_dof;      ///< Full DOF number -> reduced DOF number, -1 for condensed DOFs.
+
+      Hermes::vector<ElementRecord*> records;
+
+      SparseMatrix<Scalar>* reduced_matrix;
+      Vector<Scalar>* reduced_rhs;
+    };
+  }
+}
+#endif
@@ -47,10 +47,39 @@ namespace Hermes
         /// \param[in] eps - tolerance parameter controlling how fine the resulting linearized approximation of the solution is.
         void process_solution(MeshFunction<double>* sln, int item = H2D_FN_VAL_0, double eps = HERMES_EPS_NORMAL);
 
+        /// Processes several solution components over one shared triangulation.
+        /// The adaptive refinement is driven by the first function, the others are
+        /// then just evaluated at the resulting vertex positions - the mesh is
+        /// walked once for the whole batch instead of once per component, and all
+        /// the components share the vertex and triangle arrays. The vertex values
+        /// of component j > 0 are available through get_channel_values(); those
+        /// of the first component are stored in the vertices as usual. Note that
+        /// the accuracy parameter is therefore only enforced for the first
+        /// component; pass the least smooth component first. Not available
+        /// together with set_displacement().
+        void process_solutions(Hermes::vector<MeshFunction<double>*> slns,
+          Hermes::vector<int> items = Hermes::vector<int>(), double eps = HERMES_EPS_NORMAL);
+
         /// Save a MeshFunction (Solution, Filter) in VTK format.
+        /// With binary == true, the data sections are written as binary (big-endian)
+        /// blocks instead of ASCII, which is both smaller and much faster to write.
         void save_solution_vtk(MeshFunction<double>* sln, const char* filename, const char* quantity_name,
           bool mode_3D = true, int item = H2D_FN_VAL_0,
-          double eps = HERMES_EPS_NORMAL);
+          double eps = HERMES_EPS_NORMAL, bool binary = false);
+
+        /// Save several MeshFunctions into a single VTK file. The topology
+        /// (points, cells) is written once and shared by all the fields, which
+        /// appear as separate SCALARS sections of the common POINT_DATA block.
+        /// See process_solutions() for how the shared triangulation is built.
+        void save_solution_vtk(Hermes::vector<MeshFunction<double>*> slns, const char* filename,
+          Hermes::vector<std::string> quantity_names, bool mode_3D = true,
+          Hermes::vector<int> items = Hermes::vector<int>(),
+          double eps = HERMES_EPS_NORMAL, bool binary = false);
+
+        /// Vertex values of the passed component from the last call to
+        /// process_solutions(). Returns NULL for channel 0 - the values of the
+        /// first component are stored in the vertices, see get_vertices().
+        double* get_channel_values(int channel);
 
         /// Set the displacement, i.e. set two functions that will deform the domain for visualization, in the x-direction, and the y-direction.
         void set_displacement(MeshFunction<double>* xdisp, MeshFunction<double>* ydisp, double dmult = 1.0);
@@ -62,8 +91,24 @@ namespace Hermes
         int get_num_vertices();
 
         /// Get the vertices of this instance.
+        /// Returns NULL when the single-precision storage mode is active,
+        /// see set_float_storage() and get_vertices_f32().
         double3* get_vertices();
 
+        /// Single-precision storage of the triangulation vertices. Off by default.
+        /// When on, the finished (x, y, value) triplets are compressed into float
+        /// triplets after each process_solution() call and the double array is
+        /// released, halving the memory the stored triangulation occupies - more
+        /// than visualization or VTK export resolves anyway. Consumers then read
+        /// the vertices through get_vertices_f32() instead of get_vertices().
+        /// The adaptive refinement itself still runs in double precision, and the
+        /// mode is suspended while double buffering (set_double_buffering()) is
+        /// active - the published front buffers keep doubles.
+        void set_float_storage(bool to_set = true);
+
+        /// Get the compressed vertices, \sa set_float_storage().
+        float3* get_vertices_f32();
+
         /// Get the contours (the isolines) of this instance.
         int3* get_contour_triangles();
 
@@ -79,6 +124,27 @@ namespace Hermes
         /// Get the 'curvature' epsilon determining the tolerance of catching the shape of curved elements.
         double get_curvature_epsilon();
 
+        /// Incremental mode for transient calculations on a fixed mesh. When enabled and
+        /// the mesh (Mesh::get_seq()), the item and the accuracy are the same as in the
+        /// previous call, process_solution() keeps the stored triangulation and only
+        /// re-evaluates the values at the stored vertex positions, instead of rebuilding
+        /// the adaptive triangulation from scratch. Any change of the key invalidates the
+        /// stored topology and triggers a full rebuild. Note that the refinement pattern
+        /// then reflects the solution the triangulation was built for, that doubled
+        /// vertices at discontinuities become single-valued, and that the mode is
+        /// suspended when a displacement is set.
+        void set_topology_reuse(bool to_set = true);
+
+        /// Change-aware mode for periodic exports and view refreshes (off by default).
+        /// When enabled, process_solution() returns immediately - keeping the stored
+        /// triangulation - if it is called for the very same Solution, item and accuracy
+        /// as the previous call and neither the solution (Solution::get_sln_seq()) nor
+        /// its mesh (Mesh::get_seq()) have changed since; save_solution_vtk() then also
+        /// drops a re-export into the same file altogether. Functions without a change
+        /// stamp (filters, exact solutions) are always reprocessed, as is anything
+        /// while a displacement is set.
+        void set_skip_unchanged(bool to_set = true);
+
         /// Free the instance.
         void free();
 
@@ -96,12 +162,58 @@ namespace Hermes
         int3* tris_contours;      ///< triangles: vertex index triplets
         int triangle_contours_count;
         double3* verts;  ///< vertices: (x, y, value) triplets
+        /// \sa set_float_storage().
+        bool float_storage;
+        /// The compressed vertex array; non-NULL only in the float storage mode
+        /// once a triangulation has been processed (verts is NULL then).
+        float3* verts_f32;
+        /// Compresses verts into verts_f32 and releases the double array,
+        /// \sa set_float_storage(). A no-op unless the mode is active.
+        void compress_vertices();
+        /// Coordinates and value of the i-th stored vertex regardless of which
+        /// of the two storages currently holds the triangulation.
+        inline double vertex_x(int i) const { return verts != NULL ? verts[i][0] : (double) verts_f32[i][0]; }
+        inline double vertex_y(int i) const { return verts != NULL ? verts[i][1] : (double) verts_f32[i][1]; }
+        inline double vertex_value(int i) const { return verts != NULL ? verts[i][2] : (double) verts_f32[i][2]; }
+
+        /// Publishes the vertex and contour arrays on top of the common ones.
+        /// See LinearizerBase::set_double_buffering().
+        virtual void publish_buffers();
+
+        double3* front_verts; ///< The published copy of verts.
+        int front_vertex_size;
+        int3* front_tris_contours;
+        int front_triangle_contours_count, front_triangle_contours_size;
 
         /// What kind of information do we want to get out of the solution.
         int item, component, value_type;
 
+        /// Vertex values of the components beyond the first one from the last
+        /// process_solutions() call; entry 0 is a NULL placeholder so that the
+        /// indices match the component numbers.
+        Hermes::vector<double*> value_channels;
+
+        /// Topology reuse (set_topology_reuse()) bookkeeping.
+        bool reuse_topology;
+        bool topology_valid; ///< The stored triangulation may be reused.
+        unsigned int last_sln_seq; ///< Mesh::seq the triangulation was built for.
+        double last_eps;
+        int last_item;
+
+        /// Change skipping (set_skip_unchanged()) bookkeeping.
+        bool skip_unchanged;
+        MeshFunction<double>* last_processed_sln; ///< The function of the last process_solution() call.
+        int last_sln_stamp; ///< Its Solution::get_sln_seq() stamp, -1 for functions without one.
+        std::string last_saved_filename; ///< Target of the last single-field save_solution_vtk().
+        /// True if the data stored from the last process_solution() call is guaranteed
+        /// to match the current contents of the given function, \sa set_skip_unchanged().
+        bool solution_unchanged(MeshFunction<double>* sln, int item_, double eps);
+
         int add_vertex();
         int get_vertex(int p1, int p2, double x, double y, double value);
+        /// Lookup / creation of a vertex through the concurrent interning table,
+        /// see LinearizerBase::set_vertex_interning().
+        int get_vertex_interned(int p1, int p2, double x, double y, double value);
 
         void process_triangle(MeshFunction<double>** fns, int iv0, int iv1, int iv2, int level,
           double* val, double* phx, double* phy, int* indices, bool curved);
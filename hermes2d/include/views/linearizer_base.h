@@ -83,6 +83,22 @@ namespace Hermes
         void lock_data() const;
         void unlock_data() const;
 
+        /// Switches the reading side to a published copy of the data (off by default).
+        /// process_solution() then builds the triangulation without holding the data
+        /// lock and publishes the finished arrays by a short copy at the end, so a
+        /// view rendering on another thread never blocks the calculation and vice
+        /// versa - at the price of keeping the data twice in memory. The getters
+        /// return the published copy while the switch is on.
+        void set_double_buffering(bool to_set = true);
+        bool get_double_buffering() const;
+
+        /// Switches the vertex deduplication to a concurrent interning table (off by
+        /// default). Vertices are then looked up and created through an open addressed
+        /// table whose slots are inserted atomically, instead of the hash with linked
+        /// synonym lists guarded by a critical section, so the parallel part of
+        /// process_solution() does not serialize on vertex creation.
+        void set_vertex_interning(bool to_set = true);
+
         int3* get_triangles();
         int* get_triangle_markers();
         int get_num_triangles();
@@ -118,6 +134,25 @@ namespace Hermes
         int* hash_table; ///< hash table
         int4 * info; ///< info[0] = p1, info[1] = p2, info[2] = next vertex in hash
 
+        /// Concurrent vertex interning, see set_vertex_interning(). Every slot of the
+        /// open addressed table packs a check hash of the parent pair (upper half) and
+        /// the vertex index (lower half) into one word, published by compare-and-swap;
+        /// collisions are resolved by linear probing. All ones marks an empty slot.
+        bool vertex_interning;
+        int64_t* intern_table;
+        int intern_capacity; ///< Capacity of intern_table, a power of two.
+
+        /// Probing start position for the parent pair (p1, p2), p1 <= p2.
+        unsigned int intern_hash(int p1, int p2);
+        /// Check hash stored in the upper half of a slot, filtering out foreign
+        /// slots without touching the vertex data.
+        unsigned int intern_check(int p1, int p2);
+        /// (Re)allocates the interning table from the current vertex capacity
+        /// estimate, which bounds the number of insertions and keeps the load
+        /// factor low. Called by process_solution().
+        void init_intern_table();
+        void free_intern_table();
+
         int vertex_count, triangle_count, edges_count; ///< Real numbers of vertices, triangles and edges
         int vertex_size, triangle_size, edges_size; ///< Size of arrays of vertices, triangles and edges
 
@@ -132,12 +167,57 @@ namespace Hermes
         void add_edge(int iv1, int iv2, int marker);
         void add_triangle(int iv0, int iv1, int iv2, int marker);
 
+        /// Per-thread output buffers. While they are active, add_triangle() and add_edge()
+        /// append to the buffer of the calling thread instead of the shared arrays, so the
+        /// parallel part of process_solution() does not serialize on the shared storage.
+        /// merge_thread_buffers() then moves the buffered data into tris / edges.
+        void init_thread_buffers(int count);
+        void merge_thread_buffers();
+        void free_thread_buffers();
+
+        /// Publishes the working arrays for the readers: takes the data lock and
+        /// copies them into the front arrays the getters return while double
+        /// buffering is on. The overrides add the vertex storage of the
+        /// respective class.
+        virtual void publish_buffers();
+        /// The part of the publishing common to all the classes. The data lock
+        /// has to be held by the caller.
+        void publish_base_buffers();
+
+        bool double_buffering;
+
+        /// The published (front) copies of the arrays, read by the views instead
+        /// of the working arrays while double buffering is on.
+        int3* front_tris;
+        int* front_tri_markers;
+        int2* front_edges;
+        int* front_edge_markers;
+        int front_vertex_count, front_triangle_count, front_edges_count;
+        int front_triangle_size, front_edges_size;
+        double front_min_val, front_max_val;
+
+        int thread_buffer_count; ///< Number of active per-thread buffers, zero outside process_solution().
+        int3** thread_tris;
+        int** thread_tri_markers;
+        int* thread_triangle_count;
+        int* thread_triangle_size;
+        int2** thread_edges;
+        int** thread_edge_markers;
+        int* thread_edges_count;
+        int* thread_edges_size;
+
         int hash(int p1, int p2);
 
         mutable pthread_mutex_t data_mutex;
 
         Hermes::Exceptions::Exception* caughtException;
 
+        /// Writes a block of binary VTK data. The legacy VTK format stores binary
+        /// sections big-endian, so the values are byte-swapped in place on
+        /// little-endian machines - the contents of the data array are destroyed.
+        static void vtk_write_binary_floats(FILE* f, float* data, int count);
+        static void vtk_write_binary_ints(FILE* f, int* data, int count);
+
         /// Calculates AABB from an array of X-axis and Y-axis coordinates. The distance between values in the array is stride bytes.
         static void calc_aabb(double* x, double* y, int stride, int num, double* min_x, double* max_x, double* min_y, double* max_y);
         friend class MeshView;
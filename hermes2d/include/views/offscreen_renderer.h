@@ -0,0 +1,86 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_OFFSCREEN_RENDERER_H
+#define __H2D_OFFSCREEN_RENDERER_H
+
+#include "../global.h"
+#include "view.h"
+#include "linearizer.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    namespace Views
+    {
+      /// \brief Headless bitmap export of linearized solutions.
+      ///
+      /// OffscreenRenderer produces the same kind of color-map images as
+      /// ScalarView, but by software rasterization of the triangulation stored
+      /// in a Linearizer - no GL context, no window and no view thread are
+      /// involved, so it works on cluster nodes without a display and also in
+      /// NOGLUT builds, where the View classes themselves are disabled.
+      ///
+      /// The renderer only reads the linearizer under its data lock. Combined
+      /// with LinearizerBase::set_double_buffering(), image export can
+      /// therefore run on a thread of the caller's choice while the
+      /// simulation thread fills the next triangulation.
+      ///
+      /// Typical usage:
+      /// Hermes::Hermes2D::Views::Linearizer lin;
+      /// lin.process_solution(&sln);
+      /// Hermes::Hermes2D::Views::OffscreenRenderer renderer(800, 600);
+      /// renderer.save_bitmap(&lin, "solution.bmp");
+      class HERMES_API OffscreenRenderer
+      {
+      public:
+        OffscreenRenderer(int width = H2D_DEFAULT_WIDTH, int height = H2D_DEFAULT_HEIGHT);
+
+        void set_palette(ViewPaletteType type);
+        void set_num_palette_steps(int num);
+
+        /// Fixes the value range of the color map; values outside are clamped.
+        void set_min_max_range(double min, double max);
+        /// Maps the full value range of each rendered triangulation (default).
+        void auto_min_max_range();
+
+        /// Rasterizes the triangulation currently stored in the linearizer and
+        /// saves it as a .BMP file of the configured size. Throws if the
+        /// linearizer is empty or the file cannot be written.
+        void save_bitmap(Linearizer* lin, const char* filename);
+        /// Like save_bitmap(), but forms the file name in printf-style using the
+        /// 'number' parameter, e.g., format = "sln%03d.bmp" and number = 5 gives
+        /// the file name "sln005.bmp".
+        void save_numbered_bitmap(Linearizer* lin, const char* format, int number);
+
+      protected:
+        int width, height;
+        int margin;
+
+        ViewPaletteType pal_type;
+        int pal_steps;
+
+        bool range_auto;
+        double range_min, range_max;
+
+        /// The palette lookup of View::get_palette_color(), duplicated here
+        /// because the View side of it only exists in GL-enabled builds.
+        void get_palette_color(double x, float* color);
+      };
+    }
+  }
+}
+#endif
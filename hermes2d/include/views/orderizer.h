@@ -37,12 +37,30 @@ namespace Hermes
         template<typename Scalar>
         void process_space(const Space<Scalar>* space);
 
+        /// Lightweight order snapshot: fills the (element id, encoded order) pairs
+        /// of all active elements, without building the polygonal order
+        /// visualization - the cost is one pass over the element array. The orders
+        /// are encoded as returned by Space::get_element_order(), i.e. use
+        /// H2D_GET_H_ORDER / H2D_GET_V_ORDER to get the directional orders of
+        /// quads. Meant for recording the order distribution in every adaptivity
+        /// iteration, where running the full triangulation would be wasteful.
+        template<typename Scalar>
+        static void get_element_orders(const Space<Scalar>* space, Hermes::vector<int>& element_ids, Hermes::vector<int>& element_orders);
+
+        /// Text export of the order snapshot of get_element_orders(): one
+        /// "element_id horizontal_order vertical_order" line per active element
+        /// (the vertical order of triangles is written as 0).
+        template<typename Scalar>
+        static void save_orders_txt(const Space<Scalar>* space, const char* file_name);
+
         /// Saves a MeshFunction (Solution, Filter) in VTK format.
+        /// With binary == true, the data sections are written as binary (big-endian)
+        /// blocks instead of ASCII, which is both smaller and much faster to write.
         template<typename Scalar>
-        void save_orders_vtk(const Space<Scalar>* space, const char* file_name);
+        void save_orders_vtk(const Space<Scalar>* space, const char* file_name, bool binary = false);
 
         template<typename Scalar>
-        void save_mesh_vtk(const Space<Scalar>* space, const char* file_name);
+        void save_mesh_vtk(const Space<Scalar>* space, const char* file_name, bool binary = false);
 
         int get_labels(int*& lvert, char**& ltext, double2*& lbox) const;
 
@@ -141,6 +141,18 @@ namespace Hermes
         int max_gl_tris; ///< A maximum allocated number of triangles
         int gl_tri_cnt; ///< A number of OpenGL triangles
 
+        /// CPU-side shadow copies of the last uploaded buffer contents. While the
+        /// counts stay the same, prepare_gl_geometry() diffs the fresh data against
+        /// them and re-uploads only the modified byte ranges instead of rewriting
+        /// the whole buffer. When the solution changes in a part of the domain only
+        /// (a local adaptivity step, a time step with localized dynamics), the
+        /// per-frame transfer shrinks to the changed vertices - the difference
+        /// between usable and unusable for large linearizations over remote GL.
+        GLVertex2* gl_verts_shadow; ///< Last uploaded vertex data. NULL until the first upload.
+        int gl_verts_shadow_cnt; ///< A number of vertices in gl_verts_shadow.
+        unsigned int* gl_tris_shadow; ///< Last uploaded triangle indices.
+        int gl_tris_shadow_cnt; ///< A number of indices in gl_tris_shadow.
+
         bool show_values; ///< true to show values
 
         void prepare_gl_geometry(); ///< prepares geometry in a form compatible with GL arrays; Data are updated if lin is updated. In a case of a failure (out of memory), gl_verts is NULL and an old OpenGL rendering method has to be used.
@@ -181,7 +193,9 @@ namespace Hermes
         ///< Information about the range of vertex values.
         double value_irange, value_range_avg;
 
-        double3* normals;
+        /// Per-vertex normals of the 3D surface. Unit vectors need no double
+        /// precision, so they are packed as floats - GL takes either.
+        float3* normals;
 
         /// This function calculates the distance that the model (3D plot of the solution over the whole solution domain) must be
         /// translated along the z-axis of the eye coordinate system, so that it fills the actual viewport without being clipped.
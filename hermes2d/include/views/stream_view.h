@@ -97,6 +97,23 @@ namespace Hermes
         /// using barycentric coordinates (returned as side efect).
         bool is_in_triangle(int idx, double x, double y, double3& bar);
 
+        /// Neighbor triangle across each edge of each linearized triangle,
+        /// 3 entries per triangle, -1 on the boundary. Built together with the tree.
+        int* tri_neighbors;
+
+        /// The triangle the last located point fell into, the starting point of the walk.
+        int last_tri;
+
+        /// Builds the triangle adjacency used by find_triangle_walk().
+        void build_neighbors();
+
+        /// Element-walking point location: starts in the triangle of the previous
+        /// point and crosses edges towards (x, y) via the neighbor links, so the
+        /// small steps of the streamline integrator locate in O(1) instead of a
+        /// tree descent per evaluation. Falls back to the kD-tree when there is
+        /// no previous triangle or the walk leaves the domain.
+        int find_triangle_walk(double x, double y, double3& bar);
+
         /// Gets values of velocities at given point using built kD-tree.
         bool get_solution_values(double x, double y, double& xval, double& yval);
 
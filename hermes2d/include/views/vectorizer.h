@@ -70,6 +70,14 @@ namespace Hermes
         /// Gets the 'curvature' epsilon determining the tolerance of catching the shape of curved elements.
         double get_curvature_epsilon();
 
+        /// When enabled, process_solution() reuses the triangulation built by the previous
+        /// call (triangles, edges and vertex positions) as long as the meshes, the items and
+        /// the accuracy stay the same, and only re-evaluates the vertex values. Meant for
+        /// time-dependent calculations on a fixed mesh, where it skips the adaptive
+        /// refinement walk entirely. Vertices doubled along a discontinuity receive a single
+        /// value when re-evaluated, and the reuse is suspended when a displacement is set.
+        void set_topology_reuse(bool to_set = true);
+
         /// Frees the instance.
         void free();
 
@@ -87,12 +95,28 @@ namespace Hermes
         int xitem, component_x, value_type_x;
         int yitem, component_y, value_type_y;
 
+        /// Topology reuse (set_topology_reuse()) bookkeeping.
+        bool reuse_topology;
+        bool topology_valid; ///< The stored triangulation may be reused.
+        unsigned int last_xsln_seq, last_ysln_seq; ///< Mesh::seq values the triangulation was built for.
+        double last_eps;
+        int last_xitem, last_yitem;
+
         double4* verts;  ///< vertices: (x, y, xvalue, yvalue) quadruples
         int2* dashes;
 
         int dashes_count; ///< Real numbers of vertices, triangles and edges, dashes
         int dashes_size; ///< Size of arrays of vertices, triangles and edges, dashes
 
+        /// Publishes the vertex and dash arrays on top of the common ones.
+        /// See LinearizerBase::set_double_buffering().
+        virtual void publish_buffers();
+
+        double4* front_verts; ///< The published copy of verts.
+        int front_vertex_size;
+        int2* front_dashes;
+        int front_dashes_count, front_dashes_size;
+
         int get_vertex(int p1, int p2, double x, double y, double xvalue, double yvalue);
         void process_dash(int iv1, int iv2);
 
@@ -249,6 +249,42 @@ namespace Hermes
       /// scaling factor
       void setScalingFactor(double scalingFactor);
 
+      /// Assembling metadata: mark this form as linear, i.e. its value does not
+      /// depend on the previous-iteration solutions u_ext (default: false).
+      /// Forms marked this way keep their contributions unchanged between the
+      /// Newton iterations, which DiscreteProblem can exploit by caching them.
+      /// \sa DiscreteProblem::set_split_assembling().
+      void set_linear(bool to_set = true);
+      bool get_linear() const;
+
+      /// Assembling metadata: the form reads the current time or stage time
+      /// (default: true). A cached contribution of a time-dependent linear form
+      /// stays valid within one time step and is rebuilt when the time changes.
+      void set_time_dependent(bool to_set);
+      bool get_time_dependent() const;
+
+      /// Assembling metadata: the form reads its external functions
+      /// (default: true). Since the external functions can change without the
+      /// assembling noticing, forms depending on them are never cached. The flag
+      /// is irrelevant for forms that receive no external functions at all.
+      void set_ext_dependent(bool to_set);
+      bool get_ext_dependent() const;
+
+      /// Declare a material coefficient that is constant on every element of the
+      /// given area (marker). Before assembling, DiscreteProblem resolves the
+      /// declared values to a table indexed by the internal marker ids - together
+      /// with the areas - and preloads the value belonging to the element (or
+      /// boundary edge) being assembled, so that the kernel obtains it through
+      /// get_material_coefficient(): a plain member read in place of one virtual
+      /// Hermes1DFunction / Hermes2DFunction value() call per quadrature point.
+      /// Markers without a declared value read as zero.
+      void set_material_coefficient(std::string area, Scalar value);
+
+      /// The declared material coefficient of the element (or edge) currently
+      /// being assembled. Only meaningful inside value() / value_block() of a
+      /// form whose coefficients were declared via set_material_coefficient().
+      inline Scalar get_material_coefficient() const { return this->material_coefficient; }
+
     protected:
       /// Set pointer to a WeakForm.
       inline void set_weakform(WeakForm<Scalar>* wf) { this->wf = wf; }
@@ -256,6 +292,32 @@ namespace Hermes
       /// Markers of the areas where this form will be assembled.
       Hermes::vector<std::string> areas;
 
+      /// The marker filter above resolved to plain integers: before assembly,
+      /// DiscreteProblem translates the area strings to the internal marker ids on
+      /// the meshes of the spaces the form couples, so that the per-element filter
+      /// in the assembling loops compares ints instead of performing string-keyed
+      /// map lookups. Areas not present on a mesh resolve to -1, which never
+      /// matches. \sa DiscreteProblem::resolve_form_areas().
+      bool any_area;
+      Hermes::vector<int> areas_internal_m;
+      Hermes::vector<int> areas_internal_n;
+
+      /// The resolved filter condensed one step further: bit m is set when elements
+      /// (or edges) with the internal marker m are assembled by this form, so the
+      /// per-element test in the assembling loops is a single indexed bit instead
+      /// of a scan of the resolved marker list. Internal markers are small and
+      /// sequential, which keeps the bitmap tiny.
+      /// \sa DiscreteProblem::resolve_form_areas().
+      std::vector<bool> area_bitmap;
+
+      /// Marker-piecewise-constant material data: the values declared by the
+      /// marker string, the same values resolved to a table indexed by the
+      /// internal marker ids, and the preloaded value of the element being
+      /// assembled. \sa set_material_coefficient().
+      std::map<std::string, Scalar> material_coefficients;
+      std::vector<Scalar> material_table;
+      Scalar material_coefficient;
+
       /// External solutions for this form will start
       /// with u_ext[u_ext_offset] where u_ext[] are external
       /// solutions coming to the assembling procedure via the
@@ -274,8 +336,20 @@ namespace Hermes
       /// Form will be always multiplied (scaled) with this number.
       double scaling_factor;
 
+      /// Assembling metadata, see the setters above.
+      bool is_linear;
+      bool depends_on_time;
+      bool depends_on_ext;
+
       WeakForm<Scalar>* wf;
       double stage_time;
+
+      /// Memoized results of the Ord shadow evaluation of this form, keyed by the
+      /// integer order signature of the assembled element. Forms are cloned for each
+      /// assembling thread, so the map needs no locking.
+      /// \sa DiscreteProblem::set_order_cache().
+      std::map<std::vector<int>, int> order_cache;
+
       void set_uExtOffset(int u_ext_offset);
       friend class WeakForm<Scalar>;
       friend class RungeKutta<Scalar>;
@@ -322,9 +396,34 @@ namespace Hermes
       void setSymFlag(SymFlag sym);
       SymFlag getSymFlag() const;
 
+      /// Mark this form as having a constant coefficient, i.e. the local stiffness
+      /// matrix depends only on the element shape, the polynomial orders and the
+      /// Jacobian factors - not on the physical coordinates or on the previous
+      /// iteration. DiscreteProblem then caches and reuses local matrices of
+      /// elements with identical signatures.
+      void set_const_coefficient(bool to_set);
+      bool get_const_coefficient() const;
+
+      /// Batch evaluation of the whole local stiffness matrix, storing the raw form values
+      /// in result[test_i][base_j]. The assembly list coefficients, the scaling factor and
+      /// the block scaling are applied by the assembling procedure afterwards. Overriding
+      /// this method (conveniently through InlinedMatrixFormVol) replaces one virtual
+      /// value() call per basis / test function pair with a single call per element, so
+      /// that simple kernels can be inlined into the pair loops and vectorized.
+      /// The default implementation returns false, telling the assembling procedure to
+      /// take the generic per-pair path.
+      virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **base_fns, int base_cnt,
+        Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar** result) const;
+
       virtual ~MatrixFormVol();
 
       virtual MatrixFormVol* clone() const;
+
+    protected:
+      /// \sa set_const_coefficient()
+      bool const_coefficient;
+
+      friend class WeakForm<Scalar>;
     };
 
     /// \brief Abstract, base class for matrix Surface form - i.e. MatrixForm, where the integration is with respect to 1D-Lebesgue measure (element domain-boundary edges).
@@ -335,9 +434,31 @@ namespace Hermes
       /// Constructor with coordinates.
       MatrixFormSurf(unsigned int i, unsigned int j);
 
+      /// Mark this form as having a constant coefficient - the local matrix of an edge
+      /// then depends only on the element mode, the quadrature order of the edge, its
+      /// marker and the Jacobian factors. DiscreteProblem groups such edges and reuses
+      /// the local matrix within a group instead of re-running the quadrature loop.
+      /// Useful for Robin-type conditions with constant material data; conditions whose
+      /// data differ between markers have to be registered as separate forms anyway.
+      void set_const_coefficient(bool to_set);
+      bool get_const_coefficient() const;
+
+      /// Batch evaluation of the whole local matrix of one edge, the surface counterpart
+      /// of MatrixFormVol::value_block(). The 0.5 edge factor, the assembly list
+      /// coefficients and the scaling are applied by the assembling procedure afterwards.
+      /// The default implementation returns false, selecting the generic per-pair path.
+      virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **base_fns, int base_cnt,
+        Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar** result) const;
+
       virtual ~MatrixFormSurf();
 
       virtual MatrixFormSurf* clone() const;
+
+    protected:
+      /// \sa set_const_coefficient()
+      bool const_coefficient;
+
+      friend class WeakForm<Scalar>;
     };
 
     /// \brief Abstract, base class for matrix DG form - i.e. bilinear form, where the integration is with respect to 1D-Lebesgue measure (element inner-domain edges).
@@ -407,6 +528,14 @@ namespace Hermes
       /// Constructor with coordinates.
       VectorFormSurf(unsigned int i);
 
+      /// Batch evaluation of the local right-hand side contributions of one edge,
+      /// storing the raw form values in result[test_i]. The 0.5 edge factor, the
+      /// assembly list coefficients and the scaling factor are applied by the
+      /// assembling procedure afterwards. The default implementation returns false,
+      /// selecting the generic per-test-function path.
+      virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[],
+        Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar* result) const;
+
       virtual ~VectorFormSurf();
 
       virtual VectorFormSurf* clone() const;
@@ -0,0 +1,400 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_FORM_DSL_H
+#define __H2D_FORM_DSL_H
+
+#include "../weakform/weakform.h"
+#include "../forms.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /* A small compile-time language for volumetric forms.
+
+    Instead of subclassing MatrixFormVol / VectorFormVol and hand-coding the
+    quadrature loop of value(), an integrand is written as an expression,
+
+      using namespace FormsDSL;
+      wf.add_matrix_form(integral(grad(u) * grad(v) * coeff(lambda)));
+      wf.add_vector_form(integral_v(coeff(f) * v));
+
+    The expression is a tree of small types composed by the operators below,
+    so the whole integrand is known at compile time: the evaluation fuses into
+    a single quadrature loop with no virtual calls inside, which the compiler
+    can inline and vectorize. The generated matrix forms also provide the
+    batch value_block() evaluation (one call per element instead of one
+    virtual value() call per basis / test function pair) and, whenever the
+    expression does not reference the physical coordinates, mark themselves
+    with set_const_coefficient() so that local matrices are reused between
+    elements of identical signatures.
+
+    Available building blocks: the placeholders u (basis) and v (test),
+    their first derivatives dx(.) / dy(.), gradients grad(.) combined by the
+    dot product grad(u) * grad(v), the physical coordinates coord_x / coord_y,
+    and constants coeff(value). Scalar sub-expressions compose with +, - and *.
+    The basis placeholders u, dx(u), dy(u), grad(u) are only valid in matrix
+    forms; previous iterations and external functions are not accessible -
+    forms needing them are written by subclassing, as before.
+
+    The order of the integrand is obtained by evaluating the same expression
+    tree in Hermes::Ord arithmetic, exactly as with handwritten ord() methods.
+    The forms are allocated by the integral() / integral_v() factories and
+    their ownership passes to the WeakForm they are registered with.
+    */
+    namespace FormsDSL
+    {
+      /// Base of all scalar expression nodes, constrains the operators below
+      /// to DSL types.
+      template<typename Derived>
+      struct Expr
+      {
+        const Derived& derived() const
+        {
+          return static_cast<const Derived&>(*this);
+        }
+      };
+
+      /// Placeholder for the basis function. Only valid in matrix forms.
+      struct TrialFn : public Expr<TrialFn>
+      {
+        enum { is_elementwise_const = 1 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return u->val[pt];
+        }
+      };
+
+      /// Placeholder for the test function.
+      struct TestFn : public Expr<TestFn>
+      {
+        enum { is_elementwise_const = 1 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return v->val[pt];
+        }
+      };
+
+      const TrialFn u = TrialFn();
+      const TestFn v = TestFn();
+
+      /// Selects the Func a placeholder stands for.
+      template<typename Real>
+      inline Func<Real>* arg_of(const TrialFn&, Func<Real>* u, Func<Real>* v)
+      {
+        return u;
+      }
+      template<typename Real>
+      inline Func<Real>* arg_of(const TestFn&, Func<Real>* u, Func<Real>* v)
+      {
+        return v;
+      }
+
+      /// First derivative with respect to x of a placeholder, see dx().
+      template<typename Fn>
+      struct DxFn : public Expr<DxFn<Fn> >
+      {
+        enum { is_elementwise_const = 1 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return arg_of(Fn(), u, v)->dx[pt];
+        }
+      };
+
+      /// First derivative with respect to y of a placeholder, see dy().
+      template<typename Fn>
+      struct DyFn : public Expr<DyFn<Fn> >
+      {
+        enum { is_elementwise_const = 1 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return arg_of(Fn(), u, v)->dy[pt];
+        }
+      };
+
+      inline DxFn<TrialFn> dx(const TrialFn&) { return DxFn<TrialFn>(); }
+      inline DxFn<TestFn> dx(const TestFn&) { return DxFn<TestFn>(); }
+      inline DyFn<TrialFn> dy(const TrialFn&) { return DyFn<TrialFn>(); }
+      inline DyFn<TestFn> dy(const TestFn&) { return DyFn<TestFn>(); }
+
+      /// Gradient of a placeholder - vector-valued, only usable through the
+      /// dot product with another gradient, see grad().
+      template<typename Fn>
+      struct GradFn
+      {
+      };
+
+      inline GradFn<TrialFn> grad(const TrialFn&) { return GradFn<TrialFn>(); }
+      inline GradFn<TestFn> grad(const TestFn&) { return GradFn<TestFn>(); }
+
+      /// Dot product of two gradients, produced by grad(.) * grad(.).
+      template<typename FnA, typename FnB>
+      struct GradDot : public Expr<GradDot<FnA, FnB> >
+      {
+        enum { is_elementwise_const = 1 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          Func<Real>* a = arg_of(FnA(), u, v);
+          Func<Real>* b = arg_of(FnB(), u, v);
+          return a->dx[pt] * b->dx[pt] + a->dy[pt] * b->dy[pt];
+        }
+      };
+
+      template<typename FnA, typename FnB>
+      inline GradDot<FnA, FnB> operator*(const GradFn<FnA>&, const GradFn<FnB>&)
+      {
+        return GradDot<FnA, FnB>();
+      }
+
+      /// A constant coefficient, see coeff(). Contributes order zero.
+      struct CoeffExpr : public Expr<CoeffExpr>
+      {
+        enum { is_elementwise_const = 1 };
+        explicit CoeffExpr(double value) : value(value) {}
+        double at(int pt, Func<double>* u, Func<double>* v, Geom<double>* e) const
+        {
+          return value;
+        }
+        Hermes::Ord at(int pt, Func<Hermes::Ord>* u, Func<Hermes::Ord>* v, Geom<Hermes::Ord>* e) const
+        {
+          return Hermes::Ord(0);
+        }
+        double value;
+      };
+
+      inline CoeffExpr coeff(double value) { return CoeffExpr(value); }
+
+      /// The physical x-coordinate of the quadrature point. Expressions
+      /// containing it naturally cannot be marked as elementwise constant.
+      struct CoordX : public Expr<CoordX>
+      {
+        enum { is_elementwise_const = 0 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return e->x[pt];
+        }
+      };
+
+      /// The physical y-coordinate of the quadrature point.
+      struct CoordY : public Expr<CoordY>
+      {
+        enum { is_elementwise_const = 0 };
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return e->y[pt];
+        }
+      };
+
+      const CoordX coord_x = CoordX();
+      const CoordY coord_y = CoordY();
+
+      /// Product of two scalar sub-expressions.
+      template<typename A, typename B>
+      struct ProdExpr : public Expr<ProdExpr<A, B> >
+      {
+        enum { is_elementwise_const = A::is_elementwise_const && B::is_elementwise_const };
+        ProdExpr(const A& a, const B& b) : a(a), b(b) {}
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return a.at(pt, u, v, e) * b.at(pt, u, v, e);
+        }
+        A a;
+        B b;
+      };
+
+      /// Sum of two scalar sub-expressions.
+      template<typename A, typename B>
+      struct SumExpr : public Expr<SumExpr<A, B> >
+      {
+        enum { is_elementwise_const = A::is_elementwise_const && B::is_elementwise_const };
+        SumExpr(const A& a, const B& b) : a(a), b(b) {}
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return a.at(pt, u, v, e) + b.at(pt, u, v, e);
+        }
+        A a;
+        B b;
+      };
+
+      /// Difference of two scalar sub-expressions.
+      template<typename A, typename B>
+      struct DiffExpr : public Expr<DiffExpr<A, B> >
+      {
+        enum { is_elementwise_const = A::is_elementwise_const && B::is_elementwise_const };
+        DiffExpr(const A& a, const B& b) : a(a), b(b) {}
+        template<typename Real>
+        Real at(int pt, Func<Real>* u, Func<Real>* v, Geom<Real>* e) const
+        {
+          return a.at(pt, u, v, e) - b.at(pt, u, v, e);
+        }
+        A a;
+        B b;
+      };
+
+      template<typename A, typename B>
+      inline ProdExpr<A, B> operator*(const Expr<A>& a, const Expr<B>& b)
+      {
+        return ProdExpr<A, B>(a.derived(), b.derived());
+      }
+      template<typename A, typename B>
+      inline SumExpr<A, B> operator+(const Expr<A>& a, const Expr<B>& b)
+      {
+        return SumExpr<A, B>(a.derived(), b.derived());
+      }
+      template<typename A, typename B>
+      inline DiffExpr<A, B> operator-(const Expr<A>& a, const Expr<B>& b)
+      {
+        return DiffExpr<A, B>(a.derived(), b.derived());
+      }
+
+      // plain numbers are promoted to coeff()
+      template<typename B>
+      inline ProdExpr<CoeffExpr, B> operator*(double a, const Expr<B>& b)
+      {
+        return ProdExpr<CoeffExpr, B>(CoeffExpr(a), b.derived());
+      }
+      template<typename A>
+      inline ProdExpr<A, CoeffExpr> operator*(const Expr<A>& a, double b)
+      {
+        return ProdExpr<A, CoeffExpr>(a.derived(), CoeffExpr(b));
+      }
+
+      /// Volumetric matrix form evaluating a DSL expression, see integral().
+      template<typename Expression>
+      class DSLMatrixFormVol : public MatrixFormVol<double>
+      {
+      public:
+        DSLMatrixFormVol(unsigned int i, unsigned int j, const Expression& expression)
+          : MatrixFormVol<double>(i, j), expression(expression)
+        {
+          this->set_const_coefficient(Expression::is_elementwise_const != 0);
+        }
+
+        virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+          Geom<double> *e, Func<double> **ext) const
+        {
+          double result = 0.0;
+          for (int pt = 0; pt < n; pt++)
+            result += wt[pt] * expression.at(pt, u, v, e);
+          return result;
+        }
+
+        virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
+          Geom<Hermes::Ord> *e, Func<Ord> **ext) const
+        {
+          return expression.at(0, u, v, e);
+        }
+
+        virtual bool value_block(int n, double *wt, Func<double> *u_ext[], Func<double> **base_fns, int base_cnt,
+          Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<double> **ext, double** result) const
+        {
+          for (int i = 0; i < test_cnt; i++)
+            for (int j = 0; j < base_cnt; j++)
+            {
+              double val = 0.0;
+              for (int pt = 0; pt < n; pt++)
+                val += wt[pt] * expression.at(pt, base_fns[j], test_fns[i], e);
+              result[i][j] = val;
+            }
+          return true;
+        }
+
+        virtual MatrixFormVol<double>* clone() const
+        {
+          DSLMatrixFormVol<Expression>* form = new DSLMatrixFormVol<Expression>(this->i, this->j, expression);
+          form->setSymFlag(this->getSymFlag());
+          form->set_const_coefficient(this->get_const_coefficient());
+          return form;
+        }
+
+      protected:
+        Expression expression;
+      };
+
+      /// Volumetric vector form evaluating a DSL expression, see integral_v().
+      template<typename Expression>
+      class DSLVectorFormVol : public VectorFormVol<double>
+      {
+      public:
+        DSLVectorFormVol(unsigned int i, const Expression& expression)
+          : VectorFormVol<double>(i), expression(expression)
+        {
+        }
+
+        virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v,
+          Geom<double> *e, Func<double> **ext) const
+        {
+          double result = 0.0;
+          for (int pt = 0; pt < n; pt++)
+            result += wt[pt] * expression.at(pt, (Func<double>*) NULL, v, e);
+          return result;
+        }
+
+        virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *v, Geom<Hermes::Ord> *e,
+          Func<Ord> **ext) const
+        {
+          return expression.at(0, (Func<Hermes::Ord>*) NULL, v, e);
+        }
+
+        virtual VectorFormVol<double>* clone() const
+        {
+          return new DSLVectorFormVol<Expression>(this->i, expression);
+        }
+
+      protected:
+        Expression expression;
+      };
+
+      /// Creates a matrix form from an expression, for the block (i, j) of the
+      /// system (the single-equation overload below uses the block (0, 0)).
+      template<typename Expression>
+      DSLMatrixFormVol<Expression>* integral(unsigned int i, unsigned int j, const Expr<Expression>& expression)
+      {
+        return new DSLMatrixFormVol<Expression>(i, j, expression.derived());
+      }
+
+      template<typename Expression>
+      DSLMatrixFormVol<Expression>* integral(const Expr<Expression>& expression)
+      {
+        return new DSLMatrixFormVol<Expression>(0, 0, expression.derived());
+      }
+
+      /// Creates a vector form from an expression, for the component i of the
+      /// system (the overload below uses the component 0).
+      template<typename Expression>
+      DSLVectorFormVol<Expression>* integral_v(unsigned int i, const Expr<Expression>& expression)
+      {
+        return new DSLVectorFormVol<Expression>(i, expression.derived());
+      }
+
+      template<typename Expression>
+      DSLVectorFormVol<Expression>* integral_v(const Expr<Expression>& expression)
+      {
+        return new DSLVectorFormVol<Expression>(0, expression.derived());
+      }
+    }
+  }
+}
+#endif
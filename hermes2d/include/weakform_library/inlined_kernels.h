@@ -0,0 +1,110 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_INLINED_KERNELS_H
+#define __H2D_INLINED_KERNELS_H
+
+#include "../weakform/weakform.h"
+#include "../forms.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /* Volumetric matrix form whose integrand is supplied as a template parameter.
+
+    The kernel is a class with two static methods,
+
+      static Scalar point(Func<double>* u, Func<double>* v, Geom<double>* e, int pt);
+      static Hermes::Ord order(Func<Hermes::Ord>* u, Func<Hermes::Ord>* v);
+
+    the first returning the integrand evaluated with the basis function u and the test
+    function v at the quadrature point pt, the second the polynomial order of the
+    integrand. Since the kernel type is known at compile time, the calls inside the
+    batch evaluation value_block() are not virtual and the compiler is free to inline
+    the kernel into the loops over basis / test function pairs and vectorize them -
+    unlike the generic assembling path, which evaluates a user form through one
+    virtual value() call per pair.
+
+    For kernels independent of the physical coordinates, combine with
+    set_const_coefficient() to also reuse local matrices between elements of
+    identical signatures.
+    */
+
+    template<typename Scalar, typename Kernel>
+    class InlinedMatrixFormVol : public MatrixFormVol<Scalar>
+    {
+    public:
+      InlinedMatrixFormVol(unsigned int i, unsigned int j) : MatrixFormVol<Scalar>(i, j)
+      {
+      }
+
+      virtual Scalar value(int n, double *wt, Func<Scalar> *u_ext[], Func<double> *u, Func<double> *v,
+        Geom<double> *e, Func<Scalar> **ext) const
+      {
+        Scalar result = Scalar(0);
+        for (int pt = 0; pt < n; pt++)
+          result += wt[pt] * Kernel::point(u, v, e, pt);
+        return result;
+      }
+
+      virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
+        Geom<Hermes::Ord> *e, Func<Ord> **ext) const
+      {
+        return Kernel::order(u, v);
+      }
+
+      virtual bool value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **base_fns, int base_cnt,
+        Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar** result) const
+      {
+        for (int i = 0; i < test_cnt; i++)
+          for (int j = 0; j < base_cnt; j++)
+          {
+            Scalar val = Scalar(0);
+            for (int pt = 0; pt < n; pt++)
+              val += wt[pt] * Kernel::point(base_fns[j], test_fns[i], e, pt);
+            result[i][j] = val;
+          }
+        return true;
+      }
+
+      virtual MatrixFormVol<Scalar>* clone() const
+      {
+        InlinedMatrixFormVol<Scalar, Kernel>* form = new InlinedMatrixFormVol<Scalar, Kernel>(this->i, this->j);
+        form->setSymFlag(this->getSymFlag());
+        form->set_const_coefficient(this->get_const_coefficient());
+        return form;
+      }
+    };
+
+    /* Kernel of the weak Laplacian, i.e. the integrand of
+    \int_{area} \nabla u \cdot \nabla v \bfx. */
+
+    class LaplaceKernel
+    {
+    public:
+      static double point(Func<double>* u, Func<double>* v, Geom<double>* e, int pt)
+      {
+        return u->dx[pt] * v->dx[pt] + u->dy[pt] * v->dy[pt];
+      }
+
+      static Hermes::Ord order(Func<Hermes::Ord>* u, Func<Hermes::Ord>* v)
+      {
+        return u->dx[0] * v->dx[0] + u->dy[0] * v->dy[0];
+      }
+    };
+  }
+}
+#endif
@@ -26,6 +26,46 @@ namespace Hermes
   {
     namespace WeakFormsH1
     {
+      /// \brief Per-element cache of radius-folded quadrature weights for axisymmetric forms.
+      ///
+      /// Axisymmetric integrands multiply every quadrature point by the radius, and on
+      /// elements touching the axis several points end up with weights far below rounding.
+      /// This cache folds the radius into the weight array once per element (the assembler
+      /// calls a form's value() once per shape-function pair with identical wt and e) and
+      /// drops points whose folded weight is negligible relative to the largest one.
+      /// Instances are not shared between threads; the assembler works on per-thread
+      /// clones of the forms.
+      class HERMES_API AxisymWeightCache
+      {
+      public:
+        AxisymWeightCache();
+        /// Copies start out empty - clone() must not share the arrays.
+        AxisymWeightCache(const AxisymWeightCache& other);
+        ~AxisymWeightCache();
+
+        /// Folds the axisymmetric radius into the weights of the current element and
+        /// compacts away negligible points. Reuses the stored arrays when called again
+        /// for the same element. Returns the number of retained points.
+        int prepare(int n, double *wt, Geom<double> *e, GeomType gt);
+
+        double* weights;  ///< Radius-scaled weights of the retained points.
+        int* points;      ///< Original quadrature point indices of the retained points.
+
+      private:
+        int capacity;
+        int cached_id;
+        int cached_n;
+        /// The element id alone does not identify the quadrature data: in
+        /// multimesh assembling the same space element is visited once per
+        /// union-mesh sub-element, with the same id and point count but
+        /// different physical points and jacobian-scaled weights. The first
+        /// physical point and weight are stored to tell the states apart.
+        double cached_x0;
+        double cached_y0;
+        double cached_wt0;
+        int np;
+      };
+
       /* Default volumetric matrix form \int_{area} const_coeff * function_coeff(x, y) * u * v \bfx
       const_coeff... constant number
       function_coeff... (generally nonconstant) function of x, y
@@ -53,10 +93,16 @@ namespace Hermes
 
         virtual MatrixFormVol<Scalar>* clone() const;
 
+        /// Fold the axisymmetric radius into cached per-element weight arrays and skip
+        /// provably negligible points. Off by default; has no effect for HERMES_PLANAR.
+        void set_axisym_weight_caching(bool to_set = true);
+
       private:
 
         Hermes2DFunction<Scalar>* coeff;
         GeomType gt;
+        bool axisym_weight_caching;
+        mutable AxisymWeightCache axisym_cache;
       };
 
       /* Default volumetric matrix form \int_{area} const_coeff * spline_coeff'(u_ext[0]) u \nabla u_ext[0] \cdot \nabla v
@@ -85,11 +131,17 @@ namespace Hermes
 
         virtual MatrixFormVol<Scalar>* clone() const;
 
+        /// Fold the axisymmetric radius into cached per-element weight arrays and skip
+        /// provably negligible points. Off by default; has no effect for HERMES_PLANAR.
+        void set_axisym_weight_caching(bool to_set = true);
+
       private:
         int idx_j;
 
         Hermes1DFunction<Scalar>* coeff;
         GeomType gt;
+        bool axisym_weight_caching;
+        mutable AxisymWeightCache axisym_cache;
       };
 
        template<typename Scalar>
@@ -50,6 +50,8 @@ namespace Hermes
 
       // reset values
       memset(errors, 0, sizeof(errors));
+      this->deterministic_error_calculation = false;
+      this->fast_error_estimation = false;
       memset(sln, 0, sizeof(sln));
       memset(rsln, 0, sizeof(rsln));
       own_forms = new bool*[H2D_MAX_COMPONENTS];
@@ -107,6 +109,8 @@ namespace Hermes
 
       // reset values
       memset(errors, 0, sizeof(errors));
+      this->deterministic_error_calculation = false;
+      this->fast_error_estimation = false;
       memset(sln, 0, sizeof(sln));
       memset(rsln, 0, sizeof(rsln));
       own_forms = new bool*[H2D_MAX_COMPONENTS];
@@ -287,6 +291,27 @@ namespace Hermes
         return true;
       }
 
+      // Shape value tables are shared by the selector clones below, fill them up front
+      // so that the parallel selection loop never writes into them.
+      for (unsigned int j = 0; j < refinement_selectors.size(); j++)
+      {
+        RefinementSelectors::ProjBasedSelector<Scalar>* proj_based_selector = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j]);
+        if(proj_based_selector != NULL)
+        {
+          bool mode_present[H2D_NUM_MODES] = { false, false };
+          const Mesh::ActiveElementsCache* element_cache = meshes[j]->get_active_elements_cache();
+          for (int i = 0; i < element_cache->count; i++)
+          {
+            mode_present[element_cache->nvert[i] == 3 ? HERMES_MODE_TRIANGLE : HERMES_MODE_QUAD] = true;
+            if(mode_present[HERMES_MODE_TRIANGLE] && mode_present[HERMES_MODE_QUAD])
+              break;
+          }
+          for(int mode = 0; mode < H2D_NUM_MODES; mode++)
+            if(mode_present[mode])
+              proj_based_selector->precalc_cached_shape_vals((ElementMode2D)mode);
+        }
+      }
+
       // RefinementSelectors cloning.
       RefinementSelectors::Selector<Scalar>*** global_refinement_selectors = new RefinementSelectors::Selector<Scalar>**[Hermes::Hermes2D::Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
 
@@ -305,6 +330,9 @@ namespace Hermes
               dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(global_refinement_selectors[i][j])->cached_shape_vals_valid = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j])->cached_shape_vals_valid;
               dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(global_refinement_selectors[i][j])->cached_shape_ortho_vals = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j])->cached_shape_ortho_vals;
               dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(global_refinement_selectors[i][j])->cached_shape_vals = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j])->cached_shape_vals;
+              dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(global_refinement_selectors[i][j])->cand_proj_error_cache = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j])->cand_proj_error_cache;
+              dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(global_refinement_selectors[i][j])->candidate_eval_caching = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j])->candidate_eval_caching;
+              dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(global_refinement_selectors[i][j])->candidate_eval_delta = dynamic_cast<RefinementSelectors::ProjBasedSelector<Scalar>*>(refinement_selectors[j])->candidate_eval_delta;
             }
             if(dynamic_cast<RefinementSelectors::OptimumSelector<Scalar>*>(global_refinement_selectors[i][j]) != NULL)
               dynamic_cast<RefinementSelectors::OptimumSelector<Scalar>*>(global_refinement_selectors[i][j])->num_shapes = dynamic_cast<RefinementSelectors::OptimumSelector<Scalar>*>(refinement_selectors[j])->num_shapes;
@@ -340,7 +368,7 @@ namespace Hermes
       int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
 #pragma omp parallel shared(ids, components, elem_inx_to_proc, meshes, current_orders) private(current_refinement_selectors, current_rslns, id_to_refine) num_threads(num_threads_used)
       {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
         for(id_to_refine = 0; id_to_refine < ids.size(); id_to_refine++)
         {
           try
@@ -428,6 +456,10 @@ namespace Hermes
       //apply refinements
       apply_refinements(elem_inx_to_proc);
 
+      // Record the accepted refinements for a later warm-started replay.
+      if(!this->refinement_trace_file_name.empty())
+        this->record_refinement_trace(elem_inx_to_proc);
+
       // in singlemesh case, impose same orders across meshes
       homogenize_shared_mesh_orders(meshes);
 
@@ -816,12 +848,122 @@ namespace Hermes
       return last_refinements;
     }
 
+    template<typename Scalar>
+    void Adapt<Scalar>::set_refinement_trace_recording(const char* file_name)
+    {
+      this->refinement_trace_file_name = file_name;
+    }
+
+    template<typename Scalar>
+    void Adapt<Scalar>::record_refinement_trace(const std::vector<ElementToRefine>& elems_to_refine)
+    {
+      FILE* file = fopen(this->refinement_trace_file_name.c_str(), "ab");
+      if(file == NULL)
+      {
+        this->warn("Adaptivity: could not open the refinement trace file \"%s\" for appending.", this->refinement_trace_file_name.c_str());
+        return;
+      }
+      fprintf(file, "iteration %d\n", (int) elems_to_refine.size());
+      for (std::vector<ElementToRefine>::const_iterator elem_ref = elems_to_refine.begin();
+        elem_ref != elems_to_refine.end(); elem_ref++)
+      {
+        fprintf(file, "%d %d %d", elem_ref->id, elem_ref->comp, elem_ref->split);
+        for (int j = 0; j < H2D_MAX_ELEMENT_SONS; j++)
+          fprintf(file, " %d", elem_ref->p[j]);
+        for (int j = 0; j < H2D_MAX_ELEMENT_SONS; j++)
+          fprintf(file, " %d", elem_ref->q[j]);
+        fprintf(file, "\n");
+      }
+      fclose(file);
+    }
+
+    template<typename Scalar>
+    int Adapt<Scalar>::replay_refinement_trace(const char* file_name)
+    {
+      FILE* file = fopen(file_name, "rb");
+      if(file == NULL)
+        throw Hermes::Exceptions::Exception("Adaptivity: could not open the refinement trace file \"%s\".", file_name);
+
+      Mesh* meshes[H2D_MAX_COMPONENTS];
+      for (int i = 0; i < this->num; i++)
+        meshes[i] = this->spaces[i]->get_mesh();
+
+      int blocks = 0;
+      int count;
+      while (fscanf(file, " iteration %d", &count) == 1)
+      {
+        std::vector<ElementToRefine> elems_to_refine;
+        elems_to_refine.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+          ElementToRefine elem_ref;
+          if(fscanf(file, "%d %d %d %d %d %d %d %d %d %d %d", &elem_ref.id, &elem_ref.comp, &elem_ref.split,
+            &elem_ref.p[0], &elem_ref.p[1], &elem_ref.p[2], &elem_ref.p[3],
+            &elem_ref.q[0], &elem_ref.q[1], &elem_ref.q[2], &elem_ref.q[3]) != 11)
+          {
+            fclose(file);
+            throw Hermes::Exceptions::Exception("Adaptivity: the refinement trace file \"%s\" is truncated.", file_name);
+          }
+          if(elem_ref.comp < 0 || elem_ref.comp >= this->num
+            || elem_ref.id < 0 || elem_ref.id >= meshes[elem_ref.comp]->get_max_element_id())
+          {
+            fclose(file);
+            throw Hermes::Exceptions::Exception("Adaptivity: the refinement trace file \"%s\" does not match the meshes.", file_name);
+          }
+          elems_to_refine.push_back(elem_ref);
+        }
+
+        // One recorded adapt() call worth of refinements at a time, so that the
+        // replay passes through the same bulk-refinement path as the recording run.
+        apply_refinements(elems_to_refine);
+        homogenize_shared_mesh_orders(meshes);
+        blocks++;
+      }
+      fclose(file);
+
+      for(unsigned int i = 0; i < this->spaces.size(); i++)
+        this->spaces[i]->assign_dofs();
+
+      this->info("Adaptivity: replayed %d refinement block(s) from \"%s\".", blocks, file_name);
+      return blocks;
+    }
+
     template<typename Scalar>
     void Adapt<Scalar>::apply_refinements(std::vector<ElementToRefine>& elems_to_refine)
     {
+      // the mesh refinements first, in bulk, one pass per distinct mesh
+      for (int i = 0; i < this->num; i++)
+      {
+        Mesh* mesh = this->spaces[i]->get_mesh();
+        bool mesh_done = false;
+        for (int j = 0; j < i; j++)
+          if(this->spaces[j]->get_mesh() == mesh)
+            mesh_done = true;
+        if(mesh_done)
+          continue;
+
+        std::vector<ElementToRefine> mesh_refs;
+        for (std::vector<ElementToRefine>::const_iterator elem_ref = elems_to_refine.begin();
+          elem_ref != elems_to_refine.end(); elem_ref++)
+          if(this->spaces[elem_ref->comp]->get_mesh() == mesh)
+            mesh_refs.push_back(*elem_ref);
+        mesh->refine_elements(mesh_refs);
+      }
+
+      // then the polynomial orders: the elements are refined already, so
+      // apply_refinement() only distributes the orders among the sons. The
+      // constraint updates of the spaces stay deferred to the assign_dofs()
+      // that follows the refinements, and batching the order updates leaves
+      // each space with a single sequence increment for the whole pass.
+      for (int i = 0; i < this->num; i++)
+        this->spaces[i]->begin_order_updates();
+
       for (std::vector<ElementToRefine>::const_iterator elem_ref = elems_to_refine.begin();
         elem_ref != elems_to_refine.end(); elem_ref++)
         apply_refinement(*elem_ref);
+
+      for (int i = 0; i < this->num; i++)
+        this->spaces[i]->end_order_updates();
     }
 
     template<typename Scalar>
@@ -934,6 +1076,11 @@ namespace Hermes
       ov->free_ord(); delete ov;
       delete fake_e;
 
+      // In the fast estimation mode integrate at roughly the solution order
+      // instead of the doubled order of the error product.
+      if(this->fast_error_estimation)
+        order = std::max(1, order / 2);
+
       // eval the form
       Quad2D* quad = sln1->get_quad_2d();
       double3* pt = quad->get_points(order, sln1->get_active_element()->get_mode());
@@ -998,6 +1145,11 @@ namespace Hermes
       ov->free_ord(); delete ov;
       delete fake_e;
 
+      // In the fast estimation mode integrate at roughly the solution order
+      // instead of the doubled order of the error product.
+      if(this->fast_error_estimation)
+        order = std::max(1, order / 2);
+
       // eval the form
       Quad2D* quad = rsln1->get_quad_2d();
       double3* pt = quad->get_points(order, rrv1->get_active_element()->get_mode());
@@ -1085,15 +1237,11 @@ namespace Hermes
 
       // Prepare multi-mesh traversal and error arrays.
       const Mesh **meshes = new const Mesh *[2 * num];
-      Transformable **tr = new Transformable *[2 * num];
-      Traverse trav(true);
       num_act_elems = 0;
       for (i = 0; i < num; i++)
       {
         meshes[i] = sln[i]->get_mesh();
         meshes[i + num] = rsln[i]->get_mesh();
-        tr[i] = sln[i];
-        tr[i + num] = rsln[i];
 
         num_act_elems += sln[i]->get_mesh()->get_num_active_elements();
 
@@ -1114,32 +1262,203 @@ namespace Hermes
       if(solutions_for_adapt) this->errors_squared_sum = 0.0;
       double total_error = 0.0;
 
+      // Precalculation of states for the loop to claim them by index.
+      int num_states;
+      Traverse trav_master(true);
+      Hermes::vector<const Mesh*> mesh_vector;
+      for (i = 0; i < 2 * num; i++)
+        mesh_vector.push_back(meshes[i]);
+      Traverse::State** states = trav_master.get_states(mesh_vector, num_states);
+
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+
+      // Solution cloning.
+      Solution<Scalar>*** slns_cloned = new Solution<Scalar>**[num_threads_used];
+      Solution<Scalar>*** rslns_cloned = new Solution<Scalar>**[num_threads_used];
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        slns_cloned[thread] = new Solution<Scalar>*[num];
+        rslns_cloned[thread] = new Solution<Scalar>*[num];
+        for (j = 0; j < num; j++)
+        {
+          slns_cloned[thread][j] = dynamic_cast<Solution<Scalar>*>(sln[j]->clone());
+          slns_cloned[thread][j]->set_quad_2d(&g_quad_2d_std);
+          rslns_cloned[thread][j] = dynamic_cast<Solution<Scalar>*>(rsln[j]->clone());
+          rslns_cloned[thread][j]->set_quad_2d(&g_quad_2d_std);
+        }
+      }
+
+      // Per-thread accumulators, combined once the loop finishes.
+      double* norms_threads = new double[num_threads_used * num];
+      memset(norms_threads, 0, num_threads_used * num * sizeof(double));
+      double* errors_components_threads = new double[num_threads_used * num];
+      memset(errors_components_threads, 0, num_threads_used * num * sizeof(double));
+      // Deterministic mode: the contribution of every state is stored on its
+      // own instead of being folded into a per-thread accumulator, so that the
+      // reduction below can proceed in the fixed state order.
+      double* state_norms = NULL;
+      double* state_errors = NULL;
+      if(this->deterministic_error_calculation)
+      {
+        state_norms = new double[(size_t)num_states * num];
+        memset(state_norms, 0, (size_t)num_states * num * sizeof(double));
+        state_errors = new double[(size_t)num_states * num];
+        memset(state_errors, 0, (size_t)num_states * num * sizeof(double));
+      }
+
+      double*** errors_threads = NULL;
+      if(solutions_for_adapt && !this->deterministic_error_calculation)
+      {
+        errors_threads = new double**[num_threads_used];
+        for(int thread = 0; thread < num_threads_used; thread++)
+        {
+          errors_threads[thread] = new double*[num];
+          for (i = 0; i < num; i++)
+          {
+            int max = meshes[i]->get_max_element_id();
+            errors_threads[thread][i] = new double[max];
+            memset(errors_threads[thread][i], 0, sizeof(double) * max);
+          }
+        }
+      }
+
+      this->caughtException = NULL;
+
       // Calculate error.
-      Traverse::State * ee;
-      trav.begin(2 * num, meshes, tr);
-      while ((ee = trav.get_next_state()) != NULL)
+      Solution<Scalar>** current_slns;
+      Solution<Scalar>** current_rslns;
+      int state_i;
+#pragma omp parallel shared(states, num_states, meshes) private(current_slns, current_rslns, state_i) num_threads(num_threads_used)
       {
-        for (i = 0; i < num; i++)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+        for(state_i = 0; state_i < num_states; state_i++)
         {
-          for (j = 0; j < num; j++)
+          try
           {
-            if(error_form[i][j] != NULL)
+            current_slns = slns_cloned[omp_get_thread_num()];
+            current_rslns = rslns_cloned[omp_get_thread_num()];
+
+            Traverse::State* ee = states[state_i];
+
+            for (int k = 0; k < num; k++)
             {
-              double err, nrm;
-              err = eval_error(error_form[i][j], sln[i], sln[j], rsln[i], rsln[j]);
-              nrm = eval_error_norm(norm_form[i][j], rsln[i], rsln[j]);
-
-              norms[i] += nrm;
-              total_norm  += nrm;
-              total_error += err;
-              errors_components[i] += err;
-              if(solutions_for_adapt)
-                this->errors[i][ee->e[i]->id] += err;
+              if(ee->e[k] != NULL)
+              {
+                current_slns[k]->set_active_element(ee->e[k]);
+                current_slns[k]->set_transform(ee->sub_idx[k]);
+              }
+              if(ee->e[k + num] != NULL)
+              {
+                current_rslns[k]->set_active_element(ee->e[k + num]);
+                current_rslns[k]->set_transform(ee->sub_idx[k + num]);
+              }
+            }
+
+            double* current_norms = (state_norms != NULL)
+              ? state_norms + (size_t)state_i * num
+              : norms_threads + omp_get_thread_num() * num;
+            double* current_errors_components = (state_errors != NULL)
+              ? state_errors + (size_t)state_i * num
+              : errors_components_threads + omp_get_thread_num() * num;
+
+            for (int form_i = 0; form_i < num; form_i++)
+            {
+              for (int form_j = 0; form_j < num; form_j++)
+              {
+                if(error_form[form_i][form_j] != NULL)
+                {
+                  double err, nrm;
+                  err = eval_error(error_form[form_i][form_j], current_slns[form_i], current_slns[form_j], current_rslns[form_i], current_rslns[form_j]);
+                  nrm = eval_error_norm(norm_form[form_i][form_j], current_rslns[form_i], current_rslns[form_j]);
+
+                  current_norms[form_i] += nrm;
+                  current_errors_components[form_i] += err;
+                  if(solutions_for_adapt && errors_threads != NULL)
+                    errors_threads[omp_get_thread_num()][form_i][ee->e[form_i]->id] += err;
+                }
+              }
             }
           }
+          catch(Hermes::Exceptions::Exception& exception)
+          {
+            if(this->caughtException == NULL)
+              this->caughtException = exception.clone();
+          }
+          catch(std::exception& exception)
+          {
+            if(this->caughtException == NULL)
+              this->caughtException = new Hermes::Exceptions::Exception(exception.what());
+          }
         }
       }
-      trav.finish();
+
+      // Combine the partial results. The deterministic mode walks the states in
+      // their fixed order; otherwise the per-thread accumulators are summed.
+      if(this->deterministic_error_calculation)
+      {
+        for(state_i = 0; state_i < num_states; state_i++)
+          for (i = 0; i < num; i++)
+          {
+            norms[i] += state_norms[(size_t)state_i * num + i];
+            double err = state_errors[(size_t)state_i * num + i];
+            errors_components[i] += err;
+            if(solutions_for_adapt && states[state_i]->e[i] != NULL)
+              this->errors[i][states[state_i]->e[i]->id] += err;
+          }
+        delete [] state_norms;
+        delete [] state_errors;
+      }
+      else
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        for (i = 0; i < num; i++)
+        {
+          norms[i] += norms_threads[thread * num + i];
+          errors_components[i] += errors_components_threads[thread * num + i];
+          if(solutions_for_adapt)
+          {
+            int max = meshes[i]->get_max_element_id();
+            for(int id = 0; id < max; id++)
+              this->errors[i][id] += errors_threads[thread][i][id];
+          }
+        }
+      }
+      for (i = 0; i < num; i++)
+      {
+        total_norm += norms[i];
+        total_error += errors_components[i];
+      }
+
+      delete [] norms_threads;
+      delete [] errors_components_threads;
+      if(errors_threads != NULL)
+      {
+        for(int thread = 0; thread < num_threads_used; thread++)
+        {
+          for (i = 0; i < num; i++)
+            delete [] errors_threads[thread][i];
+          delete [] errors_threads[thread];
+        }
+        delete [] errors_threads;
+      }
+
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        for (j = 0; j < num; j++)
+        {
+          delete slns_cloned[thread][j];
+          delete rslns_cloned[thread][j];
+        }
+        delete [] slns_cloned[thread];
+        delete [] rslns_cloned[thread];
+      }
+      delete [] slns_cloned;
+      delete [] rslns_cloned;
+
+      Traverse::free_states(states, num_states);
+
+      if(this->caughtException != NULL)
+        throw *(this->caughtException);
 
       // Store the calculation for each solution component separately.
       if(component_errors != NULL)
@@ -1199,7 +1518,6 @@ namespace Hermes
       }
 
       delete [] meshes;
-      delete [] tr;
       delete [] norms;
       delete [] errors_components;
 
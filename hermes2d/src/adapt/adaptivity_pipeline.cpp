@@ -0,0 +1,250 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+#include "adaptivity_pipeline.h"
+#include "discrete_problem_linear.h"
+#include "solvers/umfpack_solver.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    template<typename Scalar>
+    AdaptivityPipeline<Scalar>::AdaptivityPipeline(const WeakForm<Scalar>* wf, Space<Scalar>* space,
+      Adapt<Scalar>* adaptivity, RefinementSelectors::Selector<Scalar>* selector)
+      : Hermes::Mixins::Loggable(true), wf(wf), space(space), adaptivity(adaptivity), selector(selector),
+      matrix(NULL), rhs(NULL), solver(NULL), last_ref_space(NULL), last_ref_mesh(NULL),
+      error_stop(1.0), max_iterations(10), order_increase(1),
+      threshold(0.3), strat(0), regularize(-1), error_estimate(0.0)
+    {
+      if(wf == NULL || space == NULL || adaptivity == NULL || selector == NULL)
+        throw Hermes::Exceptions::NullException(wf == NULL ? 1 : (space == NULL ? 2 : (adaptivity == NULL ? 3 : 4)));
+#ifndef _WIN32
+      this->teardown_pending = false;
+#endif
+    }
+
+    template<typename Scalar>
+    AdaptivityPipeline<Scalar>::~AdaptivityPipeline()
+    {
+      this->join_teardown();
+      if(this->solver != NULL)
+        delete this->solver;
+      if(this->matrix != NULL)
+        delete this->matrix;
+      if(this->rhs != NULL)
+        delete this->rhs;
+      if(this->last_ref_space != NULL)
+        delete this->last_ref_space;
+      if(this->last_ref_mesh != NULL)
+        delete this->last_ref_mesh;
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::set_tolerance(double error_stop)
+    {
+      if(error_stop <= 0.0)
+        throw Hermes::Exceptions::ValueException("error_stop", error_stop, 0.0);
+      this->error_stop = error_stop;
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::set_max_iterations(int max_iterations)
+    {
+      if(max_iterations < 1)
+        throw Hermes::Exceptions::ValueException("max_iterations", max_iterations, 1);
+      this->max_iterations = max_iterations;
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::set_order_increase(unsigned int order_increase)
+    {
+      this->order_increase = order_increase;
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::set_adapt_parameters(double threshold, int strat, int regularize)
+    {
+      this->threshold = threshold;
+      this->strat = strat;
+      this->regularize = regularize;
+    }
+
+    template<typename Scalar>
+    Solution<Scalar>* AdaptivityPipeline<Scalar>::get_solution()
+    {
+      return &this->sln;
+    }
+
+    template<typename Scalar>
+    Solution<Scalar>* AdaptivityPipeline<Scalar>::get_ref_solution()
+    {
+      return &this->ref_sln;
+    }
+
+    template<typename Scalar>
+    double AdaptivityPipeline<Scalar>::get_error_estimate() const
+    {
+      return this->error_estimate;
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::solve_reference(Space<Scalar>* ref_space)
+    {
+#ifdef WITH_UMFPACK
+      Algebra::UMFPackMatrix<Scalar>* mat = new Algebra::UMFPackMatrix<Scalar>();
+      Algebra::UMFPackVector<Scalar>* vec = new Algebra::UMFPackVector<Scalar>(ref_space->get_num_dofs());
+      Hermes::Solvers::UMFPackLinearMatrixSolver<Scalar>* sol =
+        new Hermes::Solvers::UMFPackLinearMatrixSolver<Scalar>(mat, vec);
+
+      DiscreteProblemLinear<Scalar> dp(this->wf, ref_space);
+      dp.assemble(mat, vec);
+      sol->solve();
+      Solution<Scalar>::vector_to_solution(sol->get_sln_vector(), ref_space, &this->ref_sln);
+
+      this->matrix = mat;
+      this->rhs = vec;
+      this->solver = sol;
+#else
+      throw Hermes::Exceptions::Exception("AdaptivityPipeline requires the UMFPACK solver.");
+#endif
+    }
+
+    template<typename Scalar>
+    void* AdaptivityPipeline<Scalar>::teardown_worker(void* data)
+    {
+      RetiredIteration* retired = (RetiredIteration*)data;
+      if(retired->solver != NULL)
+        delete retired->solver;
+      if(retired->matrix != NULL)
+        delete retired->matrix;
+      if(retired->rhs != NULL)
+        delete retired->rhs;
+      if(retired->ref_space != NULL)
+        delete retired->ref_space;
+      if(retired->ref_mesh != NULL)
+        delete retired->ref_mesh;
+      delete retired;
+      return NULL;
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::retire(Space<Scalar>* ref_space, Mesh* ref_mesh,
+      SparseMatrix<Scalar>* matrix, Vector<Scalar>* rhs, Hermes::Solvers::LinearMatrixSolver<Scalar>* solver)
+    {
+      RetiredIteration* retired = new RetiredIteration;
+      retired->ref_space = ref_space;
+      retired->ref_mesh = ref_mesh;
+      retired->matrix = matrix;
+      retired->rhs = rhs;
+      retired->solver = solver;
+#ifndef _WIN32
+      this->join_teardown();
+      if(pthread_create(&this->teardown_thread, NULL, &AdaptivityPipeline<Scalar>::teardown_worker, retired) == 0)
+      {
+        this->teardown_pending = true;
+        return;
+      }
+#endif
+      // No thread available - dismantle the structures right away.
+      AdaptivityPipeline<Scalar>::teardown_worker(retired);
+    }
+
+    template<typename Scalar>
+    void AdaptivityPipeline<Scalar>::join_teardown()
+    {
+#ifndef _WIN32
+      if(this->teardown_pending)
+      {
+        pthread_join(this->teardown_thread, NULL);
+        this->teardown_pending = false;
+      }
+#endif
+    }
+
+    template<typename Scalar>
+    int AdaptivityPipeline<Scalar>::run()
+    {
+      int iteration = 0;
+      Space<Scalar>* prev_ref_space = NULL;
+      Mesh* prev_ref_mesh = NULL;
+
+      // Structures left over from a previous run().
+      if(this->last_ref_space != NULL)
+      {
+        this->retire(this->last_ref_space, this->last_ref_mesh, this->matrix, this->rhs, this->solver);
+        this->join_teardown();
+        this->last_ref_space = NULL;
+        this->last_ref_mesh = NULL;
+        this->matrix = NULL;
+        this->rhs = NULL;
+        this->solver = NULL;
+      }
+
+      while(true)
+      {
+        iteration++;
+        this->info("AdaptivityPipeline: iteration %d, ndof: %d.", iteration, this->space->get_num_dofs());
+
+        // The reference structures of the previous iteration; their solver
+        // objects are still held in matrix / rhs / solver at this point.
+        SparseMatrix<Scalar>* prev_matrix = this->matrix;
+        Vector<Scalar>* prev_rhs = this->rhs;
+        Hermes::Solvers::LinearMatrixSolver<Scalar>* prev_solver = this->solver;
+        this->matrix = NULL;
+        this->rhs = NULL;
+        this->solver = NULL;
+
+        // Construct the reference problem of this iteration and solve it.
+        typename Mesh::ReferenceMeshCreator ref_mesh_creator(this->space->get_mesh());
+        Mesh* ref_mesh = ref_mesh_creator.create_ref_mesh();
+        typename Space<Scalar>::ReferenceSpaceCreator ref_space_creator(this->space, ref_mesh, this->order_increase);
+        Space<Scalar>* ref_space = ref_space_creator.create_ref_space();
+        this->solve_reference(ref_space);
+
+        // The new reference solution no longer refers to anything from the
+        // previous iteration, so its structures can be dismantled in the
+        // background while the estimate and the refinements are computed.
+        if(prev_ref_space != NULL)
+          this->retire(prev_ref_space, prev_ref_mesh, prev_matrix, prev_rhs, prev_solver);
+        prev_ref_space = ref_space;
+        prev_ref_mesh = ref_mesh;
+
+        this->projection.project_global(this->space, &this->ref_sln, &this->sln);
+        this->error_estimate = this->adaptivity->calc_err_est(&this->sln, &this->ref_sln);
+        this->info("AdaptivityPipeline: error estimate: %g%%.", this->error_estimate);
+
+        if(this->error_estimate < this->error_stop)
+          break;
+        if(iteration >= this->max_iterations)
+        {
+          this->warn("AdaptivityPipeline: maximum number of iterations (%d) reached.", this->max_iterations);
+          break;
+        }
+        if(this->adaptivity->adapt(this->selector, this->threshold, this->strat, this->regularize))
+          break;
+      }
+
+      // The structures of the last iteration stay alive - ref_sln refers to
+      // them; the destructor cleans them up together with matrix / rhs / solver.
+      this->join_teardown();
+      this->last_ref_space = prev_ref_space;
+      this->last_ref_mesh = prev_ref_mesh;
+      return iteration;
+    }
+
+    template class HERMES_API AdaptivityPipeline<double>;
+    template class HERMES_API AdaptivityPipeline<std::complex<double> >;
+  }
+}
@@ -13,6 +13,7 @@
 // You should have received a copy of the GNU General Public License
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 #include "kelly_type_adapt.h"
+#include "api2d.h"
 
 namespace Hermes
 {
@@ -51,6 +52,7 @@ namespace Hermes
       interface_scaling_fns = interface_scaling_fns_;
       interface_scaling_const = boundary_scaling_const = volumetric_scaling_const = 1.0;
       ignore_visited_segments = ignore_visited_segments_;
+      interface_order_reduction = false;
 
       element_markers_conversion = spaces_[0]->get_mesh()->element_markers_conversion;
       boundary_markers_conversion = spaces_[0]->get_mesh()->boundary_markers_conversion;
@@ -72,11 +74,40 @@ namespace Hermes
 
       interface_scaling_const = boundary_scaling_const = volumetric_scaling_const = 1.0;
       ignore_visited_segments = ignore_visited_segments_;
+      interface_order_reduction = false;
 
       element_markers_conversion = space_->get_mesh()->element_markers_conversion;
       boundary_markers_conversion = space_->get_mesh()->boundary_markers_conversion;
     }
 
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::set_interface_order_limit(std::string element_marker, int order)
+    {
+      if(order < 0)
+        throw Exceptions::ValueException("order", order, 0);
+      Mesh::MarkersConversion::IntValid internal = element_markers_conversion.get_internal_marker(element_marker);
+      if(!internal.valid)
+        throw Hermes::Exceptions::Exception("Unknown element marker \"%s\" in set_interface_order_limit().", element_marker.c_str());
+      element_marker_order_limits[internal.marker] = order;
+    }
+
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::set_boundary_order_limit(std::string boundary_marker, int order)
+    {
+      if(order < 0)
+        throw Exceptions::ValueException("order", order, 0);
+      Mesh::MarkersConversion::IntValid internal = boundary_markers_conversion.get_internal_marker(boundary_marker);
+      if(!internal.valid)
+        throw Hermes::Exceptions::Exception("Unknown boundary marker \"%s\" in set_boundary_order_limit().", boundary_marker.c_str());
+      boundary_marker_order_limits[internal.marker] = order;
+    }
+
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::set_interface_order_reduction(bool to_set)
+    {
+      this->interface_order_reduction = to_set;
+    }
+
     template<typename Scalar>
     bool KellyTypeAdapt<Scalar>::adapt(double thr, int strat, int regularize, double to_be_processed)
     {
@@ -127,13 +158,11 @@ namespace Hermes
       this->have_coarse_solutions = true;
 
       const Mesh** meshes = new const Mesh*[this->num];
-      Transformable** fns = new Transformable*[this->num];
 
       this->num_act_elems = 0;
       for (int i = 0; i < this->num; i++)
       {
         meshes[i] = (this->sln[i]->get_mesh());
-        fns[i] = (this->sln[i]);
 
         this->num_act_elems += meshes[i]->get_num_active_elements();
         int max = meshes[i]->get_max_element_id();
@@ -161,27 +190,126 @@ namespace Hermes
       this->errors_squared_sum = 0.0;
       double total_error = 0.0;
 
-      bool bnd[H2D_MAX_NUMBER_EDGES];
-      SurfPos surf_pos[H2D_MAX_NUMBER_EDGES];
-      Traverse::State *ee;
-      Traverse trav(true);
+      // Precalculation of states for the loop below to claim them by index.
+      int num_states;
+      Traverse trav_master(true);
+      Hermes::vector<const Mesh*> mesh_vector;
+      for (int i = 0; i < this->num; i++)
+        mesh_vector.push_back(meshes[i]);
+      Traverse::State** states = trav_master.get_states(mesh_vector, num_states);
+
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+
+      // External functions supplied to the estimator forms are shared between all evaluations
+      // and keep internal state, so their presence degrades the sweep to a single thread.
+      for (unsigned int iest = 0; iest < error_estimators_vol.size(); iest++)
+        if(error_estimators_vol[iest]->ext.size() > 0)
+          num_threads_used = 1;
+      for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+        if(error_estimators_surf[iest]->ext.size() > 0)
+          num_threads_used = 1;
+
+      // Solution cloning - the active element and subelement mapping of a solution cannot
+      // be shared between threads.
+      Solution<Scalar>*** slns_cloned = new Solution<Scalar>**[num_threads_used];
+      Transformable*** fns_cloned = new Transformable**[num_threads_used];
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        slns_cloned[thread] = new Solution<Scalar>*[this->num];
+        fns_cloned[thread] = new Transformable*[this->num];
+        for (int j = 0; j < this->num; j++)
+        {
+          slns_cloned[thread][j] = dynamic_cast<Solution<Scalar>*>(this->sln[j]->clone());
+          slns_cloned[thread][j]->set_quad_2d(&g_quad_2d_std);
+          fns_cloned[thread][j] = slns_cloned[thread][j];
+        }
+      }
 
-      // Reset the e->visited status of each element of each mesh (most likely it will be set to true from
-      // the latest assembling procedure).
-      if(ignore_visited_segments)
+      // Per-thread accumulators, combined once the loop finishes.
+      double* norms_threads = NULL;
+      if(calc_norm)
       {
+        norms_threads = new double[num_threads_used * this->num];
+        memset(norms_threads, 0, num_threads_used * this->num * sizeof(double));
+      }
+      double* errors_components_threads = new double[num_threads_used * this->num];
+      memset(errors_components_threads, 0, num_threads_used * this->num * sizeof(double));
+      double*** errors_threads = new double**[num_threads_used];
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        errors_threads[thread] = new double*[this->num];
         for (int i = 0; i < this->num; i++)
         {
-          Element* e;
-          for_all_active_elements(e, meshes[i])
-            e->visited = false;
+          int max = meshes[i]->get_max_element_id();
+          errors_threads[thread][i] = new double[max];
+          memset(errors_threads[thread][i], 0, sizeof(double) * max);
         }
       }
 
-      // Begin the multimesh traversal.
-      trav.begin(this->num, meshes, fns);
-      while ((ee = trav.get_next_state()) != NULL)
+      // Determine the minimum mesh seq (the same for every interface encountered below).
+      unsigned int min_dg_mesh_seq = 0;
+      for(unsigned int j = 0; j < this->spaces.size(); j++)
+        if(this->spaces[j]->get_mesh()->get_seq() < min_dg_mesh_seq || j == 0)
+          min_dg_mesh_seq = this->spaces[j]->get_mesh()->get_seq();
+
+      // Build the element adjacencies up front so the threads below only read them.
+      const Mesh::ElementAdjacency** adjacencies = new const Mesh::ElementAdjacency*[this->num];
+      for (int i = 0; i < this->num; i++)
+        adjacencies[i] = const_cast<Mesh*>(meshes[i])->get_element_adjacency();
+
+      this->caughtException = NULL;
+
+      Solution<Scalar>** current_slns;
+      Transformable** current_fns;
+      int state_i;
+
+#define CHUNKSIZE 1
+#pragma omp parallel shared(states, num_states, meshes) private(current_slns, current_fns, state_i) num_threads(num_threads_used)
       {
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+        for(state_i = 0; state_i < num_states; state_i++)
+      {
+        if(this->caughtException != NULL)
+          continue;
+        try
+        {
+
+        current_slns = slns_cloned[omp_get_thread_num()];
+        current_fns = fns_cloned[omp_get_thread_num()];
+        double* current_norms = calc_norm ? norms_threads + omp_get_thread_num() * this->num : NULL;
+        double* current_errors_components = errors_components_threads + omp_get_thread_num() * this->num;
+        double** current_errors = errors_threads[omp_get_thread_num()];
+
+        Traverse::State* ee = states[state_i];
+
+        // Prefetch the elements of the next state together with their recorded
+        // neighbors while this state is being processed; the surface estimators
+        // below will chase the same data through the edge nodes.
+        if(state_i + 1 < num_states)
+        {
+          Traverse::State* next = states[state_i + 1];
+          for (int k = 0; k < this->num; k++)
+          {
+            if(next->e[k] == NULL)
+              continue;
+            H2D_PREFETCH(next->e[k]);
+            if(next->e[k]->id < adjacencies[k]->size)
+              for (int a = adjacencies[k]->neighbor_start[next->e[k]->id]; a < adjacencies[k]->neighbor_start[next->e[k]->id + 1]; a++)
+                H2D_PREFETCH(meshes[k]->get_element(adjacencies[k]->neighbor_ids[a]));
+          }
+        }
+
+        for (int k = 0; k < this->num; k++)
+        {
+          if(ee->e[k] == NULL)
+            continue;
+          current_slns[k]->set_active_element(ee->e[k]);
+          current_slns[k]->set_transform(ee->sub_idx[k]);
+        }
+
+        bool bnd[H2D_MAX_NUMBER_EDGES];
+        SurfPos surf_pos[H2D_MAX_NUMBER_EDGES];
+
         bnd[0] = ee->bnd[0];
         bnd[1] = ee->bnd[1];
         bnd[2] = ee->bnd[2];
@@ -203,10 +331,7 @@ namespace Hermes
           if(ee->e[i] == NULL)
             continue;
 
-          // Set maximum integration order for use in integrals, see limit_order()
-          update_limit_table(ee->e[i]->get_mode());
-
-          RefMap *rm = this->sln[i]->get_refmap();
+          RefMap *rm = current_slns[i]->get_refmap();
 
           double err = 0.0;
 
@@ -223,7 +348,7 @@ namespace Hermes
               if(!element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).valid || element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).marker != ee->e[i]->marker)
                 continue;
 
-            err += eval_volumetric_estimator(error_estimators_vol[iest], rm);
+            err += eval_volumetric_estimator(error_estimators_vol[iest], rm, current_slns);
           }
 
           // Go through all surface error estimators (includes both interface and boundary est's).
@@ -248,7 +373,7 @@ namespace Hermes
                     continue;
                 }
 
-                err += eval_boundary_estimator(error_estimators_surf[iest], rm, &surf_pos[isurf]);
+                err += eval_boundary_estimator(error_estimators_surf[iest], rm, &surf_pos[isurf], current_slns);
               }
               else              // Interface
               {
@@ -263,12 +388,6 @@ namespace Hermes
                 NeighborNode* root;
                 int ns_index;
 
-                // Determine the minimum mesh seq in this stage.
-                unsigned int min_dg_mesh_seq = 0;
-                for(unsigned int j = 0; j < this->spaces.size(); j++)
-                  if(this->spaces[j]->get_mesh()->get_seq() < min_dg_mesh_seq || j == 0)
-                    min_dg_mesh_seq = this->spaces[j]->get_mesh()->get_seq();
-
                 ns_index = meshes[i]->get_seq() - min_dg_mesh_seq; // = 0 for single mesh
 
                 // Initialize the NeighborSearches.
@@ -302,16 +421,12 @@ namespace Hermes
                 {
                   if(ignore_visited_segments)
                   {
-                    bool processed = true;
-                    for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                      if(neighbor_searches.present(j))
-                        if(!neighbor_searches.get(j)->neighbors.at(neighbor)->visited)
-                        {
-                          processed = false;
-                          break;
-                        }
-
-                    if(processed) continue;
+                    // Instead of marking processed segments by element visited flags (which would
+                    // race between the threads of the sweep), each segment is deterministically
+                    // owned by the side with the lower element id; the other side skips it and
+                    // receives its share of the estimate through the scatter below.
+                    if(neighbor_searches.get(ns_index)->neighbors.at(neighbor)->id < ee->e[i]->id)
+                      continue;
                   }
 
                   // We do not use cache_e and cache_jwt here.
@@ -334,17 +449,17 @@ namespace Hermes
                   {
                     NeighborSearch<Scalar> *ns = neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq);
                     if(ns->central_transformations.present(neighbor))
-                      ns->central_transformations.get(neighbor)->apply_on(fns[fns_i]);
+                      ns->central_transformations.get(neighbor)->apply_on(current_fns[fns_i]);
                   }
 
                   // END COPY FROM DISCRETE_PROBLEM.CPP
-                  rm->force_transform(this->sln[i]->get_transform(), this->sln[i]->get_ctm());
+                  rm->force_transform(current_slns[i]->get_transform(), current_slns[i]->get_ctm());
 
                   // The estimate is multiplied by 0.5 in order to distribute the error equally onto
                   // the two neighboring elements.
                   double central_err = 0.5 * eval_interface_estimator(error_estimators_surf[iest],
                                                                       rm, &surf_pos[isurf], neighbor_searches,
-                                                                      ns_index);
+                                                                      ns_index, current_slns);
                   double neighb_err = central_err;
 
                   // Scale the error estimate by the scaling function dependent on the element diameter
@@ -369,10 +484,9 @@ namespace Hermes
                     else
                       neighb_err *= interface_scaling_fns[i]->value(neighb->get_diameter(), element_markers_conversion.get_user_marker(neighb->marker).marker);
 
-                    errors_components[i] += central_err + neighb_err;
-                    total_error += central_err + neighb_err;
-                    this->errors[i][ee->e[i]->id] += central_err;
-                    this->errors[i][neighb->id] += neighb_err;
+                    current_errors_components[i] += central_err + neighb_err;
+                    current_errors[i][ee->e[i]->id] += central_err;
+                    current_errors[i][neighb->id] += neighb_err;
                   }
                   else
                     err += central_err;
@@ -381,7 +495,7 @@ namespace Hermes
 
                   // Clear the transformations from the RefMaps and all functions.
                   for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
-                    fns[fns_i]->set_transform(neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq)->original_central_el_transform);
+                    current_fns[fns_i]->set_transform(neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq)->original_central_el_transform);
 
                   rm->set_transform(neighbor_searches.get(ns_index)->original_central_el_transform);
 
@@ -404,20 +518,72 @@ namespace Hermes
           }
 
           if(calc_norm)
-          {
-            double nrm = eval_solution_norm(this->norm_form[i][i], rm, this->sln[i]);
-            norms[i] += nrm;
-            total_norm += nrm;
-          }
+            current_norms[i] += eval_solution_norm(this->norm_form[i][i], rm, current_slns[i]);
 
-          errors_components[i] += err;
-          total_error += err;
-          this->errors[i][ee->e[i]->id] += err;
+          current_errors_components[i] += err;
+          current_errors[i][ee->e[i]->id] += err;
+        }
 
-          ee->e[i]->visited = true;
         }
+        catch(Hermes::Exceptions::Exception& exception)
+        {
+          if(this->caughtException == NULL)
+            this->caughtException = exception.clone();
+        }
+        catch(std::exception& exception)
+        {
+          if(this->caughtException == NULL)
+            this->caughtException = new Hermes::Exceptions::Exception(exception.what());
+        }
+      }
+      }
+
+      // Combine the per-thread results.
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        for (int i = 0; i < this->num; i++)
+        {
+          if(calc_norm)
+            norms[i] += norms_threads[thread * this->num + i];
+          errors_components[i] += errors_components_threads[thread * this->num + i];
+          int max = meshes[i]->get_max_element_id();
+          for(int id = 0; id < max; id++)
+            this->errors[i][id] += errors_threads[thread][i][id];
+        }
+      }
+      for (int i = 0; i < this->num; i++)
+      {
+        if(calc_norm)
+          total_norm += norms[i];
+        total_error += errors_components[i];
       }
-      trav.finish();
+
+      if(calc_norm)
+        delete [] norms_threads;
+      delete [] errors_components_threads;
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        for (int i = 0; i < this->num; i++)
+          delete [] errors_threads[thread][i];
+        delete [] errors_threads[thread];
+      }
+      delete [] errors_threads;
+
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        for (int j = 0; j < this->num; j++)
+          delete slns_cloned[thread][j];
+        delete [] slns_cloned[thread];
+        delete [] fns_cloned[thread];
+      }
+      delete [] slns_cloned;
+      delete [] fns_cloned;
+      delete [] adjacencies;
+
+      Traverse::free_states(states, num_states);
+
+      if(this->caughtException != NULL)
+        throw *(this->caughtException);
 
       // Store the calculation for each solution component separately.
       if(component_errors != NULL)
@@ -527,14 +693,14 @@ namespace Hermes
 
     template<typename Scalar>
     double KellyTypeAdapt<Scalar>::eval_volumetric_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                             RefMap *rm)
+                                                             RefMap *rm, Solution<Scalar>** current_slns)
     {
       // Determine the integration order.
-      int inc = (this->sln[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
+      int inc = (current_slns[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
 
       Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[this->num];
       for (int i = 0; i < this->num; i++)
-        oi[i] = init_fn_ord(this->sln[i]->get_fn_order() + inc);
+        oi[i] = init_fn_ord(current_slns[i]->get_fn_order() + inc);
 
       // Polynomial order of additional external functions.
       Func<Hermes::Ord>** fake_ext_fn = new Func<Hermes::Ord>*[err_est_form->ext.size()];
@@ -568,7 +734,7 @@ namespace Hermes
       delete [] fake_ext_fn;
 
       // eval the form
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
+      Quad2D* quad = current_slns[err_est_form->i]->get_quad_2d();
       double3* pt = quad->get_points(order, rm->get_active_element()->get_mode());
       int np = quad->get_num_points(order, rm->get_active_element()->get_mode());
 
@@ -583,7 +749,7 @@ namespace Hermes
       Func<Scalar>** ui = new Func<Scalar>*[this->num];
 
       for (int i = 0; i < this->num; i++)
-        ui[i] = init_fn(this->sln[i], order);
+        ui[i] = init_fn(current_slns[i], order);
 
       Func<Scalar>** ext_fn = new Func<Scalar>*[err_est_form->ext.size()];
       for (unsigned i = 0; i < err_est_form->ext.size(); i++)
@@ -622,13 +788,13 @@ namespace Hermes
 
     template<typename Scalar>
     double KellyTypeAdapt<Scalar>::eval_boundary_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                           RefMap *rm, SurfPos* surf_pos)
+                                                           RefMap *rm, SurfPos* surf_pos, Solution<Scalar>** current_slns)
     {
       // Determine the integration order.
-      int inc = (this->sln[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
+      int inc = (current_slns[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
       Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[this->num];
       for (int i = 0; i < this->num; i++)
-        oi[i] = init_fn_ord(this->sln[i]->get_edge_fn_order(surf_pos->surf_num) + inc);
+        oi[i] = init_fn_ord(current_slns[i]->get_edge_fn_order(surf_pos->surf_num) + inc);
 
       // Polynomial order of additional external functions.
       Func<Hermes::Ord>** fake_ext_fn = new Func<Hermes::Ord>*[err_est_form->ext.size()];
@@ -644,6 +810,14 @@ namespace Hermes
 
       limit_order(order, rm->get_active_element()->get_mode());
 
+      // User-requested cap for this boundary marker.
+      if(!boundary_marker_order_limits.empty())
+      {
+        std::map<int, int>::const_iterator cap = boundary_marker_order_limits.find(surf_pos->marker);
+        if(cap != boundary_marker_order_limits.end() && order > cap->second)
+          order = cap->second;
+      }
+
       // Clean up.
       for (int i = 0; i < this->num; i++)
         if(oi[i] != NULL)
@@ -659,7 +833,7 @@ namespace Hermes
       delete [] fake_ext_fn;
 
       // Evaluate the form.
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
+      Quad2D* quad = current_slns[err_est_form->i]->get_quad_2d();
       int eo = quad->get_edge_points(surf_pos->surf_num, order, rm->get_active_element()->get_mode());
       double3* pt = quad->get_points(eo, rm->get_active_element()->get_mode());
       int np = quad->get_num_points(eo, rm->get_active_element()->get_mode());
@@ -674,7 +848,7 @@ namespace Hermes
       // Function values
       Func<Scalar>** ui = new Func<Scalar>*[this->num];
       for (int i = 0; i < this->num; i++)
-        ui[i] = init_fn(this->sln[i], eo);
+        ui[i] = init_fn(current_slns[i], eo);
 
       Func<Scalar>** ext_fn = new Func<Scalar>*[err_est_form->ext.size()];
       for (unsigned i = 0; i < err_est_form->ext.size(); i++)
@@ -716,12 +890,12 @@ namespace Hermes
     double KellyTypeAdapt<Scalar>::eval_interface_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
                                                             RefMap *rm, SurfPos* surf_pos,
                                                             LightArray<NeighborSearch<Scalar>*>& neighbor_searches,
-                                                            int neighbor_index)
+                                                            int neighbor_index, Solution<Scalar>** current_slns)
     {
       NeighborSearch<Scalar>* nbs = neighbor_searches.get(neighbor_index);
       Hermes::vector<MeshFunction<Scalar>*> slns;
       for (int i = 0; i < this->num; i++)
-        slns.push_back(this->sln[i]);
+        slns.push_back(current_slns[i]);
 
       // Determine integration order.
       Func<Hermes::Ord>** fake_ext_fns = new Func<Hermes::Ord>*[err_est_form->ext.size()];
@@ -745,6 +919,34 @@ namespace Hermes
 
       limit_order(order, rm->get_active_element()->get_mode());
 
+      // Equal polynomial order on both sides of a straight interface: the integrand
+      // is a polynomial of exactly the order the form reported, the padding added
+      // for the inverse reference map is not needed.
+      if(interface_order_reduction
+        && !rm->get_active_element()->is_curved() && !nbs->neighb_el->is_curved()
+        && this->spaces[err_est_form->i]->get_element_order(rm->get_active_element()->id)
+           == this->spaces[err_est_form->i]->get_element_order(nbs->neighb_el->id))
+      {
+        int reduced = o.get_order();
+        limit_order(reduced, rm->get_active_element()->get_mode());
+        if(reduced < order)
+          order = reduced;
+      }
+
+      // User-requested cap, only applied when the elements on both sides belong
+      // to a capped material marker - material interfaces keep the full order.
+      if(!element_marker_order_limits.empty())
+      {
+        std::map<int, int>::const_iterator central_cap = element_marker_order_limits.find(rm->get_active_element()->marker);
+        std::map<int, int>::const_iterator neighb_cap = element_marker_order_limits.find(nbs->neighb_el->marker);
+        if(central_cap != element_marker_order_limits.end() && neighb_cap != element_marker_order_limits.end())
+        {
+          int cap = std::max(central_cap->second, neighb_cap->second);
+          if(order > cap)
+            order = cap;
+        }
+      }
+
       // Clean up.
       for (int i = 0; i < this->num; i++)
       {
@@ -758,7 +960,7 @@ namespace Hermes
 
       //delete fake_ext;
 
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
+      Quad2D* quad = current_slns[err_est_form->i]->get_quad_2d();
       int eo = quad->get_edge_points(surf_pos->surf_num, order, rm->get_active_element()->get_mode());
       int np = quad->get_num_points(eo, rm->get_active_element()->get_mode());
       double3* pt = quad->get_points(eo, rm->get_active_element()->get_mode());
@@ -19,14 +19,27 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    template<typename Scalar>
+    const unsigned int AsmList<Scalar>::inline_cap;
+
     template<typename Scalar>
     AsmList<Scalar>::AsmList(const AsmList<Scalar> & other)
     {
       this->cnt = other.cnt;
-      this->cap = other.cap;
-      this->idx = (int*) malloc(sizeof(int) * cap);
-      this->dof = (int*) malloc(sizeof(int) * cap);
-      this->coef = (Scalar*) malloc(sizeof(Scalar) * cap);
+      if(cnt <= inline_cap)
+      {
+        this->cap = inline_cap;
+        this->idx = idx_buf;
+        this->dof = dof_buf;
+        this->coef = coef_buf;
+      }
+      else
+      {
+        this->cap = other.cap;
+        this->idx = (int*) malloc(sizeof(int) * cap);
+        this->dof = (int*) malloc(sizeof(int) * cap);
+        this->coef = (Scalar*) malloc(sizeof(Scalar) * cap);
+      }
       for(unsigned int i = 0; i < cnt; i++) {
         coef[i] = other.coef[i];
         dof[i] = other.dof[i];
@@ -38,18 +51,21 @@ namespace Hermes
     AsmList<Scalar>::AsmList()
     {
       cnt = 0;
-      cap = 128;
-      idx = (int*) malloc(sizeof(int) * cap);
-      dof = (int*) malloc(sizeof(int) * cap);
-      coef = (Scalar*) malloc(sizeof(Scalar) * cap);
+      cap = inline_cap;
+      idx = idx_buf;
+      dof = dof_buf;
+      coef = coef_buf;
     }
 
     template<typename Scalar>
     AsmList<Scalar>::~AsmList()
     {
-      free(idx);
-      free(dof);
-      free(coef);
+      if(idx != idx_buf)
+      {
+        free(idx);
+        free(dof);
+        free(coef);
+      }
     }
 
     template<typename Scalar>
@@ -89,10 +105,25 @@ namespace Hermes
     template<typename Scalar>
     void AsmList<Scalar>::enlarge()
     {
-      cap = !cap ? 128 : cap * 2;
-      idx = (int*) realloc(idx, sizeof(int) * cap);
-      dof = (int*) realloc(dof, sizeof(int) * cap);
-      coef = (Scalar*) realloc(coef, sizeof(Scalar) * cap);
+      cap = !cap ? inline_cap : cap * 2;
+      if(idx == idx_buf)
+      {
+        // the list outgrew the inline storage - move it to the heap
+        idx = (int*) malloc(sizeof(int) * cap);
+        dof = (int*) malloc(sizeof(int) * cap);
+        coef = (Scalar*) malloc(sizeof(Scalar) * cap);
+        for(unsigned int i = 0; i < cnt; i++) {
+          idx[i] = idx_buf[i];
+          dof[i] = dof_buf[i];
+          coef[i] = coef_buf[i];
+        }
+      }
+      else
+      {
+        idx = (int*) realloc(idx, sizeof(int) * cap);
+        dof = (int*) realloc(dof, sizeof(int) * cap);
+        coef = (Scalar*) realloc(coef, sizeof(Scalar) * cap);
+      }
     }
 
     template HERMES_API class AsmList<double>;
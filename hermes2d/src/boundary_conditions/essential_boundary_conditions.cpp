@@ -28,6 +28,7 @@ namespace Hermes
     {
       current_time = 0.0;
       value_const = 0.0;
+      time_invariant = false;
     }
 
     template<typename Scalar>
@@ -36,6 +37,7 @@ namespace Hermes
       markers.push_back(marker);
       current_time = 0.0;
       value_const = 0.0;
+      time_invariant = false;
     }
 
     template<typename Scalar>
@@ -55,10 +57,23 @@ namespace Hermes
       return current_time;
     }
 
+    template<typename Scalar>
+    void EssentialBoundaryCondition<Scalar>::set_time_invariant(bool to_set)
+    {
+      this->time_invariant = to_set;
+    }
+
+    template<typename Scalar>
+    bool EssentialBoundaryCondition<Scalar>::is_time_invariant() const
+    {
+      return time_invariant;
+    }
+
     template<typename Scalar>
     DefaultEssentialBCConst<Scalar>::DefaultEssentialBCConst(Hermes::vector<std::string> markers, Scalar value_const) : EssentialBoundaryCondition<Scalar>(markers)
     {
       this->value_const = value_const;
+      this->time_invariant = true;
     }
 
     template<typename Scalar>
@@ -66,6 +81,7 @@ namespace Hermes
     {
       this->value_const = value_const;
       this->markers.push_back(marker);
+      this->time_invariant = true;
     }
 
     template<typename Scalar>
@@ -15,6 +15,7 @@
 
 #include "calculation_continuity.h"
 #include "mesh_reader_h2d_xml.h"
+#include "mesh_reader_h2d_bin.h"
 #include "space_h1.h"
 #include "space_hdiv.h"
 #include "space_hcurl.h"
@@ -100,7 +101,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    CalculationContinuity<Scalar>::CalculationContinuity(IdentificationMethod identification_method) : last_record(NULL), record_available(false), identification_method(identification_method), num(0)
+    CalculationContinuity<Scalar>::CalculationContinuity(IdentificationMethod identification_method) : last_record(NULL), record_available(false), identification_method(identification_method), num(0), writer_running(false), writer_task(NULL)
     {
       double last_time;
       unsigned int last_number;
@@ -163,6 +164,114 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    CalculationContinuity<Scalar>::~CalculationContinuity()
+    {
+      try
+      {
+        this->wait_for_last_record();
+      }
+      catch(Hermes::Exceptions::Exception& e)
+      {
+        // the destructor must not throw, printing is the last chance to report the failure
+        e.print_msg();
+      }
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::start_writer(Record* record, Hermes::vector<Mesh*> meshes, Hermes::vector<Solution<Scalar>*> slns, double time_step, double time_step_n_minus_one, double error)
+    {
+      WriterTask* task = new WriterTask;
+      task->record = record;
+      task->time_step = time_step;
+      task->time_step_n_minus_one = time_step_n_minus_one;
+      task->error = error;
+      task->failed = false;
+
+      // The staging copies: Mesh::copy() for the meshes, Solution::copy() for the
+      // solutions - the latter duplicates just the coefficient and order arrays,
+      // which is all the save routines read.
+      for(unsigned int i = 0; i < meshes.size(); i++)
+      {
+        Mesh* mesh_copy = new Mesh;
+        mesh_copy->copy(meshes[i]);
+        task->meshes.push_back(mesh_copy);
+      }
+      for(unsigned int i = 0; i < slns.size(); i++)
+      {
+        Solution<Scalar>* sln_copy = new Solution<Scalar>;
+        sln_copy->copy(slns[i]);
+        task->solutions.push_back(sln_copy);
+      }
+
+      this->writer_task = task;
+      if(pthread_create(&this->writer_thread, NULL, &CalculationContinuity<Scalar>::writer_thread_func, this) == 0)
+        this->writer_running = true;
+      else
+        // could not spawn the thread, write on the calling thread instead; the
+        // handshake in wait_for_last_record() still cleans up and re-throws
+        writer_thread_func(this);
+    }
+
+    template<typename Scalar>
+    void* CalculationContinuity<Scalar>::writer_thread_func(void* continuity)
+    {
+      CalculationContinuity<Scalar>* cont = static_cast<CalculationContinuity<Scalar>*>(continuity);
+      WriterTask* task = cont->writer_task;
+      try
+      {
+        task->record->save_meshes(task->meshes);
+        if(task->solutions != Hermes::vector<Solution<Scalar>*>())
+          task->record->save_solutions(task->solutions);
+        if(task->time_step > 0.0)
+          task->record->save_time_step_length(task->time_step);
+        if(task->time_step_n_minus_one > 0.0)
+          task->record->save_time_step_length_n_minus_one(task->time_step_n_minus_one);
+        if(task->error > 0.0)
+          task->record->save_error(task->error);
+      }
+      catch(std::exception& e)
+      {
+        task->failed = true;
+        task->error_message = e.what();
+      }
+      catch(...)
+      {
+        task->failed = true;
+        task->error_message = "unknown exception in the background record writer";
+      }
+      return NULL;
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::wait_for_last_record()
+    {
+      if(this->writer_task == NULL)
+        return;
+
+      if(this->writer_running)
+      {
+        pthread_join(this->writer_thread, NULL);
+        this->writer_running = false;
+      }
+
+      WriterTask* task = this->writer_task;
+      this->writer_task = NULL;
+
+      for(unsigned int i = 0; i < task->solutions.size(); i++)
+        delete task->solutions[i];
+      for(unsigned int i = 0; i < task->meshes.size(); i++)
+        delete task->meshes[i];
+
+      if(task->failed)
+      {
+        CalculationContinuityException exception(CalculationContinuityException::general, task->error_message.c_str());
+        delete task;
+        throw exception;
+      }
+      delete task;
+    }
+
     template<typename Scalar>
     void CalculationContinuity<Scalar>::add_record(double time, unsigned int number, Mesh* mesh, Space<Scalar>* space, Solution<Scalar>* sln, double time_step, double time_step_n_minus_one, double error)
     {
@@ -176,17 +285,32 @@ namespace Hermes
         throw IOCalculationContinuityException(CalculationContinuityException::general, IOCalculationContinuityException::output, "timeAndNumber.h2d");
 
       CalculationContinuity<Scalar>::Record* record = new CalculationContinuity<Scalar>::Record(time, number);
-      record->save_mesh(mesh);
-      if(space != NULL)
-        record->save_space(space);
-      if(sln != NULL)
-        record->save_solution(sln);
-      if(time_step > 0.0)
-        record->save_time_step_length(time_step);
-      if(time_step_n_minus_one > 0.0)
-        record->save_time_step_length_n_minus_one(time_step_n_minus_one);
-      if(error > 0.0)
-        record->save_error(error);
+      if(asynchronous_saving)
+      {
+        this->wait_for_last_record();
+        if(space != NULL)
+          record->save_space(space);
+        Hermes::vector<Mesh*> meshes_to_stage;
+        meshes_to_stage.push_back(mesh);
+        Hermes::vector<Solution<Scalar>*> slns_to_stage;
+        if(sln != NULL)
+          slns_to_stage.push_back(sln);
+        this->start_writer(record, meshes_to_stage, slns_to_stage, time_step, time_step_n_minus_one, error);
+      }
+      else
+      {
+        record->save_mesh(mesh);
+        if(space != NULL)
+          record->save_space(space);
+        if(sln != NULL)
+          record->save_solution(sln);
+        if(time_step > 0.0)
+          record->save_time_step_length(time_step);
+        if(time_step_n_minus_one > 0.0)
+          record->save_time_step_length_n_minus_one(time_step_n_minus_one);
+        if(error > 0.0)
+          record->save_error(error);
+      }
 
       this->records.insert(std::pair<std::pair<double, unsigned int>, CalculationContinuity<Scalar>::Record*>(std::pair<double, unsigned int>(time, number), record));
       this->last_record = record;
@@ -205,17 +329,27 @@ namespace Hermes
         throw IOCalculationContinuityException(CalculationContinuityException::general, IOCalculationContinuityException::output, "timeAndNumber.h2d");
 
       CalculationContinuity<Scalar>::Record* record = new CalculationContinuity<Scalar>::Record(time, number);
-      record->save_meshes(meshes);
-      if(spaces != Hermes::vector<Space<Scalar>*>())
-        record->save_spaces(spaces);
-      if(slns != Hermes::vector<Solution<Scalar>*>())
-        record->save_solutions(slns);
-      if(time_step > 0.0)
-        record->save_time_step_length(time_step);
-      if(time_step_n_minus_one > 0.0)
-        record->save_time_step_length_n_minus_one(time_step_n_minus_one);
-      if(error > 0.0)
-        record->save_error(error);
+      if(asynchronous_saving)
+      {
+        this->wait_for_last_record();
+        if(spaces != Hermes::vector<Space<Scalar>*>())
+          record->save_spaces(spaces);
+        this->start_writer(record, meshes, slns, time_step, time_step_n_minus_one, error);
+      }
+      else
+      {
+        record->save_meshes(meshes);
+        if(spaces != Hermes::vector<Space<Scalar>*>())
+          record->save_spaces(spaces);
+        if(slns != Hermes::vector<Solution<Scalar>*>())
+          record->save_solutions(slns);
+        if(time_step > 0.0)
+          record->save_time_step_length(time_step);
+        if(time_step_n_minus_one > 0.0)
+          record->save_time_step_length_n_minus_one(time_step_n_minus_one);
+        if(error > 0.0)
+          record->save_error(error);
+      }
 
       this->records.insert(std::pair<std::pair<double, unsigned int>, CalculationContinuity<Scalar>::Record*>(std::pair<double, unsigned int>(time, number), record));
       this->last_record = record;
@@ -234,17 +368,32 @@ namespace Hermes
         throw IOCalculationContinuityException(CalculationContinuityException::general, IOCalculationContinuityException::output, "onlyTime.h2d");
 
       CalculationContinuity<Scalar>::Record* record = new CalculationContinuity<Scalar>::Record(time);
-      record->save_mesh(mesh);
-      if(space != NULL)
-        record->save_space(space);
-      if(sln != NULL)
-        record->save_solution(sln);
-      if(time_step > 0.0)
-        record->save_time_step_length(time_step);
-      if(time_step_n_minus_one > 0.0)
-        record->save_time_step_length_n_minus_one(time_step_n_minus_one);
-      if(error > 0.0)
-        record->save_error(error);
+      if(asynchronous_saving)
+      {
+        this->wait_for_last_record();
+        if(space != NULL)
+          record->save_space(space);
+        Hermes::vector<Mesh*> meshes_to_stage;
+        meshes_to_stage.push_back(mesh);
+        Hermes::vector<Solution<Scalar>*> slns_to_stage;
+        if(sln != NULL)
+          slns_to_stage.push_back(sln);
+        this->start_writer(record, meshes_to_stage, slns_to_stage, time_step, time_step_n_minus_one, error);
+      }
+      else
+      {
+        record->save_mesh(mesh);
+        if(space != NULL)
+          record->save_space(space);
+        if(sln != NULL)
+          record->save_solution(sln);
+        if(time_step > 0.0)
+          record->save_time_step_length(time_step);
+        if(time_step_n_minus_one > 0.0)
+          record->save_time_step_length_n_minus_one(time_step_n_minus_one);
+        if(error > 0.0)
+          record->save_error(error);
+      }
 
       this->time_records.insert(std::pair<double, CalculationContinuity<Scalar>::Record*>(time, record));
       this->last_record = record;
@@ -262,17 +411,27 @@ namespace Hermes
       else
         throw IOCalculationContinuityException(CalculationContinuityException::general, IOCalculationContinuityException::output, "onlyTime.h2d");
       CalculationContinuity<Scalar>::Record* record = new CalculationContinuity<Scalar>::Record(time);
-      record->save_meshes(meshes);
-      if(spaces != Hermes::vector<Space<Scalar>*>())
-        record->save_spaces(spaces);
-      if(slns != Hermes::vector<Solution<Scalar>*>())
-        record->save_solutions(slns);
-      if(time_step > 0.0)
-        record->save_time_step_length(time_step);
-      if(time_step_n_minus_one > 0.0)
-        record->save_time_step_length_n_minus_one(time_step_n_minus_one);
-      if(error > 0.0)
-        record->save_error(error);
+      if(asynchronous_saving)
+      {
+        this->wait_for_last_record();
+        if(spaces != Hermes::vector<Space<Scalar>*>())
+          record->save_spaces(spaces);
+        this->start_writer(record, meshes, slns, time_step, time_step_n_minus_one, error);
+      }
+      else
+      {
+        record->save_meshes(meshes);
+        if(spaces != Hermes::vector<Space<Scalar>*>())
+          record->save_spaces(spaces);
+        if(slns != Hermes::vector<Solution<Scalar>*>())
+          record->save_solutions(slns);
+        if(time_step > 0.0)
+          record->save_time_step_length(time_step);
+        if(time_step_n_minus_one > 0.0)
+          record->save_time_step_length_n_minus_one(time_step_n_minus_one);
+        if(error > 0.0)
+          record->save_error(error);
+      }
       this->time_records.insert(std::pair<double, CalculationContinuity<Scalar>::Record*>(time, record));
       this->last_record = record;
     }
@@ -290,17 +449,32 @@ namespace Hermes
         throw IOCalculationContinuityException(CalculationContinuityException::general, IOCalculationContinuityException::output, "onlyNumber.h2d");
 
       CalculationContinuity<Scalar>::Record* record = new CalculationContinuity<Scalar>::Record(number);
-      record->save_mesh(mesh);
-      if(space != NULL)
-        record->save_space(space);
-      if(sln != NULL)
-        record->save_solution(sln);
-      if(time_step > 0.0)
-        record->save_time_step_length(time_step);
-      if(time_step_n_minus_one > 0.0)
-        record->save_time_step_length_n_minus_one(time_step_n_minus_one);
-      if(error > 0.0)
-        record->save_error(error);
+      if(asynchronous_saving)
+      {
+        this->wait_for_last_record();
+        if(space != NULL)
+          record->save_space(space);
+        Hermes::vector<Mesh*> meshes_to_stage;
+        meshes_to_stage.push_back(mesh);
+        Hermes::vector<Solution<Scalar>*> slns_to_stage;
+        if(sln != NULL)
+          slns_to_stage.push_back(sln);
+        this->start_writer(record, meshes_to_stage, slns_to_stage, time_step, time_step_n_minus_one, error);
+      }
+      else
+      {
+        record->save_mesh(mesh);
+        if(space != NULL)
+          record->save_space(space);
+        if(sln != NULL)
+          record->save_solution(sln);
+        if(time_step > 0.0)
+          record->save_time_step_length(time_step);
+        if(time_step_n_minus_one > 0.0)
+          record->save_time_step_length_n_minus_one(time_step_n_minus_one);
+        if(error > 0.0)
+          record->save_error(error);
+      }
 
       this->numbered_records.insert(std::pair<unsigned int, CalculationContinuity<Scalar>::Record*>(number, record));
       this->last_record = record;
@@ -319,17 +493,27 @@ namespace Hermes
         throw IOCalculationContinuityException(CalculationContinuityException::general, IOCalculationContinuityException::output, "onlyNumber.h2d");
 
       CalculationContinuity<Scalar>::Record* record = new CalculationContinuity<Scalar>::Record(number);
-      record->save_meshes(meshes);
-      if(spaces != Hermes::vector<Space<Scalar>*>())
-        record->save_spaces(spaces);
-      if(slns != Hermes::vector<Solution<Scalar>*>())
-        record->save_solutions(slns);
-      if(time_step > 0.0)
-        record->save_time_step_length(time_step);
-      if(time_step_n_minus_one > 0.0)
-        record->save_time_step_length_n_minus_one(time_step_n_minus_one);
-      if(error > 0.0)
-        record->save_error(error);
+      if(asynchronous_saving)
+      {
+        this->wait_for_last_record();
+        if(spaces != Hermes::vector<Space<Scalar>*>())
+          record->save_spaces(spaces);
+        this->start_writer(record, meshes, slns, time_step, time_step_n_minus_one, error);
+      }
+      else
+      {
+        record->save_meshes(meshes);
+        if(spaces != Hermes::vector<Space<Scalar>*>())
+          record->save_spaces(spaces);
+        if(slns != Hermes::vector<Solution<Scalar>*>())
+          record->save_solutions(slns);
+        if(time_step > 0.0)
+          record->save_time_step_length(time_step);
+        if(time_step_n_minus_one > 0.0)
+          record->save_time_step_length_n_minus_one(time_step_n_minus_one);
+        if(error > 0.0)
+          record->save_error(error);
+      }
       this->numbered_records.insert(std::pair<unsigned int, CalculationContinuity<Scalar>::Record*>(number, record));
       this->last_record = record;
     }
@@ -373,14 +557,18 @@ namespace Hermes
     template<typename Scalar>
     void CalculationContinuity<Scalar>::Record::save_meshes(Hermes::vector<Mesh*> meshes)
     {
-      MeshReaderH2DXML reader;
+      MeshReaderH2DXML xml_reader;
+      MeshReaderH2DBin bin_reader;
       for(unsigned int i = 0; i < meshes.size(); i++)
       {
         std::stringstream filename;
         filename << CalculationContinuity<Scalar>::mesh_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          reader.save(filename.str().c_str(), meshes[i]);
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+            bin_reader.save(filename.str().c_str(), meshes[i]);
+          else
+            xml_reader.save(filename.str().c_str(), meshes[i]);
         }
         catch(std::exception& e)
         {
@@ -391,12 +579,20 @@ namespace Hermes
     template<typename Scalar>
     void CalculationContinuity<Scalar>::Record::save_mesh(Mesh* mesh)
     {
-      MeshReaderH2DXML reader;
       std::stringstream filename;
       filename << CalculationContinuity<Scalar>::mesh_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        reader.save(filename.str().c_str(), mesh);
+        if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+        {
+          MeshReaderH2DBin reader;
+          reader.save(filename.str().c_str(), mesh);
+        }
+        else
+        {
+          MeshReaderH2DXML reader;
+          reader.save(filename.str().c_str(), mesh);
+        }
       }
       catch(std::exception& e)
       {
@@ -413,7 +609,13 @@ namespace Hermes
         filename << CalculationContinuity<Scalar>::space_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          spaces[i]->save(filename.str().c_str());
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+          {
+            if(!spaces[i]->save_bin(filename.str().c_str()))
+              throw IOCalculationContinuityException(CalculationContinuityException::spaces, IOCalculationContinuityException::output, filename.str().c_str());
+          }
+          else
+            spaces[i]->save(filename.str().c_str());
         }
         catch(std::exception& e)
         {
@@ -429,7 +631,13 @@ namespace Hermes
       filename << CalculationContinuity<Scalar>::space_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        space->save(filename.str().c_str());
+        if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+        {
+          if(!space->save_bin(filename.str().c_str()))
+            throw IOCalculationContinuityException(CalculationContinuityException::spaces, IOCalculationContinuityException::output, filename.str().c_str());
+        }
+        else
+          space->save(filename.str().c_str());
       }
       catch(std::exception& e)
       {
@@ -447,7 +655,10 @@ namespace Hermes
 
         try
         {
-          solutions[i]->save(filename.str().c_str());
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+            solutions[i]->save_bin(filename.str().c_str());
+          else
+            solutions[i]->save(filename.str().c_str());
         }
         catch(Hermes::Exceptions::SolutionSaveFailureException& e)
         {
@@ -462,7 +673,10 @@ namespace Hermes
       filename << CalculationContinuity<Scalar>::solution_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        solution->save(filename.str().c_str());
+        if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+          solution->save_bin(filename.str().c_str());
+        else
+          solution->save(filename.str().c_str());
       }
       catch(Hermes::Exceptions::SolutionSaveFailureException& e)
       {
@@ -524,14 +738,18 @@ namespace Hermes
     template<typename Scalar>
     void CalculationContinuity<Scalar>::Record::load_meshes(Hermes::vector<Mesh*> meshes)
     {
-      MeshReaderH2DXML reader;
+      MeshReaderH2DXML xml_reader;
+      MeshReaderH2DBin bin_reader;
       for(unsigned int i = 0; i < meshes.size(); i++)
       {
         std::stringstream filename;
         filename << CalculationContinuity<Scalar>::mesh_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          reader.load(filename.str().c_str(), meshes[i]);
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+            bin_reader.load(filename.str().c_str(), meshes[i]);
+          else
+            xml_reader.load(filename.str().c_str(), meshes[i]);
         }
         catch(Hermes::Exceptions::MeshLoadFailureException& e)
         {
@@ -542,13 +760,21 @@ namespace Hermes
     template<typename Scalar>
     void CalculationContinuity<Scalar>::Record::load_mesh(Mesh* mesh)
     {
-      MeshReaderH2DXML reader;
       std::stringstream filename;
       filename << CalculationContinuity<Scalar>::mesh_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
 
       try
       {
-        reader.load(filename.str().c_str(), mesh);
+        if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+        {
+          MeshReaderH2DBin reader;
+          reader.load(filename.str().c_str(), mesh);
+        }
+        else
+        {
+          MeshReaderH2DXML reader;
+          reader.load(filename.str().c_str(), mesh);
+        }
       }
       catch(Hermes::Exceptions::MeshLoadFailureException& e)
       {
@@ -572,7 +798,10 @@ namespace Hermes
 
         try
         {
-          spaces.push_back(Space<Scalar>::load(filename.str().c_str(), meshes[i], false, essential_bcs[i], shapesets[i]));
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+            spaces.push_back(Space<Scalar>::load_bin(filename.str().c_str(), meshes[i], essential_bcs[i], shapesets[i]));
+          else
+            spaces.push_back(Space<Scalar>::load(filename.str().c_str(), meshes[i], false, essential_bcs[i], shapesets[i]));
         }
         catch(Hermes::Exceptions::SpaceLoadFailureException& e)
         {
@@ -603,7 +832,10 @@ namespace Hermes
 
         try
         {
-          spaces.push_back(Space<Scalar>::load(filename.str().c_str(), meshes[i], false, NULL, shapesets[i]));
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+            spaces.push_back(Space<Scalar>::load_bin(filename.str().c_str(), meshes[i], NULL, shapesets[i]));
+          else
+            spaces.push_back(Space<Scalar>::load(filename.str().c_str(), meshes[i], false, NULL, shapesets[i]));
         }
         catch(Hermes::Exceptions::SpaceLoadFailureException& e)
         {
@@ -626,7 +858,10 @@ namespace Hermes
 
       try
       {
-        return Space<Scalar>::load(filename.str().c_str(), mesh, false, essential_bcs, shapeset);
+        if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+          return Space<Scalar>::load_bin(filename.str().c_str(), mesh, essential_bcs, shapeset);
+        else
+          return Space<Scalar>::load(filename.str().c_str(), mesh, false, essential_bcs, shapeset);
       }
       catch(Hermes::Exceptions::SpaceLoadFailureException& e)
       {
@@ -649,7 +884,10 @@ namespace Hermes
         filename << CalculationContinuity<Scalar>::solution_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          solutions[i]->load(filename.str().c_str(), spaces[i]);
+          if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+            solutions[i]->load_bin(filename.str().c_str(), spaces[i]);
+          else
+            solutions[i]->load(filename.str().c_str(), spaces[i]);
           solutions[i]->space_type = spaces[i]->get_type();
         }
         catch(Hermes::Exceptions::SolutionLoadFailureException& e)
@@ -669,7 +907,10 @@ namespace Hermes
       filename << CalculationContinuity<Scalar>::solution_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        solution->load(filename.str().c_str(), space);
+        if(CalculationContinuity<Scalar>::record_file_format == fileFormatBinary)
+          solution->load_bin(filename.str().c_str(), space);
+        else
+          solution->load(filename.str().c_str(), space);
         solution->space_type = space->get_type();
       }
       catch(Hermes::Exceptions::SolutionLoadFailureException& e)
@@ -745,6 +986,12 @@ namespace Hermes
       return this->number;
     }
 
+    template<typename Scalar>
+    typename CalculationContinuity<Scalar>::RecordFileFormat CalculationContinuity<Scalar>::record_file_format = CalculationContinuity<Scalar>::fileFormatXML;
+
+    template<typename Scalar>
+    bool CalculationContinuity<Scalar>::asynchronous_saving = false;
+
     template<typename Scalar>
     std::string CalculationContinuity<Scalar>::mesh_file_name = "Mesh-";
 
@@ -762,6 +1009,16 @@ namespace Hermes
     template<typename Scalar>
     std::string CalculationContinuity<Scalar>::error_file_name = "Error_";
 
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::set_record_file_format(RecordFileFormat record_file_formatToSet)
+    {
+      record_file_format = record_file_formatToSet;
+    }
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::set_asynchronous_saving(bool to_set)
+    {
+      asynchronous_saving = to_set;
+    }
     template<typename Scalar>
     void CalculationContinuity<Scalar>::set_mesh_file_name(std::string mesh_file_nameToSet)
     {
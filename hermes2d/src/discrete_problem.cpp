@@ -18,6 +18,7 @@
 
 #include "discrete_problem.h"
 #include "function/exact_solution.h"
+#include "instrumentation.h"
 #include <algorithm>
 #include <map>
 #include <string>
@@ -46,7 +47,7 @@ namespace Hermes
     double DiscreteProblem<Scalar>::fake_wt = 1.0;
 
     template<typename Scalar>
-    DiscreteProblem<Scalar>::DiscreteProblem(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces) : Hermes::Solvers::DiscreteProblemInterface<Scalar>(), wf(wf)
+    DiscreteProblem<Scalar>::DiscreteProblem(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces) : Hermes::Solvers::DiscreteProblemInterface<Scalar>(), wf(wf), traverse_master(true)
     {
       if(spaces.empty())
         throw Exceptions::NullException(2);
@@ -62,7 +63,7 @@ namespace Hermes
 
     template<typename Scalar>
     DiscreteProblem<Scalar>::DiscreteProblem(const WeakForm<Scalar>* wf, const Space<Scalar>* space)
-      : Hermes::Solvers::DiscreteProblemInterface<Scalar>(), wf(wf)
+      : Hermes::Solvers::DiscreteProblemInterface<Scalar>(), wf(wf), traverse_master(true)
     {
       spaces.push_back(space);
       this->spaces_first_dofs.push_back(0);
@@ -71,7 +72,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    DiscreteProblem<Scalar>::DiscreteProblem() : Hermes::Solvers::DiscreteProblemInterface<Scalar>(), wf(NULL)
+    DiscreteProblem<Scalar>::DiscreteProblem() : Hermes::Solvers::DiscreteProblemInterface<Scalar>(), wf(NULL), traverse_master(true)
     {
       // Set all attributes for which we don't need to acces wf or spaces.
       // This is important for the destructor to properly detect what needs to be deallocated.
@@ -86,6 +87,8 @@ namespace Hermes
 
       // Matrix<Scalar> related settings.
       have_matrix = false;
+      reuse_matrix_structure = false;
+      structure_mat = NULL;
 
       // There is a special function that sets a DiscreteProblem to be FVM.
       // Purpose is that this constructor looks cleaner and is simpler.
@@ -102,10 +105,49 @@ namespace Hermes
       current_rhs = NULL;
       current_block_weights = NULL;
 
+      this->use_scatter_matrices = false;
+      this->scatter_mat = NULL;
+
+      this->deterministic_assembling = false;
+      this->scatter_rhs = NULL;
+      this->deterministic_next_chunk = 0;
+
+      this->matrix_free_apply = false;
+      this->apply_x = NULL;
+      this->apply_y = NULL;
+
+      this->incremental_assembling = false;
+      this->state_contributions = NULL;
+      this->recording_contribution = NULL;
+      this->recording_dof_pos = NULL;
 
       cache_element_stored = NULL;
 
       this->do_not_use_cache = false;
+      this->vector_only_fast_path = false;
+      this->states_cache = false;
+      this->order_cache = false;
+      this->batch_assembling = false;
+      this->adaptive_quadrature = false;
+      this->adaptive_quadrature_tolerance = 1e-12;
+      this->element_cost_accounting = false;
+      this->element_costs = NULL;
+      this->element_costs_size = 0;
+      this->assembling_deadline = 0.0;
+      this->deadline_states = NULL;
+      this->deadline_num_states = 0;
+      this->deadline_resume_pending = false;
+      this->local_stiffness_scratch = NULL;
+      this->local_stiffness_scratch_size = NULL;
+
+      this->u_ext_pooling = false;
+      this->u_ext_pool = NULL;
+
+      this->split_assembling = false;
+      this->split_assembling_pass = 0;
+      this->split_linear_mat = NULL;
+      this->split_linear_rhs = NULL;
+      this->split_linear_time = 0.0;
 
       this->spaces_size = 0;
 
@@ -158,6 +200,8 @@ namespace Hermes
 
       // Matrix<Scalar> related settings.
       have_matrix = false;
+      reuse_matrix_structure = false;
+      structure_mat = NULL;
 
       // There is a special function that sets a DiscreteProblem to be FVM.
       // Purpose is that this constructor looks cleaner and is simpler.
@@ -182,6 +226,21 @@ namespace Hermes
       current_rhs = NULL;
       current_block_weights = NULL;
 
+      this->use_scatter_matrices = false;
+      this->scatter_mat = NULL;
+
+      this->deterministic_assembling = false;
+      this->scatter_rhs = NULL;
+      this->deterministic_next_chunk = 0;
+
+      this->matrix_free_apply = false;
+      this->apply_x = NULL;
+      this->apply_y = NULL;
+
+      this->incremental_assembling = false;
+      this->recording_contribution = NULL;
+      this->recording_dof_pos = NULL;
+
       cache_records_sub_idx = new std::map<uint64_t, CacheRecordPerSubIdx*>**[spaces.size()];
       cache_records_element = new CacheRecordPerElement**[spaces.size()];
 
@@ -203,7 +262,34 @@ namespace Hermes
       }
       cache_element_stored = NULL;
 
+      state_contributions = (std::map<uint64_t, StateContributionRecord*>**)malloc(this->cache_size * sizeof(std::map<uint64_t, StateContributionRecord*>*));
+      memset(state_contributions, NULL, this->cache_size * sizeof(std::map<uint64_t, StateContributionRecord*>*));
+
       this->do_not_use_cache = false;
+      this->vector_only_fast_path = false;
+      this->states_cache = false;
+      this->order_cache = false;
+      this->batch_assembling = false;
+      this->adaptive_quadrature = false;
+      this->adaptive_quadrature_tolerance = 1e-12;
+      this->element_cost_accounting = false;
+      this->element_costs = NULL;
+      this->element_costs_size = 0;
+      this->assembling_deadline = 0.0;
+      this->deadline_states = NULL;
+      this->deadline_num_states = 0;
+      this->deadline_resume_pending = false;
+      this->local_stiffness_scratch = NULL;
+      this->local_stiffness_scratch_size = NULL;
+
+      this->u_ext_pooling = false;
+      this->u_ext_pool = NULL;
+
+      this->split_assembling = false;
+      this->split_assembling_pass = 0;
+      this->split_linear_mat = NULL;
+      this->split_linear_rhs = NULL;
+      this->split_linear_time = 0.0;
     }
 
     template<typename Scalar>
@@ -231,15 +317,130 @@ namespace Hermes
 
       if(sp_seq != NULL) delete [] sp_seq;
 
+      this->free_u_ext_pool();
+
+      if(this->element_costs != NULL)
+        delete [] this->element_costs;
+
+      this->invalidate_split_assembling_cache();
+
       this->delete_cache();
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::free_u_ext_pool()
+    {
+      if(u_ext_pool == NULL)
+        return;
+      for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
+      {
+        for (unsigned int j = 0; j < this->spaces_size; j++)
+          delete u_ext_pool[i][j];
+        delete [] u_ext_pool[i];
+      }
+      delete [] u_ext_pool;
+      u_ext_pool = NULL;
+      u_ext_pool_seqs.clear();
+    }
+
     template<typename Scalar>
     int DiscreteProblem<Scalar>::get_num_dofs() const
     {
       return this->ndof;
     }
 
+    template<typename Scalar>
+    double* DiscreteProblem<Scalar>::get_element_costs() const
+    {
+      return this->element_costs;
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::get_element_costs_size() const
+    {
+      return this->element_costs_size;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::assembling_complete() const
+    {
+      return this->unassembled_states.size() == 0;
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::get_num_unassembled_states() const
+    {
+      return this->unassembled_states.size();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::reset_assembling_resume()
+    {
+      this->unassembled_states.clear();
+      this->deadline_states = NULL;
+      this->deadline_num_states = 0;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::dump_element_costs_vtk(const char* filename) const
+    {
+      if(this->element_costs == NULL)
+        throw Hermes::Exceptions::Exception("No element cost map available, see set_element_cost_accounting().");
+
+      Mesh* mesh = this->spaces[0]->get_mesh();
+
+      FILE* f = fopen(filename, "wb");
+      if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
+
+      fprintf(f, "# vtk DataFile Version 2.0\n");
+      fprintf(f, "\n");
+      fprintf(f, "ASCII\n\n");
+      fprintf(f, "DATASET UNSTRUCTURED_GRID\n");
+
+      // All mesh nodes are written so that the cells can index them by their
+      // ids directly; the unused slots stay at the origin and are never
+      // referenced.
+      fprintf(f, "POINTS %d %s\n", mesh->get_max_node_id(), "float");
+      for (int i = 0; i < mesh->get_max_node_id(); i++)
+      {
+        Node* node = mesh->get_node(i);
+        if(node->used && node->type == HERMES_TYPE_VERTEX)
+          fprintf(f, "%g %g %g\n", node->x, node->y, 0.0);
+        else
+          fprintf(f, "0 0 0\n");
+      }
+
+      int cell_data_count = 0;
+      Element* e;
+      for_all_active_elements(e, mesh)
+        cell_data_count += e->get_nvert() + 1;
+
+      fprintf(f, "\n");
+      fprintf(f, "CELLS %d %d\n", mesh->get_num_active_elements(), cell_data_count);
+      for_all_active_elements(e, mesh)
+      {
+        fprintf(f, "%d", e->get_nvert());
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          fprintf(f, " %d", e->vn[i]->id);
+        fprintf(f, "\n");
+      }
+
+      fprintf(f, "\n");
+      fprintf(f, "CELL_TYPES %d\n", mesh->get_num_active_elements());
+      for_all_active_elements(e, mesh)
+        fprintf(f, "%d\n", e->is_triangle() ? 5 : 9);   // VTK triangle / quad.
+
+      // One value per cell - the accounted cost is constant per element.
+      fprintf(f, "\n");
+      fprintf(f, "CELL_DATA %d\n", mesh->get_num_active_elements());
+      fprintf(f, "SCALARS %s %s %d\n", "assembly_cost", "float", 1);
+      fprintf(f, "LOOKUP_TABLE %s\n", "default");
+      for_all_active_elements(e, mesh)
+        fprintf(f, "%g\n", e->id < this->element_costs_size ? this->element_costs[e->id] : 0.0);
+
+      fclose(f);
+    }
+
     template<typename Scalar>
     Hermes::vector<const Space<Scalar>*> DiscreteProblem<Scalar>::get_spaces() const
     {
@@ -282,6 +483,14 @@ namespace Hermes
       if(!have_matrix)
         up_to_date = false;
 
+      // A different matrix instance does not carry the structure over.
+      if(current_mat != NULL && current_mat != structure_mat)
+        up_to_date = false;
+
+      // The caller asserted an unchanged dof structure, the seq numbers need not agree.
+      if(reuse_matrix_structure)
+        return up_to_date;
+
       for (unsigned int i = 0; i < wf->get_neq(); i++)
       {
         if(spaces[i]->get_seq() != sp_seq[i])
@@ -300,6 +509,52 @@ namespace Hermes
       this->is_fvm = true;
     }
 
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::form_cacheable(Form<Scalar>* form) const
+    {
+      if(!form->get_linear())
+        return false;
+      // Ext dependence is vacuous for forms that receive no external functions.
+      if(form->get_ext_dependent() && (form->ext.size() > 0 || this->wf->ext.size() > 0))
+        return false;
+      return true;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::split_restrict_forms(WeakForm<Scalar>* wf_instance)
+    {
+      bool keep_cacheable = (this->split_assembling_pass == 1);
+
+      for(int i = (int)wf_instance->mfvol.size() - 1; i >= 0; i--)
+        if(form_cacheable(wf_instance->mfvol[i]) != keep_cacheable)
+          wf_instance->mfvol.erase(wf_instance->mfvol.begin() + i);
+      for(int i = (int)wf_instance->mfsurf.size() - 1; i >= 0; i--)
+        if(form_cacheable(wf_instance->mfsurf[i]) != keep_cacheable)
+          wf_instance->mfsurf.erase(wf_instance->mfsurf.begin() + i);
+      for(int i = (int)wf_instance->vfvol.size() - 1; i >= 0; i--)
+        if(form_cacheable(wf_instance->vfvol[i]) != keep_cacheable)
+          wf_instance->vfvol.erase(wf_instance->vfvol.begin() + i);
+      for(int i = (int)wf_instance->vfsurf.size() - 1; i >= 0; i--)
+        if(form_cacheable(wf_instance->vfsurf[i]) != keep_cacheable)
+          wf_instance->vfsurf.erase(wf_instance->vfsurf.begin() + i);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::invalidate_split_assembling_cache()
+    {
+      if(this->split_linear_mat != NULL)
+      {
+        delete this->split_linear_mat;
+        this->split_linear_mat = NULL;
+      }
+      if(this->split_linear_rhs != NULL)
+      {
+        delete this->split_linear_rhs;
+        this->split_linear_rhs = NULL;
+      }
+      this->split_linear_sp_seqs.clear();
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::delete_cache()
     {
@@ -331,6 +586,29 @@ namespace Hermes
       }
       delete [] this->cache_records_sub_idx;
       delete [] this->cache_records_element;
+
+      for(typename std::map<uint64_t, ConstCoeffCacheRecord*>::iterator it = this->const_coeff_cache.begin(); it != this->const_coeff_cache.end(); it++)
+      {
+        it->second->clear();
+        delete it->second;
+      }
+      this->const_coeff_cache.clear();
+
+      if(this->state_contributions != NULL)
+      {
+        for(unsigned int j = 0; j < cache_size; j++)
+        {
+          if(this->state_contributions[j] != NULL)
+          {
+            for(typename std::map<uint64_t, StateContributionRecord*>::iterator it = this->state_contributions[j]->begin(); it != this->state_contributions[j]->end(); it++)
+              delete it->second;
+            delete this->state_contributions[j];
+            this->state_contributions[j] = NULL;
+          }
+        }
+        free(this->state_contributions);
+        this->state_contributions = NULL;
+      }
     }
 
     template<typename Scalar>
@@ -392,6 +670,9 @@ namespace Hermes
           memset(cache_records_element[i], NULL, this->cache_size * sizeof(CacheRecordPerElement*));
         }
         cache_element_stored = NULL;
+
+        state_contributions = (std::map<uint64_t, StateContributionRecord*>**)malloc(this->cache_size * sizeof(std::map<uint64_t, StateContributionRecord*>*));
+        memset(state_contributions, NULL, this->cache_size * sizeof(std::map<uint64_t, StateContributionRecord*>*));
       }
       else
       {
@@ -415,6 +696,9 @@ namespace Hermes
             memset(this->cache_records_element[i] + this->cache_size, NULL, (max_size - this->cache_size) * sizeof(CacheRecordPerElement*));
           }
 
+          this->state_contributions = (std::map<uint64_t, StateContributionRecord*>**)realloc(this->state_contributions, max_size * sizeof(std::map<uint64_t, StateContributionRecord*>*));
+          memset(this->state_contributions + this->cache_size, NULL, (max_size - this->cache_size) * sizeof(std::map<uint64_t, StateContributionRecord*>*));
+
           this->cache_size = max_size;
         }
 
@@ -463,6 +747,27 @@ namespace Hermes
             }
           }
         }
+
+        // Drop stored contributions of states whose representing element is gone.
+        if(this->state_contributions != NULL)
+        {
+          for(unsigned int j = 0; j < cache_size; j++)
+          {
+            if(this->state_contributions[j] == NULL)
+              continue;
+            bool keep = false;
+            for(unsigned int i = 0; i < spaces.size() && !keep; i++)
+              if(j < spaces[i]->get_mesh()->get_max_element_id() && spaces[i]->get_mesh()->get_element(j) != NULL && spaces[i]->get_mesh()->get_element(j)->active)
+                keep = true;
+            if(!keep)
+            {
+              for(typename std::map<uint64_t, StateContributionRecord*>::iterator it = this->state_contributions[j]->begin(); it != this->state_contributions[j]->end(); it++)
+                delete it->second;
+              delete this->state_contributions[j];
+              this->state_contributions[j] = NULL;
+            }
+          }
+        }
       }
 
       this->ndof = Space<Scalar>::get_num_dofs(this->spaces);
@@ -510,40 +815,94 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    bool DiscreteProblem<Scalar>::form_to_be_assembled(MatrixFormVol<Scalar>* form, Traverse::State* current_state)
+    void DiscreteProblem<Scalar>::resolve_form_areas(WeakForm<Scalar>* wf_instance)
     {
-      if(!form_to_be_assembled((MatrixForm<Scalar>*)form, current_state))
-        return false;
+      for (unsigned int i = 0; i < wf_instance->mfvol.size(); i++)
+        resolve_form_areas(wf_instance->mfvol[i],
+          this->spaces[wf_instance->mfvol[i]->i]->get_mesh()->get_element_markers_conversion(),
+          &this->spaces[wf_instance->mfvol[i]->j]->get_mesh()->get_element_markers_conversion());
+      for (unsigned int i = 0; i < wf_instance->mfsurf.size(); i++)
+        resolve_form_areas(wf_instance->mfsurf[i],
+          this->spaces[wf_instance->mfsurf[i]->i]->get_mesh()->get_boundary_markers_conversion(),
+          &this->spaces[wf_instance->mfsurf[i]->j]->get_mesh()->get_boundary_markers_conversion());
+      for (unsigned int i = 0; i < wf_instance->vfvol.size(); i++)
+        resolve_form_areas(wf_instance->vfvol[i],
+          this->spaces[wf_instance->vfvol[i]->i]->get_mesh()->get_element_markers_conversion(), NULL);
+      for (unsigned int i = 0; i < wf_instance->vfsurf.size(); i++)
+        resolve_form_areas(wf_instance->vfsurf[i],
+          this->spaces[wf_instance->vfsurf[i]->i]->get_mesh()->get_boundary_markers_conversion(), NULL);
+    }
 
-      // Assemble this form only if one of its areas is HERMES_ANY
-      // of if the element marker coincides with one of the form's areas.
-      bool assemble_this_form = false;
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::resolve_form_areas(Form<Scalar>* form, const Mesh::MarkersConversion& conversion_m, const Mesh::MarkersConversion* conversion_n)
+    {
+      // The declared marker-piecewise-constant material data is resolved here as
+      // well, to a table indexed by the internal markers of the test space mesh.
+      // \sa Form::set_material_coefficient().
+      form->material_table.clear();
+      for(typename std::map<std::string, Scalar>::const_iterator it = form->material_coefficients.begin(); it != form->material_coefficients.end(); it++)
+      {
+        Mesh::MarkersConversion::IntValid marker = conversion_m.get_internal_marker(it->first);
+        if(!marker.valid || marker.marker < 0)
+          continue;
+        if((int)form->material_table.size() <= marker.marker)
+          form->material_table.resize(marker.marker + 1, Scalar(0.));
+        form->material_table[marker.marker] = it->second;
+      }
+
+      form->any_area = false;
+      form->areas_internal_m.clear();
+      form->areas_internal_n.clear();
+      form->area_bitmap.clear();
       for (unsigned int ss = 0; ss < form->areas.size(); ss++)
       {
         if(form->areas[ss] == HERMES_ANY)
         {
-          assemble_this_form = true;
-          break;
+          form->any_area = true;
+          return;
         }
-        else
+        Mesh::MarkersConversion::IntValid marker_m = conversion_m.get_internal_marker(form->areas[ss]);
+        form->areas_internal_m.push_back(marker_m.valid ? marker_m.marker : -1);
+        if(conversion_n != NULL)
         {
-          bool marker_on_space_m = this->spaces[form->i]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->areas[ss]).valid;
-          if(marker_on_space_m)
-            marker_on_space_m = (this->spaces[form->i]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->areas[ss]).marker == current_state->rep->marker);
-
-          bool marker_on_space_n = this->spaces[form->j]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->areas[ss]).valid;
-          if(marker_on_space_n)
-            marker_on_space_n = (this->spaces[form->j]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->areas[ss]).marker == current_state->rep->marker);
-
-          if(marker_on_space_m && marker_on_space_n)
-          {
-            assemble_this_form = true;
-            break;
-          }
+          Mesh::MarkersConversion::IntValid marker_n = conversion_n->get_internal_marker(form->areas[ss]);
+          form->areas_internal_n.push_back(marker_n.valid ? marker_n.marker : -1);
         }
       }
-      if(!assemble_this_form)
+
+      // Condense the resolved list into a marker-indexed bitmap, so that the
+      // per-element filter in the assembling loops tests one bit instead of
+      // scanning the list. A marker assembles when both meshes the form couples
+      // resolve the area to the same internal id, exactly as the list scan did.
+      for (unsigned int ss = 0; ss < form->areas_internal_m.size(); ss++)
+      {
+        int marker = form->areas_internal_m[ss];
+        if(marker < 0)
+          continue;
+        if(conversion_n != NULL && form->areas_internal_n[ss] != marker)
+          continue;
+        if((int)form->area_bitmap.size() <= marker)
+          form->area_bitmap.resize(marker + 1, false);
+        form->area_bitmap[marker] = true;
+      }
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::form_to_be_assembled(MatrixFormVol<Scalar>* form, Traverse::State* current_state)
+    {
+      if(!form_to_be_assembled((MatrixForm<Scalar>*)form, current_state))
         return false;
+
+      // Assemble this form only if one of its areas is HERMES_ANY
+      // of if the element marker coincides with one of the form's areas.
+      // The resolved areas are condensed into a marker-indexed bitmap,
+      // see resolve_form_areas().
+      if(!form->any_area)
+      {
+        int marker = current_state->rep->marker;
+        if(marker < 0 || marker >= (int)form->area_bitmap.size() || !form->area_bitmap[marker])
+          return false;
+      }
       return true;
     }
 
@@ -558,33 +917,14 @@ namespace Hermes
       if(!form_to_be_assembled((MatrixForm<Scalar>*)form, current_state))
         return false;
 
-      bool assemble_this_form = false;
-      for (unsigned int ss = 0; ss < form->areas.size(); ss++)
+      // The resolved areas are condensed into a marker-indexed bitmap,
+      // see resolve_form_areas().
+      if(!form->any_area)
       {
-        if(form->areas[ss] == HERMES_ANY)
-        {
-          assemble_this_form = true;
-          break;
-        }
-        else
-        {
-          bool marker_on_space_m = this->spaces[form->i]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->areas[ss]).valid;
-          if(marker_on_space_m)
-            marker_on_space_m = (this->spaces[form->i]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->areas[ss]).marker == current_state->rep->en[current_state->isurf]->marker);
-
-          bool marker_on_space_n = this->spaces[form->j]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->areas[ss]).valid;
-          if(marker_on_space_n)
-            marker_on_space_n = (this->spaces[form->j]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->areas[ss]).marker == current_state->rep->en[current_state->isurf]->marker);
-
-          if(marker_on_space_m && marker_on_space_n)
-          {
-            assemble_this_form = true;
-            break;
-          }
-        }
+        int marker = current_state->rep->en[current_state->isurf]->marker;
+        if(marker < 0 || marker >= (int)form->area_bitmap.size() || !form->area_bitmap[marker])
+          return false;
       }
-      if(assemble_this_form == false)
-        return false;
       return true;
     }
 
@@ -607,29 +947,14 @@ namespace Hermes
 
       // Assemble this form only if one of its areas is HERMES_ANY
       // of if the element marker coincides with one of the form's areas.
-      bool assemble_this_form = false;
-      for (unsigned int ss = 0; ss < form->areas.size(); ss++)
+      // The resolved areas are condensed into a marker-indexed bitmap,
+      // see resolve_form_areas().
+      if(!form->any_area)
       {
-        if(form->areas[ss] == HERMES_ANY)
-        {
-          assemble_this_form = true;
-          break;
-        }
-        else
-        {
-          bool marker_on_space_m = this->spaces[form->i]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->areas[ss]).valid;
-          if(marker_on_space_m)
-            marker_on_space_m = (this->spaces[form->i]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->areas[ss]).marker == current_state->rep->marker);
-
-          if(marker_on_space_m)
-          {
-            assemble_this_form = true;
-            break;
-          }
-        }
+        int marker = current_state->rep->marker;
+        if(marker < 0 || marker >= (int)form->area_bitmap.size() || !form->area_bitmap[marker])
+          return false;
       }
-      if(!assemble_this_form)
-        return false;
       return true;
     }
 
@@ -645,29 +970,14 @@ namespace Hermes
       if(!form_to_be_assembled((VectorForm<Scalar>*)form, current_state))
         return false;
 
-      bool assemble_this_form = false;
-      for (unsigned int ss = 0; ss < form->areas.size(); ss++)
+      // The resolved areas are condensed into a marker-indexed bitmap,
+      // see resolve_form_areas().
+      if(!form->any_area)
       {
-        if(form->areas[ss] == HERMES_ANY)
-        {
-          assemble_this_form = true;
-          break;
-        }
-        else
-        {
-          bool marker_on_space_m = this->spaces[form->i]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->areas[ss]).valid;
-          if(marker_on_space_m)
-            marker_on_space_m = (this->spaces[form->i]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->areas[ss]).marker == current_state->rep->en[current_state->isurf]->marker);
-
-          if(marker_on_space_m)
-          {
-            assemble_this_form = true;
-            break;
-          }
-        }
+        int marker = current_state->rep->en[current_state->isurf]->marker;
+        if(marker < 0 || marker >= (int)form->area_bitmap.size() || !form->area_bitmap[marker])
+          return false;
       }
-      if(assemble_this_form == false)
-        return false;
       return true;
     }
 
@@ -685,7 +995,9 @@ namespace Hermes
     {
       if(is_up_to_date())
       {
-        if(current_mat != NULL)
+        // A deadline-bounded assembling resuming a cut-short pass keeps the
+        // partial contents, \sa set_assembling_deadline().
+        if(current_mat != NULL && !this->deadline_resume_pending)
           current_mat->zero();
         if(current_rhs != NULL)
         {
@@ -693,7 +1005,7 @@ namespace Hermes
           // we end up with everything up_to_date, but unallocated Vector.
           if(current_rhs->length() == 0)
             current_rhs->alloc(this->ndof);
-          else
+          else if(!this->deadline_resume_pending)
             current_rhs->zero();
         }
         return;
@@ -863,6 +1175,7 @@ namespace Hermes
         delete [] blocks;
 
         current_mat->alloc();
+        structure_mat = current_mat;
       }
 
       // WARNING: unlike Matrix<Scalar>::alloc(), Vector<Scalar>::alloc(ndof) frees the memory occupied
@@ -893,6 +1206,16 @@ namespace Hermes
     template<typename Scalar>
     void DiscreteProblem<Scalar>::init_assembling(Scalar* coeff_vec, PrecalcShapeset*** pss , PrecalcShapeset*** spss, RefMap*** refmaps, Solution<Scalar>*** u_ext, AsmList<Scalar>*** als, WeakForm<Scalar>** weakforms)
     {
+      if(this->local_stiffness_scratch == NULL)
+      {
+        this->local_stiffness_scratch = new Scalar**[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+        this->local_stiffness_scratch_size = new unsigned int[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+        for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
+        {
+          this->local_stiffness_scratch[i] = NULL;
+          this->local_stiffness_scratch_size[i] = 0;
+        }
+      }
       for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
       {
         pss[i] = new PrecalcShapeset*[wf->get_neq()];
@@ -917,17 +1240,46 @@ namespace Hermes
 
       // U_ext functions
       if(!is_linear)
+      {
+        // With pooling on, the u_ext Solutions retained by the previous assembling are
+        // reused whenever the spaces have not changed in between (checked through their
+        // seq numbers); refreshing them below with the new coefficient vector then keeps
+        // their whole layout. \sa set_u_ext_pooling()
+        bool pooled = this->u_ext_pooling && coeff_vec != NULL;
+        if(pooled)
+        {
+          bool pool_valid = u_ext_pool != NULL && u_ext_pool_seqs.size() == wf->get_neq();
+          if(pool_valid)
+            for (unsigned int j = 0; j < wf->get_neq(); j++)
+              if(spaces[j]->get_seq() != u_ext_pool_seqs[j])
+                pool_valid = false;
+          if(!pool_valid)
+          {
+            free_u_ext_pool();
+            u_ext_pool = new Solution<Scalar>**[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+            for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
+            {
+              u_ext_pool[i] = new Solution<Scalar>*[wf->get_neq()];
+              for (int j = 0; j < wf->get_neq(); j++)
+                u_ext_pool[i][j] = new Solution<Scalar>(spaces[j]->get_mesh());
+            }
+            for (unsigned int j = 0; j < wf->get_neq(); j++)
+              u_ext_pool_seqs.push_back(spaces[j]->get_seq());
+          }
+        }
+
         for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
         {
           if(coeff_vec != NULL)
           {
-            u_ext[i] = new Solution<Scalar>*[wf->get_neq()];
+            u_ext[i] = pooled ? u_ext_pool[i] : new Solution<Scalar>*[wf->get_neq()];
             if(i == 0)
             {
               int first_dof = 0;
               for (int j = 0; j < wf->get_neq(); j++)
               {
-                u_ext[i][j] = new Solution<Scalar>(spaces[j]->get_mesh());
+                if(!pooled)
+                  u_ext[i][j] = new Solution<Scalar>(spaces[j]->get_mesh());
                 Solution<Scalar>::vector_to_solution(coeff_vec, spaces[j], u_ext[i][j], !RungeKutta, first_dof);
                 first_dof += spaces[j]->get_num_dofs();
               }
@@ -936,7 +1288,8 @@ namespace Hermes
             {
               for (int j = 0; j < wf->get_neq(); j++)
               {
-                u_ext[i][j] = new Solution<Scalar>(spaces[j]->get_mesh());
+                if(!pooled)
+                  u_ext[i][j] = new Solution<Scalar>(spaces[j]->get_mesh());
                 u_ext[i][j]->copy(u_ext[0][j]);
               }
             }
@@ -953,6 +1306,7 @@ namespace Hermes
             }
           }
         }
+      }
 
         // Assembly lists
         for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
@@ -967,6 +1321,9 @@ namespace Hermes
         {
           weakforms[i] = this->wf->clone();
           weakforms[i]->cloneMembers(this->wf);
+          if(this->split_assembling_pass != 0)
+            split_restrict_forms(weakforms[i]);
+          resolve_form_areas(weakforms[i]);
         }
 
         assert(cache_element_stored == NULL);
@@ -1009,6 +1366,9 @@ namespace Hermes
       {
         for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
         {
+          // pooled Solutions stay alive for the next assembling
+          if(u_ext_pool != NULL && u_ext[i] == u_ext_pool[i])
+            continue;
           if(u_ext[i] != NULL)
           {
             for (unsigned int j = 0; j < wf->get_neq(); j++)
@@ -1038,8 +1398,39 @@ namespace Hermes
         delete [] cache_element_stored[i];
       delete [] cache_element_stored;
       cache_element_stored = NULL;
+
+      if(this->local_stiffness_scratch != NULL)
+      {
+        for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
+          if(this->local_stiffness_scratch[i] != NULL)
+            delete [] this->local_stiffness_scratch[i];
+        delete [] this->local_stiffness_scratch;
+        delete [] this->local_stiffness_scratch_size;
+        this->local_stiffness_scratch = NULL;
+        this->local_stiffness_scratch_size = NULL;
+      }
     }
 
+    /// Ordering of state indices by descending accounted cost,
+    /// \sa DiscreteProblem::set_assembling_deadline().
+    struct StateCostOrdering
+    {
+      StateCostOrdering(const double* costs) : costs(costs) {}
+      bool operator()(int a, int b) const { return costs[a] > costs[b]; }
+      const double* costs;
+    };
+
+    /// Grouping of state indices by their (mode, element-order) signature,
+    /// \sa DiscreteProblem::set_batch_assembling(). Lexicographic comparison
+    /// of the signature tuples; ties keep the traversal order (stable sort),
+    /// preserving the mesh locality within each group.
+    struct StateSignatureOrdering
+    {
+      StateSignatureOrdering(const std::vector<int>* signatures) : signatures(signatures) {}
+      bool operator()(int a, int b) const { return signatures[a] < signatures[b]; }
+      const std::vector<int>* signatures;
+    };
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble(Scalar* coeff_vec, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs, bool force_diagonal_blocks, Table* block_weights)
     {
@@ -1061,9 +1452,104 @@ namespace Hermes
         if(block_weights->get_size() != wf->get_neq())
           throw Exceptions::LengthException(6, block_weights->get_size(), wf->get_neq());
 
+      // Deadline-bounded assembling: when the previous call was cut short, the
+      // partially assembled structures must survive the zeroing in
+      // create_sparse_structure(). Whether the resume is actually still valid
+      // is decided below, once the state stream is known.
+      this->deadline_resume_pending = (this->assembling_deadline > 0.0 && this->unassembled_states.size() > 0);
+
       // Creating matrix sparse structure.
       create_sparse_structure();
 
+      // Split assembling: decide whether the forms marked linear are served from
+      // the internal cached pair, leaving only the remaining forms to this pass.
+      // \sa set_split_assembling()
+      bool split_active = false;
+      if(this->split_assembling && this->split_assembling_pass == 0 && !this->is_matrix_free() && !this->matrix_free_apply
+        && !DG_matrix_forms_present && !DG_vector_forms_present
+        && !this->incremental_assembling && this->assembling_deadline == 0.0)
+      {
+        bool any_cacheable = false, any_rest = false;
+        for(unsigned int form_i = 0; form_i < this->wf->forms.size(); form_i++)
+        {
+          if(form_cacheable(this->wf->forms[form_i]))
+            any_cacheable = true;
+          else
+            any_rest = true;
+        }
+        // Splitting pays off only when both parts are nonempty.
+        split_active = any_cacheable && any_rest;
+      }
+
+      if(split_active)
+      {
+        // Validity of the cached part: it has to cover the requested structures
+        // and neither the spaces nor - when a cached form depends on it - the
+        // time may have changed since it was assembled.
+        bool cache_valid = (split_linear_mat != NULL || split_linear_rhs != NULL)
+          && (mat == NULL || split_linear_mat != NULL)
+          && (rhs == NULL || split_linear_rhs != NULL);
+        if(cache_valid)
+        {
+          if(split_linear_sp_seqs.size() != spaces.size())
+            cache_valid = false;
+          else
+            for(unsigned int i = 0; i < spaces.size(); i++)
+              if(spaces[i]->get_seq() != split_linear_sp_seqs[i])
+                cache_valid = false;
+        }
+        if(cache_valid && this->wf->get_current_time() != split_linear_time)
+          for(unsigned int form_i = 0; form_i < this->wf->forms.size(); form_i++)
+            if(form_cacheable(this->wf->forms[form_i]) && this->wf->forms[form_i]->get_time_dependent())
+              cache_valid = false;
+
+        if(!cache_valid)
+        {
+          invalidate_split_assembling_cache();
+          if(mat != NULL)
+            split_linear_mat = create_matrix<Scalar>();
+          if(rhs != NULL)
+          {
+            split_linear_rhs = create_vector<Scalar>();
+            split_linear_rhs->alloc(this->ndof);
+          }
+
+          // Assemble the linear forms into the internal pair. The persistent
+          // element cache stays dedicated to the varying part.
+          bool stored_cache_setting = this->do_not_use_cache;
+          this->do_not_use_cache = true;
+          this->split_assembling_pass = 1;
+          try
+          {
+            assemble(coeff_vec, split_linear_mat, split_linear_rhs, force_diagonal_blocks, block_weights);
+          }
+          catch(...)
+          {
+            this->split_assembling_pass = 0;
+            this->do_not_use_cache = stored_cache_setting;
+            invalidate_split_assembling_cache();
+            throw;
+          }
+          this->split_assembling_pass = 0;
+          this->do_not_use_cache = stored_cache_setting;
+
+          split_linear_sp_seqs.clear();
+          for(unsigned int i = 0; i < spaces.size(); i++)
+            split_linear_sp_seqs.push_back(spaces[i]->get_seq());
+          split_linear_time = this->wf->get_current_time();
+
+          // The recursive call retargeted the assembling info and the structure
+          // bookkeeping to the internal pair - point them back to this call's.
+          this->structure_mat = mat;
+          current_mat = mat;
+          current_rhs = rhs;
+          current_force_diagonal_blocks = force_diagonal_blocks;
+          current_block_weights = block_weights;
+        }
+
+        this->split_assembling_pass = 2;
+      }
+
       // Initial check of meshes and spaces.
       for(unsigned int ext_i = 0; ext_i < this->wf->ext.size(); ext_i++)
       {
@@ -1082,6 +1568,10 @@ namespace Hermes
       // Fill these structures.
       init_assembling(coeff_vec, pss, spss, refmaps, u_ext, als, weakforms);
 
+      // The form restriction of split assembling applies only to the clones
+      // that were just made.
+      this->split_assembling_pass = 0;
+
       // Vector of meshes.
       Hermes::vector<const Mesh*> meshes;
       for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
@@ -1095,10 +1585,16 @@ namespace Hermes
       for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
         meshes.push_back(spaces[space_i]->get_mesh());
 
-      Traverse trav_master(true);
-      unsigned int num_states = trav_master.get_num_states(meshes);
-
-      trav_master.begin(meshes.size(), &(meshes.front()));
+      int num_states;
+      Traverse::State** states = NULL;
+      if(this->states_cache)
+        // Flat state stream - derived once, replayed while the meshes do not change.
+        states = traverse_master.get_states(meshes, num_states);
+      else
+      {
+        num_states = traverse_master.get_num_states(meshes);
+        traverse_master.begin(meshes.size(), &(meshes.front()));
+      }
 
       Traverse* trav = new Traverse[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
       Hermes::vector<Transformable *>* fns = new Hermes::vector<Transformable *>[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
@@ -1126,7 +1622,8 @@ namespace Hermes
           u_ext[i][j]->set_quad_2d(&g_quad_2d_std);
         }
         trav[i].begin(meshes.size(), &(meshes.front()), &(fns[i].front()));
-        trav[i].stack = trav_master.stack;
+        if(!this->states_cache)
+          trav[i].stack = traverse_master.stack;
       }
 
       int state_i;
@@ -1140,33 +1637,211 @@ namespace Hermes
 
 #define CHUNKSIZE 1
       int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
-#pragma omp parallel shared(trav_master, mat, rhs ) private(state_i, current_pss, current_spss, current_refmaps, current_u_ext, current_als, current_weakform) num_threads(num_threads_used)
+
+      if(this->deterministic_assembling)
+      {
+        if(!this->states_cache)
+          throw Hermes::Exceptions::Exception("Deterministic assembling needs a reproducible state stream, call set_states_cache() as well.");
+        if(this->assembling_deadline > 0.0)
+          throw Hermes::Exceptions::Exception("Deterministic assembling cannot be combined with an assembling deadline.");
+      }
+
+      // Per-thread scatter matrices - each thread assembles into its own copy of the
+      // matrix structure so that no synchronization on individual entries is necessary.
+      // The copies are summed into the target matrix below. The deterministic mode
+      // relies on them even single-threaded, so that the summation grouping does not
+      // change with the thread count.
+      if(mat != NULL && ((this->use_scatter_matrices && num_threads_used > 1) || this->deterministic_assembling))
       {
-#pragma omp for schedule(static, CHUNKSIZE)
-        for(state_i = 0; state_i < num_states; state_i++)
+        this->scatter_mat = new SparseMatrix<Scalar>*[num_threads_used];
+        for(int i = 0; i < num_threads_used; i++)
         {
-          if(this->caughtException != NULL)
-            continue;
-          try
-          {
-            Traverse::State current_state;
-#pragma omp critical (get_next_state)
-            {
-              try
-              {
-                current_state = trav[omp_get_thread_num()].get_next_state(&trav_master.top, &trav_master.id);
-              }
-              catch(Hermes::Exceptions::Exception& e)
-              {
-                if(this->caughtException == NULL)
-                  this->caughtException = e.clone();
-              }
-              catch(std::exception& e)
-              {
-                if(this->caughtException == NULL)
-                  this->caughtException = new Hermes::Exceptions::Exception(e.what());
-              }
-            }
+          this->scatter_mat[i] = mat->duplicate();
+          this->scatter_mat[i]->zero();
+        }
+      }
+
+      // Deterministic mode: the right-hand side is scattered as well - its shared
+      // adds would otherwise race-order just like the matrix entries.
+      if(this->deterministic_assembling && rhs != NULL)
+      {
+        this->scatter_rhs = new Vector<Scalar>*[num_threads_used];
+        for(int i = 0; i < num_threads_used; i++)
+        {
+          this->scatter_rhs[i] = create_vector<Scalar>();
+          this->scatter_rhs[i]->alloc(rhs->length());
+          this->scatter_rhs[i]->zero();
+        }
+      }
+      this->deterministic_next_chunk = 0;
+
+      // The deterministic reduction works with larger blocks of the state stream, so
+      // that the ordered flushes of the scattered structures stay rare.
+      int chunk_size = this->deterministic_assembling ? 64 : CHUNKSIZE;
+
+      // Incremental re-assembly: per-thread recording state. DG forms do not pass
+      // through the recorded insertion points, so they disable the feature.
+      if(this->incremental_assembling && !this->matrix_free_apply && !DG_matrix_forms_present && !DG_vector_forms_present)
+      {
+        this->recording_contribution = new StateContributionRecord*[num_threads_used];
+        for(int i = 0; i < num_threads_used; i++)
+          this->recording_contribution[i] = NULL;
+        this->recording_dof_pos = new std::map<int, int>[num_threads_used];
+      }
+
+      // Element cost accounting: per-thread cost arrays, so that the threads
+      // do not synchronize on the shared map; they are summed below.
+      double** thread_element_costs = NULL;
+      if(this->element_cost_accounting)
+      {
+        int cost_map_size = 0;
+        for(unsigned int i = 0; i < this->spaces_size; i++)
+          if(this->spaces[i]->get_mesh()->get_max_element_id() + 1 > cost_map_size)
+            cost_map_size = this->spaces[i]->get_mesh()->get_max_element_id() + 1;
+
+        if(this->element_costs_size < cost_map_size)
+        {
+          if(this->element_costs != NULL)
+            delete [] this->element_costs;
+          this->element_costs = new double[cost_map_size];
+          this->element_costs_size = cost_map_size;
+        }
+        memset(this->element_costs, 0, this->element_costs_size * sizeof(double));
+
+        thread_element_costs = new double*[num_threads_used];
+        for(int i = 0; i < num_threads_used; i++)
+        {
+          thread_element_costs[i] = new double[this->element_costs_size];
+          memset(thread_element_costs[i], 0, this->element_costs_size * sizeof(double));
+        }
+      }
+
+      // Deadline-bounded assembling: establish the processing order - by
+      // descending accounted cost when a cost map exists - and, when resuming
+      // a cut-short pass over an unchanged state stream, restrict the work to
+      // the remembered remainder. \sa set_assembling_deadline().
+      int num_states_to_do = num_states;
+      int* state_order = NULL;
+      char* state_done = NULL;
+      bool deadline_passed = false;
+      Hermes::Mixins::TimeMeasurable deadline_timer;
+      if(this->assembling_deadline > 0.0 && states != NULL)
+      {
+        if(this->deadline_resume_pending && this->deadline_states == states && this->deadline_num_states == num_states)
+        {
+          num_states_to_do = this->unassembled_states.size();
+          state_order = new int[num_states_to_do];
+          for(int i = 0; i < num_states_to_do; i++)
+            state_order[i] = this->unassembled_states[i];
+        }
+        else
+        {
+          // A fresh full pass. If a remembered remainder belongs to another
+          // state stream (the meshes changed), the skipped zeroing of the
+          // structures has to be made up for.
+          if(this->deadline_resume_pending)
+          {
+            if(current_mat != NULL)
+              current_mat->zero();
+            if(current_rhs != NULL)
+              current_rhs->zero();
+          }
+          state_order = new int[num_states];
+          for(int i = 0; i < num_states; i++)
+            state_order[i] = i;
+          if(this->element_costs != NULL)
+          {
+            double* state_costs = new double[num_states];
+            for(int i = 0; i < num_states; i++)
+            {
+              Element* rep = states[i]->rep;
+              state_costs[i] = (rep != NULL && rep->id < this->element_costs_size)
+                ? this->element_costs[rep->id] : 0.0;
+            }
+            std::sort(state_order, state_order + num_states, StateCostOrdering(state_costs));
+            delete [] state_costs;
+          }
+          else if(this->batch_assembling)
+          {
+            // Group the states by their assembly signature, so that elements
+            // of the same mode and order tuple are processed back to back and
+            // share the per-order setup, \sa set_batch_assembling().
+            std::vector<int>* state_signatures = new std::vector<int>[num_states];
+            for(int i = 0; i < num_states; i++)
+            {
+              state_signatures[i].reserve(spaces.size() + 1);
+              state_signatures[i].push_back(states[i]->rep == NULL ? -1 : (int) states[i]->rep->get_mode());
+              for(unsigned int j = 0; j < spaces.size(); j++)
+                state_signatures[i].push_back(states[i]->e[j] == NULL ? -1 : spaces[j]->get_element_order(states[i]->e[j]->id));
+            }
+            std::stable_sort(state_order, state_order + num_states, StateSignatureOrdering(state_signatures));
+            delete [] state_signatures;
+          }
+        }
+        this->deadline_resume_pending = false;
+        state_done = new char[num_states_to_do];
+        memset(state_done, 0, num_states_to_do * sizeof(char));
+        // The budget starts here.
+        deadline_timer.tick(Hermes::Mixins::TimeMeasurable::HERMES_SKIP);
+      }
+
+#pragma omp parallel shared(mat, rhs ) private(state_i, current_pss, current_spss, current_refmaps, current_u_ext, current_als, current_weakform) num_threads(num_threads_used)
+      {
+        // The per-thread wall clock of the cost accounting.
+        Hermes::Mixins::TimeMeasurable cost_timer;
+#pragma omp for schedule(dynamic, chunk_size)
+        for(state_i = 0; state_i < num_states_to_do; state_i++)
+        {
+          if(this->caughtException != NULL)
+            continue;
+
+          // Once the budget is out, the remaining states are left over for
+          // the next call.
+          if(state_done != NULL)
+          {
+            if(!deadline_passed)
+            {
+#pragma omp critical (assembling_deadline)
+              {
+                deadline_timer.tick();
+                if(deadline_timer.accumulated() > this->assembling_deadline)
+                  deadline_passed = true;
+              }
+            }
+            if(deadline_passed)
+              continue;
+          }
+          try
+          {
+            Traverse::State current_state;
+            if(this->states_cache)
+            {
+              int idx = (state_order != NULL) ? state_order[state_i] : state_i;
+              // Replaying a flat state stream - no synchronization needed, the
+              // functions only have to be re-targeted by hand.
+              trav[omp_get_thread_num()].apply_state(states[idx]);
+              current_state = states[idx];
+            }
+            else
+            {
+#pragma omp critical (get_next_state)
+              {
+                try
+                {
+                  current_state = trav[omp_get_thread_num()].get_next_state(&traverse_master.top, &traverse_master.id);
+                }
+                catch(Hermes::Exceptions::Exception& e)
+                {
+                  if(this->caughtException == NULL)
+                    this->caughtException = e.clone();
+                }
+                catch(std::exception& e)
+                {
+                  if(this->caughtException == NULL)
+                    this->caughtException = new Hermes::Exceptions::Exception(e.what());
+                }
+              }
+            }
 
             current_pss = pss[omp_get_thread_num()];
             current_spss = spss[omp_get_thread_num()];
@@ -1181,10 +1856,22 @@ namespace Hermes
             // The proper sub-element mappings to all the functions of
             // this stage is supplied by the function Traverse::get_next_state()
             // called in the while loop.
+            if(thread_element_costs != NULL)
+              cost_timer.tick(Hermes::Mixins::TimeMeasurable::HERMES_SKIP);
+
             assemble_one_state(current_pss, current_spss, current_refmaps, current_u_ext, current_als, &current_state, current_weakform);
 
             if(DG_matrix_forms_present || DG_vector_forms_present)
               assemble_one_DG_state(current_pss, current_spss, current_refmaps, current_als, &current_state, current_weakform->mfDG, current_weakform->vfDG, trav[omp_get_thread_num()].fn, current_weakform);
+
+            if(thread_element_costs != NULL && current_state.rep != NULL && current_state.rep->id < this->element_costs_size)
+            {
+              cost_timer.tick();
+              thread_element_costs[omp_get_thread_num()][current_state.rep->id] += cost_timer.last();
+            }
+
+            if(state_done != NULL)
+              state_done[state_i] = 1;
           }
           catch(Hermes::Exceptions::Exception& e)
           {
@@ -1196,12 +1883,107 @@ namespace Hermes
             if(this->caughtException == NULL)
               this->caughtException = new Hermes::Exceptions::Exception(e.what());
           }
+
+          // Deterministic mode: the scattered contributions of a finished block
+          // enter the shared structures strictly in the block order, so the
+          // floating-point summation order is fixed no matter how the blocks
+          // were scheduled. The thread holding the next block in line flushes
+          // and the others wait for their turn; on an exception everything is
+          // abandoned, the result is thrown away when re-thrown below anyway.
+          if(this->deterministic_assembling && (((state_i + 1) % chunk_size == 0) || state_i == num_states_to_do - 1))
+          {
+            int block = state_i / chunk_size;
+            bool my_turn = false;
+            while(!my_turn && this->caughtException == NULL)
+            {
+#pragma omp critical (deterministic_reduction)
+              my_turn = (this->deterministic_next_chunk == block);
+            }
+            if(this->caughtException == NULL)
+            {
+              if(this->scatter_mat != NULL)
+              {
+                mat->add_sparse_matrix(this->scatter_mat[omp_get_thread_num()]);
+                this->scatter_mat[omp_get_thread_num()]->zero();
+              }
+              if(this->scatter_rhs != NULL)
+              {
+                rhs->add_vector(this->scatter_rhs[omp_get_thread_num()]);
+                this->scatter_rhs[omp_get_thread_num()]->zero();
+              }
+#pragma omp critical (deterministic_reduction)
+              this->deterministic_next_chunk++;
+            }
+          }
+        }
+      }
+
+      // Deadline-bounded assembling: remember the states that are left, in
+      // the (priority) order they were scheduled in.
+      if(state_done != NULL)
+      {
+        this->unassembled_states.clear();
+        for(int i = 0; i < num_states_to_do; i++)
+          if(!state_done[i])
+            this->unassembled_states.push_back(state_order[i]);
+        this->deadline_states = states;
+        this->deadline_num_states = num_states;
+        delete [] state_done;
+        delete [] state_order;
+      }
+      else if(state_order != NULL)
+        delete [] state_order;
+
+      // Sum the per-thread cost arrays into the shared map.
+      if(thread_element_costs != NULL)
+      {
+        for(int i = 0; i < num_threads_used; i++)
+        {
+          for(int j = 0; j < this->element_costs_size; j++)
+            this->element_costs[j] += thread_element_costs[i][j];
+          delete [] thread_element_costs[i];
+        }
+        delete [] thread_element_costs;
+      }
+
+      // Incremental re-assembly: drop the per-thread recording state.
+      if(this->recording_contribution != NULL)
+      {
+        for(int i = 0; i < num_threads_used; i++)
+          delete this->recording_contribution[i];
+        delete [] this->recording_contribution;
+        this->recording_contribution = NULL;
+        delete [] this->recording_dof_pos;
+        this->recording_dof_pos = NULL;
+      }
+
+      // Sum the per-thread scatter matrices into the target matrix. In the
+      // deterministic mode they were already flushed in block order above.
+      if(this->scatter_mat != NULL)
+      {
+        for(int i = 0; i < num_threads_used; i++)
+        {
+          if(!this->deterministic_assembling)
+            mat->add_sparse_matrix(this->scatter_mat[i]);
+          delete this->scatter_mat[i];
         }
+        delete [] this->scatter_mat;
+        this->scatter_mat = NULL;
+      }
+      if(this->scatter_rhs != NULL)
+      {
+        for(int i = 0; i < num_threads_used; i++)
+          delete this->scatter_rhs[i];
+        delete [] this->scatter_rhs;
+        this->scatter_rhs = NULL;
       }
 
       deinit_assembling(pss, spss, refmaps, u_ext, als, weakforms);
 
-      trav_master.finish();
+      // With the states cache active, get_states() has already finished the master
+      // traversal (and owns the state array - it must stay alive for the replays).
+      if(!this->states_cache)
+        traverse_master.finish();
       for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
         trav[i].finish();
 
@@ -1212,6 +1994,15 @@ namespace Hermes
       delete [] fns;
       delete [] trav;
 
+      // Split assembling: add the cached contributions of the linear forms.
+      if(split_active && this->caughtException == NULL)
+      {
+        if(current_mat != NULL && split_linear_mat != NULL)
+          current_mat->add_sparse_matrix(split_linear_mat);
+        if(current_rhs != NULL && split_linear_rhs != NULL)
+          current_rhs->add_vector(split_linear_rhs);
+      }
+
       /// \todo Should this be really here? Or in assemble()?
       if(current_mat != NULL)
         current_mat->finish();
@@ -1237,6 +2028,55 @@ namespace Hermes
       assemble(coeff_vec, NULL, rhs, force_diagonal_blocks, block_weights);
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::apply(const Scalar* x, Scalar* y, Scalar* coeff_vec)
+    {
+      if(this->DG_matrix_forms_present)
+        throw Hermes::Exceptions::Exception("DG forms are not supported in DiscreteProblem::apply().");
+
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+
+      this->apply_x = x;
+      this->apply_y = new Scalar*[num_threads_used];
+      for(int i = 0; i < num_threads_used; i++)
+      {
+        this->apply_y[i] = new Scalar[this->ndof];
+        memset(this->apply_y[i], 0, this->ndof * sizeof(Scalar));
+      }
+
+      // Run the element-by-element pipeline, the local stiffness matrices are
+      // applied to x in assemble_matrix_form() instead of being inserted into
+      // a global matrix.
+      this->matrix_free_apply = true;
+      try
+      {
+        this->assemble(coeff_vec, (SparseMatrix<Scalar>*)NULL, (Vector<Scalar>*)NULL);
+      }
+      catch(...)
+      {
+        this->matrix_free_apply = false;
+        for(int i = 0; i < num_threads_used; i++)
+          delete [] this->apply_y[i];
+        delete [] this->apply_y;
+        this->apply_y = NULL;
+        this->apply_x = NULL;
+        throw;
+      }
+      this->matrix_free_apply = false;
+
+      // Sum the per-thread results.
+      memset(y, 0, this->ndof * sizeof(Scalar));
+      for(int i = 0; i < num_threads_used; i++)
+      {
+        for(int j = 0; j < this->ndof; j++)
+          y[j] += this->apply_y[i][j];
+        delete [] this->apply_y[i];
+      }
+      delete [] this->apply_y;
+      this->apply_y = NULL;
+      this->apply_x = NULL;
+    }
+
     template<typename Scalar>
     DiscreteProblem<Scalar>::CacheRecordPerSubIdx::CacheRecordPerSubIdx() : fnsSurface(NULL)
     {
@@ -1292,6 +2132,52 @@ namespace Hermes
       delete [] this->asmlistIdx;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::ConstCoeffCacheRecord::clear()
+    {
+      delete [] this->values;
+      delete [] this->idx_i;
+      delete [] this->idx_j;
+      delete [] this->jacobian_x_weights;
+      delete [] this->fn_signature;
+    }
+
+    template<typename Scalar>
+    DiscreteProblem<Scalar>::StateContributionRecord::StateContributionRecord() : has_matrix(false), has_rhs(false)
+    {
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::record_local_matrix(Scalar** local_matrix, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j)
+    {
+      StateContributionRecord* record = this->recording_contribution[omp_get_thread_num()];
+      std::map<int, int>& dof_pos = this->recording_dof_pos[omp_get_thread_num()];
+
+      for (unsigned int i = 0; i < current_als_i->cnt; i++)
+      {
+        if(current_als_i->dof[i] < 0)
+          continue;
+        for (unsigned int j = 0; j < current_als_j->cnt; j++)
+        {
+          if(current_als_j->dof[j] < 0)
+            continue;
+          if(local_matrix[i][j] == Scalar(0.0))
+            continue;
+          record->matrix_pos_i.push_back(dof_pos[current_als_i->dof[i]]);
+          record->matrix_pos_j.push_back(dof_pos[current_als_j->dof[j]]);
+          record->matrix_values.push_back(local_matrix[i][j]);
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::record_local_rhs(int dof, Scalar value)
+    {
+      StateContributionRecord* record = this->recording_contribution[omp_get_thread_num()];
+      record->rhs_pos.push_back(this->recording_dof_pos[omp_get_thread_num()][dof]);
+      record->rhs_values.push_back(value);
+    }
+
     template<typename Scalar>
     bool DiscreteProblem<Scalar>::state_needs_recalculation(AsmList<Scalar>** current_als, Traverse::State* current_state)
     {
@@ -1453,6 +2339,26 @@ namespace Hermes
         }
       }
 
+      // Adaptive quadrature: the Ord calculus counted the previous-iterate
+      // solutions at their stored element orders; on elements where their
+      // coefficients have decayed, the integrand is of effectively lower
+      // degree and the integration order can be lowered accordingly.
+      if(this->adaptive_quadrature && current_u_ext != NULL)
+      {
+        int reduction = 0;
+        int u_ext_count = RungeKutta ? RK_original_spaces_count : this->wf->get_neq();
+        for(int j = 0; j < u_ext_count; j++)
+        {
+          if(current_u_ext[j] == NULL || current_state->e[j] == NULL)
+            continue;
+          int effective = current_u_ext[j]->get_effective_element_order(current_state->e[j], this->adaptive_quadrature_tolerance);
+          if(effective >= 0 && current_u_ext[j]->elem_orders[current_state->e[j]->id] - effective > reduction)
+            reduction = current_u_ext[j]->elem_orders[current_state->e[j]->id] - effective;
+        }
+        if(reduction > 0)
+          order = std::max(order - reduction, 1);
+      }
+
       // Order is known, we know how many integration points we need and we can proceed.
       // cache record sub idx : new precalcshapeset(spaces->shapeset, element, sub_idx, order, asmlist->idx)
       for(unsigned int i = 0; i < this->spaces_size; i++)
@@ -1552,6 +2458,8 @@ namespace Hermes
     void DiscreteProblem<Scalar>::assemble_one_state(PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, AsmList<Scalar>** current_als, 
       Traverse::State* current_state, WeakForm<Scalar>* current_wf)
     {
+      HERMES_PROFILE_INCREMENT(elements_assembled);
+
       // Representing space.
       int rep_space_i = -1;
 
@@ -1591,6 +2499,19 @@ namespace Hermes
           }
         }
 
+        // Residual-only fast path: no matrix is wanted and the cache record would have to
+        // be recalculated anyway - integrate the vector forms at their own (smaller) order
+        // and leave the cache untouched for the next full assembly. When the cache record
+        // is valid, the cached data is used below - it is already paid for.
+        if(this->vector_only_fast_path && changedInLastAdaptation
+          && current_mat == NULL && current_rhs != NULL && !this->matrix_free_apply
+          && this->recording_contribution == NULL
+          && !this->DG_matrix_forms_present && !this->DG_vector_forms_present)
+        {
+          this->assemble_one_state_vector_only(current_pss, current_spss, current_refmaps, current_u_ext, current_als, current_state, current_alsSurface, current_wf);
+          return;
+        }
+
         // Calculate the cache entries.
         CacheRecordPerSubIdx** cacheRecordPerSubIdx = new CacheRecordPerSubIdx*[this->spaces_size];
 
@@ -1613,6 +2534,93 @@ namespace Hermes
           }
         }
 
+        // Incremental re-assembly.
+        if(this->recording_contribution != NULL)
+        {
+          int state_rep_id = current_state->rep->id;
+          uint64_t state_sub_idx = current_state->sub_idx[rep_space_i];
+
+          StateContributionRecord* record = NULL;
+          if(!changedInLastAdaptation)
+          {
+#pragma omp critical (state_contributions_map)
+            {
+              if(this->state_contributions[state_rep_id] != NULL)
+              {
+                typename std::map<uint64_t, StateContributionRecord*>::iterator it = this->state_contributions[state_rep_id]->find(state_sub_idx);
+                if(it != this->state_contributions[state_rep_id]->end())
+                  record = it->second;
+              }
+            }
+          }
+
+          // Concatenated dof / coef arrays of the current assembly lists.
+          Hermes::vector<int> state_dofs;
+          Hermes::vector<Scalar> state_coefs;
+          for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
+          {
+            if(current_state->e[space_i] == NULL)
+              continue;
+            for(unsigned int dof_i = 0; dof_i < current_als[space_i]->cnt; dof_i++)
+            {
+              state_dofs.push_back(current_als[space_i]->dof[dof_i]);
+              state_coefs.push_back(current_als[space_i]->coef[dof_i]);
+            }
+          }
+
+          if(record != NULL && (current_mat == NULL || record->has_matrix) && (current_rhs == NULL || record->has_rhs))
+          {
+            // Constraining coefficients may change without the assembly lists changing.
+            bool valid = (state_coefs.size() == record->coefs.size());
+            for(unsigned int coef_i = 0; coef_i < state_coefs.size() && valid; coef_i++)
+              if(std::abs(state_coefs[coef_i] - record->coefs[coef_i]) > 1e-12)
+                valid = false;
+
+            if(valid)
+            {
+              // Replay the stored contributions with the current dof numbers,
+              // the quadrature is skipped entirely.
+              if(current_mat != NULL)
+              {
+                SparseMatrix<Scalar>* target_mat = (this->scatter_mat == NULL) ? current_mat : this->scatter_mat[omp_get_thread_num()];
+                for(unsigned int entry_i = 0; entry_i < record->matrix_values.size(); entry_i++)
+                  target_mat->add(state_dofs[record->matrix_pos_i[entry_i]], state_dofs[record->matrix_pos_j[entry_i]], record->matrix_values[entry_i]);
+              }
+              if(current_rhs != NULL)
+              {
+                Vector<Scalar>* target_rhs = (this->scatter_rhs == NULL) ? current_rhs : this->scatter_rhs[omp_get_thread_num()];
+                for(unsigned int entry_i = 0; entry_i < record->rhs_values.size(); entry_i++)
+                  target_rhs->add(state_dofs[record->rhs_pos[entry_i]], record->rhs_values[entry_i]);
+              }
+
+              // Cleanup as at the end of a full pass.
+              if(current_alsSurface != NULL)
+              {
+                for(unsigned int i = 0; i < this->spaces_size; i++)
+                  if(current_state->e[i] != NULL)
+                    delete [] current_alsSurface[i];
+                delete [] current_alsSurface;
+              }
+              delete [] cacheRecordPerSubIdx;
+              return;
+            }
+          }
+
+          // Record this state anew.
+          StateContributionRecord* new_record = new StateContributionRecord;
+          new_record->coefs = state_coefs;
+          new_record->has_matrix = (current_mat != NULL);
+          new_record->has_rhs = (current_rhs != NULL);
+
+          std::map<int, int>& dof_pos = this->recording_dof_pos[omp_get_thread_num()];
+          dof_pos.clear();
+          for(unsigned int dof_i = 0; dof_i < state_dofs.size(); dof_i++)
+            if(state_dofs[dof_i] >= 0)
+              dof_pos[state_dofs[dof_i]] = dof_i;
+
+          this->recording_contribution[omp_get_thread_num()] = new_record;
+        }
+
         // Ext functions.
         // - order
         int order = cacheRecordPerSubIdx[rep_space_i]->order;
@@ -1652,7 +2660,7 @@ namespace Hermes
           for(int ext_i = 0; ext_i < this->RK_original_spaces_count; ext_i++)
             u_ext[ext_i]->add(ext[current_extCount - this->RK_original_spaces_count + ext_i]);
 
-        if(current_mat != NULL)
+        if(current_mat != NULL || this->matrix_free_apply)
         {
           for(int current_mfvol_i = 0; current_mfvol_i < wf->mfvol.size(); current_mfvol_i++)
           {
@@ -1739,6 +2747,9 @@ namespace Hermes
               // Edge-wise parameters for WeakForm.
               (const_cast<WeakForm<Scalar>*>(current_wf))->set_active_edge_state(current_state->e, current_state->isurf);
 
+              // Traces of form-specific ext functions shared by all surface forms of this edge.
+              SharedSurfaceTraces shared_traces;
+
               // Ext functions.
               // - order
               int orderSurf = cacheRecordPerSubIdx[rep_space_i]->orderSurface[current_state->isurf];
@@ -1771,7 +2782,7 @@ namespace Hermes
                 for(int ext_surf_i = 0; ext_surf_i < this->RK_original_spaces_count; ext_surf_i++)
                   u_extSurf[ext_surf_i]->add(extSurf[current_extCount - this->RK_original_spaces_count + ext_surf_i]);
 
-              if(current_mat != NULL)
+              if(current_mat != NULL || this->matrix_free_apply)
               {
                 for(int current_mfsurf_i = 0; current_mfsurf_i < wf->mfsurf.size(); current_mfsurf_i++)
                 {
@@ -1792,9 +2803,10 @@ namespace Hermes
                     &current_alsSurface[form_i][current_state->isurf], 
                     &current_alsSurface[form_j][current_state->isurf], 
                     current_state, 
-                    CacheRecordPerSubIdxI->n_quadrature_pointsSurface[current_state->isurf], 
-                    CacheRecordPerSubIdxI->geometrySurface[current_state->isurf], 
-                    CacheRecordPerSubIdxI->jacobian_x_weightsSurface[current_state->isurf]);
+                    CacheRecordPerSubIdxI->n_quadrature_pointsSurface[current_state->isurf],
+                    CacheRecordPerSubIdxI->geometrySurface[current_state->isurf],
+                    CacheRecordPerSubIdxI->jacobian_x_weightsSurface[current_state->isurf],
+                    &shared_traces);
                 }
               }
 
@@ -1814,10 +2826,11 @@ namespace Hermes
                     extSurf, 
                     u_extSurf, 
                     &current_alsSurface[form_i][current_state->isurf], 
-                    current_state, 
-                    CacheRecordPerSubIdxI->n_quadrature_pointsSurface[current_state->isurf], 
-                    CacheRecordPerSubIdxI->geometrySurface[current_state->isurf], 
-                    CacheRecordPerSubIdxI->jacobian_x_weightsSurface[current_state->isurf]);
+                    current_state,
+                    CacheRecordPerSubIdxI->n_quadrature_pointsSurface[current_state->isurf],
+                    CacheRecordPerSubIdxI->geometrySurface[current_state->isurf],
+                    CacheRecordPerSubIdxI->jacobian_x_weightsSurface[current_state->isurf],
+                    &shared_traces);
                 }
               }
 
@@ -1839,6 +2852,13 @@ namespace Hermes
                   delete extSurf[ext_surf_i];
                 }
                 delete [] extSurf;
+
+              // Release the traces shared between the surface forms of this edge.
+              for(typename SharedSurfaceTraces::iterator it = shared_traces.begin(); it != shared_traces.end(); ++it)
+              {
+                it->second->free_fn();
+                delete it->second;
+              }
             }
 
             for(unsigned int i = 0; i < this->spaces_size; i++)
@@ -1846,6 +2866,27 @@ namespace Hermes
                 delete [] current_alsSurface[i];
           }
 
+          // Incremental re-assembly: store the freshly recorded contributions.
+          if(this->recording_contribution != NULL && this->recording_contribution[omp_get_thread_num()] != NULL)
+          {
+            int state_rep_id = current_state->rep->id;
+            uint64_t state_sub_idx = current_state->sub_idx[rep_space_i];
+#pragma omp critical (state_contributions_map)
+            {
+              if(this->state_contributions[state_rep_id] == NULL)
+                this->state_contributions[state_rep_id] = new std::map<uint64_t, StateContributionRecord*>;
+              typename std::map<uint64_t, StateContributionRecord*>::iterator it = this->state_contributions[state_rep_id]->find(state_sub_idx);
+              if(it != this->state_contributions[state_rep_id]->end())
+              {
+                delete it->second;
+                it->second = this->recording_contribution[omp_get_thread_num()];
+              }
+              else
+                this->state_contributions[state_rep_id]->insert(std::pair<uint64_t, StateContributionRecord*>(state_sub_idx, this->recording_contribution[omp_get_thread_num()]));
+            }
+            this->recording_contribution[omp_get_thread_num()] = NULL;
+          }
+
           if(cacheRecordPerSubIdx != NULL)
             delete [] cacheRecordPerSubIdx;
           if(current_alsSurface != NULL)
@@ -1853,46 +2894,417 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    int DiscreteProblem<Scalar>::calc_order_matrix_form(MatrixForm<Scalar> *form, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, Traverse::State* current_state)
+    void DiscreteProblem<Scalar>::assemble_one_state_vector_only(PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, Solution<Scalar>** current_u_ext,
+      AsmList<Scalar>** current_als, Traverse::State* current_state, AsmList<Scalar>** current_alsSurface, WeakForm<Scalar>* current_wf)
     {
-      int order;
-
-      // order of solutions from the previous Newton iteration etc..
-      Func<Hermes::Ord>** u_ext_ord = new Func<Hermes::Ord>*[RungeKutta ? RK_original_spaces_count : this->wf->get_neq() - form->u_ext_offset];
-      Func<Hermes::Ord>** ext_ord = NULL;
-      int ext_size = std::max(form->ext.size(), form->wf->ext.size());
-      if(ext_size > 0)
-        ext_ord = new Func<Hermes::Ord>*[ext_size];
-      init_ext_orders(form, u_ext_ord, ext_ord, current_u_ext, current_state);
+      // Only the spaces some vector form tests in are needed, there are no trial functions.
+      bool* space_tested = new bool[this->spaces_size];
+      memset(space_tested, 0, this->spaces_size * sizeof(bool));
+      for(int current_vfvol_i = 0; current_vfvol_i < current_wf->vfvol.size(); current_vfvol_i++)
+        space_tested[current_wf->vfvol[current_vfvol_i]->i] = true;
+      if(current_state->isBnd)
+        for(int current_vfsurf_i = 0; current_vfsurf_i < current_wf->vfsurf.size(); current_vfsurf_i++)
+          space_tested[current_wf->vfsurf[current_vfsurf_i]->i] = true;
 
-      // Order of shape functions.
-      int max_order_j = this->spaces[form->j]->get_element_order(current_state->e[form->j]->id);
-      int max_order_i = this->spaces[form->i]->get_element_order(current_state->e[form->i]->id);
-      if(H2D_GET_V_ORDER(max_order_i) > H2D_GET_H_ORDER(max_order_i))
-        max_order_i = H2D_GET_V_ORDER(max_order_i);
-      else
-        max_order_i = H2D_GET_H_ORDER(max_order_i);
-      if(H2D_GET_V_ORDER(max_order_j) > H2D_GET_H_ORDER(max_order_j))
-        max_order_j = H2D_GET_V_ORDER(max_order_j);
-      else
-        max_order_j = H2D_GET_H_ORDER(max_order_j);
+      int rep_space_i = -1;
+      for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
+        if(current_state->e[space_i] != NULL && space_tested[space_i])
+        {
+          rep_space_i = space_i;
+          break;
+        }
 
-      for (unsigned int k = 0; k < current_state->rep->nvert; k++)
+      if(rep_space_i == -1)
       {
-        int eo = this->spaces[form->i]->get_edge_order(current_state->e[form->i], k);
-        if(eo > max_order_i)
-          max_order_i = eo;
-        eo = this->spaces[form->j]->get_edge_order(current_state->e[form->j], k);
-        if(eo > max_order_j)
-          max_order_j = eo;
+        if(current_alsSurface != NULL)
+        {
+          for(unsigned int i = 0; i < this->spaces_size; i++)
+            if(current_state->e[i] != NULL)
+              delete [] current_alsSurface[i];
+          delete [] current_alsSurface;
+        }
+        delete [] space_tested;
+        return;
       }
 
-      Func<Hermes::Ord>* ou = init_fn_ord(max_order_j + (spaces[form->j]->get_shapeset()->get_num_components() > 1 ? 1 : 0));
-      Func<Hermes::Ord>* ov = init_fn_ord(max_order_i + (spaces[form->i]->get_shapeset()->get_num_components() > 1 ? 1 : 0));
-
-      // Total order of the vector form.
-      Hermes::Ord o = form->ord(1, &fake_wt, u_ext_ord, ou, ov, &geom_ord, ext_ord);
-
+      // Order calculation - the vector forms alone, the matrix forms do not enter here.
+      int order = this->wf->global_integration_order_set ? this->wf->global_integration_order : 0;
+      if(order == 0)
+      {
+        for(int current_vfvol_i = 0; current_vfvol_i < current_wf->vfvol.size(); current_vfvol_i++)
+        {
+          if(!form_to_be_assembled(current_wf->vfvol[current_vfvol_i], current_state))
+            continue;
+          current_wf->vfvol[current_vfvol_i]->wf = current_wf;
+          int orderTemp = calc_order_vector_form(current_wf->vfvol[current_vfvol_i], current_refmaps, current_u_ext, current_state);
+          if(order < orderTemp)
+            order = orderTemp;
+        }
+        if(current_state->isBnd)
+        {
+          for (current_state->isurf = 0; current_state->isurf < current_state->rep->nvert; current_state->isurf++)
+          {
+            if(!current_state->bnd[current_state->isurf])
+              continue;
+            for(int current_vfsurf_i = 0; current_vfsurf_i < current_wf->vfsurf.size(); current_vfsurf_i++)
+            {
+              if(!form_to_be_assembled(current_wf->vfsurf[current_vfsurf_i], current_state))
+                continue;
+              current_wf->vfsurf[current_vfsurf_i]->wf = current_wf;
+              int orderTemp = calc_order_vector_form(current_wf->vfsurf[current_vfsurf_i], current_refmaps, current_u_ext, current_state);
+              if(order < orderTemp)
+                order = orderTemp;
+            }
+          }
+        }
+      }
+
+      // Adaptive quadrature, as in assemble_one_state().
+      if(this->adaptive_quadrature && current_u_ext != NULL)
+      {
+        int reduction = 0;
+        int u_ext_count = RungeKutta ? RK_original_spaces_count : this->wf->get_neq();
+        for(int j = 0; j < u_ext_count; j++)
+        {
+          if(current_u_ext[j] == NULL || current_state->e[j] == NULL)
+            continue;
+          int effective = current_u_ext[j]->get_effective_element_order(current_state->e[j], this->adaptive_quadrature_tolerance);
+          if(effective >= 0 && current_u_ext[j]->elem_orders[current_state->e[j]->id] - effective > reduction)
+            reduction = current_u_ext[j]->elem_orders[current_state->e[j]->id] - effective;
+        }
+        if(reduction > 0)
+          order = std::max(order - reduction, 1);
+      }
+
+      // Test functions and geometry of the tested spaces at this order.
+      Func<double>*** fns = new Func<double>**[this->spaces_size];
+      Geom<double>** geometry = new Geom<double>*[this->spaces_size];
+      double** jacobian_x_weights = new double*[this->spaces_size];
+      int* n_quadrature_points = new int[this->spaces_size];
+      for(unsigned int i = 0; i < this->spaces_size; i++)
+      {
+        fns[i] = NULL;
+        if(current_state->e[i] == NULL || !space_tested[i])
+          continue;
+
+        current_spss[i]->set_active_element(current_state->e[i]);
+        current_spss[i]->set_master_transform();
+        current_refmaps[i]->force_transform(current_pss[i]->get_transform(), current_pss[i]->get_ctm());
+
+        fns[i] = new Func<double>*[current_als[i]->cnt];
+        for (unsigned int j = 0; j < current_als[i]->cnt; j++)
+        {
+          current_spss[i]->set_active_shape(current_als[i]->idx[j]);
+          fns[i][j] = init_fn(current_spss[i], current_refmaps[i], order);
+        }
+
+        n_quadrature_points[i] = init_geometry_points(current_refmaps[i], order, geometry[i], jacobian_x_weights[i]);
+      }
+
+      // Ext functions.
+      // - u_ext
+      Func<Scalar>** u_ext = NULL;
+      int prevNewtonSize = this->wf->get_neq();
+
+      if(!this->is_linear)
+      {
+        u_ext = new Func<Scalar>*[prevNewtonSize];
+        if(current_u_ext != NULL)
+          for(int u_ext_i = 0; u_ext_i < prevNewtonSize; u_ext_i++)
+            if(current_u_ext[u_ext_i] != NULL)
+              u_ext[u_ext_i] = init_fn(current_u_ext[u_ext_i], order);
+            else
+              u_ext[u_ext_i] = NULL;
+        else
+          for(int u_ext_i = 0; u_ext_i < prevNewtonSize; u_ext_i++)
+            u_ext[u_ext_i] = NULL;
+      }
+
+      // - ext
+      int current_extCount = this->wf->ext.size();
+      Func<Scalar>** ext = NULL;
+      if(current_extCount > 0)
+      {
+        ext = new Func<Scalar>*[current_extCount];
+        for(int ext_i = 0; ext_i < current_extCount; ext_i++)
+          if(current_wf->ext[ext_i] != NULL)
+            ext[ext_i] = init_fn(current_wf->ext[ext_i], order);
+          else
+            ext[ext_i] = NULL;
+      }
+
+      if(RungeKutta)
+        for(int ext_i = 0; ext_i < this->RK_original_spaces_count; ext_i++)
+          u_ext[ext_i]->add(ext[current_extCount - this->RK_original_spaces_count + ext_i]);
+
+      for(int current_vfvol_i = 0; current_vfvol_i < current_wf->vfvol.size(); current_vfvol_i++)
+      {
+        VectorFormVol<Scalar>* vfv = current_wf->vfvol[current_vfvol_i];
+
+        if(!form_to_be_assembled(vfv, current_state))
+          continue;
+
+        int form_i = vfv->i;
+
+        assemble_vector_form(vfv,
+          order,
+          fns[form_i],
+          ext,
+          u_ext,
+          current_als[form_i],
+          current_state,
+          n_quadrature_points[form_i],
+          geometry[form_i],
+          jacobian_x_weights[form_i]);
+      }
+
+      // Cleanup - u_ext
+      if(current_u_ext != NULL)
+      {
+        for(int u_ext_i = 0; u_ext_i < prevNewtonSize; u_ext_i++)
+          if(current_u_ext[u_ext_i] != NULL && current_state->e[u_ext_i] != NULL)
+          {
+            u_ext[u_ext_i]->free_fn();
+            delete u_ext[u_ext_i];
+          }
+          delete [] u_ext;
+      }
+
+      // Cleanup - ext
+      for(int ext_i = 0; ext_i < current_extCount; ext_i++)
+      {
+        if(current_wf->ext[ext_i] != NULL)
+        {
+          ext[ext_i]->free_fn();
+          delete ext[ext_i];
+        }
+      }
+        delete [] ext;
+
+        // Assemble surface integrals now: loop through surfaces of the element.
+        if(current_state->isBnd && current_wf->vfsurf.size() > 0)
+        {
+          for (current_state->isurf = 0; current_state->isurf < current_state->rep->nvert; current_state->isurf++)
+          {
+            if(!current_state->bnd[current_state->isurf])
+              continue;
+
+            // Edge-wise parameters for WeakForm.
+            (const_cast<WeakForm<Scalar>*>(current_wf))->set_active_edge_state(current_state->e, current_state->isurf);
+
+            // Traces of form-specific ext functions shared by all surface forms of this edge.
+            SharedSurfaceTraces shared_traces;
+
+            // Test functions and geometry of this edge for the tested spaces.
+            Func<double>*** fnsSurface = new Func<double>**[this->spaces_size];
+            Geom<double>** geometrySurface = new Geom<double>*[this->spaces_size];
+            double** jacobian_x_weightsSurface = new double*[this->spaces_size];
+            int* n_quadrature_pointsSurface = new int[this->spaces_size];
+            int* orderSurface = new int[this->spaces_size];
+            for(unsigned int i = 0; i < this->spaces_size; i++)
+            {
+              fnsSurface[i] = NULL;
+              if(current_state->e[i] == NULL || !space_tested[i])
+                continue;
+
+              orderSurface[i] = order;
+              n_quadrature_pointsSurface[i] = init_surface_geometry_points(current_refmaps[i], orderSurface[i], current_state, geometrySurface[i], jacobian_x_weightsSurface[i]);
+
+              fnsSurface[i] = new Func<double>*[current_alsSurface[i][current_state->isurf].cnt];
+              for (unsigned int j = 0; j < current_alsSurface[i][current_state->isurf].cnt; j++)
+              {
+                current_spss[i]->set_active_shape(current_alsSurface[i][current_state->isurf].idx[j]);
+                fnsSurface[i][j] = init_fn(current_spss[i], current_refmaps[i], orderSurface[i]);
+              }
+            }
+
+            // Ext functions.
+            // - u_ext
+            Func<Scalar>** u_extSurf = NULL;
+            if(!this->is_linear)
+            {
+              u_extSurf = new Func<Scalar>*[prevNewtonSize];
+              if(current_u_ext != NULL)
+                for(int u_ext_surf_i = 0; u_ext_surf_i < prevNewtonSize; u_ext_surf_i++)
+                  if(current_u_ext[u_ext_surf_i] != NULL)
+                    u_extSurf[u_ext_surf_i] = current_state->e[u_ext_surf_i] == NULL ? NULL : init_fn(current_u_ext[u_ext_surf_i], orderSurface[rep_space_i]);
+                  else
+                    u_extSurf[u_ext_surf_i] = NULL;
+              else
+                for(int u_ext_surf_i = 0; u_ext_surf_i < prevNewtonSize; u_ext_surf_i++)
+                  u_extSurf[u_ext_surf_i] = NULL;
+            }
+            // - ext
+            Func<Scalar>** extSurf = new Func<Scalar>*[current_extCount];
+            for(int ext_surf_i = 0; ext_surf_i < current_extCount; ext_surf_i++)
+              if(current_wf->ext[ext_surf_i] != NULL)
+                extSurf[ext_surf_i] = current_state->e[ext_surf_i] == NULL ? NULL : init_fn(current_wf->ext[ext_surf_i], orderSurface[rep_space_i]);
+              else
+                extSurf[ext_surf_i] = NULL;
+
+            if(RungeKutta)
+              for(int ext_surf_i = 0; ext_surf_i < this->RK_original_spaces_count; ext_surf_i++)
+                u_extSurf[ext_surf_i]->add(extSurf[current_extCount - this->RK_original_spaces_count + ext_surf_i]);
+
+            for(int current_vfsurf_i = 0; current_vfsurf_i < current_wf->vfsurf.size(); current_vfsurf_i++)
+            {
+              if(!form_to_be_assembled(current_wf->vfsurf[current_vfsurf_i], current_state))
+                continue;
+
+              int form_i = current_wf->vfsurf[current_vfsurf_i]->i;
+
+              assemble_vector_form(current_wf->vfsurf[current_vfsurf_i],
+                orderSurface[form_i],
+                fnsSurface[form_i],
+                extSurf,
+                u_extSurf,
+                &current_alsSurface[form_i][current_state->isurf],
+                current_state,
+                n_quadrature_pointsSurface[form_i],
+                geometrySurface[form_i],
+                jacobian_x_weightsSurface[form_i],
+                &shared_traces);
+            }
+
+            if(current_u_ext != NULL)
+            {
+              for(int u_ext_surf_i = 0; u_ext_surf_i < prevNewtonSize; u_ext_surf_i++)
+                if(current_u_ext[u_ext_surf_i] != NULL)
+                {
+                  u_extSurf[u_ext_surf_i]->free_fn();
+                  delete u_extSurf[u_ext_surf_i];
+                }
+                delete [] u_extSurf;
+            }
+
+            for(int ext_surf_i = 0; ext_surf_i < current_extCount; ext_surf_i++)
+              if(current_wf->ext[ext_surf_i] != NULL)
+              {
+                extSurf[ext_surf_i]->free_fn();
+                delete extSurf[ext_surf_i];
+              }
+              delete [] extSurf;
+
+            // Release the traces shared between the surface forms of this edge.
+            for(typename SharedSurfaceTraces::iterator it = shared_traces.begin(); it != shared_traces.end(); ++it)
+            {
+              it->second->free_fn();
+              delete it->second;
+            }
+
+            for(unsigned int i = 0; i < this->spaces_size; i++)
+            {
+              if(fnsSurface[i] == NULL)
+                continue;
+              for (unsigned int j = 0; j < current_alsSurface[i][current_state->isurf].cnt; j++)
+              {
+                fnsSurface[i][j]->free_fn();
+                delete fnsSurface[i][j];
+              }
+              delete [] fnsSurface[i];
+              delete [] jacobian_x_weightsSurface[i];
+              geometrySurface[i]->free();
+              delete geometrySurface[i];
+            }
+            delete [] fnsSurface;
+            delete [] geometrySurface;
+            delete [] jacobian_x_weightsSurface;
+            delete [] n_quadrature_pointsSurface;
+            delete [] orderSurface;
+          }
+        }
+
+        // Cleanup - test functions and geometry.
+        for(unsigned int i = 0; i < this->spaces_size; i++)
+        {
+          if(fns[i] == NULL)
+            continue;
+          for (unsigned int j = 0; j < current_als[i]->cnt; j++)
+          {
+            fns[i][j]->free_fn();
+            delete fns[i][j];
+          }
+          delete [] fns[i];
+          delete [] jacobian_x_weights[i];
+          geometry[i]->free();
+          delete geometry[i];
+        }
+        delete [] fns;
+        delete [] geometry;
+        delete [] jacobian_x_weights;
+        delete [] n_quadrature_points;
+        delete [] space_tested;
+
+        if(current_alsSurface != NULL)
+        {
+          for(unsigned int i = 0; i < this->spaces_size; i++)
+            if(current_state->e[i] != NULL)
+              delete [] current_alsSurface[i];
+          delete [] current_alsSurface;
+        }
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::calc_order_matrix_form(MatrixForm<Scalar> *form, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, Traverse::State* current_state)
+    {
+      int order;
+
+      // Order of shape functions.
+      int max_order_j = this->spaces[form->j]->get_element_order(current_state->e[form->j]->id);
+      int max_order_i = this->spaces[form->i]->get_element_order(current_state->e[form->i]->id);
+      if(H2D_GET_V_ORDER(max_order_i) > H2D_GET_H_ORDER(max_order_i))
+        max_order_i = H2D_GET_V_ORDER(max_order_i);
+      else
+        max_order_i = H2D_GET_H_ORDER(max_order_i);
+      if(H2D_GET_V_ORDER(max_order_j) > H2D_GET_H_ORDER(max_order_j))
+        max_order_j = H2D_GET_V_ORDER(max_order_j);
+      else
+        max_order_j = H2D_GET_H_ORDER(max_order_j);
+
+      for (unsigned int k = 0; k < current_state->rep->nvert; k++)
+      {
+        int eo = this->spaces[form->i]->get_edge_order(current_state->e[form->i], k);
+        if(eo > max_order_i)
+          max_order_i = eo;
+        eo = this->spaces[form->j]->get_edge_order(current_state->e[form->j], k);
+        if(eo > max_order_j)
+          max_order_j = eo;
+      }
+
+      // Memoized Ord evaluation - elements with the same order signature resolve to
+      // the same total form order, only the reference map adjustment is per-element.
+      std::vector<int> signature;
+      if(this->order_cache)
+      {
+        calc_order_signature(form, current_u_ext, current_state, signature);
+        signature.push_back(max_order_i);
+        signature.push_back(max_order_j);
+        std::map<std::vector<int>, int>::const_iterator found = form->order_cache.find(signature);
+        if(found != form->order_cache.end())
+        {
+          Hermes::Ord o(found->second);
+          adjust_order_to_refmaps(form, order, &o, current_refmaps);
+          return order;
+        }
+      }
+
+      // order of solutions from the previous Newton iteration etc..
+      Func<Hermes::Ord>** u_ext_ord = new Func<Hermes::Ord>*[RungeKutta ? RK_original_spaces_count : this->wf->get_neq() - form->u_ext_offset];
+      Func<Hermes::Ord>** ext_ord = NULL;
+      int ext_size = std::max(form->ext.size(), form->wf->ext.size());
+      if(ext_size > 0)
+        ext_ord = new Func<Hermes::Ord>*[ext_size];
+      init_ext_orders(form, u_ext_ord, ext_ord, current_u_ext, current_state);
+
+      Func<Hermes::Ord>* ou = init_fn_ord(max_order_j + (spaces[form->j]->get_shapeset()->get_num_components() > 1 ? 1 : 0));
+      Func<Hermes::Ord>* ov = init_fn_ord(max_order_i + (spaces[form->i]->get_shapeset()->get_num_components() > 1 ? 1 : 0));
+
+      // Total order of the vector form.
+      Hermes::Ord o = form->ord(1, &fake_wt, u_ext_ord, ou, ov, &geom_ord, ext_ord);
+
+      if(this->order_cache)
+        form->order_cache[signature] = o.get_order();
+
       adjust_order_to_refmaps(form, order, &o, current_refmaps);
 
       // Cleanup.
@@ -1906,19 +3318,104 @@ namespace Hermes
       return order;
     }
 
+    template<typename Scalar>
+    Scalar** DiscreteProblem<Scalar>::get_local_stiffness_scratch(unsigned int size)
+    {
+      if(this->local_stiffness_scratch == NULL)
+        return NULL;
+
+      int thread = omp_get_thread_num();
+      if(this->local_stiffness_scratch[thread] == NULL || this->local_stiffness_scratch_size[thread] < size)
+      {
+        if(this->local_stiffness_scratch[thread] != NULL)
+          delete [] this->local_stiffness_scratch[thread];
+        // new_matrix() returns the buffer zeroed.
+        this->local_stiffness_scratch[thread] = new_matrix<Scalar>(size);
+        this->local_stiffness_scratch_size[thread] = size;
+        return this->local_stiffness_scratch[thread];
+      }
+
+      Scalar** scratch = this->local_stiffness_scratch[thread];
+      unsigned int cap = this->local_stiffness_scratch_size[thread];
+      // The data block follows the row pointers, see new_matrix().
+      memset(scratch + cap, 0, cap * cap * sizeof(Scalar));
+      return scratch;
+    }
+
+    /// The physical derivatives carry the inverse reference map of the element,
+    /// which det(J) x weights alone does not determine - the signature is what
+    /// makes the cache verification reject equal-area elements of different shapes.
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::append_fn_signature(Func<double>* fn, int np, double* signature, int pos)
+    {
+      double* fields[8];
+      int n_fields = 0;
+      if(fn->nc == 1)
+      {
+        if(fn->val != NULL) fields[n_fields++] = fn->val;
+        if(fn->dx != NULL) fields[n_fields++] = fn->dx;
+        if(fn->dy != NULL) fields[n_fields++] = fn->dy;
+#ifdef H2D_USE_SECOND_DERIVATIVES
+        if(fn->laplace != NULL) fields[n_fields++] = fn->laplace;
+#endif
+      }
+      else
+      {
+        if(fn->val0 != NULL) fields[n_fields++] = fn->val0;
+        if(fn->val1 != NULL) fields[n_fields++] = fn->val1;
+        if(fn->dx0 != NULL) fields[n_fields++] = fn->dx0;
+        if(fn->dx1 != NULL) fields[n_fields++] = fn->dx1;
+        if(fn->dy0 != NULL) fields[n_fields++] = fn->dy0;
+        if(fn->dy1 != NULL) fields[n_fields++] = fn->dy1;
+        if(fn->curl != NULL) fields[n_fields++] = fn->curl;
+        if(fn->div != NULL) fields[n_fields++] = fn->div;
+      }
+      for (int f = 0; f < n_fields; f++)
+      {
+        if(signature != NULL)
+          memcpy(signature + pos, fields[f], np * sizeof(double));
+        pos += np;
+      }
+      return pos;
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::build_const_coeff_signature(Func<double>** test_fns, int cnt_i, Func<double>** base_fns, int cnt_j, int np, double* signature)
+    {
+      int pos = 0;
+      for (int i = 0; i < cnt_i; i++)
+        pos = append_fn_signature(test_fns[i], np, signature, pos);
+      for (int j = 0; j < cnt_j; j++)
+        pos = append_fn_signature(base_fns[j], np, signature, pos);
+      return pos;
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
-      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights)
+      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights,
+      SharedSurfaceTraces* shared_traces)
     {
       bool surface_form = (dynamic_cast<MatrixFormVol<Scalar>*>(form) == NULL);
 
+      // Preload the declared material coefficient of the assembled element or
+      // edge. \sa Form::set_material_coefficient().
+      if(!form->material_table.empty())
+      {
+        int material_marker = surface_form ? current_state->rep->en[current_state->isurf]->marker : current_state->rep->marker;
+        form->material_coefficient = (material_marker >= 0 && material_marker < (int)form->material_table.size())
+          ? form->material_table[material_marker] : Scalar(0.);
+      }
+
       double block_scaling_coefficient = this->block_scaling_coeff(form);
 
       bool tra = (form->i != form->j) && (form->sym != 0);
       bool sym = (form->i == form->j) && (form->sym == 1);
 
       // Assemble the local stiffness matrix for the form form.
-      Scalar **local_stiffness_matrix = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
+      Scalar **local_stiffness_matrix = this->get_local_stiffness_scratch(std::max(current_als_i->cnt, current_als_j->cnt));
+      bool own_local_matrix = (local_stiffness_matrix == NULL);
+      if(own_local_matrix)
+        local_stiffness_matrix = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
 
       Func<Scalar>** local_ext = ext;
       // If the user supplied custom ext functions for this form.
@@ -1928,7 +3425,25 @@ namespace Hermes
         local_ext = new Func<Scalar>*[local_ext_count];
         for(int ext_i = 0; ext_i < local_ext_count; ext_i++)
           if(form->ext[ext_i] != NULL)
-            local_ext[ext_i] = current_state->e[ext_i] == NULL ? NULL : init_fn(form->ext[ext_i], order);
+          {
+            if(current_state->e[ext_i] == NULL)
+              local_ext[ext_i] = NULL;
+            else if(shared_traces != NULL)
+            {
+              // The surface loop shares each distinct (function, order) trace between
+              // the forms of the edge - initialize on the first request only.
+              typename SharedSurfaceTraces::iterator found = shared_traces->find(std::make_pair(form->ext[ext_i], order));
+              if(found != shared_traces->end())
+                local_ext[ext_i] = found->second;
+              else
+              {
+                local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+                (*shared_traces)[std::make_pair(form->ext[ext_i], order)] = local_ext[ext_i];
+              }
+            }
+            else
+              local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+          }
           else
             local_ext[ext_i] = NULL;
       }
@@ -1937,7 +3452,119 @@ namespace Hermes
       if(RungeKutta)
         u_ext += form->u_ext_offset;
 
+      // Local matrix cache for constant-coefficient forms.
+      // Elements with identical signatures (mode, order, assembly lists, Jacobian
+      // factors and baked basis data) share the local matrix, so the quadrature
+      // loop runs only once per signature.
+      // Boundary edges are grouped the same way; the encoded surface order carries the
+      // edge number and the marker enters the key below.
+      MatrixFormVol<Scalar>* form_vol = surface_form ? NULL : static_cast<MatrixFormVol<Scalar>*>(form);
+      MatrixFormSurf<Scalar>* form_surf = surface_form ? dynamic_cast<MatrixFormSurf<Scalar>*>(form) : NULL;
+      bool cache_const_coeff = ((form_vol != NULL && form_vol->get_const_coefficient())
+        || (form_surf != NULL && form_surf->get_const_coefficient())) && !this->do_not_use_cache
+        && current_state->sub_idx[form->i] == 0 && current_state->sub_idx[form->j] == 0;
+      // The cached values do not contain the assembly list coefficients, these differ
+      // on constrained elements.
+      if(cache_const_coeff)
+      {
+        for (unsigned int i = 0; i < current_als_i->cnt && cache_const_coeff; i++)
+          if(std::abs(current_als_i->coef[i] - 1.0) > 1e-12)
+            cache_const_coeff = false;
+        for (unsigned int j = 0; j < current_als_j->cnt && cache_const_coeff; j++)
+          if(std::abs(current_als_j->coef[j] - 1.0) > 1e-12)
+            cache_const_coeff = false;
+      }
+
+      uint64_t const_coeff_key = 0;
+      bool reused = false;
+      if(cache_const_coeff)
+      {
+        const_coeff_key = (uint64_t)order | ((uint64_t)current_state->rep->get_mode() << 10)
+          | ((uint64_t)current_als_i->cnt << 11) | ((uint64_t)current_als_j->cnt << 23)
+          | ((uint64_t)form->i << 35) | ((uint64_t)form->j << 43) | ((uint64_t)(form->sym + 1) << 51);
+        if(surface_form)
+          const_coeff_key ^= ((uint64_t)1 << 62)
+            | ((uint64_t)current_state->rep->en[current_state->isurf]->marker * (uint64_t)0x9E3779B97F4A7C15ULL);
+
+        ConstCoeffCacheRecord* record = NULL;
+#pragma omp critical (const_coeff_cache)
+        {
+          typename std::map<uint64_t, ConstCoeffCacheRecord*>::iterator it = this->const_coeff_cache.find(const_coeff_key);
+          if(it != this->const_coeff_cache.end())
+            record = it->second;
+        }
+
+        // Records are immutable once inserted, so they can be read without locking.
+        if(record != NULL && record->n_quadrature_points == n_quadrature_points
+          && record->cnt_i == (int)current_als_i->cnt && record->cnt_j == (int)current_als_j->cnt)
+        {
+          bool matches = (memcmp(record->idx_i, current_als_i->idx, current_als_i->cnt * sizeof(int)) == 0)
+            && (memcmp(record->idx_j, current_als_j->idx, current_als_j->cnt * sizeof(int)) == 0);
+          for(int point_i = 0; point_i < n_quadrature_points && matches; point_i++)
+            if(std::abs(record->jacobian_x_weights[point_i] - jacobian_x_weights[point_i]) > 1e-12 * std::abs(jacobian_x_weights[point_i]))
+              matches = false;
+
+          // The baked basis data has to match as well: det(J) x weights does not
+          // carry the inverse reference map, so two equal-area elements of
+          // different shapes would otherwise exchange stiffness matrices.
+          if(matches)
+          {
+            int signature_length = build_const_coeff_signature(test_fns, current_als_i->cnt, base_fns, current_als_j->cnt, n_quadrature_points, NULL);
+            if(signature_length != record->signature_length)
+              matches = false;
+            else
+            {
+              double* signature = new double[signature_length];
+              build_const_coeff_signature(test_fns, current_als_i->cnt, base_fns, current_als_j->cnt, n_quadrature_points, signature);
+              double tolerance = 1e-12 * record->signature_scale;
+              for(int s = 0; s < signature_length && matches; s++)
+                if(std::abs(signature[s] - record->fn_signature[s]) > tolerance)
+                  matches = false;
+              delete [] signature;
+            }
+          }
+          if(matches)
+          {
+            for (unsigned int i = 0; i < current_als_i->cnt; i++)
+              memcpy(local_stiffness_matrix[i], record->values[i], current_als_j->cnt * sizeof(Scalar));
+            reused = true;
+          }
+        }
+      }
+
+      // Batch kernel: volumetric forms overriding value_block() fill the whole local
+      // matrix in one call, without one virtual dispatch per basis / test function pair.
+      // The scaling and the assembly list coefficients are applied here afterwards.
+      bool block_evaluated = false;
+      if(!reused && !surface_form)
+        if(form_vol->value_block(n_quadrature_points, jacobian_x_weights, u_ext, base_fns, current_als_j->cnt, test_fns, current_als_i->cnt, geometry, local_ext, local_stiffness_matrix))
+        {
+          block_evaluated = true;
+          for (unsigned int i = 0; i < current_als_i->cnt; i++)
+            for (unsigned int j = 0; j < current_als_j->cnt; j++)
+              local_stiffness_matrix[i][j] *= block_scaling_coefficient * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+
+          // The per-pair path below evaluates a symmetric block only above the diagonal
+          // and assigns the mirrored value - do the same so that the results match.
+          if(sym)
+            for (unsigned int i = 0; i < current_als_i->cnt; i++)
+              for (unsigned int j = 0; j < i && j < current_als_j->cnt; j++)
+                local_stiffness_matrix[i][j] = local_stiffness_matrix[j][i];
+        }
+
+      // Surface counterpart of the batch kernel; the 0.5 edge factor is applied
+      // together with the scaling.
+      if(!reused && form_surf != NULL)
+        if(form_surf->value_block(n_quadrature_points, jacobian_x_weights, u_ext, base_fns, current_als_j->cnt, test_fns, current_als_i->cnt, geometry, local_ext, local_stiffness_matrix))
+        {
+          block_evaluated = true;
+          for (unsigned int i = 0; i < current_als_i->cnt; i++)
+            for (unsigned int j = 0; j < current_als_j->cnt; j++)
+              local_stiffness_matrix[i][j] *= 0.5 * block_scaling_coefficient * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+        }
+
       // Actual form-specific calculation.
+      if(!reused && !block_evaluated)
       for (unsigned int i = 0; i < current_als_i->cnt; i++)
       {
         if(current_als_i->dof[i] < 0)
@@ -1991,36 +3618,132 @@ namespace Hermes
         }
       }
 
-      // Insert the local stiffness matrix into the global one.
+      // Store the freshly computed local matrix. Only matrices with all DOFs unconstrained
+      // and assembled are stored, partially assembled ones (Dirichlet rows / columns are
+      // skipped above) would poison the cache.
+      if(cache_const_coeff && !reused)
+      {
+        bool fully_assembled = true;
+        for (unsigned int i = 0; i < current_als_i->cnt && fully_assembled; i++)
+          if(current_als_i->dof[i] < 0)
+            fully_assembled = false;
+        for (unsigned int j = 0; j < current_als_j->cnt && fully_assembled; j++)
+          if(current_als_j->dof[j] < 0)
+            fully_assembled = false;
+
+        if(fully_assembled)
+        {
+          ConstCoeffCacheRecord* record = new ConstCoeffCacheRecord;
+          record->cnt_i = current_als_i->cnt;
+          record->cnt_j = current_als_j->cnt;
+          record->n_quadrature_points = n_quadrature_points;
+          record->idx_i = new int[current_als_i->cnt];
+          memcpy(record->idx_i, current_als_i->idx, current_als_i->cnt * sizeof(int));
+          record->idx_j = new int[current_als_j->cnt];
+          memcpy(record->idx_j, current_als_j->idx, current_als_j->cnt * sizeof(int));
+          record->jacobian_x_weights = new double[n_quadrature_points];
+          memcpy(record->jacobian_x_weights, jacobian_x_weights, n_quadrature_points * sizeof(double));
+          record->signature_length = build_const_coeff_signature(test_fns, current_als_i->cnt, base_fns, current_als_j->cnt, n_quadrature_points, NULL);
+          record->fn_signature = new double[record->signature_length];
+          build_const_coeff_signature(test_fns, current_als_i->cnt, base_fns, current_als_j->cnt, n_quadrature_points, record->fn_signature);
+          record->signature_scale = 1.0;
+          for(int s = 0; s < record->signature_length; s++)
+            if(std::abs(record->fn_signature[s]) > record->signature_scale)
+              record->signature_scale = std::abs(record->fn_signature[s]);
+          record->values = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
+          for (unsigned int i = 0; i < current_als_i->cnt; i++)
+            memcpy(record->values[i], local_stiffness_matrix[i], current_als_j->cnt * sizeof(Scalar));
+
+#pragma omp critical (const_coeff_cache)
+          {
+            if(this->const_coeff_cache.find(const_coeff_key) == this->const_coeff_cache.end())
+              this->const_coeff_cache.insert(std::pair<uint64_t, ConstCoeffCacheRecord*>(const_coeff_key, record));
+            else
+            {
+              // Another thread beat us to it.
+              record->clear();
+              delete record;
+            }
+          }
+        }
+      }
 
-      current_mat->add(current_als_i->cnt, current_als_j->cnt, local_stiffness_matrix, current_als_i->dof, current_als_j->dof);
+      if(this->matrix_free_apply)
+      {
+        // Matrix-free mode: the local matrix multiplies the input vector right away,
+        // each thread accumulates into its own copy of the result vector.
+        Scalar* result = this->apply_y[omp_get_thread_num()];
 
-      // Insert also the off-diagonal (anti-)symmetric block, if required.
-      if(tra)
+        for (unsigned int i = 0; i < current_als_i->cnt; i++)
+        {
+          if(current_als_i->dof[i] < 0)
+            continue;
+          for (unsigned int j = 0; j < current_als_j->cnt; j++)
+            if(current_als_j->dof[j] >= 0)
+              result[current_als_i->dof[i]] += local_stiffness_matrix[i][j] * this->apply_x[current_als_j->dof[j]];
+        }
+
+        // The off-diagonal (anti-)symmetric block, if required.
+        if(tra)
+        {
+          if(form->sym < 0)
+            chsgn(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt);
+          transpose(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt);
+
+          for (unsigned int i = 0; i < current_als_j->cnt; i++)
+          {
+            if(current_als_j->dof[i] < 0)
+              continue;
+            for (unsigned int j = 0; j < current_als_i->cnt; j++)
+              if(current_als_i->dof[j] >= 0)
+                result[current_als_j->dof[i]] += local_stiffness_matrix[i][j] * this->apply_x[current_als_i->dof[j]];
+          }
+        }
+      }
+      else
       {
-        if(form->sym < 0)
-          chsgn(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt);
-        transpose(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt);
+        // Insert the local stiffness matrix into the global one.
+        // With scatter matrices in use, each thread inserts into its own copy.
+        SparseMatrix<Scalar>* target_mat = (this->scatter_mat == NULL) ? current_mat : this->scatter_mat[omp_get_thread_num()];
+
+        bool recording = (this->recording_contribution != NULL && this->recording_contribution[omp_get_thread_num()] != NULL);
+
+        target_mat->add(current_als_i->cnt, current_als_j->cnt, local_stiffness_matrix, current_als_i->dof, current_als_j->dof);
+        if(recording)
+          this->record_local_matrix(local_stiffness_matrix, current_als_i, current_als_j);
+
+        // Insert also the off-diagonal (anti-)symmetric block, if required.
+        if(tra)
+        {
+          if(form->sym < 0)
+            chsgn(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt);
+          transpose(local_stiffness_matrix, current_als_i->cnt, current_als_j->cnt);
 
-        current_mat->add(current_als_j->cnt, current_als_i->cnt, local_stiffness_matrix, current_als_j->dof, current_als_i->dof);
+          target_mat->add(current_als_j->cnt, current_als_i->cnt, local_stiffness_matrix, current_als_j->dof, current_als_i->dof);
+          if(recording)
+            this->record_local_matrix(local_stiffness_matrix, current_als_j, current_als_i);
+        }
       }
 
       if(form->ext.size() > 0)
       {
-        for(int ext_i = 0; ext_i < form->ext.size(); ext_i++)
-          if(form->ext[ext_i] != NULL)
-          {
-            local_ext[ext_i]->free_fn();
-            delete local_ext[ext_i];
-          }
-          delete [] local_ext;
+        // Shared traces are owned (and later released) by the surface loop.
+        if(shared_traces == NULL)
+          for(int ext_i = 0; ext_i < form->ext.size(); ext_i++)
+            if(local_ext[ext_i] != NULL)
+            {
+              local_ext[ext_i]->free_fn();
+              delete local_ext[ext_i];
+            }
+        delete [] local_ext;
       }
 
       if(RungeKutta)
         u_ext -= form->u_ext_offset;
 
       // Cleanup.
-      delete [] local_stiffness_matrix;
+      if(own_local_matrix)
+        delete [] local_stiffness_matrix;
     }
 
     template<typename Scalar>
@@ -2028,14 +3751,6 @@ namespace Hermes
     {
       int order;
 
-      // order of solutions from the previous Newton iteration etc..
-      Func<Hermes::Ord>** u_ext_ord = new Func<Hermes::Ord>*[RungeKutta ? RK_original_spaces_count : this->wf->get_neq() - form->u_ext_offset];
-      Func<Hermes::Ord>** ext_ord = NULL;
-      int ext_size = std::max(form->ext.size(), form->wf->ext.size());
-      if(ext_size > 0)
-        ext_ord = new Func<Hermes::Ord>*[ext_size];
-      init_ext_orders(form, u_ext_ord, ext_ord, current_u_ext, current_state);
-
       // Order of shape functions.
       int max_order_i = this->spaces[form->i]->get_element_order(current_state->e[form->i]->id);
       if(H2D_GET_V_ORDER(max_order_i) > H2D_GET_H_ORDER(max_order_i))
@@ -2049,11 +3764,38 @@ namespace Hermes
         if(eo > max_order_i)
           max_order_i = eo;
       }
+
+      // Memoized Ord evaluation, as in calc_order_matrix_form().
+      std::vector<int> signature;
+      if(this->order_cache)
+      {
+        calc_order_signature(form, current_u_ext, current_state, signature);
+        signature.push_back(max_order_i);
+        std::map<std::vector<int>, int>::const_iterator found = form->order_cache.find(signature);
+        if(found != form->order_cache.end())
+        {
+          Hermes::Ord o(found->second);
+          adjust_order_to_refmaps(form, order, &o, current_refmaps);
+          return order;
+        }
+      }
+
+      // order of solutions from the previous Newton iteration etc..
+      Func<Hermes::Ord>** u_ext_ord = new Func<Hermes::Ord>*[RungeKutta ? RK_original_spaces_count : this->wf->get_neq() - form->u_ext_offset];
+      Func<Hermes::Ord>** ext_ord = NULL;
+      int ext_size = std::max(form->ext.size(), form->wf->ext.size());
+      if(ext_size > 0)
+        ext_ord = new Func<Hermes::Ord>*[ext_size];
+      init_ext_orders(form, u_ext_ord, ext_ord, current_u_ext, current_state);
+
       Func<Hermes::Ord>* ov = init_fn_ord(max_order_i + (spaces[form->i]->get_shapeset()->get_num_components() > 1 ? 1 : 0));
 
       // Total order of the vector form.
       Hermes::Ord o = form->ord(1, &fake_wt, u_ext_ord, ov, &geom_ord, ext_ord);
 
+      if(this->order_cache)
+        form->order_cache[signature] = o.get_order();
+
       adjust_order_to_refmaps(form, order, &o, current_refmaps);
 
       // Cleanup.
@@ -2066,11 +3808,21 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void DiscreteProblem<Scalar>::assemble_vector_form(VectorForm<Scalar>* form, int order, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext, 
-      AsmList<Scalar>* current_als_i, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights)
+    void DiscreteProblem<Scalar>::assemble_vector_form(VectorForm<Scalar>* form, int order, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
+      AsmList<Scalar>* current_als_i, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights,
+      SharedSurfaceTraces* shared_traces)
     {
       bool surface_form = (dynamic_cast<VectorFormVol<Scalar>*>(form) == NULL);
 
+      // Preload the declared material coefficient of the assembled element or
+      // edge. \sa Form::set_material_coefficient().
+      if(!form->material_table.empty())
+      {
+        int material_marker = surface_form ? current_state->rep->en[current_state->isurf]->marker : current_state->rep->marker;
+        form->material_coefficient = (material_marker >= 0 && material_marker < (int)form->material_table.size())
+          ? form->material_table[material_marker] : Scalar(0.);
+      }
+
       Func<Scalar>** local_ext = ext;
 
       // If the user supplied custom ext functions for this form.
@@ -2080,7 +3832,23 @@ namespace Hermes
         local_ext = new Func<Scalar>*[local_ext_count];
         for(int ext_i = 0; ext_i < local_ext_count; ext_i++)
           if(form->ext[ext_i] != NULL)
-            local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+          {
+            if(shared_traces != NULL)
+            {
+              // The surface loop shares each distinct (function, order) trace between
+              // the forms of the edge - initialize on the first request only.
+              typename SharedSurfaceTraces::iterator found = shared_traces->find(std::make_pair(form->ext[ext_i], order));
+              if(found != shared_traces->end())
+                local_ext[ext_i] = found->second;
+              else
+              {
+                local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+                (*shared_traces)[std::make_pair(form->ext[ext_i], order)] = local_ext[ext_i];
+              }
+            }
+            else
+              local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+          }
           else
             local_ext[ext_i] = NULL;
       }
@@ -2089,7 +3857,35 @@ namespace Hermes
       if(RungeKutta)
         u_ext += form->u_ext_offset;
 
+      // Batch kernel: surface forms overriding value_block() fill all test function
+      // contributions of the edge in one call, see VectorFormSurf::value_block().
+      bool block_evaluated = false;
+      VectorFormSurf<Scalar>* form_surf = surface_form ? dynamic_cast<VectorFormSurf<Scalar>*>(form) : NULL;
+      if(form_surf != NULL)
+      {
+        Scalar* local_rhs = new Scalar[current_als_i->cnt];
+        if(form_surf->value_block(n_quadrature_points, jacobian_x_weights, u_ext, test_fns, current_als_i->cnt, geometry, local_ext, local_rhs))
+        {
+          block_evaluated = true;
+          for (unsigned int i = 0; i < current_als_i->cnt; i++)
+          {
+            if(current_als_i->dof[i] < 0)
+              continue;
+            if(std::abs(current_als_i->coef[i]) < 1e-12)
+              continue;
+
+            Scalar val = 0.5 * local_rhs[i] * form->scaling_factor * current_als_i->coef[i];
+            Vector<Scalar>* target_rhs = (this->scatter_rhs == NULL) ? current_rhs : this->scatter_rhs[omp_get_thread_num()];
+            target_rhs->add(current_als_i->dof[i], val);
+            if(this->recording_contribution != NULL && this->recording_contribution[omp_get_thread_num()] != NULL)
+              this->record_local_rhs(current_als_i->dof[i], val);
+          }
+        }
+        delete [] local_rhs;
+      }
+
       // Actual form-specific calculation.
+      if(!block_evaluated)
       for (unsigned int i = 0; i < current_als_i->cnt; i++)
       {
         if(current_als_i->dof[i] < 0)
@@ -2107,18 +3903,23 @@ namespace Hermes
         else
           val = form->value(n_quadrature_points, jacobian_x_weights, u_ext, v, geometry, local_ext) * form->scaling_factor * current_als_i->coef[i];
 
-        current_rhs->add(current_als_i->dof[i], val);
+        Vector<Scalar>* target_rhs = (this->scatter_rhs == NULL) ? current_rhs : this->scatter_rhs[omp_get_thread_num()];
+        target_rhs->add(current_als_i->dof[i], val);
+        if(this->recording_contribution != NULL && this->recording_contribution[omp_get_thread_num()] != NULL)
+          this->record_local_rhs(current_als_i->dof[i], val);
       }
 
       if(form->ext.size() > 0)
       {
-        for(int ext_i = 0; ext_i < form->ext.size(); ext_i++)
-          if(form->ext[ext_i] != NULL)
-          {
-            local_ext[ext_i]->free_fn();
-            delete local_ext[ext_i];
-          }
-          delete [] local_ext;
+        // Shared traces are owned (and later released) by the surface loop.
+        if(shared_traces == NULL)
+          for(int ext_i = 0; ext_i < form->ext.size(); ext_i++)
+            if(local_ext[ext_i] != NULL)
+            {
+              local_ext[ext_i]->free_fn();
+              delete local_ext[ext_i];
+            }
+        delete [] local_ext;
       }
 
       if(RungeKutta)
@@ -2137,13 +3938,28 @@ namespace Hermes
       if(!reference_mapping->is_jacobian_const())
         jac = reference_mapping->get_jacobian(order);
       jacobian_x_weights = new double[np];
-      for(int i = 0; i < np; i++)
+      const double *pt_x, *pt_y, *pt_w;
+      if(reference_mapping->get_quad_2d()->get_points(order, reference_mapping->get_active_element()->get_mode(), pt_x, pt_y, pt_w))
       {
+        // aligned weight array, the loops vectorize
         if(reference_mapping->is_jacobian_const())
-          jacobian_x_weights[i] = pt[i][2] * reference_mapping->get_const_jacobian();
+        {
+          double const_jacobian = reference_mapping->get_const_jacobian();
+          for(int i = 0; i < np; i++)
+            jacobian_x_weights[i] = pt_w[i] * const_jacobian;
+        }
         else
-          jacobian_x_weights[i] = pt[i][2] * jac[i];
+          for(int i = 0; i < np; i++)
+            jacobian_x_weights[i] = pt_w[i] * jac[i];
       }
+      else
+        for(int i = 0; i < np; i++)
+        {
+          if(reference_mapping->is_jacobian_const())
+            jacobian_x_weights[i] = pt[i][2] * reference_mapping->get_const_jacobian();
+          else
+            jacobian_x_weights[i] = pt[i][2] * jac[i];
+        }
       return np;
     }
 
@@ -2158,12 +3974,58 @@ namespace Hermes
       double3* tan;
       geometry = init_geom_surf(reference_mapping, current_state->isurf, current_state->rep->en[current_state->isurf]->marker, eo, tan);
       jacobian_x_weights = new double[np];
-      for(int i = 0; i < np; i++)
-        jacobian_x_weights[i] = pt[i][2] * tan[i][2];
+      const double *pt_x, *pt_y, *pt_w;
+      if(reference_mapping->get_quad_2d()->get_points(eo, reference_mapping->get_active_element()->get_mode(), pt_x, pt_y, pt_w))
+        for(int i = 0; i < np; i++)
+          jacobian_x_weights[i] = pt_w[i] * tan[i][2];
+      else
+        for(int i = 0; i < np; i++)
+          jacobian_x_weights[i] = pt[i][2] * tan[i][2];
       order = eo;
       return np;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::calc_order_signature(Form<Scalar> *form, Solution<Scalar>** current_u_ext, Traverse::State* current_state, std::vector<int>& signature)
+    {
+      unsigned int prev_size = RungeKutta ? RK_original_spaces_count : this->wf->get_neq() - form->u_ext_offset;
+      bool surface_form = (current_state->isurf > -1);
+
+      // The same orders init_ext_orders() feeds into the Ord functions, collected
+      // without allocating any of them.
+      signature.push_back(surface_form ? 1 : 0);
+
+      if(current_u_ext != NULL)
+        for(unsigned int i = 0; i < prev_size; i++)
+          if(current_u_ext[i + form->u_ext_offset] != NULL)
+            if(surface_form)
+              signature.push_back(current_u_ext[i + form->u_ext_offset]->get_edge_fn_order(current_state->isurf) + (current_u_ext[i + form->u_ext_offset]->get_num_components() > 1 ? 1 : 0));
+            else
+              signature.push_back(current_u_ext[i + form->u_ext_offset]->get_fn_order() + (current_u_ext[i + form->u_ext_offset]->get_num_components() > 1 ? 1 : 0));
+          else
+            signature.push_back(0);
+      else
+        for(unsigned int i = 0; i < prev_size; i++)
+          signature.push_back(0);
+
+      if(form->ext.size() > 0)
+      {
+        for (unsigned int i = 0; i < form->ext.size(); i++)
+          if(surface_form)
+            signature.push_back(form->ext[i]->get_edge_fn_order(current_state->isurf) + (form->ext[i]->get_num_components() > 1 ? 1 : 0));
+          else
+            signature.push_back(form->ext[i]->get_fn_order() + (form->ext[i]->get_num_components() > 1 ? 1 : 0));
+      }
+      else
+      {
+        for (unsigned int i = 0; i < form->wf->ext.size(); i++)
+          if(surface_form)
+            signature.push_back(form->wf->ext[i]->get_edge_fn_order(current_state->isurf) + (form->wf->ext[i]->get_num_components() > 1 ? 1 : 0));
+          else
+            signature.push_back(form->wf->ext[i]->get_fn_order() + (form->wf->ext[i]->get_num_components() > 1 ? 1 : 0));
+      }
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::init_ext_orders(Form<Scalar> *form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>** oext, Solution<Scalar>** current_u_ext, Traverse::State* current_state)
     {
@@ -2609,7 +4471,8 @@ namespace Hermes
             }
           }
 
-          current_mat->add(ext_asmlist_v->cnt, ext_asmlist_u->cnt, local_stiffness_matrix, ext_asmlist_v->dof, ext_asmlist_u->dof);
+          SparseMatrix<Scalar>* target_mat = (this->scatter_mat == NULL) ? current_mat : this->scatter_mat[omp_get_thread_num()];
+          target_mat->add(ext_asmlist_v->cnt, ext_asmlist_u->cnt, local_stiffness_matrix, ext_asmlist_v->dof, ext_asmlist_u->dof);
 
           delete [] local_stiffness_matrix;
         }
@@ -2656,7 +4519,8 @@ namespace Hermes
 
             Func<double>* v = init_fn(current_spss[n], current_refmaps[n], nbs_v->get_quad_eo());
 
-            current_rhs->add(current_als[n]->dof[dof_i], 0.5 * vfs->value(n_quadrature_points, jacobian_x_weights[n], v, e[n], ext) * vfs->scaling_factor * current_als[n]->coef[dof_i]);
+            Vector<Scalar>* target_rhs = (this->scatter_rhs == NULL) ? current_rhs : this->scatter_rhs[omp_get_thread_num()];
+            target_rhs->add(current_als[n]->dof[dof_i], 0.5 * vfs->value(n_quadrature_points, jacobian_x_weights[n], v, e[n], ext) * vfs->scaling_factor * current_als[n]->coef[dof_i]);
 
             v->free_fn();
             delete v;
@@ -152,7 +152,7 @@ namespace Hermes
       int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
 #pragma omp parallel shared(trav_master, mat, rhs ) private(state_i, current_pss, current_spss, current_refmaps, current_als, current_weakform) num_threads(num_threads_used)
       {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
         for(state_i = 0; state_i < num_states; state_i++)
         {
           if(this->caughtException != NULL)
@@ -243,7 +243,8 @@ namespace Hermes
 
     template<typename Scalar>
     void DiscreteProblemLinear<Scalar>::assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
-      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights)
+      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights,
+      typename DiscreteProblem<Scalar>::SharedSurfaceTraces* shared_traces)
     {
       bool surface_form = (dynamic_cast<MatrixFormVol<Scalar>*>(form) == NULL);
 
@@ -253,7 +254,10 @@ namespace Hermes
       bool sym = (form->i == form->j) && (form->sym == 1);
 
       // Assemble the local stiffness matrix for the form form.
-      Scalar **local_stiffness_matrix = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
+      Scalar **local_stiffness_matrix = this->get_local_stiffness_scratch(std::max(current_als_i->cnt, current_als_j->cnt));
+      bool own_local_matrix = (local_stiffness_matrix == NULL);
+      if(own_local_matrix)
+        local_stiffness_matrix = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
 
       Func<Scalar>** local_ext = ext;
       // If the user supplied custom ext functions for this form.
@@ -263,7 +267,24 @@ namespace Hermes
         local_ext = new Func<Scalar>*[local_ext_count];
         for(int ext_i = 0; ext_i < local_ext_count; ext_i++)
           if(form->ext[ext_i] != NULL)
-            local_ext[ext_i] = current_state->e[ext_i] == NULL ? NULL : init_fn(form->ext[ext_i], order);
+          {
+            if(current_state->e[ext_i] == NULL)
+              local_ext[ext_i] = NULL;
+            else if(shared_traces != NULL)
+            {
+              // Traces shared between the surface forms of one edge, see the parent class.
+              typename DiscreteProblem<Scalar>::SharedSurfaceTraces::iterator found = shared_traces->find(std::make_pair(form->ext[ext_i], order));
+              if(found != shared_traces->end())
+                local_ext[ext_i] = found->second;
+              else
+              {
+                local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+                (*shared_traces)[std::make_pair(form->ext[ext_i], order)] = local_ext[ext_i];
+              }
+            }
+            else
+              local_ext[ext_i] = init_fn(form->ext[ext_i], order);
+          }
           else
             local_ext[ext_i] = NULL;
       }
@@ -355,17 +376,20 @@ namespace Hermes
 
       if(form->ext.size() > 0)
       {
-        for(int ext_i = 0; ext_i < form->ext.size(); ext_i++)
-          if(form->ext[ext_i] != NULL)
-          {
-            local_ext[ext_i]->free_fn();
-            delete local_ext[ext_i];
-          }
-          delete [] local_ext;
+        // Shared traces are owned (and later released) by the surface loop.
+        if(shared_traces == NULL)
+          for(int ext_i = 0; ext_i < form->ext.size(); ext_i++)
+            if(local_ext[ext_i] != NULL)
+            {
+              local_ext[ext_i]->free_fn();
+              delete local_ext[ext_i];
+            }
+        delete [] local_ext;
       }
 
       // Cleanup.
-      delete [] local_stiffness_matrix;
+      if(own_local_matrix)
+        delete [] local_stiffness_matrix;
     }
 
     template class HERMES_API DiscreteProblemLinear<double>;
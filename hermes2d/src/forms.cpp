@@ -151,22 +151,22 @@ namespace Hermes
     template<typename T>
     void Func<T>::free_fn()
     {
-      delete [] val; val = NULL;
-      delete [] dx; dx = NULL;
-      delete [] dy; dy = NULL;
+      free_with_alignment(val); val = NULL;
+      free_with_alignment(dx); dx = NULL;
+      free_with_alignment(dy); dy = NULL;
 
 #ifdef H2D_USE_SECOND_DERIVATIVES
-      delete [] laplace; 
+      free_with_alignment(laplace);
       laplace = NULL;
 #endif
 
       if(this->nc > 1)
       {
-        delete [] val0; delete [] val1; val0 = val1 = NULL;
-        delete [] dx0;  delete [] dx1; dx0 = dx1 = NULL;
-        delete [] dy0;  delete [] dy1; dy0 = dy1 = NULL;
-        delete [] curl; curl = NULL;
-        delete [] div; div = NULL;
+        free_with_alignment(val0); free_with_alignment(val1); val0 = val1 = NULL;
+        free_with_alignment(dx0);  free_with_alignment(dx1); dx0 = dx1 = NULL;
+        free_with_alignment(dy0);  free_with_alignment(dy1); dy0 = dy1 = NULL;
+        free_with_alignment(curl); curl = NULL;
+        free_with_alignment(div); div = NULL;
       }
     }
 
@@ -184,9 +184,9 @@ namespace Hermes
         fn_neighbor = fn;
         if(reverse_neighbor_side)
         {
-          this->val_neighbor = new T[this->num_gip];
-          this->dx_neighbor = new T[this->num_gip];
-          this->dy_neighbor = new T[this->num_gip];
+          this->val_neighbor = new_with_alignment<T>(this->num_gip);
+          this->dx_neighbor = new_with_alignment<T>(this->num_gip);
+          this->dy_neighbor = new_with_alignment<T>(this->num_gip);
           for(int i = 0; i < this->num_gip; i++)
           {
             this->val_neighbor[i] = fn->val[this->num_gip-i-1];
@@ -222,9 +222,9 @@ namespace Hermes
     {
       if(reverse_neighbor_side)
       {
-        this->val_neighbor = new T[this->num_gip];
-        this->dx_neighbor = new T[this->num_gip];
-        this->dy_neighbor = new T[this->num_gip];
+        this->val_neighbor = new_with_alignment<T>(this->num_gip);
+        this->dx_neighbor = new_with_alignment<T>(this->num_gip);
+        this->dy_neighbor = new_with_alignment<T>(this->num_gip);
         for(int i = 0; i < this->num_gip; i++)
         {
           this->val_neighbor[i] = fn_neighbor->val[this->num_gip-i-1];
@@ -265,9 +265,9 @@ namespace Hermes
       {
         if(reverse_neighbor_side)
         {
-          delete [] this->val_neighbor;
-          delete [] this->dx_neighbor;
-          delete [] this->dy_neighbor;
+          free_with_alignment(this->val_neighbor);
+          free_with_alignment(this->dx_neighbor);
+          free_with_alignment(this->dy_neighbor);
         }
         fn_neighbor->free_fn();
         delete fn_neighbor;
@@ -307,9 +307,9 @@ namespace Hermes
     template<typename T>
     void Geom<T>::free()
     {
-      delete [] x;    delete [] y;
-      delete [] tx;    delete [] ty;
-      delete [] nx;    delete [] ny;
+      free_with_alignment(x);    free_with_alignment(y);
+      free_with_alignment(tx);    free_with_alignment(ty);
+      free_with_alignment(nx);    free_with_alignment(ny);
     }
 
     template<typename T>
@@ -395,8 +395,8 @@ namespace Hermes
       e->elem_marker = rm->get_active_element()->marker;
       Quad2D* quad = rm->get_quad_2d();
       int np = quad->get_num_points(order, rm->get_active_element()->get_mode());
-      e->x = new double[np];
-      e->y = new double[np];
+      e->x = new_with_alignment<double>(np);
+      e->y = new_with_alignment<double>(np);
       double* x = rm->get_phys_x(order);
       double* y = rm->get_phys_y(order);
       for (int i = 0; i < np; i++)
@@ -423,12 +423,12 @@ namespace Hermes
       
       Quad2D* quad = rm->get_quad_2d();
       int np = quad->get_num_points(order, rm->get_active_element()->get_mode());
-      e->x = new double[np];
-      e->y = new double[np];
-      e->tx = new double[np];
-      e->ty = new double[np];
-      e->nx = new double[np];
-      e->ny = new double[np];
+      e->x = new_with_alignment<double>(np);
+      e->y = new_with_alignment<double>(np);
+      e->tx = new_with_alignment<double>(np);
+      e->ty = new_with_alignment<double>(np);
+      e->nx = new_with_alignment<double>(np);
+      e->ny = new_with_alignment<double>(np);
       for (int i = 0; i < np; i++)
       {
         e->x[i] = x[i];
@@ -482,12 +482,12 @@ namespace Hermes
       // H1 & L2 space.
       if(space_type == HERMES_H1_SPACE || space_type == HERMES_L2_SPACE)
       {
-        u->val = new double[np];
-        u->dx  = new double[np];
-        u->dy  = new double[np];
+        u->val = new_with_alignment<double>(np);
+        u->dx  = new_with_alignment<double>(np);
+        u->dy  = new_with_alignment<double>(np);
 
 #ifdef H2D_USE_SECOND_DERIVATIVES
-        u->laplace = new double[np];
+        u->laplace = new_with_alignment<double>(np);
 #endif
 
         double *fn = fu->get_fn_values();
@@ -558,9 +558,9 @@ namespace Hermes
       // Hcurl space.
       else if(space_type == HERMES_HCURL_SPACE)
       {
-        u->val0 = new double[np];
-        u->val1 = new double[np];
-        u->curl = new double[np];
+        u->val0 = new_with_alignment<double>(np);
+        u->val1 = new_with_alignment<double>(np);
+        u->curl = new_with_alignment<double>(np);
 
         double *fn0 = fu->get_fn_values(0);
         double *fn1 = fu->get_fn_values(1);
@@ -601,8 +601,8 @@ namespace Hermes
       // Hdiv space.
       else if(space_type == HERMES_HDIV_SPACE)
       {
-        u->val0 = new double[np];
-        u->val1 = new double[np];
+        u->val0 = new_with_alignment<double>(np);
+        u->val1 = new_with_alignment<double>(np);
 
         double *fn0 = fu->get_fn_values(0);
         double *fn1 = fu->get_fn_values(1);
@@ -645,6 +645,45 @@ namespace Hermes
       return u;
     }
 
+    /// Shared by both init_fn() overloads below: a function that reports
+    /// constant values (MeshFunction::get_constant_values()) gets its Func
+    /// filled straight from the constants, with all the derivatives zero -
+    /// no value tables are built for it.
+    template<typename Scalar>
+    static Func<Scalar>* init_fn_const(MeshFunction<Scalar>* fu, const int order, Scalar* constants)
+    {
+      Quad2D* quad = fu->get_quad_2d();
+      int np = quad->get_num_points(order, fu->get_active_element()->get_mode());
+      int nc = fu->get_num_components();
+      Func<Scalar>* u = new Func<Scalar>(np, nc);
+
+      if(nc == 1)
+      {
+        u->val = new_with_alignment<Scalar>(np);
+        u->dx  = new_with_alignment<Scalar>(np);
+        u->dy  = new_with_alignment<Scalar>(np);
+        for (int i = 0; i < np; i++)
+        {
+          u->val[i] = constants[0];
+          u->dx[i] = u->dy[i] = Scalar(0);
+        }
+      }
+      else if(nc == 2)
+      {
+        u->val0 = new_with_alignment<Scalar>(np);
+        u->val1 = new_with_alignment<Scalar>(np);
+        u->curl = new_with_alignment<Scalar>(np);
+        u->div = new_with_alignment<Scalar>(np);
+        for (int i = 0; i < np; i++)
+        {
+          u->val0[i] = constants[0];
+          u->val1[i] = constants[1];
+          u->curl[i] = u->div[i] = Scalar(0);
+        }
+      }
+      return u;
+    }
+
     template<typename Scalar>
     Func<Scalar>* init_fn(MeshFunction<Scalar>*fu, const int order)
     {
@@ -652,6 +691,11 @@ namespace Hermes
       if(fu == NULL) throw Hermes::Exceptions::Exception("NULL MeshFunction in Func<Scalar>*::init_fn().");
       if(fu->get_mesh() == NULL) throw Hermes::Exceptions::Exception("Uninitialized MeshFunction used.");
 
+      // Trivial (constant, zero) functions skip the table machinery altogether.
+      Scalar constants[2];
+      if(fu->get_constant_values(constants))
+        return init_fn_const(fu, order, constants);
+
       int nc = fu->get_num_components();
       Quad2D* quad = fu->get_quad_2d();
       fu->set_quad_order(order);
@@ -661,19 +705,19 @@ namespace Hermes
 
       if(u->nc == 1)
       {
-        u->val = new Scalar[np];
-        u->dx  = new Scalar[np];
-        u->dy  = new Scalar[np];
+        u->val = new_with_alignment<Scalar>(np);
+        u->dx  = new_with_alignment<Scalar>(np);
+        u->dy  = new_with_alignment<Scalar>(np);
         memcpy(u->val, fu->get_fn_values(), np * sizeof(Scalar));
         memcpy(u->dx, fu->get_dx_values(), np * sizeof(Scalar));
         memcpy(u->dy, fu->get_dy_values(), np * sizeof(Scalar));
       }
       else if(u->nc == 2)
       {
-        u->val0 = new Scalar[np];
-        u->val1 = new Scalar[np];
-        u->curl = new Scalar[np];
-        u->div = new Scalar[np];
+        u->val0 = new_with_alignment<Scalar>(np);
+        u->val1 = new_with_alignment<Scalar>(np);
+        u->curl = new_with_alignment<Scalar>(np);
+        u->div = new_with_alignment<Scalar>(np);
 
         memcpy(u->val0, fu->get_fn_values(0), np * sizeof(Scalar));
         memcpy(u->val1, fu->get_fn_values(1), np * sizeof(Scalar));
@@ -696,6 +740,11 @@ namespace Hermes
       if(fu == NULL) throw Hermes::Exceptions::Exception("NULL MeshFunction in Func<Scalar>*::init_fn().");
       if(fu->get_mesh() == NULL) throw Hermes::Exceptions::Exception("Uninitialized MeshFunction used.");
 
+      // Trivial (constant, zero) solutions skip the table machinery altogether.
+      Scalar constants[2];
+      if(fu->get_constant_values(constants))
+        return init_fn_const<Scalar>(fu, order, constants);
+
       SpaceType space_type = fu->get_space_type();
       SolutionType sln_type = fu->get_type();
 
@@ -715,13 +764,13 @@ namespace Hermes
 
       if(u->nc == 1)
       {
-        u->val = new Scalar[np];
-        u->dx  = new Scalar[np];
-        u->dy  = new Scalar[np];
+        u->val = new_with_alignment<Scalar>(np);
+        u->dx  = new_with_alignment<Scalar>(np);
+        u->dy  = new_with_alignment<Scalar>(np);
         
 #ifdef H2D_USE_SECOND_DERIVATIVES
         if(space_type == HERMES_H1_SPACE && sln_type != HERMES_EXACT)
-          u->laplace = new Scalar[np];
+          u->laplace = new_with_alignment<Scalar>(np);
 #endif
 
         memcpy(u->val, fu->get_fn_values(), np * sizeof(Scalar));
@@ -740,10 +789,10 @@ namespace Hermes
       }
       else if(u->nc == 2)
       {
-        u->val0 = new Scalar[np];
-        u->val1 = new Scalar[np];
-        u->curl = new Scalar[np];
-        u->div = new Scalar[np];
+        u->val0 = new_with_alignment<Scalar>(np);
+        u->val1 = new_with_alignment<Scalar>(np);
+        u->curl = new_with_alignment<Scalar>(np);
+        u->div = new_with_alignment<Scalar>(np);
 
         memcpy(u->val0, fu->get_fn_values(0), np * sizeof(Scalar));
         memcpy(u->val1, fu->get_fn_values(1), np * sizeof(Scalar));
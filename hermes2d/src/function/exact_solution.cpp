@@ -47,6 +47,22 @@ namespace Hermes
       return 1;
     }
 
+    template<typename Scalar>
+    void ExactSolutionScalar<Scalar>::values(const double* x, const double* y, int n, Scalar* out) const
+    {
+      for (int i = 0; i < n; i++)
+        out[i] = value(x[i], y[i]);
+    }
+
+    template<typename Scalar>
+    void ExactSolutionScalar<Scalar>::exact_functions(const double* x, const double* y, int n,
+      Scalar* out, Scalar* out_dx, Scalar* out_dy) const
+    {
+      values(x, y, n, out);
+      for (int i = 0; i < n; i++)
+        derivatives(x[i], y[i], out_dx[i], out_dy[i]);
+    }
+
     template<typename Scalar>
     ExactSolutionVector<Scalar>::ExactSolutionVector(const Mesh* mesh) : ExactSolution<Scalar>(mesh)
     {
@@ -59,6 +75,24 @@ namespace Hermes
       return 2;
     }
 
+    template<typename Scalar>
+    void ExactSolutionVector<Scalar>::exact_functions(const double* x, const double* y, int n,
+      Scalar* out_0, Scalar* out_1, Scalar* out_dx_0, Scalar* out_dx_1,
+      Scalar* out_dy_0, Scalar* out_dy_1) const
+    {
+      for (int i = 0; i < n; i++)
+      {
+        Scalar2<Scalar> dx(Scalar(0), Scalar(0)), dy(Scalar(0), Scalar(0));
+        Scalar2<Scalar> val = exact_function(x[i], y[i], dx, dy);
+        out_0[i] = val[0];
+        out_1[i] = val[1];
+        out_dx_0[i] = dx[0];
+        out_dx_1[i] = dx[1];
+        out_dy_0[i] = dy[0];
+        out_dy_1[i] = dy[1];
+      }
+    }
+
     template<>
     void ConstantSolution<double>::save(const char* filename) const
     {
@@ -153,6 +187,12 @@ namespace Hermes
       return Ord(0);
     }
 
+    template<typename Scalar>
+    bool ConstantSolution<Scalar>::get_constant_values(Scalar* values) const {
+      values[0] = constant;
+      return true;
+    }
+
     template<>
     void ZeroSolution<double>::save(const char* filename) const
     {
@@ -246,6 +286,12 @@ namespace Hermes
       return Ord(0);
     }
 
+    template<typename Scalar>
+    bool ZeroSolution<Scalar>::get_constant_values(Scalar* values) const {
+      values[0] = Scalar(0);
+      return true;
+    }
+
     
     template<>
     void ConstantSolutionVector<double>::save(const char* filename) const
@@ -346,6 +392,13 @@ namespace Hermes
       return Ord(0);
     }
 
+    template<typename Scalar>
+    bool ConstantSolutionVector<Scalar>::get_constant_values(Scalar* values) const {
+      values[0] = constantX;
+      values[1] = constantY;
+      return true;
+    }
+
     template<>
     void ZeroSolutionVector<double>::save(const char* filename) const
     {
@@ -436,6 +489,12 @@ namespace Hermes
       return Ord(0);
     }
 
+    template<typename Scalar>
+    bool ZeroSolutionVector<Scalar>::get_constant_values(Scalar* values) const {
+      values[0] = values[1] = Scalar(0);
+      return true;
+    }
+
     template<typename Scalar>
     MeshFunction<Scalar>* ZeroSolutionVector<Scalar>::clone() const
     {
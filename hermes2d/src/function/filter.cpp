@@ -26,6 +26,10 @@ namespace Hermes
     template<typename Scalar>
     Filter<Scalar>::Filter()
     {
+      memset(elem_tables, 0, sizeof(elem_tables));
+      memset(table_elems, 0, sizeof(table_elems));
+      memset(oldest_table, 0, sizeof(oldest_table));
+      this->result_caching = false;
     }
 
     template<typename Scalar>
@@ -117,6 +121,12 @@ namespace Hermes
       this->order = 0;
 
       memset(sln_sub, 0, sizeof(sln_sub));
+      memset(elem_tables, 0, sizeof(elem_tables));
+      memset(table_elems, 0, sizeof(table_elems));
+      memset(oldest_table, 0, sizeof(oldest_table));
+      for(int i = 0; i < this->num; i++)
+        source_seqs[i] = -1;
+      this->result_caching = false;
       set_quad_2d(&g_quad_2d_std);
 
       this->deleteSolutions = false;
@@ -161,24 +171,117 @@ namespace Hermes
         }
       }
 
-      for(typename std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>::iterator it = tables[this->cur_quad].begin(); it != tables[this->cur_quad].end(); it++)
+      if(this->result_caching)
       {
-        for(unsigned int l = 0; l < it->second->get_size(); l++)
-          if(it->second->present(l))
-            ::free(it->second->get(l));
-        delete it->second;
+        // Invalidate the whole cache once any of the source functions has
+        // changed since the cached tables were computed.
+        for (int i = 0; i < num; i++)
+        {
+          if(get_source_seq(i) != source_seqs[i])
+          {
+            free_elem_tables();
+            for (int j = 0; j < num; j++)
+              source_seqs[j] = get_source_seq(j);
+            break;
+          }
+        }
+
+        // try finding an existing table for e (as in Solution).
+        int cur_table;
+        for (cur_table = 0; cur_table < 4; cur_table++)
+          if(table_elems[this->cur_quad][cur_table] == e)
+            break;
+
+        // if not found, free the oldest one and use its slot.
+        if(cur_table >= 4)
+        {
+          cur_table = oldest_table[this->cur_quad];
+          if(elem_tables[this->cur_quad][cur_table] != NULL)
+          {
+            for(typename std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>::iterator it = elem_tables[this->cur_quad][cur_table]->begin(); it != elem_tables[this->cur_quad][cur_table]->end(); it++)
+            {
+              for(unsigned int l = 0; l < it->second->get_size(); l++)
+                if(it->second->present(l))
+                  ::free(it->second->get(l));
+              delete it->second;
+            }
+            delete elem_tables[this->cur_quad][cur_table];
+          }
+
+          elem_tables[this->cur_quad][cur_table] = new std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>;
+          table_elems[this->cur_quad][cur_table] = e;
+
+          if(++oldest_table[this->cur_quad] >= 4)
+            oldest_table[this->cur_quad] = 0;
+        }
+
+        this->sub_tables = elem_tables[this->cur_quad][cur_table];
+      }
+      else
+      {
+        for(typename std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>::iterator it = tables[this->cur_quad].begin(); it != tables[this->cur_quad].end(); it++)
+        {
+          for(unsigned int l = 0; l < it->second->get_size(); l++)
+            if(it->second->present(l))
+              ::free(it->second->get(l));
+          delete it->second;
+        }
+        tables[this->cur_quad].clear();
+
+        this->sub_tables = &tables[this->cur_quad];
       }
-      tables[this->cur_quad].clear();
 
-      this->sub_tables = &tables[this->cur_quad];
       this->update_nodes_ptr();
 
       this->order = 20; // fixme
     }
 
+    template<typename Scalar>
+    void Filter<Scalar>::set_result_caching(bool to_set)
+    {
+      if(!to_set && this->result_caching)
+        free_elem_tables();
+      this->result_caching = to_set;
+    }
+
+    template<typename Scalar>
+    int Filter<Scalar>::get_source_seq(int i) const
+    {
+      Solution<Scalar>* solution = dynamic_cast<Solution<Scalar>*>(this->sln[i]);
+      if(solution != NULL)
+        return solution->get_sln_seq();
+      return this->sln[i]->get_mesh()->get_seq();
+    }
+
+    template<typename Scalar>
+    void Filter<Scalar>::free_elem_tables()
+    {
+      for (int i = 0; i < H2D_MAX_QUADRATURES; i++)
+      {
+        for (int j = 0; j < 4; j++)
+        {
+          if(elem_tables[i][j] == NULL)
+            continue;
+          for(typename std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>::iterator it = elem_tables[i][j]->begin(); it != elem_tables[i][j]->end(); it++)
+          {
+            for(unsigned int l = 0; l < it->second->get_size(); l++)
+              if(it->second->present(l))
+                ::free(it->second->get(l));
+            delete it->second;
+          }
+          delete elem_tables[i][j];
+          elem_tables[i][j] = NULL;
+          table_elems[i][j] = NULL;
+        }
+        oldest_table[i] = 0;
+      }
+    }
+
     template<typename Scalar>
     void Filter<Scalar>::free()
     {
+      free_elem_tables();
+
       for (int i = 0; i < H2D_MAX_QUADRATURES; i++)
       {
         for(typename std::map<uint64_t, LightArray<struct Filter<Scalar>::Node*>*>::iterator it = tables[i].begin(); it != tables[i].end(); it++)
@@ -243,6 +346,7 @@ namespace Hermes
     template<typename Scalar>
     SimpleFilter<Scalar>::SimpleFilter() : Filter<Scalar>()
     {
+      this->fused_evaluation = false;
     }
     
     template<typename Scalar>
@@ -267,6 +371,7 @@ namespace Hermes
       this->init();
       init_components();
       this->deleteSolutions = false;
+      this->fused_evaluation = false;
     }
 
     template<typename Scalar>
@@ -290,6 +395,7 @@ namespace Hermes
       this->init();
       init_components();
       this->deleteSolutions = false;
+      this->fused_evaluation = false;
     }
 
     template<typename Scalar>
@@ -320,29 +426,36 @@ namespace Hermes
       int np = quad->get_num_points(order, this->element->get_mode());
       struct Function<Scalar>::Node* node = this->new_node(H2D_FN_VAL, np);
 
-      // precalculate all solutions
-      for (int i = 0; i < this->num; i++)
-        this->sln[i]->set_quad_order(order, item[i]);
-
-      for (int j = 0; j < this->num_components; j++)
+      if(this->fused_evaluation && this->num_components == 1)
+        // Evaluate the whole chain of nested filters in one pass; only the
+        // final result is written to a table.
+        calc_value_table(order, np, node->values[0][0]);
+      else
       {
-        // obtain corresponding tables
-        Scalar* tab[H2D_MAX_COMPONENTS];
+        // precalculate all solutions
         for (int i = 0; i < this->num; i++)
+          this->sln[i]->set_quad_order(order, item[i]);
+
+        for (int j = 0; j < this->num_components; j++)
         {
-          int a = 0, b = 0, mask = item[i];
-          if(mask >= 0x40) { a = 1; mask >>= 6; }
-          while (!(mask & 1)) { mask >>= 1; b++; }
-          tab[i] = this->sln[i]->get_values(this->num_components == 1 ? a : j, b);
-          if(tab[i] == NULL) throw Hermes::Exceptions::Exception("Value of 'item%d' is incorrect in filter definition.", i + 1);
-        }
+          // obtain corresponding tables
+          Scalar* tab[H2D_MAX_COMPONENTS];
+          for (int i = 0; i < this->num; i++)
+          {
+            int a = 0, b = 0, mask = item[i];
+            if(mask >= 0x40) { a = 1; mask >>= 6; }
+            while (!(mask & 1)) { mask >>= 1; b++; }
+            tab[i] = this->sln[i]->get_values(this->num_components == 1 ? a : j, b);
+            if(tab[i] == NULL) throw Hermes::Exceptions::Exception("Value of 'item%d' is incorrect in filter definition.", i + 1);
+          }
 
-        Hermes::vector<Scalar*> values;
-        for(int i = 0; i < this->num; i++)
-          values.push_back(tab[i]);
+          Hermes::vector<Scalar*> values;
+          for(int i = 0; i < this->num; i++)
+            values.push_back(tab[i]);
 
-        // apply the filter
-        filter_fn(np, values, node->values[j][0]);
+          // apply the filter
+          filter_fn(np, values, node->values[j][0]);
+        }
       }
 
       if(this->nodes->present(order))
@@ -354,6 +467,52 @@ namespace Hermes
       this->cur_node = node;
     }
 
+    template<typename Scalar>
+    void SimpleFilter<Scalar>::set_fused_evaluation(bool to_set)
+    {
+      this->fused_evaluation = to_set;
+    }
+
+    template<typename Scalar>
+    void SimpleFilter<Scalar>::calc_value_table(int order, int np, Scalar* out)
+    {
+      Scalar* tab[H2D_MAX_COMPONENTS];
+      Scalar* scratch[H2D_MAX_COMPONENTS];
+
+      for (int i = 0; i < this->num; i++)
+      {
+        scratch[i] = NULL;
+        SimpleFilter<Scalar>* nested = dynamic_cast<SimpleFilter<Scalar>*>(this->sln[i]);
+        if(nested != NULL && item[i] == H2D_FN_VAL_0 && nested->get_num_components() == 1)
+        {
+          // A nested scalar filter used through its values - evaluate it
+          // directly into a scratch buffer instead of its tables.
+          scratch[i] = new Scalar[np];
+          nested->calc_value_table(order, np, scratch[i]);
+          tab[i] = scratch[i];
+        }
+        else
+        {
+          this->sln[i]->set_quad_order(order, item[i]);
+          int a = 0, b = 0, mask = item[i];
+          if(mask >= 0x40) { a = 1; mask >>= 6; }
+          while (!(mask & 1)) { mask >>= 1; b++; }
+          tab[i] = this->sln[i]->get_values(a, b);
+          if(tab[i] == NULL) throw Hermes::Exceptions::Exception("Value of 'item%d' is incorrect in filter definition.", i + 1);
+        }
+      }
+
+      Hermes::vector<Scalar*> values;
+      for(int i = 0; i < this->num; i++)
+        values.push_back(tab[i]);
+
+      filter_fn(np, values, out);
+
+      for (int i = 0; i < this->num; i++)
+        if(scratch[i] != NULL)
+          delete [] scratch[i];
+    }
+
     template<typename Scalar>
     Func<Scalar>* SimpleFilter<Scalar>::get_pt_value(double x, double y, Element* e)
     {
@@ -362,7 +521,7 @@ namespace Hermes
         val[i] = this->sln[i]->get_pt_value(x, y, e)->val[0];
 
       Func<Scalar>* toReturn = new Func<Scalar>(1, 1);
-      toReturn->val = new Scalar[1];
+      toReturn->val = new_with_alignment<Scalar>(1);
 
       Scalar result;
       Hermes::vector<Scalar*> values;
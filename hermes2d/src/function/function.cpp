@@ -91,6 +91,50 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void Function<Scalar>::precalculate_transform_chain(unsigned int order, int mask)
+    {
+      // Overflow chains do not go through the sub_idx-keyed tables at all.
+      if(sub_idx > H2D_MAX_IDX)
+      {
+        set_quad_order(order, mask);
+        return;
+      }
+
+      // Recover the sub-element indices of the chain; position 0 is the current
+      // (deepest) level, the last position is the untransformed element.
+      uint64_t chain[H2D_MAX_TRN_LEVEL + 2];
+      int levels = 0;
+      uint64_t idx = sub_idx;
+      while(true)
+      {
+        chain[levels++] = idx;
+        if(idx == 0)
+          break;
+        idx = (idx - 1) >> 3;
+      }
+
+      // The cumulative transform matrices of the intermediate levels are available
+      // only when the chain was built by push_transform() / set_transform(). With a
+      // transform forced from elsewhere, only the current level can be filled.
+      if(top != levels - 1)
+      {
+        set_quad_order(order, mask);
+        return;
+      }
+
+      // Go from the element level down to the current sub-element, computing every
+      // level whose table misses this rule. The last iteration is the current level,
+      // so the function is left exactly as after a plain set_quad_order() call.
+      for (int i = levels - 1; i >= 0; i--)
+      {
+        this->sub_idx = chain[i];
+        this->ctm = stack + (top - i);
+        update_nodes_ptr();
+        set_quad_order(order, mask);
+      }
+    }
+
     template<typename Scalar>
     Scalar* Function<Scalar>::get_fn_values(int component)
     {
@@ -14,6 +14,7 @@
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "mesh_function.h"
+#include "../forms.h"
 #include "../views/linearizer_base.h"
 #include <limits>
 
@@ -82,6 +83,58 @@ namespace Hermes
       init();
     }
 
+    template<typename Scalar>
+    void MeshFunction<Scalar>::eval_points(const double* x, const double* y, int n, Scalar* out, int item)
+    {
+      this->check();
+
+      // get the component and desired value from item.
+      int component = 0, value_type = 0;
+      if(item >= 0x40)
+      {
+        component = 1;
+        item >>= 6;
+      }
+      while (!(item & 1))
+      {
+        item >>= 1;
+        value_type++;
+      }
+      if(value_type > 2)
+        throw Hermes::Exceptions::Exception("Only function values and first derivatives can be evaluated in MeshFunction::eval_points().");
+
+      // group the points by their containing element, so that the element lookup
+      // and activation happen once per element instead of once per point
+      std::map<Element*, std::vector<int> > groups;
+      for (int i = 0; i < n; i++)
+      {
+        Element* e = RefMap::element_on_physical_coordinates(this->mesh, x[i], y[i]);
+        if(e == NULL)
+          out[i] = Scalar(0);
+        else
+          groups[e].push_back(i);
+      }
+
+      for (typename std::map<Element*, std::vector<int> >::iterator it = groups.begin(); it != groups.end(); it++)
+      {
+        for (unsigned int j = 0; j < it->second.size(); j++)
+        {
+          int i = it->second[j];
+          Func<Scalar>* pt = this->get_pt_value(x[i], y[i], it->first);
+          Scalar* val;
+          if(this->num_components == 1)
+            val = (value_type == 0) ? pt->val : ((value_type == 1) ? pt->dx : pt->dy);
+          else if(component == 0)
+            val = (value_type == 0) ? pt->val0 : ((value_type == 1) ? pt->dx0 : pt->dy0);
+          else
+            val = (value_type == 0) ? pt->val1 : ((value_type == 1) ? pt->dx1 : pt->dy1);
+          out[i] = (val == NULL) ? Scalar(0) : val[0];
+          pt->free_fn();
+          delete pt;
+        }
+      }
+    }
+
     template<>
     double MeshFunction<double>::get_approx_max_value(int item_)
     {
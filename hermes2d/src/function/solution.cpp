@@ -23,6 +23,11 @@
 #include <iostream>
 #include <algorithm>
 
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace Hermes
 {
   namespace Hermes2D
@@ -87,6 +92,14 @@ namespace Hermes
     template<typename Scalar>
     bool Solution<Scalar>::static_verbose_output = false;
 
+    // every bump of a solution sequence number is also published centrally
+    template<typename Scalar>
+    static void bump_sln_seq(int& sln_seq, const Solution<Scalar>* sln)
+    {
+      Hermes::HermesChangeBus.publish(Hermes::HERMES_CHANGE_SOLUTION, sln);
+      sln_seq++;
+    }
+
     template<>
     void Solution<double>::init()
     {
@@ -109,6 +122,23 @@ namespace Hermes
       num_coeffs = num_elems = 0;
       num_dofs = -1;
 
+      space_coeffs = NULL;
+      space_coeffs_count = 0;
+      space_seq = space_mesh_seq = -1;
+      space_coeffs_dir_lift = false;
+      sln_seq = 0;
+
+      lazy_conversion = false;
+      elem_converted = NULL;
+      lazy_space = NULL;
+      lazy_coeff_vec = NULL;
+      lazy_pss = NULL;
+      lazy_add_dir_lift = false;
+
+      mmap_loading = false;
+      mapped_data = NULL;
+      mapped_size = 0;
+
       this->set_quad_2d(&g_quad_2d_std);
     }
 
@@ -134,6 +164,23 @@ namespace Hermes
 			num_coeffs = num_elems = 0;
 			num_dofs = -1;
 
+			space_coeffs = NULL;
+			space_coeffs_count = 0;
+			space_seq = space_mesh_seq = -1;
+			space_coeffs_dir_lift = false;
+			sln_seq = 0;
+
+			lazy_conversion = false;
+			elem_converted = NULL;
+			lazy_space = NULL;
+			lazy_coeff_vec = NULL;
+			lazy_pss = NULL;
+			lazy_add_dir_lift = false;
+
+			mmap_loading = false;
+			mapped_data = NULL;
+			mapped_size = 0;
+
 			this->set_quad_2d(&g_quad_2d_std);
 		}
 
@@ -225,17 +272,49 @@ namespace Hermes
       num_coeffs = sln->num_coeffs;          sln->num_coeffs = 0;
       num_elems = sln->num_elems;          sln->num_elems = 0;
 
+      space_coeffs = sln->space_coeffs;      sln->space_coeffs = NULL;
+      space_coeffs_count = sln->space_coeffs_count;
+      space_seq = sln->space_seq;
+      space_mesh_seq = sln->space_mesh_seq;
+      space_coeffs_dir_lift = sln->space_coeffs_dir_lift;
+
+      lazy_conversion = sln->lazy_conversion;
+      elem_converted = sln->elem_converted;  sln->elem_converted = NULL;
+      lazy_pss = sln->lazy_pss;              sln->lazy_pss = NULL;
+      lazy_space = sln->lazy_space;
+      lazy_add_dir_lift = sln->lazy_add_dir_lift;
+      // The pending conversions stay anchored in the dof vector, which moved here.
+      lazy_coeff_vec = (sln->lazy_coeff_vec != NULL) ? space_coeffs : NULL;
+      sln->lazy_coeff_vec = NULL;
+
       sln_type = sln->sln_type;
       this->num_components = sln->num_components;
 
       memset(sln->tables, 0, sizeof(sln->tables));
+
+      bump_sln_seq(sln_seq, this);
     }
 
     template<typename Scalar>
     void Solution<Scalar>::copy(const Solution<Scalar>* sln)
     {
       if(sln->sln_type == HERMES_UNDEF) throw Hermes::Exceptions::Exception("Solution being copied is uninitialized.");
-      free();
+
+      // When this instance already holds arrays of exactly the sizes being copied,
+      // keep them and just overwrite their contents - the analogue of the layout
+      // reuse in set_coeff_vector() for the per-thread copies made in assembling.
+      bool reuse_arrays = sln_type == HERMES_SLN && sln->sln_type == HERMES_SLN
+        && mono_coeffs != NULL && elem_orders != NULL
+        && num_coeffs == sln->num_coeffs && num_elems == sln->num_elems
+        && this->num_components == sln->num_components;
+
+      if(reuse_arrays)
+      {
+        free_tables();
+        e_last = NULL;
+      }
+      else
+        free();
 
       this->mesh = sln->mesh;
 
@@ -249,24 +328,80 @@ namespace Hermes
         num_coeffs = sln->num_coeffs;
         num_elems = sln->num_elems;
 
-        mono_coeffs = new Scalar[num_coeffs];
-        memcpy(mono_coeffs, sln->mono_coeffs, sizeof(Scalar) * num_coeffs);
+        if(!reuse_arrays)
+          mono_coeffs = new Scalar[num_coeffs];
+        // The monomial tables of a lazily converted source are not copied - the copy
+        // converts the elements it actually visits from the dof vector itself.
+        bool copy_lazily = sln->lazy_conversion && sln->lazy_coeff_vec != NULL && sln->space_coeffs != NULL;
+        if(!copy_lazily)
+          memcpy(mono_coeffs, sln->mono_coeffs, sizeof(Scalar) * num_coeffs);
 
         for (int l = 0; l < this->num_components; l++)
         {
-          elem_coeffs[l] = new int[num_elems];
+          if(!reuse_arrays)
+            elem_coeffs[l] = new int[num_elems];
           memcpy(elem_coeffs[l], sln->elem_coeffs[l], sizeof(int) * num_elems);
         }
 
-        elem_orders = new int[num_elems];
+        if(!reuse_arrays)
+          elem_orders = new int[num_elems];
         memcpy(elem_orders, sln->elem_orders, sizeof(int) * num_elems);
 
-        init_dxdy_buffer();
+        if(sln->space_coeffs != NULL)
+        {
+          if(space_coeffs == NULL || space_coeffs_count != sln->space_coeffs_count)
+          {
+            if(space_coeffs != NULL)
+              delete [] space_coeffs;
+            space_coeffs = new Scalar[sln->space_coeffs_count];
+          }
+          memcpy(space_coeffs, sln->space_coeffs, sizeof(Scalar) * sln->space_coeffs_count);
+          space_coeffs_count = sln->space_coeffs_count;
+          space_seq = sln->space_seq;
+          space_mesh_seq = sln->space_mesh_seq;
+          space_coeffs_dir_lift = sln->space_coeffs_dir_lift;
+        }
+        else if(space_coeffs != NULL)
+        {
+          // do not let a stale dof vector survive next to the new coefficients
+          delete [] space_coeffs;
+          space_coeffs = NULL;
+          space_coeffs_count = 0;
+          space_seq = space_mesh_seq = -1;
+        }
+
+        lazy_conversion = sln->lazy_conversion;
+        if(copy_lazily)
+        {
+          if(!reuse_arrays || elem_converted == NULL)
+          {
+            if(elem_converted != NULL)
+              delete [] elem_converted;
+            elem_converted = new char[num_elems];
+          }
+          memset(elem_converted, 0, num_elems);
+          lazy_space = sln->lazy_space;
+          lazy_add_dir_lift = sln->lazy_add_dir_lift;
+          lazy_coeff_vec = space_coeffs;
+        }
+        else if(elem_converted != NULL)
+        {
+          // The new coefficients are complete, no conversions may fire on stale flags.
+          delete [] elem_converted;
+          elem_converted = NULL;
+          lazy_coeff_vec = NULL;
+          lazy_space = NULL;
+        }
+
+        if(dxdy_buffer == NULL)
+          init_dxdy_buffer();
       }
       else // Const, exact handled differently.
         throw Hermes::Exceptions::Exception("Undefined or exact solutions cannot be copied into an instance of Solution already coming from computation.");
 
       this->element = NULL;
+
+      bump_sln_seq(sln_seq, this);
     }
 
     template<typename Scalar>
@@ -301,9 +436,19 @@ namespace Hermes
     template<>
     void Solution<double>::free()
     {
+      free_mapped_data();
+
       if(mono_coeffs  != NULL) { delete [] mono_coeffs;   mono_coeffs = NULL;  }
       if(elem_orders != NULL) { delete [] elem_orders;  elem_orders = NULL; }
       if(dxdy_buffer != NULL) { delete [] dxdy_buffer;  dxdy_buffer = NULL; }
+      if(space_coeffs != NULL) { delete [] space_coeffs;  space_coeffs = NULL; }
+      space_coeffs_count = 0;
+      space_seq = space_mesh_seq = -1;
+
+      if(elem_converted != NULL) { delete [] elem_converted;  elem_converted = NULL; }
+      if(lazy_pss != NULL) { delete lazy_pss;  lazy_pss = NULL; }
+      lazy_coeff_vec = NULL;
+      lazy_space = NULL;
 
       for (int i = 0; i < this->num_components; i++)
         if(elem_coeffs[i] != NULL)
@@ -312,14 +457,26 @@ namespace Hermes
         e_last = NULL;
 
         free_tables();
+
+        bump_sln_seq(sln_seq, this);
     }
 
 		template<>
 		void Solution<std::complex<double> >::free()
 		{
+			free_mapped_data();
+
 			if(mono_coeffs  != NULL) { delete [] mono_coeffs;   mono_coeffs = NULL;  }
 			if(elem_orders != NULL) { delete [] elem_orders;  elem_orders = NULL; }
 			if(dxdy_buffer != NULL) { delete [] dxdy_buffer;  dxdy_buffer = NULL; }
+			if(space_coeffs != NULL) { delete [] space_coeffs;  space_coeffs = NULL; }
+			space_coeffs_count = 0;
+			space_seq = space_mesh_seq = -1;
+
+			if(elem_converted != NULL) { delete [] elem_converted;  elem_converted = NULL; }
+			if(lazy_pss != NULL) { delete lazy_pss;  lazy_pss = NULL; }
+			lazy_coeff_vec = NULL;
+			lazy_space = NULL;
 
 			for (int i = 0; i < this->num_components; i++)
 				if(elem_coeffs[i] != NULL)
@@ -328,6 +485,8 @@ namespace Hermes
 				e_last = NULL;
 
 				free_tables();
+
+				bump_sln_seq(sln_seq, this);
 		}
 
 		template<>
@@ -429,6 +588,18 @@ namespace Hermes
       delete pss;
     }
 
+    /// Pads a per-component block of monomial coefficients to a cache line boundary.
+    /// All blocks in mono_coeffs then start at the same alignment and the sequential
+    /// reads in precalculate() / make_dx_coeffs() never split a line between two
+    /// elements. The padding is zeroed, so code treating mono_coeffs as one flat
+    /// array (multiply(), copy(), the save methods) works unchanged.
+    template<typename Scalar>
+    static inline int aligned_mono_size(int np)
+    {
+      const int align = 64 / sizeof(Scalar);
+      return (np + align - 1) & ~(align - 1);
+    }
+
     template<typename Scalar>
     void Solution<Scalar>::set_coeff_vector(const Space<Scalar>* space, PrecalcShapeset* pss,
         const Scalar* coeff_vec, bool add_dir_lift, int start_index)
@@ -450,7 +621,27 @@ namespace Hermes
       if(Solution<Scalar>::static_verbose_output)
         Hermes::Mixins::Loggable::Static::info("Solution: set_coeff_vector - solution being freed.");
 
-      free();
+      // If this instance already holds tables laid out for this very space state
+      // (same space and mesh sequence numbers, same number of components), the
+      // element orders and thus all the array sizes and offsets are unchanged -
+      // only the monomial coefficients below have to be recomputed. Repeated
+      // calls with fresh coefficient vectors over a fixed space (Newton loops,
+      // Runge-Kutta stages) then skip the deallocation, the pass collecting the
+      // element orders and the reallocation entirely.
+      bool reuse_layout = sln_type == HERMES_SLN && mono_coeffs != NULL && elem_orders != NULL
+        && this->mesh == space->get_mesh()
+        && space_seq == space->get_seq()
+        && space_mesh_seq == space->get_mesh()->get_seq()
+        && this->num_components == pss->get_num_components();
+
+      if(reuse_layout)
+      {
+        // Only invalidate the values precalculated from the old coefficients.
+        free_tables();
+        e_last = NULL;
+      }
+      else
+        free();
 
       this->space_type = space->get_type();
 
@@ -460,95 +651,229 @@ namespace Hermes
       // Copy the mesh.
       this->mesh = space->get_mesh();
 
-      // Allocate the coefficient arrays.
-      num_elems = this->mesh->get_max_element_id();
-      if(elem_orders != NULL)
-        delete [] elem_orders;
-      elem_orders = new int[num_elems];
-      memset(elem_orders, 0, sizeof(int) * num_elems);
-      for (int l = 0; l < this->num_components; l++)
-      {
-        if(elem_coeffs[l] != NULL)
-          delete [] elem_coeffs[l];
-        elem_coeffs[l] = new int[num_elems];
-        memset(elem_coeffs[l], 0, sizeof(int) * num_elems);
-      }
-
-      // Obtain element orders, allocate mono_coeffs.
       Element* e;
-      num_coeffs = 0;
-      for_all_active_elements(e, this->mesh)
+      if(!reuse_layout)
       {
-        this->mode = e->get_mode();
-        o = space->get_element_order(e->id);
-        o = std::max(H2D_GET_H_ORDER(o), H2D_GET_V_ORDER(o));
-        for (unsigned int k = 0; k < e->get_nvert(); k++)
+        // Allocate the coefficient arrays.
+        num_elems = this->mesh->get_max_element_id();
+        if(elem_orders != NULL)
+          delete [] elem_orders;
+        elem_orders = new int[num_elems];
+        memset(elem_orders, 0, sizeof(int) * num_elems);
+        for (int l = 0; l < this->num_components; l++)
         {
-          int eo = space->get_edge_order(e, k);
-          if(eo > o) o = eo;
+          if(elem_coeffs[l] != NULL)
+            delete [] elem_coeffs[l];
+          elem_coeffs[l] = new int[num_elems];
+          memset(elem_coeffs[l], 0, sizeof(int) * num_elems);
         }
 
-        // Hcurl and Hdiv: actual order of functions is one higher than element order
-        if((space->shapeset)->get_num_components() == 2) o++;
+        // Obtain element orders, allocate mono_coeffs.
+        num_coeffs = 0;
+        for_all_active_elements(e, this->mesh)
+        {
+          this->mode = e->get_mode();
+          o = space->get_element_order(e->id);
+          o = std::max(H2D_GET_H_ORDER(o), H2D_GET_V_ORDER(o));
+          for (unsigned int k = 0; k < e->get_nvert(); k++)
+          {
+            int eo = space->get_edge_order(e, k);
+            if(eo > o) o = eo;
+          }
 
-        num_coeffs += this->mode ? sqr(o + 1) : (o + 1)*(o + 2)/2;
-        elem_orders[e->id] = o;
+          // Hcurl and Hdiv: actual order of functions is one higher than element order
+          if((space->shapeset)->get_num_components() == 2) o++;
+
+          int block = aligned_mono_size<Scalar>(this->mode ? sqr(o + 1) : (o + 1)*(o + 2)/2);
+          // In the lazy mode the offsets have to be known before any conversion runs;
+          // this reproduces the layout the conversion loop below writes.
+          if(lazy_conversion)
+            for (int l = 0; l < this->num_components; l++)
+              elem_coeffs[l][e->id] = num_coeffs * this->num_components + l * block;
+          num_coeffs += block;
+          elem_orders[e->id] = o;
+        }
+        num_coeffs *= this->num_components;
+        if(mono_coeffs != NULL)
+          delete [] mono_coeffs;
+        mono_coeffs = new Scalar[num_coeffs];
+        memset(mono_coeffs, 0, sizeof(Scalar) * num_coeffs);
       }
-      num_coeffs *= this->num_components;
-      if(mono_coeffs != NULL)
-        delete [] mono_coeffs;
-      mono_coeffs = new Scalar[num_coeffs];
 
-      // Express the solution on elements as a linear combination of monomials.
-      Quad2D* quad = &g_quad_2d_cheb;
-      pss->set_quad_2d(quad);
-      Scalar* mono = mono_coeffs;
-      for_all_active_elements(e, this->mesh)
+      if(lazy_conversion)
+      {
+        // Defer the conversion: mark every element pending and remember where the
+        // assembly lists come from. convert_element() picks the elements up one by
+        // one as they are accessed.
+        if(!reuse_layout || elem_converted == NULL)
+        {
+          if(elem_converted != NULL)
+            delete [] elem_converted;
+          elem_converted = new char[num_elems];
+        }
+        memset(elem_converted, 0, num_elems);
+        lazy_space = space;
+        lazy_add_dir_lift = add_dir_lift;
+      }
+      else
       {
-        this->mode = e->get_mode();
-        o = elem_orders[e->id];
-        int np = quad->get_num_points(o, e->get_mode());
+        // Express the solution on elements as a linear combination of monomials.
+        Quad2D* quad = &g_quad_2d_cheb;
+        pss->set_quad_2d(quad);
+        Scalar* mono = mono_coeffs;
+        for_all_active_elements(e, this->mesh)
+        {
+          this->mode = e->get_mode();
+          o = elem_orders[e->id];
+          int np = quad->get_num_points(o, e->get_mode());
 
-        AsmList<Scalar> al;
-        space->get_element_assembly_list(e, &al);
-        pss->set_active_element(e);
+          AsmList<Scalar> al;
+          space->get_element_assembly_list(e, &al);
+          pss->set_active_element(e);
 
-        for (int l = 0; l < this->num_components; l++)
-        {
-          // Obtain solution values for the current element.
-          Scalar* val = mono;
-          elem_coeffs[l][e->id] = (int) (mono - mono_coeffs);
-          memset(val, 0, sizeof(Scalar)*np);
-          for (unsigned int k = 0; k < al.cnt; k++)
+          for (int l = 0; l < this->num_components; l++)
           {
-            pss->set_active_shape(al.idx[k]);
-            pss->set_quad_order(o, H2D_FN_VAL);
-            int dof = al.dof[k];
-            double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
-            // By subtracting space->first_dof we make sure that it does not matter where the
-            // enumeration of dofs in the space starts. This ca be either zero or there can be some
-            // offset. By adding start_index we move to the desired section of coeff_vec.
-            Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof  - space->first_dof + start_index] : dir_lift_coeff);
-            double* shape = pss->get_fn_values(l);
-            for (int i = 0; i < np; i++)
-              val[i] += shape[i] * coef;
-          }
-          mono += np;
+            // Obtain solution values for the current element.
+            Scalar* val = mono;
+            elem_coeffs[l][e->id] = (int) (mono - mono_coeffs);
+            memset(val, 0, sizeof(Scalar)*np);
+            for (unsigned int k = 0; k < al.cnt; k++)
+            {
+              pss->set_active_shape(al.idx[k]);
+              pss->set_quad_order(o, H2D_FN_VAL);
+              int dof = al.dof[k];
+              double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
+              // By subtracting space->first_dof we make sure that it does not matter where the
+              // enumeration of dofs in the space starts. This ca be either zero or there can be some
+              // offset. By adding start_index we move to the desired section of coeff_vec.
+              Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof  - space->first_dof + start_index] : dir_lift_coeff);
+              double* shape = pss->get_fn_values(l);
+              for (int i = 0; i < np; i++)
+                val[i] += shape[i] * coef;
+            }
+            mono += aligned_mono_size<Scalar>(np);
 
-          // solve for the monomial coefficients
-          if(mono_lu.mat[this->mode][o] == NULL)
-            mono_lu.mat[this->mode][o] = calc_mono_matrix(o, mono_lu.perm[this->mode][o]);
-          lubksb(mono_lu.mat[this->mode][o], np, mono_lu.perm[this->mode][o], val);
+            // solve for the monomial coefficients
+            if(mono_lu.mat[this->mode][o] == NULL)
+              mono_lu.mat[this->mode][o] = calc_mono_matrix(o, mono_lu.perm[this->mode][o]);
+            lubksb(mono_lu.mat[this->mode][o], np, mono_lu.perm[this->mode][o], val);
+          }
         }
       }
 
       if(this->mesh == NULL) throw Hermes::Exceptions::Exception("mesh == NULL.\n");
-      init_dxdy_buffer();
+      if(dxdy_buffer == NULL)
+        init_dxdy_buffer();
       this->element = NULL;
+
+      // Remember the dof coefficients and where they belong, so that a projection
+      // of this solution back onto the same space can return them directly.
+      if(space_coeffs == NULL || space_coeffs_count != space->get_num_dofs())
+      {
+        if(space_coeffs != NULL)
+          delete [] space_coeffs;
+        space_coeffs_count = space->get_num_dofs();
+        space_coeffs = new Scalar[space_coeffs_count];
+      }
+      memcpy(space_coeffs, coeff_vec + start_index, sizeof(Scalar) * space_coeffs_count);
+      space_seq = space->get_seq();
+      space_mesh_seq = space->get_mesh()->get_seq();
+      space_coeffs_dir_lift = add_dir_lift;
+      bump_sln_seq(sln_seq, this);
+
+      // The pending conversions read from this copy, not from the caller's vector,
+      // so the caller may free or overwrite it right after this call returns.
+      if(lazy_conversion)
+        lazy_coeff_vec = space_coeffs;
+
       if(Solution<Scalar>::static_verbose_output)
         Hermes::Mixins::Loggable::Static::info("Solution: set_coeff_vector - done.");
     }
 
+    template<typename Scalar>
+    void Solution<Scalar>::use_lazy_conversion(bool onOff)
+    {
+      this->lazy_conversion = onOff;
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::convert_element(Element* e)
+    {
+      if(lazy_coeff_vec == NULL)
+        throw Hermes::Exceptions::Exception("Lazily converted solution accessed after its dof vector was dropped.");
+
+      if(lazy_pss == NULL)
+      {
+        lazy_pss = new PrecalcShapeset(lazy_space->shapeset);
+        lazy_pss->set_quad_2d(&g_quad_2d_cheb);
+      }
+
+      this->mode = e->get_mode();
+      int o = elem_orders[e->id];
+      int np = g_quad_2d_cheb.get_num_points(o, e->get_mode());
+
+      AsmList<Scalar> al;
+      lazy_space->get_element_assembly_list(e, &al);
+      lazy_pss->set_active_element(e);
+
+      for (int l = 0; l < this->num_components; l++)
+      {
+        Scalar* val = mono_coeffs + elem_coeffs[l][e->id];
+        memset(val, 0, sizeof(Scalar)*np);
+        for (unsigned int k = 0; k < al.cnt; k++)
+        {
+          lazy_pss->set_active_shape(al.idx[k]);
+          lazy_pss->set_quad_order(o, H2D_FN_VAL);
+          int dof = al.dof[k];
+          double dir_lift_coeff = lazy_add_dir_lift ? 1.0 : 0.0;
+          Scalar coef = al.coef[k] * (dof >= 0 ? lazy_coeff_vec[dof - lazy_space->first_dof] : dir_lift_coeff);
+          double* shape = lazy_pss->get_fn_values(l);
+          for (int i = 0; i < np; i++)
+            val[i] += shape[i] * coef;
+        }
+
+        // The LU factors of the Chebyshev point matrices are shared by all Solutions
+        // and the per-thread copies made in assembling may convert concurrently.
+        #pragma omp critical (solution_mono_lu)
+        {
+          if(mono_lu.mat[this->mode][o] == NULL)
+            mono_lu.mat[this->mode][o] = calc_mono_matrix(o, mono_lu.perm[this->mode][o]);
+        }
+        lubksb(mono_lu.mat[this->mode][o], np, mono_lu.perm[this->mode][o], val);
+      }
+
+      elem_converted[e->id] = 1;
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::convert_pending_elements()
+    {
+      if(elem_converted == NULL || sln_type != HERMES_SLN)
+        return;
+      Element* e;
+      for_all_active_elements(e, this->mesh)
+        if(!elem_converted[e->id])
+          convert_element(e);
+    }
+
+    template<typename Scalar>
+    bool Solution<Scalar>::has_coeff_vector_for(const Space<Scalar>* space) const
+    {
+      if(space_coeffs == NULL || !space_coeffs_dir_lift)
+        return false;
+      if(sln_type != HERMES_SLN)
+        return false;
+      if(space->get_type() != this->space_type)
+        return false;
+      if(space->get_seq() != space_seq)
+        return false;
+      if(space->get_mesh()->get_seq() != (unsigned) space_mesh_seq)
+        return false;
+      if(space->get_num_dofs() != space_coeffs_count)
+        return false;
+      return true;
+    }
+
     template<typename Scalar>
     void Solution<Scalar>::vector_to_solutions(const Scalar* solution_vector,
         Hermes::vector<const Space<Scalar>*> spaces, Hermes::vector<Solution<Scalar>*> solutions,
@@ -809,13 +1134,47 @@ namespace Hermes
     {
       if(sln_type == HERMES_SLN)
       {
+        // The dof vector is dropped below, so pending conversions have to run now.
+        convert_pending_elements();
+
         for (int i = 0; i < num_coeffs; i++)
           mono_coeffs[i] *= coef;
+
+        // The scaled function no longer matches the remembered dof coefficients
+        // (the Dirichlet lift does not scale with them).
+        if(space_coeffs != NULL)
+        {
+          delete [] space_coeffs;
+          space_coeffs = NULL;
+          space_coeffs_count = 0;
+          space_seq = space_mesh_seq = -1;
+          lazy_coeff_vec = NULL;
+        }
       }
       else if(sln_type == HERMES_EXACT)
         dynamic_cast<ExactSolution<Scalar>*>(this)->exact_multiplicator *= coef;
       else
         throw Hermes::Exceptions::Exception("Uninitialized solution.");
+
+      bump_sln_seq(sln_seq, this);
+    }
+
+    template<typename Scalar>
+    size_t Solution<Scalar>::get_memory_bytes() const
+    {
+      size_t bytes = sizeof(*this);
+      if(mono_coeffs != NULL)
+        bytes += (size_t) num_coeffs * sizeof(Scalar);
+      for (int l = 0; l < this->num_components; l++)
+        if(elem_coeffs[l] != NULL)
+          bytes += (size_t) num_elems * sizeof(int);
+      if(elem_orders != NULL)
+        bytes += (size_t) num_elems * sizeof(int);
+      if(space_coeffs != NULL)
+        bytes += (size_t) space_coeffs_count * sizeof(Scalar);
+      // the precalculated value tables of the Function base
+      bytes += (size_t) this->total_mem;
+      return bytes;
     }
 
     template<typename Scalar>
@@ -906,6 +1265,11 @@ namespace Hermes
 
       if(sln_type == HERMES_SLN)
       {
+        // Lazy mode: the monomial coefficients of an element are computed on its
+        // first activation, see use_lazy_conversion().
+        if(elem_converted != NULL && !elem_converted[e->id])
+          convert_element(e);
+
         int o = this->order = elem_orders[this->element->id];
         int n = this->mode ? sqr(o + 1) : (o + 1)*(o + 2)/2;
 
@@ -1152,9 +1516,18 @@ namespace Hermes
         double* x = this->refmap->get_phys_x(order);
         double* y = this->refmap->get_phys_y(order);
 
-        // evaluate the exact solution
+        // evaluate the exact solution - the whole quadrature batch at once, so that
+        // a vectorized override of exact_functions() gets all the points together
         if(this->num_components == 1)
         {
+          Scalar mult = (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
+          Scalar* val = new Scalar[np];
+          Scalar* dx = new Scalar[np];
+          Scalar* dy = new Scalar[np];
+          memset(dx, 0, np * sizeof(Scalar));
+          memset(dy, 0, np * sizeof(Scalar));
+          (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_functions(x, y, np, val, dx, dy);
+
           // untransform values
           if(!transform)
           {
@@ -1166,38 +1539,46 @@ namespace Hermes
             for (i = 0, m = mat; i < np; i++, m += mstep)
             {
               double jac = (*m)[0][0] *  (*m)[1][1] - (*m)[1][0] *  (*m)[0][1];
-              Scalar val, dx = 0.0, dy = 0.0;
-              val = (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_function(x[i], y[i], dx, dy);
-              node->values[0][0][i] = val * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
-              node->values[0][1][i] = (  (*m)[1][1]*dx - (*m)[0][1]*dy) / jac * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
-              node->values[0][2][i] = (- (*m)[1][0]*dx + (*m)[0][0]*dy) / jac * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
+              node->values[0][0][i] = val[i] * mult;
+              node->values[0][1][i] = (  (*m)[1][1]*dx[i] - (*m)[0][1]*dy[i]) / jac * mult;
+              node->values[0][2][i] = (- (*m)[1][0]*dx[i] + (*m)[0][0]*dy[i]) / jac * mult;
             }
           }
           else
           {
             for (i = 0; i < np; i++)
             {
-              Scalar val, dx = 0.0, dy = 0.0;
-              val = (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_function(x[i], y[i], dx, dy);
-              node->values[0][0][i] = val * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
-              node->values[0][1][i] = dx * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
-              node->values[0][2][i] = dy * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
+              node->values[0][0][i] = val[i] * mult;
+              node->values[0][1][i] = dx[i] * mult;
+              node->values[0][2][i] = dy[i] * mult;
             }
           }
+
+          delete [] val;
+          delete [] dx;
+          delete [] dy;
         }
         else
         {
+          Scalar mult = (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
+          Scalar* comp[2][3];
+          for (j = 0; j < 2; j++)
+            for (int k = 0; k < 3; k++)
+              comp[j][k] = new Scalar[np];
+          (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_functions(x, y, np,
+            comp[0][0], comp[1][0], comp[0][1], comp[1][1], comp[0][2], comp[1][2]);
+
           for (i = 0; i < np; i++)
-          {
-            Scalar2<Scalar> dx (0.0, 0.0 ), dy ( 0.0, 0.0 );
-            Scalar2<Scalar> val = (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_function(x[i], y[i], dx, dy);
             for (j = 0; j < 2; j++)
             {
-              node->values[j][0][i] = val[j] * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
-              node->values[j][1][i] = dx[j] * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
-              node->values[j][2][i] = dy[j] * (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_multiplicator;
+              node->values[j][0][i] = comp[j][0][i] * mult;
+              node->values[j][1][i] = comp[j][1][i] * mult;
+              node->values[j][2][i] = comp[j][2][i] * mult;
             }
-          }
+
+          for (j = 0; j < 2; j++)
+            for (int k = 0; k < 3; k++)
+              delete [] comp[j][k];
         }
       }
       else
@@ -1222,6 +1603,9 @@ namespace Hermes
       if(sln_type == HERMES_UNDEF)
         throw Exceptions::Exception("Cannot save -- uninitialized solution.");
 
+      // The file stores the complete monomial tables.
+      const_cast<Solution<double>*>(this)->convert_pending_elements();
+
       try
       {
         XMLSolution::solution xmlsolution(this->num_components, this->num_elems, this->num_coeffs, 0, 0);
@@ -1282,6 +1666,9 @@ namespace Hermes
       if(sln_type == HERMES_UNDEF)
         throw Exceptions::Exception("Cannot save -- uninitialized solution.");
 
+      // The file stores the complete monomial tables.
+      const_cast<Solution<std::complex<double> >*>(this)->convert_pending_elements();
+
       try
       {
         XMLSolution::solution xmlsolution(this->num_components, this->num_elems, this->num_coeffs, 0, 1);
@@ -1543,6 +1930,183 @@ namespace Hermes
       return;
     }
 
+    static const char H2D_SLN_BIN_MAGIC[8] = { 'H', '2', 'D', 'S', 'O', 'L', 'N' };
+    static const int H2D_SLN_BIN_VERSION = 1;
+    /// Offset of the coefficient array in a binary solution file. The header is padded up to
+    /// this offset, so that the array is aligned for the memory-mapped loading.
+    static const int H2D_SLN_BIN_DATA_OFFSET = 64;
+
+    template<typename Scalar>
+    void Solution<Scalar>::set_mmap_loading(bool onOff)
+    {
+      this->mmap_loading = onOff;
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::free_mapped_data()
+    {
+      if(mapped_data == NULL)
+        return;
+#ifndef WIN32
+      munmap(mapped_data, mapped_size);
+#endif
+      mapped_data = NULL;
+      mapped_size = 0;
+      // The arrays pointed into the mapping, they must not be deleted.
+      mono_coeffs = NULL;
+      elem_orders = NULL;
+      for (int i = 0; i < this->num_components; i++)
+        elem_coeffs[i] = NULL;
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::save_bin(const char* filename) const
+    {
+      if(sln_type == HERMES_UNDEF)
+        throw Exceptions::Exception("Cannot save -- uninitialized solution.");
+      if(sln_type == HERMES_EXACT)
+        throw Hermes::Exceptions::SolutionSaveFailureException("Exact solutions cannot be saved in the binary format, use save().");
+
+      // The file stores the complete monomial tables.
+      const_cast<Solution<Scalar>*>(this)->convert_pending_elements();
+
+      FILE* f = fopen(filename, "wb");
+      if(f == NULL)
+        throw Hermes::Exceptions::SolutionSaveFailureException("Could not open the file %s for writing.", filename);
+
+      int header[7];
+      header[0] = H2D_SLN_BIN_VERSION;
+      header[1] = (int) sizeof(Scalar);
+      header[2] = (int) this->get_space_type();
+      header[3] = this->num_components;
+      header[4] = this->num_elems;
+      header[5] = this->num_coeffs;
+      header[6] = H2D_SLN_BIN_DATA_OFFSET;
+
+      fwrite(H2D_SLN_BIN_MAGIC, 1, sizeof(H2D_SLN_BIN_MAGIC), f);
+      fwrite(header, sizeof(int), 7, f);
+
+      char padding[H2D_SLN_BIN_DATA_OFFSET];
+      memset(padding, 0, sizeof(padding));
+      fwrite(padding, 1, H2D_SLN_BIN_DATA_OFFSET - sizeof(H2D_SLN_BIN_MAGIC) - sizeof(header), f);
+
+      fwrite(mono_coeffs, sizeof(Scalar), this->num_coeffs, f);
+      fwrite(elem_orders, sizeof(int), this->num_elems, f);
+      for (unsigned int component_i = 0; component_i < this->num_components; component_i++)
+        fwrite(elem_coeffs[component_i], sizeof(int), this->num_elems, f);
+
+      if(ferror(f))
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SolutionSaveFailureException("Writing of the file %s failed.", filename);
+      }
+      fclose(f);
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::load_bin(const char* filename, Space<Scalar>* space)
+    {
+      free();
+      this->mesh = space->get_mesh();
+      this->space_type = space->get_type();
+
+      FILE* f = fopen(filename, "rb");
+      if(f == NULL)
+        throw Hermes::Exceptions::SolutionLoadFailureException("Solution file %s not found.", filename);
+
+      char magic[8];
+      int header[7];
+      if(fread(magic, 1, sizeof(magic), f) != sizeof(magic) || memcmp(magic, H2D_SLN_BIN_MAGIC, sizeof(magic)) != 0)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SolutionLoadFailureException("File %s: not a Hermes2D binary solution file.", filename);
+      }
+      if(fread(header, sizeof(int), 7, f) != 7)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SolutionLoadFailureException("File %s: truncated binary solution file.", filename);
+      }
+      if(header[0] != H2D_SLN_BIN_VERSION)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SolutionLoadFailureException("File %s: unsupported binary solution format version %d.", filename, header[0]);
+      }
+      if(header[1] != (int) sizeof(Scalar))
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SolutionLoadFailureException("File %s: scalar type mismatch (stored scalar size %d, expected %d).", filename, header[1], (int) sizeof(Scalar));
+      }
+      if(header[2] != (int) space->get_type())
+      {
+        fclose(f);
+        throw Exceptions::Exception("Space types not compliant in Solution::load_bin().");
+      }
+      if(header[3] < 1 || header[3] > H2D_MAX_SOLUTION_COMPONENTS || header[4] < 0 || header[5] < 0)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SolutionLoadFailureException("File %s: corrupted binary solution file.", filename);
+      }
+
+      sln_type = HERMES_SLN;
+      this->num_components = header[3];
+      this->num_elems = header[4];
+      this->num_coeffs = header[5];
+
+      // Files written before the alignment padding was introduced have no data offset
+      // stored and the arrays follow the header directly.
+      long data_offset = header[6] > 0 ? header[6] : (long) (sizeof(H2D_SLN_BIN_MAGIC) + sizeof(header));
+
+#ifndef WIN32
+      if(this->mmap_loading && header[6] > 0)
+      {
+        fseek(f, 0, SEEK_END);
+        long file_size = ftell(f);
+        long data_size = (long) (num_coeffs * sizeof(Scalar) + (1 + this->num_components) * num_elems * sizeof(int));
+        if(file_size >= data_offset + data_size)
+        {
+          // Copy-on-write mapping: the solution's arrays point directly into the file,
+          // later writes to them stay private to this process.
+          void* mapping = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(f), 0);
+          if(mapping != MAP_FAILED)
+          {
+            this->mapped_data = mapping;
+            this->mapped_size = file_size;
+            char* data = (char*) mapping + data_offset;
+            this->mono_coeffs = (Scalar*) data;
+            data += num_coeffs * sizeof(Scalar);
+            this->elem_orders = (int*) data;
+            data += num_elems * sizeof(int);
+            for (unsigned int component_i = 0; component_i < this->num_components; component_i++)
+            {
+              elem_coeffs[component_i] = (int*) data;
+              data += num_elems * sizeof(int);
+            }
+            fclose(f);
+            init_dxdy_buffer();
+            return;
+          }
+        }
+        this->warn("Could not map the file %s, falling back to reading it.", filename);
+      }
+#endif
+      fseek(f, data_offset, SEEK_SET);
+
+      this->mono_coeffs = new Scalar[num_coeffs];
+      this->elem_orders = new int[num_elems];
+      for (unsigned int component_i = 0; component_i < this->num_components; component_i++)
+        elem_coeffs[component_i] = new int[num_elems];
+
+      bool ok = fread(mono_coeffs, sizeof(Scalar), num_coeffs, f) == (size_t) num_coeffs;
+      ok = ok && fread(elem_orders, sizeof(int), num_elems, f) == (size_t) num_elems;
+      for (unsigned int component_i = 0; component_i < this->num_components; component_i++)
+        ok = ok && fread(elem_coeffs[component_i], sizeof(int), num_elems, f) == (size_t) num_elems;
+      fclose(f);
+      if(!ok)
+        throw Hermes::Exceptions::SolutionLoadFailureException("File %s: truncated binary solution file.", filename);
+
+      init_dxdy_buffer();
+    }
+
     template<typename Scalar>
     Scalar Solution<Scalar>::get_ref_value(Element* e, double xi1, double xi2, int component, int item)
     {
@@ -1565,6 +2129,61 @@ namespace Hermes
       return result;
     }
 
+    template<typename Scalar>
+    int Solution<Scalar>::get_effective_element_order(Element* e, double rel_tolerance) const
+    {
+      if(e == NULL)
+        throw Exceptions::NullException(1);
+      if(sln_type != HERMES_SLN || mono_coeffs == NULL || elem_orders == NULL)
+        return -1;
+      // A lazily converted element not accessed yet has no monomial coefficients
+      // to inspect; behave as if the solution did not come from a dof vector.
+      if(elem_converted != NULL && !elem_converted[e->id])
+        return -1;
+
+      int o = elem_orders[e->id];
+      int e_mode = (e->get_mode() == HERMES_MODE_QUAD) ? 1 : 0;
+
+      // Largest coefficient magnitude per monomial degree. The degree of an
+      // entry follows from the Horner layout used in get_ref_value(): row i
+      // carries the power o-i of the second coordinate, entry j of a row of
+      // length len the power len-1-j of the first one. On quads the degree is
+      // directional (the larger of the two powers), on triangles their sum.
+      double* degree_max = new double[o + 1];
+      for (int i = 0; i <= o; i++)
+        degree_max[i] = 0.0;
+      double max_all = 0.0;
+
+      for (int l = 0; l < this->num_components; l++)
+      {
+        Scalar* mono = mono_coeffs + elem_coeffs[l][e->id];
+        int k = 0;
+        for (int i = 0; i <= o; i++)
+        {
+          int len = (e_mode ? o : i) + 1;
+          for (int j = 0; j < len; j++, k++)
+          {
+            int deg_x = len - 1 - j;
+            int deg_y = o - i;
+            int deg = e_mode ? std::max(deg_x, deg_y) : deg_x + deg_y;
+            double mag = std::abs(mono[k]);
+            if(mag > degree_max[deg])
+              degree_max[deg] = mag;
+            if(mag > max_all)
+              max_all = mag;
+          }
+        }
+      }
+
+      int effective = o;
+      if(max_all > 0.0)
+        while (effective > 0 && degree_max[effective] < rel_tolerance * max_all)
+          effective--;
+
+      delete [] degree_max;
+      return effective;
+    }
+
     template<typename Scalar>
     Scalar Solution<Scalar>::get_ref_value_transformed(Element* e, double xi1, double xi2, int a, int b)
     {
@@ -1704,9 +2323,9 @@ namespace Hermes
         {
           Scalar val, dx = 0.0, dy = 0.0;
           val = (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_function(x, y, dx, dy);
-          toReturn->val = new Scalar[1];
-          toReturn->dx = new Scalar[1];
-          toReturn->dy = new Scalar[1];
+          toReturn->val = new_with_alignment<Scalar>(1);
+          toReturn->dx = new_with_alignment<Scalar>(1);
+          toReturn->dy = new_with_alignment<Scalar>(1);
           toReturn->val[0] = val * (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
           toReturn->dx[0] = dx * (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
           toReturn->dy[0] = dy * (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
@@ -1716,12 +2335,12 @@ namespace Hermes
           Scalar2<Scalar> dx(0.0, 0.0), dy(0.0, 0.0);
           Scalar2<Scalar> val = (static_cast<ExactSolutionVector<Scalar>*>(this))->exact_function(x, y, dx, dy);
 
-          toReturn->val0 = new Scalar[1];
-          toReturn->dx0 = new Scalar[1];
-          toReturn->dy0 = new Scalar[1];
-          toReturn->val1 = new Scalar[1];
-          toReturn->dx1 = new Scalar[1];
-          toReturn->dy1 = new Scalar[1];
+          toReturn->val0 = new_with_alignment<Scalar>(1);
+          toReturn->dx0 = new_with_alignment<Scalar>(1);
+          toReturn->dy0 = new_with_alignment<Scalar>(1);
+          toReturn->val1 = new_with_alignment<Scalar>(1);
+          toReturn->dx1 = new_with_alignment<Scalar>(1);
+          toReturn->dy1 = new_with_alignment<Scalar>(1);
           toReturn->val0[0] = val[0] * (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
           toReturn->val1[0] = val[1] * (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
           toReturn->dx0[0] = dx[0] * (static_cast<ExactSolutionScalar<Scalar>*>(this))->exact_multiplicator;
@@ -1752,9 +2371,9 @@ namespace Hermes
         {
           if(this->num_components == 1)
           {
-            toReturn->val = new Scalar[1];
-            toReturn->dx = new Scalar[1];
-            toReturn->dy = new Scalar[1];
+            toReturn->val = new_with_alignment<Scalar>(1);
+            toReturn->dx = new_with_alignment<Scalar>(1);
+            toReturn->dy = new_with_alignment<Scalar>(1);
 
             toReturn->val[0] = get_ref_value(e, xi1, xi2, 0, 0);
 
@@ -1767,7 +2386,7 @@ namespace Hermes
             toReturn->dy[0] = m[1][0]*dx + m[1][1]*dy;
     
 #ifdef H2D_USE_SECOND_DERIVATIVES
-            toReturn->laplace = new Scalar[1];
+            toReturn->laplace = new_with_alignment<Scalar>(1);
             double2x2 mat;
             double3x2 mat2;
 
@@ -1784,8 +2403,8 @@ namespace Hermes
           }
           else // vector solution
           {
-            toReturn->val0 = new Scalar[1];
-            toReturn->val1 = new Scalar[1];
+            toReturn->val0 = new_with_alignment<Scalar>(1);
+            toReturn->val1 = new_with_alignment<Scalar>(1);
 
             double2x2 m;
             double xx, yy;
@@ -23,6 +23,8 @@
 #include "quadrature/limit_order.h"
 #include "integrals/h1.h"
 #include "discrete_problem.h"
+#include "api2d.h"
+#include "solvers/umfpack_solver.h"
 
 namespace Hermes
 {
@@ -33,6 +35,12 @@ namespace Hermes
     template<typename Scalar>
     double Global<Scalar>::get_l2_norm(Vector<Scalar>* vec)
     {
+      // The residual vectors of the solvers are plain dense arrays - sum their
+      // entries directly instead of going through the virtual get() per entry.
+      Algebra::UMFPackVector<Scalar>* dense_vec = dynamic_cast<Algebra::UMFPackVector<Scalar>*>(vec);
+      if(dense_vec != NULL)
+        return sqrt(vector_norm_squared(dense_vec->length(), dense_vec->get_c_array()));
+
       Scalar val = 0;
       for (unsigned int i = 0; i < vec->length(); i++)
       {
@@ -188,6 +196,281 @@ namespace Hermes
       return calc_abs_errors(slns1, slns2) / calc_norms(slns2);
     }
 
+#define CHUNKSIZE 1
+
+    /// Serial compensated (Kahan) summation of per-state contributions. Always
+    /// running over the state order, it returns the same value no matter how the
+    /// states were distributed between the threads that filled the array.
+    static double sum_contributions(double* contribs, int count)
+    {
+      double sum = 0.0, compensation = 0.0;
+      for (int i = 0; i < count; i++)
+      {
+        double y = contribs[i] - compensation;
+        double t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+      }
+      return sum;
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_abs_error_parallel(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, int norm_type)
+    {
+      // sanity checks
+      if(sln1 == NULL) throw Hermes::Exceptions::Exception("sln1 is NULL in calc_abs_error_parallel().");
+      if(sln2 == NULL) throw Hermes::Exceptions::Exception("sln2 is NULL in calc_abs_error_parallel().");
+
+      // Precalculation of states for the loop to claim them by index.
+      int num_states;
+      Traverse trav_master(true);
+      Hermes::vector<const Mesh*> mesh_vector;
+      mesh_vector.push_back(sln1->get_mesh());
+      mesh_vector.push_back(sln2->get_mesh());
+      Traverse::State** states = trav_master.get_states(mesh_vector, num_states);
+
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+
+      // Solution cloning.
+      MeshFunction<Scalar>** slns1_cloned = new MeshFunction<Scalar>*[num_threads_used];
+      MeshFunction<Scalar>** slns2_cloned = new MeshFunction<Scalar>*[num_threads_used];
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        slns1_cloned[thread] = sln1->clone();
+        slns1_cloned[thread]->set_quad_2d(&g_quad_2d_std);
+        slns2_cloned[thread] = sln2->clone();
+        slns2_cloned[thread]->set_quad_2d(&g_quad_2d_std);
+      }
+
+      // One slot per state; the threads never share a slot, the reduction comes
+      // after the loop.
+      double* contribs = new double[num_states];
+      memset(contribs, 0, num_states * sizeof(double));
+
+      Hermes::Exceptions::Exception* caughtException = NULL;
+
+      MeshFunction<Scalar>* current_sln1;
+      MeshFunction<Scalar>* current_sln2;
+      int state_i;
+#pragma omp parallel shared(states, num_states, contribs) private(current_sln1, current_sln2, state_i) num_threads(num_threads_used)
+      {
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+        for(state_i = 0; state_i < num_states; state_i++)
+        {
+          try
+          {
+            current_sln1 = slns1_cloned[omp_get_thread_num()];
+            current_sln2 = slns2_cloned[omp_get_thread_num()];
+
+            Traverse::State* ee = states[state_i];
+            if(ee->e[0] == NULL || ee->e[1] == NULL)
+              continue;
+            current_sln1->set_active_element(ee->e[0]);
+            current_sln1->set_transform(ee->sub_idx[0]);
+            current_sln2->set_active_element(ee->e[1]);
+            current_sln2->set_transform(ee->sub_idx[1]);
+
+            RefMap* ru = current_sln1->get_refmap();
+            RefMap* rv = current_sln2->get_refmap();
+            switch (norm_type)
+            {
+            case HERMES_L2_NORM:
+              contribs[state_i] = error_fn_l2(current_sln1, current_sln2, ru, rv);
+              break;
+            case HERMES_H1_NORM:
+              contribs[state_i] = error_fn_h1(current_sln1, current_sln2, ru, rv);
+              break;
+            case HERMES_HCURL_NORM:
+              contribs[state_i] = error_fn_hc(current_sln1, current_sln2, ru, rv);
+              break;
+            case HERMES_HDIV_NORM:
+              contribs[state_i] = error_fn_hdiv(current_sln1, current_sln2, ru, rv);
+              break;
+            default: throw Hermes::Exceptions::Exception("Unknown norm in calc_abs_error_parallel().");
+            }
+          }
+          catch(Hermes::Exceptions::Exception& exception)
+          {
+#pragma omp critical (global_calc_exception)
+            if(caughtException == NULL)
+              caughtException = exception.clone();
+          }
+          catch(std::exception& exception)
+          {
+#pragma omp critical (global_calc_exception)
+            if(caughtException == NULL)
+              caughtException = new Hermes::Exceptions::Exception(exception.what());
+          }
+        }
+      }
+
+      // The serial compensated reduction keeping the result independent of the
+      // thread count.
+      double error = sum_contributions(contribs, num_states);
+
+      delete [] contribs;
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        delete slns1_cloned[thread];
+        delete slns2_cloned[thread];
+      }
+      delete [] slns1_cloned;
+      delete [] slns2_cloned;
+
+      Traverse::free_states(states, num_states);
+
+      if(caughtException != NULL)
+        throw *caughtException;
+
+      return sqrt(error);
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_norm_parallel(MeshFunction<Scalar>* sln, int norm_type)
+    {
+      if(sln == NULL) throw Hermes::Exceptions::Exception("sln is NULL in calc_norm_parallel().");
+
+      // Precalculation of states for the loop to claim them by index.
+      int num_states;
+      Traverse trav_master(true);
+      Hermes::vector<const Mesh*> mesh_vector;
+      mesh_vector.push_back(sln->get_mesh());
+      Traverse::State** states = trav_master.get_states(mesh_vector, num_states);
+
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+
+      // Solution cloning.
+      MeshFunction<Scalar>** slns_cloned = new MeshFunction<Scalar>*[num_threads_used];
+      for(int thread = 0; thread < num_threads_used; thread++)
+      {
+        slns_cloned[thread] = sln->clone();
+        slns_cloned[thread]->set_quad_2d(&g_quad_2d_std);
+      }
+
+      double* contribs = new double[num_states];
+      memset(contribs, 0, num_states * sizeof(double));
+
+      Hermes::Exceptions::Exception* caughtException = NULL;
+
+      MeshFunction<Scalar>* current_sln;
+      int state_i;
+#pragma omp parallel shared(states, num_states, contribs) private(current_sln, state_i) num_threads(num_threads_used)
+      {
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+        for(state_i = 0; state_i < num_states; state_i++)
+        {
+          try
+          {
+            current_sln = slns_cloned[omp_get_thread_num()];
+
+            Traverse::State* ee = states[state_i];
+            if(ee->e[0] == NULL)
+              continue;
+            current_sln->set_active_element(ee->e[0]);
+            current_sln->set_transform(ee->sub_idx[0]);
+
+            RefMap* ru = current_sln->get_refmap();
+            switch (norm_type)
+            {
+            case HERMES_L2_NORM:
+              contribs[state_i] = norm_fn_l2(current_sln, ru);
+              break;
+            case HERMES_H1_NORM:
+              contribs[state_i] = norm_fn_h1(current_sln, ru);
+              break;
+            case HERMES_HCURL_NORM:
+              contribs[state_i] = norm_fn_hc(current_sln, ru);
+              break;
+            case HERMES_HDIV_NORM:
+              contribs[state_i] = norm_fn_hdiv(current_sln, ru);
+              break;
+            default: throw Hermes::Exceptions::Exception("Unknown norm in calc_norm_parallel().");
+            }
+          }
+          catch(Hermes::Exceptions::Exception& exception)
+          {
+#pragma omp critical (global_calc_exception)
+            if(caughtException == NULL)
+              caughtException = exception.clone();
+          }
+          catch(std::exception& exception)
+          {
+#pragma omp critical (global_calc_exception)
+            if(caughtException == NULL)
+              caughtException = new Hermes::Exceptions::Exception(exception.what());
+          }
+        }
+      }
+
+      double norm = sum_contributions(contribs, num_states);
+
+      delete [] contribs;
+      for(int thread = 0; thread < num_threads_used; thread++)
+        delete slns_cloned[thread];
+      delete [] slns_cloned;
+
+      Traverse::free_states(states, num_states);
+
+      if(caughtException != NULL)
+        throw *caughtException;
+
+      return sqrt(norm);
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_norms_parallel(Hermes::vector<Solution<Scalar>*> slns)
+    {
+      // Calculate norms for all solutions.
+      Hermes::vector<double> norms;
+      int n = slns.size();
+      for (int i = 0; i<n; i++)
+      {
+        switch (slns[i]->get_space_type())
+        {
+        case HERMES_H1_SPACE: norms.push_back(calc_norm_parallel(slns[i], HERMES_H1_NORM)); break;
+        case HERMES_HCURL_SPACE: norms.push_back(calc_norm_parallel(slns[i], HERMES_HCURL_NORM)); break;
+        case HERMES_HDIV_SPACE: norms.push_back(calc_norm_parallel(slns[i], HERMES_HDIV_NORM)); break;
+        case HERMES_L2_SPACE: norms.push_back(calc_norm_parallel(slns[i], HERMES_L2_NORM)); break;
+        default: throw Hermes::Exceptions::Exception("Internal in calc_norms_parallel(): unknown space type.");
+        }
+      }
+      // Calculate the resulting norm.
+      double result = 0;
+      for (int i = 0; i < n; i++)
+        result += norms[i] * norms[i];
+      return sqrt(result);
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_abs_errors_parallel(Hermes::vector<Solution<Scalar>*> slns1, Hermes::vector<Solution<Scalar>*> slns2)
+    {
+      // Calculate errors for all solutions.
+      Hermes::vector<double> errors;
+      int n = slns1.size();
+      for (int i = 0; i < n; i++)
+      {
+        switch (slns1[i]->get_space_type())
+        {
+        case HERMES_H1_SPACE: errors.push_back(calc_abs_error_parallel(slns1[i], slns2[i], HERMES_H1_NORM)); break;
+        case HERMES_HCURL_SPACE: errors.push_back(calc_abs_error_parallel(slns1[i], slns2[i], HERMES_HCURL_NORM)); break;
+        case HERMES_HDIV_SPACE: errors.push_back(calc_abs_error_parallel(slns1[i], slns2[i], HERMES_HDIV_NORM)); break;
+        case HERMES_L2_SPACE: errors.push_back(calc_abs_error_parallel(slns1[i], slns2[i], HERMES_L2_NORM)); break;
+        default: throw Hermes::Exceptions::Exception("Internal in calc_abs_errors_parallel(): unknown space type.");
+        }
+      }
+      // Calculate the resulting error.
+      double result = 0;
+      for (int i = 0; i < n; i++)
+        result += errors[i] * errors[i];
+      return sqrt(result);
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_rel_errors_parallel(Hermes::vector<Solution<Scalar>*> slns1, Hermes::vector<Solution<Scalar>*> slns2)
+    {
+      return calc_abs_errors_parallel(slns1, slns2) / calc_norms_parallel(slns2);
+    }
+
     template<typename Scalar>
     double Global<Scalar>::error_fn_h1(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, RefMap* ru, RefMap* rv)
     {
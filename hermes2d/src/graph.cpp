@@ -24,6 +24,143 @@ namespace Hermes
       set_captions(title, x_axis_name, y_axis_name);
       logx = logy = false;
       legend = grid = true;
+
+      recording = false;
+      recording_binary = true;
+      recording_file = NULL;
+      recording_front = NULL;
+      recording_back = NULL;
+      recording_capacity = 0;
+      recording_count = 0;
+      recording_stop = false;
+      pthread_mutex_init(&recording_mutex, NULL);
+      pthread_cond_init(&recording_cond, NULL);
+    }
+
+    Graph::~Graph()
+    {
+      if(recording)
+        stop_recording();
+      pthread_cond_destroy(&recording_cond);
+      pthread_mutex_destroy(&recording_mutex);
+    }
+
+    void Graph::set_recording(const char* filename, bool binary)
+    {
+      if(recording)
+        stop_recording();
+
+      recording_file = fopen(filename, binary ? "ab" : "at");
+      if(recording_file == NULL) throw Hermes::Exceptions::Exception("Error writing to %s.", filename);
+
+      recording_binary = binary;
+      recording_capacity = 1024;
+      recording_front = (Record*) malloc(sizeof(Record) * recording_capacity);
+      recording_back = (Record*) malloc(sizeof(Record) * recording_capacity);
+      recording_count = 0;
+      recording_stop = false;
+      recording = true;
+      pthread_create(&recording_thread, NULL, recording_thread_fn, this);
+    }
+
+    void Graph::stop_recording()
+    {
+      if(!recording)
+        return;
+
+      pthread_mutex_lock(&recording_mutex);
+      recording_stop = true;
+      pthread_cond_signal(&recording_cond);
+      pthread_mutex_unlock(&recording_mutex);
+      pthread_join(recording_thread, NULL);
+
+      recording = false;
+      fclose(recording_file);
+      recording_file = NULL;
+      ::free(recording_front);
+      recording_front = NULL;
+      ::free(recording_back);
+      recording_back = NULL;
+      recording_capacity = recording_count = 0;
+    }
+
+    void Graph::record_values(int row, double x, double y)
+    {
+      pthread_mutex_lock(&recording_mutex);
+      if(recording_count >= recording_capacity)
+      {
+        // The flushing thread has not kept up - grow the buffers rather than wait.
+        recording_capacity *= 2;
+        recording_front = (Record*) realloc(recording_front, sizeof(Record) * recording_capacity);
+        recording_back = (Record*) realloc(recording_back, sizeof(Record) * recording_capacity);
+      }
+      Record* record = recording_front + recording_count++;
+      record->row = row;
+      record->x = x;
+      record->y = y;
+      if(recording_count >= recording_capacity / 2)
+        pthread_cond_signal(&recording_cond);
+      pthread_mutex_unlock(&recording_mutex);
+    }
+
+    void* Graph::recording_thread_fn(void* graph)
+    {
+      Graph* g = (Graph*) graph;
+      pthread_mutex_lock(&g->recording_mutex);
+      while(true)
+      {
+        while(g->recording_count == 0 && !g->recording_stop)
+          pthread_cond_wait(&g->recording_cond, &g->recording_mutex);
+        if(g->recording_count == 0 && g->recording_stop)
+          break;
+
+        // Swap the buffers and write outside of the lock, so that the recording
+        // side is never blocked by the disk.
+        Record* records = g->recording_front;
+        int count = g->recording_count;
+        g->recording_front = g->recording_back;
+        g->recording_back = records;
+        g->recording_count = 0;
+
+        pthread_mutex_unlock(&g->recording_mutex);
+        g->write_records(records, count);
+        pthread_mutex_lock(&g->recording_mutex);
+      }
+      pthread_mutex_unlock(&g->recording_mutex);
+      return NULL;
+    }
+
+    void Graph::write_records(Record* records, int count)
+    {
+      if(recording_binary)
+        fwrite(records, sizeof(Record), count, recording_file);
+      else
+        for (int i = 0; i < count; i++)
+          fprintf(recording_file, "%d  %.14g  %.14g\n", records[i].row, records[i].x, records[i].y);
+      fflush(recording_file);
+    }
+
+    void Graph::load_recording(const char* filename, bool binary)
+    {
+      FILE* f = fopen(filename, binary ? "rb" : "rt");
+      if(f == NULL) throw Hermes::Exceptions::Exception("Error reading %s.", filename);
+
+      Record record;
+      while(true)
+      {
+        if(binary)
+        {
+          if(fread(&record, sizeof(Record), 1, f) != 1)
+            break;
+        }
+        else if(fscanf(f, "%d %lf %lf", &record.row, &record.x, &record.y) != 3)
+          break;
+
+        while((int)rows.size() <= record.row)
+          add_row(NULL);
+        add_values(record.row, record.x, record.y);
+      }
+      fclose(f);
     }
 
     void Graph::set_log_x(bool log)
@@ -83,6 +220,8 @@ namespace Hermes
       if(row < 0 || row >= (int)rows.size()) throw Hermes::Exceptions::Exception("Invalid row number.");
       Values xy = { x, y };
       rows[row].data.push_back(xy);
+      if(recording)
+        record_values(row, x, y);
     }
 
     void Graph::add_values(double x, double y)
@@ -93,6 +232,8 @@ namespace Hermes
       // (sometimes the CPU time was zero and plotting crashed)
       Values xy = { x, y };
       rows[row].data.push_back(xy);
+      if(recording)
+        record_values(row, x, y);
     }
 
     void Graph::add_values(int row, int n, double* x, double* y)
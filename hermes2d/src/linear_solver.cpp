@@ -20,6 +20,8 @@
 \brief General nonlinear solver functionality.
 */
 #include "linear_solver.h"
+#include "static_condensation.h"
+#include "solvers/umfpack_solver.h"
 
 using namespace Hermes::Algebra;
 
@@ -57,9 +59,41 @@ namespace Hermes
       this->jacobian = create_matrix<Scalar>();
       this->residual = create_vector<Scalar>();
       this->matrix_solver = create_linear_solver<Scalar>(this->jacobian, this->residual);
+      this->static_condensation = false;
+      this->condensed_sln_vector = NULL;
+      this->pipelined_assembling = false;
+      this->dp_pre = NULL;
+      this->jacobian_pre = NULL;
+      this->dirichlet_lift_pre = NULL;
+      this->pre_assembled_valid = false;
+      this->constant_nullspace = false;
+      this->bordered_matrix = NULL;
+      this->bordered_rhs = NULL;
+      this->bordered_solver = NULL;
+      this->nullspace_sln_vector = NULL;
       this->set_verbose_output(true);
     }
 
+    template<typename Scalar>
+    void LinearSolver<Scalar>::set_static_condensation(bool to_set)
+    {
+      this->static_condensation = to_set;
+    }
+
+    template<typename Scalar>
+    void LinearSolver<Scalar>::set_pipelined_assembling(bool to_set)
+    {
+      this->pipelined_assembling = to_set;
+      if(!to_set)
+        this->pre_assembled_valid = false;
+    }
+
+    template<typename Scalar>
+    void LinearSolver<Scalar>::set_constant_nullspace(bool to_set)
+    {
+      this->constant_nullspace = to_set;
+    }
+
     template<typename Scalar>
     bool LinearSolver<Scalar>::isOkay() const
     {
@@ -85,6 +119,9 @@ namespace Hermes
     void LinearSolver<Scalar>::set_weak_formulation(const WeakForm<Scalar>* wf)
     {
       (static_cast<DiscreteProblem<Scalar>*>(this->dp))->set_weak_formulation(wf);
+      if(this->dp_pre != NULL)
+        (static_cast<DiscreteProblem<Scalar>*>(this->dp_pre))->set_weak_formulation(wf);
+      this->pre_assembled_valid = false;
     }
 
     template<typename Scalar>
@@ -109,12 +146,18 @@ namespace Hermes
     void LinearSolver<Scalar>::set_spaces(Hermes::vector<const Space<Scalar>*> spaces)
     {
       static_cast<DiscreteProblem<Scalar>*>(this->dp)->set_spaces(spaces);
+      if(this->dp_pre != NULL)
+        static_cast<DiscreteProblem<Scalar>*>(this->dp_pre)->set_spaces(spaces);
+      this->pre_assembled_valid = false;
     }
 
     template<typename Scalar>
     void LinearSolver<Scalar>::set_space(const Space<Scalar>* space)
     {
       static_cast<DiscreteProblem<Scalar>*>(this->dp)->set_space(space);
+      if(this->dp_pre != NULL)
+        static_cast<DiscreteProblem<Scalar>*>(this->dp_pre)->set_space(space);
+      this->pre_assembled_valid = false;
     }
     
     template<typename Scalar>
@@ -129,6 +172,22 @@ namespace Hermes
       delete jacobian;
       delete residual;
       delete matrix_solver;
+      if(condensed_sln_vector != NULL)
+        delete [] condensed_sln_vector;
+      if(jacobian_pre != NULL)
+        delete jacobian_pre;
+      if(dirichlet_lift_pre != NULL)
+        delete dirichlet_lift_pre;
+      if(dp_pre != NULL)
+        delete dp_pre;
+      if(bordered_solver != NULL)
+        delete bordered_solver;
+      if(bordered_matrix != NULL)
+        delete bordered_matrix;
+      if(bordered_rhs != NULL)
+        delete bordered_rhs;
+      if(nullspace_sln_vector != NULL)
+        delete [] nullspace_sln_vector;
       if(own_dp)
         delete this->dp;
       else
@@ -140,38 +199,126 @@ namespace Hermes
     {
       this->check();
 
+      if(this->constant_nullspace && (this->static_condensation || this->pipelined_assembling))
+        throw Hermes::Exceptions::Exception("Constant nullspace handling cannot be combined with static condensation or pipelined assembling.");
+
       this->tick();
 
       this->on_initialization();
 
-      dp->assemble(this->jacobian, this->residual);
+      double solve_time = const_cast<WeakForm<Scalar>*>(this->dp->wf)->get_current_time();
+
+      if(this->pipelined_assembling && this->pre_assembled_valid && solve_time == this->pre_assembled_time)
+      {
+        // The matrix for this time level was already assembled during the
+        // previous factorization - only the right-hand side remains. The
+        // Dirichlet lift comes from the matrix forms and was pre-assembled
+        // together with the matrix.
+        this->jacobian->zero();
+        this->jacobian->add_sparse_matrix(this->jacobian_pre);
+        dp->assemble((SparseMatrix<Scalar>*)NULL, this->residual);
+        this->residual->add_vector(this->dirichlet_lift_pre);
+      }
+      else
+        dp->assemble(this->jacobian, this->residual);
+      this->pre_assembled_valid = false;
       if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= 1))
       {
-        char* fileName = new char[this->RhsFilename.length() + 5];
-        if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-          sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), 1);
-        else
-          sprintf(fileName, "%s%i", this->RhsFilename.c_str(), 1);
-        FILE* rhs_file = fopen(fileName, "w+");
+        FILE* rhs_file = this->open_rhs_file(1);
         residual->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
         fclose(rhs_file);
       }
       if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= 1))
         {
-          char* fileName = new char[this->matrixFilename.length() + 5];
-          if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), 1);
-          else
-            sprintf(fileName, "%s%i", this->matrixFilename.c_str(), 1);
-          FILE* matrix_file = fopen(fileName, "w+");
-
+          FILE* matrix_file = this->open_matrix_file(1);
           jacobian->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
           fclose(matrix_file);
         }
 
-      this->matrix_solver->solve();
+      if(this->static_condensation)
+      {
+        // Eliminate the element-interior DOFs, solve the reduced system only
+        // and recover the eliminated values by back-substitution.
+        StaticCondensation<Scalar> condensation(this->dp->get_spaces());
+        condensation.condense(jacobian, residual);
+
+        if(this->condensed_sln_vector != NULL)
+          delete [] this->condensed_sln_vector;
+        this->condensed_sln_vector = new Scalar[Space<Scalar>::get_num_dofs(this->dp->get_spaces())];
+
+        if(condensation.get_reduced_ndof() > 0)
+        {
+          LinearMatrixSolver<Scalar>* reduced_solver = create_linear_solver<Scalar>(condensation.get_reduced_matrix(), condensation.get_reduced_rhs());
+          reduced_solver->solve();
+          condensation.recover(reduced_solver->get_sln_vector(), this->condensed_sln_vector);
+          delete reduced_solver;
+        }
+        else
+          condensation.recover(NULL, this->condensed_sln_vector);
+
+        this->sln_vector = this->condensed_sln_vector;
+      }
+      else if(this->constant_nullspace)
+        this->solve_with_constant_nullspace();
+      else
+      {
+        if(this->pipelined_assembling)
+        {
+          // While the matrix solver factorizes, assemble the next time
+          // level's matrix on the spare threads. A second discrete problem is
+          // used so that the primary one keeps the sparse structure of
+          // this->jacobian.
+          if(this->dp_pre == NULL)
+          {
+            this->dp_pre = new DiscreteProblemLinear<Scalar>(this->dp->wf, this->dp->get_spaces());
+            this->jacobian_pre = create_matrix<Scalar>();
+            this->dirichlet_lift_pre = create_vector<Scalar>();
+          }
+
+          double next_time = solve_time + const_cast<WeakForm<Scalar>*>(this->dp->wf)->get_current_time_step();
+
+#pragma omp parallel sections num_threads(2)
+          {
+#pragma omp section
+            {
+              this->matrix_solver->solve();
+            }
+#pragma omp section
+            {
+              try
+              {
+                const_cast<WeakForm<Scalar>*>(this->dp->wf)->set_current_time(next_time);
 
-      this->sln_vector = matrix_solver->get_sln_vector();
+                // The matrix together with the complete right-hand side; the
+                // vector forms alone are then subtracted, leaving the
+                // Dirichlet lift which cannot be re-created later without the
+                // matrix forms.
+                this->dp_pre->assemble(this->jacobian_pre, this->dirichlet_lift_pre);
+                Vector<Scalar>* vector_part = create_vector<Scalar>();
+                this->dp_pre->assemble((SparseMatrix<Scalar>*)NULL, vector_part);
+                vector_part->change_sign();
+                this->dirichlet_lift_pre->add_vector(vector_part);
+                delete vector_part;
+
+                const_cast<WeakForm<Scalar>*>(this->dp->wf)->set_current_time(solve_time);
+                this->pre_assembled_time = next_time;
+                this->pre_assembled_valid = true;
+              }
+              catch(...)
+              {
+                // An exception must not leave an OpenMP section; the next
+                // solve() simply falls back to a full assembly.
+                const_cast<WeakForm<Scalar>*>(this->dp->wf)->set_current_time(solve_time);
+                this->pre_assembled_valid = false;
+              }
+            }
+          }
+        }
+        else
+          this->matrix_solver->solve();
+
+        this->sln_vector = matrix_solver->get_sln_vector();
+      }
 
       this->on_finish();
       
@@ -179,6 +326,106 @@ namespace Hermes
       this->info("\tLinear solver solution duration: %f s.\n", this->last());
     }
 
+    template<typename Scalar>
+    void LinearSolver<Scalar>::solve_with_constant_nullspace()
+    {
+#ifdef WITH_UMFPACK
+      Algebra::CSCMatrix<Scalar>* mat = dynamic_cast<Algebra::CSCMatrix<Scalar>*>(this->jacobian);
+      if(mat == NULL)
+        throw Hermes::Exceptions::Exception("Constant nullspace handling requires a CSC-based matrix backend (UMFPACK).");
+
+      unsigned int n = mat->get_size();
+      unsigned int nnz = mat->get_nnz();
+      int* ap = mat->get_Ap();
+      int* ai = mat->get_Ai();
+      Scalar* ax = mat->get_Ax();
+
+      // The bordered matrix: A extended by one row and column of ones tying
+      // the mean of the solution to zero, with a zero diagonal entry for the
+      // multiplier. The border makes the system regular and keeps whatever
+      // symmetry A has. The row indices of a CSC column are sorted, and
+      // appending row n to each column preserves that.
+      unsigned int bordered_nnz = nnz + 2 * n + 1;
+      int* bap = new int[n + 2];
+      int* bai = new int[bordered_nnz];
+      Scalar* bax = new Scalar[bordered_nnz];
+      unsigned int pos = 0;
+      for (unsigned int j = 0; j < n; j++)
+      {
+        bap[j] = pos;
+        for (int k = ap[j]; k < ap[j + 1]; k++)
+        {
+          bai[pos] = ai[k];
+          bax[pos++] = ax[k];
+        }
+        bai[pos] = n;
+        bax[pos++] = Scalar(1.);
+      }
+      bap[n] = pos;
+      for (unsigned int i = 0; i < n; i++)
+      {
+        bai[pos] = i;
+        bax[pos++] = Scalar(1.);
+      }
+      bai[pos] = n;
+      bax[pos++] = Scalar(0.);
+      bap[n + 1] = pos;
+
+      // When the pattern did not change since the last solve, only refresh
+      // the values so the solver can reuse its symbolic factorization.
+      Algebra::UMFPackMatrix<Scalar>* bordered = static_cast<Algebra::UMFPackMatrix<Scalar>*>(this->bordered_matrix);
+      bool same_structure = bordered != NULL && bordered->get_size() == n + 1 && bordered->get_nnz() == bordered_nnz
+        && memcmp(bordered->get_Ap(), bap, (n + 2) * sizeof(int)) == 0
+        && memcmp(bordered->get_Ai(), bai, bordered_nnz * sizeof(int)) == 0;
+      if(same_structure)
+        memcpy(bordered->get_Ax(), bax, bordered_nnz * sizeof(Scalar));
+      else
+      {
+        if(this->bordered_solver != NULL)
+        {
+          delete this->bordered_solver;
+          this->bordered_solver = NULL;
+        }
+        if(bordered == NULL)
+        {
+          bordered = new Algebra::UMFPackMatrix<Scalar>();
+          this->bordered_matrix = bordered;
+        }
+        bordered->create(n + 1, bordered_nnz, bap, bai, bax);
+      }
+      delete [] bap;
+      delete [] bai;
+      delete [] bax;
+
+      if(this->bordered_rhs != NULL && this->bordered_rhs->length() != n + 1)
+      {
+        delete this->bordered_rhs;
+        this->bordered_rhs = NULL;
+      }
+      if(this->bordered_rhs == NULL)
+        this->bordered_rhs = new Algebra::UMFPackVector<Scalar>(n + 1);
+      Scalar* b = static_cast<Algebra::UMFPackVector<Scalar>*>(this->bordered_rhs)->get_c_array();
+      for (unsigned int i = 0; i < n; i++)
+        b[i] = this->residual->get(i);
+      b[n] = Scalar(0.);
+
+      if(this->bordered_solver == NULL)
+        this->bordered_solver = new Hermes::Solvers::UMFPackLinearMatrixSolver<Scalar>(bordered,
+          static_cast<Algebra::UMFPackVector<Scalar>*>(this->bordered_rhs));
+      else
+        this->bordered_solver->set_factorization_scheme(Hermes::Solvers::HERMES_REUSE_MATRIX_REORDERING);
+      this->bordered_solver->solve();
+
+      if(this->nullspace_sln_vector != NULL)
+        delete [] this->nullspace_sln_vector;
+      this->nullspace_sln_vector = new Scalar[n];
+      memcpy(this->nullspace_sln_vector, this->bordered_solver->get_sln_vector(), n * sizeof(Scalar));
+      this->sln_vector = this->nullspace_sln_vector;
+#else
+      throw Hermes::Exceptions::Exception("Constant nullspace handling requires a CSC-based matrix backend (UMFPACK).");
+#endif
+    }
+
     template<typename Scalar>
     Scalar *LinearSolver<Scalar>::get_sln_vector()
     {
@@ -16,6 +16,7 @@
 #include "global.h"
 #include "mesh.h"
 #include "hash.h"
+#include "api2d.h"
 
 namespace Hermes
 {
@@ -24,6 +25,11 @@ namespace Hermes
     HashTable::HashTable()
     {
       v_table = NULL; e_table = NULL;
+      flat_tables = false;
+      v_flat.p1 = v_flat.p2 = v_flat.id = NULL;
+      e_flat.p1 = e_flat.p2 = e_flat.id = NULL;
+      v_flat.capacity = v_flat.count = v_flat.mask = 0;
+      e_flat.capacity = e_flat.count = e_flat.mask = 0;
     }
 
     HashTable::~HashTable()
@@ -38,6 +44,14 @@ namespace Hermes
       mask = size-1;
       if(size & mask) throw Hermes::Exceptions::Exception("Parameter 'size' must be a power of two.");
 
+      flat_tables = (Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::useOpenAddressingHashTables) != 0);
+      if(flat_tables)
+      {
+        flat_init(v_flat, size);
+        flat_init(e_flat, size);
+        return;
+      }
+
       // allocate and initialize the hash tables
       v_table = new Node*[size];
       e_table = new Node*[size];
@@ -46,6 +60,116 @@ namespace Hermes
       memset(e_table, 0, size * sizeof(Node*));
     }
 
+    void HashTable::flat_init(FlatTable& table, int size)
+    {
+      table.capacity = size;
+      table.mask = size - 1;
+      table.count = 0;
+      table.p1 = new int[size];
+      table.p2 = new int[size];
+      table.id = new int[size];
+      for (int i = 0; i < size; i++)
+        table.p1[i] = -1;
+    }
+
+    void HashTable::flat_free(FlatTable& table)
+    {
+      if(table.p1 != NULL)
+      {
+        delete [] table.p1;
+        table.p1 = NULL;
+      }
+      if(table.p2 != NULL)
+      {
+        delete [] table.p2;
+        table.p2 = NULL;
+      }
+      if(table.id != NULL)
+      {
+        delete [] table.id;
+        table.id = NULL;
+      }
+      table.capacity = table.count = table.mask = 0;
+    }
+
+    void HashTable::flat_grow(FlatTable& table)
+    {
+      FlatTable old = table;
+      flat_init(table, 2 * old.capacity);
+      for (int i = 0; i < old.capacity; i++)
+        if(old.p1[i] >= 0)
+          flat_insert(table, old.p1[i], old.p2[i], old.id[i]);
+      delete [] old.p1;
+      delete [] old.p2;
+      delete [] old.id;
+    }
+
+    void HashTable::reserve_nodes(int num_vertex, int num_edge)
+    {
+      if(!flat_tables)
+        return;
+      while (4 * (v_flat.count + num_vertex) > 3 * v_flat.capacity)
+        flat_grow(v_flat);
+      while (4 * (e_flat.count + num_edge) > 3 * e_flat.capacity)
+        flat_grow(e_flat);
+    }
+
+    size_t HashTable::get_node_table_bytes() const
+    {
+      size_t bytes = nodes.get_memory_bytes();
+      if(flat_tables)
+        bytes += (size_t) (v_flat.capacity + e_flat.capacity) * 3 * sizeof(int);
+      else if(v_table != NULL)
+        bytes += (size_t) (mask + 1) * 2 * sizeof(Node*);
+      return bytes;
+    }
+
+    int HashTable::flat_lookup(const FlatTable& table, int p1, int p2) const
+    {
+      int i = (984120265*p1 + 125965121*p2) & table.mask;
+      while (table.p1[i] != -1)
+      {
+        if(table.p1[i] == p1 && table.p2[i] == p2)
+          return table.id[i];
+        i = (i + 1) & table.mask;
+      }
+      return -1;
+    }
+
+    void HashTable::flat_insert(FlatTable& table, int p1, int p2, int id)
+    {
+      // keep the load factor below 3/4, deleted slots included
+      if(4 * (table.count + 1) > 3 * table.capacity)
+        flat_grow(table);
+
+      int i = (984120265*p1 + 125965121*p2) & table.mask;
+      while (table.p1[i] >= 0)
+        i = (i + 1) & table.mask;
+
+      // reusing a deleted slot does not raise the count
+      if(table.p1[i] == -1)
+        table.count++;
+
+      table.p1[i] = p1;
+      table.p2[i] = p2;
+      table.id[i] = id;
+    }
+
+    void HashTable::flat_remove(FlatTable& table, int p1, int p2, int id)
+    {
+      int i = (984120265*p1 + 125965121*p2) & table.mask;
+      while (table.p1[i] != -1)
+      {
+        if(table.p1[i] == p1 && table.p2[i] == p2 && table.id[i] == id)
+        {
+          // mark the slot as deleted so that probe sequences stay intact
+          table.p1[i] = -2;
+          return;
+        }
+        i = (i + 1) & table.mask;
+      }
+    }
+
     void HashTable::copy_list(Node** ptr, Node* node)
     {
       while (node != NULL)
@@ -79,6 +203,23 @@ namespace Hermes
       free();
       nodes.copy(ht->nodes);
       mask = ht->mask;
+      flat_tables = ht->flat_tables;
+
+      if(flat_tables)
+      {
+        // node ids are preserved by nodes.copy, so the tables can be copied verbatim
+        flat_init(v_flat, ht->v_flat.capacity);
+        flat_init(e_flat, ht->e_flat.capacity);
+        memcpy(v_flat.p1, ht->v_flat.p1, v_flat.capacity * sizeof(int));
+        memcpy(v_flat.p2, ht->v_flat.p2, v_flat.capacity * sizeof(int));
+        memcpy(v_flat.id, ht->v_flat.id, v_flat.capacity * sizeof(int));
+        memcpy(e_flat.p1, ht->e_flat.p1, e_flat.capacity * sizeof(int));
+        memcpy(e_flat.p2, ht->e_flat.p2, e_flat.capacity * sizeof(int));
+        memcpy(e_flat.id, ht->e_flat.id, e_flat.capacity * sizeof(int));
+        v_flat.count = ht->v_flat.count;
+        e_flat.count = ht->e_flat.count;
+        return;
+      }
 
       v_table = new Node*[mask + 1];
       e_table = new Node*[mask + 1];
@@ -91,6 +232,33 @@ namespace Hermes
 
     void HashTable::rebuild()
     {
+      if(flat_tables)
+      {
+        int size = v_flat.capacity;
+        flat_free(v_flat);
+        flat_free(e_flat);
+        flat_init(v_flat, size);
+        flat_init(e_flat, size);
+
+        Node* node;
+        for_all_nodes(node, this)
+        {
+          // top-level vertex nodes (p1 == p2 == -1) are never searched by parent
+          // ids and must stay out of the table, -1 being the empty-slot sentinel
+          if(node->p1 < 0)
+            continue;
+
+          int p1 = node->p1, p2 = node->p2;
+          if(p1 > p2) std::swap(p1, p2);
+
+          if(node->type == HERMES_TYPE_VERTEX)
+            flat_insert(v_flat, p1, p2, node->id);
+          else
+            flat_insert(e_flat, p1, p2, node->id);
+        }
+        return;
+      }
+
       memset(v_table, 0, (mask + 1) * sizeof(Node*));
       memset(e_table, 0, (mask + 1) * sizeof(Node*));
 
@@ -127,6 +295,8 @@ namespace Hermes
         delete [] e_table;
         e_table = NULL;
       }
+      flat_free(v_flat);
+      flat_free(e_flat);
     }
 
     inline Node* HashTable::search_list(Node* node, int p1, int p2) const
@@ -144,10 +314,18 @@ namespace Hermes
     {
       // search for the node in the vertex hashtable
       if(p1 > p2) std::swap(p1, p2);
-      int i = hash(p1, p2);
-      Node* node = search_list(v_table[i], p1, p2);
-      if(node != NULL) 
-        return node;
+      if(flat_tables)
+      {
+        int id = flat_lookup(v_flat, p1, p2);
+        if(id >= 0)
+          return &nodes[id];
+      }
+      else
+      {
+        Node* node = search_list(v_table[hash(p1, p2)], p1, p2);
+        if(node != NULL)
+          return node;
+      }
 
       // not found - create a new one
       Node* newnode = nodes.add();
@@ -163,8 +341,17 @@ namespace Hermes
       newnode->y = (nodes[p1].y + nodes[p2].y) * 0.5;
 
       // insert into hashtable
-      newnode->next_hash = v_table[i];
-      v_table[i] = newnode;
+      if(flat_tables)
+      {
+        newnode->next_hash = NULL;
+        flat_insert(v_flat, p1, p2, newnode->id);
+      }
+      else
+      {
+        int i = hash(p1, p2);
+        newnode->next_hash = v_table[i];
+        v_table[i] = newnode;
+      }
 
       return newnode;
     }
@@ -173,9 +360,17 @@ namespace Hermes
     {
       // search for the node in the edge hashtable
       if(p1 > p2) std::swap(p1, p2);
-      int i = hash(p1, p2);
-      Node* node = search_list(e_table[i], p1, p2);
-      if(node != NULL) return node;
+      if(flat_tables)
+      {
+        int id = flat_lookup(e_flat, p1, p2);
+        if(id >= 0)
+          return &nodes[id];
+      }
+      else
+      {
+        Node* node = search_list(e_table[hash(p1, p2)], p1, p2);
+        if(node != NULL) return node;
+      }
 
       // not found - create a new one
       Node* newnode = nodes.add();
@@ -190,8 +385,17 @@ namespace Hermes
       newnode->elem[0] = newnode->elem[1] = NULL;
 
       // insert into hashtable
-      newnode->next_hash = e_table[i];
-      e_table[i] = newnode;
+      if(flat_tables)
+      {
+        newnode->next_hash = NULL;
+        flat_insert(e_flat, p1, p2, newnode->id);
+      }
+      else
+      {
+        int i = hash(p1, p2);
+        newnode->next_hash = e_table[i];
+        e_table[i] = newnode;
+      }
 
       return newnode;
     }
@@ -199,17 +403,34 @@ namespace Hermes
     Node* HashTable::peek_vertex_node(int p1, int p2) const
     {
       if(p1 > p2) std::swap(p1, p2);
+      if(flat_tables)
+      {
+        int id = flat_lookup(v_flat, p1, p2);
+        return (id < 0) ? NULL : &nodes[id];
+      }
       return search_list(v_table[hash(p1, p2)], p1, p2);
     }
 
     Node* HashTable::peek_edge_node(int p1, int p2) const
     {
       if(p1 > p2) std::swap(p1, p2);
+      if(flat_tables)
+      {
+        int id = flat_lookup(e_flat, p1, p2);
+        return (id < 0) ? NULL : &nodes[id];
+      }
       return search_list(e_table[hash(p1, p2)], p1, p2);
     }
 
     void HashTable::remove_vertex_node(int id)
     {
+      if(flat_tables)
+      {
+        flat_remove(v_flat, nodes[id].p1, nodes[id].p2, id);
+        nodes.remove(id);
+        return;
+      }
+
       // remove the node from the hash table
       int i = hash(nodes[id].p1, nodes[id].p2);
       Node** ptr = v_table + i;
@@ -231,6 +452,13 @@ namespace Hermes
 
     void HashTable::remove_edge_node(int id)
     {
+      if(flat_tables)
+      {
+        flat_remove(e_flat, nodes[id].p1, nodes[id].p2, id);
+        nodes.remove(id);
+        return;
+      }
+
       // remove the node from the hash table
       int i = hash(nodes[id].p1, nodes[id].p2);
       Node** ptr = e_table + i;
@@ -248,10 +248,20 @@ namespace Hermes
 
     unsigned g_mesh_seq = 0;
 
+    unsigned bump_mesh_seq(const Mesh* mesh)
+    {
+      // every bump of a mesh sequence number is also published centrally
+      Hermes::HermesChangeBus.publish(Hermes::HERMES_CHANGE_MESH, mesh);
+      return g_mesh_seq++;
+    }
+
     Mesh::Mesh() : HashTable()
     {
       nbase = nactive = ntopvert = ninitial = 0;
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
+      ref_source_seq = (unsigned) -1;
+      neighborhood_caching = false;
+      bulk_refinement = false;
     }
 
     Mesh::~Mesh() 
@@ -281,9 +291,27 @@ namespace Hermes
       Mesh* ref_mesh = new Mesh;
       ref_mesh->copy(this->coarse_mesh);
       ref_mesh->refine_all_elements(refinement, false);
+      ref_mesh->ref_source_seq = this->coarse_mesh->get_seq();
       return ref_mesh;
     }
 
+    Mesh* Mesh::ReferenceMeshCreator::create_ref_mesh(Mesh* previous_ref_mesh)
+    {
+      if(previous_ref_mesh == NULL)
+        return create_ref_mesh();
+
+      // The coarse mesh has not been touched since the previous reference
+      // mesh was derived from it - the copy and refinement would reproduce it.
+      if(previous_ref_mesh->ref_source_seq == this->coarse_mesh->get_seq())
+        return previous_ref_mesh;
+
+      // Rebuild in place, copy() frees the previous content.
+      previous_ref_mesh->copy(this->coarse_mesh);
+      previous_ref_mesh->refine_all_elements(refinement, false);
+      previous_ref_mesh->ref_source_seq = this->coarse_mesh->get_seq();
+      return previous_ref_mesh;
+    }
+
     void Mesh::initial_single_check()
     {
       RefMap r;
@@ -382,7 +410,7 @@ namespace Hermes
       }
 
       nbase = nactive = ninitial = nt + nq;
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     int Mesh::get_num_elements() const
@@ -394,6 +422,17 @@ namespace Hermes
         return elements.get_num_items();
     }
 
+    size_t Mesh::get_memory_bytes() const
+    {
+      size_t bytes = sizeof(Mesh);
+      bytes += elements.get_memory_bytes();
+      bytes += get_node_table_bytes();
+      for (int i = 0; i < elements.get_size(); i++)
+        if(elements[i].used && elements[i].cm != NULL)
+          bytes += sizeof(CurvMap);
+      return bytes;
+    }
+
     /// Returns the number of coarse mesh elements.
     int Mesh::get_num_base_elements() const
     {
@@ -488,11 +527,425 @@ namespace Hermes
       return &(elements[id]);
     }
 
+    Mesh::ActiveElementsCache::ActiveElementsCache()
+    {
+      count = 0;
+      id = NULL;
+      marker = NULL;
+      nvert = NULL;
+      vertex_x = NULL;
+      vertex_y = NULL;
+      seq = (unsigned) -1;
+    }
+
+    Mesh::ActiveElementsCache::~ActiveElementsCache()
+    {
+      free();
+    }
+
+    void Mesh::ActiveElementsCache::free()
+    {
+      count = 0;
+      if(id != NULL)
+      {
+        delete [] id;
+        id = NULL;
+      }
+      if(marker != NULL)
+      {
+        delete [] marker;
+        marker = NULL;
+      }
+      if(nvert != NULL)
+      {
+        delete [] nvert;
+        nvert = NULL;
+      }
+      if(vertex_x != NULL)
+      {
+        delete [] vertex_x;
+        vertex_x = NULL;
+      }
+      if(vertex_y != NULL)
+      {
+        delete [] vertex_y;
+        vertex_y = NULL;
+      }
+      seq = (unsigned) -1;
+    }
+
+    const Mesh::ActiveElementsCache* Mesh::get_active_elements_cache()
+    {
+      if(active_elements_cache.seq == this->seq && active_elements_cache.id != NULL)
+        return &active_elements_cache;
+
+      active_elements_cache.free();
+
+      int count = this->get_num_active_elements();
+      active_elements_cache.count = count;
+      active_elements_cache.id = new int[count];
+      active_elements_cache.marker = new int[count];
+      active_elements_cache.nvert = new char[count];
+      active_elements_cache.vertex_x = new double[4 * count];
+      active_elements_cache.vertex_y = new double[4 * count];
+
+      int i = 0;
+      Element* e;
+      for_all_active_elements(e, this)
+      {
+        active_elements_cache.id[i] = e->id;
+        active_elements_cache.marker[i] = e->marker;
+        active_elements_cache.nvert[i] = e->get_nvert();
+        for (unsigned int j = 0; j < e->get_nvert(); j++)
+        {
+          active_elements_cache.vertex_x[4 * i + j] = e->vn[j]->x;
+          active_elements_cache.vertex_y[4 * i + j] = e->vn[j]->y;
+        }
+        i++;
+      }
+      active_elements_cache.seq = this->seq;
+      return &active_elements_cache;
+    }
+
+    Mesh::ElementSearchGrid::ElementSearchGrid()
+    {
+      min_x = min_y = 0.0;
+      cell_size_x = cell_size_y = 0.0;
+      nx = ny = 0;
+      cell_start = NULL;
+      cell_elements = NULL;
+      seq = (unsigned) -1;
+    }
+
+    Mesh::ElementSearchGrid::~ElementSearchGrid()
+    {
+      free();
+    }
+
+    void Mesh::ElementSearchGrid::free()
+    {
+      nx = ny = 0;
+      if(cell_start != NULL)
+      {
+        delete [] cell_start;
+        cell_start = NULL;
+      }
+      if(cell_elements != NULL)
+      {
+        delete [] cell_elements;
+        cell_elements = NULL;
+      }
+      seq = (unsigned) -1;
+    }
+
+    const Mesh::ElementSearchGrid* Mesh::get_element_search_grid()
+    {
+      if(element_search_grid.seq == this->seq && element_search_grid.cell_start != NULL)
+        return &element_search_grid;
+
+      element_search_grid.free();
+
+      int count = this->get_num_active_elements();
+      if(count == 0)
+        return &element_search_grid;
+
+      // bounding box of the mesh and bounding boxes of the active elements;
+      // curved elements are inflated by half of their diameter, since the real
+      // boundary may bulge beyond the corner vertices
+      double* el_min_x = new double[count];
+      double* el_max_x = new double[count];
+      double* el_min_y = new double[count];
+      double* el_max_y = new double[count];
+      int* el_id = new int[count];
+
+      double min_x = 1e100, max_x = -1e100, min_y = 1e100, max_y = -1e100;
+      int i = 0;
+      Element* e;
+      for_all_active_elements(e, this)
+      {
+        double exmin = 1e100, exmax = -1e100, eymin = 1e100, eymax = -1e100;
+        for (unsigned int j = 0; j < e->get_nvert(); j++)
+        {
+          exmin = std::min(exmin, e->vn[j]->x);
+          exmax = std::max(exmax, e->vn[j]->x);
+          eymin = std::min(eymin, e->vn[j]->y);
+          eymax = std::max(eymax, e->vn[j]->y);
+        }
+        if(e->is_curved())
+        {
+          double margin = 0.5 * e->get_diameter();
+          exmin -= margin; exmax += margin;
+          eymin -= margin; eymax += margin;
+        }
+        el_min_x[i] = exmin; el_max_x[i] = exmax;
+        el_min_y[i] = eymin; el_max_y[i] = eymax;
+        el_id[i] = e->id;
+
+        min_x = std::min(min_x, exmin);
+        max_x = std::max(max_x, exmax);
+        min_y = std::min(min_y, eymin);
+        max_y = std::max(max_y, eymax);
+        i++;
+      }
+
+      // roughly one cell per element
+      int n = (int) sqrt((double) count);
+      if(n < 1) n = 1;
+      element_search_grid.nx = element_search_grid.ny = n;
+      element_search_grid.min_x = min_x;
+      element_search_grid.min_y = min_y;
+      element_search_grid.cell_size_x = (max_x > min_x) ? (max_x - min_x) / n : 1.0;
+      element_search_grid.cell_size_y = (max_y > min_y) ? (max_y - min_y) / n : 1.0;
+
+      // count the cells covered by each element's bounding box, then scatter the ids
+      int cells = n * n;
+      element_search_grid.cell_start = new int[cells + 1];
+      memset(element_search_grid.cell_start, 0, (cells + 1) * sizeof(int));
+
+      for (i = 0; i < count; i++)
+      {
+        int cx0 = std::min(std::max((int) ((el_min_x[i] - min_x) / element_search_grid.cell_size_x), 0), n - 1);
+        int cx1 = std::min(std::max((int) ((el_max_x[i] - min_x) / element_search_grid.cell_size_x), 0), n - 1);
+        int cy0 = std::min(std::max((int) ((el_min_y[i] - min_y) / element_search_grid.cell_size_y), 0), n - 1);
+        int cy1 = std::min(std::max((int) ((el_max_y[i] - min_y) / element_search_grid.cell_size_y), 0), n - 1);
+        for (int cy = cy0; cy <= cy1; cy++)
+          for (int cx = cx0; cx <= cx1; cx++)
+            element_search_grid.cell_start[cy * n + cx + 1]++;
+      }
+      for (i = 0; i < cells; i++)
+        element_search_grid.cell_start[i + 1] += element_search_grid.cell_start[i];
+
+      element_search_grid.cell_elements = new int[element_search_grid.cell_start[cells]];
+      int* next = new int[cells];
+      memcpy(next, element_search_grid.cell_start, cells * sizeof(int));
+      for (i = 0; i < count; i++)
+      {
+        int cx0 = std::min(std::max((int) ((el_min_x[i] - min_x) / element_search_grid.cell_size_x), 0), n - 1);
+        int cx1 = std::min(std::max((int) ((el_max_x[i] - min_x) / element_search_grid.cell_size_x), 0), n - 1);
+        int cy0 = std::min(std::max((int) ((el_min_y[i] - min_y) / element_search_grid.cell_size_y), 0), n - 1);
+        int cy1 = std::min(std::max((int) ((el_max_y[i] - min_y) / element_search_grid.cell_size_y), 0), n - 1);
+        for (int cy = cy0; cy <= cy1; cy++)
+          for (int cx = cx0; cx <= cx1; cx++)
+            element_search_grid.cell_elements[next[cy * n + cx]++] = el_id[i];
+      }
+      delete [] next;
+
+      delete [] el_min_x;
+      delete [] el_max_x;
+      delete [] el_min_y;
+      delete [] el_max_y;
+      delete [] el_id;
+
+      element_search_grid.seq = this->seq;
+      return &element_search_grid;
+    }
+
+    Mesh::ElementAdjacency::ElementAdjacency()
+    {
+      size = 0;
+      neighbor_start = NULL;
+      neighbor_ids = NULL;
+      seq = (unsigned) -1;
+    }
+
+    Mesh::ElementAdjacency::~ElementAdjacency()
+    {
+      free();
+    }
+
+    void Mesh::ElementAdjacency::free()
+    {
+      size = 0;
+      if(neighbor_start != NULL)
+      {
+        delete [] neighbor_start;
+        neighbor_start = NULL;
+      }
+      if(neighbor_ids != NULL)
+      {
+        delete [] neighbor_ids;
+        neighbor_ids = NULL;
+      }
+      seq = (unsigned) -1;
+    }
+
+    const Mesh::ElementAdjacency* Mesh::get_element_adjacency()
+    {
+      if(element_adjacency.seq == this->seq && element_adjacency.neighbor_start != NULL)
+        return &element_adjacency;
+
+      // The structure may be requested lazily from inside a parallel loop;
+      // only one thread builds it, the others re-check and read the result.
+#pragma omp critical (Mesh_element_adjacency)
+      if(element_adjacency.seq != this->seq || element_adjacency.neighbor_start == NULL)
+      {
+        element_adjacency.free();
+
+        int size = this->get_max_element_id();
+        element_adjacency.size = size;
+        element_adjacency.neighbor_start = new int[size + 1];
+        memset(element_adjacency.neighbor_start, 0, (size + 1) * sizeof(int));
+
+        // count the same-level active neighbors of every active element,
+        // then scatter their ids
+        Element* e;
+        for_all_active_elements(e, this)
+        {
+          for (unsigned int ie = 0; ie < e->get_nvert(); ie++)
+          {
+            Element** elem = e->en[ie]->elem;
+            Element* neighbor = (elem[0] == e) ? elem[1] : ((elem[1] == e) ? elem[0] : NULL);
+            if(neighbor != NULL && neighbor->active)
+              element_adjacency.neighbor_start[e->id + 1]++;
+          }
+        }
+        for (int i = 0; i < size; i++)
+          element_adjacency.neighbor_start[i + 1] += element_adjacency.neighbor_start[i];
+
+        element_adjacency.neighbor_ids = new int[element_adjacency.neighbor_start[size]];
+        int* next = new int[size];
+        memcpy(next, element_adjacency.neighbor_start, size * sizeof(int));
+        for_all_active_elements(e, this)
+        {
+          for (unsigned int ie = 0; ie < e->get_nvert(); ie++)
+          {
+            Element** elem = e->en[ie]->elem;
+            Element* neighbor = (elem[0] == e) ? elem[1] : ((elem[1] == e) ? elem[0] : NULL);
+            if(neighbor != NULL && neighbor->active)
+              element_adjacency.neighbor_ids[next[e->id]++] = neighbor->id;
+          }
+        }
+        delete [] next;
+
+        element_adjacency.seq = this->seq;
+      }
+      return &element_adjacency;
+    }
+
+    Mesh::EdgeNeighborhood::Record::Record()
+    {
+      neighbor_id = -1;
+      local_num_of_edge = -1;
+      orientation = false;
+      central_n_levels = 0;
+      central_transf = NULL;
+      neighbor_n_levels = 0;
+      neighbor_transf = NULL;
+    }
+
+    Mesh::EdgeNeighborhood::EdgeNeighborhood()
+    {
+      type = -1;
+      n_neighbors = 0;
+      records = NULL;
+    }
+
+    Mesh::EdgeNeighborhood::~EdgeNeighborhood()
+    {
+      if(records != NULL)
+      {
+        for(unsigned int i = 0; i < n_neighbors; i++)
+        {
+          if(records[i].central_transf != NULL)
+            delete [] records[i].central_transf;
+          if(records[i].neighbor_transf != NULL)
+            delete [] records[i].neighbor_transf;
+        }
+        delete [] records;
+      }
+    }
+
+    Mesh::NeighborhoodCache::NeighborhoodCache()
+    {
+      entries = NULL;
+      size = 0;
+      seq = (unsigned) -1;
+    }
+
+    Mesh::NeighborhoodCache::~NeighborhoodCache()
+    {
+      free();
+    }
+
+    void Mesh::NeighborhoodCache::free()
+    {
+      if(entries != NULL)
+      {
+        for(int i = 0; i < size; i++)
+          if(entries[i] != NULL)
+            delete entries[i];
+        delete [] entries;
+        entries = NULL;
+      }
+      size = 0;
+      seq = (unsigned) -1;
+    }
+
+    void Mesh::set_neighborhood_caching(bool to_set)
+    {
+      neighborhood_caching = to_set;
+      if(!to_set)
+        neighborhood_cache.free();
+    }
+
+    bool Mesh::get_neighborhood_caching() const
+    {
+      return neighborhood_caching;
+    }
+
+    Mesh::EdgeNeighborhood* Mesh::get_cached_neighborhood(int element_id, int edge)
+    {
+      if(!neighborhood_caching)
+        return NULL;
+
+      if(neighborhood_cache.seq != this->seq || neighborhood_cache.entries == NULL)
+      {
+#pragma omp critical (neighborhood_cache)
+        {
+          if(neighborhood_cache.seq != this->seq || neighborhood_cache.entries == NULL)
+          {
+            neighborhood_cache.free();
+            neighborhood_cache.size = 4 * this->get_max_element_id();
+            neighborhood_cache.entries = new EdgeNeighborhood*[neighborhood_cache.size];
+            memset(neighborhood_cache.entries, 0, neighborhood_cache.size * sizeof(EdgeNeighborhood*));
+            neighborhood_cache.seq = this->seq;
+          }
+        }
+      }
+
+      int slot = 4 * element_id + edge;
+      if(slot < 0 || slot >= neighborhood_cache.size)
+        return NULL;
+      return neighborhood_cache.entries[slot];
+    }
+
+    void Mesh::cache_neighborhood(int element_id, int edge, EdgeNeighborhood* neighborhood)
+    {
+      int slot = 4 * element_id + edge;
+      bool stored = false;
+#pragma omp critical (neighborhood_cache)
+      {
+        if(neighborhood_caching && neighborhood_cache.seq == this->seq && neighborhood_cache.entries != NULL
+           && slot >= 0 && slot < neighborhood_cache.size && neighborhood_cache.entries[slot] == NULL)
+        {
+          neighborhood_cache.entries[slot] = neighborhood;
+          stored = true;
+        }
+      }
+      if(!stored)
+        delete neighborhood;
+    }
+
     unsigned Mesh::get_seq() const
     {
       return seq;
     }
 
+    bool Mesh::has_changed_since(unsigned seq) const
+    {
+      return this->seq != seq;
+    }
+
     void Mesh::set_seq(unsigned seq)
     {
       this->seq = seq;
@@ -958,7 +1411,8 @@ namespace Hermes
       }
       else refine_quad(e, refinement);
 
-      this->seq = g_mesh_seq++;
+      if(!bulk_refinement)
+        this->seq = bump_mesh_seq(this);
     }
 
     void Mesh::refine_element_id(int id, int refinement)
@@ -971,6 +1425,40 @@ namespace Hermes
       this->refine_element(e, refinement);
     }
 
+    void Mesh::refine_elements(const std::vector<ElementToRefine>& elems_to_refine)
+    {
+      // collect the h-refinements and sort them by the element id, so that the
+      // pass through the element array and the node tables is as local as possible
+      std::vector<std::pair<int, int> > refs;
+      refs.reserve(elems_to_refine.size());
+      for (unsigned int i = 0; i < elems_to_refine.size(); i++)
+        if(elems_to_refine[i].split != H2D_REFINEMENT_P)
+          refs.push_back(std::pair<int, int>(elems_to_refine[i].id, elems_to_refine[i].split));
+      std::sort(refs.begin(), refs.end());
+
+      // a split quad creates at most five vertex and twelve edge nodes
+      this->reserve_nodes(5 * (int)refs.size(), 12 * (int)refs.size());
+
+      elements.set_append_only(true);
+      bulk_refinement = true;
+
+      for (unsigned int i = 0; i < refs.size(); i++)
+      {
+        Element* e = this->get_element(refs[i].first);
+        if(!e->used)
+          throw Hermes::Exceptions::Exception("Invalid element id number.");
+        // refined already, e.g., through another component sharing this mesh
+        if(!e->active)
+          continue;
+        this->refine_element(e, refs[i].second);
+      }
+
+      bulk_refinement = false;
+      elements.set_append_only(false);
+
+      this->seq = bump_mesh_seq(this);
+    }
+
     void Mesh::refine_all_elements(int refinement, bool mark_as_initial)
     {
       Element* e;
@@ -1186,7 +1674,7 @@ namespace Hermes
           unrefine_element_id(e->sons[i]->id);
 
       unrefine_element_internal(e);
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     void Mesh::unrefine_all_elements(bool keep_initial_refinements)
@@ -1211,6 +1699,66 @@ namespace Hermes
         unrefine_element_id(list[i]);
     }
 
+    void Mesh::compact()
+    {
+      int old_size = elements.get_size();
+      if(old_size == elements.get_num_items())
+        // No unused slots, nothing to compact.
+        return;
+
+      // Copy the used elements in the id order into a fresh array. The copies still
+      // point into the old storage, which stays alive until the final swap, so the
+      // old ids remain readable while the links are remapped below.
+      Element** new_by_old_id = new Element*[old_size];
+      memset(new_by_old_id, 0, old_size * sizeof(Element*));
+
+      Array<Element> compacted;
+      int new_nbase = 0;
+      Element* e;
+      for_all_elements(e, this)
+      {
+        Element* enew = compacted.add();
+        int new_id = enew->id;
+        *enew = *e;
+        enew->id = new_id;
+        new_by_old_id[e->id] = enew;
+        if(e->id < nbase)
+          new_nbase++;
+      }
+
+      // Remap the refinement tree links and the curved map parents.
+      for (int id = 0; id < compacted.get_size(); id++)
+      {
+        Element* enew = &compacted.get(id);
+        if(enew->parent != NULL)
+          enew->parent = new_by_old_id[enew->parent->id];
+        if(!enew->active)
+          for (int son = 0; son < H2D_MAX_ELEMENT_SONS; son++)
+            if(enew->sons[son] != NULL)
+              enew->sons[son] = new_by_old_id[enew->sons[son]->id];
+        if(enew->cm != NULL && !enew->cm->toplevel && enew->cm->parent != NULL)
+          enew->cm->parent = new_by_old_id[enew->cm->parent->id];
+      }
+
+      // Remap the node-to-element back-links. The nodes themselves do not move,
+      // hence the hash table stays valid as it is.
+      Node* node;
+      for_all_edge_nodes(node, this)
+        for (int k = 0; k < 2; k++)
+          if(node->elem[k] != NULL)
+            node->elem[k] = new_by_old_id[node->elem[k]->id];
+
+      elements.swap(compacted);
+      delete [] new_by_old_id;
+
+      // The base elements were created first and are never removed, so they keep
+      // the leading ids; still, recount them in case a conversion dropped some.
+      nbase = new_nbase;
+
+      // The element ids changed - everything built on top of the mesh is stale.
+      this->seq = bump_mesh_seq(this);
+    }
+
     Nurbs* Mesh::reverse_nurbs(Nurbs* nurbs)
     {
       Nurbs* rev = new Nurbs;
@@ -1348,6 +1896,8 @@ namespace Hermes
       unsigned int i;
 
       free();
+      // A general copy; ReferenceMeshCreator stamps its meshes itself.
+      this->ref_source_seq = (unsigned) -1;
       // Serves as a Mesh::init() for purposes of pointer calculation.
 
       // copy nodes and elements
@@ -1467,7 +2017,7 @@ namespace Hermes
 
       nbase = nactive = ninitial = mesh->nbase;
       ntopvert = mesh->ntopvert;
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     void Mesh::free()
@@ -1482,6 +2032,9 @@ namespace Hermes
         }
       }
       elements.free();
+      active_elements_cache.free();
+      element_search_grid.free();
+      neighborhood_cache.free();
       HashTable::free();
       this->boundary_markers_conversion.conversion_table.clear();
       this->boundary_markers_conversion.conversion_table_inverse.clear();
@@ -1573,7 +2126,7 @@ namespace Hermes
 
       nbase = nactive = ninitial = mesh->nactive;
       ntopvert = mesh->ntopvert = get_num_nodes();
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     void Mesh::convert_quads_to_triangles()
@@ -1964,7 +2517,7 @@ namespace Hermes
       else
         refine_quad_to_quads(e);
 
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     void Mesh::refine_quad_to_triangles(Element* e)
@@ -2162,7 +2715,7 @@ namespace Hermes
       else
         refine_quad_to_triangles(e);
 
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     void Mesh::convert_element_to_base_id(int id)
@@ -2176,7 +2729,7 @@ namespace Hermes
       else
         convert_quads_to_base(e);// FIXME:
 
-      seq = g_mesh_seq++;
+      seq = bump_mesh_seq(this);
     }
 
     Mesh::MarkersConversion::MarkersConversion() : min_marker_unused(1)
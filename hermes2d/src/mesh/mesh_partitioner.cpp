@@ -0,0 +1,218 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "mesh_partitioner.h"
+#include <queue>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    MeshPartitioner::MeshPartitioner(const Mesh* mesh, int num_partitions)
+      : mesh(mesh), num_partitions(num_partitions), calculated(false),
+      partition(NULL), partition_sizes(NULL), visited_stamp(NULL), current_stamp(0)
+    {
+      if(mesh == NULL)
+        throw Hermes::Exceptions::NullException(0);
+      if(num_partitions < 1)
+        throw Hermes::Exceptions::ValueException("num_partitions", num_partitions, 1);
+    }
+
+    MeshPartitioner::~MeshPartitioner()
+    {
+      if(partition != NULL)
+        delete [] partition;
+      if(partition_sizes != NULL)
+        delete [] partition_sizes;
+      if(visited_stamp != NULL)
+        delete [] visited_stamp;
+    }
+
+    void MeshPartitioner::build_adjacency()
+    {
+      int max_element_id = mesh->get_max_element_id();
+      adjacency.clear();
+      adjacency.resize(max_element_id);
+
+      // elements sharing a vertex node are neighbors in the element graph
+      std::map<int, std::vector<int> > elements_at_vertex;
+      Element* e;
+      for_all_active_elements(e, mesh)
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          elements_at_vertex[e->vn[i]->id].push_back(e->id);
+
+      for (std::map<int, std::vector<int> >::iterator it = elements_at_vertex.begin(); it != elements_at_vertex.end(); it++)
+      {
+        std::vector<int>& elements = it->second;
+        for (unsigned int i = 0; i < elements.size(); i++)
+          for (unsigned int j = 0; j < elements.size(); j++)
+          {
+            if(i == j)
+              continue;
+            // the same pair meets once per shared vertex, store it only once
+            std::vector<int>& neighbors = adjacency[elements[i]];
+            if(std::find(neighbors.begin(), neighbors.end(), elements[j]) == neighbors.end())
+              neighbors.push_back(elements[j]);
+          }
+      }
+    }
+
+    void MeshPartitioner::order_breadth_first(const std::vector<int>& elements, std::vector<int>& ordered)
+    {
+      // mark the sub-graph the ordering may move in
+      current_stamp++;
+      for (unsigned int i = 0; i < elements.size(); i++)
+        visited_stamp[elements[i]] = current_stamp;
+
+      int in_set = current_stamp;
+      int visited = ++current_stamp;
+
+      ordered.clear();
+      ordered.reserve(elements.size());
+
+      unsigned int next_seed = 0;
+      while (ordered.size() < elements.size())
+      {
+        // seed of the next (possibly the only) connected component
+        while (visited_stamp[elements[next_seed]] != in_set)
+          next_seed++;
+        int seed = elements[next_seed];
+
+        // double breadth-first search: the last element reached from an
+        // arbitrary seed is pseudo-peripheral, starting the final ordering
+        // there makes the bisection cut roughly perpendicular to the longest
+        // extent of the component
+        for (int pass = 0; pass < 2; pass++)
+        {
+          unsigned int component_begin = ordered.size();
+          std::queue<int> queue;
+          queue.push(seed);
+          visited_stamp[seed] = visited;
+          while (!queue.empty())
+          {
+            int id = queue.front();
+            queue.pop();
+            ordered.push_back(id);
+            std::vector<int>& neighbors = adjacency[id];
+            for (unsigned int i = 0; i < neighbors.size(); i++)
+              if(visited_stamp[neighbors[i]] == in_set)
+              {
+                visited_stamp[neighbors[i]] = visited;
+                queue.push(neighbors[i]);
+              }
+          }
+
+          if(pass == 0)
+          {
+            // restart from the farthest element found
+            seed = ordered.back();
+            for (unsigned int i = component_begin; i < ordered.size(); i++)
+              visited_stamp[ordered[i]] = in_set;
+            ordered.resize(component_begin);
+            visited_stamp[seed] = in_set;
+          }
+        }
+      }
+    }
+
+    void MeshPartitioner::bisect(std::vector<int>& elements, int first_partition, int partition_count)
+    {
+      if(partition_count == 1)
+      {
+        for (unsigned int i = 0; i < elements.size(); i++)
+          partition[elements[i]] = first_partition;
+        partition_sizes[first_partition] = elements.size();
+        return;
+      }
+
+      std::vector<int> ordered;
+      order_breadth_first(elements, ordered);
+
+      // cut the ordering in the ratio of the partition counts of the halves
+      int left_count = partition_count / 2;
+      int right_count = partition_count - left_count;
+      unsigned int cut = (unsigned int) (((long long) ordered.size() * left_count) / partition_count);
+
+      std::vector<int> left(ordered.begin(), ordered.begin() + cut);
+      std::vector<int> right(ordered.begin() + cut, ordered.end());
+
+      bisect(left, first_partition, left_count);
+      bisect(right, first_partition + left_count, right_count);
+    }
+
+    void MeshPartitioner::calculate()
+    {
+      int max_element_id = mesh->get_max_element_id();
+
+      if(partition != NULL)
+        delete [] partition;
+      if(partition_sizes != NULL)
+        delete [] partition_sizes;
+      if(visited_stamp != NULL)
+        delete [] visited_stamp;
+
+      partition = new int[max_element_id];
+      memset(partition, 0xff, max_element_id * sizeof(int));
+      partition_sizes = new int[num_partitions];
+      memset(partition_sizes, 0, num_partitions * sizeof(int));
+      visited_stamp = new int[max_element_id];
+      memset(visited_stamp, 0, max_element_id * sizeof(int));
+      current_stamp = 0;
+
+      build_adjacency();
+
+      std::vector<int> all_elements;
+      Element* e;
+      for_all_active_elements(e, mesh)
+        all_elements.push_back(e->id);
+
+      if((int) all_elements.size() < num_partitions)
+        throw Hermes::Exceptions::Exception("Mesh with %d active elements cannot be split into %d partitions.", (int) all_elements.size(), num_partitions);
+
+      bisect(all_elements, 0, num_partitions);
+      calculated = true;
+    }
+
+    int MeshPartitioner::get_partition(int element_id) const
+    {
+      if(!calculated)
+        throw Hermes::Exceptions::Exception("MeshPartitioner::calculate() has not been called.");
+      if(element_id < 0 || element_id >= mesh->get_max_element_id() || partition[element_id] < 0)
+        throw Hermes::Exceptions::ValueException("element_id", element_id, 0, mesh->get_max_element_id());
+      return partition[element_id];
+    }
+
+    int MeshPartitioner::get_partition_size(int partition) const
+    {
+      if(!calculated)
+        throw Hermes::Exceptions::Exception("MeshPartitioner::calculate() has not been called.");
+      if(partition < 0 || partition >= num_partitions)
+        throw Hermes::Exceptions::ValueException("partition", partition, 0, num_partitions);
+      return partition_sizes[partition];
+    }
+
+    int MeshPartitioner::get_interface_links() const
+    {
+      if(!calculated)
+        throw Hermes::Exceptions::Exception("MeshPartitioner::calculate() has not been called.");
+      int links = 0;
+      for (unsigned int id = 0; id < adjacency.size(); id++)
+        for (unsigned int i = 0; i < adjacency[id].size(); i++)
+          if(partition[id] >= 0 && adjacency[id][i] > (int) id && partition[id] != partition[adjacency[id][i]])
+            links++;
+      return links;
+    }
+  }
+}
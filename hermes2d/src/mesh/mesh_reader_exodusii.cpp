@@ -18,7 +18,6 @@
 #include <string.h>
 #include "mesh_reader_exodusii.h"
 #include "mesh.h"
-#include <map>
 
 #ifdef WITH_EXODUSII
 #include <exodusII.h>
@@ -39,25 +38,16 @@ namespace Hermes
     {
     }
 
-    struct Vertex
+    // hash of a point used for eliminating duplicate vertices.
+    static inline unsigned int hash_point(double x, double y)
     {
-      double x, y;
-    };
-
-    // needed for comparison of vertices inside std::map
-    struct VCompare
-    {
-      bool operator()(Vertex a, Vertex b) const
-      {
-        if(a.x < b.x) return true;
-        else if(a.x > b.x) return false;
-        else
-        {
-          if(a.y < b.y) return true;
-          return false;
-        }
-      }
-    };
+      uint64_t bits_x, bits_y;
+      memcpy(&bits_x, &x, sizeof(double));
+      memcpy(&bits_y, &y, sizeof(double));
+      uint64_t h = bits_x ^ (bits_y * 0x9e3779b97f4a7c15ULL);
+      h ^= h >> 33;
+      return (unsigned int) h;
+    }
 
     bool MeshReaderExodusII::load(const char *file_name, Mesh *mesh)
     {
@@ -83,37 +73,39 @@ namespace Hermes
       double *y = new double[n_nodes];
       err = ex_get_coord(exoid, x, y, NULL);
 
-      // remove duplicate vertices and build renumbering map
-      std::map<Vertex, int, VCompare> vtx_list;        // map for eliminating duplicities
-      std::map<int, int> vmap;                // reindexing map
-      Hermes::vector<Vertex> vtx_arr;              // vertex array
-      int vid = 0;
+      // remove duplicate vertices and build the renumbering map; an open-addressing
+      // hash table sized up-front from the node count in the file header replaces
+      // the former std::map of vertices, and the mesh' vertex array is filled
+      // directly during the deduplication (the node count is an upper bound).
+      int table_size = 1;
+      while (table_size < 2 * n_nodes)
+        table_size <<= 1;
+      int *table = new int[table_size];
+      memset(table, 0xff, table_size * sizeof(int));    // all slots -1
+
+      double2 *vtx = new double2[n_nodes];
+      int *vmap = new int[n_nodes + 1];        // reindexing map, 1-based as in the file
+      int n_vtx = 0;
       for (int i = 0; i < n_nodes; i++)
       {
-        int k;
-        Vertex v = { x[i], y[i] };
-        if(vtx_list.count(v) == 0)
+        unsigned int pos = hash_point(x[i], y[i]) & (table_size - 1);
+        while (table[pos] != -1 && !(vtx[table[pos]][0] == x[i] && vtx[table[pos]][1] == y[i]))
+          pos = (pos + 1) & (table_size - 1);
+
+        if(table[pos] == -1)
         {
-          vtx_arr.push_back(v);
-          k = vid++;
-          vtx_list[v] = k;
+          vtx[n_vtx][0] = x[i];
+          vtx[n_vtx][1] = y[i];
+          table[pos] = n_vtx;
+          vmap[i + 1] = n_vtx++;
         }
         else
-          k = vtx_list[v];
-
-        vmap[i + 1] = k;
+          vmap[i + 1] = table[pos];
       }
+      delete [] table;
       delete [] x;
       delete [] y;
 
-      int n_vtx = vtx_arr.size();
-      double2 *vtx = new double2[n_vtx];
-      for (int i = 0; i < n_vtx; i++)
-      {
-        vtx[i][0] = vtx_arr[i].x;
-        vtx[i][1] = vtx_arr[i].y;
-      }
-
       int n_tri = 0;    // number of triangles
       int n_quad = 0;    // number of quads
 
@@ -171,37 +163,46 @@ namespace Hermes
         // already used, and if not, inserts it in the appropriate structure.
         mesh->element_markers_conversion.insert_marker(mesh->element_markers_conversion.min_marker_unused, el_marker);
 
-        int ic = 0;
-        for (int j = 0; j < n_elems_in_blk; j++)
+        if(n_elem_nodes != 3 && n_elem_nodes != 4)
         {
-          el_nv[iel] = n_elem_nodes;
-          if(n_elem_nodes == 3)
-          {
-            tri[it][0] = vmap[connect[ic++]];
-            tri[it][1] = vmap[connect[ic++]];
-            tri[it][2] = vmap[connect[ic++]];
-            tri_markers[it] = el_marker;
-            els[iel] = tri[it];
-            it++;
-          }
-          else if(n_elem_nodes == 4)
+          delete [] vtx;
+          throw Hermes::Exceptions::Exception("Unknown type of element");
+          return false;
+        }
+
+        // renumber the connectivity of the whole block in parallel; the
+        // library call above stays serial, the ExodusII C API is not
+        // thread-safe.
+        if(n_elem_nodes == 3)
+        {
+#pragma omp parallel for
+          for (int j = 0; j < n_elems_in_blk; j++)
           {
-            quad[iq][0] = vmap[connect[ic++]];
-            quad[iq][1] = vmap[connect[ic++]];
-            quad[iq][2] = vmap[connect[ic++]];
-            quad[iq][3] = vmap[connect[ic++]];
-            quad_markers[iq] = el_marker;
-            els[iel] = quad[iq];
-            iq++;
+            el_nv[iel + j] = 3;
+            tri[it + j][0] = vmap[connect[3 * j]];
+            tri[it + j][1] = vmap[connect[3 * j + 1]];
+            tri[it + j][2] = vmap[connect[3 * j + 2]];
+            tri_markers[it + j] = el_marker;
+            els[iel + j] = tri[it + j];
           }
-          else
+          it += n_elems_in_blk;
+        }
+        else
+        {
+#pragma omp parallel for
+          for (int j = 0; j < n_elems_in_blk; j++)
           {
-            delete [] vtx;
-            throw Hermes::Exceptions::Exception("Unknown type of element");
-            return false;
+            el_nv[iel + j] = 4;
+            quad[iq + j][0] = vmap[connect[4 * j]];
+            quad[iq + j][1] = vmap[connect[4 * j + 1]];
+            quad[iq + j][2] = vmap[connect[4 * j + 2]];
+            quad[iq + j][3] = vmap[connect[4 * j + 3]];
+            quad_markers[iq + j] = el_marker;
+            els[iel + j] = quad[iq + j];
           }
-          iel++;
+          iq += n_elems_in_blk;
         }
+        iel += n_elems_in_blk;
         delete [] connect;
       }
       delete [] eid_blocks;
@@ -271,6 +272,7 @@ namespace Hermes
       delete [] quad_markers;
       delete [] bnd_markers;
       delete [] vtx;
+      delete [] vmap;
       delete [] el_nv;
       delete [] els;
 
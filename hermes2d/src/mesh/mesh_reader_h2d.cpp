@@ -23,7 +23,6 @@ namespace Hermes
 {
   namespace Hermes2D
   {
-    extern unsigned g_mesh_seq;
 
     MeshReaderH2D::MeshReaderH2D()
     {
@@ -382,7 +381,7 @@ namespace Hermes
       }
       mesh->ninitial = mesh->elements.get_num_items();
 
-      mesh->seq = g_mesh_seq++;
+      mesh->seq = bump_mesh_seq(mesh);
       mesh->initial_single_check();
       return true;
     }
@@ -0,0 +1,421 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#include <string.h>
+#include "mesh.h"
+#include <map>
+#include "mesh_reader_h2d_bin.h"
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+
+    static const char H2D_BIN_MAGIC[8] = { 'H', '2', 'D', 'M', 'E', 'S', 'H', 'B' };
+    static const int H2D_BIN_VERSION = 1;
+
+    MeshReaderH2DBin::MeshReaderH2DBin()
+    {
+    }
+
+    MeshReaderH2DBin::~MeshReaderH2DBin()
+    {
+    }
+
+    /// Reads one marker string table written by MeshReaderH2DBin::save().
+    static void read_marker_table(FILE* f, int count, std::vector<std::string>& markers, const char* filename)
+    {
+      for (int i = 0; i < count; i++)
+      {
+        int len;
+        if(fread(&len, sizeof(int), 1, f) != 1 || len < 0)
+          throw Hermes::Exceptions::MeshLoadFailureException("File %s: corrupted marker table.", filename);
+        std::string marker(len, ' ');
+        if(len > 0 && fread(&marker[0], 1, len, f) != (size_t) len)
+          throw Hermes::Exceptions::MeshLoadFailureException("File %s: corrupted marker table.", filename);
+        markers.push_back(marker);
+      }
+    }
+
+    static void write_marker_table(FILE* f, const std::vector<std::string>& markers)
+    {
+      for (unsigned int i = 0; i < markers.size(); i++)
+      {
+        int len = markers[i].length();
+        fwrite(&len, sizeof(int), 1, f);
+        if(len > 0)
+          fwrite(markers[i].c_str(), 1, len, f);
+      }
+    }
+
+    bool MeshReaderH2DBin::load(const char *filename, Mesh *mesh)
+    {
+      FILE* f = fopen(filename, "rb");
+      if(f == NULL)
+        throw Hermes::Exceptions::MeshLoadFailureException("Mesh file not found.");
+      try
+      {
+        load_stream(f, mesh, filename);
+      }
+      catch(...)
+      {
+        fclose(f);
+        throw;
+      }
+      fclose(f);
+      return true;
+    }
+
+    void MeshReaderH2DBin::load_stream(FILE* f, Mesh *mesh, const char* origin)
+    {
+      mesh->free();
+
+      BinHeader header;
+      if(fread(&header, sizeof(BinHeader), 1, f) != 1
+        || memcmp(header.magic, H2D_BIN_MAGIC, sizeof(H2D_BIN_MAGIC)) != 0)
+        throw Hermes::Exceptions::MeshLoadFailureException("File %s: not a Hermes2D binary mesh file.", origin);
+      if(header.version != H2D_BIN_VERSION)
+        throw Hermes::Exceptions::MeshLoadFailureException("File %s: unsupported binary mesh format version %d.", origin, header.version);
+      if(header.n_vert < 2 || header.n_el < 1)
+        throw Hermes::Exceptions::MeshLoadFailureException("File %s: invalid number of vertices or elements.", origin);
+
+      double* vertices = new double[2 * header.n_vert];
+      BinElement* elements = new BinElement[header.n_el];
+      BinBoundary* boundaries = header.n_bdy > 0 ? new BinBoundary[header.n_bdy] : NULL;
+      BinRefinement* refinements = header.n_ref > 0 ? new BinRefinement[header.n_ref] : NULL;
+
+      bool ok = fread(vertices, sizeof(double), 2 * header.n_vert, f) == (size_t) (2 * header.n_vert);
+      ok = ok && fread(elements, sizeof(BinElement), header.n_el, f) == (size_t) header.n_el;
+      if(header.n_bdy > 0)
+        ok = ok && fread(boundaries, sizeof(BinBoundary), header.n_bdy, f) == (size_t) header.n_bdy;
+      if(header.n_ref > 0)
+        ok = ok && fread(refinements, sizeof(BinRefinement), header.n_ref, f) == (size_t) header.n_ref;
+
+      std::vector<std::string> element_markers, boundary_markers;
+      try
+      {
+        if(!ok)
+          throw Hermes::Exceptions::MeshLoadFailureException("File %s: truncated binary mesh file.", origin);
+        read_marker_table(f, header.n_el_markers, element_markers, origin);
+        read_marker_table(f, header.n_bdy_markers, boundary_markers, origin);
+      }
+      catch(Hermes::Exceptions::MeshLoadFailureException& e)
+      {
+        delete [] vertices;
+        delete [] elements;
+        delete [] boundaries;
+        delete [] refinements;
+        throw;
+      }
+
+      // Create top-level vertex nodes, the same way the text reader does.
+      int size = HashTable::H2D_DEFAULT_HASH_SIZE;
+      while (size < 8 * header.n_vert) size *= 2;
+      mesh->init(size);
+
+      for (int i = 0; i < header.n_vert; i++)
+      {
+        Node* node = mesh->nodes.add();
+        assert(node->id == i);
+        node->ref = TOP_LEVEL_REF;
+        node->type = HERMES_TYPE_VERTEX;
+        node->bnd = 0;
+        node->p1 = node->p2 = -1;
+        node->next_hash = NULL;
+        node->x = vertices[2 * i];
+        node->y = vertices[2 * i + 1];
+      }
+      mesh->ntopvert = header.n_vert;
+
+      // Elements.
+      mesh->nactive = 0;
+      for (int i = 0; i < header.n_el; i++)
+      {
+        if(elements[i].vert[0] == -1)
+        {
+          mesh->elements.skip_slot();
+          continue;
+        }
+
+        int nv = (elements[i].vert[3] == -1) ? 3 : 4;
+        for (int j = 0; j < nv; j++)
+          if(elements[i].vert[j] < 0 || elements[i].vert[j] >= mesh->ntopvert)
+            throw Hermes::Exceptions::MeshLoadFailureException("File %s: error creating element #%d: vertex #%d does not exist.", origin, i, elements[i].vert[j]);
+        if(elements[i].marker < 0 || elements[i].marker >= (int) element_markers.size())
+          throw Hermes::Exceptions::MeshLoadFailureException("File %s: element #%d: invalid marker index.", origin, i);
+
+        mesh->element_markers_conversion.insert_marker(mesh->element_markers_conversion.min_marker_unused, element_markers[elements[i].marker]);
+        int marker = mesh->element_markers_conversion.get_internal_marker(element_markers[elements[i].marker]).marker;
+
+        Node *v0 = &mesh->nodes[elements[i].vert[0]], *v1 = &mesh->nodes[elements[i].vert[1]], *v2 = &mesh->nodes[elements[i].vert[2]];
+        if(nv == 3)
+        {
+          Mesh::check_triangle(i, v0, v1, v2);
+          mesh->create_triangle(marker, v0, v1, v2, NULL);
+        }
+        else
+        {
+          Node *v3 = &mesh->nodes[elements[i].vert[3]];
+          Mesh::check_quad(i, v0, v1, v2, v3);
+          mesh->create_quad(marker, v0, v1, v2, v3, NULL);
+        }
+        mesh->nactive++;
+      }
+      mesh->nbase = header.n_el;
+
+      // Boundary edges.
+      for (int i = 0; i < header.n_bdy; i++)
+      {
+        int v1 = boundaries[i].vert[0], v2 = boundaries[i].vert[1];
+
+        Node* en = mesh->peek_edge_node(v1, v2);
+        if(en == NULL)
+          throw Hermes::Exceptions::MeshLoadFailureException("File %s: boundary data #%d: edge %d-%d does not exist", origin, i, v1, v2);
+        if(boundaries[i].marker < 0 || boundaries[i].marker >= (int) boundary_markers.size())
+          throw Hermes::Exceptions::MeshLoadFailureException("File %s: boundary data #%d: invalid marker index.", origin, i);
+
+        mesh->boundary_markers_conversion.insert_marker(mesh->boundary_markers_conversion.min_marker_unused, boundary_markers[boundaries[i].marker]);
+        int marker = mesh->boundary_markers_conversion.get_internal_marker(boundary_markers[boundaries[i].marker]).marker;
+
+        en->marker = marker;
+
+        // This is extremely important, as in DG, it is assumed that negative boundary markers are reserved
+        // for the inner edges.
+        if(marker > 0)
+        {
+          mesh->nodes[v1].bnd = 1;
+          mesh->nodes[v2].bnd = 1;
+          en->bnd = 1;
+        }
+      }
+
+      // Replay the initial refinements.
+      for (int i = 0; i < header.n_ref; i++)
+        mesh->refine_element_id(refinements[i].id, refinements[i].type);
+      mesh->ninitial = mesh->elements.get_num_items();
+
+      delete [] vertices;
+      delete [] elements;
+      delete [] boundaries;
+      delete [] refinements;
+
+      mesh->seq = bump_mesh_seq(mesh);
+      mesh->initial_single_check();
+    }
+
+    void MeshReaderH2DBin::save_refinements(Mesh *mesh, Element* e, int id, std::vector<BinRefinement>& refinements)
+    {
+      if(e->active) return;
+      BinRefinement ref;
+      ref.id = id;
+      if(e->bsplit())
+      {
+        ref.type = 0;
+        refinements.push_back(ref);
+        int sid = mesh->seq; mesh->seq += 4;
+        for (int i = 0; i < 4; i++)
+          save_refinements(mesh, e->sons[i], sid + i, refinements);
+      }
+      else if(e->hsplit())
+      {
+        ref.type = 1;
+        refinements.push_back(ref);
+        int sid = mesh->seq; mesh->seq += 2;
+        save_refinements(mesh, e->sons[0], sid, refinements);
+        save_refinements(mesh, e->sons[1], sid + 1, refinements);
+      }
+      else
+      {
+        ref.type = 2;
+        refinements.push_back(ref);
+        int sid = mesh->seq; mesh->seq += 2;
+        save_refinements(mesh, e->sons[2], sid, refinements);
+        save_refinements(mesh, e->sons[3], sid + 1, refinements);
+      }
+    }
+
+    bool MeshReaderH2DBin::save(const char* filename, Mesh *mesh)
+    {
+      FILE* f = fopen(filename, "wb");
+      if(f == NULL)
+        throw Hermes::Exceptions::MeshLoadFailureException("Could not create mesh file.");
+      try
+      {
+        save_stream(f, mesh);
+      }
+      catch(...)
+      {
+        fclose(f);
+        throw;
+      }
+      fclose(f);
+      return true;
+    }
+
+    void MeshReaderH2DBin::save_stream(FILE* f, Mesh *mesh)
+    {
+      Element* e;
+
+      // Curvilinear boundaries have no binary representation.
+      for_all_base_elements(e, mesh)
+        if(e->is_curved())
+          throw Hermes::Exceptions::MeshLoadFailureException("The binary mesh format does not support curved boundaries, use MeshReaderH2D or MeshReaderH2DXML.");
+
+      // Collect the marker string tables, elements and boundary edges reference them by index.
+      std::vector<std::string> element_markers, boundary_markers;
+      std::map<std::string, int> element_marker_indices, boundary_marker_indices;
+
+      BinElement* elements = new BinElement[mesh->get_num_base_elements()];
+      for (int i = 0; i < mesh->get_num_base_elements(); i++)
+      {
+        e = mesh->get_element_fast(i);
+        if(!e->used)
+        {
+          elements[i].vert[0] = elements[i].vert[1] = elements[i].vert[2] = elements[i].vert[3] = -1;
+          elements[i].marker = 0;
+          continue;
+        }
+        for (unsigned int j = 0; j < e->get_nvert(); j++)
+          elements[i].vert[j] = e->vn[j]->id;
+        if(e->is_triangle())
+          elements[i].vert[3] = -1;
+
+        std::string marker = mesh->get_element_markers_conversion().get_user_marker(e->marker).marker;
+        if(element_marker_indices.find(marker) == element_marker_indices.end())
+        {
+          element_marker_indices[marker] = element_markers.size();
+          element_markers.push_back(marker);
+        }
+        elements[i].marker = element_marker_indices[marker];
+      }
+
+      std::vector<BinBoundary> boundaries;
+      int mrk;
+      for_all_base_elements(e, mesh)
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          if((mrk = mesh->get_base_edge_node(e, i)->marker))
+          {
+            BinBoundary bdy;
+            bdy.vert[0] = e->vn[i]->id;
+            bdy.vert[1] = e->vn[e->next_vert(i)]->id;
+
+            std::string marker = mesh->boundary_markers_conversion.get_user_marker(mrk).marker;
+            if(boundary_marker_indices.find(marker) == boundary_marker_indices.end())
+            {
+              boundary_marker_indices[marker] = boundary_markers.size();
+              boundary_markers.push_back(marker);
+            }
+            bdy.marker = boundary_marker_indices[marker];
+            boundaries.push_back(bdy);
+          }
+
+      // Collect the refinements, numbering the sons the same way load() will.
+      std::vector<BinRefinement> refinements;
+      unsigned temp = mesh->seq;
+      mesh->seq = mesh->nbase;
+      for_all_base_elements(e, mesh)
+        save_refinements(mesh, e, e->id, refinements);
+      mesh->seq = temp;
+
+      BinHeader header;
+      memcpy(header.magic, H2D_BIN_MAGIC, sizeof(H2D_BIN_MAGIC));
+      header.version = H2D_BIN_VERSION;
+      header.n_vert = mesh->ntopvert;
+      header.n_el = mesh->get_num_base_elements();
+      header.n_bdy = boundaries.size();
+      header.n_ref = refinements.size();
+      header.n_el_markers = element_markers.size();
+      header.n_bdy_markers = boundary_markers.size();
+
+      fwrite(&header, sizeof(BinHeader), 1, f);
+      for (int i = 0; i < mesh->ntopvert; i++)
+      {
+        double xy[2] = { mesh->nodes[i].x, mesh->nodes[i].y };
+        fwrite(xy, sizeof(double), 2, f);
+      }
+      fwrite(elements, sizeof(BinElement), header.n_el, f);
+      if(header.n_bdy > 0)
+        fwrite(&boundaries[0], sizeof(BinBoundary), header.n_bdy, f);
+      if(header.n_ref > 0)
+        fwrite(&refinements[0], sizeof(BinRefinement), header.n_ref, f);
+      write_marker_table(f, element_markers);
+      write_marker_table(f, boundary_markers);
+
+      delete [] elements;
+    }
+
+#ifndef WIN32
+    bool MeshReaderH2DBin::publish_shm(const char *name, Mesh *mesh)
+    {
+      int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+      if(fd < 0)
+        throw Hermes::Exceptions::MeshLoadFailureException("Could not create shared memory segment %s.", name);
+      FILE* f = fdopen(fd, "wb");
+      if(f == NULL)
+      {
+        close(fd);
+        throw Hermes::Exceptions::MeshLoadFailureException("Could not create shared memory segment %s.", name);
+      }
+      try
+      {
+        save_stream(f, mesh);
+      }
+      catch(...)
+      {
+        fclose(f);
+        shm_unlink(name);
+        throw;
+      }
+      fclose(f);
+      return true;
+    }
+
+    bool MeshReaderH2DBin::attach_shm(const char *name, Mesh *mesh)
+    {
+      int fd = shm_open(name, O_RDONLY, 0);
+      if(fd < 0)
+        throw Hermes::Exceptions::MeshLoadFailureException("Shared memory segment %s not found.", name);
+      FILE* f = fdopen(fd, "rb");
+      if(f == NULL)
+      {
+        close(fd);
+        throw Hermes::Exceptions::MeshLoadFailureException("Could not attach shared memory segment %s.", name);
+      }
+      try
+      {
+        load_stream(f, mesh, name);
+      }
+      catch(...)
+      {
+        fclose(f);
+        throw;
+      }
+      fclose(f);
+      return true;
+    }
+
+    void MeshReaderH2DBin::unlink_shm(const char *name)
+    {
+      shm_unlink(name);
+    }
+#endif
+  }
+}
@@ -32,6 +32,33 @@ namespace Hermes
     {
     }
 
+    /// Evaluates one coordinate entry of a vertex: either a reference to one of the
+    /// file-level variables or a numeric literal. Returns false when the entry is
+    /// neither (a strtod result of 0.0 must be backed by an actual zero in the text).
+    static bool get_coordinate_value(const std::string& str, const std::map<std::string, double>& variables, double& value)
+    {
+      std::map<std::string, double>::const_iterator found = variables.find(str);
+      if(found != variables.end())
+      {
+        value = found->second;
+        return true;
+      }
+
+      value = std::strtod(str.c_str(), NULL);
+      if(value != 0.0)
+        return true;
+
+      // This is a hard part, to find out if it is really zero.
+      int dot_position = strchr(str.c_str(), '.') == NULL ? -1 : strchr(str.c_str(), '.') - str.c_str();
+      for(int i = 0; i < dot_position; i++)
+        if(strncmp(str.c_str() + i, "0", 1) != 0)
+          return false;
+      for(int i = dot_position + 1; i < (int)str.length(); i++)
+        if(strncmp(str.c_str() + i, "0", 1) != 0)
+          return false;
+      return true;
+    }
+
     bool MeshReaderH2DXML::load(const char *filename, Mesh *mesh)
     {
       mesh->free();
@@ -188,6 +215,37 @@ namespace Hermes
           if(edge_is[i] > max_edge_i)
             max_edge_i = edge_is[i];
 
+        // Shared sections //
+        // The elements / edges sections are shared by all subdomains: trim the
+        // whitespaces off their markers once, and index the edges section by the
+        // file-level edge numbers, so that no subdomain has to re-walk them.
+        for (int element_i = 0; element_i < parsed_xml_domain->elements().el().size(); element_i++)
+        {
+          XMLSubdomains::domain::elements_type::el_type* element = &parsed_xml_domain->elements().el().at(element_i);
+
+          // Trim whitespaces.
+          unsigned int begin = element->m().find_first_not_of(" \t\n");
+          unsigned int end = element->m().find_last_not_of(" \t\n");
+          element->m().erase(end + 1, element->m().length());
+          element->m().erase(0, begin);
+        }
+        for(unsigned int edge_i = 0; edge_i < parsed_xml_domain->edges().ed().size(); edge_i++)
+        {
+          XMLSubdomains::domain::edges_type::ed_type* edge = &parsed_xml_domain->edges().ed().at(edge_i);
+
+          // Trim whitespaces.
+          unsigned int begin = edge->m().find_first_not_of(" \t\n");
+          unsigned int end = edge->m().find_last_not_of(" \t\n");
+          edge->m().erase(end + 1, edge->m().length());
+          edge->m().erase(0, begin);
+        }
+
+        int* edge_ordinal_by_number = new int[max_edge_i + 1];
+        for(int i = 0; i < max_edge_i + 1; i++)
+          edge_ordinal_by_number[i] = -1;
+        for(unsigned int edge_i = 0; edge_i < parsed_xml_domain->edges().ed().size(); edge_i++)
+          edge_ordinal_by_number[parsed_xml_domain->edges().ed().at(edge_i).i()] = edge_i;
+
         // Subdomains //
         unsigned int subdomains_count = parsed_xml_domain->subdomains().subdomain().size();
         if(subdomains_count != meshes.size())
@@ -196,394 +254,346 @@ namespace Hermes
         for(unsigned int subdomains_i = 0; subdomains_i < subdomains_count; subdomains_i++)
         {
           for (int element_i = 0; element_i < parsed_xml_domain->elements().el().size(); element_i++)
-          {
-            XMLSubdomains::domain::elements_type::el_type* element = &parsed_xml_domain->elements().el().at(element_i);
-
-            // Trim whitespaces.
-            unsigned int begin = element->m().find_first_not_of(" \t\n");
-            unsigned int end = element->m().find_last_not_of(" \t\n");
-            element->m().erase(end + 1, element->m().length());
-            element->m().erase(0, begin);
-
-            meshes[subdomains_i]->element_markers_conversion.insert_marker(meshes[subdomains_i]->element_markers_conversion.min_marker_unused, element->m());
-          }
+            meshes[subdomains_i]->element_markers_conversion.insert_marker(meshes[subdomains_i]->element_markers_conversion.min_marker_unused, parsed_xml_domain->elements().el().at(element_i).m());
           for(unsigned int edge_i = 0; edge_i < parsed_xml_domain->edges().ed().size(); edge_i++)
-          {
-            XMLSubdomains::domain::edges_type::ed_type* edge = &parsed_xml_domain->edges().ed().at(edge_i);
-
-            // Trim whitespaces.
-            unsigned int begin = edge->m().find_first_not_of(" \t\n");
-            unsigned int end = edge->m().find_last_not_of(" \t\n");
-            edge->m().erase(end + 1, edge->m().length());
-            edge->m().erase(0, begin);
-
-            meshes[subdomains_i]->boundary_markers_conversion.insert_marker(meshes[subdomains_i]->boundary_markers_conversion.min_marker_unused, edge->m());
-          }
+            meshes[subdomains_i]->boundary_markers_conversion.insert_marker(meshes[subdomains_i]->boundary_markers_conversion.min_marker_unused, parsed_xml_domain->edges().ed().at(edge_i).m());
         }
 
-        for(unsigned int subdomains_i = 0; subdomains_i < subdomains_count; subdomains_i++)
+        // The subdomain meshes are built independently of each other, each one
+        // only reads the (now pre-processed) shared sections.
+        Hermes::Exceptions::Exception* caughtException = NULL;
+        int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+#pragma omp parallel for num_threads(num_threads_used)
+        for(int subdomains_i = 0; subdomains_i < (int)subdomains_count; subdomains_i++)
         {
-          unsigned int vertex_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).vertices().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).vertices()->i().size() : 0;
-          unsigned int element_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements()->i().size() : 0;
-          unsigned int boundary_edge_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges()->i().size() : 0;
-          unsigned int inner_edge_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).inner_edges().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).inner_edges()->i().size() : 0;
-
-          // copy the whole mesh if the subdomain is the whole mesh.
-          if(element_number_count == 0 || element_number_count == parsed_xml_domain->elements().el().size())
+          if(caughtException != NULL)
+            continue;
+          try
           {
-            meshes[subdomains_i]->copy(&global_mesh);
-            // refinements.
-            if(parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements().present() && parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size() > 0)
+            unsigned int vertex_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).vertices().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).vertices()->i().size() : 0;
+            unsigned int element_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements()->i().size() : 0;
+            unsigned int boundary_edge_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges()->i().size() : 0;
+            unsigned int inner_edge_number_count = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).inner_edges().present() ? parsed_xml_domain->subdomains().subdomain().at(subdomains_i).inner_edges()->i().size() : 0;
+
+            // copy the whole mesh if the subdomain is the whole mesh.
+            if(element_number_count == 0 || element_number_count == parsed_xml_domain->elements().el().size())
             {
-              // perform initial refinements
-              for (unsigned int i = 0; i < parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size(); i++)
+              // Mesh::copy() and the initial refinements advance the global mesh
+              // sequence number, which must stay unique across the meshes.
+#pragma omp critical (mesh_reader_h2d_xml_mesh_seq)
               {
-                int element_id = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).element_id();
-                int refinement_type = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).refinement_type();
-                if(refinement_type == -1)
-                  meshes[subdomains_i]->unrefine_element_id(element_id);
-                else
-                  meshes[subdomains_i]->refine_element_id(element_id, refinement_type);
+                meshes[subdomains_i]->copy(&global_mesh);
+                // refinements.
+                if(parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements().present() && parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size() > 0)
+                {
+                  // perform initial refinements
+                  for (unsigned int i = 0; i < parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size(); i++)
+                  {
+                    int element_id = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).element_id();
+                    int refinement_type = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).refinement_type();
+                    if(refinement_type == -1)
+                      meshes[subdomains_i]->unrefine_element_id(element_id);
+                    else
+                      meshes[subdomains_i]->refine_element_id(element_id, refinement_type);
+                  }
+                }
               }
             }
-          }
-          else
-          {
-            // Variables //
-            unsigned int variables_count = parsed_xml_domain->variables().present() ? parsed_xml_domain->variables()->var().size() : 0;
+            else
+            {
+              // Variables //
+              unsigned int variables_count = parsed_xml_domain->variables().present() ? parsed_xml_domain->variables()->var().size() : 0;
 
-            std::map<std::string, double> variables;
-            for (unsigned int variables_i = 0; variables_i < variables_count; variables_i++)
+              std::map<std::string, double> variables;
+              for (unsigned int variables_i = 0; variables_i < variables_count; variables_i++)
 #ifdef _MSC_VER
-              variables.insert(std::make_pair<std::string, double>((std::string)parsed_xml_domain->variables()->var().at(variables_i).name(), (double&&)parsed_xml_domain->variables()->var().at(variables_i).value()));
+                variables.insert(std::make_pair<std::string, double>((std::string)parsed_xml_domain->variables()->var().at(variables_i).name(), (double&&)parsed_xml_domain->variables()->var().at(variables_i).value()));
 #else
-              variables.insert(std::make_pair<std::string, double>((std::string)parsed_xml_domain->variables()->var().at(variables_i).name(), parsed_xml_domain->variables()->var().at(variables_i).value()));
+                variables.insert(std::make_pair<std::string, double>((std::string)parsed_xml_domain->variables()->var().at(variables_i).name(), parsed_xml_domain->variables()->var().at(variables_i).value()));
 #endif
-            // Vertex numbers //
-            // create a mapping order-in-the-whole-domain <-> order-in-this-subdomain.
-            std::map<unsigned int, unsigned int> vertex_vertex_numbers;
-
-            // Initialize mesh.
-            int size = HashTable::H2D_DEFAULT_HASH_SIZE;
-            while (size < 8 * vertex_number_count)
-              size *= 2;
-            meshes[subdomains_i]->init(size);
-
-            // Create top-level vertex nodes.
-            if(vertex_number_count == 0)
-              vertex_number_count = parsed_xml_domain->vertices().v().size();
-            for (unsigned int vertex_numbers_i = 0; vertex_numbers_i < vertex_number_count; vertex_numbers_i++)
-            {
-              unsigned int vertex_number;
-              if(vertex_number_count == parsed_xml_domain->vertices().v().size())
-                vertex_number = vertex_is[vertex_numbers_i];
-              else
-              {
-                vertex_number =  parsed_xml_domain->subdomains().subdomain().at(subdomains_i).vertices()->i().at(vertex_numbers_i);
-                if(vertex_number > max_vertex_i)
-                  throw Exceptions::MeshLoadFailureException("Wrong vertex number:%u in subdomain %u.", vertex_number, subdomains_i);
-              }
-
-              vertex_vertex_numbers.insert(std::pair<unsigned int, unsigned int>(vertex_number, vertex_numbers_i));
-              Node* node = meshes[subdomains_i]->nodes.add();
-              assert(node->id == vertex_numbers_i);
-              node->ref = TOP_LEVEL_REF;
-              node->type = HERMES_TYPE_VERTEX;
-              node->bnd = 0;
-              node->p1 = node->p2 = -1;
-              node->next_hash = NULL;
-
-              // variables matching.
-              std::string x = parsed_xml_domain->vertices().v().at(vertex_number).x();
-              std::string y = parsed_xml_domain->vertices().v().at(vertex_number).y();
-              double x_value;
-              double y_value;
-
-              // variables lookup.
-              bool x_found = false;
-              bool y_found = false;
-              if(variables.find(x) != variables.end())
-              {
-                x_value = variables.find(x)->second;
-                x_found = true;
-              }
-              if(variables.find(y) != variables.end())
+              // Vertex numbers //
+              // create a mapping order-in-the-whole-domain <-> order-in-this-subdomain.
+              std::map<unsigned int, unsigned int> vertex_vertex_numbers;
+
+              // Initialize mesh.
+              int size = HashTable::H2D_DEFAULT_HASH_SIZE;
+              while (size < 8 * vertex_number_count)
+                size *= 2;
+              meshes[subdomains_i]->init(size);
+
+              // Create top-level vertex nodes.
+              if(vertex_number_count == 0)
+                vertex_number_count = parsed_xml_domain->vertices().v().size();
+              for (unsigned int vertex_numbers_i = 0; vertex_numbers_i < vertex_number_count; vertex_numbers_i++)
               {
-                y_value = variables.find(y)->second;
-                y_found = true;
-              }
-
-              // test of value if no variable found.
-              if(!x_found)
-                if(std::strtod(x.c_str(), NULL) != 0.0)
-                  x_value = std::strtod(x.c_str(), NULL);
+                unsigned int vertex_number;
+                if(vertex_number_count == parsed_xml_domain->vertices().v().size())
+                  vertex_number = vertex_is[vertex_numbers_i];
                 else
                 {
-                  // This is a hard part, to find out if it is really zero.
-                  int dot_position = strchr(x.c_str(), '.') == NULL ? -1 : strchr(x.c_str(), '.') - x.c_str();
-                  for(int i = 0; i < dot_position; i++)
-                    if(strncmp(x.c_str() + i, "0", 1) != 0)
-                      throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_number + 1);
-                  for(int i = dot_position + 1; i < x.length(); i++)
-                    if(strncmp(x.c_str() + i, "0", 1) != 0)
-                      throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_number + 1);
-                  x_value = std::strtod(x.c_str(), NULL);
+                  vertex_number =  parsed_xml_domain->subdomains().subdomain().at(subdomains_i).vertices()->i().at(vertex_numbers_i);
+                  if(vertex_number > max_vertex_i)
+                    throw Exceptions::MeshLoadFailureException("Wrong vertex number:%u in subdomain %u.", vertex_number, subdomains_i);
                 }
 
-                if(!y_found)
-                  if(std::strtod(y.c_str(), NULL) != 0.0)
-                    y_value = std::strtod(y.c_str(), NULL);
-                  else
-                  {
-                    // This is a hard part, to find out if it is really zero.
-                    int dot_position = strchr(y.c_str(), '.') == NULL ? -1 : strchr(y.c_str(), '.') - y.c_str();
-                    for(int i = 0; i < dot_position; i++)
-                      if(strncmp(y.c_str() + i, "0", 1) != 0)
-                        throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_number + 1);
-                    for(int i = dot_position + 1; i < y.length(); i++)
-                      if(strncmp(y.c_str() + i, "0", 1) != 0)
-                        throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_number + 1);
-                    y_value = std::strtod(y.c_str(), NULL);
-                  }
-
-                  // assignment.
-                  node->x = x_value;
-                  node->y = y_value;
-            }
-            meshes[subdomains_i]->ntopvert = vertex_number_count;
-
-            // Element numbers //
-            unsigned int element_count = parsed_xml_domain->elements().el().size();
-            meshes[subdomains_i]->nbase = element_count;
-            meshes[subdomains_i]->nactive = meshes[subdomains_i]->ninitial = element_number_count;
-
-            Element* e;
-            int* elements_existing = new int[element_count];
-            for(int i = 0; i < element_count; i++)
-              elements_existing[i] = -1;
-            for (int element_number_i = 0; element_number_i < element_number_count; element_number_i++)
-            {
-              int elementI = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements()->i().at(element_number_i);
-              if(elementI > max_element_i)
-                  throw Exceptions::MeshLoadFailureException("Wrong element number:%i in subdomain %u.", elementI, subdomains_i);
-
-              elements_existing[element_is[parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements()->i().at(element_number_i)]] = elementI;
-            }
-            for (int element_i = 0; element_i < element_count; element_i++)
-            {
-              bool found = false;
-              if(element_number_count == 0)
-                found = true;
-              else
-                found = elements_existing[element_i] != -1;
-
-              if(!found)
-              {
-                meshes[subdomains_i]->elements.skip_slot();
-                continue;
+                vertex_vertex_numbers.insert(std::pair<unsigned int, unsigned int>(vertex_number, vertex_numbers_i));
+                Node* node = meshes[subdomains_i]->nodes.add();
+                assert(node->id == vertex_numbers_i);
+                node->ref = TOP_LEVEL_REF;
+                node->type = HERMES_TYPE_VERTEX;
+                node->bnd = 0;
+                node->p1 = node->p2 = -1;
+                node->next_hash = NULL;
+
+                // variables matching / value evaluation.
+                double x_value;
+                double y_value;
+                if(!get_coordinate_value(parsed_xml_domain->vertices().v().at(vertex_number).x(), variables, x_value))
+                  throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_number + 1);
+                if(!get_coordinate_value(parsed_xml_domain->vertices().v().at(vertex_number).y(), variables, y_value))
+                  throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_number + 1);
+
+                // assignment.
+                node->x = x_value;
+                node->y = y_value;
               }
+              meshes[subdomains_i]->ntopvert = vertex_number_count;
+
+              // Element numbers //
+              unsigned int element_count = parsed_xml_domain->elements().el().size();
+              meshes[subdomains_i]->nbase = element_count;
+              meshes[subdomains_i]->nactive = meshes[subdomains_i]->ninitial = element_number_count;
+
+              Element* e;
+              int* elements_existing = new int[element_count];
+              for(int i = 0; i < element_count; i++)
+                elements_existing[i] = -1;
+              for (int element_number_i = 0; element_number_i < element_number_count; element_number_i++)
+              {
+                int elementI = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements()->i().at(element_number_i);
+                if(elementI > max_element_i)
+                    throw Exceptions::MeshLoadFailureException("Wrong element number:%i in subdomain %u.", elementI, subdomains_i);
 
-              XMLSubdomains::domain::elements_type::el_type* element = NULL;
-              for(int searched_element_i = 0; searched_element_i < element_count; searched_element_i++)
+                elements_existing[element_is[parsed_xml_domain->subdomains().subdomain().at(subdomains_i).elements()->i().at(element_number_i)]] = elementI;
+              }
+              for (int element_i = 0; element_i < element_count; element_i++)
               {
-                element = &parsed_xml_domain->elements().el().at(searched_element_i);
-                if(element->i() == elements_existing[element_i])
-                  break;
+                bool found = false;
+                if(element_number_count == 0)
+                  found = true;
                 else
-                  element = NULL;
+                  found = elements_existing[element_i] != -1;
+
+                if(!found)
+                {
+                  meshes[subdomains_i]->elements.skip_slot();
+                  continue;
+                }
+
+                // element_is maps the file-level element number back onto the
+                // position in the shared elements section.
+                XMLSubdomains::domain::elements_type::el_type* element = NULL;
+                if(elements_existing[element_i] >= 0 && elements_existing[element_i] < H2D_MAX_NODE_ID && element_is[elements_existing[element_i]] != -1)
+                  element = &parsed_xml_domain->elements().el().at(element_is[elements_existing[element_i]]);
+                if(element == NULL)
+                  throw Exceptions::MeshLoadFailureException("Element number wrong in the mesh file.");
+
+                XMLSubdomains::q_t* el_q = dynamic_cast<XMLSubdomains::q_t*>(element);
+                XMLSubdomains::t_t* el_t = dynamic_cast<XMLSubdomains::t_t*>(element);
+                if(el_q != NULL)
+                  e = meshes[subdomains_i]->create_quad(meshes[subdomains_i]->element_markers_conversion.get_internal_marker(element->m()).marker,
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v1())->second],
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v2())->second],
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v3())->second],
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v4())->second],
+                  NULL, element_i);
+                if(el_t != NULL)
+                  e = meshes[subdomains_i]->create_triangle(meshes[subdomains_i]->element_markers_conversion.get_internal_marker(element->m()).marker,
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_t->v1())->second],
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_t->v2())->second],
+                  &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_t->v3())->second],
+                  NULL, element_i);
               }
-              if(element == NULL)
-                throw Exceptions::MeshLoadFailureException("Element number wrong in the mesh file.");
-
-              XMLSubdomains::q_t* el_q = dynamic_cast<XMLSubdomains::q_t*>(element);
-              XMLSubdomains::t_t* el_t = dynamic_cast<XMLSubdomains::t_t*>(element);
-              if(el_q != NULL)
-                e = meshes[subdomains_i]->create_quad(meshes[subdomains_i]->element_markers_conversion.get_internal_marker(element->m()).marker,
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v1())->second],
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v2())->second],
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v3())->second],
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_q->v4())->second],
-                NULL, element_i);
-              if(el_t != NULL)
-                e = meshes[subdomains_i]->create_triangle(meshes[subdomains_i]->element_markers_conversion.get_internal_marker(element->m()).marker,
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_t->v1())->second],
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_t->v2())->second],
-                &meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(el_t->v3())->second],
-                NULL, element_i);
-            }
 
-            // Boundary Edge numbers //
-            if(boundary_edge_number_count == 0)
-              boundary_edge_number_count = parsed_xml_domain->edges().ed().size();
+              // Boundary Edge numbers //
+              if(boundary_edge_number_count == 0)
+                boundary_edge_number_count = parsed_xml_domain->edges().ed().size();
 
-            for (int boundary_edge_number_i = 0; boundary_edge_number_i < boundary_edge_number_count; boundary_edge_number_i++)
-            {
-              XMLSubdomains::domain::edges_type::ed_type* edge = NULL;
-              for(unsigned int to_find_i = 0; to_find_i < parsed_xml_domain->edges().ed().size(); to_find_i++)
+              for (int boundary_edge_number_i = 0; boundary_edge_number_i < boundary_edge_number_count; boundary_edge_number_i++)
               {
+                int edge_number;
                 if(boundary_edge_number_count != parsed_xml_domain->edges().ed().size())
-                {
-                  if(parsed_xml_domain->edges().ed().at(to_find_i).i() == parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges()->i().at(boundary_edge_number_i))
-                  {
-                    edge = &parsed_xml_domain->edges().ed().at(to_find_i);
-                    break;
-                  }
-                }
+                  edge_number = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges()->i().at(boundary_edge_number_i);
                 else
-                {
-                  if(parsed_xml_domain->edges().ed().at(to_find_i).i() == edge_is[boundary_edge_number_i])
-                  {
-                    edge = &parsed_xml_domain->edges().ed().at(to_find_i);
-                    break;
-                  }
-                }
-              }
+                  edge_number = edge_is[boundary_edge_number_i];
 
-              if(edge == NULL)
-                  throw Exceptions::MeshLoadFailureException("Wrong boundary-edge number:%i in subdomain %u.", parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges()->i().at(boundary_edge_number_i), subdomains_i);
+                XMLSubdomains::domain::edges_type::ed_type* edge = NULL;
+                if(edge_number >= 0 && edge_number <= max_edge_i && edge_ordinal_by_number[edge_number] != -1)
+                  edge = &parsed_xml_domain->edges().ed().at(edge_ordinal_by_number[edge_number]);
 
-              Node* en = meshes[subdomains_i]->peek_edge_node(vertex_vertex_numbers.find(edge->v1())->second, vertex_vertex_numbers.find(edge->v2())->second);
-              if(en == NULL)
-                throw Hermes::Exceptions::MeshLoadFailureException("Boundary data error (edge %i does not exist).", boundary_edge_number_i);
+                if(edge == NULL)
+                    throw Exceptions::MeshLoadFailureException("Wrong boundary-edge number:%i in subdomain %u.", edge_number, subdomains_i);
 
-              en->marker = meshes[subdomains_i]->boundary_markers_conversion.get_internal_marker(edge->m()).marker;
+                Node* en = meshes[subdomains_i]->peek_edge_node(vertex_vertex_numbers.find(edge->v1())->second, vertex_vertex_numbers.find(edge->v2())->second);
+                if(en == NULL)
+                  throw Hermes::Exceptions::MeshLoadFailureException("Boundary data error (edge %i does not exist).", boundary_edge_number_i);
 
-              meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(edge->v1())->second].bnd = 1;
-              meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(edge->v2())->second].bnd = 1;
-              en->bnd = 1;
-            }
+                en->marker = meshes[subdomains_i]->boundary_markers_conversion.get_internal_marker(edge->m()).marker;
 
-            // Inner Edge numbers //
-            for (int inner_edge_number_i = 0; inner_edge_number_i < inner_edge_number_count; inner_edge_number_i++)
-            {
-              XMLSubdomains::domain::edges_type::ed_type* edge = NULL;
+                meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(edge->v1())->second].bnd = 1;
+                meshes[subdomains_i]->nodes[vertex_vertex_numbers.find(edge->v2())->second].bnd = 1;
+                en->bnd = 1;
+              }
 
-              for(unsigned int to_find_i = 0; to_find_i < parsed_xml_domain->edges().ed().size(); to_find_i++)
+              // Inner Edge numbers //
+              for (int inner_edge_number_i = 0; inner_edge_number_i < inner_edge_number_count; inner_edge_number_i++)
               {
-                if(parsed_xml_domain->edges().ed().at(to_find_i).i() == parsed_xml_domain->subdomains().subdomain().at(subdomains_i).inner_edges()->i().at(inner_edge_number_i))
-                {
-                  edge = &parsed_xml_domain->edges().ed().at(to_find_i);
-                  break;
-                }
-              }
+                int edge_number = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).inner_edges()->i().at(inner_edge_number_i);
 
-              if(edge == NULL)
-                  throw Exceptions::MeshLoadFailureException("Wrong inner-edge number:%i in subdomain %u.", parsed_xml_domain->subdomains().subdomain().at(subdomains_i).boundary_edges()->i().at(inner_edge_number_i), subdomains_i);
+                XMLSubdomains::domain::edges_type::ed_type* edge = NULL;
+                if(edge_number >= 0 && edge_number <= max_edge_i && edge_ordinal_by_number[edge_number] != -1)
+                  edge = &parsed_xml_domain->edges().ed().at(edge_ordinal_by_number[edge_number]);
 
-              Node* en = meshes[subdomains_i]->peek_edge_node(vertex_vertex_numbers.find(edge->v1())->second, vertex_vertex_numbers.find(edge->v2())->second);
-              if(en == NULL)
-                throw Hermes::Exceptions::MeshLoadFailureException("Inner data error (edge %i does not exist).", inner_edge_number_i);
+                if(edge == NULL)
+                    throw Exceptions::MeshLoadFailureException("Wrong inner-edge number:%i in subdomain %u.", edge_number, subdomains_i);
 
-              en->marker = meshes[subdomains_i]->boundary_markers_conversion.get_internal_marker(edge->m()).marker;
-              en->bnd = 0;
-            }
+                Node* en = meshes[subdomains_i]->peek_edge_node(vertex_vertex_numbers.find(edge->v1())->second, vertex_vertex_numbers.find(edge->v2())->second);
+                if(en == NULL)
+                  throw Hermes::Exceptions::MeshLoadFailureException("Inner data error (edge %i does not exist).", inner_edge_number_i);
 
-            // Curves //
-            // Arcs & NURBSs //
-            unsigned int arc_count = parsed_xml_domain->curves().present() ? parsed_xml_domain->curves()->arc().size() : 0;
-            unsigned int nurbs_count = parsed_xml_domain->curves().present() ? parsed_xml_domain->curves()->NURBS().size() : 0;
+                en->marker = meshes[subdomains_i]->boundary_markers_conversion.get_internal_marker(edge->m()).marker;
+                en->bnd = 0;
+              }
 
-            for (unsigned int curves_i = 0; curves_i < arc_count + nurbs_count; curves_i++)
-            {
-              // load the control points, knot vector, etc.
-              Node* en;
-              int p1, p2;
+              // Curves //
+              // Arcs & NURBSs //
+              unsigned int arc_count = parsed_xml_domain->curves().present() ? parsed_xml_domain->curves()->arc().size() : 0;
+              unsigned int nurbs_count = parsed_xml_domain->curves().present() ? parsed_xml_domain->curves()->NURBS().size() : 0;
 
-              // first do arcs, then NURBSs.
-              Nurbs* nurbs;
-              if(curves_i < arc_count)
+              for (unsigned int curves_i = 0; curves_i < arc_count + nurbs_count; curves_i++)
               {
-                if(vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v1()) == vertex_vertex_numbers.end() ||
-                  vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v2()) == vertex_vertex_numbers.end())
-                  continue;
-                else
-                {
-                  // read the end point indices
-                  p1 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v1())->second;
-                  p2 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v2())->second;
+                // load the control points, knot vector, etc.
+                Node* en;
+                int p1, p2;
 
-                  nurbs = load_arc(meshes[subdomains_i], parsed_xml_domain, curves_i, &en, p1, p2, true);
-                  if(nurbs == NULL)
+                // first do arcs, then NURBSs.
+                Nurbs* nurbs;
+                if(curves_i < arc_count)
+                {
+                  if(vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v1()) == vertex_vertex_numbers.end() ||
+                    vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v2()) == vertex_vertex_numbers.end())
                     continue;
+                  else
+                  {
+                    // read the end point indices
+                    p1 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v1())->second;
+                    p2 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->arc().at(curves_i).v2())->second;
+
+                    nurbs = load_arc(meshes[subdomains_i], parsed_xml_domain, curves_i, &en, p1, p2, true);
+                    if(nurbs == NULL)
+                      continue;
+                  }
                 }
-              }
-              else
-              {
-                if(vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v1()) == vertex_vertex_numbers.end() ||
-                  vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v2()) == vertex_vertex_numbers.end())
-                  continue;
                 else
                 {
-                  // read the end point indices
-                  p1 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v1())->second;
-                  p2 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v2())->second;
-
-                  nurbs = load_nurbs(meshes[subdomains_i], parsed_xml_domain, curves_i - arc_count, &en, p1, p2, true);
-                  if(nurbs == NULL)
+                  if(vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v1()) == vertex_vertex_numbers.end() ||
+                    vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v2()) == vertex_vertex_numbers.end())
                     continue;
-                }
-              }
-
-              // assign the arc to the elements sharing the edge node
-              for (unsigned int node_i = 0; node_i < 2; node_i++)
-              {
-                Element* e = en->elem[node_i];
-                if(e == NULL) continue;
+                  else
+                  {
+                    // read the end point indices
+                    p1 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v1())->second;
+                    p2 = vertex_vertex_numbers.find(parsed_xml_domain->curves()->NURBS().at(curves_i - arc_count).v2())->second;
 
-                if(e->cm == NULL)
-                {
-                  e->cm = new CurvMap;
-                  memset(e->cm, 0, sizeof(CurvMap));
-                  e->cm->toplevel = 1;
-                  e->cm->order = 4;
+                    nurbs = load_nurbs(meshes[subdomains_i], parsed_xml_domain, curves_i - arc_count, &en, p1, p2, true);
+                    if(nurbs == NULL)
+                      continue;
+                  }
                 }
 
-                int idx = -1;
-                for (unsigned j = 0; j < e->get_nvert(); j++)
-                  if(e->en[j] == en) { idx = j; break; }
-                  assert(idx >= 0);
+                // assign the arc to the elements sharing the edge node
+                for (unsigned int node_i = 0; node_i < 2; node_i++)
+                {
+                  Element* e = en->elem[node_i];
+                  if(e == NULL) continue;
 
-                  if(e->vn[idx]->id == p1)
-                  {
-                    e->cm->nurbs[idx] = nurbs;
-                    nurbs->ref++;
-                  }
-                  else
+                  if(e->cm == NULL)
                   {
-                    Nurbs* nurbs_rev = meshes[subdomains_i]->reverse_nurbs(nurbs);
-                    e->cm->nurbs[idx] = nurbs_rev;
-                    nurbs_rev->ref++;
+                    e->cm = new CurvMap;
+                    memset(e->cm, 0, sizeof(CurvMap));
+                    e->cm->toplevel = 1;
+                    e->cm->order = 4;
                   }
+
+                  int idx = -1;
+                  for (unsigned j = 0; j < e->get_nvert(); j++)
+                    if(e->en[j] == en) { idx = j; break; }
+                    assert(idx >= 0);
+
+                    if(e->vn[idx]->id == p1)
+                    {
+                      e->cm->nurbs[idx] = nurbs;
+                      nurbs->ref++;
+                    }
+                    else
+                    {
+                      Nurbs* nurbs_rev = meshes[subdomains_i]->reverse_nurbs(nurbs);
+                      e->cm->nurbs[idx] = nurbs_rev;
+                      nurbs_rev->ref++;
+                    }
+                }
+                if(!nurbs->ref) delete nurbs;
               }
-              if(!nurbs->ref) delete nurbs;
-            }
 
-            // update refmap coeffs of curvilinear elements
-            for_all_elements(e, meshes[subdomains_i])
-              if(e->cm != NULL)
-                e->cm->update_refmap_coeffs(e);
+              // update refmap coeffs of curvilinear elements
+              // (serialized - CurvMap keeps shared projection matrices that are
+              // calculated on the first use)
+#pragma omp critical (mesh_reader_h2d_xml_curved)
+              for_all_elements(e, meshes[subdomains_i])
+                if(e->cm != NULL)
+                  e->cm->update_refmap_coeffs(e);
 
-            // refinements.
-            if(parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements().present() && parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size() > 0)
-            {
-              // perform initial refinements
-              for (unsigned int i = 0; i < parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size(); i++)
+              // refinements.
+              if(parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements().present() && parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size() > 0)
               {
-                int element_id = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).element_id();
-                int refinement_type = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).refinement_type();
-                if(refinement_type == -1)
-                  meshes[subdomains_i]->unrefine_element_id(element_id);
-                else
-                  meshes[subdomains_i]->refine_element_id(element_id, refinement_type);
+                // perform initial refinements
+#pragma omp critical (mesh_reader_h2d_xml_mesh_seq)
+                for (unsigned int i = 0; i < parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size(); i++)
+                {
+                  int element_id = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).element_id();
+                  int refinement_type = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().at(i).refinement_type();
+                  if(refinement_type == -1)
+                    meshes[subdomains_i]->unrefine_element_id(element_id);
+                  else
+                    meshes[subdomains_i]->refine_element_id(element_id, refinement_type);
+                }
               }
-            }
 
-            delete [] elements_existing;
+              delete [] elements_existing;
+            }
+#pragma omp critical (mesh_reader_h2d_xml_mesh_seq)
+            meshes[subdomains_i]->seq = bump_mesh_seq(meshes[subdomains_i]);
+            meshes[subdomains_i]->initial_single_check();
+          }
+          catch(Hermes::Exceptions::Exception& e)
+          {
+#pragma omp critical (mesh_reader_h2d_xml_exception)
+            if(caughtException == NULL)
+              caughtException = e.clone();
+          }
+          catch(std::exception& e)
+          {
+#pragma omp critical (mesh_reader_h2d_xml_exception)
+            if(caughtException == NULL)
+              caughtException = new Hermes::Exceptions::MeshLoadFailureException(e.what());
           }
-          meshes[subdomains_i]->seq = g_mesh_seq++;
-          meshes[subdomains_i]->initial_single_check();
         }
 
+        delete [] edge_ordinal_by_number;
+
+        if(caughtException != NULL)
+          throw *caughtException;
+
         delete [] vertex_is;
 
         delete [] element_is;
@@ -810,6 +820,36 @@ namespace Hermes
           size *= 2;
         mesh->init(size);
 
+        // Evaluate the vertex coordinates first: the variable lookups and the
+        // string-to-number conversions are independent of each other, so the
+        // vertices section is processed chunked over all threads; the nodes are
+        // then created serially below.
+        double* x_values = new double[vertices_count];
+        double* y_values = new double[vertices_count];
+        char* failed_coordinate = new char[vertices_count];
+
+        int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+#pragma omp parallel for num_threads(num_threads_used)
+        for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
+        {
+          failed_coordinate[vertex_i] = 0;
+          if(!get_coordinate_value(parsed_xml_mesh->vertices().v().at(vertex_i).x(), variables, x_values[vertex_i]))
+            failed_coordinate[vertex_i] = 'x';
+          else if(!get_coordinate_value(parsed_xml_mesh->vertices().v().at(vertex_i).y(), variables, y_values[vertex_i]))
+            failed_coordinate[vertex_i] = 'y';
+        }
+
+        // The parallel loop must not throw, the first failure is reported here.
+        for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
+          if(failed_coordinate[vertex_i] != 0)
+          {
+            char coordinate = failed_coordinate[vertex_i];
+            delete [] x_values;
+            delete [] y_values;
+            delete [] failed_coordinate;
+            throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the %c coordinate of vertex no. %i.", coordinate, vertex_i + 1);
+          }
+
         // Create top-level vertex nodes.
         for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
         {
@@ -821,67 +861,16 @@ namespace Hermes
           node->p1 = node->p2 = -1;
           node->next_hash = NULL;
 
-          // variables matching.
-          std::string x = parsed_xml_mesh->vertices().v().at(vertex_i).x();
-          std::string y = parsed_xml_mesh->vertices().v().at(vertex_i).y();
-
           // insert into the map.
           vertex_is.insert(std::pair<unsigned int, unsigned int>(parsed_xml_mesh->vertices().v().at(vertex_i).i(), vertex_i));
 
-          double x_value;
-          double y_value;
-
-          // variables lookup.
-          bool x_found = false;
-          bool y_found = false;
-          if(variables.find(x) != variables.end())
-          {
-            x_value = variables.find(x)->second;
-            x_found = true;
-          }
-          if(variables.find(y) != variables.end())
-          {
-            y_value = variables.find(y)->second;
-            y_found = true;
-          }
-
-          // test of value if no variable found.
-          if(!x_found)
-            if(std::strtod(x.c_str(), NULL) != 0.0)
-              x_value = std::strtod(x.c_str(), NULL);
-            else
-            {
-              // This is a hard part, to find out if it is really zero.
-              int dot_position = strchr(x.c_str(), '.') == NULL ? -1 : strchr(x.c_str(), '.') - x.c_str();
-              for(int i = 0; i < dot_position; i++)
-                if(strncmp(x.c_str() + i, "0", 1) != 0)
-                  throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_i + 1);
-              for(int i = dot_position + 1; i < x.length(); i++)
-                if(strncmp(x.c_str() + i, "0", 1) != 0)
-                  throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_i + 1);
-              x_value = std::strtod(x.c_str(), NULL);
-            }
-
-            if(!y_found)
-              if(std::strtod(y.c_str(), NULL) != 0.0)
-                y_value = std::strtod(y.c_str(), NULL);
-              else
-              {
-                // This is a hard part, to find out if it is really zero.
-                int dot_position = strchr(y.c_str(), '.') == NULL ? -1 : strchr(y.c_str(), '.') - y.c_str();
-                for(int i = 0; i < dot_position; i++)
-                  if(strncmp(y.c_str() + i, "0", 1) != 0)
-                    throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_i + 1);
-                for(int i = dot_position + 1; i < y.length(); i++)
-                  if(strncmp(y.c_str() + i, "0", 1) != 0)
-                    throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_i + 1);
-                y_value = std::strtod(y.c_str(), NULL);
-              }
-
-              // assignment.
-              node->x = x_value;
-              node->y = y_value;
+          // assignment.
+          node->x = x_values[vertex_i];
+          node->y = y_values[vertex_i];
         }
+        delete [] x_values;
+        delete [] y_values;
+        delete [] failed_coordinate;
         mesh->ntopvert = vertices_count;
 
         // Elements //
@@ -1061,6 +1050,36 @@ namespace Hermes
           size *= 2;
         mesh->init(size);
 
+        // Evaluate the vertex coordinates first: the variable lookups and the
+        // string-to-number conversions are independent of each other, so the
+        // vertices section is processed chunked over all threads; the nodes are
+        // then created serially below.
+        double* x_values = new double[vertices_count];
+        double* y_values = new double[vertices_count];
+        char* failed_coordinate = new char[vertices_count];
+
+        int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+#pragma omp parallel for num_threads(num_threads_used)
+        for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
+        {
+          failed_coordinate[vertex_i] = 0;
+          if(!get_coordinate_value(parsed_xml_domain->vertices().v().at(vertex_i).x(), variables, x_values[vertex_i]))
+            failed_coordinate[vertex_i] = 'x';
+          else if(!get_coordinate_value(parsed_xml_domain->vertices().v().at(vertex_i).y(), variables, y_values[vertex_i]))
+            failed_coordinate[vertex_i] = 'y';
+        }
+
+        // The parallel loop must not throw, the first failure is reported here.
+        for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
+          if(failed_coordinate[vertex_i] != 0)
+          {
+            char coordinate = failed_coordinate[vertex_i];
+            delete [] x_values;
+            delete [] y_values;
+            delete [] failed_coordinate;
+            throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the %c coordinate of vertex no. %i.", coordinate, vertex_i + 1);
+          }
+
         // Create top-level vertex nodes.
         for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
         {
@@ -1072,70 +1091,24 @@ namespace Hermes
           node->p1 = node->p2 = -1;
           node->next_hash = NULL;
 
-          // variables matching.
-          std::string x = parsed_xml_domain->vertices().v().at(vertex_i).x();
-          std::string y = parsed_xml_domain->vertices().v().at(vertex_i).y();
-
           if(parsed_xml_domain->vertices().v().at(vertex_i).i() > H2D_MAX_NODE_ID - 1)
+          {
+            delete [] x_values;
+            delete [] y_values;
+            delete [] failed_coordinate;
             throw Exceptions::MeshLoadFailureException("The index 'i' of vertex in the mesh file must be lower than %i.", H2D_MAX_NODE_ID);
+          }
 
           // insert
           vertex_is[parsed_xml_domain->vertices().v().at(vertex_i).i()] = vertex_i;
 
-          double x_value;
-          double y_value;
-
-          // variables lookup.
-          bool x_found = false;
-          bool y_found = false;
-          if(variables.find(x) != variables.end())
-          {
-            x_value = variables.find(x)->second;
-            x_found = true;
-          }
-          if(variables.find(y) != variables.end())
-          {
-            y_value = variables.find(y)->second;
-            y_found = true;
-          }
-
-          // test of value if no variable found.
-          if(!x_found)
-            if(std::strtod(x.c_str(), NULL) != 0.0)
-              x_value = std::strtod(x.c_str(), NULL);
-            else
-            {
-              // This is a hard part, to find out if it is really zero.
-              int dot_position = strchr(x.c_str(), '.') == NULL ? -1 : strchr(x.c_str(), '.') - x.c_str();
-              for(int i = 0; i < dot_position; i++)
-                if(strncmp(x.c_str() + i, "0", 1) != 0)
-                  throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_i + 1);
-              for(int i = dot_position + 1; i < x.length(); i++)
-                if(strncmp(x.c_str() + i, "0", 1) != 0)
-                  throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the x coordinate of vertex no. %i.", vertex_i + 1);
-              x_value = std::strtod(x.c_str(), NULL);
-            }
-
-            if(!y_found)
-              if(std::strtod(y.c_str(), NULL) != 0.0)
-                y_value = std::strtod(y.c_str(), NULL);
-              else
-              {
-                // This is a hard part, to find out if it is really zero.
-                int dot_position = strchr(y.c_str(), '.') == NULL ? -1 : strchr(y.c_str(), '.') - y.c_str();
-                for(int i = 0; i < dot_position; i++)
-                  if(strncmp(y.c_str() + i, "0", 1) != 0)
-                    throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_i + 1);
-                for(int i = dot_position + 1; i < y.length(); i++)
-                  if(strncmp(y.c_str() + i, "0", 1) != 0)
-                    throw Hermes::Exceptions::MeshLoadFailureException("Wrong syntax in the y coordinate of vertex no. %i.", vertex_i + 1);
-                y_value = std::strtod(y.c_str(), NULL);
-              }
-
-              // assignment.
-              node->x = x_value;
-              node->y = y_value;
+          // assignment.
+          node->x = x_values[vertex_i];
+          node->y = y_values[vertex_i];
         }
+        delete [] x_values;
+        delete [] y_values;
+        delete [] failed_coordinate;
         mesh->ntopvert = vertices_count;
 
         // Elements //
@@ -32,6 +32,124 @@ namespace Hermes
 
     RefMap::~RefMap() { free(); }
 
+    bool RefMap::geometry_cache_enabled = false;
+
+    std::map<RefMap::GeometryCacheKey, RefMap::GeometryCacheEntry*> RefMap::geometry_cache;
+
+    bool RefMap::GeometryCacheKey::operator<(const GeometryCacheKey& other) const
+    {
+      if(element_id != other.element_id)
+        return element_id < other.element_id;
+      if(order != other.order)
+        return order < other.order;
+      if(sub_idx != other.sub_idx)
+        return sub_idx < other.sub_idx;
+      return mode < other.mode;
+    }
+
+    void RefMap::use_geometry_cache(bool use)
+    {
+      geometry_cache_enabled = use;
+    }
+
+    void RefMap::free_geometry_cache()
+    {
+#pragma omp critical (refmap_geometry_cache)
+      {
+        for(std::map<GeometryCacheKey, GeometryCacheEntry*>::iterator it = geometry_cache.begin(); it != geometry_cache.end(); it++)
+        {
+          if(it->second->jacobian != NULL)
+            delete [] it->second->jacobian;
+          if(it->second->inv_ref_map != NULL)
+            delete [] it->second->inv_ref_map;
+          if(it->second->second_ref_map != NULL)
+            delete [] it->second->second_ref_map;
+          if(it->second->phys_x != NULL)
+            delete [] it->second->phys_x;
+          if(it->second->phys_y != NULL)
+            delete [] it->second->phys_y;
+          delete it->second;
+        }
+        geometry_cache.clear();
+      }
+    }
+
+    RefMap::GeometryCacheEntry* RefMap::get_geometry_cache_entry(const GeometryCacheKey& cache_key, int np, bool create)
+    {
+      std::map<GeometryCacheKey, GeometryCacheEntry*>::iterator it = geometry_cache.find(cache_key);
+      if(it != geometry_cache.end())
+      {
+        GeometryCacheEntry* entry = it->second;
+
+        // The id alone does not identify the geometry, compare the vertices and
+        // the curvature signature.
+        bool matches = (entry->np == np) && (entry->curv == element->cm);
+        for (unsigned int vertex_i = 0; vertex_i < element->get_nvert() && matches; vertex_i++)
+          if(entry->x[vertex_i] != element->vn[vertex_i]->x || entry->y[vertex_i] != element->vn[vertex_i]->y)
+            matches = false;
+        if(matches && element->cm != NULL)
+        {
+          if(entry->curv_order != element->cm->order || entry->curv_nc != element->cm->nc
+            || entry->curv_coeff_first[0] != element->cm->coeffs[0][0] || entry->curv_coeff_first[1] != element->cm->coeffs[0][1]
+            || entry->curv_coeff_last[0] != element->cm->coeffs[element->cm->nc - 1][0] || entry->curv_coeff_last[1] != element->cm->coeffs[element->cm->nc - 1][1])
+            matches = false;
+        }
+
+        if(matches)
+          return entry;
+        if(!create)
+          return NULL;
+
+        // The element behind the id changed, release the stale tables.
+        if(entry->jacobian != NULL)
+          delete [] entry->jacobian;
+        if(entry->inv_ref_map != NULL)
+          delete [] entry->inv_ref_map;
+        if(entry->second_ref_map != NULL)
+          delete [] entry->second_ref_map;
+        if(entry->phys_x != NULL)
+          delete [] entry->phys_x;
+        if(entry->phys_y != NULL)
+          delete [] entry->phys_y;
+        delete entry;
+        geometry_cache.erase(it);
+      }
+
+      if(!create)
+        return NULL;
+
+      GeometryCacheEntry* entry = new GeometryCacheEntry;
+      entry->np = np;
+      for (unsigned int vertex_i = 0; vertex_i < element->get_nvert(); vertex_i++)
+      {
+        entry->x[vertex_i] = element->vn[vertex_i]->x;
+        entry->y[vertex_i] = element->vn[vertex_i]->y;
+      }
+      entry->curv = element->cm;
+      if(element->cm != NULL)
+      {
+        entry->curv_order = element->cm->order;
+        entry->curv_nc = element->cm->nc;
+        entry->curv_coeff_first[0] = element->cm->coeffs[0][0];
+        entry->curv_coeff_first[1] = element->cm->coeffs[0][1];
+        entry->curv_coeff_last[0] = element->cm->coeffs[element->cm->nc - 1][0];
+        entry->curv_coeff_last[1] = element->cm->coeffs[element->cm->nc - 1][1];
+      }
+      else
+      {
+        entry->curv_order = entry->curv_nc = 0;
+        entry->curv_coeff_first[0] = entry->curv_coeff_first[1] = 0.;
+        entry->curv_coeff_last[0] = entry->curv_coeff_last[1] = 0.;
+      }
+      entry->jacobian = NULL;
+      entry->inv_ref_map = NULL;
+      entry->second_ref_map = NULL;
+      entry->phys_x = NULL;
+      entry->phys_y = NULL;
+      geometry_cache.insert(std::make_pair(cache_key, entry));
+      return entry;
+    }
+
     /// Returns the current quadrature points.
     Quad2D* RefMap::get_quad_2d() const
     {
@@ -232,23 +350,83 @@ namespace Hermes
       assert(quad_2d != NULL);
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
 
+      // Try the shared geometry cache first - the tables may have been computed
+      // for this element already, by this or any other RefMap instance.
+      GeometryCacheKey cache_key;
+      bool cacheable = geometry_cache_enabled;
+      if(cacheable)
+      {
+        cache_key.element_id = element->id;
+        cache_key.order = order;
+        cache_key.sub_idx = sub_idx;
+        cache_key.mode = element->get_mode();
+
+        bool hit = false;
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, false);
+          if(entry != NULL && entry->inv_ref_map != NULL)
+          {
+            cur_node->inv_ref_map[order] = new double2x2[np];
+            memcpy(cur_node->inv_ref_map[order], entry->inv_ref_map, np * sizeof(double2x2));
+            cur_node->jacobian[order] = new double[np];
+            memcpy(cur_node->jacobian[order], entry->jacobian, np * sizeof(double));
+            hit = true;
+          }
+        }
+        if(hit)
+          return;
+      }
+
       // construct jacobi matrices of the direct reference map for all integration points
 
       double2x2* m = new double2x2[np];
-      memset(m, 0, np * sizeof(double2x2));
-      ref_map_pss.force_transform(sub_idx, ctm);
-      for (i = 0; i < nc; i++)
-      {
-        double *dx, *dy;
-        ref_map_pss.set_active_shape(indices[i]);
-        ref_map_pss.set_quad_order(order);
-        ref_map_pss.get_dx_dy_values(dx, dy);
-        for (j = 0; j < np; j++)
+      if(element->cm == NULL)
+      {
+        // Straight-edged elements do not need the shapeset table machinery: the
+        // Jacobi matrix of an affine triangle is constant and that of a bilinear
+        // quad is an analytic linear function of the reference coordinates.
+        double3* pt = quad_2d->get_points(order, element->get_mode());
+        if(element->is_triangle())
         {
-          m[j][0][0] += coeffs[i][0] * dx[j];
-          m[j][0][1] += coeffs[i][0] * dy[j];
-          m[j][1][0] += coeffs[i][1] * dx[j];
-          m[j][1][1] += coeffs[i][1] * dy[j];
+          m[0][0][0] = 0.5 * (element->vn[1]->x - element->vn[0]->x);
+          m[0][0][1] = 0.5 * (element->vn[2]->x - element->vn[0]->x);
+          m[0][1][0] = 0.5 * (element->vn[1]->y - element->vn[0]->y);
+          m[0][1][1] = 0.5 * (element->vn[2]->y - element->vn[0]->y);
+          for (j = 1; j < np; j++)
+            memcpy(m + j, m, sizeof(double2x2));
+        }
+        else
+        {
+          for (j = 0; j < np; j++)
+          {
+            // the reference coordinates of the point within the sub-element
+            double xi  = ctm->m[0] * pt[j][0] + ctm->t[0];
+            double eta = ctm->m[1] * pt[j][1] + ctm->t[1];
+            m[j][0][0] = 0.25 * ((element->vn[1]->x - element->vn[0]->x) * (1.0 - eta) + (element->vn[2]->x - element->vn[3]->x) * (1.0 + eta));
+            m[j][0][1] = 0.25 * ((element->vn[3]->x - element->vn[0]->x) * (1.0 - xi)  + (element->vn[2]->x - element->vn[1]->x) * (1.0 + xi));
+            m[j][1][0] = 0.25 * ((element->vn[1]->y - element->vn[0]->y) * (1.0 - eta) + (element->vn[2]->y - element->vn[3]->y) * (1.0 + eta));
+            m[j][1][1] = 0.25 * ((element->vn[3]->y - element->vn[0]->y) * (1.0 - xi)  + (element->vn[2]->y - element->vn[1]->y) * (1.0 + xi));
+          }
+        }
+      }
+      else
+      {
+        memset(m, 0, np * sizeof(double2x2));
+        ref_map_pss.force_transform(sub_idx, ctm);
+        for (i = 0; i < nc; i++)
+        {
+          double *dx, *dy;
+          ref_map_pss.set_active_shape(indices[i]);
+          ref_map_pss.set_quad_order(order);
+          ref_map_pss.get_dx_dy_values(dx, dy);
+          for (j = 0; j < np; j++)
+          {
+            m[j][0][0] += coeffs[i][0] * dx[j];
+            m[j][0][1] += coeffs[i][0] * dy[j];
+            m[j][1][0] += coeffs[i][1] * dx[j];
+            m[j][1][1] += coeffs[i][1] * dy[j];
+          }
         }
       }
 
@@ -281,6 +459,31 @@ namespace Hermes
       }
 
       delete [] m;
+
+      // Store the freshly computed tables in the shared geometry cache.
+      if(cacheable)
+      {
+        double2x2* irm_copy = new double2x2[np];
+        memcpy(irm_copy, irm, np * sizeof(double2x2));
+        double* jac_copy = new double[np];
+        memcpy(jac_copy, jac, np * sizeof(double));
+
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, true);
+          if(entry->inv_ref_map == NULL)
+          {
+            entry->inv_ref_map = irm_copy;
+            entry->jacobian = jac_copy;
+          }
+          else
+          {
+            // another thread has stored the tables meanwhile
+            delete [] irm_copy;
+            delete [] jac_copy;
+          }
+        }
+      }
     }
 
     void RefMap::calc_second_ref_map(int order)
@@ -288,25 +491,76 @@ namespace Hermes
       assert(quad_2d != NULL);
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
 
+      // Affine elements: the reference map is linear, its second derivatives
+      // vanish identically and the whole table is zero - no shapeset machinery,
+      // no inverse map needed.
+      if(is_const)
+      {
+        cur_node->second_ref_map[order] = new double3x2[np];
+        memset(cur_node->second_ref_map[order], 0, np * sizeof(double3x2));
+        return;
+      }
+
+      // Curved elements are the expensive case, try the shared geometry cache
+      // first, \sa calc_inv_ref_map().
+      GeometryCacheKey cache_key;
+      bool cacheable = geometry_cache_enabled && element->cm != NULL;
+      if(cacheable)
+      {
+        cache_key.element_id = element->id;
+        cache_key.order = order;
+        cache_key.sub_idx = sub_idx;
+        cache_key.mode = element->get_mode();
+
+        bool hit = false;
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, false);
+          if(entry != NULL && entry->second_ref_map != NULL)
+          {
+            cur_node->second_ref_map[order] = new double3x2[np];
+            memcpy(cur_node->second_ref_map[order], entry->second_ref_map, np * sizeof(double3x2));
+            hit = true;
+          }
+        }
+        if(hit)
+          return;
+      }
+
       double3x2* k = new double3x2[np];
       memset(k, 0, np * sizeof(double3x2));
-      ref_map_pss.force_transform(sub_idx, ctm);
-      for (i = 0; i < nc; i++)
-      {
-        double *dxy, *dxx, *dyy;
-        ref_map_pss.set_active_shape(indices[i]);
-        ref_map_pss.set_quad_order(order, H2D_FN_ALL);
-        dxx = ref_map_pss.get_dxx_values();
-        dyy = ref_map_pss.get_dyy_values();
-        dxy = ref_map_pss.get_dxy_values();
+      if(element->cm == NULL)
+      {
+        // The only straight-edged non-affine element is the general bilinear
+        // quad, whose map keeps a single constant mixed derivative.
+        double kxy_x = 0.25 * (element->vn[0]->x - element->vn[1]->x + element->vn[2]->x - element->vn[3]->x);
+        double kxy_y = 0.25 * (element->vn[0]->y - element->vn[1]->y + element->vn[2]->y - element->vn[3]->y);
         for (j = 0; j < np; j++)
         {
-          k[j][0][0] += coeffs[i][0] * dxx[j];
-          k[j][0][1] += coeffs[i][1] * dxx[j];
-          k[j][1][0] += coeffs[i][0] * dxy[j];
-          k[j][1][1] += coeffs[i][1] * dxy[j];
-          k[j][2][0] += coeffs[i][0] * dyy[j];
-          k[j][2][1] += coeffs[i][1] * dyy[j];
+          k[j][1][0] = kxy_x;
+          k[j][1][1] = kxy_y;
+        }
+      }
+      else
+      {
+        ref_map_pss.force_transform(sub_idx, ctm);
+        for (i = 0; i < nc; i++)
+        {
+          double *dxy, *dxx, *dyy;
+          ref_map_pss.set_active_shape(indices[i]);
+          ref_map_pss.set_quad_order(order, H2D_FN_ALL);
+          dxx = ref_map_pss.get_dxx_values();
+          dyy = ref_map_pss.get_dyy_values();
+          dxy = ref_map_pss.get_dxy_values();
+          for (j = 0; j < np; j++)
+          {
+            k[j][0][0] += coeffs[i][0] * dxx[j];
+            k[j][0][1] += coeffs[i][1] * dxx[j];
+            k[j][1][0] += coeffs[i][0] * dxy[j];
+            k[j][1][1] += coeffs[i][1] * dxy[j];
+            k[j][2][0] += coeffs[i][0] * dyy[j];
+            k[j][2][1] += coeffs[i][1] * dyy[j];
+          }
         }
       }
 
@@ -335,6 +589,23 @@ namespace Hermes
       }
 
       delete [] k;
+
+      // Store the freshly computed table in the shared geometry cache.
+      if(cacheable)
+      {
+        double3x2* mm_copy = new double3x2[np];
+        memcpy(mm_copy, mm, np * sizeof(double3x2));
+
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, true);
+          if(entry->second_ref_map == NULL)
+            entry->second_ref_map = mm_copy;
+          else
+            // another thread has stored the table meanwhile
+            delete [] mm_copy;
+        }
+      }
     }
 
     bool RefMap::is_parallelogram(Element* e)
@@ -367,35 +638,151 @@ namespace Hermes
 
     void RefMap::calc_phys_x(int order)
     {
-      // transform all x coordinates of the integration points
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
+
+      // Try the shared geometry cache first.
+      GeometryCacheKey cache_key;
+      bool cacheable = geometry_cache_enabled;
+      if(cacheable)
+      {
+        cache_key.element_id = element->id;
+        cache_key.order = order;
+        cache_key.sub_idx = sub_idx;
+        cache_key.mode = element->get_mode();
+
+        bool hit = false;
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, false);
+          if(entry != NULL && entry->phys_x != NULL)
+          {
+            cur_node->phys_x[order] = new double[np];
+            memcpy(cur_node->phys_x[order], entry->phys_x, np * sizeof(double));
+            hit = true;
+          }
+        }
+        if(hit)
+          return;
+      }
+
+      // transform all x coordinates of the integration points
       double* x = cur_node->phys_x[order] = new double[np];
-      memset(x, 0, np * sizeof(double));
-      ref_map_pss.force_transform(sub_idx, ctm);
-      for (i = 0; i < nc; i++)
+      if(element->cm == NULL)
       {
-        ref_map_pss.set_active_shape(indices[i]);
-        ref_map_pss.set_quad_order(order);
-        double* fn = ref_map_pss.get_fn_values();
+        // straight-edged element: evaluate the affine / bilinear map analytically
+        double3* pt = quad_2d->get_points(order, element->get_mode());
         for (j = 0; j < np; j++)
-          x[j] += coeffs[i][0] * fn[j];
+        {
+          double xi  = ctm->m[0] * pt[j][0] + ctm->t[0];
+          double eta = ctm->m[1] * pt[j][1] + ctm->t[1];
+          if(element->is_triangle())
+            x[j] = -0.5 * (xi + eta) * element->vn[0]->x + 0.5 * (1.0 + xi) * element->vn[1]->x + 0.5 * (1.0 + eta) * element->vn[2]->x;
+          else
+            x[j] = 0.25 * ((1.0 - xi) * (1.0 - eta) * element->vn[0]->x + (1.0 + xi) * (1.0 - eta) * element->vn[1]->x
+              + (1.0 + xi) * (1.0 + eta) * element->vn[2]->x + (1.0 - xi) * (1.0 + eta) * element->vn[3]->x);
+        }
+      }
+      else
+      {
+        memset(x, 0, np * sizeof(double));
+        ref_map_pss.force_transform(sub_idx, ctm);
+        for (i = 0; i < nc; i++)
+        {
+          ref_map_pss.set_active_shape(indices[i]);
+          ref_map_pss.set_quad_order(order);
+          double* fn = ref_map_pss.get_fn_values();
+          for (j = 0; j < np; j++)
+            x[j] += coeffs[i][0] * fn[j];
+        }
+      }
+
+      if(cacheable)
+      {
+        double* x_copy = new double[np];
+        memcpy(x_copy, x, np * sizeof(double));
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, true);
+          if(entry->phys_x == NULL)
+            entry->phys_x = x_copy;
+          else
+            delete [] x_copy;
+        }
       }
     }
 
     void RefMap::calc_phys_y(int order)
     {
-      // transform all y coordinates of the integration points
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
+
+      // Try the shared geometry cache first.
+      GeometryCacheKey cache_key;
+      bool cacheable = geometry_cache_enabled;
+      if(cacheable)
+      {
+        cache_key.element_id = element->id;
+        cache_key.order = order;
+        cache_key.sub_idx = sub_idx;
+        cache_key.mode = element->get_mode();
+
+        bool hit = false;
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, false);
+          if(entry != NULL && entry->phys_y != NULL)
+          {
+            cur_node->phys_y[order] = new double[np];
+            memcpy(cur_node->phys_y[order], entry->phys_y, np * sizeof(double));
+            hit = true;
+          }
+        }
+        if(hit)
+          return;
+      }
+
+      // transform all y coordinates of the integration points
       double* y = cur_node->phys_y[order] = new double[np];
-      memset(y, 0, np * sizeof(double));
-      ref_map_pss.force_transform(sub_idx, ctm);
-      for (i = 0; i < nc; i++)
+      if(element->cm == NULL)
       {
-        ref_map_pss.set_active_shape(indices[i]);
-        ref_map_pss.set_quad_order(order);
-        double* fn = ref_map_pss.get_fn_values();
+        // straight-edged element: evaluate the affine / bilinear map analytically
+        double3* pt = quad_2d->get_points(order, element->get_mode());
         for (j = 0; j < np; j++)
-          y[j] += coeffs[i][1] * fn[j];
+        {
+          double xi  = ctm->m[0] * pt[j][0] + ctm->t[0];
+          double eta = ctm->m[1] * pt[j][1] + ctm->t[1];
+          if(element->is_triangle())
+            y[j] = -0.5 * (xi + eta) * element->vn[0]->y + 0.5 * (1.0 + xi) * element->vn[1]->y + 0.5 * (1.0 + eta) * element->vn[2]->y;
+          else
+            y[j] = 0.25 * ((1.0 - xi) * (1.0 - eta) * element->vn[0]->y + (1.0 + xi) * (1.0 - eta) * element->vn[1]->y
+              + (1.0 + xi) * (1.0 + eta) * element->vn[2]->y + (1.0 - xi) * (1.0 + eta) * element->vn[3]->y);
+        }
+      }
+      else
+      {
+        memset(y, 0, np * sizeof(double));
+        ref_map_pss.force_transform(sub_idx, ctm);
+        for (i = 0; i < nc; i++)
+        {
+          ref_map_pss.set_active_shape(indices[i]);
+          ref_map_pss.set_quad_order(order);
+          double* fn = ref_map_pss.get_fn_values();
+          for (j = 0; j < np; j++)
+            y[j] += coeffs[i][1] * fn[j];
+        }
+      }
+
+      if(cacheable)
+      {
+        double* y_copy = new double[np];
+        memcpy(y_copy, y, np * sizeof(double));
+#pragma omp critical (refmap_geometry_cache)
+        {
+          GeometryCacheEntry* entry = get_geometry_cache_entry(cache_key, np, true);
+          if(entry->phys_y == NULL)
+            entry->phys_y = y_copy;
+          else
+            delete [] y_copy;
+        }
       }
     }
 
@@ -784,9 +1171,35 @@ namespace Hermes
 
     Element* RefMap::element_on_physical_coordinates(const Mesh* mesh, double x, double y, double* x_reference, double* y_reference)
     {
-      // go through all elements
       double xi1, xi2;
       Element *e;
+
+      // fast path: restrict the scan to the elements whose bounding boxes cover the
+      // grid cell of the point; the grid is just a cache on the mesh (const_cast).
+      const Mesh::ElementSearchGrid* grid = const_cast<Mesh*>(mesh)->get_element_search_grid();
+      if(grid->cell_start != NULL && grid->nx > 0)
+      {
+        int cx = std::min(std::max((int) ((x - grid->min_x) / grid->cell_size_x), 0), grid->nx - 1);
+        int cy = std::min(std::max((int) ((y - grid->min_y) / grid->cell_size_y), 0), grid->ny - 1);
+        int cell = cy * grid->nx + cx;
+        for (int pos = grid->cell_start[cell]; pos < grid->cell_start[cell + 1]; pos++)
+        {
+          e = mesh->get_element(grid->cell_elements[pos]);
+          if(is_element_on_physical_coordinates(e, x, y, &xi1, &xi2))
+          {
+            if(x_reference != NULL)
+              (*x_reference) = xi1;
+            if(y_reference != NULL)
+              (*y_reference) = xi2;
+            return e;
+          }
+        }
+        // no candidate matched - either the point lies outside the domain, or a
+        // curved element bulges beyond its inflated bounding box; fall through to
+        // the exhaustive scan below to keep the original semantics.
+      }
+
+      // go through all elements
       // vector for curved elements that do not have the point in them when considering straight edges.
       Hermes::vector<Element*> improbable_curved_elements;
       for_all_active_elements(e, mesh)
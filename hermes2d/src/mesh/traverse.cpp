@@ -17,15 +17,133 @@
 #include "mesh.h"
 #include "transformable.h"
 #include "traverse.h"
+#include "instrumentation.h"
 namespace Hermes
 {
   namespace Hermes2D
   {
     static const Rect H2D_UNITY = { 0, 0, ONE, ONE };
-    Traverse::Traverse(bool master) : master(master)
+    Traverse::Traverse(bool master) : stack(NULL), master(master), states_cache(false), cached_states(NULL), cached_states_count(0), cached_seqs(NULL), cached_seqs_count(0)
     {
     }
 
+    Traverse::~Traverse()
+    {
+      free_states_cache();
+    }
+
+    bool Traverse::sfc_ordering_enabled = false;
+
+    void Traverse::use_space_filling_curve(bool use)
+    {
+      sfc_ordering_enabled = use;
+    }
+
+    /// Hilbert curve index of the grid cell (x, y) on a 2^order x 2^order grid.
+    static uint64_t hilbert_index(unsigned int x, unsigned int y, int order)
+    {
+      uint64_t d = 0;
+      for (unsigned int s = 1u << (order - 1); s > 0; s >>= 1)
+      {
+        unsigned int rx = (x & s) ? 1 : 0;
+        unsigned int ry = (y & s) ? 1 : 0;
+        d += (uint64_t) s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant
+        if(ry == 0)
+        {
+          if(rx == 1)
+          {
+            x = s - 1 - x;
+            y = s - 1 - y;
+          }
+          unsigned int tmp = x;
+          x = y;
+          y = tmp;
+        }
+      }
+      return d;
+    }
+
+    void Traverse::sort_states_by_sfc(Hermes::vector<State*>& states)
+    {
+      if(states.size() < 2)
+        return;
+
+      // bounding box of the representative element centroids
+      double min_x = 1e100, min_y = 1e100;
+      double max_x = -1e100, max_y = -1e100;
+      Hermes::vector<std::pair<double, double> > centroids;
+      centroids.reserve(states.size());
+      for (unsigned int i = 0; i < states.size(); i++)
+      {
+        Element* rep = states[i]->rep;
+        double cx = 0.0, cy = 0.0;
+        for (unsigned int k = 0; k < rep->get_nvert(); k++)
+        {
+          cx += rep->vn[k]->x;
+          cy += rep->vn[k]->y;
+        }
+        cx /= rep->get_nvert();
+        cy /= rep->get_nvert();
+        centroids.push_back(std::make_pair(cx, cy));
+        min_x = std::min(min_x, cx); max_x = std::max(max_x, cx);
+        min_y = std::min(min_y, cy); max_y = std::max(max_y, cy);
+      }
+
+      // map the centroids onto a 2^16 x 2^16 grid and sort by the Hilbert
+      // index; states of elements with equal indices keep their relative order
+      // through the pointer tiebreaker of the pair comparison.
+      const int order = 16;
+      double scale_x = (max_x > min_x) ? (((1u << order) - 1) / (max_x - min_x)) : 0.0;
+      double scale_y = (max_y > min_y) ? (((1u << order) - 1) / (max_y - min_y)) : 0.0;
+
+      std::vector<std::pair<uint64_t, void*> > keyed(states.size());
+      for (unsigned int i = 0; i < states.size(); i++)
+      {
+        unsigned int gx = (unsigned int) ((centroids[i].first - min_x) * scale_x);
+        unsigned int gy = (unsigned int) ((centroids[i].second - min_y) * scale_y);
+        keyed[i] = std::make_pair(hilbert_index(gx, gy, order), (void*) states[i]);
+      }
+      std::sort(keyed.begin(), keyed.end());
+      for (unsigned int i = 0; i < states.size(); i++)
+        states[i] = (State*) keyed[i].second;
+    }
+
+    void Traverse::set_states_cache(bool to_set)
+    {
+      this->states_cache = to_set;
+      if(!to_set)
+        free_states_cache();
+    }
+
+    void Traverse::free_states_cache()
+    {
+      if(cached_states != NULL)
+      {
+        free_states(cached_states, cached_states_count);
+        cached_states = NULL;
+        cached_states_count = 0;
+      }
+      if(cached_seqs != NULL)
+      {
+        delete [] cached_seqs;
+        cached_seqs = NULL;
+        cached_seqs_count = 0;
+      }
+    }
+
+    void Traverse::apply_state(Traverse::State* s)
+    {
+      if(this->fn == NULL)
+        return;
+      for (int i = 0; i < s->num; i++)
+        if(s->e[i] != NULL)
+        {
+          fn[i]->set_active_element(s->e[i]);
+          fn[i]->set_transform(s->sub_idx[i]);
+        }
+    }
+
     static int get_split_and_sons(Element* e, Rect* cr, Rect* er, int4& sons)
     {
       uint64_t hmid = (er->l + er->r) >> 1;
@@ -515,6 +633,373 @@ namespace Hermes
       this->finish();
     }
 
+    FaceState* Traverse::get_face_states(const Mesh* mesh, int& states_count)
+    {
+      // The exact count is not known beforehand, the vector is turned into a
+      // plain array at the end.
+      Hermes::vector<FaceState> faces;
+
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        for (int isurf = 0; isurf < e->get_nvert(); isurf++)
+        {
+          if(e->en[isurf]->bnd)
+            continue;
+
+          Element* neighbor = e->get_neighbor(isurf);
+          if(neighbor != NULL && neighbor->active)
+          {
+            // A conforming face - report it once, from the lower-id side.
+            if(neighbor->id < e->id)
+              continue;
+
+            FaceState face;
+            face.left = e;
+            face.right = neighbor;
+            face.left_surf = isurf;
+            face.right_surf = -1;
+            for (int j = 0; j < neighbor->get_nvert(); j++)
+              if(neighbor->en[j] == e->en[isurf])
+              {
+                face.right_surf = j;
+                break;
+              }
+            assert(face.right_surf >= 0);
+            face.marker = e->en[isurf]->marker;
+            faces.push_back(face);
+          }
+          else
+          {
+            // An irregular face - report the one-sided view, the caller goes
+            // through NeighborSearch for the neighborhood.
+            FaceState face;
+            face.left = e;
+            face.right = NULL;
+            face.left_surf = isurf;
+            face.right_surf = -1;
+            face.marker = e->en[isurf]->marker;
+            faces.push_back(face);
+          }
+        }
+      }
+
+      states_count = faces.size();
+      FaceState* faces_array = new FaceState[states_count];
+      for(int face_i = 0; face_i < states_count; face_i++)
+        faces_array[face_i] = faces[face_i];
+      return faces_array;
+    }
+
+    Traverse::State** Traverse::get_states(Hermes::vector<const Mesh*> meshes, int& states_count)
+    {
+      // As long as none of the meshes changed since the cached stream was derived,
+      // just replay it.
+      if(states_cache && cached_states != NULL && cached_seqs_count == (int)meshes.size())
+      {
+        bool meshes_unchanged = true;
+        for(int i = 0; i < cached_seqs_count; i++)
+          if(cached_seqs[i] != meshes[i]->get_seq())
+          {
+            meshes_unchanged = false;
+            break;
+          }
+        if(meshes_unchanged)
+        {
+          HERMES_PROFILE_INCREMENT(state_stream_replays);
+          states_count = cached_states_count;
+          return cached_states;
+        }
+      }
+
+      // Gathered states. The exact count is not known beforehand, the vector is
+      // turned into a plain array at the end.
+      Hermes::vector<State*> states;
+
+      this->num = meshes.size();
+      this->begin(num, &meshes.front());
+
+      while (1)
+      {
+        int i, son;
+        // The logic is identical to get_num_states() / get_next_state(), except that
+        // every leaf state encountered is deep-copied into the output array.
+        State* s;
+
+        while (top > 0 && (s = stack + top-1)->visited)
+          (top)--;
+
+        // The stack is empty, take next base element.
+        if(top <= 0)
+        {
+          s = push_state();
+          s->cr = H2D_UNITY;
+          while (1)
+          {
+            // No more base elements? we're finished.
+            if(id >= meshes[0]->get_num_base_elements())
+            {
+              this->finish();
+              if(sfc_ordering_enabled)
+                sort_states_by_sfc(states);
+              states_count = states.size();
+              State** states_array = new State*[states_count];
+              for(int state_i = 0; state_i < states_count; state_i++)
+                states_array[state_i] = states[state_i];
+
+              if(states_cache)
+              {
+                free_states_cache();
+                cached_states = states_array;
+                cached_states_count = states_count;
+                cached_seqs_count = meshes.size();
+                cached_seqs = new unsigned int[cached_seqs_count];
+                for(int i = 0; i < cached_seqs_count; i++)
+                  cached_seqs[i] = meshes[i]->get_seq();
+              }
+
+              return states_array;
+            }
+
+            int nused = 0;
+            for (i = 0; i < num; i++)
+            {
+              // Retrieve the Element with this id on the i-th mesh.
+              s->e[i] = meshes[i]->get_element(id);
+              if(!s->e[i]->used)
+              {
+                s->e[i] = NULL;
+                continue;
+              }
+              else
+                s->rep = s->e[i];
+              s->er[i] = H2D_UNITY;
+              nused++;
+            }
+            if(nused)
+              break;
+            (id)++;
+          }
+
+          (id)++;
+
+          if(s->rep->is_triangle())
+            for (i = 0; i < 3; i++)
+              s->bnd[i] = true;
+        }
+
+        // Entering a new state, perform transformations.
+        s->visited = true;
+        for (i = 0; i < num; i++)
+        {
+          // ..where the element is used ..
+          if(s->e[i] != NULL)
+            if(s->sub_idx[i] == 0 && s->e[i]->active)
+              if(!s->rep->is_triangle())
+                init_transforms(s, i);
+        }
+
+        // Is this the leaf state?
+        bool leaf = true;
+        for (i = 0; i < num; i++)
+        {
+          if(s->e[i] != NULL)
+            if(!s->e[i]->active)
+            {
+              leaf = false;
+              break;
+            }
+        }
+
+        // If yes, store a stand-alone copy of the state.
+        if(leaf)
+        {
+          set_boundary_info(s);
+          State* copy = new State();
+          *copy = s;
+          states.push_back(copy);
+          continue;
+        }
+
+        // Triangle: push son states
+        if(s->rep->is_triangle())
+        {
+          // Triangle always has 4 sons.
+          for (son = 0; son <= 3; son++)
+          {
+            State* ns = push_state();
+            // For every mesh..
+            for (i = 0; i < num; i++)
+            {
+              // ..if the element is not used.
+              if(s->e[i] == NULL)
+              {
+                ns->e[i] = NULL;
+              }
+              else if(s->e[i]->active)
+              {
+                ns->rep = s->e[i];
+                ns->e[i] = s->e[i];
+                ns->sub_idx[i] = s->sub_idx[i];
+                ns->push_transform(son, i, true);
+              }
+              // ..we move to the son.
+              else
+              {
+                ns->e[i] = s->e[i]->sons[son];
+                // If the son's element is active.
+                if(ns->e[i]->active)
+                  ns->sub_idx[i] = 0;
+                if(ns->e[i] != NULL)
+                  ns->rep = ns->e[i];
+              }
+            }
+
+            // Determine boundary flags and positions for the new state.
+            if(son < 3)
+            {
+              memcpy(ns->bnd, s->bnd, sizeof(ns->bnd));
+
+              switch (son)
+              {
+              case 0: ns->bnd[1] = false; break;
+              case 1: ns->bnd[2] = false; break;
+              case 2: ns->bnd[0] = false; break;
+              }
+            }
+            else
+            {
+              memset(ns->bnd, 0, sizeof(ns->bnd));
+            }
+          }
+        }
+        // Quad: this is a little more complicated, same principle, though.
+        else
+        {
+          // Obtain split types and son numbers for the current rectangle on all elements.
+          int4* current_sons = new int4[num];
+          int split = 0;
+          for (i = 0; i < num; i++)
+            if(s->e[i] != NULL && !s->e[i]->active)
+              split |= get_split_and_sons(s->e[i], &s->cr, s->er + i, current_sons[i]);
+
+          // Both splits: recur to four sons, similar to triangles.
+          if(split == 3)
+          {
+            for (son = 0; son <= 3; son++)
+            {
+              State* ns = push_state();
+              // Sets the son's "base" rectangle to the correct one.
+              move_to_son(&ns->cr, &s->cr, son);
+
+              for (i = 0; i < num; i++)
+              {
+                if(s->e[i] == NULL)
+                {
+                  ns->e[i] = NULL;
+                }
+                else
+                {
+                  if(s->e[i]->active)
+                  {
+                    ns->e[i] = s->e[i];
+                    ns->sub_idx[i] = s->sub_idx[i];
+                    ns->push_transform(son, i);
+                  }
+                  else
+                  {
+                    ns->e[i] = s->e[i]->sons[current_sons[i][son] & 3];
+                    // Sets the son's "current mesh" rectangle correctly.
+                    move_to_son(ns->er + i, s->er + i, current_sons[i][son]);
+                    if(ns->e[i]->active)
+                      ns->sub_idx[i] = 0;
+                  }
+                  if(ns->e[i] != NULL)
+                    ns->rep = ns->e[i];
+                }
+              }
+            }
+          }
+          // V or h split, recur to two sons.
+          else if(split > 0)
+          {
+            int son0 = 4, son1 = 5;
+            if(split == 2) { son0 = 6; son1 = 7; }
+
+            for (son = son0; son <= son1; son++)
+            {
+              State* ns = push_state();
+              move_to_son(&ns->cr, &s->cr, son);
+
+              int j = (son == 4 || son == 6) ? 0 : 2;
+              for (i = 0; i < num; i++)
+              {
+                if(s->e[i] == NULL)
+                {
+                  ns->e[i] = NULL;
+                }
+                else
+                {
+                  if(s->e[i]->active)
+                  {
+                    ns->e[i] = s->e[i];
+                    ns->sub_idx[i] = s->sub_idx[i];
+                    ns->push_transform(son, i);
+                  }
+                  else
+                  {
+                    ns->e[i] = s->e[i]->sons[current_sons[i][j] & 3];
+                    move_to_son(ns->er + i, s->er + i, current_sons[i][j]);
+                    if(ns->e[i]->active)
+                      ns->sub_idx[i] = 0;
+                  }
+                  if(ns->e[i] != NULL)
+                    ns->rep = ns->e[i];
+                }
+              }
+            }
+          }
+
+          // No splits, recur to one son.
+          else
+          {
+            State* ns = push_state();
+            memcpy(&ns->cr, &s->cr, sizeof(Rect));
+
+            for (i = 0; i < num; i++)
+            {
+              if(s->e[i] == NULL)
+              {
+                ns->e[i] = NULL;
+              }
+              else if(s->e[i]->active)
+              {
+                ns->e[i] = s->e[i];
+                memcpy(&ns->er[i], &ns->cr, sizeof(Rect));
+              }
+              else
+              {
+                ns->e[i] = s->e[i]->sons[current_sons[i][0] & 3];
+                move_to_son(ns->er + i, s->er + i, current_sons[i][0]);
+                if(ns->e[i]->active)
+                  ns->sub_idx[i] = 0;
+                if(ns->e[i] != NULL)
+                  ns->rep = ns->e[i];
+              }
+            }
+          }
+          delete [] current_sons;
+        }
+      }
+    }
+
+    void Traverse::free_states(Traverse::State** states, int states_count)
+    {
+      for(int i = 0; i < states_count; i++)
+        delete states[i];
+      delete [] states;
+    }
+
     Traverse::State* Traverse::get_next_state(int* top_by_ref, int* id_by_ref)
     {
       // Serial / parallel code.
@@ -612,6 +1097,7 @@ namespace Hermes
                 fn[i]->set_transform(s->sub_idx[i]);
               }
               set_boundary_info(s);
+              HERMES_PROFILE_INCREMENT(states_traversed);
               return s;
         }
 
@@ -112,6 +112,41 @@ namespace Hermes
         this->rhs_number_format = number_format;
       }
 
+      static FILE* open_dump_file(const std::string& filename, Hermes::Algebra::EMatrixDumpFormat format, int iteration)
+      {
+        char* fileName = new char[filename.length() + 20];
+        switch(format)
+        {
+        case Hermes::Algebra::DF_MATLAB_SPARSE:
+          sprintf(fileName, "%s%i.m", filename.c_str(), iteration);
+          break;
+        case Hermes::Algebra::DF_MATRIX_MARKET:
+          sprintf(fileName, "%s%i.mtx", filename.c_str(), iteration);
+          break;
+        case Hermes::Algebra::DF_HERMES_BIN:
+          sprintf(fileName, "%s%i.bin", filename.c_str(), iteration);
+          break;
+        default:
+          sprintf(fileName, "%s%i", filename.c_str(), iteration);
+        }
+        // The binary format must not go through the text-mode newline translation.
+        FILE* file = fopen(fileName, format == Hermes::Algebra::DF_HERMES_BIN ? "wb" : "w+");
+        delete [] fileName;
+        return file;
+      }
+
+      template<typename Scalar>
+      FILE* MatrixRhsOutput<Scalar>::open_matrix_file(int iteration) const
+      {
+        return open_dump_file(this->matrixFilename, this->matrixFormat, iteration);
+      }
+
+      template<typename Scalar>
+      FILE* MatrixRhsOutput<Scalar>::open_rhs_file(int iteration) const
+      {
+        return open_dump_file(this->RhsFilename, this->RhsFormat, iteration);
+      }
+
       template HERMES_API class SettableSpaces<double>;
       template HERMES_API class SettableSpaces<std::complex<double> >;
       template HERMES_API class MatrixRhsOutput<double>;
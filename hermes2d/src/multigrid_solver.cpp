@@ -0,0 +1,729 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, see <http://www.gnu.prg/licenses/>.
+#include "multigrid_solver.h"
+#include "discrete_problem_linear.h"
+#include "solvers/umfpack_solver.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    template<typename Scalar>
+    MultigridSolver<Scalar>::MultigridSolver(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar>*> spaces)
+      : wf(wf), assembled(false), rhs(NULL), coarse_solver(NULL), coarse_rhs(NULL),
+      smoother(H2D_SMOOTHER_GAUSS_SEIDEL), pre_sweeps(2), post_sweeps(2), jacobi_weight(2.0 / 3.0),
+      tolerance(1e-8), max_iters(100), num_iters(0), residual_norm(0.0)
+    {
+      if(spaces.size() < 2)
+        throw Hermes::Exceptions::ValueException("spaces.size()", spaces.size(), 2);
+
+      for(unsigned int i = 0; i < spaces.size(); i++)
+      {
+        if(spaces[i]->get_type() != HERMES_H1_SPACE)
+          throw Hermes::Exceptions::Exception("MultigridSolver: only H1 spaces are supported.");
+
+        Level level;
+        level.space = spaces[i];
+        level.ndof = spaces[i]->get_num_dofs();
+        level.mat = NULL;
+        level.x = level.b = level.r = level.diag = NULL;
+        level.prol_ptr = NULL;
+        level.prol_dof = NULL;
+        level.prol_weight = NULL;
+        levels.push_back(level);
+      }
+    }
+
+    template<typename Scalar>
+    MultigridSolver<Scalar>::~MultigridSolver()
+    {
+      for(unsigned int i = 0; i < levels.size(); i++)
+      {
+        if(levels[i].mat != NULL)
+          delete levels[i].mat;
+        free_with_alignment(levels[i].x);
+        free_with_alignment(levels[i].b);
+        free_with_alignment(levels[i].r);
+        free_with_alignment(levels[i].diag);
+        if(levels[i].prol_ptr != NULL)
+          delete [] levels[i].prol_ptr;
+        if(levels[i].prol_dof != NULL)
+          delete [] levels[i].prol_dof;
+        if(levels[i].prol_weight != NULL)
+          delete [] levels[i].prol_weight;
+      }
+      if(coarse_solver != NULL)
+        delete coarse_solver;
+      if(coarse_rhs != NULL)
+        delete coarse_rhs;
+      if(rhs != NULL)
+        delete rhs;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::set_smoother(MultigridSmootherType smoother)
+    {
+      this->smoother = smoother;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::set_smoothing_sweeps(int pre_sweeps, int post_sweeps)
+    {
+      if(pre_sweeps < 0 || post_sweeps < 0)
+        throw Hermes::Exceptions::ValueException("sweeps", pre_sweeps < 0 ? pre_sweeps : post_sweeps, 0);
+      this->pre_sweeps = pre_sweeps;
+      this->post_sweeps = post_sweeps;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::set_jacobi_weight(double weight)
+    {
+      if(weight <= 0.0)
+        throw Hermes::Exceptions::ValueException("weight", weight, 0.0);
+      this->jacobi_weight = weight;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::set_tolerance(double tolerance)
+    {
+      if(tolerance <= 0.0)
+        throw Hermes::Exceptions::ValueException("tolerance", tolerance, 0.0);
+      this->tolerance = tolerance;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::set_max_iters(int max_iters)
+    {
+      if(max_iters < 1)
+        throw Hermes::Exceptions::ValueException("max_iters", max_iters, 1);
+      this->max_iters = max_iters;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::assemble()
+    {
+#ifdef WITH_UMFPACK
+      for(unsigned int i = 0; i < levels.size(); i++)
+      {
+        Level& level = levels[i];
+
+        // The transfer operators carry vertex values only, so every DOF of the
+        // level must be a vertex DOF - i.e. the spaces must be of first order.
+        Node* vn;
+        int vertex_dofs = 0;
+        for_all_vertex_nodes(vn, level.space->get_mesh())
+          if(level.space->ndata[vn->id].dof >= 0)
+            vertex_dofs++;
+        if(vertex_dofs != level.ndof)
+          throw Hermes::Exceptions::Exception("MultigridSolver: level %d is not a first-order space (%d of %d DOFs are vertex DOFs).",
+            i, vertex_dofs, level.ndof);
+
+        level.mat = new Algebra::UMFPackMatrix<Scalar>();
+        DiscreteProblemLinear<Scalar> dp(wf, level.space);
+        if(i == levels.size() - 1)
+        {
+          this->rhs = new Algebra::UMFPackVector<Scalar>(level.ndof);
+          dp.assemble(level.mat, this->rhs);
+        }
+        else
+          dp.assemble(level.mat);
+
+        level.x = new_with_alignment<Scalar>(level.ndof);
+        level.b = new_with_alignment<Scalar>(level.ndof);
+        level.r = new_with_alignment<Scalar>(level.ndof);
+        level.diag = new_with_alignment<Scalar>(level.ndof);
+        zero_with_first_touch(level.x, level.ndof);
+        zero_with_first_touch(level.b, level.ndof);
+        zero_with_first_touch(level.r, level.ndof);
+
+        // Diagonal extraction for the smoothers.
+        Algebra::CSCMatrix<Scalar>* csc = static_cast<Algebra::CSCMatrix<Scalar>*>(level.mat);
+        int* Ap = csc->get_Ap();
+        int* Ai = csc->get_Ai();
+        Scalar* Ax = csc->get_Ax();
+        for(int j = 0; j < level.ndof; j++)
+        {
+          level.diag[j] = Scalar(0.0);
+          for(int k = Ap[j]; k < Ap[j + 1]; k++)
+            if(Ai[k] == j)
+            {
+              level.diag[j] = Ax[k];
+              break;
+            }
+          if(level.diag[j] == Scalar(0.0))
+            throw Hermes::Exceptions::Exception("MultigridSolver: zero diagonal entry in row %d of level %d.", j, i);
+        }
+
+        if(i > 0)
+          build_transfer(i);
+      }
+
+      // The coarsest system is small - solve it directly and keep the solver
+      // so the factorization is computed just once.
+      coarse_rhs = new Algebra::UMFPackVector<Scalar>(levels[0].ndof);
+      coarse_solver = new Hermes::Solvers::UMFPackLinearMatrixSolver<Scalar>(
+        static_cast<Algebra::UMFPackMatrix<Scalar>*>(levels[0].mat),
+        static_cast<Algebra::UMFPackVector<Scalar>*>(coarse_rhs));
+
+      assembled = true;
+#else
+      throw Hermes::Exceptions::Exception("MultigridSolver requires a CSC-based matrix backend (UMFPACK).");
+#endif
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::resolve_coarse_dofs(Mesh* fine_mesh, const Space<Scalar>* coarse_space,
+      int node_id, double weight, std::map<int, double>& target)
+    {
+      Mesh* coarse_mesh = coarse_space->get_mesh();
+      if(node_id < coarse_mesh->get_max_node_id())
+      {
+        Node* cn = coarse_mesh->get_node(node_id);
+        if(cn->used && cn->type == HERMES_TYPE_VERTEX)
+        {
+          // The vertex exists on the coarse mesh. Essential-boundary and
+          // constrained vertices carry no coarse DOF - their contribution is
+          // dropped, the correction there being zero / determined elsewhere.
+          int dof = coarse_space->ndata[node_id].dof;
+          if(dof >= 0)
+            target[dof] += weight;
+          return;
+        }
+      }
+
+      // A refinement-created vertex: the midpoint of its two parents.
+      Node* fn = fine_mesh->get_node(node_id);
+      if(fn->p1 < 0 || fn->p2 < 0)
+        throw Hermes::Exceptions::Exception("MultigridSolver: vertex %d not traceable to the coarser mesh - the meshes are not nested.", node_id);
+      resolve_coarse_dofs(fine_mesh, coarse_space, fn->p1, 0.5 * weight, target);
+      resolve_coarse_dofs(fine_mesh, coarse_space, fn->p2, 0.5 * weight, target);
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::build_transfer(int level)
+    {
+      Level& fine = levels[level];
+      const Space<Scalar>* coarse_space = levels[level - 1].space;
+      Mesh* fine_mesh = fine.space->get_mesh();
+
+      std::vector<std::map<int, double> > rows(fine.ndof);
+      Node* vn;
+      for_all_vertex_nodes(vn, fine_mesh)
+      {
+        int dof = fine.space->ndata[vn->id].dof;
+        if(dof >= 0)
+          resolve_coarse_dofs(fine_mesh, coarse_space, vn->id, 1.0, rows[dof]);
+      }
+
+      int nnz = 0;
+      for(int i = 0; i < fine.ndof; i++)
+        nnz += rows[i].size();
+
+      fine.prol_ptr = new int[fine.ndof + 1];
+      fine.prol_dof = new int[nnz];
+      fine.prol_weight = new double[nnz];
+      int pos = 0;
+      for(int i = 0; i < fine.ndof; i++)
+      {
+        fine.prol_ptr[i] = pos;
+        for(std::map<int, double>::const_iterator it = rows[i].begin(); it != rows[i].end(); ++it)
+        {
+          fine.prol_dof[pos] = it->first;
+          fine.prol_weight[pos] = it->second;
+          pos++;
+        }
+      }
+      fine.prol_ptr[fine.ndof] = pos;
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::compute_residual(int level)
+    {
+#ifdef WITH_UMFPACK
+      Level& l = levels[level];
+      static_cast<Algebra::CSCMatrix<Scalar>*>(l.mat)->multiply_with_vector(l.x, l.r);
+      for(int i = 0; i < l.ndof; i++)
+        l.r[i] = l.b[i] - l.r[i];
+#endif
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::smooth(int level, int sweeps)
+    {
+#ifdef WITH_UMFPACK
+      Level& l = levels[level];
+      Algebra::CSCMatrix<Scalar>* csc = static_cast<Algebra::CSCMatrix<Scalar>*>(l.mat);
+
+      if(smoother == H2D_SMOOTHER_JACOBI)
+      {
+        for(int sweep = 0; sweep < sweeps; sweep++)
+        {
+          compute_residual(level);
+          for(int i = 0; i < l.ndof; i++)
+            l.x[i] += Scalar(jacobi_weight) * l.r[i] / l.diag[i];
+        }
+      }
+      else
+      {
+        // Forward Gauss-Seidel on column storage: the residual is kept updated
+        // column by column, so when column j is reached, r[j] already accounts
+        // for the new values of the unknowns 0..j-1.
+        int* Ap = csc->get_Ap();
+        int* Ai = csc->get_Ai();
+        Scalar* Ax = csc->get_Ax();
+        compute_residual(level);
+        for(int sweep = 0; sweep < sweeps; sweep++)
+        {
+          for(int j = 0; j < l.ndof; j++)
+          {
+            Scalar delta = l.r[j] / l.diag[j];
+            l.x[j] += delta;
+            for(int k = Ap[j]; k < Ap[j + 1]; k++)
+              l.r[Ai[k]] -= delta * Ax[k];
+          }
+        }
+      }
+#endif
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::solve_coarsest()
+    {
+#ifdef WITH_UMFPACK
+      Level& l = levels[0];
+      Algebra::UMFPackVector<Scalar>* rhs_vec = static_cast<Algebra::UMFPackVector<Scalar>*>(coarse_rhs);
+      memcpy(rhs_vec->get_c_array(), l.b, l.ndof * sizeof(Scalar));
+      coarse_solver->solve();
+      memcpy(l.x, coarse_solver->get_sln_vector(), l.ndof * sizeof(Scalar));
+#endif
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::v_cycle(int level)
+    {
+      if(level == 0)
+      {
+        solve_coarsest();
+        return;
+      }
+
+      Level& fine = levels[level];
+      Level& coarse = levels[level - 1];
+
+      smooth(level, pre_sweeps);
+      compute_residual(level);
+
+      // Restriction: b_coarse = P^T r_fine, zero coarse initial guess.
+      for(int i = 0; i < coarse.ndof; i++)
+      {
+        coarse.b[i] = Scalar(0.0);
+        coarse.x[i] = Scalar(0.0);
+      }
+      for(int i = 0; i < fine.ndof; i++)
+        for(int k = fine.prol_ptr[i]; k < fine.prol_ptr[i + 1]; k++)
+          coarse.b[fine.prol_dof[k]] += Scalar(fine.prol_weight[k]) * fine.r[i];
+
+      v_cycle(level - 1);
+
+      // Prolongation: x_fine += P x_coarse.
+      for(int i = 0; i < fine.ndof; i++)
+        for(int k = fine.prol_ptr[i]; k < fine.prol_ptr[i + 1]; k++)
+          fine.x[i] += Scalar(fine.prol_weight[k]) * coarse.x[fine.prol_dof[k]];
+
+      smooth(level, post_sweeps);
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::solve()
+    {
+#ifdef WITH_UMFPACK
+      if(!assembled)
+        assemble();
+
+      Level& finest = levels[levels.size() - 1];
+      memcpy(finest.b, static_cast<Algebra::UMFPackVector<Scalar>*>(rhs)->get_c_array(), finest.ndof * sizeof(Scalar));
+      memset(finest.x, 0, finest.ndof * sizeof(Scalar));
+
+      double rhs_norm = std::sqrt(vector_norm_squared((unsigned int) finest.ndof, finest.b));
+      if(rhs_norm == 0.0)
+        rhs_norm = 1.0;
+
+      num_iters = 0;
+      while(num_iters < max_iters)
+      {
+        v_cycle(levels.size() - 1);
+        num_iters++;
+
+        compute_residual(levels.size() - 1);
+        residual_norm = std::sqrt(vector_norm_squared((unsigned int) finest.ndof, finest.r));
+        this->info("\tMultigrid: V-cycle %d, relative residual %g.", num_iters, residual_norm / rhs_norm);
+        if(residual_norm / rhs_norm < tolerance)
+          return;
+      }
+
+      this->warn("\tMultigrid: maximum number of V-cycles (%d) reached, relative residual %g.", max_iters, residual_norm / rhs_norm);
+#else
+      throw Hermes::Exceptions::Exception("MultigridSolver requires a CSC-based matrix backend (UMFPACK).");
+#endif
+    }
+
+    template<typename Scalar>
+    void MultigridSolver<Scalar>::apply_vcycle(const Scalar* rhs, Scalar* out)
+    {
+      if(!assembled)
+        assemble();
+
+      Level& finest = levels[levels.size() - 1];
+      memcpy(finest.b, rhs, finest.ndof * sizeof(Scalar));
+      memset(finest.x, 0, finest.ndof * sizeof(Scalar));
+      v_cycle(levels.size() - 1);
+      memcpy(out, finest.x, finest.ndof * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    Scalar* MultigridSolver<Scalar>::get_sln_vector()
+    {
+      return levels[levels.size() - 1].x;
+    }
+
+    template<typename Scalar>
+    int MultigridSolver<Scalar>::get_num_iters() const
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    double MultigridSolver<Scalar>::get_residual_norm() const
+    {
+      return residual_norm;
+    }
+
+    template<typename Scalar>
+    PMultigridSolver<Scalar>::PMultigridSolver(const WeakForm<Scalar>* wf, const Space<Scalar>* space)
+      : wf(wf), space(space), ndof(space->get_num_dofs()), assembled(false),
+      mat(NULL), rhs(NULL), x(NULL), b(NULL), r(NULL), diag(NULL),
+      coarse_ndof(0), coarse_dof(NULL), full_to_coarse(NULL),
+      coarse_mat(NULL), coarse_solver(NULL), coarse_rhs(NULL),
+      smoother(H2D_SMOOTHER_GAUSS_SEIDEL), pre_sweeps(2), post_sweeps(2), jacobi_weight(2.0 / 3.0),
+      tolerance(1e-8), max_iters(100), num_iters(0), residual_norm(0.0)
+    {
+      if(space->get_type() != HERMES_H1_SPACE)
+        throw Hermes::Exceptions::Exception("PMultigridSolver: only H1 spaces are supported.");
+    }
+
+    template<typename Scalar>
+    PMultigridSolver<Scalar>::~PMultigridSolver()
+    {
+      if(mat != NULL)
+        delete mat;
+      if(rhs != NULL)
+        delete rhs;
+      free_with_alignment(x);
+      free_with_alignment(b);
+      free_with_alignment(r);
+      free_with_alignment(diag);
+      if(coarse_dof != NULL)
+        delete [] coarse_dof;
+      if(full_to_coarse != NULL)
+        delete [] full_to_coarse;
+      if(coarse_solver != NULL)
+        delete coarse_solver;
+      if(coarse_rhs != NULL)
+        delete coarse_rhs;
+      if(coarse_mat != NULL)
+        delete coarse_mat;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_smoother(MultigridSmootherType smoother)
+    {
+      this->smoother = smoother;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_smoothing_sweeps(int pre_sweeps, int post_sweeps)
+    {
+      if(pre_sweeps < 0 || post_sweeps < 0)
+        throw Hermes::Exceptions::ValueException("sweeps", pre_sweeps < 0 ? pre_sweeps : post_sweeps, 0);
+      this->pre_sweeps = pre_sweeps;
+      this->post_sweeps = post_sweeps;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_jacobi_weight(double weight)
+    {
+      if(weight <= 0.0)
+        throw Hermes::Exceptions::ValueException("weight", weight, 0.0);
+      this->jacobi_weight = weight;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_tolerance(double tolerance)
+    {
+      if(tolerance <= 0.0)
+        throw Hermes::Exceptions::ValueException("tolerance", tolerance, 0.0);
+      this->tolerance = tolerance;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_max_iters(int max_iters)
+    {
+      if(max_iters < 1)
+        throw Hermes::Exceptions::ValueException("max_iters", max_iters, 1);
+      this->max_iters = max_iters;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::assemble()
+    {
+#ifdef WITH_UMFPACK
+      mat = new Algebra::UMFPackMatrix<Scalar>();
+      rhs = new Algebra::UMFPackVector<Scalar>(ndof);
+      DiscreteProblemLinear<Scalar> dp(wf, space);
+      dp.assemble(mat, rhs);
+
+      x = new_with_alignment<Scalar>(ndof);
+      b = new_with_alignment<Scalar>(ndof);
+      r = new_with_alignment<Scalar>(ndof);
+      diag = new_with_alignment<Scalar>(ndof);
+      zero_with_first_touch(x, ndof);
+      zero_with_first_touch(b, ndof);
+      zero_with_first_touch(r, ndof);
+
+      // The vertex DOFs span the p = 1 subspace; number them in the order of
+      // their full-system DOF numbers.
+      full_to_coarse = new int[ndof];
+      for(int i = 0; i < ndof; i++)
+        full_to_coarse[i] = -1;
+      Node* vn;
+      for_all_vertex_nodes(vn, space->get_mesh())
+      {
+        int dof = space->ndata[vn->id].dof;
+        if(dof >= 0)
+          full_to_coarse[dof] = 0;
+      }
+      coarse_ndof = 0;
+      for(int i = 0; i < ndof; i++)
+        if(full_to_coarse[i] == 0)
+          full_to_coarse[i] = coarse_ndof++;
+      if(coarse_ndof == 0)
+        throw Hermes::Exceptions::Exception("PMultigridSolver: the space has no vertex DOFs.");
+      if(coarse_ndof == ndof)
+        this->warn("PMultigridSolver: the space is of first order already, the coarse correction is a direct solve.");
+      coarse_dof = new int[coarse_ndof];
+      for(int i = 0; i < ndof; i++)
+        if(full_to_coarse[i] >= 0)
+          coarse_dof[full_to_coarse[i]] = i;
+
+      Algebra::CSCMatrix<Scalar>* csc = static_cast<Algebra::CSCMatrix<Scalar>*>(mat);
+      int* Ap = csc->get_Ap();
+      int* Ai = csc->get_Ai();
+      Scalar* Ax = csc->get_Ax();
+
+      // Diagonal extraction for the smoothers.
+      for(int j = 0; j < ndof; j++)
+      {
+        diag[j] = Scalar(0.0);
+        for(int k = Ap[j]; k < Ap[j + 1]; k++)
+          if(Ai[k] == j)
+          {
+            diag[j] = Ax[k];
+            break;
+          }
+        if(diag[j] == Scalar(0.0))
+          throw Hermes::Exceptions::Exception("PMultigridSolver: zero diagonal entry in row %d.", j);
+      }
+
+      // The coarse operator: the principal submatrix of the vertex DOFs. The
+      // index selection keeps the row ordering within the columns, so the
+      // selected entries form a valid CSC structure directly.
+      int coarse_nnz = 0;
+      for(int j = 0; j < ndof; j++)
+        if(full_to_coarse[j] >= 0)
+          for(int k = Ap[j]; k < Ap[j + 1]; k++)
+            if(full_to_coarse[Ai[k]] >= 0)
+              coarse_nnz++;
+
+      int* cap = new int[coarse_ndof + 1];
+      int* cai = new int[coarse_nnz];
+      Scalar* cax = new Scalar[coarse_nnz];
+      int pos = 0;
+      for(int cj = 0; cj < coarse_ndof; cj++)
+      {
+        cap[cj] = pos;
+        int j = coarse_dof[cj];
+        for(int k = Ap[j]; k < Ap[j + 1]; k++)
+          if(full_to_coarse[Ai[k]] >= 0)
+          {
+            cai[pos] = full_to_coarse[Ai[k]];
+            cax[pos] = Ax[k];
+            pos++;
+          }
+      }
+      cap[coarse_ndof] = pos;
+
+      Algebra::UMFPackMatrix<Scalar>* coarse_csc = new Algebra::UMFPackMatrix<Scalar>();
+      coarse_csc->create(coarse_ndof, coarse_nnz, cap, cai, cax);
+      coarse_mat = coarse_csc;
+      delete [] cap;
+      delete [] cai;
+      delete [] cax;
+
+      coarse_rhs = new Algebra::UMFPackVector<Scalar>(coarse_ndof);
+      coarse_solver = new Hermes::Solvers::UMFPackLinearMatrixSolver<Scalar>(
+        coarse_csc, static_cast<Algebra::UMFPackVector<Scalar>*>(coarse_rhs));
+
+      assembled = true;
+#else
+      throw Hermes::Exceptions::Exception("PMultigridSolver requires a CSC-based matrix backend (UMFPACK).");
+#endif
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::compute_residual()
+    {
+#ifdef WITH_UMFPACK
+      static_cast<Algebra::CSCMatrix<Scalar>*>(mat)->multiply_with_vector(x, r);
+      for(int i = 0; i < ndof; i++)
+        r[i] = b[i] - r[i];
+#endif
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::smooth(int sweeps)
+    {
+#ifdef WITH_UMFPACK
+      if(smoother == H2D_SMOOTHER_JACOBI)
+      {
+        for(int sweep = 0; sweep < sweeps; sweep++)
+        {
+          compute_residual();
+          for(int i = 0; i < ndof; i++)
+            x[i] += Scalar(jacobi_weight) * r[i] / diag[i];
+        }
+      }
+      else
+      {
+        // Forward Gauss-Seidel on column storage, \sa MultigridSolver::smooth().
+        Algebra::CSCMatrix<Scalar>* csc = static_cast<Algebra::CSCMatrix<Scalar>*>(mat);
+        int* Ap = csc->get_Ap();
+        int* Ai = csc->get_Ai();
+        Scalar* Ax = csc->get_Ax();
+        compute_residual();
+        for(int sweep = 0; sweep < sweeps; sweep++)
+        {
+          for(int j = 0; j < ndof; j++)
+          {
+            Scalar delta = r[j] / diag[j];
+            x[j] += delta;
+            for(int k = Ap[j]; k < Ap[j + 1]; k++)
+              r[Ai[k]] -= delta * Ax[k];
+          }
+        }
+      }
+#endif
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::cycle()
+    {
+#ifdef WITH_UMFPACK
+      smooth(pre_sweeps);
+      compute_residual();
+
+      // The p = 1 correction: restrict the residual by index selection, solve
+      // the vertex-DOF system and inject the correction back.
+      Algebra::UMFPackVector<Scalar>* rhs_vec = static_cast<Algebra::UMFPackVector<Scalar>*>(coarse_rhs);
+      Scalar* crhs = rhs_vec->get_c_array();
+      for(int c = 0; c < coarse_ndof; c++)
+        crhs[c] = r[coarse_dof[c]];
+      coarse_solver->solve();
+      Scalar* csln = coarse_solver->get_sln_vector();
+      for(int c = 0; c < coarse_ndof; c++)
+        x[coarse_dof[c]] += csln[c];
+
+      smooth(post_sweeps);
+#endif
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::solve()
+    {
+#ifdef WITH_UMFPACK
+      if(!assembled)
+        assemble();
+
+      memcpy(b, static_cast<Algebra::UMFPackVector<Scalar>*>(rhs)->get_c_array(), ndof * sizeof(Scalar));
+      memset(x, 0, ndof * sizeof(Scalar));
+
+      double rhs_norm = std::sqrt(vector_norm_squared((unsigned int) ndof, b));
+      if(rhs_norm == 0.0)
+        rhs_norm = 1.0;
+
+      num_iters = 0;
+      while(num_iters < max_iters)
+      {
+        cycle();
+        num_iters++;
+
+        compute_residual();
+        residual_norm = std::sqrt(vector_norm_squared((unsigned int) ndof, r));
+        this->info("\tP-multigrid: cycle %d, relative residual %g.", num_iters, residual_norm / rhs_norm);
+        if(residual_norm / rhs_norm < tolerance)
+          return;
+      }
+
+      this->warn("\tP-multigrid: maximum number of cycles (%d) reached, relative residual %g.", max_iters, residual_norm / rhs_norm);
+#else
+      throw Hermes::Exceptions::Exception("PMultigridSolver requires a CSC-based matrix backend (UMFPACK).");
+#endif
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::apply_cycle(const Scalar* rhs, Scalar* out)
+    {
+      if(!assembled)
+        assemble();
+
+      memcpy(b, rhs, ndof * sizeof(Scalar));
+      memset(x, 0, ndof * sizeof(Scalar));
+      cycle();
+      memcpy(out, x, ndof * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    Scalar* PMultigridSolver<Scalar>::get_sln_vector()
+    {
+      return x;
+    }
+
+    template<typename Scalar>
+    int PMultigridSolver<Scalar>::get_num_iters() const
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    double PMultigridSolver<Scalar>::get_residual_norm() const
+    {
+      return residual_norm;
+    }
+
+    template class HERMES_API MultigridSolver<double>;
+    template class HERMES_API MultigridSolver<std::complex<double> >;
+    template class HERMES_API PMultigridSolver<double>;
+    template class HERMES_API PMultigridSolver<std::complex<double> >;
+  }
+}
@@ -160,6 +160,24 @@ namespace Hermes
       //std::cout << std::endl << "central element: " << central_el->id << std::endl;
       if(central_el->en[active_edge]->bnd == 0)
       {
+        // If the mesh caches neighborhoods and this edge has already been visited, take the result from there.
+        if(mesh->get_neighborhood_caching())
+        {
+          Mesh::EdgeNeighborhood* cached = const_cast<Mesh*>(mesh)->get_cached_neighborhood(central_el->id, active_edge);
+          if(cached != NULL)
+          {
+            init_from_neighborhood_cache(cached);
+            return;
+          }
+        }
+
+        // Issue software prefetches for the central element's recorded neighbors
+        // before the pointer chase through the edge nodes begins.
+        const Mesh::ElementAdjacency* adjacency = const_cast<Mesh*>(mesh)->get_element_adjacency();
+        if(central_el->id < adjacency->size)
+          for (int k = adjacency->neighbor_start[central_el->id]; k < adjacency->neighbor_start[central_el->id + 1]; k++)
+            H2D_PREFETCH(mesh->get_element(adjacency->neighbor_ids[k]));
+
         neighb_el = central_el->get_neighbor(active_edge);
 
         // First case : The neighboring element is of the same size as the central one.
@@ -233,12 +251,90 @@ namespace Hermes
             //debug_log("number of neighbors on the way down: %d ", n_neighbors);
           }
         }
+
+        if(mesh->get_neighborhood_caching())
+          store_neighborhood_cache();
       }
       else
         if(!ignore_errors)
           throw Hermes::Exceptions::Exception("The given edge isn't inner");
     }
 
+    template<typename Scalar>
+    void NeighborSearch<Scalar>::init_from_neighborhood_cache(const Mesh::EdgeNeighborhood* cached)
+    {
+      neighborhood_type = (NeighborhoodType) cached->type;
+      n_neighbors = cached->n_neighbors;
+
+      for(unsigned int i = 0; i < cached->n_neighbors; i++)
+      {
+        const Mesh::EdgeNeighborhood::Record& record = cached->records[i];
+
+        neighb_el = mesh->get_element(record.neighbor_id);
+        neighbors.push_back(neighb_el);
+        neighbor_edge.local_num_of_edge = record.local_num_of_edge;
+
+        NeighborEdgeInfo local_edge_info;
+        local_edge_info.local_num_of_edge = record.local_num_of_edge;
+        local_edge_info.orientation = record.orientation;
+        neighbor_edges.push_back(local_edge_info);
+
+        if(record.central_n_levels > 0)
+        {
+          if(!central_transformations.present(i))
+            central_transformations.add(new Transformations, i);
+          Transformations* tr = central_transformations.get(i);
+          memcpy(tr->transf, record.central_transf, record.central_n_levels * sizeof(unsigned int));
+          tr->num_levels = record.central_n_levels;
+        }
+
+        if(record.neighbor_n_levels > 0)
+        {
+          if(!neighbor_transformations.present(i))
+            neighbor_transformations.add(new Transformations, i);
+          Transformations* tr = neighbor_transformations.get(i);
+          memcpy(tr->transf, record.neighbor_transf, record.neighbor_n_levels * sizeof(unsigned int));
+          tr->num_levels = record.neighbor_n_levels;
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void NeighborSearch<Scalar>::store_neighborhood_cache()
+    {
+      Mesh::EdgeNeighborhood* cached = new Mesh::EdgeNeighborhood;
+      cached->type = neighborhood_type;
+      cached->n_neighbors = n_neighbors;
+      cached->records = new Mesh::EdgeNeighborhood::Record[n_neighbors];
+
+      for(unsigned int i = 0; i < n_neighbors; i++)
+      {
+        Mesh::EdgeNeighborhood::Record& record = cached->records[i];
+
+        record.neighbor_id = neighbors[i]->id;
+        record.local_num_of_edge = neighbor_edges[i].local_num_of_edge;
+        record.orientation = neighbor_edges[i].orientation;
+
+        if(central_transformations.present(i) && central_transformations.get(i)->num_levels > 0)
+        {
+          Transformations* tr = central_transformations.get(i);
+          record.central_n_levels = tr->num_levels;
+          record.central_transf = new unsigned int[tr->num_levels];
+          memcpy(record.central_transf, tr->transf, tr->num_levels * sizeof(unsigned int));
+        }
+
+        if(neighbor_transformations.present(i) && neighbor_transformations.get(i)->num_levels > 0)
+        {
+          Transformations* tr = neighbor_transformations.get(i);
+          record.neighbor_n_levels = tr->num_levels;
+          record.neighbor_transf = new unsigned int[tr->num_levels];
+          memcpy(record.neighbor_transf, tr->transf, tr->num_levels * sizeof(unsigned int));
+        }
+      }
+
+      const_cast<Mesh*>(mesh)->cache_neighborhood(central_el->id, active_edge, cached);
+    }
+
     template<typename Scalar>
     bool NeighborSearch<Scalar>::set_active_edge_multimesh(const int& edge)
     {
@@ -76,6 +76,22 @@ namespace Hermes
       this->initial_auto_damping_ratio = 1.0;
       this->sufficient_improvement_factor = 0.95;
       this->necessary_successful_steps_to_increase = 1;
+      this->jacobian_refresh = false;
+      this->jacobian_refresh_ratio = 0.5;
+    }
+
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_jacobian_refresh_policy(bool onOff, double ratio)
+    {
+      if(onOff)
+      {
+        if(ratio <= 0.0)
+          throw Exceptions::ValueException("ratio", ratio, 0.0);
+        this->jacobian_refresh = true;
+        this->jacobian_refresh_ratio = ratio;
+      }
+      else
+        this->jacobian_refresh = false;
     }
 
     template<typename Scalar>
@@ -276,9 +292,11 @@ namespace Hermes
         delete_coeff_vec = true;
       }
 
-      // Vector for restarting steps.
-      Scalar* coeff_vec_back = new Scalar[ndof];
-      memset(coeff_vec_back, 0, ndof*sizeof(Scalar));
+      // Preallocated buffer of the last applied (damped) Newton increment; the
+      // damping search restarts a step in place through an axpy rollback instead
+      // of copying the whole candidate vector.
+      Scalar* applied_step = new Scalar[ndof];
+      memset(applied_step, 0, ndof*sizeof(Scalar));
 
       // Delete the old solution vector, if there is any.
       if(this->sln_vector != NULL)
@@ -293,6 +311,10 @@ namespace Hermes
       int it = 1;
       int successfulSteps = 0;
 
+      // The sparsity pattern may have changed since the last call (e.g. by adaptivity),
+      // start from a complete factorization.
+      linear_solver->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
+
       this->on_initialization();
 
       while (true)
@@ -303,15 +325,9 @@ namespace Hermes
         this->dp->assemble(coeff_vec, residual);
         if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
         {
-          char* fileName = new char[this->RhsFilename.length() + 5];
-          if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
-          FILE* rhs_file = fopen(fileName, "w+");
+          FILE* rhs_file = this->open_rhs_file(it);
           residual->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
           fclose(rhs_file);
-          delete [] fileName;
         }
         
         Element* e;
@@ -380,7 +396,7 @@ namespace Hermes
                   coeff_vec = NULL;
                 }
 
-                delete [] coeff_vec_back;
+                delete [] applied_step;
 
                 throw Exceptions::Exception("Newton NOT converged because of damping coefficient could not be decreased anymore to possibly handle non-converging process.");
               }
@@ -406,7 +422,7 @@ namespace Hermes
             coeff_vec = NULL;
           }
 
-          delete [] coeff_vec_back;
+          delete [] applied_step;
           
           throw Exceptions::ValueException("residual norm", residual_norm, max_allowed_residual_norm);
         }
@@ -426,7 +442,7 @@ namespace Hermes
             coeff_vec = NULL;
           }
 
-          delete [] coeff_vec_back;
+          delete [] applied_step;
 
           this->on_finish();
 
@@ -440,16 +456,9 @@ namespace Hermes
         this->dp->assemble(coeff_vec, jacobian);
         if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
         {
-          char* fileName = new char[this->matrixFilename.length() + 5];
-          if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
-          FILE* matrix_file = fopen(fileName, "w+");
-
+          FILE* matrix_file = this->open_matrix_file(it);
           jacobian->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
           fclose(matrix_file);
-          delete [] fileName;
         }
 
         this->on_step_end();
@@ -462,18 +471,23 @@ namespace Hermes
         if(!linear_solver->solve())
           throw Exceptions::LinearMatrixSolverException();
 
+        // The sparsity pattern of the Jacobian does not change between the iterations,
+        // subsequent factorizations can reuse the symbolic analysis.
+        if(it == 1)
+          linear_solver->set_factorization_scheme(HERMES_REUSE_MATRIX_REORDERING);
+
         // Add \deltaY^{n + 1} to Y^n.
         // The good case.
         if(residual_norm < last_residual_norm * this->sufficient_improvement_factor || this->manual_damping || it == 1)
         {
-          memcpy(coeff_vec_back, coeff_vec, sizeof(Scalar)*ndof);
-          for (int i = 0; i < ndof; i++)
-            coeff_vec[i] += currentDampingCofficient * linear_solver->get_sln_vector()[i];
+          vector_axpy_rec((unsigned int) ndof, Scalar(currentDampingCofficient), linear_solver->get_sln_vector(), coeff_vec, applied_step);
         }
         else
         {
-          for (int i = 0; i < ndof; i++)
-            coeff_vec[i] = coeff_vec_back[i] + currentDampingCofficient * (coeff_vec[i] - coeff_vec_back[i]);
+          // Roll the rejected part of the last step back in place and leave the
+          // recorded increment rescaled to the reduced damping coefficient, so
+          // repeated backtracks keep working on the same buffer.
+          vector_step_rescale((unsigned int) ndof, Scalar(currentDampingCofficient), applied_step, coeff_vec);
         }
 
         // Increase the number of iterations and test if we are still under the limit.
@@ -490,8 +504,8 @@ namespace Hermes
             coeff_vec = NULL;
           }
 
-          delete [] coeff_vec_back;
-          coeff_vec_back = NULL;
+          delete [] applied_step;
+          applied_step = NULL;
 
           this->tick();
           this->info("\tNewton: solution duration: %f s.\n", this->last());
@@ -539,11 +553,13 @@ namespace Hermes
         delete_coeff_vec = true;
       }
 
-      // Vector for restarting steps.
-      Scalar* coeff_vec_back = new Scalar[ndof];
-      memset(coeff_vec_back, 0, ndof*sizeof(Scalar));
+      // Preallocated buffer of the last applied (damped) Newton increment; the
+      // damping search restarts a step in place through an axpy rollback instead
+      // of copying the whole candidate vector.
+      Scalar* applied_step = new Scalar[ndof];
+      memset(applied_step, 0, ndof*sizeof(Scalar));
+
 
-      
       // The Newton's loop.
       double residual_norm;
       double last_residual_norm;
@@ -560,12 +576,7 @@ namespace Hermes
         this->dp->assemble(coeff_vec, residual);
         if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
         {
-          char* fileName = new char[this->RhsFilename.length() + 5];
-          if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
-          FILE* rhs_file = fopen(fileName, "w+");
+          FILE* rhs_file = this->open_rhs_file(it);
           residual->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
           fclose(rhs_file);
         }
@@ -636,7 +647,7 @@ namespace Hermes
                   coeff_vec = NULL;
                 }
 
-                delete [] coeff_vec_back;
+                delete [] applied_step;
           
                 throw Exceptions::Exception("Newton NOT converged because of damping coefficient could not be decreased anymore to possibly handle non-converging process.");
               }
@@ -661,7 +672,7 @@ namespace Hermes
             coeff_vec = NULL;
           }
 
-          delete [] coeff_vec_back;
+          delete [] applied_step;
 
           this->on_finish();
 
@@ -683,7 +694,7 @@ namespace Hermes
             coeff_vec = NULL;
           }
 
-          delete [] coeff_vec_back;
+          delete [] applied_step;
 
           this->tick();
           this->info("\tNewton: solution duration: %f s.", this->last());
@@ -694,7 +705,7 @@ namespace Hermes
 
         // Assemble and keep the jacobian if this has not been done before.
         // Also declare that LU-factorization in case of a direct solver will be done only once and reused afterwards.
-        if(kept_jacobian == NULL || !(static_cast<DiscreteProblem<Scalar>*>(this->dp))->have_matrix) 
+        if(kept_jacobian == NULL || !(static_cast<DiscreteProblem<Scalar>*>(this->dp))->have_matrix)
         {
           if(kept_jacobian != NULL)
             delete kept_jacobian;
@@ -713,19 +724,31 @@ namespace Hermes
 
           if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
           {
-            char* fileName = new char[this->matrixFilename.length() + 5];
-            if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-              sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
-            else
-              sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
-            FILE* matrix_file = fopen(fileName, "w+");
-
+            FILE* matrix_file = this->open_matrix_file(it);
             kept_jacobian->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
             fclose(matrix_file);
           }
 
           linear_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
         }
+        else if(this->jacobian_refresh && it > 1 && residual_norm > last_residual_norm * this->jacobian_refresh_ratio)
+        {
+          // The residual contraction with the stale jacobian has stalled, reassemble it
+          // at the current iterate. The sparsity pattern is unchanged, so the following
+          // solve refactorizes reusing the matrix reordering; the new factorization is
+          // then again reused completely until the next stall.
+          this->info("\t Newton: convergence stalled, reassembling the kept jacobian.");
+          this->dp->assemble(coeff_vec, kept_jacobian);
+
+          if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+          {
+            FILE* matrix_file = this->open_matrix_file(it);
+            kept_jacobian->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
+            fclose(matrix_file);
+          }
+
+          linear_solver->set_factorization_scheme(HERMES_REUSE_MATRIX_REORDERING);
+        }
 
         this->on_step_end();
 
@@ -734,23 +757,27 @@ namespace Hermes
         residual->change_sign();
 
         // Solve the linear system.
-        if(!linear_solver->solve()) 
+        if(!linear_solver->solve())
         {
           throw Exceptions::LinearMatrixSolverException();
         }
 
+        // If the jacobian was just refreshed, reuse its new factorization from now on.
+        if(this->jacobian_refresh)
+          linear_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+
          // Add \deltaY^{n + 1} to Y^n.
         // The good case.
         if(residual_norm < last_residual_norm * this->sufficient_improvement_factor || this->manual_damping || it == 1)
         {
-          memcpy(coeff_vec_back, coeff_vec, sizeof(Scalar)*ndof);
-          for (int i = 0; i < ndof; i++)
-            coeff_vec[i] += currentDampingCofficient * linear_solver->get_sln_vector()[i];
+          vector_axpy_rec((unsigned int) ndof, Scalar(currentDampingCofficient), linear_solver->get_sln_vector(), coeff_vec, applied_step);
         }
         else
         {
-          for (int i = 0; i < ndof; i++)
-            coeff_vec[i] = coeff_vec_back[i] + currentDampingCofficient * (coeff_vec[i] - coeff_vec_back[i]);
+          // Roll the rejected part of the last step back in place and leave the
+          // recorded increment rescaled to the reduced damping coefficient, so
+          // repeated backtracks keep working on the same buffer.
+          vector_step_rescale((unsigned int) ndof, Scalar(currentDampingCofficient), applied_step, coeff_vec);
         }
 
         // Increase the number of iterations and test if we are still under the limit.
@@ -767,7 +794,7 @@ namespace Hermes
             coeff_vec = NULL;
           }
 
-          delete [] coeff_vec_back;
+          delete [] applied_step;
 
           this->tick();
           this->info("\tNewton: solution duration: %f s.\n", this->last());
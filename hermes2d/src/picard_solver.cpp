@@ -136,7 +136,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void PicardSolver<Scalar>::calculate_anderson_coeffs(Scalar** previous_vectors, Scalar* anderson_coeffs, int num_last_vectors_used, int ndof)
+    void PicardSolver<Scalar>::calculate_anderson_coeffs(Scalar** previous_residuals, Scalar* anderson_coeffs, int num_last_vectors_used, int ndof)
     {
       if(num_last_vectors_used <= 1) throw Hermes::Exceptions::Exception("Picard: Anderson acceleration makes sense only if at least two last iterations are used.");
 
@@ -155,32 +155,31 @@ namespace Hermes
       double** mat = new_matrix<double>(n, n);
       Scalar* rhs = new Scalar[n];
 
-      // Set up the matrix and rhs vector.
+      // Set up the matrix and rhs vector. The residuals come in precomputed
+      // (solve() keeps them in the ring buffers), so every entry is a single
+      // pass of inner products over the already stored history.
+      Scalar* residual_n = previous_residuals[n];
       for (int i = 0; i < n; i++)
       {
+        Scalar* residual_i = previous_residuals[i];
+
         // Calculate i-th entry of the rhs vector.
         rhs[i] = 0;
         for (int k = 0; k < ndof; k++)
+          rhs[i] += residual_n[k] * (residual_n[k] - residual_i[k]);
+
+        // The system is symmetric, only the lower triangle is computed.
+        for (int j = 0; j <= i; j++)
         {
-          Scalar residual_n_k = previous_vectors[n + 1][k] - previous_vectors[n][k];
-          Scalar residual_i_k = previous_vectors[i + 1][k] - previous_vectors[i][k];
-          rhs[i] += residual_n_k * (residual_n_k - residual_i_k);
-        }
-        for (int j = 0; j < n; j++)
-        {
+          Scalar* residual_j = previous_residuals[j];
           Scalar val = 0;
           for (int k = 0; k < ndof; k++)
-          {
-            Scalar residual_n_k = previous_vectors[n + 1][k] - previous_vectors[n][k];
-            Scalar residual_i_k = previous_vectors[i + 1][k] - previous_vectors[i][k];
-            Scalar residual_j_k = previous_vectors[j + 1][k] - previous_vectors[j][k];
-            val += (residual_n_k - residual_i_k) * (residual_n_k - residual_j_k);
-          }
+            val += (residual_n[k] - residual_i[k]) * (residual_n[k] - residual_j[k]);
 
           // FIXME: This is not a nice way to cast Scalar to double. Not mentioning
           // that this will not work for Scalar = complex.
           double* ptr = (double*)(&val);
-          mat[i][j] = *ptr;
+          mat[i][j] = mat[j][i] = *ptr;
         }
       }
 
@@ -300,11 +299,16 @@ namespace Hermes
 
       // If Anderson is used, allocate memory for vectors and coefficients.
       Scalar** previous_vectors = NULL;      // To store num_last_vectors_used last coefficient vectors.
+      Scalar** previous_residuals = NULL;    // Ring of residuals of consecutive stored vectors - each
+                                             // iteration computes one new residual into a recycled
+                                             // buffer, the older ones are kept as they are.
       Scalar* anderson_coeffs = NULL;        // To store num_last_vectors_used - 1 Anderson coefficients.
       if (anderson_is_on)
       {
         previous_vectors = new Scalar*[num_last_vectors_used];
         for (int i = 0; i < num_last_vectors_used; i++) previous_vectors[i] = new Scalar[ndof];
+        previous_residuals = new Scalar*[num_last_vectors_used-1];
+        for (int i = 0; i < num_last_vectors_used-1; i++) previous_residuals[i] = new Scalar[ndof];
         anderson_coeffs = new Scalar[num_last_vectors_used-1];
       }
 
@@ -315,6 +319,10 @@ namespace Hermes
       int it = 1;
       int vec_in_memory = 1;   // There is already one vector in the memory.
 
+      // The sparsity pattern may have changed since the last call (e.g. by adaptivity),
+      // start from a complete factorization.
+      linear_solver->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
+
       this->on_initialization();
 
       while (true)
@@ -325,28 +333,15 @@ namespace Hermes
         this->dp->assemble(last_iter_vector, matrix, rhs);
         if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
         {
-          char* fileName = new char[this->matrixFilename.length() + 5];
-          if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
-          FILE* matrix_file = fopen(fileName, "w+");
-
+          FILE* matrix_file = this->open_matrix_file(it);
           matrix->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
           fclose(matrix_file);
-          delete [] fileName;
         }
         if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
         {
-          char* fileName = new char[this->RhsFilename.length() + 5];
-          if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
-          FILE* rhs_file = fopen(fileName, "w+");
+          FILE* rhs_file = this->open_rhs_file(it);
           rhs->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
           fclose(rhs_file);
-          delete [] fileName;
         }
 
         this->on_step_end();
@@ -357,25 +352,43 @@ namespace Hermes
         if(!linear_solver->solve())
           throw Exceptions::LinearMatrixSolverException();
 
+        // The matrix keeps its sparsity pattern over the iterations, only the values
+        // are reassembled - the symbolic analysis can be reused from now on.
+        if(it == 1)
+          linear_solver->set_factorization_scheme(HERMES_REUSE_MATRIX_REORDERING);
+
         memcpy(this->sln_vector, linear_solver->get_sln_vector(), sizeof(Scalar)*ndof);
 
-        // If Anderson is used, store the new vector in the memory.
+        // If Anderson is used, store the new vector and its residual in the ring buffers.
         if (anderson_is_on)
         {
           // If memory not full, just add the vector.
           if (vec_in_memory < num_last_vectors_used)
           {
             for (int i = 0; i < ndof; i++) previous_vectors[vec_in_memory][i] = this->sln_vector[i];
+            for (int i = 0; i < ndof; i++)
+              previous_residuals[vec_in_memory-1][i] = this->sln_vector[i] - previous_vectors[vec_in_memory-1][i];
             vec_in_memory++;
           }
-          else
+          else if (num_last_vectors_used > 1)
           {
-            // If memory full, shift all vectors back, forgetting the oldest one.
+            // If memory full, rotate the rings, forgetting the oldest entries.
             // Save this->sln_vector[] as the newest one.
             Scalar* oldest_vec = previous_vectors[0];
             for (int i = 0; i < num_last_vectors_used-1; i++) previous_vectors[i] = previous_vectors[i + 1];
             previous_vectors[num_last_vectors_used-1] = oldest_vec;
-            for (int j = 0; j < ndof; j++) previous_vectors[num_last_vectors_used-1][j] = this->sln_vector[j];
+
+            Scalar* oldest_residual = previous_residuals[0];
+            for (int i = 0; i < num_last_vectors_used-2; i++) previous_residuals[i] = previous_residuals[i + 1];
+            previous_residuals[num_last_vectors_used-2] = oldest_residual;
+
+            // Only the newest residual has to be computed, the kept ones are
+            // differences of kept vectors and remain valid.
+            for (int j = 0; j < ndof; j++)
+            {
+              previous_vectors[num_last_vectors_used-1][j] = this->sln_vector[j];
+              previous_residuals[num_last_vectors_used-2][j] = this->sln_vector[j] - previous_vectors[num_last_vectors_used-2][j];
+            }
           }
         }
 
@@ -383,7 +396,7 @@ namespace Hermes
         if (anderson_is_on && vec_in_memory >= num_last_vectors_used)
         {
           // Calculate Anderson coefficients.
-          calculate_anderson_coeffs(previous_vectors, anderson_coeffs, num_last_vectors_used, ndof);
+          calculate_anderson_coeffs(previous_residuals, anderson_coeffs, num_last_vectors_used, ndof);
 
           // Calculate new vector and store it in this->sln_vector[].
           for (int i = 0; i < ndof; i++)
@@ -397,17 +410,10 @@ namespace Hermes
         }
 
         // Calculate relative error between last_iter_vector[] and this->sln_vector[].
-        // FIXME: this is wrong in the complex case (complex conjugation must be used).
         // FIXME: This will crash if norm of last_iter_vector[] is zero.
-        double last_iter_vec_norm = 0;
-        for (int i = 0; i < ndof; i++)
-          last_iter_vec_norm += std::abs(last_iter_vector[i] * last_iter_vector[i]);
+        double last_iter_vec_norm = sqrt(vector_norm_squared((unsigned int) ndof, last_iter_vector));
 
-        last_iter_vec_norm = sqrt(last_iter_vec_norm);
-
-        double abs_error = 0;
-        for (int i = 0; i < ndof; i++) abs_error += std::abs((this->sln_vector[i] - last_iter_vector[i]) * (this->sln_vector[i] - last_iter_vector[i]));
-        abs_error = sqrt(abs_error);
+        double abs_error = sqrt(vector_diff_norm_squared((unsigned int) ndof, this->sln_vector, last_iter_vector));
 
         double rel_error = abs_error / last_iter_vec_norm;
 
@@ -426,9 +432,11 @@ namespace Hermes
           {
             for (int i = 0; i < num_last_vectors_used; i++) delete [] previous_vectors[i];
             delete [] previous_vectors;
+            for (int i = 0; i < num_last_vectors_used-1; i++) delete [] previous_residuals[i];
+            delete [] previous_residuals;
             delete [] anderson_coeffs;
           }
-          
+
           static_cast<DiscreteProblem<Scalar>*>(this->dp)->have_matrix = false;
 
           this->tick();
@@ -446,6 +454,8 @@ namespace Hermes
           {
             for (int i = 0; i < num_last_vectors_used; i++) delete [] previous_vectors[i];
             delete [] previous_vectors;
+            for (int i = 0; i < num_last_vectors_used-1; i++) delete [] previous_residuals[i];
+            delete [] previous_residuals;
             delete [] anderson_coeffs;
           }
           static_cast<DiscreteProblem<Scalar>*>(this->dp)->have_matrix = false;
@@ -16,6 +16,8 @@
 #include "projections/localprojection.h"
 #include "space.h"
 #include "discrete_problem.h"
+#include "traverse.h"
+#include "refmap.h"
 
 namespace Hermes
 {
@@ -170,6 +172,278 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void LocalProjection<Scalar>::transfer_to_coarse(const Space<Scalar>* space, MeshFunction<Scalar>* meshfn,
+      Scalar* target_vec)
+    {
+      if(target_vec == NULL) throw Exceptions::NullException(3);
+
+      int ndof = space->get_num_dofs();
+      memset(target_vec, 0, ndof * sizeof(Scalar));
+
+      // Averaging of basis functions shared by several elements.
+      Scalar* sums = new Scalar[ndof];
+      memset(sums, 0, ndof * sizeof(Scalar));
+      int* writes = new int[ndof];
+      memset(writes, 0, ndof * sizeof(int));
+
+      PrecalcShapeset pss(space->get_shapeset());
+      pss.set_quad_2d(&g_quad_2d_std);
+      RefMap rm;
+      rm.set_quad_2d(&g_quad_2d_std);
+      Quad2D* old_quad = meshfn->get_quad_2d();
+      meshfn->set_quad_2d(&g_quad_2d_std);
+
+      // The traversal of the two meshes yields, for every active element of the
+      // space, the source elements it is made of, together with the sub-element
+      // transformations placing them on the parent. The states of one parent come
+      // out consecutively, the loop below processes them as one group.
+      int num_states;
+      Traverse trav(true);
+      Hermes::vector<const Mesh*> meshes;
+      meshes.push_back(space->get_mesh());
+      meshes.push_back(meshfn->get_mesh());
+      Traverse::State** states = trav.get_states(meshes, num_states);
+
+      AsmList<Scalar> al;
+      int inc = (meshfn->get_num_components() == 2) ? 1 : 0;
+
+      int group_begin = 0;
+      while(group_begin < num_states)
+      {
+        Element* e = states[group_begin]->e[0];
+        int group_end = group_begin;
+        while(group_end < num_states && states[group_end]->e[0] == e)
+          group_end++;
+
+        space->get_element_assembly_list(e, &al);
+        int cnt = al.get_cnt();
+        if(cnt == 0)
+        {
+          group_begin = group_end;
+          continue;
+        }
+
+        // Constrained spaces may list one shape function several times, with
+        // different coefficients; the local solve runs over the distinct shapes.
+        int* shape_loc = new int[cnt];
+        int* distinct_idx = new int[cnt];
+        int m = 0;
+        for (int i = 0; i < cnt; i++)
+        {
+          int loc = -1;
+          for (int j = 0; j < m; j++)
+            if(distinct_idx[j] == al.get_idx()[i])
+            {
+              loc = j;
+              break;
+            }
+          if(loc < 0)
+          {
+            distinct_idx[m] = al.get_idx()[i];
+            loc = m++;
+          }
+          shape_loc[i] = loc;
+        }
+
+        double** mass = Hermes::Algebra::DenseMatrixOperations::new_matrix<double>(m, m);
+        Scalar* rhs = new Scalar[m];
+        memset(rhs, 0, m * sizeof(Scalar));
+        // Known (Dirichlet) contributions and the unknown / multiply listed flags.
+        Scalar* known = new Scalar[m];
+        memset(known, 0, m * sizeof(Scalar));
+        int* listed = new int[m];
+        memset(listed, 0, m * sizeof(int));
+        bool* unknown = new bool[m];
+        memset(unknown, 0, m * sizeof(bool));
+        for (int i = 0; i < cnt; i++)
+        {
+          listed[shape_loc[i]]++;
+          if(al.get_dof()[i] < 0)
+            known[shape_loc[i]] += al.get_coef()[i];
+          else
+            unknown[shape_loc[i]] = true;
+        }
+
+        for (int state_i = group_begin; state_i < group_end; state_i++)
+        {
+          Traverse::State* state = states[state_i];
+          if(state->e[0] == NULL || state->e[1] == NULL)
+            continue;
+
+          pss.set_active_element(e);
+          pss.set_transform(state->sub_idx[0]);
+          rm.set_active_element(e);
+          rm.force_transform(pss.get_transform(), pss.get_ctm());
+          meshfn->set_active_element(state->e[1]);
+          meshfn->set_transform(state->sub_idx[1]);
+
+          int shape_order = std::max(H2D_GET_H_ORDER(space->get_element_order(e->id)),
+            H2D_GET_V_ORDER(space->get_element_order(e->id)));
+          int order = shape_order + std::max(shape_order, meshfn->get_fn_order() + inc);
+          order += rm.get_inv_ref_order();
+          limit_order(order, e->get_mode());
+
+          double3* pt = g_quad_2d_std.get_points(order, e->get_mode());
+          int np = g_quad_2d_std.get_num_points(order, e->get_mode());
+          double* jac = rm.get_jacobian(order);
+          double* jwt = new double[np];
+          for (int i = 0; i < np; i++)
+            jwt[i] = pt[i][2] * jac[i];
+
+          Func<Scalar>* u = init_fn(meshfn, order);
+          Func<double>** shapes = new Func<double>*[m];
+          for (int j = 0; j < m; j++)
+          {
+            pss.set_active_shape(distinct_idx[j]);
+            shapes[j] = init_fn(&pss, &rm, order);
+          }
+
+          for (int i = 0; i < m; i++)
+          {
+            for (int j = i; j < m; j++)
+            {
+              double val = 0.;
+              if(inc == 0)
+                for (int k = 0; k < np; k++)
+                  val += jwt[k] * shapes[i]->val[k] * shapes[j]->val[k];
+              else
+                for (int k = 0; k < np; k++)
+                  val += jwt[k] * (shapes[i]->val0[k] * shapes[j]->val0[k] + shapes[i]->val1[k] * shapes[j]->val1[k]);
+              mass[i][j] += val;
+              if(j > i)
+                mass[j][i] += val;
+            }
+            if(inc == 0)
+              for (int k = 0; k < np; k++)
+                rhs[i] += jwt[k] * u->val[k] * shapes[i]->val[k];
+            else
+              for (int k = 0; k < np; k++)
+                rhs[i] += jwt[k] * (u->val0[k] * shapes[i]->val0[k] + u->val1[k] * shapes[i]->val1[k]);
+          }
+
+          for (int j = 0; j < m; j++)
+          {
+            shapes[j]->free_fn();
+            delete shapes[j];
+          }
+          delete [] shapes;
+          u->free_fn();
+          delete u;
+          delete [] jwt;
+        }
+
+        // Eliminate the known part and solve the reduced system for the shapes
+        // carrying unknown basis coefficients.
+        for (int i = 0; i < m; i++)
+          for (int j = 0; j < m; j++)
+            if(known[j] != Scalar(0))
+              rhs[i] -= mass[i][j] * known[j];
+
+        int mu = 0;
+        int* reduced = new int[m];
+        for (int j = 0; j < m; j++)
+          reduced[j] = unknown[j] ? mu++ : -1;
+
+        if(mu > 0)
+        {
+          double** mass_r = Hermes::Algebra::DenseMatrixOperations::new_matrix<double>(mu, mu);
+          Scalar* rhs_r = new Scalar[mu];
+          for (int i = 0; i < m; i++)
+          {
+            if(reduced[i] < 0)
+              continue;
+            rhs_r[reduced[i]] = rhs[i];
+            for (int j = 0; j < m; j++)
+              if(reduced[j] >= 0)
+                mass_r[reduced[i]][reduced[j]] = mass[i][j];
+          }
+
+          int* indx = new int[mu];
+          double d;
+          Hermes::Algebra::DenseMatrixOperations::ludcmp(mass_r, mu, indx, &d);
+          Hermes::Algebra::DenseMatrixOperations::lubksb<Scalar>(mass_r, mu, indx, rhs_r);
+
+          // The coefficients of shapes listed more than once belong to constraining
+          // basis functions of neighbors; they are written by the elements where
+          // they are unconstrained.
+          for (int i = 0; i < cnt; i++)
+            if(al.get_dof()[i] >= 0 && listed[shape_loc[i]] == 1)
+            {
+              sums[al.get_dof()[i]] += rhs_r[reduced[shape_loc[i]]] / al.get_coef()[i];
+              writes[al.get_dof()[i]]++;
+            }
+
+          delete [] indx;
+          delete [] rhs_r;
+          delete [] mass_r;
+        }
+
+        delete [] reduced;
+        delete [] unknown;
+        delete [] listed;
+        delete [] known;
+        delete [] rhs;
+        delete [] mass;
+        delete [] distinct_idx;
+        delete [] shape_loc;
+
+        group_begin = group_end;
+      }
+
+      for (int dof = 0; dof < ndof; dof++)
+        if(writes[dof] > 0)
+          target_vec[dof] = sums[dof] / (double)writes[dof];
+
+      Traverse::free_states(states, num_states);
+      meshfn->set_quad_2d(old_quad);
+      delete [] writes;
+      delete [] sums;
+    }
+
+    template<typename Scalar>
+    void LocalProjection<Scalar>::transfer_to_coarse(const Space<Scalar>* space, Solution<Scalar>* source_sln,
+      Solution<Scalar>* target_sln)
+    {
+      int ndof = space->get_num_dofs();
+      Scalar* coeff_vec = new Scalar[ndof];
+      transfer_to_coarse(space, source_sln, coeff_vec);
+      Solution<Scalar>::vector_to_solution(coeff_vec, space, target_sln);
+      delete [] coeff_vec;
+    }
+
+    template<typename Scalar>
+    void LocalProjection<Scalar>::transfer_to_coarse(Hermes::vector<const Space<Scalar>*> spaces,
+      Hermes::vector<MeshFunction<Scalar>*> meshfns, Scalar* target_vec)
+    {
+      int n = spaces.size();
+
+      // Sanity checks.
+      if(n != meshfns.size()) throw Exceptions::LengthException(1, 2, n, meshfns.size());
+      if(target_vec == NULL) throw Exceptions::NullException(3);
+
+      int start_index = 0;
+      for (int i = 0; i < n; i++)
+      {
+        transfer_to_coarse(spaces[i], meshfns[i], target_vec + start_index);
+        start_index += spaces[i]->get_num_dofs();
+      }
+    }
+
+    template<typename Scalar>
+    void LocalProjection<Scalar>::transfer_to_coarse(Hermes::vector<const Space<Scalar>*> spaces,
+      Hermes::vector<Solution<Scalar>*> source_slns, Hermes::vector<Solution<Scalar>*> target_slns)
+    {
+      int n = spaces.size();
+
+      // Sanity checks.
+      if(n != source_slns.size()) throw Exceptions::LengthException(1, 2, n, source_slns.size());
+      if(n != target_slns.size()) throw Exceptions::LengthException(1, 2, n, target_slns.size());
+
+      for (int i = 0; i < n; i++)
+        transfer_to_coarse(spaces[i], source_slns[i], target_slns[i]);
+    }
+
     template class HERMES_API LocalProjection<double>;
     template class HERMES_API LocalProjection<std::complex<double> >;
   }
@@ -16,6 +16,7 @@
 #include "projections/ogprojection.h"
 #include "space.h"
 #include "linear_solver.h"
+#include "solvers/block_diagonal_matrix.h"
 
 namespace Hermes
 {
@@ -24,6 +25,164 @@ namespace Hermes
     template<typename Scalar>
     OGProjection<Scalar>::OGProjection() : Hermes::Mixins::Loggable(), ndof(0)
     {
+      this->reuse_projection_matrix = false;
+      this->lumped_l2_projection = false;
+      this->block_diagonal_l2_projection = false;
+      this->cached_matrix = NULL;
+      this->cached_rhs = NULL;
+      this->cached_solver = NULL;
+      this->cached_lumped_diagonal = NULL;
+      this->cached_space_seq = -1;
+      this->cached_ndof = -1;
+      this->cached_norm = HERMES_UNSET_NORM;
+    }
+
+    template<typename Scalar>
+    OGProjection<Scalar>::~OGProjection()
+    {
+      free_cache();
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::set_reuse_projection_matrix()
+    {
+      this->reuse_projection_matrix = true;
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::set_lumped_l2_projection()
+    {
+      this->lumped_l2_projection = true;
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::set_block_diagonal_l2_projection()
+    {
+      this->block_diagonal_l2_projection = true;
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::free_cache()
+    {
+      if(cached_solver != NULL)
+      {
+        delete cached_solver;
+        cached_solver = NULL;
+      }
+      if(cached_matrix != NULL)
+      {
+        delete cached_matrix;
+        cached_matrix = NULL;
+      }
+      if(cached_rhs != NULL)
+      {
+        delete cached_rhs;
+        cached_rhs = NULL;
+      }
+      if(cached_lumped_diagonal != NULL)
+      {
+        delete [] cached_lumped_diagonal;
+        cached_lumped_diagonal = NULL;
+      }
+      cached_space_seq = -1;
+      cached_ndof = -1;
+      cached_norm = HERMES_UNSET_NORM;
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::project_cached(const Space<Scalar>* space, WeakForm<Scalar>* wf, Scalar* target_vec, ProjNormType norm)
+    {
+      bool lumping = this->lumped_l2_projection && norm == HERMES_L2_NORM;
+      bool cache_valid = cached_space_seq == space->get_seq() && cached_norm == norm
+        && cached_ndof == space->get_num_dofs()
+        && (lumping ? cached_lumped_diagonal != NULL : cached_solver != NULL);
+
+      if(!cache_valid)
+        free_cache();
+
+      DiscreteProblemLinear<Scalar> dp(wf, space);
+      dp.set_do_not_use_cache();
+
+      if(cached_rhs == NULL)
+        cached_rhs = create_vector<Scalar>();
+
+      if(lumping)
+      {
+        if(!cache_valid)
+        {
+          // Assemble the mass matrix once and lump it: the diagonal entry becomes the
+          // row sum, obtained as the matrix applied to the all-ones vector.
+          cached_matrix = create_matrix<Scalar>();
+          dp.assemble(cached_matrix, cached_rhs);
+
+          Scalar* ones = new Scalar[space->get_num_dofs()];
+          for (int i = 0; i < space->get_num_dofs(); i++)
+            ones[i] = 1.0;
+          cached_lumped_diagonal = new Scalar[space->get_num_dofs()];
+          cached_matrix->multiply_with_vector(ones, cached_lumped_diagonal);
+          delete [] ones;
+
+          // Only the diagonal is kept.
+          delete cached_matrix;
+          cached_matrix = NULL;
+        }
+        else
+        {
+          dp.set_vector_only_fast_path();
+          dp.assemble((SparseMatrix<Scalar>*)NULL, cached_rhs);
+        }
+
+        for (int i = 0; i < space->get_num_dofs(); i++)
+          target_vec[i] = cached_rhs->get(i) / cached_lumped_diagonal[i];
+      }
+      else
+      {
+        if(!cache_valid)
+        {
+          cached_matrix = create_matrix<Scalar>();
+          dp.assemble(cached_matrix, cached_rhs);
+          cached_solver = create_linear_solver<Scalar>(cached_matrix, cached_rhs);
+        }
+        else
+        {
+          dp.set_vector_only_fast_path();
+          dp.assemble((SparseMatrix<Scalar>*)NULL, cached_rhs);
+          cached_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+        }
+
+        cached_solver->solve();
+        for (int i = 0; i < space->get_num_dofs(); i++)
+          target_vec[i] = cached_solver->get_sln_vector()[i];
+      }
+
+      cached_space_seq = space->get_seq();
+      cached_ndof = space->get_num_dofs();
+      cached_norm = norm;
+    }
+
+    template<typename Scalar>
+    void OGProjection<Scalar>::project_block_diagonal(const Space<Scalar>* space, WeakForm<Scalar>* wf, Scalar* target_vec)
+    {
+      int ndof = space->get_num_dofs();
+
+      DiscreteProblemLinear<Scalar> dp(wf, space);
+      dp.set_do_not_use_cache();
+
+      // On an L2 space the mass matrix falls apart into per-element dense
+      // blocks; the assembled blocks are factorized and solved independently
+      // in parallel, no global sparse structure or solver is created.
+      Algebra::BlockDiagonalMatrix<Scalar>* matrix = new Algebra::BlockDiagonalMatrix<Scalar>();
+      Vector<Scalar>* rhs = create_vector<Scalar>();
+      dp.assemble(matrix, rhs);
+
+      Scalar* b = new Scalar[ndof];
+      for (int i = 0; i < ndof; i++)
+        b[i] = rhs->get(i);
+      matrix->solve(b, target_vec);
+
+      delete [] b;
+      delete rhs;
+      delete matrix;
     }
 
     template<typename Scalar>
@@ -135,9 +294,18 @@ namespace Hermes
         ProjNormType proj_norm)
     {
       // Sanity checks.
-      if(target_vec == NULL) 
+      if(target_vec == NULL)
         throw Exceptions::NullException(3);
 
+      // Short-circuit: a Solution built on this very dof assignment is its own
+      // projection in any norm, the remembered coefficients are the result.
+      Solution<Scalar>* source_sln = dynamic_cast<Solution<Scalar>*>(source_meshfn);
+      if(source_sln != NULL && source_sln->has_coeff_vector_for(space))
+      {
+        memcpy(target_vec, source_sln->space_coeffs, sizeof(Scalar) * space->get_num_dofs());
+        return;
+      }
+
       // If projection norm is not provided, set it
       // to match the type of the space.
       ProjNormType norm = HERMES_UNSET_NORM;
@@ -165,7 +333,12 @@ namespace Hermes
       proj_wf->add_vector_form(new ProjectionVectorFormVol(0, norm));
 
       // Call main function.
-      project_internal(space, proj_wf, target_vec);
+      if(this->block_diagonal_l2_projection && norm == HERMES_L2_NORM && space->get_type() == HERMES_L2_SPACE)
+        project_block_diagonal(space, proj_wf, target_vec);
+      else if(this->reuse_projection_matrix || (this->lumped_l2_projection && norm == HERMES_L2_NORM))
+        project_cached(space, proj_wf, target_vec, norm);
+      else
+        project_internal(space, proj_wf, target_vec);
 
       // Clean up.
       delete proj_wf;
@@ -2428,7 +2428,7 @@ namespace Hermes
       // product of 1D quadrature points...
 
       np = sqr(std_np_1d[order]);
-      double3* result = new double3[np];
+      double3* result = new_with_alignment<double3>(np);
       double2* table = std_tables_1d[order];
 
       for (int i = 0, n = 0; i < std_np_1d[order]; i++)
@@ -2447,7 +2447,7 @@ namespace Hermes
     static double3* make_edge_table(double2& v1, double2& v2, int& np, int order)
     {
       np = std_np_1d[order];
-      double3* result = new double3[np];
+      double3* result = new_with_alignment<double3>(np);
       double2* table = std_tables_1d[order];
 
       for (int i = 0; i < np; i++)
@@ -2479,6 +2479,46 @@ namespace Hermes
 
     static int quad_pt_ref = 0;
 
+    void Quad2D::build_soa_tables()
+    {
+      for (int mode = 0; mode < 2; mode++)
+      {
+        soa_tables[mode] = new double*[num_tables[mode]];
+        for (int i = 0; i < num_tables[mode]; i++)
+        {
+          if(tables[mode][i] == NULL)
+          {
+            soa_tables[mode][i] = NULL;
+            continue;
+          }
+          int n = np[mode][i];
+          int stride = (n + soa_pad - 1) & ~(soa_pad - 1);
+          double* block = new_with_alignment<double>(3 * stride);
+          memset(block, 0, 3 * stride * sizeof(double));
+          for (int j = 0; j < n; j++)
+          {
+            block[j] = tables[mode][i][j][0];
+            block[stride + j] = tables[mode][i][j][1];
+            block[2 * stride + j] = tables[mode][i][j][2];
+          }
+          soa_tables[mode][i] = block;
+        }
+      }
+    }
+
+    void Quad2D::free_soa_tables()
+    {
+      for (int mode = 0; mode < 2; mode++)
+      {
+        if(soa_tables[mode] == NULL)
+          continue;
+        for (int i = 0; i < num_tables[mode]; i++)
+          free_with_alignment(soa_tables[mode][i]);
+        delete [] soa_tables[mode];
+        soa_tables[mode] = NULL;
+      }
+    }
+
     Quad2DStd::Quad2DStd()
     {
       ref_vert[0][0][0] = -1.0;
@@ -2531,18 +2571,22 @@ namespace Hermes
 
       tables = std_tables_2d;
       np = std_np_2d;
+
+      // aligned structure-of-arrays copies for vectorized integration kernels
+      build_soa_tables();
     }
 
     Quad2DStd::~Quad2DStd()
     {
       int i;
+      free_soa_tables();
       if(!--quad_pt_ref)
       {
         for (i = 0; i <= 3 * max_order[0] + 2; i++)
-          delete [] std_tables_2d_tri[max_order[0] + 1 + i];
+          free_with_alignment(std_tables_2d_tri[max_order[0] + 1 + i]);
 
         for (i = 0; i <= 5 * max_order[1] + 4; i++)
-          delete [] std_tables_2d_quad[i];
+          free_with_alignment(std_tables_2d_quad[i]);
       }
     }
 
@@ -6,6 +6,7 @@
 #include "quad_all.h"
 #include "element_to_refine.h"
 #include "order_permutator.h"
+#include "instrumentation.h"
 
 namespace Hermes
 {
@@ -21,8 +22,12 @@ namespace Hermes
         warn_uniform_orders(false),
         error_weight_h(H2DRS_DEFAULT_ERR_WEIGHT_H),
         error_weight_p(H2DRS_DEFAULT_ERR_WEIGHT_P),
-        error_weight_aniso(H2DRS_DEFAULT_ERR_WEIGHT_ANISO)
+        error_weight_aniso(H2DRS_DEFAULT_ERR_WEIGHT_ANISO),
+        candidate_eval_caching(false),
+        candidate_eval_delta(1e-3)
       {
+        cand_proj_error_cache = new std::map<int, CandProjErrorCacheEntry*>;
+
         cached_shape_vals_valid = new bool[2];
         cached_shape_ortho_vals = new TrfShape[2];
         cached_shape_vals = new TrfShape[2];
@@ -34,7 +39,10 @@ namespace Hermes
         for(int m = 0; m < H2D_NUM_MODES; m++)
           for(int i = 0; i < H2DRS_MAX_ORDER + 2; i++)
             for(int k = 0; k < H2DRS_MAX_ORDER + 2; k++)
+            {
               proj_matrix_cache[m][i][k] = NULL;
+              proj_matrix_pivot_cache[m][i][k] = NULL;
+            }
 
         //allocate caches
         int max_inx = this->max_shape_inx[0];
@@ -55,6 +63,8 @@ namespace Hermes
             {
               if(proj_matrix_cache[m][i][k] != NULL)
                 delete [] proj_matrix_cache[m][i][k];
+              if(proj_matrix_pivot_cache[m][i][k] != NULL)
+                delete [] proj_matrix_pivot_cache[m][i][k];
             }
         }
 
@@ -63,9 +73,27 @@ namespace Hermes
           delete [] cached_shape_vals_valid;
           delete [] cached_shape_ortho_vals;
           delete [] cached_shape_vals;
+
+          for(typename std::map<int, CandProjErrorCacheEntry*>::iterator it = cand_proj_error_cache->begin(); it != cand_proj_error_cache->end(); it++)
+            delete it->second;
+          delete cand_proj_error_cache;
         }
       }
 
+      template<typename Scalar>
+      void ProjBasedSelector<Scalar>::set_candidate_eval_caching(bool to_set)
+      {
+        candidate_eval_caching = to_set;
+      }
+
+      template<typename Scalar>
+      void ProjBasedSelector<Scalar>::set_candidate_eval_delta(double delta)
+      {
+        if(delta < 0)
+          throw Exceptions::ValueException("delta", delta, 0.0);
+        candidate_eval_delta = delta;
+      }
+
       template<typename Scalar>
       void ProjBasedSelector<Scalar>::set_error_weights(double weight_h, double weight_p, double weight_aniso)
       {
@@ -229,6 +257,40 @@ namespace Hermes
         *dev_error = sqrt(sum_sqr_err/num_processed - Hermes::sqr(*avg_error)); // deviation is square root of variance
       }
 
+      template<typename Scalar>
+      void ProjBasedSelector<Scalar>::precalc_cached_shape_vals(ElementMode2D mode)
+      {
+        if(cached_shape_vals_valid[mode])
+          return;
+
+        // select quadrature, obtain integration points and weights
+        Quad2D* quad = &g_quad_2d_std;
+        double3* gip_points = quad->get_points(H2DRS_INTR_GIP_ORDER, mode);
+        int num_gip_points = quad->get_num_points(H2DRS_INTR_GIP_ORDER, mode);
+
+        //retrieve transformations
+        Trf* trfs = NULL;
+        int num_noni_trfs = 0;
+        if(mode == HERMES_MODE_TRIANGLE)
+        {
+          trfs = tri_trf;
+          num_noni_trfs = H2D_TRF_TRI_NUM;
+        }
+        else
+        {
+          trfs = quad_trf;
+          num_noni_trfs = H2D_TRF_QUAD_NUM;
+        }
+
+#pragma omp critical (cached_shape_vals_valid)
+        if(!cached_shape_vals_valid[mode])
+        {
+          precalc_ortho_shapes(gip_points, num_gip_points, trfs, num_noni_trfs, this->shape_indices[mode], this->max_shape_inx[mode], cached_shape_ortho_vals[mode], mode);
+          precalc_shapes(gip_points, num_gip_points, trfs, num_noni_trfs, this->shape_indices[mode], this->max_shape_inx[mode], cached_shape_vals[mode], mode);
+          cached_shape_vals_valid[mode] = true;
+        }
+      }
+
       template<typename Scalar>
       void ProjBasedSelector<Scalar>::calc_projection_errors(Element* e, const typename OptimumSelector<Scalar>::CandsInfo& info_h, const typename OptimumSelector<Scalar>::CandsInfo& info_p, const  typename OptimumSelector<Scalar>::CandsInfo& info_aniso, Solution<Scalar>* rsln, CandElemProjError herr[H2D_MAX_ELEMENT_SONS], CandElemProjError perr, CandElemProjError anisoerr[H2D_MAX_ELEMENT_SONS])
       {
@@ -280,6 +342,60 @@ namespace Hermes
           }
         }
 
+        // cached candidate errors: with the caching on, skip the projections altogether
+        // when the element looks the same as when its errors were stored, i.e., its
+        // refinement configuration and the examined order ranges match and the reference
+        // solution on it has drifted relatively less than the tolerance. The signature is
+        // a weighted sum of squared magnitudes of the reference solution at the
+        // integration points of the sons.
+        int cand_cache_config[14];
+        double cand_cache_signature = 0.;
+        if(candidate_eval_caching)
+        {
+          cand_cache_config[0] = base_element->active ? 1 : 0;
+          for (int son = 0; son < H2D_MAX_ELEMENT_SONS; son++)
+            cand_cache_config[1 + son] = (base_element->sons[son] == NULL) ? -1 : (int)base_element->sons[son]->id;
+          cand_cache_config[5] = info_h.min_quad_order;
+          cand_cache_config[6] = info_h.max_quad_order;
+          cand_cache_config[7] = info_h.uniform_orders ? 1 : 0;
+          cand_cache_config[8] = info_p.min_quad_order;
+          cand_cache_config[9] = info_p.max_quad_order;
+          cand_cache_config[10] = info_p.uniform_orders ? 1 : 0;
+          cand_cache_config[11] = info_aniso.min_quad_order;
+          cand_cache_config[12] = info_aniso.max_quad_order;
+          cand_cache_config[13] = info_aniso.uniform_orders ? 1 : 0;
+
+          for (int son = 0; son < H2D_MAX_ELEMENT_SONS; son++)
+            for (int k = 0; k < num_gip_points; k++)
+              cand_cache_signature += gip_points[k][H2D_GIP2D_W] * sqr(std::abs(rval[son][0][k]));
+
+          CandProjErrorCacheEntry* cache_entry = NULL;
+          #pragma omp critical (cand_proj_error_cache)
+          {
+            typename std::map<int, CandProjErrorCacheEntry*>::iterator it = cand_proj_error_cache->find(e->id);
+            if(it != cand_proj_error_cache->end())
+            {
+              bool same_config = true;
+              for (int i = 0; i < 14; i++)
+                if(it->second->config[i] != cand_cache_config[i])
+                {
+                  same_config = false;
+                  break;
+                }
+              if(same_config && std::abs(cand_cache_signature - it->second->signature) <= candidate_eval_delta * std::abs(it->second->signature))
+                cache_entry = it->second;
+            }
+          }
+          if(cache_entry != NULL)
+          {
+            memcpy(herr, cache_entry->herr, sizeof(cache_entry->herr));
+            memcpy(perr, cache_entry->perr, sizeof(cache_entry->perr));
+            memcpy(anisoerr, cache_entry->anisoerr, sizeof(cache_entry->anisoerr));
+            HERMES_PROFILE_INCREMENT(candidate_score_reuses);
+            return;
+          }
+        }
+
         //retrieve transformations
         Trf* trfs = NULL;
         int num_noni_trfs = 0;
@@ -297,16 +413,7 @@ namespace Hermes
         // precalculate values of shape functions
         TrfShape empty_shape_vals;
 
-        if(!cached_shape_vals_valid[mode])
-        {
-#pragma omp critical (cached_shape_vals_valid)
-          if(!cached_shape_vals_valid[mode])
-          {
-            precalc_ortho_shapes(gip_points, num_gip_points, trfs, num_noni_trfs, this->shape_indices[mode], this->max_shape_inx[mode], cached_shape_ortho_vals[mode], mode);
-            precalc_shapes(gip_points, num_gip_points, trfs, num_noni_trfs, this->shape_indices[mode], this->max_shape_inx[mode], cached_shape_vals[mode], mode);
-            cached_shape_vals_valid[mode] = true;
-          }
-        }
+        precalc_cached_shape_vals(mode);
 
         //issue a warning if ortho values are defined and the selected cand_list might benefit from that but it cannot because elements do not have uniform orders
         if(!warn_uniform_orders && mode == HERMES_MODE_QUAD && !cached_shape_ortho_vals[mode][H2D_TRF_IDENTITY].empty())
@@ -422,6 +529,24 @@ namespace Hermes
               , info_p, perr);
           }
         }
+
+        // store the calculated errors for the next run of the adaptivity loop
+        if(candidate_eval_caching)
+        {
+          CandProjErrorCacheEntry* new_entry = new CandProjErrorCacheEntry;
+          memcpy(new_entry->config, cand_cache_config, sizeof(cand_cache_config));
+          new_entry->signature = cand_cache_signature;
+          memcpy(new_entry->herr, herr, sizeof(new_entry->herr));
+          memcpy(new_entry->perr, perr, sizeof(new_entry->perr));
+          memcpy(new_entry->anisoerr, anisoerr, sizeof(new_entry->anisoerr));
+          #pragma omp critical (cand_proj_error_cache)
+          {
+            typename std::map<int, CandProjErrorCacheEntry*>::iterator it = cand_proj_error_cache->find(e->id);
+            if(it != cand_proj_error_cache->end())
+              delete it->second;
+            (*cand_proj_error_cache)[e->id] = new_entry;
+          }
+        }
       }
 
       template<typename Scalar>
@@ -437,10 +562,8 @@ namespace Hermes
         int max_num_shapes = this->next_order_shape[mode][this->current_max_order];
         Scalar* right_side = new Scalar[max_num_shapes];
         int* shape_inxs = new int[max_num_shapes];
-        int* indx = new int[max_num_shapes]; //solver data
-        double* d = new double[max_num_shapes]; //solver data
-        double** proj_matrix = new_matrix<double>(max_num_shapes, max_num_shapes);
         ProjMatrixCache& proj_matrices = proj_matrix_cache[mode];
+        ProjMatrixPivotCache& proj_matrix_pivots = proj_matrix_pivot_cache[mode];
         Hermes::vector<typename OptimumSelector<Scalar>::ShapeInx>& full_shape_indices = this->shape_indices[mode];
 
         //check whether ortho-svals are available
@@ -489,12 +612,19 @@ namespace Hermes
           Hermes::vector< ValueCacheItem<Scalar> >& rhs_cache = use_ortho ? ortho_rhs_cache : nonortho_rhs_cache;
           Hermes::vector<TrfShapeExp>** sub_svals = use_ortho ? sub_ortho_svals : sub_nonortho_svals;
 
-          //calculate projection matrix iff no ortho is used
-          if(!use_ortho)
+          //build and factorize the projection matrix iff no ortho is used
+          if(!use_ortho && proj_matrices[order_h][order_v] == NULL)
           {
-            if(proj_matrices[order_h][order_v] == NULL)
-              proj_matrices[order_h][order_v] = build_projection_matrix(gip_points, num_gip_points, shape_inxs, num_shapes, mode);
-            copy_matrix(proj_matrix, proj_matrices[order_h][order_v], num_shapes, num_shapes); //copy projection matrix because original matrix will be modified
+            // The matrix is factorized right away and kept factorized: back
+            // substitution alone is enough for every subsequent evaluation with
+            // this order pair, which makes the non-uniform-order (anisotropic)
+            // candidates as cheap to score as repeated uniform ones.
+            double** matrix = build_projection_matrix(gip_points, num_gip_points, shape_inxs, num_shapes, mode);
+            int* pivots = new int[num_shapes];
+            double d;
+            ludcmp(matrix, num_shapes, pivots, &d);
+            proj_matrices[order_h][order_v] = matrix;
+            proj_matrix_pivots[order_h][order_v] = pivots;
           }
 
           //build right side (fill cache values that are missing)
@@ -528,10 +658,7 @@ namespace Hermes
 
           //solve iff no ortho is used
           if(!use_ortho)
-          {
-            ludcmp(proj_matrix, num_shapes, indx, d);
-            lubksb<Scalar>(proj_matrix, num_shapes, indx, right_side);
-          }
+            lubksb<Scalar>(proj_matrices[order_h][order_v], num_shapes, proj_matrix_pivots[order_h][order_v], right_side);
 
           //calculate error
           double error_squared = 0;
@@ -548,11 +675,8 @@ namespace Hermes
         }
         while (order_perm.next());
 
-        delete [] proj_matrix;
         delete [] right_side;
         delete [] shape_inxs;
-        delete [] indx;
-        delete [] d;
       }
 
       template class HERMES_API ProjBasedSelector<double>;
@@ -15,6 +15,7 @@
 
 #include "runge_kutta.h"
 #include "discrete_problem.h"
+#include "solvers/block_diagonal_matrix.h"
 #include "projections/ogprojection.h"
 #include "projections/localprojection.h"
 #include "weakform_library/weakforms_hcurl.h"
@@ -25,8 +26,10 @@ namespace Hermes
     template<typename Scalar>
     RungeKutta<Scalar>::RungeKutta(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces, ButcherTable* bt)
       : wf(wf), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * spaces.size()),
-      stage_wf_left(spaces.size()), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
-      freeze_jacobian(false), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
+      stage_wf_left(spaces.size()), stage_wf_explicit(spaces.size()), lumped_mass(false), lumped_mass_vector(NULL),
+      block_diagonal_mass(false), block_mass_matrix(NULL),
+      start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
+      freeze_jacobian(false), reuse_jacobian_across_steps(false), jacobian_time_step(-1.0), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
     {
       for(unsigned int i = 0; i < spaces.size(); i++)
       {
@@ -59,13 +62,16 @@ namespace Hermes
 
       this->stage_dp_left = NULL;
       this->stage_dp_right = NULL;
+      this->stage_dp_explicit = NULL;
     }
 
     template<typename Scalar>
     RungeKutta<Scalar>::RungeKutta(const WeakForm<Scalar>* wf, const Space<Scalar>* space, ButcherTable* bt)
       : wf(wf), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * 1),
-      stage_wf_left(1), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
-      freeze_jacobian(false), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
+      stage_wf_left(1), stage_wf_explicit(1), lumped_mass(false), lumped_mass_vector(NULL),
+      block_diagonal_mass(false), block_mass_matrix(NULL),
+      start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
+      freeze_jacobian(false), reuse_jacobian_across_steps(false), jacobian_time_step(-1.0), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
     {
       this->spaces.push_back(space);
       this->spaces_seqs.push_back(space->get_seq());
@@ -93,6 +99,7 @@ namespace Hermes
 
       this->stage_dp_left = NULL;
       this->stage_dp_right = NULL;
+      this->stage_dp_explicit = NULL;
     }
 
     template<typename Scalar>
@@ -127,6 +134,8 @@ namespace Hermes
 
       if(this->stage_dp_left != NULL)
         static_cast<DiscreteProblem<Scalar>*>(this->stage_dp_left)->set_spaces(this->spaces);
+      if(this->stage_dp_explicit != NULL)
+        static_cast<DiscreteProblem<Scalar>*>(this->stage_dp_explicit)->set_spaces(this->spaces);
     }
 
     template<typename Scalar>
@@ -157,6 +166,8 @@ namespace Hermes
 
       if(this->stage_dp_left != NULL)
         static_cast<DiscreteProblem<Scalar>*>(this->stage_dp_left)->set_space(space);
+      if(this->stage_dp_explicit != NULL)
+        static_cast<DiscreteProblem<Scalar>*>(this->stage_dp_explicit)->set_space(space);
     }
 
     template<typename Scalar>
@@ -189,7 +200,13 @@ namespace Hermes
       // in a form suitable for the Newton's method: k_i - f(...) = 0. At the end, matrix_left and vector_left
       // are added to matrix_right and vector_right, respectively.
       this->stage_dp_left = new DiscreteProblem<Scalar>(&stage_wf_left, spaces);
-      
+
+      // The explicit lumped-mass / block-diagonal-mass paths assemble the
+      // stationary residual one stage at a time, over the original
+      // (non-augmented) spaces.
+      if(lumped_mass || block_diagonal_mass)
+        this->stage_dp_explicit = new DiscreteProblem<Scalar>(&stage_wf_explicit, spaces);
+
       // All Spaces of the problem.
       Hermes::vector<const Space<Scalar>*> stage_spaces_vector;
 
@@ -203,6 +220,11 @@ namespace Hermes
 
       stage_dp_right->set_RK(spaces.size());
 
+      // Within one time step the stage spaces stay fixed while the Newton loop
+      // assembles repeatedly, so the stage u_ext Solutions can be retained and
+      // only refreshed with the new stage coefficients.
+      stage_dp_right->set_u_ext_pooling();
+
       // Prepare residuals of stage solutions.
       if(!residual_as_vector)
         for (unsigned int i = 0; i < num_stages; i++)
@@ -228,12 +250,37 @@ namespace Hermes
       this->block_diagonal_jacobian = true;
     }
 
+    template<typename Scalar>
+    void RungeKutta<Scalar>::set_lumped_mass_matrix()
+    {
+      if(this->stage_dp_left != NULL)
+        throw Hermes::Exceptions::Exception("set_lumped_mass_matrix() must be called before the first call to rk_time_step_newton().");
+      if(!bt->is_explicit())
+        throw Hermes::Exceptions::Exception("set_lumped_mass_matrix(): the lumped mass path requires an explicit Butcher's table.");
+      this->lumped_mass = true;
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::set_block_diagonal_mass_matrix()
+    {
+      if(this->stage_dp_left != NULL)
+        throw Hermes::Exceptions::Exception("set_block_diagonal_mass_matrix() must be called before the first call to rk_time_step_newton().");
+      if(!bt->is_explicit())
+        throw Hermes::Exceptions::Exception("set_block_diagonal_mass_matrix(): the block-diagonal mass path requires an explicit Butcher's table.");
+      this->block_diagonal_mass = true;
+    }
+
     template<typename Scalar>
     void RungeKutta<Scalar>::set_freeze_jacobian()
     {
       this->freeze_jacobian = true;
     }
     template<typename Scalar>
+    void RungeKutta<Scalar>::set_reuse_jacobian_across_steps()
+    {
+      this->reuse_jacobian_across_steps = true;
+    }
+    template<typename Scalar>
     void RungeKutta<Scalar>::set_newton_tol(double newton_tol)
     {
       this->newton_tol = newton_tol;
@@ -261,6 +308,12 @@ namespace Hermes
         delete stage_dp_left;
       if(stage_dp_right != NULL)
         delete stage_dp_right;
+      if(stage_dp_explicit != NULL)
+        delete stage_dp_explicit;
+      if(lumped_mass_vector != NULL)
+        delete [] lumped_mass_vector;
+      if(block_mass_matrix != NULL)
+        delete block_mass_matrix;
       delete solver;
       delete matrix_right;
       delete matrix_left;
@@ -329,152 +382,226 @@ namespace Hermes
       // All Spaces of the problem.
       Hermes::vector<const Space<Scalar>*> stage_spaces_vector;
 
-      // Create spaces for stage solutions K_i. This is necessary
-      // to define a num_stages x num_stages block weak formulation.
-      for (unsigned int i = 0; i < num_stages; i++)
-        for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
-        {
-          typename Space<Scalar>::ReferenceSpaceCreator ref_space_creator(spaces[space_i], spaces[space_i]->get_mesh(), 0);
-          stage_spaces_vector.push_back(ref_space_creator.create_ref_space());
-        }
-
-      this->stage_dp_right->set_spaces(stage_spaces_vector);
-
-      // Zero utility vectors.
-      if(start_from_zero_K_vector || !iteration)
-        memset(K_vector, 0, num_stages * ndof * sizeof(Scalar));
-      memset(u_ext_vec, 0, num_stages * ndof * sizeof(Scalar));
-      memset(vector_left, 0, num_stages * ndof * sizeof(Scalar));
-
-      // Assemble the block-diagonal mass matrix M of size ndof times ndof.
-      // The corresponding part of the global residual vector is obtained
-      // just by multiplication with the stage vector K.
-      // FIXME: This should not be repeated if spaces have not changed.
-      stage_dp_left->assemble(matrix_left, NULL);
-
-      // The Newton's loop.
-      double residual_norm;
-      int it = 1;
-      while (true)
+      if(lumped_mass || block_diagonal_mass)
       {
-        // Prepare vector h\sum_{j = 1}^s a_{ij} K_j.
-        prepare_u_ext_vec();
+        // Explicit lumped-mass / block-diagonal-mass paths: no stage Jacobian
+        // is assembled or factorized and no global linear system is solved.
+        // Each stage derivative
+        // k_i = M^{-1} F(t + c_i h, u_n + h sum_{j<i} a_{ij} k_j)
+        // costs one residual assembly and either a division by the lumped
+        // diagonal or the dense per-element block solves.
+        if(block_diagonal_mass)
+          update_block_mass_matrix();
+        else
+          update_lumped_mass_vector();
 
-        // Reinitialize filters.
-        if(this->filters_to_reinit.size() > 0)
-        {
-          Solution<Scalar>::vector_to_solutions(u_ext_vec, spaces, slns_time_new);
+        // Pass the previous time level solutions to the single-stage residual forms.
+        stage_wf_explicit.ext.clear();
+        for(unsigned int slns_time_prev_i = 0; slns_time_prev_i < slns_time_prev.size(); slns_time_prev_i++)
+          stage_wf_explicit.ext.push_back(slns_time_prev[slns_time_prev_i]);
 
-          for(unsigned int filters_i = 0; filters_i < this->filters_to_reinit.size(); filters_i++)
-            filters_to_reinit.at(filters_i)->reinit();
-        }
+        Vector<Scalar>* stage_rhs = create_vector<Scalar>();
+        Scalar* stage_rhs_array = block_diagonal_mass ? new Scalar[ndof] : NULL;
 
-        // Residual corresponding to the stage derivatives k_i in the equation k_i - f(...) = 0.
-        multiply_as_diagonal_block_matrix(matrix_left, num_stages, K_vector, vector_left);
+        for (unsigned int stage_i = 0; stage_i < num_stages; stage_i++)
+        {
+          // Prepare the vector h \sum_{j<i} a_{ij} K_j of this stage; for explicit
+          // tables the sum stops below the diagonal.
+          for (int idx = 0; idx < ndof; idx++)
+          {
+            Scalar increment = 0;
+            for (unsigned int stage_j = 0; stage_j < stage_i; stage_j++)
+              increment += bt->get_A(stage_i, stage_j) * K_vector[stage_j * ndof + idx];
+            u_ext_vec[idx] = this->time_step * increment;
+          }
 
-        // Assemble the block Jacobian matrix of the stationary residual F.
-        // Diagonal blocks are created even if empty, so that matrix_left can be added later.
-        bool force_diagonal_blocks = true;
-        stage_dp_right->assemble(u_ext_vec, NULL, vector_right, force_diagonal_blocks);
+          double stage_time = this->time + bt->get_C(stage_i) * this->time_step;
+          for (unsigned int m = 0; m < stage_wf_explicit.vfvol.size(); m++)
+            stage_wf_explicit.vfvol[m]->set_current_stage_time(stage_time);
+          for (unsigned int m = 0; m < stage_wf_explicit.vfsurf.size(); m++)
+            stage_wf_explicit.vfsurf[m]->set_current_stage_time(stage_time);
 
-        // Finalizing the residual vector.
-        vector_right->add_vector(vector_left);
+          stage_dp_explicit->assemble(u_ext_vec, NULL, stage_rhs, false);
 
-        // Multiply the residual vector with -1 since the matrix
-        // equation reads J(Y^n) \deltaY^{n + 1} = -F(Y^n).
-        vector_right->change_sign();
-        if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
-        {
-          char* fileName = new char[this->RhsFilename.length() + 5];
-          if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), it);
+          // The residual forms carry the scaling factor -1.0, so the assembled
+          // vector is -F and the stage derivative comes out with a plain minus.
+          if(block_diagonal_mass)
+          {
+            for (int idx = 0; idx < ndof; idx++)
+              stage_rhs_array[idx] = -stage_rhs->get(idx);
+            block_mass_matrix->solve(stage_rhs_array, K_vector + stage_i * ndof);
+          }
           else
-            sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
-          FILE* rhs_file = fopen(fileName, "w+");
-          vector_right->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
-          fclose(rhs_file);
+            for (int idx = 0; idx < ndof; idx++)
+              K_vector[stage_i * ndof + idx] = -stage_rhs->get(idx) / lumped_mass_vector[idx];
         }
+        delete stage_rhs;
+        if(stage_rhs_array != NULL)
+          delete [] stage_rhs_array;
+      }
+      else
+      {
+        // Create spaces for stage solutions K_i. This is necessary
+        // to define a num_stages x num_stages block weak formulation.
+        for (unsigned int i = 0; i < num_stages; i++)
+          for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+          {
+            typename Space<Scalar>::ReferenceSpaceCreator ref_space_creator(spaces[space_i], spaces[space_i]->get_mesh(), 0);
+            stage_spaces_vector.push_back(ref_space_creator.create_ref_space());
+          }
 
-        // Measure the residual norm.
-        if(residual_as_vector)
-          // Calculate the l2-norm of residual vector.
-          residual_norm = Global<Scalar>::get_l2_norm(vector_right);
-        else
+        this->stage_dp_right->set_spaces(stage_spaces_vector);
+
+        // Zero utility vectors.
+        if(start_from_zero_K_vector || !iteration)
+          memset(K_vector, 0, num_stages * ndof * sizeof(Scalar));
+        memset(u_ext_vec, 0, num_stages * ndof * sizeof(Scalar));
+        memset(vector_left, 0, num_stages * ndof * sizeof(Scalar));
+
+        // Assemble the block-diagonal mass matrix M of size ndof times ndof.
+        // The corresponding part of the global residual vector is obtained
+        // just by multiplication with the stage vector K.
+        // FIXME: This should not be repeated if spaces have not changed.
+        stage_dp_left->assemble(matrix_left, NULL);
+
+        // With set_reuse_jacobian_across_steps(), the frozen jacobian assembled in a previous
+        // call stays valid - together with its factorization - as long as neither the time
+        // step (which scales the blocks) nor the spaces changed in between.
+        bool jacobian_reusable_from_last_step = false;
+        if(freeze_jacobian && reuse_jacobian_across_steps && this->time_step == jacobian_time_step
+           && jacobian_spaces_seqs.size() == spaces.size())
         {
-          // Translate residual vector into residual functions.
-          Hermes::vector<bool> add_dir_lift_vector;
-          add_dir_lift_vector.reserve(1);
-          add_dir_lift_vector.push_back(false);
-          Solution<Scalar>::vector_to_solutions(vector_right, stage_dp_right->get_spaces(),
-            residuals_vector, false);
-          residual_norm = Global<Scalar>::calc_norms(residuals_vector);
+          jacobian_reusable_from_last_step = true;
+          for(unsigned int i = 0; i < spaces.size(); i++)
+            if(spaces[i]->get_seq() != jacobian_spaces_seqs[i])
+              jacobian_reusable_from_last_step = false;
         }
 
-        // Info for the user.
-        if(it == 1)
-          this->info("\tRunge-Kutta: Newton initial residual norm: %g", residual_norm);
-        else
-          this->info("\tRunge-Kutta: Newton iteration %d, residual norm: %g", it-1, residual_norm);
-
-        // If maximum allowed residual norm is exceeded, fail.
-        if(residual_norm > newton_max_allowed_residual_norm)
+        // The Newton's loop.
+        double residual_norm;
+        int it = 1;
+        while (true)
         {
-          throw Exceptions::ValueException("residual norm", residual_norm, newton_max_allowed_residual_norm);
-        }
+          // Prepare vector h\sum_{j = 1}^s a_{ij} K_j.
+          prepare_u_ext_vec();
 
-        // If residual norm is within tolerance, or the maximum number
-        // of iteration has been reached, or the problem is linear, then quit.
-        if((residual_norm < newton_tol || it > newton_max_iter) && it > 1)
-          break;
+          // Reinitialize filters.
+          if(this->filters_to_reinit.size() > 0)
+          {
+            Solution<Scalar>::vector_to_solutions(u_ext_vec, spaces, slns_time_new);
 
-        bool rhs_only = (freeze_jacobian && it > 1);
-        if(!rhs_only)
-        {
-          // Assemble the block Jacobian matrix of the stationary residual F
-          // Diagonal blocks are created even if empty, so that matrix_left
-          // can be added later.
-          stage_dp_right->assemble(u_ext_vec, matrix_right, NULL, force_diagonal_blocks);
+            for(unsigned int filters_i = 0; filters_i < this->filters_to_reinit.size(); filters_i++)
+              filters_to_reinit.at(filters_i)->reinit();
+          }
+
+          // Residual corresponding to the stage derivatives k_i in the equation k_i - f(...) = 0.
+          multiply_as_diagonal_block_matrix(matrix_left, num_stages, K_vector, vector_left);
 
-          // Adding the block mass matrix M to matrix_right. This completes the
-          // resulting tensor Jacobian.
-          matrix_right->add_sparse_to_diagonal_blocks(num_stages, matrix_left);
+          // Assemble the block Jacobian matrix of the stationary residual F.
+          // Diagonal blocks are created even if empty, so that matrix_left can be added later.
+          bool force_diagonal_blocks = true;
+          stage_dp_right->assemble(u_ext_vec, NULL, vector_right, force_diagonal_blocks);
 
-          if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+          // Finalizing the residual vector.
+          vector_right->add_vector(vector_left);
+
+          // Multiply the residual vector with -1 since the matrix
+          // equation reads J(Y^n) \deltaY^{n + 1} = -F(Y^n).
+          vector_right->change_sign();
+          if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
           {
-            char* fileName = new char[this->matrixFilename.length() + 5];
-            if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-              sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
-            else
-              sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
-            FILE* matrix_file = fopen(fileName, "w+");
-
-            matrix_right->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
-            fclose(matrix_file);
+            FILE* rhs_file = this->open_rhs_file(it);
+            vector_right->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
+            fclose(rhs_file);
           }
 
-          matrix_right->finish();
-        }
-        else
-          solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+          // Measure the residual norm.
+          if(residual_as_vector)
+            // Calculate the l2-norm of residual vector.
+            residual_norm = Global<Scalar>::get_l2_norm(vector_right);
+          else
+          {
+            // Translate residual vector into residual functions.
+            Hermes::vector<bool> add_dir_lift_vector;
+            add_dir_lift_vector.reserve(1);
+            add_dir_lift_vector.push_back(false);
+            Solution<Scalar>::vector_to_solutions(vector_right, stage_dp_right->get_spaces(),
+              residuals_vector, false);
+            residual_norm = Global<Scalar>::calc_norms(residuals_vector);
+          }
 
-        // Solve the linear system.
-        if(!solver->solve())
-          throw Exceptions::LinearMatrixSolverException();
+          // Info for the user.
+          if(it == 1)
+            this->info("\tRunge-Kutta: Newton initial residual norm: %g", residual_norm);
+          else
+            this->info("\tRunge-Kutta: Newton iteration %d, residual norm: %g", it-1, residual_norm);
 
-        // Add \deltaK^{n + 1} to K^n.
-        for (unsigned int i = 0; i < num_stages*ndof; i++)
-          K_vector[i] += newton_damping_coeff * solver->get_sln_vector()[i];
+          // If maximum allowed residual norm is exceeded, fail.
+          if(residual_norm > newton_max_allowed_residual_norm)
+          {
+            throw Exceptions::ValueException("residual norm", residual_norm, newton_max_allowed_residual_norm);
+          }
 
-        // Increase iteration counter.
-        it++;
-      }
+          // If residual norm is within tolerance, or the maximum number
+          // of iteration has been reached, or the problem is linear, then quit.
+          if((residual_norm < newton_tol || it > newton_max_iter) && it > 1)
+            break;
 
-      // If max number of iterations was exceeded, fail.
-      if(it >= newton_max_iter)
-      {
-        this->tick();
-        this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
-        throw Exceptions::ValueException("Newton iterations", it, newton_max_iter);
+          bool rhs_only = (freeze_jacobian && it > 1) || jacobian_reusable_from_last_step;
+          if(!rhs_only)
+          {
+            // Assemble the block Jacobian matrix of the stationary residual F
+            // Diagonal blocks are created even if empty, so that matrix_left
+            // can be added later.
+            stage_dp_right->assemble(u_ext_vec, matrix_right, NULL, force_diagonal_blocks);
+
+            // Adding the block mass matrix M to matrix_right. This completes the
+            // resulting tensor Jacobian.
+            matrix_right->add_sparse_to_diagonal_blocks(num_stages, matrix_left);
+
+            if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+            {
+              FILE* matrix_file = this->open_matrix_file(it);
+              matrix_right->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
+              fclose(matrix_file);
+            }
+
+            matrix_right->finish();
+
+            if(reuse_jacobian_across_steps)
+            {
+              // The spaces (and with them the matrix pattern) may have changed, so the
+              // fresh matrix has to be factorized from scratch; remember what it was
+              // assembled with so that the next call can decide about the reuse.
+              solver->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
+              jacobian_time_step = this->time_step;
+              jacobian_spaces_seqs.clear();
+              for(unsigned int i = 0; i < spaces.size(); i++)
+                jacobian_spaces_seqs.push_back(spaces[i]->get_seq());
+            }
+          }
+          else
+            solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+
+          // Solve the linear system.
+          if(!solver->solve())
+            throw Exceptions::LinearMatrixSolverException();
+
+          // Add \deltaK^{n + 1} to K^n.
+          for (unsigned int i = 0; i < num_stages*ndof; i++)
+            K_vector[i] += newton_damping_coeff * solver->get_sln_vector()[i];
+
+          // Increase iteration counter.
+          it++;
+        }
+
+        // If max number of iterations was exceeded, fail.
+        if(it >= newton_max_iter)
+        {
+          this->tick();
+          this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+          throw Exceptions::ValueException("Newton iterations", it, newton_max_iter);
+        }
       }
 
       // Project previous time level solution on the stage space,
@@ -526,12 +653,12 @@ namespace Hermes
         Solution<Scalar>::vector_to_solutions_common_dir_lift(coeff_vec, spaces, error_fns);
       }
 
-      // Delete stage spaces.
-      for (unsigned int i = 0; i < num_stages * spaces.size(); i++)
+      // Delete stage spaces (the explicit lumped-mass path creates none).
+      for (unsigned int i = 0; i < stage_spaces_vector.size(); i++)
           delete stage_spaces_vector[i];
 
       // Delete all residuals.
-      if(!residual_as_vector)
+      if(!residual_as_vector && !lumped_mass && !block_diagonal_mass)
         for (unsigned int i = 0; i < num_stages; i++)
           delete residuals_vector[i];
 
@@ -576,6 +703,7 @@ namespace Hermes
       // Clear the WeakForms.
       stage_wf_left.delete_all();
       stage_wf_right.delete_all();
+      stage_wf_explicit.delete_all();
 
       // First let's do the mass matrix (only one block ndof times ndof).
       for(unsigned int component_i = 0; component_i < size; component_i++)
@@ -625,6 +753,13 @@ namespace Hermes
           {
             if(block_diagonal_jacobian && i != j) continue;
 
+            // The block (i, j) is scaled by a_{ij} in update_stage_wf(), so a zero
+            // Butcher coefficient makes the whole block vanish - do not create it
+            // at all. For diagonally implicit tables this drops the upper triangle
+            // of the stage Jacobian, for explicit tables the diagonal as well,
+            // which shrinks both the assembling work and the matrix pattern.
+            if(bt->get_A(i, j) == 0.0) continue;
+
             MatrixFormVol<Scalar>* mfv_ij = mfvol_base[m]->clone();
 
             mfv_ij->i = mfv_ij->i + i * spaces.size();
@@ -650,6 +785,9 @@ namespace Hermes
           {
             if(block_diagonal_jacobian && i != j) continue;
 
+            // See the volume forms above - zero Butcher coefficients yield zero blocks.
+            if(bt->get_A(i, j) == 0.0) continue;
+
             MatrixFormSurf<Scalar>* mfs_ij = mfsurf_base[m]->clone();
 
             mfs_ij->i = mfs_ij->i + i * spaces.size();
@@ -703,6 +841,27 @@ namespace Hermes
           stage_wf_right.add_vector_form_surf(vfs_i);
         }
       }
+
+      // The explicit lumped-mass path evaluates the stationary residual one
+      // stage at a time, so its weak formulation holds just a single block of
+      // the vector forms; the stage time is set before each stage evaluation.
+      if(lumped_mass || block_diagonal_mass)
+      {
+        for (unsigned int m = 0; m < vfvol_base.size(); m++)
+        {
+          VectorFormVol<Scalar>* vfv = vfvol_base[m]->clone();
+          vfv->scaling_factor = -1.0;
+          vfv->u_ext_offset = 0;
+          stage_wf_explicit.add_vector_form(vfv);
+        }
+        for (unsigned int m = 0; m < vfsurf_base.size(); m++)
+        {
+          VectorFormSurf<Scalar>* vfs = vfsurf_base[m]->clone();
+          vfs->scaling_factor = -1.0;
+          vfs->u_ext_offset = 0;
+          stage_wf_explicit.add_vector_form_surf(vfs);
+        }
+      }
     }
 
     template<typename Scalar>
@@ -712,6 +871,7 @@ namespace Hermes
       {
         this->stage_wf_left.set_global_integration_order(this->wf->global_integration_order);
         this->stage_wf_right.set_global_integration_order(this->wf->global_integration_order);
+        this->stage_wf_explicit.set_global_integration_order(this->wf->global_integration_order);
       }
 
       // Extracting volume and surface matrix and vector forms from the
@@ -765,6 +925,78 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void RungeKutta<Scalar>::update_lumped_mass_vector()
+    {
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
+      bool up_to_date = (lumped_mass_vector != NULL) && (lumped_mass_spaces_seqs.size() == spaces.size());
+      if(up_to_date)
+        for(unsigned int i = 0; i < spaces.size(); i++)
+          if(spaces[i]->get_seq() != lumped_mass_spaces_seqs[i])
+            up_to_date = false;
+      if(up_to_date)
+        return;
+
+      // Row-sum lumping needs shape functions forming a partition of unity.
+      for(unsigned int i = 0; i < spaces.size(); i++)
+        if(spaces[i]->get_type() != HERMES_H1_SPACE && spaces[i]->get_type() != HERMES_L2_SPACE)
+          throw Hermes::Exceptions::Exception("Mass lumping is only available for H1 and L2 spaces.");
+
+      // One consistent mass matrix assembly per space sequence; the row sums,
+      // obtained by multiplication with the all-ones vector, then form the
+      // lumped diagonal.
+      stage_dp_left->assemble(matrix_left, NULL);
+
+      if(lumped_mass_vector != NULL)
+        delete [] lumped_mass_vector;
+      lumped_mass_vector = new Scalar[ndof];
+
+      Scalar* ones = new Scalar[ndof];
+      for(int i = 0; i < ndof; i++)
+        ones[i] = 1.0;
+      matrix_left->multiply_with_vector(ones, lumped_mass_vector);
+      delete [] ones;
+
+      for(int i = 0; i < ndof; i++)
+        if(lumped_mass_vector[i] == 0.0)
+          throw Hermes::Exceptions::Exception("Mass lumping produced a zero diagonal entry (dof %d).", i);
+
+      lumped_mass_spaces_seqs.clear();
+      for(unsigned int i = 0; i < spaces.size(); i++)
+        lumped_mass_spaces_seqs.push_back(spaces[i]->get_seq());
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::update_block_mass_matrix()
+    {
+      bool up_to_date = (block_mass_matrix != NULL) && (block_mass_spaces_seqs.size() == spaces.size());
+      if(up_to_date)
+        for(unsigned int i = 0; i < spaces.size(); i++)
+          if(spaces[i]->get_seq() != block_mass_spaces_seqs[i])
+            up_to_date = false;
+      if(up_to_date)
+        return;
+
+      // Only on discontinuous spaces is the mass matrix guaranteed to fall
+      // apart into per-element blocks.
+      for(unsigned int i = 0; i < spaces.size(); i++)
+        if(spaces[i]->get_type() != HERMES_L2_SPACE)
+          throw Hermes::Exceptions::Exception("The block-diagonal mass path is only available for L2 spaces.");
+
+      // One mass matrix assembly and batched per-block factorization per
+      // space sequence; the stage solves then reuse the factors.
+      if(block_mass_matrix != NULL)
+        delete block_mass_matrix;
+      block_mass_matrix = new Algebra::BlockDiagonalMatrix<Scalar>();
+      stage_dp_left->assemble(block_mass_matrix, NULL);
+      block_mass_matrix->factorize();
+
+      block_mass_spaces_seqs.clear();
+      for(unsigned int i = 0; i < spaces.size(); i++)
+        block_mass_spaces_seqs.push_back(spaces[i]->get_seq());
+    }
+
     template<typename Scalar>
     void RungeKutta<Scalar>::prepare_u_ext_vec()
     {
@@ -774,10 +1006,13 @@ namespace Hermes
         unsigned int running_space_ndofs = 0;
         for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
         {
+          // For explicit and diagonally implicit tables a_{ij} = 0 for j > i,
+          // so the inner sum can stop at the diagonal.
+          unsigned int last_stage_j = bt->is_fully_implicit() ? num_stages : stage_i + 1;
           for (int idx = 0; idx < spaces[space_i]->get_num_dofs(); idx++)
           {
             Scalar increment = 0;
-            for (unsigned int stage_j = 0; stage_j < num_stages; stage_j++)
+            for (unsigned int stage_j = 0; stage_j < last_stage_j; stage_j++)
               increment += bt->get_A(stage_i, stage_j) * K_vector[stage_j * ndof + running_space_ndofs + idx];
             u_ext_vec[stage_i * ndof + running_space_ndofs + idx] = this->time_step * increment;
           }
@@ -785,7 +1020,120 @@ namespace Hermes
         }
       }
     }
+    template<typename Scalar>
+    RungeKuttaTimeStepController<Scalar>::RungeKuttaTimeStepController(RungeKutta<Scalar>* runge_kutta,
+      ButcherTable* bt, unsigned int order, double tolerance)
+      : runge_kutta(runge_kutta), bt(bt), order(order), tolerance(tolerance), min_time_step(1e-12),
+      max_time_step(1e12), safety_factor(0.9), step_increase_threshold(1.2), last_error(1.0)
+    {
+      if(runge_kutta == NULL)
+        throw Exceptions::NullException(1);
+      if(bt == NULL)
+        throw Exceptions::NullException(2);
+      if(!bt->is_embedded())
+        throw Exceptions::Exception("RungeKuttaTimeStepController: the Butcher table must be embedded (nonzero B2 row).");
+      if(tolerance <= 0.0)
+        throw Exceptions::ValueException("tolerance", tolerance, 0.0);
+
+      // The standard PI exponents scaled by the order of the error estimate.
+      pi_alpha = 0.7 / (order + 1);
+      pi_beta = 0.4 / (order + 1);
+    }
+
+    template<typename Scalar>
+    void RungeKuttaTimeStepController<Scalar>::set_tolerance(double tolerance)
+    {
+      if(tolerance <= 0.0)
+        throw Exceptions::ValueException("tolerance", tolerance, 0.0);
+      this->tolerance = tolerance;
+    }
+
+    template<typename Scalar>
+    void RungeKuttaTimeStepController<Scalar>::set_time_step_bounds(double min_time_step, double max_time_step)
+    {
+      if(min_time_step <= 0.0)
+        throw Exceptions::ValueException("min_time_step", min_time_step, 0.0);
+      if(max_time_step < min_time_step)
+        throw Exceptions::ValueException("max_time_step", max_time_step, min_time_step);
+      this->min_time_step = min_time_step;
+      this->max_time_step = max_time_step;
+    }
+
+    template<typename Scalar>
+    void RungeKuttaTimeStepController<Scalar>::set_safety_factor(double factor)
+    {
+      if(factor <= 0.0 || factor > 1.0)
+        throw Exceptions::ValueException("factor", factor, 0.0, 1.0);
+      this->safety_factor = factor;
+    }
+
+    template<typename Scalar>
+    void RungeKuttaTimeStepController<Scalar>::set_step_increase_threshold(double threshold)
+    {
+      if(threshold <= 1.0)
+        throw Exceptions::ValueException("threshold", threshold, 1.0);
+      this->step_increase_threshold = threshold;
+    }
+
+    template<typename Scalar>
+    double RungeKuttaTimeStepController<Scalar>::do_time_step(Hermes::vector<Solution<Scalar>*> slns_time_prev,
+      Hermes::vector<Solution<Scalar>*> slns_time_new, Hermes::vector<Solution<Scalar>*> error_fns)
+    {
+      while (true)
+      {
+        runge_kutta->rk_time_step_newton(slns_time_prev, slns_time_new, error_fns);
+
+        // Relative temporal error estimate from the embedded B2 row, scaled by the tolerance.
+        double error = Global<Scalar>::calc_norms(error_fns) / Global<Scalar>::calc_norms(slns_time_new) / tolerance;
+        // Keep the error bounded away from zero so that the step size formula stays finite.
+        double limited_error = std::max(error, 1e-4);
+
+        double used_time_step = runge_kutta->time_step;
+        if(error <= 1.0)
+        {
+          // Accepted - propose the next step size by the PI formula. Increases below
+          // the threshold keep the step unchanged, so that runs of equal accepted
+          // steps can reuse the stage matrix factorization (see
+          // RungeKutta::set_reuse_jacobian_across_steps()).
+          double factor = safety_factor * std::pow(limited_error, -pi_alpha) * std::pow(last_error, pi_beta);
+          if(factor > 5.0)
+            factor = 5.0;
+          if(factor > 1.0 && factor < step_increase_threshold)
+            factor = 1.0;
+          double new_time_step = std::min(std::max(used_time_step * factor, min_time_step), max_time_step);
+
+          runge_kutta->set_time(runge_kutta->time + used_time_step);
+          runge_kutta->set_time_step(new_time_step);
+          last_error = limited_error;
+          return used_time_step;
+        }
+
+        // Rejected - shrink the step and repeat from the same previous time level solution.
+        double factor = std::max(safety_factor * std::pow(limited_error, -1.0 / (order + 1)), 0.1);
+        double new_time_step = used_time_step * factor;
+        if(new_time_step < min_time_step)
+          throw Exceptions::Exception("RungeKuttaTimeStepController: the time step fell below the minimum allowed value %g.", min_time_step);
+        this->info("\tRunge-Kutta: step rejected (error estimate %g times over the tolerance), retrying with time step %g.", error, new_time_step);
+        runge_kutta->set_time_step(new_time_step);
+      }
+    }
+
+    template<typename Scalar>
+    double RungeKuttaTimeStepController<Scalar>::do_time_step(Solution<Scalar>* sln_time_prev,
+      Solution<Scalar>* sln_time_new, Solution<Scalar>* error_fn)
+    {
+      Hermes::vector<Solution<Scalar>*> slns_time_prev;
+      slns_time_prev.push_back(sln_time_prev);
+      Hermes::vector<Solution<Scalar>*> slns_time_new;
+      slns_time_new.push_back(sln_time_new);
+      Hermes::vector<Solution<Scalar>*> error_fns;
+      error_fns.push_back(error_fn);
+      return do_time_step(slns_time_prev, slns_time_new, error_fns);
+    }
+
     template class HERMES_API RungeKutta<double>;
     template class HERMES_API RungeKutta<std::complex<double> >;
+    template class HERMES_API RungeKuttaTimeStepController<double>;
+    template class HERMES_API RungeKuttaTimeStepController<std::complex<double> >;
   }
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "quad_all.h"
 #include "precalc.h"
 #include "mesh.h"
+#include "instrumentation.h"
 namespace Hermes
 {
   namespace Hermes2D
@@ -29,6 +30,11 @@ namespace Hermes
       master_pss = NULL;
       num_components = shapeset->get_num_components();
       assert(num_components == 1 || num_components == 2);
+      cache_size_limit = 0;
+      cache_bytes = 0;
+      cache_stamp = 0;
+      active_key = (unsigned) -1;
+      thread_safe_sharing = false;
       update_max_index();
       set_quad_2d(&g_quad_2d_std);
     }
@@ -40,6 +46,11 @@ namespace Hermes
       master_pss = pss;
       shapeset = pss->shapeset;
       num_components = pss->num_components;
+      cache_size_limit = 0;
+      cache_bytes = 0;
+      cache_stamp = 0;
+      active_key = (unsigned) -1;
+      thread_safe_sharing = false;
       update_max_index();
       set_quad_2d(&g_quad_2d_std);
     }
@@ -73,26 +84,190 @@ namespace Hermes
       // Key creation.
       unsigned key = cur_quad | (element->get_mode() << 3) | ((unsigned) (max_index[element->get_mode()] - index) << 4);
 
-      if(master_pss == NULL)
+      PrecalcShapeset* owner = (master_pss == NULL) ? this : master_pss;
+      this->active_key = key;
+
+      if(owner->thread_safe_sharing)
       {
-        if(!tables.present(key))
-          tables.add(new std::map<uint64_t, LightArray<Node*>*>, key);
-        sub_tables = tables.get(key);
+        // Shared tables: the fast path reads without locking, a miss inserts
+        // under the critical section. No LRU bookkeeping here - the stamp map
+        // is not safe for concurrent use and eviction could free tables being
+        // read by another thread.
+        if(owner->tables.present(key))
+          sub_tables = owner->tables.get(key);
+        else
+        {
+#pragma omp critical (precalc_shapeset_tables)
+          {
+            if(!owner->tables.present(key))
+              owner->tables.add(new std::map<uint64_t, LightArray<Node*>*>, key);
+            sub_tables = owner->tables.get(key);
+          }
+        }
       }
       else
       {
-        if(!master_pss->tables.present(key))
-          master_pss->tables.add(new std::map<uint64_t, LightArray<Node*>*>, key);
-        sub_tables = master_pss->tables.get(key);
+        if(!owner->tables.present(key))
+          owner->tables.add(new std::map<uint64_t, LightArray<Node*>*>, key);
+        sub_tables = owner->tables.get(key);
+
+        // Bookkeeping for the optional cache size limit.
+        owner->cache_stamps[key] = ++owner->cache_stamp;
+        if(owner->cache_size_limit > 0 && owner->cache_bytes > owner->cache_size_limit)
+          owner->evict_cache(key);
       }
 
       // Update the Node table.
-      update_nodes_ptr();
+      update_nodes_ptr_shared();
 
       this->index = index;
       order = std::max(H2D_GET_H_ORDER(shapeset->get_order(index, element->get_mode())), H2D_GET_V_ORDER(shapeset->get_order(index, element->get_mode())));
     }
 
+    void PrecalcShapeset::update_nodes_ptr_shared()
+    {
+      PrecalcShapeset* owner = (master_pss == NULL) ? this : master_pss;
+      if(!owner->thread_safe_sharing)
+      {
+        update_nodes_ptr();
+        return;
+      }
+
+      if(sub_idx > H2D_MAX_IDX)
+      {
+        handle_overflow_idx();
+        return;
+      }
+
+      // Fast path: the sub-element tables are immutable once published, so a
+      // hit is always valid, even on a retired copy - its entries are shared
+      // with the current table.
+      std::map<uint64_t, LightArray<Node*>*>::iterator found = sub_tables->find(sub_idx);
+      if(found != sub_tables->end())
+      {
+        nodes = found->second;
+        return;
+      }
+
+#pragma omp critical (precalc_shapeset_tables)
+      {
+        // Re-read the current table - ours may be a stale retired copy.
+        std::map<uint64_t, LightArray<Node*>*>* current = owner->tables.get(active_key);
+        found = current->find(sub_idx);
+        if(found != current->end())
+          nodes = found->second;
+        else
+        {
+          // Build-then-swap: the extended table is fully built before the single
+          // pointer store publishing it, and the table it replaces is retired,
+          // not freed - other threads may still be reading it.
+          std::map<uint64_t, LightArray<Node*>*>* updated = new std::map<uint64_t, LightArray<Node*>*>(*current);
+          nodes = new LightArray<Node*>;
+          updated->insert(std::pair<uint64_t, LightArray<Node*>*>(sub_idx, nodes));
+          owner->tables.add(updated, active_key);
+          owner->retired_sub_tables.push_back(current);
+        }
+        sub_tables = owner->tables.get(active_key);
+      }
+    }
+
+    void PrecalcShapeset::set_quad_order(unsigned int order, int mask)
+    {
+#ifdef WITH_INSTRUMENTATION
+      if(nodes->present(order) && (nodes->get(order)->mask & mask) == mask)
+        HERMES_PROFILE_INCREMENT(pss_cache_hits);
+      else
+        HERMES_PROFILE_INCREMENT(pss_cache_misses);
+#endif
+      PrecalcShapeset* owner = (master_pss == NULL) ? this : master_pss;
+      if(owner->thread_safe_sharing && (overflow_nodes == NULL || nodes != overflow_nodes))
+      {
+        // Unlike the base class version, never re-store cur_node into the shared
+        // table here: another thread may have replaced it meanwhile and re-adding
+        // it could retire the same node twice. precalculate() publishes the nodes
+        // inside the critical section.
+        if(nodes->present(order))
+        {
+          cur_node = nodes->get(order);
+          if((cur_node->mask & mask) != mask)
+            precalculate(order, mask);
+        }
+        else
+        {
+          cur_node = NULL;
+          precalculate(order, mask);
+        }
+      }
+      else
+        Function<double>::set_quad_order(order, mask);
+    }
+
+    void PrecalcShapeset::precalculate_transform_chain(unsigned int order, int mask)
+    {
+      // No tables attached yet, or an overflow chain - only the current level
+      // can be handled.
+      if(sub_tables == NULL || sub_idx > H2D_MAX_IDX)
+      {
+        set_quad_order(order, mask);
+        return;
+      }
+
+      uint64_t chain[H2D_MAX_TRN_LEVEL + 2];
+      int levels = 0;
+      uint64_t idx = sub_idx;
+      while(true)
+      {
+        chain[levels++] = idx;
+        if(idx == 0)
+          break;
+        idx = (idx - 1) >> 3;
+      }
+
+      if(top != levels - 1)
+      {
+        set_quad_order(order, mask);
+        return;
+      }
+
+      for (int i = levels - 1; i >= 0; i--)
+      {
+        this->sub_idx = chain[i];
+        this->ctm = stack + (top - i);
+        update_nodes_ptr_shared();
+        set_quad_order(order, mask);
+      }
+    }
+
+    void PrecalcShapeset::precalculate_shape_block(const int* indices, int num_shapes, int order,
+      double* values, double* dx, double* dy, int component)
+    {
+      Quad2D* quad = get_quad_2d();
+      ElementMode2D mode = element->get_mode();
+      int np = quad->get_num_points(order, mode);
+      double3* pt = quad->get_points(order, mode);
+
+      // apply the sub-element transform to the quadrature points once, for all shapes
+      double* x = new double[np];
+      double* y = new double[np];
+      for (int i = 0; i < np; i++)
+      {
+        x[i] = ctm->m[0] * pt[i][0] + ctm->t[0];
+        y[i] = ctm->m[1] * pt[i][1] + ctm->t[1];
+      }
+
+      for (int s = 0; s < num_shapes; s++)
+      {
+        shapeset->get_values(H2D_FEI_VALUE, indices[s], x, y, np, component, mode, values + s * np);
+        if(dx != NULL)
+          shapeset->get_values(H2D_FEI_DX, indices[s], x, y, np, component, mode, dx + s * np);
+        if(dy != NULL)
+          shapeset->get_values(H2D_FEI_DY, indices[s], x, y, np, component, mode, dy + s * np);
+      }
+
+      delete [] x;
+      delete [] y;
+    }
+
     void PrecalcShapeset::set_active_element(Element* e)
     {
       Transformable::set_active_element(e);
@@ -111,7 +286,16 @@ namespace Hermes
       int newmask = mask | oldmask;
       Node* node = new_node(newmask, np);
 
-      // precalculate all required tables
+      // apply the sub-element transform to the quadrature points once
+      double* x = new double[np];
+      double* y = new double[np];
+      for (i = 0; i < np; i++)
+      {
+        x[i] = ctm->m[0] * pt[i][0] + ctm->t[0];
+        y[i] = ctm->m[1] * pt[i][1] + ctm->t[1];
+      }
+
+      // precalculate all required tables, each by one batch sweep over the points
       for (j = 0; j < num_components; j++)
       {
         for (k = 0; k < 6; k++)
@@ -121,25 +305,301 @@ namespace Hermes
             if(oldmask & idx2mask[k][j])
               memcpy(node->values[j][k], cur_node->values[j][k], np * sizeof(double));
             else
-              for (i = 0; i < np; i++)
-                node->values[j][k][i] = shapeset->get_value(k, index, ctm->m[0] * pt[i][0] + ctm->t[0],
-                ctm->m[1] * pt[i][1] + ctm->t[1], j, element->get_mode());
+              shapeset->get_values(k, index, x, y, np, j, element->get_mode(), node->values[j][k]);
           }
         }
       }
-      if(nodes->present(order))
+
+      delete [] x;
+      delete [] y;
+      // overflow nodes live outside the shared tables and are not accounted for
+      PrecalcShapeset* owner = (master_pss == NULL) ? this : master_pss;
+      bool shared = (overflow_nodes == NULL || nodes != overflow_nodes);
+
+      if(owner->thread_safe_sharing && shared)
+      {
+#pragma omp critical (precalc_shapeset_tables)
+        {
+          // Build-then-swap: the node was fully computed above, publishing it
+          // is a single pointer store. A node computed meanwhile by another
+          // thread is retired, not freed - its readers may still be using it.
+          if(nodes->present(order))
+          {
+            owner->cache_bytes -= nodes->get(order)->size;
+            owner->retired_nodes.push_back(nodes->get(order));
+          }
+          nodes->add(node, order);
+          owner->cache_bytes += node->size;
+        }
+      }
+      else
       {
-        assert(nodes->get(order) == cur_node);
-        ::free(nodes->get(order));
+        if(nodes->present(order))
+        {
+          assert(nodes->get(order) == cur_node);
+          if(shared)
+            owner->cache_bytes -= nodes->get(order)->size;
+          ::free(nodes->get(order));
+        }
+        nodes->add(node, order);
+        if(shared)
+          owner->cache_bytes += node->size;
       }
-      nodes->add(node, order);
       cur_node = node;
     }
 
+    void PrecalcShapeset::set_cache_size_limit(int bytes)
+    {
+      if(master_pss != NULL)
+      {
+        master_pss->set_cache_size_limit(bytes);
+        return;
+      }
+      if(bytes < 0)
+        bytes = 0;
+      cache_size_limit = bytes;
+    }
+
+    int PrecalcShapeset::get_cache_bytes() const
+    {
+      return (master_pss == NULL) ? cache_bytes : master_pss->cache_bytes;
+    }
+
+    size_t PrecalcShapeset::get_memory_bytes() const
+    {
+      return sizeof(*this) + (size_t) get_cache_bytes();
+    }
+
+    static const char H2D_PSS_CACHE_MAGIC[8] = { 'H', '2', 'D', 'P', 'S', 'S', 'C', 0 };
+    static const int H2D_PSS_CACHE_VERSION = 1;
+
+    /// Header of the value table cache file, see PrecalcShapeset::save_cache().
+    struct PssCacheHeader
+    {
+      char magic[8];
+      int version;
+      int shapeset_id;
+      int num_components;
+      int max_order[H2D_NUM_MODES]; ///< Signature of the quadrature tables, per mode.
+      int max_np[H2D_NUM_MODES];
+      int num_records;
+    };
+
+    /// One precalculated Node, identified the same way as in the live tables.
+    struct PssCacheRecord
+    {
+      unsigned key;     ///< Quadrature selector, mode and shape index, see set_active_shape().
+      uint64_t sub_idx; ///< Sub-element transform index.
+      int order;        ///< Integration rule order.
+      int mask;         ///< The precalculated tables, a combination of H2D_FN_XXX.
+      int np;           ///< Point count of the rule, a consistency check on load.
+      int num_doubles;  ///< Length of the data block following the record.
+    };
+
+    void PrecalcShapeset::save_cache(const char* filename)
+    {
+      if(master_pss != NULL)
+      {
+        master_pss->save_cache(filename);
+        return;
+      }
+
+      Quad2D* quad = get_quad_2d();
+
+      PssCacheHeader header;
+      memcpy(header.magic, H2D_PSS_CACHE_MAGIC, sizeof(H2D_PSS_CACHE_MAGIC));
+      header.version = H2D_PSS_CACHE_VERSION;
+      header.shapeset_id = shapeset->get_id();
+      header.num_components = num_components;
+      for (int mode = 0; mode < H2D_NUM_MODES; mode++)
+      {
+        header.max_order[mode] = quad->get_max_order((ElementMode2D) mode);
+        header.max_np[mode] = quad->get_num_points(header.max_order[mode], (ElementMode2D) mode);
+      }
+
+      // Count the stored nodes first, the header carries the count.
+      header.num_records = 0;
+      for (unsigned int i = 0; i < tables.get_size(); i++)
+      {
+        if(!tables.present(i))
+          continue;
+        std::map<uint64_t, LightArray<Node*>*>* sub = tables.get(i);
+        for (std::map<uint64_t, LightArray<Node*>*>::iterator it = sub->begin(); it != sub->end(); ++it)
+          for (unsigned int o = 0; o < it->second->get_size(); o++)
+            if(it->second->present(o))
+              header.num_records++;
+      }
+
+      FILE* f = fopen(filename, "wb");
+      if(f == NULL)
+        throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
+      fwrite(&header, sizeof(PssCacheHeader), 1, f);
+
+      for (unsigned int i = 0; i < tables.get_size(); i++)
+      {
+        if(!tables.present(i))
+          continue;
+        int mode = (i >> 3) & 1;
+        std::map<uint64_t, LightArray<Node*>*>* sub = tables.get(i);
+        for (std::map<uint64_t, LightArray<Node*>*>::iterator it = sub->begin(); it != sub->end(); ++it)
+          for (unsigned int o = 0; o < it->second->get_size(); o++)
+          {
+            if(!it->second->present(o))
+              continue;
+            Node* node = it->second->get(o);
+
+            PssCacheRecord record;
+            record.key = i;
+            record.sub_idx = it->first;
+            record.order = o;
+            record.mask = node->mask;
+            record.np = quad->get_num_points(o, (ElementMode2D) mode);
+            record.num_doubles = (node->size - (sizeof(Node) - sizeof(double))) / sizeof(double);
+
+            fwrite(&record, sizeof(PssCacheRecord), 1, f);
+            fwrite(node->data, sizeof(double), record.num_doubles, f);
+          }
+      }
+      fclose(f);
+    }
+
+    bool PrecalcShapeset::load_cache(const char* filename)
+    {
+      if(master_pss != NULL)
+        return master_pss->load_cache(filename);
+
+      FILE* f = fopen(filename, "rb");
+      if(f == NULL)
+        return false;
+
+      Quad2D* quad = get_quad_2d();
+
+      // A cache written for a different shapeset or quadrature is rejected as
+      // a whole - the tables are then built on demand as usual.
+      PssCacheHeader header;
+      bool ok = fread(&header, sizeof(PssCacheHeader), 1, f) == 1
+        && memcmp(header.magic, H2D_PSS_CACHE_MAGIC, sizeof(H2D_PSS_CACHE_MAGIC)) == 0
+        && header.version == H2D_PSS_CACHE_VERSION
+        && header.shapeset_id == shapeset->get_id()
+        && header.num_components == num_components;
+      for (int mode = 0; ok && mode < H2D_NUM_MODES; mode++)
+        ok = header.max_order[mode] == quad->get_max_order((ElementMode2D) mode)
+          && header.max_np[mode] == quad->get_num_points(header.max_order[mode], (ElementMode2D) mode);
+      if(!ok)
+      {
+        fclose(f);
+        return false;
+      }
+
+      for (int r = 0; r < header.num_records; r++)
+      {
+        PssCacheRecord record;
+        if(fread(&record, sizeof(PssCacheRecord), 1, f) != 1)
+        {
+          fclose(f);
+          return false;
+        }
+        int mode = (record.key >> 3) & 1;
+        if(record.order > quad->get_max_order((ElementMode2D) mode)
+          || record.np != quad->get_num_points(record.order, (ElementMode2D) mode))
+        {
+          fclose(f);
+          return false;
+        }
+
+        Node* node = new_node(record.mask, record.np);
+        if((int) ((node->size - (sizeof(Node) - sizeof(double))) / sizeof(double)) != record.num_doubles
+          || fread(node->data, sizeof(double), record.num_doubles, f) != (size_t) record.num_doubles)
+        {
+          total_mem -= node->size;
+          ::free(node);
+          fclose(f);
+          return false;
+        }
+
+        if(!tables.present(record.key))
+          tables.add(new std::map<uint64_t, LightArray<Node*>*>, record.key);
+        std::map<uint64_t, LightArray<Node*>*>* sub = tables.get(record.key);
+
+        LightArray<Node*>* order_table;
+        std::map<uint64_t, LightArray<Node*>*>::iterator found = sub->find(record.sub_idx);
+        if(found != sub->end())
+          order_table = found->second;
+        else
+        {
+          order_table = new LightArray<Node*>;
+          sub->insert(std::pair<uint64_t, LightArray<Node*>*>(record.sub_idx, order_table));
+        }
+
+        if(order_table->present(record.order))
+        {
+          // Already built (or loaded) in this run, keep the live node.
+          total_mem -= node->size;
+          ::free(node);
+          continue;
+        }
+        order_table->add(node, record.order);
+        cache_bytes += node->size;
+      }
+
+      fclose(f);
+      return true;
+    }
+
+    void PrecalcShapeset::set_thread_safe_sharing(bool to_set)
+    {
+      if(master_pss != NULL)
+      {
+        master_pss->set_thread_safe_sharing(to_set);
+        return;
+      }
+      thread_safe_sharing = to_set;
+    }
+
+    void PrecalcShapeset::evict_cache(unsigned keep_key)
+    {
+      while (cache_bytes > cache_size_limit)
+      {
+        // find the least recently activated shape entry
+        std::map<unsigned, unsigned>::iterator oldest = cache_stamps.end();
+        for(std::map<unsigned, unsigned>::iterator it = cache_stamps.begin(); it != cache_stamps.end(); it++)
+        {
+          if(it->first == keep_key || it->first == active_key)
+            continue;
+          if(oldest == cache_stamps.end() || it->second < oldest->second)
+            oldest = it;
+        }
+        if(oldest == cache_stamps.end())
+          return;
+
+        // free all tables of that shape; the top-level slot stays allocated
+        // (LightArray does not support removal) and holds an empty map
+        if(tables.present(oldest->first))
+        {
+          std::map<uint64_t, LightArray<Node*>*>* sub = tables.get(oldest->first);
+          for(std::map<uint64_t, LightArray<Node*>*>::iterator it = sub->begin(); it != sub->end(); it++)
+          {
+            for(unsigned int k = 0; k < it->second->get_size(); k++)
+              if(it->second->present(k))
+              {
+                cache_bytes -= it->second->get(k)->size;
+                ::free(it->second->get(k));
+              }
+            delete it->second;
+          }
+          sub->clear();
+        }
+        cache_stamps.erase(oldest);
+      }
+    }
+
     void PrecalcShapeset::free()
     {
       if(master_pss != NULL) return;
 
+      cache_bytes = 0;
+      cache_stamps.clear();
+
       for(unsigned int i = 0; i < tables.get_size(); i++)
         if(tables.present(i))
         {
@@ -160,6 +620,16 @@ namespace Hermes
               ::free(overflow_nodes->get(i));
           delete overflow_nodes;
         }
+
+        // retired sub-element tables share their entries with the current
+        // tables released above, so only the map objects are deleted here
+        for(unsigned int i = 0; i < retired_sub_tables.size(); i++)
+          delete retired_sub_tables[i];
+        retired_sub_tables.clear();
+
+        for(unsigned int i = 0; i < retired_nodes.size(); i++)
+          ::free(retired_nodes[i]);
+        retired_nodes.clear();
     }
 
     extern PrecalcShapeset ref_map_pss;
@@ -173,14 +643,14 @@ namespace Hermes
     {
       Transformable::push_transform(son);
       if(sub_tables != NULL)
-        update_nodes_ptr();
+        update_nodes_ptr_shared();
     }
 
     void PrecalcShapeset::pop_transform()
     {
       Transformable::pop_transform();
       if(sub_tables != NULL)
-        update_nodes_ptr();
+        update_nodes_ptr_shared();
     }
 
     int PrecalcShapeset::get_active_shape() const
@@ -15,6 +15,10 @@
 
 #include "global.h"
 #include "shapeset.h"
+#include "shapeset_h1_all.h"
+#include "shapeset_hc_all.h"
+#include "shapeset_hd_all.h"
+#include "shapeset_l2_all.h"
 #include "matrix.h"
 
 using namespace Hermes::Algebra::DenseMatrixOperations;
@@ -165,9 +169,22 @@ namespace Hermes
       return sum;
     }
 
+    Shapeset::Shapeset() : order_cap(-1)
+    {
+    }
+
     Shapeset::~Shapeset() { free_constrained_edge_combinations(); }
 
-    int Shapeset::get_max_order() const { return max_order; }
+    int Shapeset::get_max_order() const { return (order_cap == -1) ? max_order : std::min(max_order, order_cap); }
+
+    void Shapeset::set_order_cap(int cap)
+    {
+      if(cap != -1 && (cap < 1 || cap > max_order))
+        throw Hermes::Exceptions::ValueException("cap", cap, 1, max_order);
+      order_cap = cap;
+    }
+
+    int Shapeset::get_order_cap() const { return order_cap; }
 
     int Shapeset::get_num_components() const { return num_components; }
 
@@ -250,6 +267,29 @@ namespace Hermes
         return get_constrained_value(n, index, x, y, component, mode);
     }
 
+    void Shapeset::get_values(int n, int index, const double* x, const double* y, int np, int component, ElementMode2D mode, double* out)
+    {
+      if(index >= 0)
+      {
+        Shapeset::shape_fn_t** shape_expansion = shape_table[n][mode];
+        if(shape_expansion == NULL)
+        {
+          // let get_value() issue its warning about the undefined expansion
+          for (int i = 0; i < np; i++)
+            out[i] = get_value(n, index, x[i], y[i], component, mode);
+        }
+        else
+        {
+          Shapeset::shape_fn_t fn = shape_expansion[component][index];
+          for (int i = 0; i < np; i++)
+            out[i] = fn(x[i], y[i]);
+        }
+      }
+      else
+        for (int i = 0; i < np; i++)
+          out[i] = get_constrained_value(n, index, x[i], y[i], component, mode);
+    }
+
     double Shapeset::get_fn_value (int index, double x, double y, int component, ElementMode2D mode)  { return get_value(0, index, x, y, component, mode); }
     double Shapeset::get_dx_value (int index, double x, double y, int component, ElementMode2D mode)  { return get_value(1, index, x, y, component, mode); }
     double Shapeset::get_dy_value (int index, double x, double y, int component, ElementMode2D mode)  { return get_value(2, index, x, y, component, mode); }
@@ -262,5 +302,52 @@ namespace Hermes
     {
       return &ref_vert[mode][vertex];
     }
+
+    Shapeset* ShapesetRegistry::shapesets[4] = { NULL, NULL, NULL, NULL };
+
+    Shapeset* ShapesetRegistry::get_default_shapeset(SpaceType type)
+    {
+      if(type != HERMES_H1_SPACE && type != HERMES_HCURL_SPACE && type != HERMES_HDIV_SPACE && type != HERMES_L2_SPACE)
+        throw Hermes::Exceptions::ValueException("type", type, HERMES_H1_SPACE, HERMES_L2_SPACE);
+
+#pragma omp critical (shapeset_registry)
+      {
+        if(shapesets[type] == NULL)
+        {
+          switch(type)
+          {
+          case HERMES_H1_SPACE:
+            shapesets[type] = new H1Shapeset;
+            break;
+          case HERMES_HCURL_SPACE:
+            shapesets[type] = new HcurlShapeset;
+            break;
+          case HERMES_HDIV_SPACE:
+            shapesets[type] = new HdivShapeset;
+            break;
+          case HERMES_L2_SPACE:
+            shapesets[type] = new L2Shapeset;
+            break;
+          default:
+            break;
+          }
+        }
+      }
+
+      return shapesets[type];
+    }
+
+    void ShapesetRegistry::free_shapesets()
+    {
+#pragma omp critical (shapeset_registry)
+      {
+        for (int i = 0; i < 4; i++)
+          if(shapesets[i] != NULL)
+          {
+            delete shapesets[i];
+            shapesets[i] = NULL;
+          }
+      }
+    }
   }
 }
\ No newline at end of file
@@ -31,6 +31,13 @@ namespace Hermes
   {
     unsigned g_space_seq = 0;
 
+    // every bump of a space sequence number is also published centrally
+    static unsigned bump_space_seq(const void* space)
+    {
+      Hermes::HermesChangeBus.publish(Hermes::HERMES_CHANGE_SPACE, space);
+      return g_space_seq++;
+    }
+
 		template<>
 		void Space<double>::init()
 		{
@@ -47,6 +54,18 @@ namespace Hermes
       this->proj_mat = NULL;
       this->chol_p = NULL;
       this->vertex_functions_count = this->edge_functions_count = this->bubble_functions_count = 0;
+      this->bandwidth_reduction = false;
+      this->asm_list_caching = false;
+      this->asm_list_cache_idx = NULL;
+      this->asm_list_cache_dof = NULL;
+      this->asm_list_cache_coef = NULL;
+      this->asm_list_cache_start = NULL;
+      this->asm_list_cache_size = 0;
+      this->asm_list_cache_seq = -1;
+      this->bc_proj_cache_seq = -1;
+      this->bc_proj_cache_valid = false;
+      this->bc_proj_source = NULL;
+      this->order_update_batch = false;
 
 			if(essential_bcs != NULL)
 				for(Hermes::vector<EssentialBoundaryCondition<double>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
@@ -75,6 +94,18 @@ namespace Hermes
       this->proj_mat = NULL;
       this->chol_p = NULL;
       this->vertex_functions_count = this->edge_functions_count = this->bubble_functions_count = 0;
+      this->bandwidth_reduction = false;
+      this->asm_list_caching = false;
+      this->asm_list_cache_idx = NULL;
+      this->asm_list_cache_dof = NULL;
+      this->asm_list_cache_coef = NULL;
+      this->asm_list_cache_start = NULL;
+      this->asm_list_cache_size = 0;
+      this->asm_list_cache_seq = -1;
+      this->bc_proj_cache_seq = -1;
+      this->bc_proj_cache_valid = false;
+      this->bc_proj_source = NULL;
+      this->order_update_batch = false;
 
 			if(essential_bcs != NULL)
 				for(Hermes::vector<EssentialBoundaryCondition<std::complex<double> >*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
@@ -91,6 +122,7 @@ namespace Hermes
 		void Space<double>::free()
 		{
 			free_bc_data();
+			free_asm_list_cache();
 			if(nsize) { ::free(ndata); nsize = 0; ndata = NULL; }
 			if(esize) { ::free(edata); edata = 0; edata = NULL; }
 			this->seq = -1;
@@ -100,6 +132,7 @@ namespace Hermes
 		void Space<std::complex<double> >::free()
 		{
 			free_bc_data();
+			free_asm_list_cache();
 			if(nsize) { ::free(ndata); nsize = 0; ndata = NULL; }
 			if(esize) { ::free(edata); edata = 0; edata = NULL; }
 			this->seq = -1;
@@ -239,6 +272,7 @@ namespace Hermes
       this->free();
       
       this->vertex_functions_count = this->edge_functions_count = this->bubble_functions_count = 0;
+      this->bandwidth_reduction = space->bandwidth_reduction;
 
       this->essential_bcs = space->essential_bcs;
       this->shapeset = space->shapeset->clone();
@@ -246,7 +280,7 @@ namespace Hermes
       new_mesh->copy(space->get_mesh());
       this->mesh = new_mesh;
 
-      this->resize_tables();
+      this->begin_order_updates();
 
       Element* e;
       for_all_active_elements(e, this->mesh)
@@ -254,7 +288,7 @@ namespace Hermes
         this->set_element_order_internal(e->id, space->get_element_order(e->id));
       }
 
-      this->seq = g_space_seq++;
+      this->end_order_updates();
       
       for_all_active_elements(e, this->mesh)
       {
@@ -278,6 +312,15 @@ namespace Hermes
       return ndof;
     }
 
+    template<typename Scalar>
+    size_t Space<Scalar>::get_memory_bytes() const
+    {
+      size_t bytes = sizeof(*this);
+      bytes += (size_t) ndata_allocated * sizeof(NodeData);
+      bytes += (size_t) esize * sizeof(ElementData);
+      return bytes;
+    }
+
     template<typename Scalar>
     int Space<Scalar>::get_max_dof() const
     {
@@ -316,13 +359,32 @@ namespace Hermes
       if(id < 0 || id >= mesh->get_max_element_id())
         throw Hermes::Exceptions::Exception("Space<Scalar>::set_element_order_internal: Invalid element id.");
 
-      resize_tables();
+      // Inside a batched update the tables have been resized by
+      // begin_order_updates() already; only an element created since then
+      // (the mesh refined inside the batch) triggers the resize.
+      if(!order_update_batch || id >= esize)
+        resize_tables();
 
       if(mesh->get_element(id)->is_quad() && get_type() != HERMES_L2_SPACE && H2D_GET_V_ORDER(order) == 0)
         order = H2D_MAKE_QUAD_ORDER(order, order);
 
       edata[id].order = order;
-      seq = g_space_seq++;
+      if(!order_update_batch)
+        seq = bump_space_seq(this);
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::begin_order_updates()
+    {
+      resize_tables();
+      order_update_batch = true;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::end_order_updates()
+    {
+      order_update_batch = false;
+      seq = bump_space_seq(this);
     }
 
     template<typename Scalar>
@@ -379,11 +441,45 @@ namespace Hermes
     {
       int n = spaces.size();
 
+      // The DOF numbering itself is a sequential chain (every space starts numbering
+      // where the previous one ended), but it is cheap. The expensive parts - constraint
+      // resolution and boundary condition projections - only touch their own space,
+      // so they run for the individual spaces concurrently.
       int ndof = 0;
       for (int i = 0; i < n; i++) {
-        ndof += spaces[i]->assign_dofs(ndof);
+        ndof += spaces[i]->assign_dofs_only(ndof);
       }
 
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+      if(num_threads_used > n)
+        num_threads_used = n;
+
+      Hermes::Exceptions::Exception* caughtException = NULL;
+      int i;
+#pragma omp parallel for schedule(dynamic, 1) private(i) num_threads(num_threads_used)
+      for (i = 0; i < n; i++)
+      {
+        try
+        {
+          spaces[i]->finalize_dof_assignment();
+        }
+        catch(Hermes::Exceptions::Exception& e)
+        {
+#pragma omp critical (assign_dofs_exception)
+          if(caughtException == NULL)
+            caughtException = e.clone();
+        }
+        catch(std::exception& e)
+        {
+#pragma omp critical (assign_dofs_exception)
+          if(caughtException == NULL)
+            caughtException = new Hermes::Exceptions::Exception(e.what());
+        }
+      }
+
+      if(caughtException != NULL)
+        throw *caughtException;
+
       return ndof;
     }
 
@@ -426,7 +522,7 @@ namespace Hermes
             ed->order = quad_order;
         }
       }
-      seq = g_space_seq++;
+      seq = bump_space_seq(this);
     }
 
     template<typename Scalar>
@@ -452,6 +548,7 @@ namespace Hermes
     void Space<Scalar>::adjust_element_order(int order_change, int min_order)
     {
       Element* e;
+      begin_order_updates();
       for_all_active_elements(e, this->get_mesh())
       {
         if(e->is_triangle())
@@ -473,12 +570,14 @@ namespace Hermes
           set_element_order_internal(e->id, H2D_MAKE_QUAD_ORDER(h_order, v_order));
         }
       }
+      end_order_updates();
     }
 
     template<typename Scalar>
     void Space<Scalar>::adjust_element_order(int horizontal_order_change, int vertical_order_change, unsigned int horizontal_min_order, unsigned int vertical_min_order)
     {
       Element* e;
+      begin_order_updates();
       for_all_active_elements(e, this->get_mesh())
       {
         if(e->is_triangle())
@@ -492,17 +591,20 @@ namespace Hermes
           else
             set_element_order_internal(e->id, H2D_MAKE_QUAD_ORDER(std::max<int>(H2D_GET_H_ORDER(get_element_order(e->id)) + horizontal_order_change, horizontal_min_order), std::max<int>(H2D_GET_V_ORDER(get_element_order(e->id)) + vertical_order_change, vertical_min_order)));
       }
+      end_order_updates();
     }
 
     template<typename Scalar>
     void Space<Scalar>::update_element_orders_after_refinement()
     {
       Element* e;
+      begin_order_updates();
       for_all_active_elements(e, this->mesh)
       {
         if(this->get_element_order(e->id) < 0)
           this->set_element_order_internal(e->id, this->get_element_order(e->parent->id));
       }
+      end_order_updates();
     }
 
     template<typename Scalar>
@@ -742,7 +844,7 @@ namespace Hermes
     template<typename Scalar>
     void Space<Scalar>::ReferenceSpaceCreator::finish_construction(Space<Scalar>* ref_space)
     {
-      ref_space->seq = g_space_seq++;
+      ref_space->seq = bump_space_seq(ref_space);
 
       Element *e;
       for_all_active_elements(e, coarse_space->get_mesh())
@@ -827,7 +929,7 @@ namespace Hermes
       free();
       this->mesh = mesh;
       this->mesh_seq = mesh->get_seq();
-      seq = g_space_seq++;
+      seq = bump_space_seq(this);
     }
 
     template<typename Scalar>
@@ -853,6 +955,12 @@ namespace Hermes
       return seq;
     }
 
+    template<typename Scalar>
+    bool Space<Scalar>::has_changed_since(int seq) const
+    {
+      return this->seq != seq;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::distribute_orders(Mesh* mesh, int* parents)
     {
@@ -866,13 +974,23 @@ namespace Hermes
           p = std::max(H2D_GET_H_ORDER(p), H2D_GET_V_ORDER(p));
         orders[e->id] = p;
       }
+      begin_order_updates();
       for_all_active_elements(e, mesh)
         set_element_order_internal(e->id, orders[e->id]);
+      end_order_updates();
       delete [] orders;
     }
 
     template<typename Scalar>
     int Space<Scalar>::assign_dofs(int first_dof, int stride)
+    {
+      int ndof = assign_dofs_only(first_dof, stride);
+      finalize_dof_assignment();
+      return ndof;
+    }
+
+    template<typename Scalar>
+    int Space<Scalar>::assign_dofs_only(int first_dof, int stride)
     {
       if(ndata == NULL || edata == NULL || !nsize || !esize)
         return false;
@@ -920,11 +1038,6 @@ namespace Hermes
       assign_edge_dofs();
       assign_bubble_dofs();
 
-      free_bc_data();
-      update_essential_bc_values();
-      update_constraints();
-      post_assign();
-
       mesh_seq = mesh->get_seq();
       was_assigned = this->seq;
       this->ndof = (next_dof - first_dof) / stride;
@@ -933,6 +1046,238 @@ namespace Hermes
       check();
     }
 
+    template<typename Scalar>
+    void Space<Scalar>::finalize_dof_assignment()
+    {
+      // assign_dofs_only() bailed out on this space.
+      if(!is_up_to_date())
+        return;
+
+      if(this->bandwidth_reduction)
+        reorder_dofs_cuthill_mckee();
+
+      free_bc_data();
+      update_essential_bc_values();
+      update_constraints();
+      post_assign();
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::set_bandwidth_reduction(bool to_set)
+    {
+      this->bandwidth_reduction = to_set;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::set_assembly_list_caching(bool to_set)
+    {
+      this->asm_list_caching = to_set;
+      if(!to_set)
+        free_asm_list_cache();
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::free_asm_list_cache()
+    {
+      if(this->asm_list_cache_start == NULL)
+        return;
+      delete [] this->asm_list_cache_idx;
+      delete [] this->asm_list_cache_dof;
+      delete [] this->asm_list_cache_coef;
+      delete [] this->asm_list_cache_start;
+      this->asm_list_cache_idx = NULL;
+      this->asm_list_cache_dof = NULL;
+      this->asm_list_cache_coef = NULL;
+      this->asm_list_cache_start = NULL;
+      this->asm_list_cache_size = 0;
+      this->asm_list_cache_seq = -1;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::build_asm_list_cache()
+    {
+      free_asm_list_cache();
+
+      int max_id = mesh->get_max_element_id();
+      this->asm_list_cache_start = new int[max_id + 1];
+
+      std::vector<int> idx, dof;
+      std::vector<Scalar> coef;
+
+      AsmList<Scalar> al;
+      int pos = 0, next_id = 0;
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        while(next_id <= e->id)
+          this->asm_list_cache_start[next_id++] = pos;
+
+        al.cnt = 0;
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          get_vertex_assembly_list(e, i, &al);
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          get_boundary_assembly_list_internal(e, i, &al);
+        get_bubble_assembly_list(e, &al);
+
+        for(unsigned int i = 0; i < al.cnt; i++, pos++)
+        {
+          idx.push_back(al.idx[i]);
+          dof.push_back(al.dof[i]);
+          coef.push_back(al.coef[i]);
+        }
+      }
+      while(next_id <= max_id)
+        this->asm_list_cache_start[next_id++] = pos;
+
+      this->asm_list_cache_idx = new int[pos];
+      this->asm_list_cache_dof = new int[pos];
+      this->asm_list_cache_coef = new Scalar[pos];
+      for(int i = 0; i < pos; i++)
+      {
+        this->asm_list_cache_idx[i] = idx[i];
+        this->asm_list_cache_dof[i] = dof[i];
+        this->asm_list_cache_coef[i] = coef[i];
+      }
+      this->asm_list_cache_size = max_id;
+      this->asm_list_cache_seq = this->seq;
+    }
+
+    /// Compares two DOF groups by their degree in the connectivity graph. Used for seed
+    /// selection and level sorting in Space<Scalar>::reorder_dofs_cuthill_mckee().
+    struct GroupDegreeCompare
+    {
+      GroupDegreeCompare(const std::vector<std::vector<int> >& adjacency) : adjacency(adjacency) {}
+      bool operator()(int a, int b) const { return adjacency[a].size() < adjacency[b].size(); }
+      const std::vector<std::vector<int> >& adjacency;
+    };
+
+    template<typename Scalar>
+    void Space<Scalar>::reorder_dofs_cuthill_mckee()
+    {
+      // The renumbering works with groups of DOFs belonging to one node or one element
+      // interior, so that each group stays consecutive and the assembly lists can keep
+      // addressing its members as (first group DOF + i * stride).
+      int max_node_id = mesh->get_max_node_id();
+      int max_element_id = mesh->get_max_element_id();
+      int* node_group = new int[max_node_id];
+      int* element_group = new int[max_element_id];
+      for (int i = 0; i < max_node_id; i++)
+        node_group[i] = -1;
+      for (int i = 0; i < max_element_id; i++)
+        element_group[i] = -1;
+
+      // Collect the groups and the list of groups coupled by each active element,
+      // i.e. the connectivity that get_element_assembly_list() implies.
+      std::vector<int> group_node;      // Node id of the group, -1 for element interiors.
+      std::vector<int> group_element;   // Element id for interior groups, -1 otherwise.
+      std::vector<int> group_size;      // Number of DOFs in the group.
+      std::vector<std::vector<int> > element_group_lists;
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        std::vector<int> groups;
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+        {
+          Node* vn = e->vn[i];
+          if(ndata[vn->id].dof >= 0)
+          {
+            if(node_group[vn->id] == -1)
+            {
+              node_group[vn->id] = group_node.size();
+              group_node.push_back(vn->id);
+              group_element.push_back(-1);
+              group_size.push_back(1);
+            }
+            groups.push_back(node_group[vn->id]);
+          }
+          Node* en = e->en[i];
+          if(ndata[en->id].dof >= 0 && ndata[en->id].n > 0)
+          {
+            if(node_group[en->id] == -1)
+            {
+              node_group[en->id] = group_node.size();
+              group_node.push_back(en->id);
+              group_element.push_back(-1);
+              group_size.push_back(ndata[en->id].n);
+            }
+            groups.push_back(node_group[en->id]);
+          }
+        }
+        // H1-type spaces do not initialize the bubble data of elements kept at zero
+        // order, hence the order guard before edata is consulted.
+        if((this->get_element_order(e->id) > 0 || this->get_type() == HERMES_L2_SPACE) && edata[e->id].n > 0)
+        {
+          element_group[e->id] = group_node.size();
+          group_node.push_back(-1);
+          group_element.push_back(e->id);
+          group_size.push_back(edata[e->id].n);
+          groups.push_back(element_group[e->id]);
+        }
+        element_group_lists.push_back(groups);
+      }
+
+      int num_groups = group_node.size();
+      std::vector<std::vector<int> > adjacency(num_groups);
+      for (unsigned int i = 0; i < element_group_lists.size(); i++)
+        for (unsigned int j = 0; j < element_group_lists[i].size(); j++)
+          for (unsigned int k = 0; k < element_group_lists[i].size(); k++)
+            if(j != k)
+              adjacency[element_group_lists[i][j]].push_back(element_group_lists[i][k]);
+      for (int i = 0; i < num_groups; i++)
+      {
+        std::sort(adjacency[i].begin(), adjacency[i].end());
+        adjacency[i].erase(std::unique(adjacency[i].begin(), adjacency[i].end()), adjacency[i].end());
+      }
+
+      // Cuthill-McKee: breadth-first traversal started from a minimum-degree group of
+      // each component, the neighbors of every group visited in the order of ascending
+      // degree. The final numbering reverses the traversal order.
+      GroupDegreeCompare degree_compare(adjacency);
+      std::vector<int> order;
+      order.reserve(num_groups);
+      std::vector<bool> visited(num_groups, false);
+      unsigned int processed = 0;
+      while ((int) order.size() < num_groups)
+      {
+        int seed = -1;
+        for (int i = 0; i < num_groups; i++)
+          if(!visited[i] && (seed == -1 || adjacency[i].size() < adjacency[seed].size()))
+            seed = i;
+        visited[seed] = true;
+        order.push_back(seed);
+        while (processed < order.size())
+        {
+          int current = order[processed++];
+          std::vector<int> neighbors;
+          for (unsigned int i = 0; i < adjacency[current].size(); i++)
+            if(!visited[adjacency[current][i]])
+            {
+              visited[adjacency[current][i]] = true;
+              neighbors.push_back(adjacency[current][i]);
+            }
+          std::sort(neighbors.begin(), neighbors.end(), degree_compare);
+          for (unsigned int i = 0; i < neighbors.size(); i++)
+            order.push_back(neighbors[i]);
+        }
+      }
+
+      // Hand out the new starting DOFs in reverse traversal order.
+      int dof = this->first_dof;
+      for (int i = num_groups - 1; i >= 0; i--)
+      {
+        int group = order[i];
+        if(group_node[group] != -1)
+          ndata[group_node[group]].dof = dof;
+        else
+          edata[group_element[group]].bdof = dof;
+        dof += group_size[group] * this->stride;
+      }
+      assert(dof == this->next_dof);
+
+      delete [] node_group;
+      delete [] element_group;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::reset_dof_assignment()
     {
@@ -994,13 +1339,38 @@ namespace Hermes
         throw Hermes::Exceptions::Exception("The space in get_element_assembly_list() is out of date. You need to update it with assign_dofs()"
         " any time the mesh changes.");
 
-      // add vertex, edge and bubble functions to the assembly list
-      al->cnt = 0;
-      for (unsigned int i = 0; i < e->get_nvert(); i++)
-        get_vertex_assembly_list(e, i, al);
-      for (unsigned int i = 0; i < e->get_nvert(); i++)
-        get_boundary_assembly_list_internal(e, i, al);
-      get_bubble_assembly_list(e, al);
+      if(this->asm_list_caching)
+      {
+        // The assembly runs this from several threads, the cache must only be built once.
+        if(this->asm_list_cache_start == NULL || this->asm_list_cache_seq != this->seq)
+        {
+#pragma omp critical (build_asm_list_cache)
+          {
+            if(this->asm_list_cache_start == NULL || this->asm_list_cache_seq != this->seq)
+              const_cast<Space<Scalar>*>(this)->build_asm_list_cache();
+          }
+        }
+
+        // copy the cached triplets
+        int start = this->asm_list_cache_start[e->id];
+        unsigned int cnt = this->asm_list_cache_start[e->id + 1] - start;
+        while(al->cap < cnt)
+          al->enlarge();
+        memcpy(al->idx, this->asm_list_cache_idx + start, cnt * sizeof(int));
+        memcpy(al->dof, this->asm_list_cache_dof + start, cnt * sizeof(int));
+        memcpy(al->coef, this->asm_list_cache_coef + start, cnt * sizeof(Scalar));
+        al->cnt = cnt;
+      }
+      else
+      {
+        // add vertex, edge and bubble functions to the assembly list
+        al->cnt = 0;
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          get_vertex_assembly_list(e, i, al);
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          get_boundary_assembly_list_internal(e, i, al);
+        get_bubble_assembly_list(e, al);
+      }
       for(unsigned int i = 0; i < al->cnt; i++)
         if(al->dof[i] >= 0)
           al->dof[i] += first_dof;
@@ -1038,10 +1408,22 @@ namespace Hermes
       this->essential_bcs = essential_bcs;
     }
 
+    template<typename Scalar>
+    void Space<Scalar>::set_bc_projection_source(Space<Scalar>* source)
+    {
+      if(source == this)
+        throw Hermes::Exceptions::Exception("A space cannot be its own source of essential BC projections.");
+      if(source != NULL && source->get_mesh() != this->mesh)
+        throw Hermes::Exceptions::Exception("The source of essential BC projections has to use the same mesh.");
+      this->bc_proj_source = source;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::precalculate_projection_matrix(int nv, double**& mat, double*& p)
     {
-      int n = shapeset->get_max_order() + 1 - nv;
+      // Deliberately not get_max_order(): the matrix is precalculated once, so it has to
+      // cover the full degree range even when an order cap is (temporarily) in effect.
+      int n = shapeset->max_order + 1 - nv;
       mat = new_matrix<double>(n, n);
       int component = (get_type() == HERMES_HDIV_SPACE) ? 1 : 0;
 
@@ -1085,8 +1467,42 @@ namespace Hermes
             {
               int order = get_edge_order_internal(en);
               surf_pos->marker = en->marker;
-              nd->edge_bc_proj = get_bc_projection(surf_pos, order, bc);
-              bc_data.push_back(nd->edge_bc_proj);
+              if(bc->is_time_invariant())
+              {
+                // time-invariant condition: reuse the projection computed in a
+                // previous run, if the space has not changed since
+                typename std::map<int, Scalar*>::iterator it = bc_proj_cache.find(en->id);
+                if(it != bc_proj_cache.end())
+                  nd->edge_bc_proj = it->second;
+                else
+                {
+                  // a projection the source space has already computed for the very same
+                  // condition, shapeset and order can be taken over directly
+                  // (\sa set_bc_projection_source())
+                  if(bc_proj_source != NULL && bc_proj_source->bc_proj_cache_seq == bc_proj_source->seq
+                     && bc_proj_source->get_type() == this->get_type()
+                     && bc_proj_source->shapeset->get_id() == this->shapeset->get_id()
+                     && bc_proj_source->essential_bcs != NULL
+                     && bc_proj_source->essential_bcs->get_boundary_condition(this->mesh->boundary_markers_conversion.get_user_marker(en->marker).marker) == bc
+                     && bc_proj_source->get_edge_order_internal(en) == order)
+                  {
+                    typename std::map<int, Scalar*>::iterator source_it = bc_proj_source->bc_proj_cache.find(en->id);
+                    if(source_it != bc_proj_source->bc_proj_cache.end())
+                    {
+                      nd->edge_bc_proj = new Scalar[order + 1];
+                      memcpy(nd->edge_bc_proj, source_it->second, (order + 1) * sizeof(Scalar));
+                    }
+                  }
+                  if(nd->edge_bc_proj == NULL)
+                    nd->edge_bc_proj = get_bc_projection(surf_pos, order, bc);
+                  bc_proj_cache[en->id] = nd->edge_bc_proj;
+                }
+              }
+              else
+              {
+                nd->edge_bc_proj = get_bc_projection(surf_pos, order, bc);
+                bc_data.push_back(nd->edge_bc_proj);
+              }
 
               int i = surf_pos->surf_num, j = e->next_vert(i);
               ndata[e->vn[i]->id].vertex_bc_coef = nd->edge_bc_proj + 0;
@@ -1113,6 +1529,31 @@ namespace Hermes
     template<typename Scalar>
     void Space<Scalar>::update_essential_bc_values()
     {
+      // the space has changed - the cached projections do not apply any more
+      if(bc_proj_cache_seq != this->seq)
+      {
+        for (typename std::map<int, Scalar*>::iterator it = bc_proj_cache.begin(); it != bc_proj_cache.end(); it++)
+          delete [] it->second;
+        bc_proj_cache.clear();
+        bc_proj_cache_seq = this->seq;
+        bc_proj_cache_valid = false;
+      }
+
+      // with only time-invariant conditions and an unchanged space there is
+      // nothing to re-evaluate
+      if(bc_proj_cache_valid && essential_bcs != NULL)
+      {
+        bool invariant_only = true;
+        for (typename Hermes::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
+          if(!(*it)->is_time_invariant())
+            invariant_only = false;
+        if(invariant_only)
+          return;
+      }
+
+      // The cached assembly lists hold the essential BC coefficients.
+      free_asm_list_cache();
+
       Element* e;
       for_all_base_elements(e, mesh)
       {
@@ -1126,6 +1567,8 @@ namespace Hermes
           }
         }
       }
+
+      bc_proj_cache_valid = true;
     }
 
     template<typename Scalar>
@@ -1134,6 +1577,11 @@ namespace Hermes
       for (unsigned int i = 0; i < bc_data.size(); i++)
         delete [] bc_data[i];
       bc_data.clear();
+
+      for (typename std::map<int, Scalar*>::iterator it = bc_proj_cache.begin(); it != bc_proj_cache.end(); it++)
+        delete [] it->second;
+      bc_proj_cache.clear();
+      bc_proj_cache_valid = false;
     }
 
     template<typename Scalar>
@@ -1308,7 +1756,7 @@ namespace Hermes
           space->edata[parsed_xml_space->element_data().at(elem_data_i).e_id()].changed_in_last_adaptation = parsed_xml_space->element_data().at(elem_data_i).chgd();
         }
 
-        space->seq = g_space_seq++;
+        space->seq = bump_space_seq(space);
 
         space->assign_dofs();
 
@@ -1320,6 +1768,338 @@ namespace Hermes
       }
     }
 
+    static const char H2D_SPACE_BIN_MAGIC[8] = { 'H', '2', 'D', 'S', 'P', 'A', 'C' };
+    static const int H2D_SPACE_BIN_VERSION = 2;
+
+    template<typename Scalar>
+    bool Space<Scalar>::save_bin(const char *filename) const
+    {
+      this->check();
+
+      switch(this->get_type())
+      {
+        case HERMES_H1_SPACE:
+        case HERMES_HCURL_SPACE:
+        case HERMES_HDIV_SPACE:
+        case HERMES_L2_SPACE:
+          break;
+        default:
+          return false;
+      }
+
+      FILE* f = fopen(filename, "wb");
+      if(f == NULL)
+        return false;
+
+      int header[3];
+      header[0] = H2D_SPACE_BIN_VERSION;
+      header[1] = (int) this->get_type();
+      header[2] = 0;
+
+      // Utility pointer.
+      Element *e;
+      for_all_elements(e, this->get_mesh())
+        header[2]++;
+
+      fwrite(H2D_SPACE_BIN_MAGIC, 1, sizeof(H2D_SPACE_BIN_MAGIC), f);
+      fwrite(header, sizeof(int), 3, f);
+
+      // Since version 2, the resolved DOF numbering follows, so that load_bin() can
+      // skip the whole assign_dofs() numbering on an unchanged mesh. The first two
+      // entries stamp the mesh structure the numbering belongs to.
+      int max_node_id = this->get_mesh()->get_max_node_id();
+      int extra[10];
+      extra[0] = max_node_id;
+      extra[1] = this->get_mesh()->get_max_element_id();
+      extra[2] = this->ndof;
+      extra[3] = this->first_dof;
+      extra[4] = this->next_dof;
+      extra[5] = this->stride;
+      extra[6] = this->vertex_functions_count;
+      extra[7] = this->edge_functions_count;
+      extra[8] = this->bubble_functions_count;
+      extra[9] = 0;
+      fwrite(extra, sizeof(int), 10, f);
+
+      for_all_elements(e, this->get_mesh())
+      {
+        int record[5];
+        record[0] = e->id;
+        record[1] = this->edata[e->id].order;
+        record[2] = this->edata[e->id].bdof;
+        record[3] = this->edata[e->id].n;
+        record[4] = this->edata[e->id].changed_in_last_adaptation ? 1 : 0;
+        fwrite(record, sizeof(int), 5, f);
+      }
+
+      // The per-node DOF numbers. For nodes constrained by the mesh refinement
+      // configuration the table holds pointers set up by update_constraints() - those
+      // are written out as the canonical pre-constraint markers instead, which is what
+      // the entries held right after the numbering. update_constraints() rebuilds the
+      // pointers from them on load without reading the previous contents.
+      int* node_dof = new int[max_node_id];
+      int* node_n = new int[max_node_id];
+      for (int i = 0; i < max_node_id; i++)
+      {
+        node_dof[i] = H2D_UNASSIGNED_DOF;
+        node_n[i] = 1;
+      }
+      Node* node;
+      for_all_vertex_nodes(node, this->get_mesh())
+      {
+        if(node->is_constrained_vertex())
+          continue;
+        node_dof[node->id] = this->ndata[node->id].dof;
+        node_n[node->id] = this->ndata[node->id].n;
+      }
+      for_all_edge_nodes(node, this->get_mesh())
+      {
+        // The unconstrained-edge condition of assign_edge_dofs().
+        if(node->ref > 1 || node->bnd || this->get_mesh()->peek_vertex_node(node->p1, node->p2) != NULL)
+        {
+          node_dof[node->id] = this->ndata[node->id].dof;
+          node_n[node->id] = this->ndata[node->id].n;
+        }
+        else
+          node_n[node->id] = -1;
+      }
+      fwrite(node_dof, sizeof(int), max_node_id, f);
+      fwrite(node_n, sizeof(int), max_node_id, f);
+      delete [] node_dof;
+      delete [] node_n;
+
+      bool ok = !ferror(f);
+      fclose(f);
+      return ok;
+    }
+
+    template<typename Scalar>
+    Space<Scalar>* Space<Scalar>::load_bin(const char *filename, Mesh* mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      FILE* f = fopen(filename, "rb");
+      if(f == NULL)
+        throw Hermes::Exceptions::SpaceLoadFailureException("Space file %s not found.", filename);
+
+      char magic[8];
+      int header[3];
+      if(fread(magic, 1, sizeof(magic), f) != sizeof(magic) || memcmp(magic, H2D_SPACE_BIN_MAGIC, sizeof(magic)) != 0)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SpaceLoadFailureException("File %s: not a Hermes2D binary space file.", filename);
+      }
+      if(fread(header, sizeof(int), 3, f) != 3)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SpaceLoadFailureException("File %s: truncated binary space file.", filename);
+      }
+      if(header[0] != 1 && header[0] != H2D_SPACE_BIN_VERSION)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SpaceLoadFailureException("File %s: unsupported binary space format version %d.", filename, header[0]);
+      }
+
+      // Version 2 carries the resolved DOF numbering.
+      int extra[10];
+      bool has_dof_tables = header[0] >= 2;
+      if(has_dof_tables && fread(extra, sizeof(int), 10, f) != 10)
+      {
+        fclose(f);
+        throw Hermes::Exceptions::SpaceLoadFailureException("File %s: truncated binary space file.", filename);
+      }
+
+      Space<Scalar>* space;
+      switch((SpaceType) header[1])
+      {
+      case HERMES_H1_SPACE:
+        space = new H1Space<Scalar>();
+        space->mesh = mesh;
+
+        if(shapeset == NULL)
+        {
+          space->shapeset = new H1Shapeset;
+          space->own_shapeset = true;
+        }
+        else
+        {
+          if(shapeset->get_space_type() != HERMES_H1_SPACE)
+          {
+            fclose(f);
+            throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the binary space file %s in Space::load_bin.", filename);
+          }
+          else
+            space->shapeset = shapeset;
+        }
+
+        space->precalculate_projection_matrix(2, space->proj_mat, space->chol_p);
+        break;
+      case HERMES_HCURL_SPACE:
+        space = new HcurlSpace<Scalar>();
+        space->mesh = mesh;
+
+        if(shapeset == NULL)
+        {
+          space->shapeset = new HcurlShapeset;
+          space->own_shapeset = true;
+        }
+        else
+        {
+          if(shapeset->get_num_components() < 2)
+          {
+            fclose(f);
+            throw Hermes::Exceptions::Exception("HcurlSpace requires a vector shapeset in Space::load_bin.");
+          }
+          if(shapeset->get_space_type() != HERMES_HCURL_SPACE)
+          {
+            fclose(f);
+            throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the binary space file %s in Space::load_bin.", filename);
+          }
+          else
+            space->shapeset = shapeset;
+        }
+
+        space->precalculate_projection_matrix(0, space->proj_mat, space->chol_p);
+        break;
+      case HERMES_HDIV_SPACE:
+        space = new HdivSpace<Scalar>();
+        space->mesh = mesh;
+
+        if(shapeset == NULL)
+        {
+          space->shapeset = new HdivShapeset;
+          space->own_shapeset = true;
+        }
+        else
+        {
+          if(shapeset->get_num_components() < 2)
+          {
+            fclose(f);
+            throw Hermes::Exceptions::Exception("HdivSpace requires a vector shapeset in Space::load_bin.");
+          }
+          if(shapeset->get_space_type() != HERMES_HDIV_SPACE)
+          {
+            fclose(f);
+            throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the binary space file %s in Space::load_bin.", filename);
+          }
+          else
+            space->shapeset = shapeset;
+        }
+
+        space->precalculate_projection_matrix(0, space->proj_mat, space->chol_p);
+        break;
+      case HERMES_L2_SPACE:
+        space = new L2Space<Scalar>();
+        space->mesh = mesh;
+
+        if(shapeset == NULL)
+        {
+          space->shapeset = new L2Shapeset;
+          space->own_shapeset = true;
+        }
+        else
+        {
+          if(shapeset->get_space_type() != HERMES_L2_SPACE)
+          {
+            fclose(f);
+            throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the binary space file %s in Space::load_bin.", filename);
+          }
+          else
+            space->shapeset = shapeset;
+        }
+
+        static_cast<L2Space<Scalar>*>(space)->ldata = NULL;
+        static_cast<L2Space<Scalar>*>(space)->lsize = 0;
+        break;
+      default:
+        fclose(f);
+        throw Exceptions::SpaceLoadFailureException("Wrong spaceType in the binary space file %s in Space::load_bin.", filename);
+      }
+
+      space->essential_bcs = essential_bcs;
+      space->mesh_seq = space->mesh->get_seq();
+
+      // L2 space does not have any (strong) essential BCs.
+      if(essential_bcs != NULL && (SpaceType) header[1] != HERMES_L2_SPACE)
+        for(typename Hermes::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
+          for(unsigned int i = 0; i < (*it)->markers.size(); i++)
+            if(space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.find((*it)->markers.at(i)) == space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.end())
+            {
+              fclose(f);
+              throw Hermes::Exceptions::Exception("A boundary condition defined on a non-existent marker.");
+            }
+
+      space->resize_tables();
+
+      // Element data //
+      for (int elem_data_i = 0; elem_data_i < header[2]; elem_data_i++)
+      {
+        int record[5];
+        if(fread(record, sizeof(int), 5, f) != 5)
+        {
+          fclose(f);
+          throw Hermes::Exceptions::SpaceLoadFailureException("File %s: truncated binary space file.", filename);
+        }
+        space->edata[record[0]].order = record[1];
+        space->edata[record[0]].bdof = record[2];
+        space->edata[record[0]].n = record[3];
+        space->edata[record[0]].changed_in_last_adaptation = record[4] != 0;
+      }
+
+      space->seq = bump_space_seq(space);
+
+      // The fast path: when the mesh has the same structure as the one the space was
+      // saved with, the stored numbering is taken over directly and only the pointer
+      // tables (boundary condition projections and constraint coefficient lists) are
+      // rebuilt. Otherwise the numbering is thrown away and recomputed.
+      if(has_dof_tables && extra[0] == mesh->get_max_node_id() && extra[1] == mesh->get_max_element_id())
+      {
+        int max_node_id = extra[0];
+        int* node_dof = new int[max_node_id];
+        int* node_n = new int[max_node_id];
+        if(fread(node_dof, sizeof(int), max_node_id, f) != (size_t) max_node_id
+          || fread(node_n, sizeof(int), max_node_id, f) != (size_t) max_node_id)
+        {
+          delete [] node_dof;
+          delete [] node_n;
+          fclose(f);
+          throw Hermes::Exceptions::SpaceLoadFailureException("File %s: truncated binary space file.", filename);
+        }
+        fclose(f);
+
+        for (int i = 0; i < max_node_id; i++)
+        {
+          space->ndata[i].dof = node_dof[i];
+          space->ndata[i].n = node_n[i];
+        }
+        delete [] node_dof;
+        delete [] node_n;
+
+        space->ndof = extra[2];
+        space->first_dof = extra[3];
+        space->next_dof = extra[4];
+        space->stride = extra[5];
+        space->vertex_functions_count = extra[6];
+        space->edge_functions_count = extra[7];
+        space->bubble_functions_count = extra[8];
+        space->mesh_seq = mesh->get_seq();
+        space->was_assigned = space->seq;
+
+        // The same finalization assign_dofs() runs after the numbering, except for the
+        // bandwidth-reducing reordering: the stored numbering already contains it if it
+        // was on when the space was saved, reapplying it would permute the DOFs again.
+        space->free_bc_data();
+        space->update_essential_bc_values();
+        space->update_constraints();
+        space->post_assign();
+      }
+      else
+      {
+        fclose(f);
+        space->assign_dofs();
+      }
+
+      return space;
+    }
+
     template class HERMES_API Space<double>;
     template class HERMES_API Space<std::complex<double> >;
   }
@@ -18,18 +18,26 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    /// Granularity of the pooled baselist storage, in BaseComponents.
+    static const int H2D_BASELIST_POOL_CHUNK = 1024;
+
     template<typename Scalar>
     H1Space<Scalar>::H1Space() : Space<Scalar>()
     {
+      this->baselist_pool_current = this->baselist_pool_used = 0;
     }
 
     template<typename Scalar>
     void H1Space<Scalar>::init(Shapeset* shapeset, int p_init)
     {
+      this->baselist_pool_current = this->baselist_pool_used = 0;
+
       if(shapeset == NULL)
       {
-        this->shapeset = new H1Shapeset;
-        this->own_shapeset = true;
+        // The default shapesets are identical for every space, so the shared
+        // instance is used instead of a private copy.
+        this->shapeset = ShapesetRegistry::get_default_shapeset(HERMES_H1_SPACE);
+        this->own_shapeset = false;
       }
 
       this->precalculate_projection_matrix(2, this->proj_mat, this->chol_p);
@@ -61,10 +69,56 @@ namespace Hermes
     template<typename Scalar>
     H1Space<Scalar>::~H1Space()
     {
+      baselist_pool_free();
       if(this->own_shapeset)
         delete this->shapeset;
     }
 
+    template<typename Scalar>
+    typename Space<Scalar>::BaseComponent* H1Space<Scalar>::baselist_pool_allocate(int count)
+    {
+      // move to a chunk with enough room left, allocating a new one when there is none
+      while(baselist_pool_current < (int) baselist_pool_chunks.size()
+        && baselist_pool_used + count > baselist_pool_chunk_sizes[baselist_pool_current])
+      {
+        baselist_pool_current++;
+        baselist_pool_used = 0;
+      }
+      if(baselist_pool_current == (int) baselist_pool_chunks.size())
+      {
+        int size = std::max(count, H2D_BASELIST_POOL_CHUNK);
+        baselist_pool_chunks.push_back((typename Space<Scalar>::BaseComponent*) malloc(size * sizeof(typename Space<Scalar>::BaseComponent)));
+        baselist_pool_chunk_sizes.push_back(size);
+      }
+
+      typename Space<Scalar>::BaseComponent* result = baselist_pool_chunks[baselist_pool_current] + baselist_pool_used;
+      baselist_pool_used += count;
+      return result;
+    }
+
+    template<typename Scalar>
+    void H1Space<Scalar>::baselist_pool_return(int count)
+    {
+      baselist_pool_used -= count;
+    }
+
+    template<typename Scalar>
+    void H1Space<Scalar>::baselist_pool_reset()
+    {
+      baselist_pool_current = 0;
+      baselist_pool_used = 0;
+    }
+
+    template<typename Scalar>
+    void H1Space<Scalar>::baselist_pool_free()
+    {
+      for (unsigned int i = 0; i < baselist_pool_chunks.size(); i++)
+        ::free(baselist_pool_chunks[i]);
+      baselist_pool_chunks.clear();
+      baselist_pool_chunk_sizes.clear();
+      baselist_pool_reset();
+    }
+
     template<typename Scalar>
     void H1Space<Scalar>::copy(const Space<Scalar>* space, Mesh* new_mesh)
     {
@@ -370,7 +424,7 @@ namespace Hermes
       int max_result = n1 + n2;
       if(edge != NULL) max_result += this->ndata[edge->id].n;
 
-      typename Space<Scalar>::BaseComponent* result = (typename Space<Scalar>::BaseComponent*) malloc(max_result * sizeof(typename Space<Scalar>::BaseComponent));
+      typename Space<Scalar>::BaseComponent* result = baselist_pool_allocate(max_result);
       typename Space<Scalar>::BaseComponent* current = result;
       typename Space<Scalar>::BaseComponent* last = NULL;
 
@@ -395,20 +449,11 @@ namespace Hermes
         current += this->ndata[edge->id].n;
       }
 
-      // if we produced less components than we expected, reallocate the resulting array
-      // ...this should be OK as we are always shrinking the array so no copying should occur
+      // if we produced less components than we expected, give the remainder back to
+      // the pool; the list stays where it is, so edge_dofs needs no fixing up
       ncomponents = current - result;
-      if(ncomponents < max_result)
-      {
-        typename Space<Scalar>::BaseComponent* reallocated_result = (typename Space<Scalar>::BaseComponent*) realloc(result, ncomponents * sizeof(typename Space<Scalar>::BaseComponent));
-        if(edge_dofs != NULL)
-        {
-          edge_dofs = reallocated_result + (edge_dofs - result);
-        }
-        return reallocated_result;
-      }
-      else
-        return result;
+      baselist_pool_return(max_result - ncomponents);
+      return result;
     }
 
     template<typename Scalar>
@@ -497,7 +542,6 @@ namespace Hermes
           typename Space<Scalar>::BaseComponent* edge_dofs;
           nd = &this->ndata[mid_vn->id];
           nd->baselist = merge_baselists(bl[0], nc[0], bl[1], nc[1], en, edge_dofs, nd->ncomponents);
-          this->bc_data.push_back(nd->baselist);
 
           // set edge node coeffs to function values of the edge functions
           double mid = (ei[i]->lo + ei[i]->hi) * 0.5;
@@ -566,6 +610,11 @@ namespace Hermes
     template<typename Scalar>
     void H1Space<Scalar>::update_constraints()
     {
+      // Every coefficient list is rebuilt below - assign_dofs() renumbers all the
+      // dofs the lists store, even where the refinement configuration is unchanged.
+      // The pooled storage of the previous lists is reused for the new ones.
+      this->baselist_pool_reset();
+
       Element* e;
       for_all_base_elements(e, this->mesh)
         update_constrained_nodes(e, NULL, NULL, NULL, NULL);
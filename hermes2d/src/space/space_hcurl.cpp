@@ -34,8 +34,9 @@ namespace Hermes
     {
       if(shapeset == NULL)
       {
-        this->shapeset = new HcurlShapeset;
-        this->own_shapeset = true;
+        // Shared default instance, see ShapesetRegistry.
+        this->shapeset = ShapesetRegistry::get_default_shapeset(HERMES_HCURL_SPACE);
+        this->own_shapeset = false;
       }
       if(this->shapeset->get_num_components() < 2) throw Hermes::Exceptions::Exception("HcurlSpace requires a vector shapeset.");
 
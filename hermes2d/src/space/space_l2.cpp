@@ -34,8 +34,9 @@ namespace Hermes
     {
       if(shapeset == NULL)
       {
-        this->shapeset = new L2Shapeset;
-        this->own_shapeset = true;
+        // Shared default instance, see ShapesetRegistry.
+        this->shapeset = ShapesetRegistry::get_default_shapeset(HERMES_L2_SPACE);
+        this->own_shapeset = false;
       }
       ldata = NULL;
       lsize = 0;
@@ -29,10 +29,14 @@ namespace Hermes
       extrapolate_der_right(extrapolate_der_right)
     {
       this->is_const = false;
+      this->uniform_knots = false;
+      this->uniform_step_inverse = 0.0;
     }
 
     CubicSpline::CubicSpline(double const_value) : Hermes::Hermes1DFunction<double>(const_value)
     {
+      this->uniform_knots = false;
+      this->uniform_step_inverse = 0.0;
     }
 
     CubicSpline::~CubicSpline() 
@@ -113,6 +117,57 @@ namespace Hermes
       return get_derivative_from_interval(x, m);
     };
 
+    void CubicSpline::get_values(const double* x_in, int n, double* values_out) const
+    {
+      // For simple constant case.
+      if(this->is_const)
+      {
+        for (int i = 0; i < n; i++)
+          values_out[i] = const_value;
+        return;
+      }
+
+      // For general case. The interval index m is carried over from one point
+      // to the next: on sorted inputs it only ever moves forward, so a whole
+      // batch costs one walk over the knots instead of one bisection per point.
+      int last_interval = points.size() - 2;
+      int m = 0;
+      for (int i = 0; i < n; i++)
+      {
+        double x = x_in[i];
+        // Extrapolation on the left / right of the interval of definition,
+        // handled the same way as in value().
+        if(x <= point_left)
+        {
+          values_out[i] = extrapolate_der_left ? extrapolate_value(point_left, value_left, derivative_left, x) : value_left;
+          continue;
+        }
+        if(x > point_right)
+        {
+          values_out[i] = extrapolate_der_right ? extrapolate_value(point_right, value_right, derivative_right, x) : value_right;
+          continue;
+        }
+
+        if(uniform_knots)
+        {
+          // Equidistant grid points - the interval is just index arithmetic.
+          m = (int) ((x - points[0]) * uniform_step_inverse);
+          if(m > last_interval)
+            m = last_interval;
+        }
+        else if(x >= points[m])
+        {
+          while (m < last_interval && points[m + 1] < x)
+            m++;
+        }
+        else
+          // The input is not sorted after all, fall back to the bisection.
+          find_interval(x, m);
+
+        values_out[i] = get_value_from_interval(x, m);
+      }
+    }
+
     double CubicSpline::extrapolate_value(double point_end, double value_end,
       double derivative_end, double x_in) const
     {
@@ -144,6 +199,14 @@ namespace Hermes
       if(x_in < points[i_left]) return false;
       if(x_in > points[i_right]) return false;
 
+      if(uniform_knots)
+      {
+        m = (int) ((x_in - points[0]) * uniform_step_inverse);
+        if(m > i_right - 1)
+          m = i_right - 1;
+        return true;
+      }
+
       while (i_left + 1 < i_right)
       {
         int i_mid = (i_left + i_right) / 2;
@@ -252,6 +315,18 @@ namespace Hermes
         }
       }
 
+      // Detect equidistant grid points - interval lookup is then pure index
+      // arithmetic, see find_interval().
+      double uniform_step = (points[nelem] - points[0]) / nelem;
+      this->uniform_knots = true;
+      for (int i = 0; i < nelem; i++)
+        if(fabs(points[i + 1] - points[i] - uniform_step) > eps)
+        {
+          this->uniform_knots = false;
+          break;
+        }
+      this->uniform_step_inverse = this->uniform_knots ? 1.0 / uniform_step : 0.0;
+
       /* START COMPUTATION */
 
       // Allocate matrix and rhs.
@@ -0,0 +1,450 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, see <http://www.gnu.prg/licenses/>.
+#include "static_condensation.h"
+#include "solvers/umfpack_solver.h"
+#include <vector>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Dense LU factorization with partial pivoting, in place.
+    /// Unlike Hermes::Algebra::DenseMatrixOperations::ludcmp this works for
+    /// both scalar types, which the condensed blocks need.
+    template<typename Scalar>
+    static void dense_lu_factor(Scalar** a, int n, int* indx)
+    {
+      for(int k = 0; k < n; k++)
+      {
+        int pivot = k;
+        double largest = std::abs(a[k][k]);
+        for(int r = k + 1; r < n; r++)
+          if(std::abs(a[r][k]) > largest)
+          {
+            largest = std::abs(a[r][k]);
+            pivot = r;
+          }
+        if(largest == 0.0)
+          throw Hermes::Exceptions::Exception("StaticCondensation: singular interior block encountered.");
+        indx[k] = pivot;
+        if(pivot != k)
+          for(int c = 0; c < n; c++)
+          {
+            Scalar tmp = a[k][c];
+            a[k][c] = a[pivot][c];
+            a[pivot][c] = tmp;
+          }
+        for(int r = k + 1; r < n; r++)
+        {
+          a[r][k] /= a[k][k];
+          for(int c = k + 1; c < n; c++)
+            a[r][c] -= a[r][k] * a[k][c];
+        }
+      }
+    }
+
+    /// Solves a system with the factorization produced by dense_lu_factor, in place.
+    template<typename Scalar>
+    static void dense_lu_solve(Scalar** a, int n, int* indx, Scalar* b)
+    {
+      for(int k = 0; k < n; k++)
+      {
+        if(indx[k] != k)
+        {
+          Scalar tmp = b[k];
+          b[k] = b[indx[k]];
+          b[indx[k]] = tmp;
+        }
+        for(int r = k + 1; r < n; r++)
+          b[r] -= a[r][k] * b[k];
+      }
+      for(int k = n - 1; k >= 0; k--)
+      {
+        for(int c = k + 1; c < n; c++)
+          b[k] -= a[k][c] * b[c];
+        b[k] /= a[k][k];
+      }
+    }
+
+    template<typename Scalar>
+    StaticCondensation<Scalar>::StaticCondensation(Hermes::vector<const Space<Scalar>*> spaces) : spaces(spaces),
+      ndof(0), reduced_ndof(0), reduced_dof(NULL), reduced_matrix(NULL), reduced_rhs(NULL)
+    {
+    }
+
+    template<typename Scalar>
+    StaticCondensation<Scalar>::StaticCondensation(const Space<Scalar>* space) :
+      ndof(0), reduced_ndof(0), reduced_dof(NULL), reduced_matrix(NULL), reduced_rhs(NULL)
+    {
+      spaces.push_back(space);
+    }
+
+    template<typename Scalar>
+    StaticCondensation<Scalar>::~StaticCondensation()
+    {
+      free();
+    }
+
+    template<typename Scalar>
+    StaticCondensation<Scalar>::ElementRecord::ElementRecord() : n_condensed(0), n_interface(0),
+      condensed_dofs(NULL), interface_dofs(NULL), W(NULL), g(NULL)
+    {
+    }
+
+    template<typename Scalar>
+    StaticCondensation<Scalar>::ElementRecord::~ElementRecord()
+    {
+      if(condensed_dofs != NULL)
+        delete [] condensed_dofs;
+      if(interface_dofs != NULL)
+        delete [] interface_dofs;
+      if(W != NULL)
+        delete [] W;
+      if(g != NULL)
+        delete [] g;
+    }
+
+    template<typename Scalar>
+    void StaticCondensation<Scalar>::free()
+    {
+      for(unsigned int i = 0; i < records.size(); i++)
+        delete records[i];
+      records.clear();
+      if(reduced_dof != NULL)
+      {
+        delete [] reduced_dof;
+        reduced_dof = NULL;
+      }
+      if(reduced_matrix != NULL)
+      {
+        delete reduced_matrix;
+        reduced_matrix = NULL;
+      }
+      if(reduced_rhs != NULL)
+      {
+        delete reduced_rhs;
+        reduced_rhs = NULL;
+      }
+      ndof = reduced_ndof = 0;
+    }
+
+    template<typename Scalar>
+    void StaticCondensation<Scalar>::condense(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs)
+    {
+#ifdef WITH_UMFPACK
+      free();
+
+      ndof = Space<Scalar>::get_num_dofs(spaces);
+      if(mat->get_size() != (unsigned int) ndof)
+        throw Hermes::Exceptions::Exception("StaticCondensation: matrix size %d does not match the %d DOFs of the spaces.", mat->get_size(), ndof);
+
+      CSCMatrix<Scalar>* csc = dynamic_cast<CSCMatrix<Scalar>*>(mat);
+      if(csc == NULL)
+        throw Hermes::Exceptions::Exception("StaticCondensation requires a CSC-based matrix (e.g. the UMFPACK one).");
+
+      int* Ap = csc->get_Ap();
+      int* Ai = csc->get_Ai();
+      Scalar* Ax = csc->get_Ax();
+
+      // Gather the assembly lists of all active elements over all spaces.
+      std::vector<std::vector<int> > element_dofs;
+      AsmList<Scalar> al;
+      for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        Element* e;
+        for_all_active_elements(e, spaces[space_i]->get_mesh())
+        {
+          spaces[space_i]->get_element_assembly_list(e, &al);
+          std::vector<int> dofs;
+          for(unsigned int i = 0; i < al.get_cnt(); i++)
+            if(al.get_dof()[i] >= 0)
+              dofs.push_back(al.get_dof()[i]);
+          element_dofs.push_back(dofs);
+        }
+      }
+
+      // A DOF is a candidate for elimination if it belongs to a single element's assembly list.
+      int* owner = new int[ndof];
+      for(int i = 0; i < ndof; i++)
+        owner[i] = -2;
+      for(unsigned int e_i = 0; e_i < element_dofs.size(); e_i++)
+        for(unsigned int i = 0; i < element_dofs[e_i].size(); i++)
+        {
+          int dof = element_dofs[e_i][i];
+          if(owner[dof] == -2)
+            owner[dof] = e_i;
+          else if(owner[dof] != (int) e_i)
+            owner[dof] = -1;
+        }
+
+      // Verify each candidate against the sparsity pattern: its matrix column must
+      // only reference DOFs of the owning element. This keeps e.g. DG-coupled DOFs
+      // in the reduced system.
+      bool* condensed = new bool[ndof];
+      bool* in_element = new bool[ndof];
+      for(int i = 0; i < ndof; i++)
+        condensed[i] = in_element[i] = false;
+      for(unsigned int e_i = 0; e_i < element_dofs.size(); e_i++)
+      {
+        const std::vector<int>& dofs = element_dofs[e_i];
+        bool has_candidate = false;
+        for(unsigned int i = 0; i < dofs.size(); i++)
+          if(owner[dofs[i]] == (int) e_i)
+            has_candidate = true;
+        if(!has_candidate)
+          continue;
+
+        for(unsigned int i = 0; i < dofs.size(); i++)
+          in_element[dofs[i]] = true;
+        for(unsigned int i = 0; i < dofs.size(); i++)
+        {
+          int dof = dofs[i];
+          if(owner[dof] != (int) e_i)
+            continue;
+          bool local_only = true;
+          for(int idx = Ap[dof]; idx < Ap[dof + 1]; idx++)
+            if(!in_element[Ai[idx]])
+            {
+              local_only = false;
+              break;
+            }
+          if(local_only)
+            condensed[dof] = true;
+        }
+        for(unsigned int i = 0; i < dofs.size(); i++)
+          in_element[dofs[i]] = false;
+      }
+      delete [] owner;
+
+      // Numbering of the reduced system.
+      reduced_dof = new int[ndof];
+      reduced_ndof = 0;
+      for(int i = 0; i < ndof; i++)
+        reduced_dof[i] = condensed[i] ? -1 : reduced_ndof++;
+
+      // Per-element elimination. The Schur blocks are kept until they have been
+      // added into the reduced matrix, the W / g factors are kept for recovery.
+      Scalar* corrected_rhs = new Scalar[ndof];
+      for(int i = 0; i < ndof; i++)
+        corrected_rhs[i] = rhs->get(i);
+
+      int* pos_condensed = new int[ndof];
+      int* pos_interface = new int[ndof];
+      std::vector<Scalar**> schur_blocks;
+      for(unsigned int e_i = 0; e_i < element_dofs.size(); e_i++)
+      {
+        const std::vector<int>& dofs = element_dofs[e_i];
+        int n_b = 0;
+        for(unsigned int i = 0; i < dofs.size(); i++)
+          if(condensed[dofs[i]])
+            n_b++;
+        if(n_b == 0)
+          continue;
+        int n_i = dofs.size() - n_b;
+
+        ElementRecord* record = new ElementRecord;
+        record->n_condensed = n_b;
+        record->n_interface = n_i;
+        record->condensed_dofs = new int[n_b];
+        record->interface_dofs = new int[n_i > 0 ? n_i : 1];
+        n_b = n_i = 0;
+        for(unsigned int i = 0; i < dofs.size(); i++)
+          if(condensed[dofs[i]])
+          {
+            pos_condensed[dofs[i]] = n_b;
+            record->condensed_dofs[n_b++] = dofs[i];
+          }
+          else
+          {
+            pos_interface[dofs[i]] = n_i;
+            record->interface_dofs[n_i++] = dofs[i];
+          }
+
+        // Extract K_bb and K_ib from the columns of the condensed DOFs,
+        // K_bi from the condensed rows of the interface columns.
+        Scalar** K_bb = new_matrix<Scalar>(n_b);
+        Scalar** K_bi = new_matrix<Scalar>(n_b, n_i > 0 ? n_i : 1);
+        Scalar** K_ib = new_matrix<Scalar>(n_i > 0 ? n_i : 1, n_b);
+        for(int k = 0; k < n_b; k++)
+        {
+          int col = record->condensed_dofs[k];
+          for(int idx = Ap[col]; idx < Ap[col + 1]; idx++)
+          {
+            int row = Ai[idx];
+            if(condensed[row])
+              K_bb[pos_condensed[row]][k] = Ax[idx];
+            else
+              K_ib[pos_interface[row]][k] = Ax[idx];
+          }
+        }
+        // An interface column also holds condensed rows of the other elements
+        // sharing the DOF, hence the explicit membership marker.
+        for(int k = 0; k < n_b; k++)
+          in_element[record->condensed_dofs[k]] = true;
+        for(int m = 0; m < n_i; m++)
+        {
+          int col = record->interface_dofs[m];
+          for(int idx = Ap[col]; idx < Ap[col + 1]; idx++)
+          {
+            int row = Ai[idx];
+            if(in_element[row])
+              K_bi[pos_condensed[row]][m] = Ax[idx];
+          }
+        }
+        for(int k = 0; k < n_b; k++)
+          in_element[record->condensed_dofs[k]] = false;
+
+        // Factor K_bb, compute g = K_bb^{-1} f_b and W = K_bb^{-1} K_bi.
+        int* indx = new int[n_b];
+        dense_lu_factor(K_bb, n_b, indx);
+        record->g = new Scalar[n_b];
+        for(int k = 0; k < n_b; k++)
+          record->g[k] = rhs->get(record->condensed_dofs[k]);
+        dense_lu_solve(K_bb, n_b, indx, record->g);
+
+        Scalar* column = new Scalar[n_b];
+        for(int m = 0; m < n_i; m++)
+        {
+          for(int k = 0; k < n_b; k++)
+            column[k] = K_bi[k][m];
+          dense_lu_solve(K_bb, n_b, indx, column);
+          for(int k = 0; k < n_b; k++)
+            K_bi[k][m] = column[k];
+        }
+        delete [] column;
+        delete [] indx;
+        delete [] K_bb;
+        record->W = K_bi;
+
+        // Schur complement S = K_ib W and the rhs correction K_ib g.
+        Scalar** S = new_matrix<Scalar>(n_i > 0 ? n_i : 1);
+        for(int m = 0; m < n_i; m++)
+        {
+          Scalar correction = 0.0;
+          for(int k = 0; k < n_b; k++)
+            correction += K_ib[m][k] * record->g[k];
+          corrected_rhs[record->interface_dofs[m]] -= correction;
+          for(int c = 0; c < n_i; c++)
+          {
+            Scalar val = 0.0;
+            for(int k = 0; k < n_b; k++)
+              val += K_ib[m][k] * record->W[k][c];
+            S[m][c] = val;
+          }
+        }
+        delete [] K_ib;
+
+        schur_blocks.push_back(S);
+        records.push_back(record);
+      }
+      delete [] pos_condensed;
+      delete [] pos_interface;
+
+      // Build the reduced matrix: the kept part of the original pattern plus the
+      // fill-in of the Schur complements.
+      reduced_matrix = create_matrix<Scalar>();
+      reduced_matrix->prealloc(reduced_ndof);
+      for(int col = 0; col < ndof; col++)
+      {
+        if(reduced_dof[col] < 0)
+          continue;
+        for(int idx = Ap[col]; idx < Ap[col + 1]; idx++)
+          if(reduced_dof[Ai[idx]] >= 0)
+            reduced_matrix->pre_add_ij(reduced_dof[Ai[idx]], reduced_dof[col]);
+      }
+      for(unsigned int r_i = 0; r_i < records.size(); r_i++)
+        for(int m = 0; m < records[r_i]->n_interface; m++)
+          for(int c = 0; c < records[r_i]->n_interface; c++)
+            reduced_matrix->pre_add_ij(reduced_dof[records[r_i]->interface_dofs[m]], reduced_dof[records[r_i]->interface_dofs[c]]);
+      reduced_matrix->alloc();
+
+      for(int col = 0; col < ndof; col++)
+      {
+        if(reduced_dof[col] < 0)
+          continue;
+        for(int idx = Ap[col]; idx < Ap[col + 1]; idx++)
+          if(reduced_dof[Ai[idx]] >= 0)
+            reduced_matrix->add(reduced_dof[Ai[idx]], reduced_dof[col], Ax[idx]);
+      }
+      for(unsigned int r_i = 0; r_i < records.size(); r_i++)
+      {
+        ElementRecord* record = records[r_i];
+        Scalar** S = schur_blocks[r_i];
+        for(int m = 0; m < record->n_interface; m++)
+          for(int c = 0; c < record->n_interface; c++)
+            reduced_matrix->add(reduced_dof[record->interface_dofs[m]], reduced_dof[record->interface_dofs[c]], -S[m][c]);
+        delete [] S;
+      }
+      reduced_matrix->finish();
+
+      reduced_rhs = create_vector<Scalar>();
+      reduced_rhs->alloc(reduced_ndof);
+      for(int i = 0; i < ndof; i++)
+        if(reduced_dof[i] >= 0)
+          reduced_rhs->set(reduced_dof[i], corrected_rhs[i]);
+      reduced_rhs->finish();
+
+      delete [] corrected_rhs;
+      delete [] condensed;
+      delete [] in_element;
+#else
+      throw Hermes::Exceptions::Exception("StaticCondensation requires a CSC-based matrix (e.g. the UMFPACK one).");
+#endif
+    }
+
+    template<typename Scalar>
+    SparseMatrix<Scalar>* StaticCondensation<Scalar>::get_reduced_matrix()
+    {
+      return reduced_matrix;
+    }
+
+    template<typename Scalar>
+    Vector<Scalar>* StaticCondensation<Scalar>::get_reduced_rhs()
+    {
+      return reduced_rhs;
+    }
+
+    template<typename Scalar>
+    int StaticCondensation<Scalar>::get_reduced_ndof() const
+    {
+      return reduced_ndof;
+    }
+
+    template<typename Scalar>
+    void StaticCondensation<Scalar>::recover(Scalar* reduced_sln_vector, Scalar* full_sln_vector)
+    {
+      if(reduced_dof == NULL)
+        throw Hermes::Exceptions::Exception("StaticCondensation::recover() called before condense().");
+
+      for(int i = 0; i < ndof; i++)
+        full_sln_vector[i] = (reduced_dof[i] >= 0) ? reduced_sln_vector[reduced_dof[i]] : Scalar(0.0);
+
+      for(unsigned int r_i = 0; r_i < records.size(); r_i++)
+      {
+        ElementRecord* record = records[r_i];
+        for(int k = 0; k < record->n_condensed; k++)
+        {
+          Scalar val = record->g[k];
+          for(int m = 0; m < record->n_interface; m++)
+            val -= record->W[k][m] * full_sln_vector[record->interface_dofs[m]];
+          full_sln_vector[record->condensed_dofs[k]] = val;
+        }
+      }
+    }
+
+    template class HERMES_API StaticCondensation<double>;
+    template class HERMES_API StaticCondensation<std::complex<double> >;
+  }
+}
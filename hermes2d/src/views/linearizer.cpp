@@ -18,6 +18,9 @@
 #include "traverse.h"
 #include "exact_solution.h"
 #include "api2d.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace Hermes
 {
@@ -106,11 +109,22 @@ namespace Hermes
       Linearizer::Linearizer(bool auto_max) : LinearizerBase(auto_max), dmult(1.0), component(0), value_type(0), curvature_epsilon(1e-3)
       {
         verts = NULL;
+        float_storage = false;
+        verts_f32 = NULL;
         xdisp = NULL;
         user_xdisp = false;
         ydisp = NULL;
         user_ydisp = false;
         tris_contours = NULL;
+        reuse_topology = false;
+        topology_valid = false;
+        skip_unchanged = false;
+        last_processed_sln = NULL;
+        last_sln_stamp = -1;
+        front_verts = NULL;
+        front_vertex_size = 0;
+        front_tris_contours = NULL;
+        front_triangle_contours_count = front_triangle_contours_size = 0;
       }
 
       void Linearizer::process_triangle(MeshFunction<double>** fns, int iv0, int iv1, int iv2, int level,
@@ -268,6 +282,54 @@ namespace Hermes
         return this->curvature_epsilon;
       }
 
+      void Linearizer::set_topology_reuse(bool to_set)
+      {
+        this->reuse_topology = to_set;
+      }
+
+      void Linearizer::set_skip_unchanged(bool to_set)
+      {
+        this->skip_unchanged = to_set;
+      }
+
+      bool Linearizer::solution_unchanged(MeshFunction<double>* sln, int item_, double eps)
+      {
+        if(!this->skip_unchanged || this->empty || this->user_xdisp || this->user_ydisp)
+          return false;
+        if(sln != this->last_processed_sln || item_ != this->last_item || eps != this->last_eps)
+          return false;
+        if(sln->get_mesh()->has_changed_since(this->last_sln_seq))
+          return false;
+        // Only solutions carry a change stamp; filters and exact solutions may change
+        // without any observable trace, so they always get reprocessed.
+        Solution<double>* solution = dynamic_cast<Solution<double>*>(sln);
+        if(solution == NULL)
+          return false;
+        return !solution->has_changed_since(this->last_sln_stamp);
+      }
+
+      void Linearizer::set_float_storage(bool to_set)
+      {
+        this->float_storage = to_set;
+      }
+
+      void Linearizer::compress_vertices()
+      {
+        // With double buffering the readers work on the published double
+        // arrays, so there is nothing to be gained by compressing here.
+        if(!this->float_storage || this->double_buffering)
+          return;
+        this->verts_f32 = (float3*) realloc(this->verts_f32, sizeof(float3) * this->vertex_count);
+        for (int i = 0; i < this->vertex_count; i++)
+        {
+          this->verts_f32[i][0] = (float) this->verts[i][0];
+          this->verts_f32[i][1] = (float) this->verts[i][1];
+          this->verts_f32[i][2] = (float) this->verts[i][2];
+        }
+        ::free(this->verts);
+        this->verts = NULL;
+      }
+
       void Linearizer::push_transforms(MeshFunction<double>** fns, int transform)
       {
         fns[0]->push_transform(transform);
@@ -524,9 +586,80 @@ namespace Hermes
         // Important, sets the current caughtException to NULL.
         this->caughtException = NULL;
 
-        lock_data();
+        // Nothing to do if the stored triangulation was built for this very data,
+        // see set_skip_unchanged().
+        if(solution_unchanged(sln, item_, eps))
+          return;
+
+        // With double buffering the build works on arrays no reader touches, the
+        // data lock is only taken for the publishing copy at the end.
+        if(!this->double_buffering)
+          lock_data();
         this->tick();
 
+        // Incremental mode: if the triangulation stored from the previous call was built
+        // for the same mesh, item and accuracy, only the vertex values are recomputed at
+        // the stored positions and everything else (triangles, edges, contours) is kept.
+        if(this->reuse_topology && this->topology_valid && !this->empty
+          && !this->user_xdisp && !this->user_ydisp
+          && sln->get_mesh()->get_seq() == this->last_sln_seq
+          && this->last_eps == eps && this->last_item == item_)
+        {
+          double* px = new double[this->vertex_count];
+          double* py = new double[this->vertex_count];
+          double* v = new double[this->vertex_count];
+          for (int i = 0; i < this->vertex_count; i++)
+          {
+            px[i] = vertex_x(i);
+            py[i] = vertex_y(i);
+          }
+
+          try
+          {
+            sln->eval_points(px, py, this->vertex_count, v, item_);
+          }
+          catch(...)
+          {
+            delete [] px;
+            delete [] py;
+            delete [] v;
+            this->topology_valid = false;
+            if(!this->double_buffering)
+              unlock_data();
+            throw;
+          }
+
+          for (int i = 0; i < this->vertex_count; i++)
+          {
+            if(verts != NULL)
+              verts[i][2] = v[i];
+            else
+              verts_f32[i][2] = (float) v[i];
+            if(finite(v[i]) && fabs(v[i]) > max)
+              max = fabs(v[i]);
+          }
+
+          delete [] px;
+          delete [] py;
+          delete [] v;
+
+          // the freshly evaluated values match the solution again
+          this->last_processed_sln = sln;
+          Solution<double>* solution = dynamic_cast<Solution<double>*>(sln);
+          this->last_sln_stamp = (solution != NULL) ? solution->get_sln_seq() : -1;
+
+          find_min_max();
+          if(this->double_buffering)
+            this->publish_buffers();
+          else
+            unlock_data();
+          return;
+        }
+
+        // The stored topology is clobbered by the full rebuild below; it becomes valid
+        // again only once the rebuild finishes.
+        this->topology_valid = false;
+
         // Initialization of 'global' stuff.
         this->item = item_;
         this->eps = eps;
@@ -564,6 +697,8 @@ namespace Hermes
         //    initialize the hash table
         this->hash_table = (int*) malloc(sizeof(int) * this->vertex_size);
         memset(this->hash_table, 0xff, sizeof(int) * this->vertex_size);
+        if(this->vertex_interning)
+          this->init_intern_table();
 
         // select the linearization quadratures
         Quad2D *old_quad, *old_quad_x = NULL, *old_quad_y = NULL;
@@ -632,7 +767,7 @@ namespace Hermes
         int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
 #pragma omp parallel shared(trav_masterMax) private(state_i) num_threads(num_threads_used)
         {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
           for(state_i = 0; state_i < num_states; state_i++)
           {
             try
@@ -683,9 +818,13 @@ namespace Hermes
           trav[i].stack = trav_master.stack;
         }
 
+        // per-thread triangle and edge buffers, so that the threads do not block each other
+        // on the shared arrays; they are merged below, once the traversal is finished.
+        this->init_thread_buffers(num_threads_used);
+
 #pragma omp parallel shared(trav_master) private(state_i) num_threads(num_threads_used)
         {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
           for(state_i = 0; state_i < num_states; state_i++)
           {
             if(this->caughtException != NULL)
@@ -770,6 +909,11 @@ namespace Hermes
         delete [] trfs;
         delete [] trav;
 
+        // merge the per-thread buffers into the shared arrays; the regularization
+        // below runs serially and uses the shared arrays again.
+        this->merge_thread_buffers();
+        this->free_thread_buffers();
+
         // for contours, without regularization.
         this->tris_contours = (int3*) realloc(this->tris_contours, sizeof(int3) * this->triangle_count);
         memcpy(this->tris_contours, this->tris, this->triangle_count * sizeof(int3));
@@ -777,9 +921,11 @@ namespace Hermes
 
         if(this->caughtException != NULL)
         {
-          this->unlock_data();
+          if(!this->double_buffering)
+            this->unlock_data();
           ::free(hash_table);
           ::free(info);
+          this->free_intern_table();
           throw *(this->caughtException);
         }
 
@@ -800,7 +946,10 @@ namespace Hermes
 
         find_min_max();
 
-        this->unlock_data();
+        if(this->double_buffering)
+          this->publish_buffers();
+        else
+          this->unlock_data();
 
         // select old quadratrues
         sln->set_quad_2d(old_quad);
@@ -816,6 +965,92 @@ namespace Hermes
         // clean up
         ::free(hash_table);
         ::free(info);
+        this->free_intern_table();
+
+        // remember what the triangulation was built for, for set_topology_reuse()
+        // and set_skip_unchanged().
+        this->last_sln_seq = sln->get_mesh()->get_seq();
+        this->last_eps = eps;
+        this->last_item = item_;
+        this->topology_valid = true;
+        this->last_processed_sln = sln;
+        Solution<double>* solution = dynamic_cast<Solution<double>*>(sln);
+        this->last_sln_stamp = (solution != NULL) ? solution->get_sln_seq() : -1;
+
+        // The adaptive build above works in doubles; only the finished
+        // triplets are narrowed, \sa set_float_storage().
+        compress_vertices();
+      }
+
+      void Linearizer::process_solutions(Hermes::vector<MeshFunction<double>*> slns,
+        Hermes::vector<int> items, double eps)
+      {
+        if(slns.size() == 0)
+          throw Exceptions::NullException(1);
+        if(items.size() > 0 && items.size() != slns.size())
+          throw Exceptions::LengthException(1, 2, slns.size(), items.size());
+        if(this->user_xdisp || this->user_ydisp)
+          throw Exceptions::Exception("Linearizer::process_solutions() is not available with a displacement set.");
+
+        for(unsigned int i = 0; i < this->value_channels.size(); i++)
+          delete [] this->value_channels[i];
+        this->value_channels.clear();
+
+        // The triangulation decisions are driven by the first component; the walk
+        // over the mesh, the vertex hashing and the regularization are thus paid
+        // once for the whole batch.
+        process_solution(slns[0], items.size() > 0 ? items[0] : H2D_FN_VAL_0, eps);
+
+        if(slns.size() == 1)
+          return;
+
+        lock_data();
+
+        this->value_channels.push_back(NULL);
+
+        double* px = new double[this->vertex_count];
+        double* py = new double[this->vertex_count];
+        for (int i = 0; i < this->vertex_count; i++)
+        {
+          px[i] = vertex_x(i);
+          py[i] = vertex_y(i);
+        }
+
+        // The remaining components are only evaluated at the shared vertex
+        // positions, the same way the topology reuse mode re-evaluates a new
+        // time level of a solution on the stored triangulation.
+        for (unsigned int j = 1; j < slns.size(); j++)
+        {
+          double* v = new double[this->vertex_count];
+          try
+          {
+            slns[j]->eval_points(px, py, this->vertex_count, v, items.size() > 0 ? items[j] : H2D_FN_VAL_0);
+          }
+          catch(...)
+          {
+            delete [] v;
+            delete [] px;
+            delete [] py;
+            for(unsigned int i = 0; i < this->value_channels.size(); i++)
+              delete [] this->value_channels[i];
+            this->value_channels.clear();
+            unlock_data();
+            throw;
+          }
+          this->value_channels.push_back(v);
+        }
+
+        delete [] px;
+        delete [] py;
+
+        unlock_data();
+      }
+
+      double* Linearizer::get_channel_values(int channel)
+      {
+        if(channel < 0 || channel >= (int) this->value_channels.size())
+          return NULL;
+        return this->value_channels[channel];
       }
 
       void Linearizer::find_min_max()
@@ -825,13 +1060,106 @@ namespace Hermes
         this->max_val = -1e100;
         for (int i = 0; i < this->vertex_count; i++)
         {
-          if(finite(verts[i][2]) && verts[i][2] < min_val) min_val = verts[i][2];
-          if(finite(verts[i][2]) && verts[i][2] > max_val) max_val = verts[i][2];
+          double value = vertex_value(i);
+          if(finite(value) && value < min_val) min_val = value;
+          if(finite(value) && value > max_val) max_val = value;
+        }
+      }
+
+      // Atomic primitives for the concurrent vertex interning. GCC and MSVC
+      // spell them differently, everything else in the protocol is shared.
+#ifdef _MSC_VER
+      static inline int64_t intern_word_cas(int64_t* target, int64_t expected, int64_t desired)
+      {
+        return _InterlockedCompareExchange64((volatile __int64*)target, desired, expected);
+      }
+      static inline int intern_index_reserve(int* counter)
+      {
+        return _InterlockedIncrement((volatile long*)counter) - 1;
+      }
+      static inline void intern_index_unreserve(int* counter, int reserved)
+      {
+        _InterlockedCompareExchange((volatile long*)counter, reserved, reserved + 1);
+      }
+#else
+      static inline int64_t intern_word_cas(int64_t* target, int64_t expected, int64_t desired)
+      {
+        return __sync_val_compare_and_swap(target, expected, desired);
+      }
+      static inline int intern_index_reserve(int* counter)
+      {
+        return __sync_fetch_and_add(counter, 1);
+      }
+      static inline void intern_index_unreserve(int* counter, int reserved)
+      {
+        __sync_bool_compare_and_swap(counter, reserved + 1, reserved);
+      }
+#endif
+
+      int Linearizer::get_vertex_interned(int p1, int p2, double x, double y, double value)
+      {
+        if(p1 > p2) std::swap(p1, p2);
+        unsigned int mask = (unsigned int)this->intern_capacity - 1;
+        unsigned int pos = this->intern_hash(p1, p2) & mask;
+        int64_t check = (int64_t)this->intern_check(p1, p2) << 32;
+        int reserved = -1;
+        while(true)
+        {
+          int64_t word = this->intern_table[pos];
+          if(word == -1)
+          {
+            // An empty slot: claim it for a new vertex. The index is reserved only
+            // once; if the claim is lost, the reservation is carried over to the
+            // next empty slot.
+            if(reserved < 0)
+            {
+              reserved = intern_index_reserve(&this->vertex_count);
+              if(reserved >= this->vertex_size)
+                throw Hermes::Exceptions::Exception("Vertex capacity exhausted in Linearizer with vertex interning on.");
+              verts[reserved][0] = x;
+              verts[reserved][1] = y;
+              verts[reserved][2] = value;
+              this->info[reserved][0] = p1;
+              this->info[reserved][1] = p2;
+              this->info[reserved][2] = -1;
+            }
+            // The vertex data are filled in before the slot is published by the
+            // compare-and-swap, the searches rely on this ordering.
+            int64_t prev = intern_word_cas(&this->intern_table[pos], -1, check | reserved);
+            if(prev == -1)
+              return reserved;
+            // Another thread claimed the slot first - match against its vertex.
+            word = prev;
+          }
+          if((word & ((int64_t)0xffffffff << 32)) == check)
+          {
+            int i = (int)(word & 0xffffffff);
+            if(
+              this->info[i][0] == p1 && this->info[i][1] == p2 &&
+              (value == verts[i][2] || fabs(value - verts[i][2]) < this->max*1e-8) &&
+              (fabs(x - verts[i][0]) < 1e-8) &&
+              (fabs(y - verts[i][1]) < 1e-8)
+              )
+            {
+              // A duplicate: hand the reserved index back if no other reservation
+              // has been made in the meantime; otherwise the reserved vertex stays
+              // in the arrays, filled in but unreferenced.
+              if(reserved >= 0)
+                intern_index_unreserve(&this->vertex_count, reserved);
+              return i;
+            }
+            // same parents, different value - a discontinuity in the solution,
+            // where more vertices with different values are created; probe on
+          }
+          pos = (pos + 1) & mask;
         }
       }
 
       int Linearizer::get_vertex(int p1, int p2, double x, double y, double value)
       {
+        if(this->intern_table != NULL)
+          return get_vertex_interned(p1, p2, x, y, value);
+
         // search for an existing vertex
         if(p1 > p2) std::swap(p1, p2);
         int index = this->hash(p1, p2);
@@ -859,7 +1187,35 @@ namespace Hermes
 #pragma omp critical(realloc_vertices)
         try
         {
-          i = add_vertex();
+          // another thread may have added the vertex while this one was waiting,
+          // so search the hash synonym chain once more before creating it
+          int j = this->hash_table[index];
+          while (j >= 0 && j < this->vertex_count)
+          {
+            if(
+              this->info[j][0] == p1 && this->info[j][1] == p2 &&
+              (value == verts[j][2] || fabs(value - verts[j][2]) < this->max*1e-8) &&
+              (fabs(x - verts[j][0]) < 1e-8) &&
+              (fabs(y - verts[j][1]) < 1e-8)
+              )
+              break;
+            j = info[j][2];
+          }
+          if(j >= 0 && j < this->vertex_count)
+            i = j;
+          else
+          {
+            i = add_vertex();
+            verts[i][0] = x;
+            verts[i][1] = y;
+            verts[i][2] = value;
+            this->info[i][0] = p1;
+            this->info[i][1] = p2;
+            this->info[i][2] = hash_table[index];
+            // publish the vertex only after its data have been filled in,
+            // the lock-free search above relies on this ordering
+            this->hash_table[index] = i;
+          }
         }
         catch(std::exception& e)
         {
@@ -870,13 +1226,6 @@ namespace Hermes
         {
           return -1;
         }
-        verts[i][0] = x;
-        verts[i][1] = y;
-        verts[i][2] = value;
-        this->info[i][0] = p1;
-        this->info[i][1] = p2;
-        this->info[i][2] = hash_table[index];
-        this->hash_table[index] = i;
         return i;
       }
 
@@ -900,11 +1249,32 @@ namespace Hermes
           ::free(verts);
           verts = NULL;
         }
+        if(verts_f32 != NULL)
+        {
+          ::free(verts_f32);
+          verts_f32 = NULL;
+        }
         if(tris_contours != NULL)
         {
           ::free(tris_contours);
           tris_contours = NULL;
         }
+        if(front_verts != NULL)
+        {
+          ::free(front_verts);
+          front_verts = NULL;
+          front_vertex_size = 0;
+        }
+        if(front_tris_contours != NULL)
+        {
+          ::free(front_tris_contours);
+          front_tris_contours = NULL;
+          front_triangle_contours_count = front_triangle_contours_size = 0;
+        }
+        for(unsigned int i = 0; i < this->value_channels.size(); i++)
+          delete [] this->value_channels[i];
+        this->value_channels.clear();
+        topology_valid = false;
 
         LinearizerBase::free();
       }
@@ -915,26 +1285,43 @@ namespace Hermes
       }
 
       void Linearizer::save_solution_vtk(MeshFunction<double>* sln, const char* filename, const char *quantity_name,
-        bool mode_3D, int item, double eps)
+        bool mode_3D, int item, double eps, bool binary)
       {
+        // A re-export of unchanged data into the same file is dropped altogether,
+        // see set_skip_unchanged().
+        if(solution_unchanged(sln, item, eps) && this->last_saved_filename == filename)
+          return;
+
         process_solution(sln, item, eps);
 
         FILE* f = fopen(filename, "wb");
         if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
         lock_data();
 
+        // the export is written in many small pieces, a large stream buffer keeps
+        // the number of write syscalls low
+        setvbuf(f, NULL, _IOFBF, 1 << 20);
+
         // Output header for vertices.
         fprintf(f, "# vtk DataFile Version 2.0\n");
         fprintf(f, "\n");
-        fprintf(f, "ASCII\n\n");
+        fprintf(f, binary ? "BINARY\n\n" : "ASCII\n\n");
         fprintf(f, "DATASET UNSTRUCTURED_GRID\n");
 
         // Output vertices.
         fprintf(f, "POINTS %d %s\n", this->vertex_count, "float");
         for (int i = 0; i < this->vertex_count; i++)
         {
-          if(mode_3D == true) fprintf(f, "%g %g %g\n", this->verts[i][0], this->verts[i][1], this->verts[i][2]);
-          else fprintf(f, "%g %g %g\n", this->verts[i][0], this->verts[i][1], 0.0);
+          if(binary)
+          {
+            float xyz[3];
+            xyz[0] = (float) vertex_x(i);
+            xyz[1] = (float) vertex_y(i);
+            xyz[2] = mode_3D ? (float) vertex_value(i) : 0.0f;
+            vtk_write_binary_floats(f, xyz, 3);
+          }
+          else if(mode_3D == true) fprintf(f, "%g %g %g\n", vertex_x(i), vertex_y(i), vertex_value(i));
+          else fprintf(f, "%g %g %g\n", vertex_x(i), vertex_y(i), 0.0);
         }
 
         // Output elements.
@@ -942,7 +1329,17 @@ namespace Hermes
         fprintf(f, "CELLS %d %d\n", this->triangle_count, 4 * this->triangle_count);
         for (int i = 0; i < this->triangle_count; i++)
         {
-          fprintf(f, "3 %d %d %d\n", this->tris[i][0], this->tris[i][1], this->tris[i][2]);
+          if(binary)
+          {
+            int cell[4];
+            cell[0] = 3;
+            cell[1] = this->tris[i][0];
+            cell[2] = this->tris[i][1];
+            cell[3] = this->tris[i][2];
+            vtk_write_binary_ints(f, cell, 4);
+          }
+          else
+            fprintf(f, "3 %d %d %d\n", this->tris[i][0], this->tris[i][1], this->tris[i][2]);
         }
 
         // Output cell types.
@@ -950,7 +1347,13 @@ namespace Hermes
         fprintf(f, "CELL_TYPES %d\n", this->triangle_count);
         for (int i = 0; i < this->triangle_count; i++)
         {
-          fprintf(f, "5\n");    // The "5" means triangle in VTK.
+          if(binary)
+          {
+            int type = 5;     // The "5" means triangle in VTK.
+            vtk_write_binary_ints(f, &type, 1);
+          }
+          else
+            fprintf(f, "5\n");    // The "5" means triangle in VTK.
         }
 
         // This outputs double solution values.
@@ -960,7 +1363,108 @@ namespace Hermes
         fprintf(f, "LOOKUP_TABLE %s\n", "default");
         for (int i = 0; i < this->vertex_count; i++)
         {
-          fprintf(f, "%g\n", this->verts[i][2]);
+          if(binary)
+          {
+            float value = (float) vertex_value(i);
+            vtk_write_binary_floats(f, &value, 1);
+          }
+          else
+            fprintf(f, "%g\n", vertex_value(i));
+        }
+
+        unlock_data();
+        fclose(f);
+
+        this->last_saved_filename = filename;
+      }
+
+      void Linearizer::save_solution_vtk(Hermes::vector<MeshFunction<double>*> slns, const char* filename,
+        Hermes::vector<std::string> quantity_names, bool mode_3D, Hermes::vector<int> items, double eps, bool binary)
+      {
+        if(slns.size() != quantity_names.size())
+          throw Exceptions::LengthException(1, 3, slns.size(), quantity_names.size());
+
+        process_solutions(slns, items, eps);
+
+        FILE* f = fopen(filename, "wb");
+        if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
+        lock_data();
+
+        setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+        // Output header for vertices.
+        fprintf(f, "# vtk DataFile Version 2.0\n");
+        fprintf(f, "\n");
+        fprintf(f, binary ? "BINARY\n\n" : "ASCII\n\n");
+        fprintf(f, "DATASET UNSTRUCTURED_GRID\n");
+
+        // Output vertices. The 3D mode lifts the points by the first field.
+        fprintf(f, "POINTS %d %s\n", this->vertex_count, "float");
+        for (int i = 0; i < this->vertex_count; i++)
+        {
+          if(binary)
+          {
+            float xyz[3];
+            xyz[0] = (float) vertex_x(i);
+            xyz[1] = (float) vertex_y(i);
+            xyz[2] = mode_3D ? (float) vertex_value(i) : 0.0f;
+            vtk_write_binary_floats(f, xyz, 3);
+          }
+          else if(mode_3D == true) fprintf(f, "%g %g %g\n", vertex_x(i), vertex_y(i), vertex_value(i));
+          else fprintf(f, "%g %g %g\n", vertex_x(i), vertex_y(i), 0.0);
+        }
+
+        // Output elements - once, shared by all the fields.
+        fprintf(f, "\n");
+        fprintf(f, "CELLS %d %d\n", this->triangle_count, 4 * this->triangle_count);
+        for (int i = 0; i < this->triangle_count; i++)
+        {
+          if(binary)
+          {
+            int cell[4];
+            cell[0] = 3;
+            cell[1] = this->tris[i][0];
+            cell[2] = this->tris[i][1];
+            cell[3] = this->tris[i][2];
+            vtk_write_binary_ints(f, cell, 4);
+          }
+          else
+            fprintf(f, "3 %d %d %d\n", this->tris[i][0], this->tris[i][1], this->tris[i][2]);
+        }
+
+        // Output cell types.
+        fprintf(f, "\n");
+        fprintf(f, "CELL_TYPES %d\n", this->triangle_count);
+        for (int i = 0; i < this->triangle_count; i++)
+        {
+          if(binary)
+          {
+            int type = 5;     // The "5" means triangle in VTK.
+            vtk_write_binary_ints(f, &type, 1);
+          }
+          else
+            fprintf(f, "5\n");    // The "5" means triangle in VTK.
+        }
+
+        // One SCALARS section per field within a common POINT_DATA block.
+        fprintf(f, "\n");
+        fprintf(f, "POINT_DATA %d\n", this->vertex_count);
+        for (unsigned int j = 0; j < slns.size(); j++)
+        {
+          double* channel = (j == 0) ? NULL : this->value_channels[j];
+          fprintf(f, "SCALARS %s %s %d\n", quantity_names[j].c_str(), "float", 1);
+          fprintf(f, "LOOKUP_TABLE %s\n", "default");
+          for (int i = 0; i < this->vertex_count; i++)
+          {
+            double value_d = (channel == NULL) ? vertex_value(i) : channel[i];
+            if(binary)
+            {
+              float value = (float) value_d;
+              vtk_write_binary_floats(f, &value, 1);
+            }
+            else
+              fprintf(f, "%g\n", value_d);
+          }
         }
 
         unlock_data();
@@ -969,27 +1473,80 @@ namespace Hermes
 
       void Linearizer::calc_vertices_aabb(double* min_x, double* max_x, double* min_y, double* max_y) const
       {
-        if(verts == NULL)
+        double3* v = this->double_buffering ? this->front_verts : this->verts;
+        int count = this->double_buffering ? this->front_vertex_count : this->vertex_count;
+        if(v == NULL && this->verts_f32 != NULL && !this->double_buffering)
+        {
+          // calc_aabb() walks doubles; the compressed storage is scanned directly.
+          *min_x = *min_y =  1e100;
+          *max_x = *max_y = -1e100;
+          for (int i = 0; i < count; i++)
+          {
+            *min_x = std::min(*min_x, (double) this->verts_f32[i][0]);
+            *max_x = std::max(*max_x, (double) this->verts_f32[i][0]);
+            *min_y = std::min(*min_y, (double) this->verts_f32[i][1]);
+            *max_y = std::max(*max_y, (double) this->verts_f32[i][1]);
+          }
+          return;
+        }
+        if(v == NULL)
           throw Exceptions::Exception("Cannot calculate AABB from NULL vertices");
-        calc_aabb(&verts[0][0], &verts[0][1], sizeof(double3), vertex_count, min_x, max_x, min_y, max_y);
+        calc_aabb(&v[0][0], &v[0][1], sizeof(double3), count, min_x, max_x, min_y, max_y);
+      }
+
+      void Linearizer::publish_buffers()
+      {
+        lock_data();
+        publish_base_buffers();
+
+        if(this->vertex_count > this->front_vertex_size)
+        {
+          this->front_vertex_size = this->vertex_size;
+          this->front_verts = (double3*) realloc(this->front_verts, sizeof(double3) * this->front_vertex_size);
+        }
+        memcpy(this->front_verts, this->verts, sizeof(double3) * this->vertex_count);
+
+        if(this->triangle_contours_count > this->front_triangle_contours_size)
+        {
+          this->front_triangle_contours_size = this->triangle_contours_count;
+          this->front_tris_contours = (int3*) realloc(this->front_tris_contours, sizeof(int3) * this->front_triangle_contours_size);
+        }
+        memcpy(this->front_tris_contours, this->tris_contours, sizeof(int3) * this->triangle_contours_count);
+        this->front_triangle_contours_count = this->triangle_contours_count;
+
+        unlock_data();
       }
 
       double3* Linearizer::get_vertices()
       {
+        if(this->double_buffering)
+          return this->front_verts;
         return this->verts;
       }
+      float3* Linearizer::get_vertices_f32()
+      {
+        if(this->double_buffering)
+          return NULL;
+        return this->verts_f32;
+      }
       int Linearizer::get_num_vertices()
       {
+        if(this->double_buffering)
+          return this->front_vertex_count;
         return this->vertex_count;
       }
 
       int Linearizer::get_num_contour_triangles()
       {
+        if(this->double_buffering)
+          return this->front_triangle_contours_count;
         return this->triangle_contours_count;
       }
 
       int3* Linearizer::get_contour_triangles()
       {
+        if(this->double_buffering)
+          return this->front_tris_contours;
         return this->tris_contours;
       }
     }
@@ -43,8 +43,30 @@ namespace Hermes
         edge_markers = NULL;
         hash_table = NULL;
         info = NULL;
+        vertex_interning = false;
+        intern_table = NULL;
+        intern_capacity = 0;
         max = -1e100;
 
+        double_buffering = false;
+        front_tris = NULL;
+        front_tri_markers = NULL;
+        front_edges = NULL;
+        front_edge_markers = NULL;
+        front_vertex_count = front_triangle_count = front_edges_count = 0;
+        front_triangle_size = front_edges_size = 0;
+        front_min_val = front_max_val = 0.0;
+
+        thread_buffer_count = 0;
+        thread_tris = NULL;
+        thread_tri_markers = NULL;
+        thread_triangle_count = NULL;
+        thread_triangle_size = NULL;
+        thread_edges = NULL;
+        thread_edge_markers = NULL;
+        thread_edges_count = NULL;
+        thread_edges_size = NULL;
+
         vertex_count = triangle_count = edges_count = this->vertex_size = this->triangle_size = this->edges_size = 0;
 
         pthread_mutexattr_t attr;
@@ -75,12 +97,28 @@ namespace Hermes
 					::free(edge_markers);
 					edge_markers = NULL;
         }
+        if(front_tris != NULL)
+        {
+          ::free(front_tris);
+          front_tris = NULL;
+          ::free(front_tri_markers);
+          front_tri_markers = NULL;
+        }
+        if(front_edges != NULL)
+        {
+          ::free(front_edges);
+          front_edges = NULL;
+          ::free(front_edge_markers);
+          front_edge_markers = NULL;
+        }
+        front_vertex_count = front_triangle_count = front_edges_count = 0;
+        front_triangle_size = front_edges_size = 0;
         this->empty = true;
       }
 
       LinearizerBase::~LinearizerBase()
       {
-        
+        free_intern_table();
         pthread_mutex_destroy(&data_mutex);
       }
 
@@ -94,6 +132,57 @@ namespace Hermes
         pthread_mutex_unlock(&data_mutex);
       }
 
+      void LinearizerBase::set_vertex_interning(bool to_set)
+      {
+        this->vertex_interning = to_set;
+        if(!to_set)
+          free_intern_table();
+      }
+
+      void LinearizerBase::set_double_buffering(bool to_set)
+      {
+        this->double_buffering = to_set;
+      }
+
+      bool LinearizerBase::get_double_buffering() const
+      {
+        return this->double_buffering;
+      }
+
+      void LinearizerBase::publish_buffers()
+      {
+        lock_data();
+        publish_base_buffers();
+        unlock_data();
+      }
+
+      void LinearizerBase::publish_base_buffers()
+      {
+        if(this->triangle_count > this->front_triangle_size)
+        {
+          this->front_triangle_size = this->triangle_size;
+          this->front_tris = (int3*) realloc(this->front_tris, sizeof(int3) * this->front_triangle_size);
+          this->front_tri_markers = (int*) realloc(this->front_tri_markers, sizeof(int) * this->front_triangle_size);
+        }
+        memcpy(this->front_tris, this->tris, sizeof(int3) * this->triangle_count);
+        memcpy(this->front_tri_markers, this->tri_markers, sizeof(int) * this->triangle_count);
+        this->front_triangle_count = this->triangle_count;
+
+        if(this->edges_count > this->front_edges_size)
+        {
+          this->front_edges_size = this->edges_size;
+          this->front_edges = (int2*) realloc(this->front_edges, sizeof(int2) * this->front_edges_size);
+          this->front_edge_markers = (int*) realloc(this->front_edge_markers, sizeof(int) * this->front_edges_size);
+        }
+        memcpy(this->front_edges, this->edges, sizeof(int2) * this->edges_count);
+        memcpy(this->front_edge_markers, this->edge_markers, sizeof(int) * this->edges_count);
+        this->front_edges_count = this->edges_count;
+
+        this->front_vertex_count = this->vertex_count;
+        this->front_min_val = this->min_val;
+        this->front_max_val = this->max_val;
+      }
+
       void LinearizerBase::process_edge(int iv1, int iv2, int marker)
       {
         int mid = peek_vertex(iv1, iv2);
@@ -169,8 +258,108 @@ namespace Hermes
         }
       }
 
+      void LinearizerBase::init_thread_buffers(int count)
+      {
+        thread_buffer_count = count;
+        thread_tris = new int3*[count];
+        thread_tri_markers = new int*[count];
+        thread_triangle_count = new int[count];
+        thread_triangle_size = new int[count];
+        thread_edges = new int2*[count];
+        thread_edge_markers = new int*[count];
+        thread_edges_count = new int[count];
+        thread_edges_size = new int[count];
+        for(int i = 0; i < count; i++)
+        {
+          thread_triangle_size[i] = std::max(triangle_size / count, 1000);
+          thread_tris[i] = (int3*) malloc(sizeof(int3) * thread_triangle_size[i]);
+          thread_tri_markers[i] = (int*) malloc(sizeof(int) * thread_triangle_size[i]);
+          thread_triangle_count[i] = 0;
+
+          thread_edges_size[i] = std::max(edges_size / count, 1000);
+          thread_edges[i] = (int2*) malloc(sizeof(int2) * thread_edges_size[i]);
+          thread_edge_markers[i] = (int*) malloc(sizeof(int) * thread_edges_size[i]);
+          thread_edges_count[i] = 0;
+        }
+      }
+
+      void LinearizerBase::merge_thread_buffers()
+      {
+        int total_triangles = triangle_count, total_edges = edges_count;
+        for(int i = 0; i < thread_buffer_count; i++)
+        {
+          total_triangles += thread_triangle_count[i];
+          total_edges += thread_edges_count[i];
+        }
+
+        if(total_triangles > triangle_size)
+        {
+          tris = (int3*) realloc(tris, sizeof(int3) * total_triangles);
+          tri_markers = (int*) realloc(tri_markers, sizeof(int) * (triangle_size = total_triangles));
+        }
+        if(total_edges > edges_size)
+        {
+          edges = (int2*) realloc(edges, sizeof(int2) * total_edges);
+          edge_markers = (int*) realloc(edge_markers, sizeof(int) * (edges_size = total_edges));
+        }
+
+        for(int i = 0; i < thread_buffer_count; i++)
+        {
+          memcpy(tris + triangle_count, thread_tris[i], sizeof(int3) * thread_triangle_count[i]);
+          memcpy(tri_markers + triangle_count, thread_tri_markers[i], sizeof(int) * thread_triangle_count[i]);
+          triangle_count += thread_triangle_count[i];
+
+          memcpy(edges + edges_count, thread_edges[i], sizeof(int2) * thread_edges_count[i]);
+          memcpy(edge_markers + edges_count, thread_edge_markers[i], sizeof(int) * thread_edges_count[i]);
+          edges_count += thread_edges_count[i];
+        }
+      }
+
+      void LinearizerBase::free_thread_buffers()
+      {
+        for(int i = 0; i < thread_buffer_count; i++)
+        {
+          ::free(thread_tris[i]);
+          ::free(thread_tri_markers[i]);
+          ::free(thread_edges[i]);
+          ::free(thread_edge_markers[i]);
+        }
+        delete [] thread_tris;
+        delete [] thread_tri_markers;
+        delete [] thread_triangle_count;
+        delete [] thread_triangle_size;
+        delete [] thread_edges;
+        delete [] thread_edge_markers;
+        delete [] thread_edges_count;
+        delete [] thread_edges_size;
+        thread_tris = NULL;
+        thread_tri_markers = NULL;
+        thread_triangle_count = NULL;
+        thread_triangle_size = NULL;
+        thread_edges = NULL;
+        thread_edge_markers = NULL;
+        thread_edges_count = NULL;
+        thread_edges_size = NULL;
+        thread_buffer_count = 0;
+      }
+
       void LinearizerBase::add_edge(int iv1, int iv2, int marker)
       {
+        if(thread_buffer_count > 0)
+        {
+          int thread = omp_get_thread_num();
+          if(thread_edges_count[thread] >= thread_edges_size[thread])
+          {
+            thread_edges[thread] = (int2*) realloc(thread_edges[thread], sizeof(int2) * (thread_edges_size[thread] * 2));
+            thread_edge_markers[thread] = (int*) realloc(thread_edge_markers[thread], sizeof(int) * (thread_edges_size[thread] = thread_edges_size[thread] * 2));
+          }
+          int index = thread_edges_count[thread]++;
+          thread_edges[thread][index][0] = iv1;
+          thread_edges[thread][index][1] = iv2;
+          thread_edge_markers[thread][index] = marker;
+          return;
+        }
+
 #pragma omp critical(realloc_edges)
         {
           if(edges_count >= edges_size)
@@ -188,6 +377,26 @@ namespace Hermes
       {
         // search for a vertex with parents p1, p2
         if(p1 > p2) std::swap(p1, p2);
+
+        if(intern_table != NULL)
+        {
+          unsigned int mask = (unsigned int)intern_capacity - 1;
+          unsigned int pos = intern_hash(p1, p2) & mask;
+          int64_t check = (int64_t)intern_check(p1, p2) << 32;
+          while(true)
+          {
+            int64_t word = intern_table[pos];
+            if(word == -1)
+              return -1;
+            if((word & ((int64_t)0xffffffff << 32)) == check)
+            {
+              int i = (int)(word & 0xffffffff);
+              if(info[i][0] == p1 && info[i][1] == p2) return i;
+            }
+            pos = (pos + 1) & mask;
+          }
+        }
+
         int index = hash(p1, p2);
         int i = hash_table[index];
         while (i >= 0)
@@ -200,6 +409,22 @@ namespace Hermes
 
       void LinearizerBase::add_triangle(int iv0, int iv1, int iv2, int marker)
       {
+        if(thread_buffer_count > 0)
+        {
+          int thread = omp_get_thread_num();
+          if(thread_triangle_count[thread] >= thread_triangle_size[thread])
+          {
+            thread_tris[thread] = (int3*) realloc(thread_tris[thread], sizeof(int3) * (thread_triangle_size[thread] * 2));
+            thread_tri_markers[thread] = (int*) realloc(thread_tri_markers[thread], sizeof(int) * (thread_triangle_size[thread] = thread_triangle_size[thread] * 2));
+          }
+          int index = thread_triangle_count[thread]++;
+          thread_tris[thread][index][0] = iv0;
+          thread_tris[thread][index][1] = iv1;
+          thread_tris[thread][index][2] = iv2;
+          thread_tri_markers[thread][index] = marker;
+          return;
+        }
+
         int index;
 #pragma omp critical(realloc_triangles)
         {
@@ -229,6 +454,43 @@ namespace Hermes
         return (984120265*p1 + 125965121*p2) & (vertex_size - 1);
       }
 
+      unsigned int LinearizerBase::intern_hash(int p1, int p2)
+      {
+        return 984120265u * (unsigned int)p1 + 125965121u * (unsigned int)p2;
+      }
+
+      unsigned int LinearizerBase::intern_check(int p1, int p2)
+      {
+        return 941083987u * (unsigned int)p1 ^ 805306457u * (unsigned int)p2;
+      }
+
+      void LinearizerBase::init_intern_table()
+      {
+        // The vertex arrays bound the number of insertions, so with a capacity of
+        // the next power of two above one and a half of their size the load factor
+        // stays well below one.
+        int capacity = 1024;
+        while(capacity < vertex_size + vertex_size / 2)
+          capacity *= 2;
+        if(intern_table == NULL || intern_capacity != capacity)
+        {
+          intern_table = (int64_t*) realloc(intern_table, sizeof(int64_t) * capacity);
+          intern_capacity = capacity;
+        }
+        // All ones marks an empty slot.
+        memset(intern_table, 0xff, sizeof(int64_t) * capacity);
+      }
+
+      void LinearizerBase::free_intern_table()
+      {
+        if(intern_table != NULL)
+        {
+          ::free(intern_table);
+          intern_table = NULL;
+          intern_capacity = 0;
+        }
+      }
+
       void LinearizerBase::set_max_absolute_value(double max_abs)
       {
         if(max_abs < 0.0)
@@ -243,14 +505,44 @@ namespace Hermes
 
       double LinearizerBase::get_min_value() const
       {
+        if(this->double_buffering)
+          return front_min_val;
         return min_val;
       }
 
       double LinearizerBase::get_max_value() const
       {
+        if(this->double_buffering)
+          return front_max_val;
         return max_val;
       }
 
+      void LinearizerBase::vtk_write_binary_floats(FILE* f, float* data, int count)
+      {
+        int one = 1;
+        if(*(char*)&one)
+          for(int i = 0; i < count; i++)
+          {
+            char* p = (char*)(data + i);
+            std::swap(p[0], p[3]);
+            std::swap(p[1], p[2]);
+          }
+        fwrite(data, sizeof(float), count, f);
+      }
+
+      void LinearizerBase::vtk_write_binary_ints(FILE* f, int* data, int count)
+      {
+        int one = 1;
+        if(*(char*)&one)
+          for(int i = 0; i < count; i++)
+          {
+            char* p = (char*)(data + i);
+            std::swap(p[0], p[3]);
+            std::swap(p[1], p[2]);
+          }
+        fwrite(data, sizeof(int), count, f);
+      }
+
       void LinearizerBase::calc_aabb(double* x, double* y, int stride, int num, double* min_x, double* max_x, double* min_y, double* max_y)
       {
         *min_x = *max_x = *x;
@@ -269,26 +561,38 @@ namespace Hermes
 
       int3* LinearizerBase::get_triangles()
       {
+        if(this->double_buffering)
+          return this->front_tris;
         return this->tris;
       }
 			int* LinearizerBase::get_triangle_markers()
 			{
+        if(this->double_buffering)
+          return this->front_tri_markers;
 				return this->tri_markers;
 			}
       int LinearizerBase::get_num_triangles()
       {
+        if(this->double_buffering)
+          return this->front_triangle_count;
         return this->triangle_count;
       }
       int2* LinearizerBase::get_edges()
       {
+        if(this->double_buffering)
+          return this->front_edges;
         return this->edges;
       }
 			int* LinearizerBase::get_edge_markers()
 			{
+        if(this->double_buffering)
+          return this->front_edge_markers;
 				return this->edge_markers;
 			}
       int LinearizerBase::get_num_edges()
       {
+        if(this->double_buffering)
+          return this->front_edges_count;
         return this->edges_count;
       }
     }
@@ -0,0 +1,281 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "global.h"
+#include "offscreen_renderer.h"
+#include "view_data.cpp"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    namespace Views
+    {
+      typedef unsigned int dword;
+      typedef unsigned short word;
+
+      const word BITMAP_ID = 0x4D42;
+
+#pragma pack(1)
+
+      struct BitmapFileHeader
+      {
+        word  type;
+        dword size;
+        word  reserved1;
+        word  reserved2;
+        dword off_bits;
+      };
+
+      struct BitmapInfoHeader
+      {
+        dword size;
+        dword width;
+        dword height;
+        word  planes;
+        word  bit_count;
+        dword compression;
+        dword size_image;
+        dword xdpi;
+        dword ydpi;
+        dword clr_used;
+        dword clr_important;
+      };
+
+#pragma pack()
+
+      OffscreenRenderer::OffscreenRenderer(int width, int height)
+      {
+        this->width = width;
+        this->height = height;
+        margin = 15;
+        pal_type = H2DV_PT_HUESCALE;
+        pal_steps = 50;
+        range_auto = true;
+        range_min = 0;
+        range_max = 1;
+      }
+
+      void OffscreenRenderer::set_palette(ViewPaletteType type)
+      {
+        if(type < H2DV_PT_DEFAULT || type >= H2DV_PT_MAX_ID)
+          throw Hermes::Exceptions::Exception("Invalid palette type.");
+        pal_type = type;
+      }
+
+      void OffscreenRenderer::set_num_palette_steps(int num)
+      {
+        pal_steps = num;
+      }
+
+      void OffscreenRenderer::set_min_max_range(double min, double max)
+      {
+        if(max < min)
+          std::swap(min, max);
+        range_min = min;
+        range_max = max;
+        range_auto = false;
+      }
+
+      void OffscreenRenderer::auto_min_max_range()
+      {
+        range_auto = true;
+      }
+
+      void OffscreenRenderer::get_palette_color(double x, float* color)
+      {
+        if(pal_type == H2DV_PT_HUESCALE || pal_type == H2DV_PT_DEFAULT) { //default color
+          if(x < 0.0) x = 0.0;
+          else if(x > 1.0) x = 1.0;
+          x *= num_pal_entries;
+          int n = (int)x;
+          color[0] = palette_data[n][0];
+          color[1] = palette_data[n][1];
+          color[2] = palette_data[n][2];
+        }
+        else if(pal_type == H2DV_PT_GRAYSCALE)
+          color[0] = color[1] = color[2] = (float)x;
+        else if(pal_type == H2DV_PT_INVGRAYSCALE)
+          color[0] = color[1] = color[2] = (float)(1.0 - x);
+        else
+          color[0] = color[1] = color[2] = 1.0f;
+      }
+
+      void OffscreenRenderer::save_bitmap(Linearizer* lin, const char* filename)
+      {
+        if(lin == NULL)
+          throw Hermes::Exceptions::NullException(1);
+
+        lin->lock_data();
+
+        int3* tris = lin->get_triangles();
+        int num_tris = lin->get_num_triangles();
+        double3* verts = lin->get_vertices();
+        float3* verts_f32 = lin->get_vertices_f32();
+        if(num_tris <= 0 || (verts == NULL && verts_f32 == NULL))
+        {
+          lin->unlock_data();
+          throw Hermes::Exceptions::Exception("The linearizer is empty, process a solution first.");
+        }
+
+        double min_x, max_x, min_y, max_y;
+        lin->calc_vertices_aabb(&min_x, &max_x, &min_y, &max_y);
+
+        double value_min = range_min, value_max = range_max;
+        if(range_auto)
+        {
+          value_min = lin->get_min_value();
+          value_max = lin->get_max_value();
+        }
+        double value_irange = 1.0 / (value_max - value_min);
+        // special case: constant solution
+        if(fabs(value_min - value_max) < 1e-8)
+          value_irange = 1.0;
+
+        // Fit the mesh AABB into the image, preserving the aspect ratio.
+        double mesh_w = max_x - min_x, mesh_h = max_y - min_y;
+        if(mesh_w < 1e-12) mesh_w = 1e-12;
+        if(mesh_h < 1e-12) mesh_h = 1e-12;
+        double scale = std::min((width - 2 * margin) / mesh_w, (height - 2 * margin) / mesh_h);
+        double offset_x = (width - mesh_w * scale) * 0.5;
+        double offset_y = (height - mesh_h * scale) * 0.5;
+
+        // 4 bytes per pixel, rows bottom-up as in the .BMP file. White background.
+        unsigned char* pixels = (unsigned char*) malloc(4 * width * height);
+        if(pixels == NULL)
+          throw Hermes::Exceptions::Exception("Could not allocate memory for pixel data");
+        memset(pixels, 0xff, 4 * width * height);
+
+        float color[3];
+        for (int i = 0; i < num_tris; i++)
+        {
+          double px[3], py[3], pv[3];
+          for (int j = 0; j < 3; j++)
+          {
+            int idx = tris[i][j];
+            double x, y, v;
+            if(verts != NULL)
+            {
+              x = verts[idx][0]; y = verts[idx][1]; v = verts[idx][2];
+            }
+            else
+            {
+              x = verts_f32[idx][0]; y = verts_f32[idx][1]; v = verts_f32[idx][2];
+            }
+            px[j] = offset_x + (x - min_x) * scale;
+            py[j] = offset_y + (y - min_y) * scale;
+            pv[j] = v;
+          }
+
+          double denom = (py[1] - py[2]) * (px[0] - px[2]) + (px[2] - px[1]) * (py[0] - py[2]);
+          if(fabs(denom) < 1e-12)
+            continue;
+
+          int x0 = (int) floor(std::min(px[0], std::min(px[1], px[2])));
+          int x1 = (int) ceil (std::max(px[0], std::max(px[1], px[2])));
+          int y0 = (int) floor(std::min(py[0], std::min(py[1], py[2])));
+          int y1 = (int) ceil (std::max(py[0], std::max(py[1], py[2])));
+          if(x0 < 0) x0 = 0;
+          if(y0 < 0) y0 = 0;
+          if(x1 > width - 1) x1 = width - 1;
+          if(y1 > height - 1) y1 = height - 1;
+
+          for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+            {
+              double cx = x + 0.5, cy = y + 0.5;
+              double l0 = ((py[1] - py[2]) * (cx - px[2]) + (px[2] - px[1]) * (cy - py[2])) / denom;
+              double l1 = ((py[2] - py[0]) * (cx - px[2]) + (px[0] - px[2]) * (cy - py[2])) / denom;
+              double l2 = 1.0 - l0 - l1;
+              if(l0 < -1e-9 || l1 < -1e-9 || l2 < -1e-9)
+                continue;
+
+              double value = l0 * pv[0] + l1 * pv[1] + l2 * pv[2];
+              double t = (value - value_min) * value_irange;
+              // quantize the same way the palette texture with pal_steps entries does
+              if(pal_steps > 0)
+              {
+                if(t < 0.0) t = 0.0;
+                else if(t > 1.0) t = 1.0;
+                t = ((int) (t * pal_steps) + 0.5) / pal_steps;
+              }
+              get_palette_color(t, color);
+
+              unsigned char* pixel = pixels + 4 * (y * width + x);
+              pixel[0] = (unsigned char) (255.0f * color[2]);
+              pixel[1] = (unsigned char) (255.0f * color[1]);
+              pixel[2] = (unsigned char) (255.0f * color[0]);
+              pixel[3] = 255;
+            }
+        }
+
+        lin->unlock_data();
+
+        // Write the pixels as a 32bpp .BMP, the same layout View::save_screenshot() produces.
+        FILE* file = fopen(filename, "wb");
+        if(file == NULL)
+        {
+          free(pixels);
+          throw Hermes::Exceptions::Exception("Could not open '%s' for writing", filename);
+        }
+
+        BitmapFileHeader file_header;
+        BitmapInfoHeader info_header;
+
+        file_header.type = BITMAP_ID;
+        file_header.size = sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader) +
+          4 * width * height;
+        file_header.reserved1 = file_header.reserved2 = 0;
+        file_header.off_bits = 14 + 40; // length of both headers
+
+        info_header.size = sizeof(BitmapInfoHeader);
+        info_header.width = width;
+        info_header.height = height;
+        info_header.planes = 1;
+        info_header.bit_count = 32; // 4 bytes per pixel = 32 bits
+        info_header.compression = 0;
+        info_header.size_image = width * height * 4;
+        info_header.xdpi = 2835; // 72 dpi
+        info_header.ydpi = 2835; // 72 dpi
+        info_header.clr_used = 0;
+        info_header.clr_important = 0;
+
+        if(fwrite(&file_header, sizeof(file_header), 1, file) != 1
+          || fwrite(&info_header, sizeof(info_header), 1, file) != 1
+          || fwrite(pixels, 1, info_header.size_image, file) != info_header.size_image)
+        {
+          fclose(file);
+          free(pixels);
+          throw Hermes::Exceptions::Exception("Error writing bitmap data");
+        }
+
+        fclose(file);
+        free(pixels);
+      }
+
+      void OffscreenRenderer::save_numbered_bitmap(Linearizer* lin, const char* format, int number)
+      {
+        if(strstr(format, "%") == NULL)
+          throw Hermes::Exceptions::Exception("Wrong format for the numbered bitmap.");
+        char buffer[1024];
+        sprintf(buffer, format, number);
+        save_bitmap(lin, buffer);
+      }
+    }
+  }
+}
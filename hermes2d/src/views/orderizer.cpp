@@ -16,8 +16,11 @@
 #include "orderizer.h"
 #include "space.h"
 #include "refmap.h"
+#include "api2d.h"
 #include "linear_data.cpp"
 
+#define CHUNKSIZE 1
+
 namespace Hermes
 {
   namespace Hermes2D
@@ -143,66 +146,157 @@ namespace Hermes
         ltext = (char**) realloc(ltext, sizeof(char*) * label_size);
         lbox = (double2*) realloc(lbox, sizeof(double2) * label_size);
 
-        int oo, o[6];
-
-        RefMap refmap;
-        refmap.set_quad_2d(&quad_ord);
-
-        // make a mesh illustrating the distribution of polynomial orders over the space
+        // Collect the active elements and compute the per-element offsets into the
+        // vertex / triangle / label arrays. Every element contributes a fixed
+        // number of vertices and triangles given by its mode, so the layout is
+        // known up front and the element loop below can fill the arrays in
+        // parallel without locking; only the edges, whose count depends on the
+        // orientation test, go through the critical section of add_edge().
+        Element** elements = new Element*[nn];
+        int* vertex_offset = new int[nn];
+        int* triangle_offset = new int[nn];
+        int ne = 0, nv = 0, nt = 0;
         Element* e;
         for_all_active_elements(e, mesh)
         {
-          oo = o[4] = o[5] = space->get_element_order(e->id);
-          for (unsigned int k = 0; k < e->get_nvert(); k++)
-            o[k] = space->get_edge_order(e, k);
+          elements[ne] = e;
+          vertex_offset[ne] = nv;
+          triangle_offset[ne] = nt;
+          nv += quad_ord.get_num_points(type, e->get_mode());
+          nt += num_elem[e->get_mode()][type];
+          ne++;
+        }
+        vertex_count = nv;
+        triangle_count = nt;
+        label_count = ne;
 
-          refmap.set_active_element(e);
-          double* x = refmap.get_phys_x(type);
-          double* y = refmap.get_phys_y(type);
+        int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
 
-          double3* pt = quad_ord.get_points(type, e->get_mode());
-          int np = quad_ord.get_num_points(type, e->get_mode());
-          int id[80];
-          assert(np <= 80);
+        // make a mesh illustrating the distribution of polynomial orders over the space
+#pragma omp parallel num_threads(num_threads_used)
+        {
+          int oo, o[6];
+
+          RefMap refmap;
+          refmap.set_quad_2d(&quad_ord);
 
-          int mode = e->get_mode();
-          if(e->is_quad())
+          int element_i;
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+          for (element_i = 0; element_i < ne; element_i++)
           {
-            o[4] = H2D_GET_H_ORDER(oo);
-            o[5] = H2D_GET_V_ORDER(oo);
-          }
-          make_vert(lvert[label_count], x[0], y[0], o[4]);
+            Element* e = elements[element_i];
 
-          for (int i = 1; i < np; i++)
-            make_vert(id[i-1], x[i], y[i], o[(int) pt[i][2]]);
+            oo = o[4] = o[5] = space->get_element_order(e->id);
+            for (unsigned int k = 0; k < e->get_nvert(); k++)
+              o[k] = space->get_edge_order(e, k);
 
-          for (int i = 0; i < num_elem[mode][type]; i++)
-            this->add_triangle(id[ord_elem[mode][type][i][0]], id[ord_elem[mode][type][i][1]], id[ord_elem[mode][type][i][2]], o[4], e->marker);
+            refmap.set_active_element(e);
+            double* x = refmap.get_phys_x(type);
+            double* y = refmap.get_phys_y(type);
 
-          for (int i = 0; i < num_edge[mode][type]; i++)
-          {
-            if(e->en[ord_edge[mode][type][i][2]]->bnd || (y[ord_edge[mode][type][i][0] + 1] < y[ord_edge[mode][type][i][1] + 1]) ||
-              ((y[ord_edge[mode][type][i][0] + 1] == y[ord_edge[mode][type][i][1] + 1]) &&
-              (x[ord_edge[mode][type][i][0] + 1] < x[ord_edge[mode][type][i][1] + 1])))
+            double3* pt = quad_ord.get_points(type, e->get_mode());
+            int np = quad_ord.get_num_points(type, e->get_mode());
+            int id[80];
+            assert(np <= 80);
+
+            int mode = e->get_mode();
+            if(e->is_quad())
             {
-              LinearizerBase::add_edge(id[ord_edge[mode][type][i][0]], id[ord_edge[mode][type][i][1]], e->en[ord_edge[mode][type][i][2]]->marker);
+              o[4] = H2D_GET_H_ORDER(oo);
+              o[5] = H2D_GET_V_ORDER(oo);
             }
-          }
 
-          double xmin = 1e100, ymin = 1e100, xmax = -1e100, ymax = -1e100;
-          for (unsigned int k = 0; k < e->get_nvert(); k++)
-          {
-            if(e->vn[k]->x < xmin) xmin = e->vn[k]->x;
-            if(e->vn[k]->x > xmax) xmax = e->vn[k]->x;
-            if(e->vn[k]->y < ymin) ymin = e->vn[k]->y;
-            if(e->vn[k]->y > ymax) ymax = e->vn[k]->y;
+            int base = vertex_offset[element_i];
+            verts[base][0] = x[0];
+            verts[base][1] = y[0];
+            verts[base][2] = o[4];
+            lvert[element_i] = base;
+
+            for (int i = 1; i < np; i++)
+            {
+              id[i-1] = base + i;
+              verts[base + i][0] = x[i];
+              verts[base + i][1] = y[i];
+              verts[base + i][2] = o[(int) pt[i][2]];
+            }
+
+            for (int i = 0; i < num_elem[mode][type]; i++)
+            {
+              int index = triangle_offset[element_i] + i;
+              tris[index][0] = id[ord_elem[mode][type][i][0]];
+              tris[index][1] = id[ord_elem[mode][type][i][1]];
+              tris[index][2] = id[ord_elem[mode][type][i][2]];
+              tris_orders[index] = o[4];
+              tri_markers[index] = e->marker;
+            }
+
+            for (int i = 0; i < num_edge[mode][type]; i++)
+            {
+              if(e->en[ord_edge[mode][type][i][2]]->bnd || (y[ord_edge[mode][type][i][0] + 1] < y[ord_edge[mode][type][i][1] + 1]) ||
+                ((y[ord_edge[mode][type][i][0] + 1] == y[ord_edge[mode][type][i][1] + 1]) &&
+                (x[ord_edge[mode][type][i][0] + 1] < x[ord_edge[mode][type][i][1] + 1])))
+              {
+                LinearizerBase::add_edge(id[ord_edge[mode][type][i][0]], id[ord_edge[mode][type][i][1]], e->en[ord_edge[mode][type][i][2]]->marker);
+              }
+            }
+
+            double xmin = 1e100, ymin = 1e100, xmax = -1e100, ymax = -1e100;
+            for (unsigned int k = 0; k < e->get_nvert(); k++)
+            {
+              if(e->vn[k]->x < xmin) xmin = e->vn[k]->x;
+              if(e->vn[k]->x > xmax) xmax = e->vn[k]->x;
+              if(e->vn[k]->y < ymin) ymin = e->vn[k]->y;
+              if(e->vn[k]->y > ymax) ymax = e->vn[k]->y;
+            }
+            lbox[element_i][0] = xmax - xmin;
+            lbox[element_i][1] = ymax - ymin;
+            ltext[element_i] = labels[o[4]][o[5]];
           }
-          lbox[label_count][0] = xmax - xmin;
-          lbox[label_count][1] = ymax - ymin;
-          ltext[label_count++] = labels[o[4]][o[5]];
         }
 
-        refmap.set_quad_2d(&g_quad_2d_std);
+        delete [] elements;
+        delete [] vertex_offset;
+        delete [] triangle_offset;
+      }
+
+      template<typename Scalar>
+      void Orderizer::get_element_orders(const Space<Scalar>* space, Hermes::vector<int>& element_ids, Hermes::vector<int>& element_orders)
+      {
+        if(space == NULL) throw Hermes::Exceptions::Exception("Space is NULL in Orderizer::get_element_orders().");
+
+        if(!space->is_up_to_date())
+          throw Hermes::Exceptions::Exception("The space is not up to date.");
+
+        Mesh* mesh = space->get_mesh();
+
+        element_ids.clear();
+        element_orders.clear();
+        element_ids.reserve(mesh->get_num_active_elements());
+        element_orders.reserve(mesh->get_num_active_elements());
+
+        Element* e;
+        for_all_active_elements(e, mesh)
+        {
+          element_ids.push_back(e->id);
+          element_orders.push_back(space->get_element_order(e->id));
+        }
+      }
+
+      template<typename Scalar>
+      void Orderizer::save_orders_txt(const Space<Scalar>* space, const char* file_name)
+      {
+        Hermes::vector<int> element_ids;
+        Hermes::vector<int> element_orders;
+        get_element_orders(space, element_ids, element_orders);
+
+        FILE* f = fopen(file_name, "wb");
+        if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", file_name);
+
+        fprintf(f, "# element_id h_order v_order\n");
+        for (unsigned int i = 0; i < element_ids.size(); i++)
+          fprintf(f, "%d %d %d\n", element_ids[i], H2D_GET_H_ORDER(element_orders[i]), H2D_GET_V_ORDER(element_orders[i]));
+
+        fclose(f);
       }
 
       void Orderizer::add_triangle(int iv0, int iv1, int iv2, int order, int marker)
@@ -270,7 +364,7 @@ namespace Hermes
       }
 
       template<typename Scalar>
-      void Orderizer::save_orders_vtk(const Space<Scalar>* space, const char* file_name)
+      void Orderizer::save_orders_vtk(const Space<Scalar>* space, const char* file_name, bool binary)
       {
         process_space(space);
 
@@ -278,17 +372,30 @@ namespace Hermes
         if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", file_name);
         lock_data();
 
+        // the export is written in many small pieces, a large stream buffer keeps
+        // the number of write syscalls low
+        setvbuf(f, NULL, _IOFBF, 1 << 20);
+
         // Output header for vertices.
         fprintf(f, "# vtk DataFile Version 2.0\n");
         fprintf(f, "\n");
-        fprintf(f, "ASCII\n\n");
+        fprintf(f, binary ? "BINARY\n\n" : "ASCII\n\n");
         fprintf(f, "DATASET UNSTRUCTURED_GRID\n");
 
         // Output vertices.
         fprintf(f, "POINTS %d %s\n", this->vertex_count, "float");
         for (int i = 0; i < this->vertex_count; i++)
         {
-          fprintf(f, "%g %g %g\n", this->verts[i][0], this->verts[i][1], 0.0);
+          if(binary)
+          {
+            float xyz[3];
+            xyz[0] = (float) this->verts[i][0];
+            xyz[1] = (float) this->verts[i][1];
+            xyz[2] = 0.0f;
+            vtk_write_binary_floats(f, xyz, 3);
+          }
+          else
+            fprintf(f, "%g %g %g\n", this->verts[i][0], this->verts[i][1], 0.0);
         }
 
         // Output elements.
@@ -296,7 +403,17 @@ namespace Hermes
         fprintf(f, "CELLS %d %d\n", this->triangle_count, 4 * this->triangle_count);
         for (int i = 0; i < this->triangle_count; i++)
         {
-          fprintf(f, "3 %d %d %d\n", this->tris[i][0], this->tris[i][1], this->tris[i][2]);
+          if(binary)
+          {
+            int cell[4];
+            cell[0] = 3;
+            cell[1] = this->tris[i][0];
+            cell[2] = this->tris[i][1];
+            cell[3] = this->tris[i][2];
+            vtk_write_binary_ints(f, cell, 4);
+          }
+          else
+            fprintf(f, "3 %d %d %d\n", this->tris[i][0], this->tris[i][1], this->tris[i][2]);
         }
 
         // Output cell types.
@@ -304,7 +421,13 @@ namespace Hermes
         fprintf(f, "CELL_TYPES %d\n", this->triangle_count);
         for (int i = 0; i < this->triangle_count; i++)
         {
-          fprintf(f, "5\n");    // The "5" means triangle in VTK.
+          if(binary)
+          {
+            int type = 5;     // The "5" means triangle in VTK.
+            vtk_write_binary_ints(f, &type, 1);
+          }
+          else
+            fprintf(f, "5\n");    // The "5" means triangle in VTK.
         }
 
         // This outputs double solution values. Look into Hermes2D/src/output/vtk.cpp
@@ -315,7 +438,13 @@ namespace Hermes
         fprintf(f, "LOOKUP_TABLE %s\n", "default");
         for (int i = 0; i < this->triangle_count; i++)
         {
-          fprintf(f, "%i\n", this->tris_orders[i]);
+          if(binary)
+          {
+            float order = (float) this->tris_orders[i];
+            vtk_write_binary_floats(f, &order, 1);
+          }
+          else
+            fprintf(f, "%i\n", this->tris_orders[i]);
         }
 
         unlock_data();
@@ -323,7 +452,7 @@ namespace Hermes
       }
 
       template<typename Scalar>
-      void Orderizer::save_mesh_vtk(const Space<Scalar>* space, const char* file_name)
+      void Orderizer::save_mesh_vtk(const Space<Scalar>* space, const char* file_name, bool binary)
       {
         process_space(space);
 
@@ -331,29 +460,63 @@ namespace Hermes
         if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", file_name);
         lock_data();
 
+        // the export is written in many small pieces, a large stream buffer keeps
+        // the number of write syscalls low
+        setvbuf(f, NULL, _IOFBF, 1 << 20);
+
         // Output header for vertices.
         fprintf(f, "# vtk DataFile Version 2.0\n");
         fprintf(f, "\n");
-        fprintf(f, "ASCII\n\n");
+        fprintf(f, binary ? "BINARY\n\n" : "ASCII\n\n");
         fprintf(f, "DATASET UNSTRUCTURED_GRID\n");
 
         // Output vertices.
         fprintf(f, "POINTS %d %s\n", this->vertex_count, "float");
         for (int i = 0; i < this->vertex_count; i++)
-          fprintf(f, "%g %g %g\n", this->verts[i][0], this->verts[i][1], 0.0);
+        {
+          if(binary)
+          {
+            float xyz[3];
+            xyz[0] = (float) this->verts[i][0];
+            xyz[1] = (float) this->verts[i][1];
+            xyz[2] = 0.0f;
+            vtk_write_binary_floats(f, xyz, 3);
+          }
+          else
+            fprintf(f, "%g %g %g\n", this->verts[i][0], this->verts[i][1], 0.0);
+        }
 
         // Output elements.
         fprintf(f, "\n");
         fprintf(f, "CELLS %d %d\n", this->edges_count, + 3 * this->edges_count);
         for (int i = 0; i < this->edges_count; i++)
-          fprintf(f, "2 %d %d\n", this->edges[i][0], this->edges[i][1]);
+        {
+          if(binary)
+          {
+            int cell[3];
+            cell[0] = 2;
+            cell[1] = this->edges[i][0];
+            cell[2] = this->edges[i][1];
+            vtk_write_binary_ints(f, cell, 3);
+          }
+          else
+            fprintf(f, "2 %d %d\n", this->edges[i][0], this->edges[i][1]);
+        }
 
         // Output cell types.
         fprintf(f, "\n");
         fprintf(f, "CELL_TYPES %d\n", this->edges_count);
 
         for (int i = 0; i < this->edges_count; i++)
-          fprintf(f, "3\n");    // The "5" means triangle in VTK.
+        {
+          if(binary)
+          {
+            int type = 3;     // The "3" means line in VTK.
+            vtk_write_binary_ints(f, &type, 1);
+          }
+          else
+            fprintf(f, "3\n");    // The "3" means line in VTK.
+        }
 
         // This outputs double solution values. Look into Hermes2D/src/output/vtk.cpp
         // for how it is done for vectors.
@@ -362,7 +525,15 @@ namespace Hermes
         fprintf(f, "SCALARS %s %s %d\n", "Mesh", "float", 1);
         fprintf(f, "LOOKUP_TABLE %s\n", "default");
         for (int i = 0; i < this->edges_count; i++)
-          fprintf(f, "0 \n");
+        {
+          if(binary)
+          {
+            float zero = 0.0f;
+            vtk_write_binary_floats(f, &zero, 1);
+          }
+          else
+            fprintf(f, "0 \n");
+        }
         unlock_data();
         fclose(f);
       }
@@ -391,12 +562,16 @@ namespace Hermes
         return this->vertex_count;
       }
 
-      template HERMES_API void Orderizer::save_orders_vtk<double>(const Space<double>* space, const char* file_name);
-      template HERMES_API void Orderizer::save_orders_vtk<std::complex<double> >(const Space<std::complex<double> >* space, const char* file_name);
-      template HERMES_API void Orderizer::save_mesh_vtk<double>(const Space<double>* space, const char* file_name);
-      template HERMES_API void Orderizer::save_mesh_vtk<std::complex<double> >(const Space<std::complex<double> >* space, const char* file_name);
+      template HERMES_API void Orderizer::save_orders_vtk<double>(const Space<double>* space, const char* file_name, bool binary);
+      template HERMES_API void Orderizer::save_orders_vtk<std::complex<double> >(const Space<std::complex<double> >* space, const char* file_name, bool binary);
+      template HERMES_API void Orderizer::save_mesh_vtk<double>(const Space<double>* space, const char* file_name, bool binary);
+      template HERMES_API void Orderizer::save_mesh_vtk<std::complex<double> >(const Space<std::complex<double> >* space, const char* file_name, bool binary);
       template HERMES_API void Orderizer::process_space<double>(const Space<double>* space);
       template HERMES_API void Orderizer::process_space<std::complex<double> >(const Space<std::complex<double> >* space);
+      template HERMES_API void Orderizer::get_element_orders<double>(const Space<double>* space, Hermes::vector<int>& element_ids, Hermes::vector<int>& element_orders);
+      template HERMES_API void Orderizer::get_element_orders<std::complex<double> >(const Space<std::complex<double> >* space, Hermes::vector<int>& element_ids, Hermes::vector<int>& element_orders);
+      template HERMES_API void Orderizer::save_orders_txt<double>(const Space<double>* space, const char* file_name);
+      template HERMES_API void Orderizer::save_orders_txt<std::complex<double> >(const Space<std::complex<double> >* space, const char* file_name);
     }
   }
 }
\ No newline at end of file
@@ -59,6 +59,8 @@ namespace Hermes
         show_values = true;
         lin_updated = false;
         gl_coord_buffer = 0; gl_index_buffer = 0; gl_edge_inx_buffer = 0;
+        gl_verts_shadow = NULL; gl_verts_shadow_cnt = 0;
+        gl_tris_shadow = NULL; gl_tris_shadow_cnt = 0;
 
         do_zoom_to_fit = true;
         is_constant = false;
@@ -115,6 +117,8 @@ namespace Hermes
       ScalarView::~ScalarView()
       {
         delete [] normals;
+        delete [] gl_verts_shadow;
+        delete [] gl_tris_shadow;
         vertex_nodes.clear();
         delete lin;
       }
@@ -162,10 +166,18 @@ namespace Hermes
           lin->set_max_absolute_value(std::max(fabs(range_min), fabs(range_max)));
 
         lin->set_displacement(xdisp, ydisp, dmult);
-        lin->lock_data();
+
+        // With double buffering the linearizer publishes its data itself and the
+        // lock is needed just for reading the published arrays below, so a renderer
+        // running on another thread is not blocked while process_solution() works.
+        if(!lin->get_double_buffering())
+          lin->lock_data();
 
         lin->process_solution(sln, item, eps);
 
+        if(lin->get_double_buffering())
+          lin->lock_data();
+
         update_mesh_info();
 
         // Initialize mesh nodes for displaying and selection.
@@ -656,6 +668,29 @@ namespace Hermes
         }
       }
 
+      /// Uploads only the byte ranges of 'data' that differ from 'shadow' into the
+      /// buffer currently bound to 'target'. Modified ranges closer to each other
+      /// than the merge threshold are coalesced into a single glBufferSubData call,
+      /// so scattered small changes do not degenerate into thousands of uploads.
+      static void upload_buffer_deltas(GLenum target, const char* data, const char* shadow, size_t size)
+      {
+        const size_t merge_gap = 1024;
+        size_t i = 0;
+        while (i < size)
+        {
+          if(data[i] == shadow[i]) { i++; continue; }
+          size_t start = i;
+          size_t last_diff = i;
+          while (i < size && i - last_diff < merge_gap)
+          {
+            if(data[i] != shadow[i])
+              last_diff = i;
+            i++;
+          }
+          glBufferSubDataARB(target, start, last_diff - start + 1, data + start);
+        }
+      }
+
       void ScalarView::prepare_gl_geometry()
       {
         if(lin_updated)
@@ -675,7 +710,8 @@ namespace Hermes
               throw std::runtime_error("ARB_vertex_buffer_object not supported");
 
             //reallocate indices
-            if(gl_index_buffer == 0 || tri_cnt > max_gl_tris)
+            bool index_realloc = (gl_index_buffer == 0 || tri_cnt > max_gl_tris);
+            if(index_realloc)
             {
               if(gl_index_buffer == 0)
                 glGenBuffersARB(1, &gl_index_buffer);
@@ -691,10 +727,9 @@ namespace Hermes
               glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, gl_index_buffer);
             }
 
-            //fill indices
-            GLuint* gl_triangle = (GLuint*)glMapBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, GL_WRITE_ONLY_ARB);
-            if(gl_triangle == NULL)
-              throw std::runtime_error("unable to map index buffer: " + glGetError());
+            //build the compacted index data on the CPU side, so that it can be
+            //diffed against what the buffer already contains
+            unsigned int* new_tris = new unsigned int[tri_cnt * 3];
             gl_tri_cnt = 0;
             for(int i = 0; i < tri_cnt; i++)
             {
@@ -704,17 +739,26 @@ namespace Hermes
               const double3& vert_c = verts[triangle[2]];
               if(finite(vert_a[2]) && finite(vert_b[2]) && finite(vert_c[2]))
               {
-                gl_triangle[0] = (GLint)triangle[0];
-                gl_triangle[1] = (GLint)triangle[1];
-                gl_triangle[2] = (GLint)triangle[2];
+                new_tris[3 * gl_tri_cnt + 0] = (unsigned int)triangle[0];
+                new_tris[3 * gl_tri_cnt + 1] = (unsigned int)triangle[1];
+                new_tris[3 * gl_tri_cnt + 2] = (unsigned int)triangle[2];
                 gl_tri_cnt++;
-                gl_triangle += 3; //three indices per triangle
               }
             }
-            glUnmapBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB);
+
+            //upload indices: everything after a reallocation or a count change,
+            //only the changed ranges otherwise
+            if(index_realloc || gl_tris_shadow == NULL || gl_tris_shadow_cnt != 3 * gl_tri_cnt)
+              glBufferSubDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0, sizeof(GLuint) * 3 * gl_tri_cnt, new_tris);
+            else
+              upload_buffer_deltas(GL_ELEMENT_ARRAY_BUFFER_ARB, (const char*)new_tris, (const char*)gl_tris_shadow, sizeof(GLuint) * 3 * gl_tri_cnt);
+            delete [] gl_tris_shadow;
+            gl_tris_shadow = new_tris;
+            gl_tris_shadow_cnt = 3 * gl_tri_cnt;
 
             //reallocate vertices
-            if(gl_coord_buffer == 0 || vert_cnt > max_gl_verts)
+            bool coord_realloc = (gl_coord_buffer == 0 || vert_cnt > max_gl_verts);
+            if(coord_realloc)
             {
               if(gl_coord_buffer == 0)
                 glGenBuffersARB(1, &gl_coord_buffer);
@@ -730,13 +774,18 @@ namespace Hermes
               glBindBufferARB(GL_ARRAY_BUFFER_ARB, gl_coord_buffer);
             }
 
-            //fill vertices
-            GLVertex2* gl_verts = (GLVertex2*)glMapBufferARB(GL_ARRAY_BUFFER_ARB, GL_WRITE_ONLY_ARB);
-            if(gl_verts == NULL)
-              throw std::runtime_error("unable to map coord buffer: " + glGetError());
+            //build the vertex data and upload it the same way as the indices
+            GLVertex2* new_verts = new GLVertex2[vert_cnt];
             for(int i = 0; i < vert_cnt; i++)
-              gl_verts[i] = GLVertex2((float)verts[i][0], (float)verts[i][1], (float)((verts[i][2] - range_min) * value_irange));
-            glUnmapBufferARB(GL_ARRAY_BUFFER_ARB);
+              new_verts[i] = GLVertex2((float)verts[i][0], (float)verts[i][1], (float)((verts[i][2] - range_min) * value_irange));
+
+            if(coord_realloc || gl_verts_shadow == NULL || gl_verts_shadow_cnt != vert_cnt)
+              glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, 0, sizeof(GLVertex2) * vert_cnt, new_verts);
+            else
+              upload_buffer_deltas(GL_ARRAY_BUFFER_ARB, (const char*)new_verts, (const char*)gl_verts_shadow, sizeof(GLVertex2) * vert_cnt);
+            delete [] gl_verts_shadow;
+            gl_verts_shadow = new_verts;
+            gl_verts_shadow_cnt = vert_cnt;
 
             //allocate edge indices
             if(gl_edge_inx_buffer == 0)
@@ -757,6 +806,8 @@ namespace Hermes
             if(gl_coord_buffer) { glDeleteBuffersARB(1, &gl_coord_buffer); gl_coord_buffer = 0; }
             if(gl_index_buffer) { glDeleteBuffersARB(1, &gl_index_buffer); gl_index_buffer = 0; }
             if(gl_edge_inx_buffer) { glDeleteBuffersARB(1, &gl_edge_inx_buffer); gl_edge_inx_buffer = 0; }
+            if(gl_verts_shadow) { delete [] gl_verts_shadow; gl_verts_shadow = NULL; gl_verts_shadow_cnt = 0; }
+            if(gl_tris_shadow) { delete [] gl_tris_shadow; gl_tris_shadow = NULL; gl_tris_shadow_cnt = 0; }
           }
         }
       }
@@ -1164,12 +1215,18 @@ namespace Hermes
         x *= l; y *= l; z *= l;
       }
 
+      static inline void normalize(float& x, float& y, float& z)
+      {
+        float l = (float) (1.0 / sqrt(sqr(x) + sqr(y) + sqr(z)));
+        x *= l; y *= l; z *= l;
+      }
+
       void ScalarView::calculate_normals(double3* vert, int num_verts, int3* tris, int num_tris)
       {
         if(normals != NULL)
           delete [] normals;
-        normals = new double3[num_verts];
-        memset(normals, 0, sizeof(double3) * num_verts);
+        normals = new float3[num_verts];
+        memset(normals, 0, sizeof(float3) * num_verts);
         for (int i = 0; i < num_tris; i++)
         {
           int3 &tri = tris[i];
@@ -1188,9 +1245,9 @@ namespace Hermes
 
           for (int j = 0; j < 3; j++)
           {
-            normals[tri[j]][0] += nx;
-            normals[tri[j]][1] += ny;
-            normals[tri[j]][2] += nz;
+            normals[tri[j]][0] += (float) nx;
+            normals[tri[j]][1] += (float) ny;
+            normals[tri[j]][2] += (float) nz;
           }
         }
 
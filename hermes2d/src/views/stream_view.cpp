@@ -15,6 +15,7 @@
 
 #ifndef NOGLUT
 #include <GL/freeglut.h>
+#include <map>
 #include "global.h"
 #include "stream_view.h"
 
@@ -35,6 +36,8 @@ namespace Hermes
         root_x_max = -1e100;
         root_y_max = -1e100;
         root = NULL;
+        tri_neighbors = NULL;
+        last_tri = -1;
       }
 
       StreamView::StreamView(char* title, WinGeom* wg)
@@ -48,6 +51,8 @@ namespace Hermes
         root_x_max = -1e100;
         root_y_max = -1e100;
         root = NULL;
+        tri_neighbors = NULL;
+        last_tri = -1;
       }
 
       void StreamView::show(MeshFunction<double>* xsln, MeshFunction<double>* ysln, int marker, double step, double eps)
@@ -162,13 +167,76 @@ namespace Hermes
         }
       }
 
+      void StreamView::build_neighbors()
+      {
+        int3* xtris = vec->get_triangles();
+        int num_tris = vec->get_num_triangles();
+
+        delete [] tri_neighbors;
+        tri_neighbors = new int[3 * num_tris];
+        for (int i = 0; i < 3 * num_tris; i++)
+          tri_neighbors[i] = -1;
+        last_tri = -1;
+
+        // Pair up the triangles sharing an edge. Edge e of a triangle connects
+        // its vertices e and (e+1)%3.
+        std::map<std::pair<int, int>, int> edge_map;
+        for (int i = 0; i < num_tris; i++)
+          for (int e = 0; e < 3; e++)
+          {
+            int v1 = xtris[i][e], v2 = xtris[i][(e + 1) % 3];
+            std::pair<int, int> key(std::min(v1, v2), std::max(v1, v2));
+            std::map<std::pair<int, int>, int>::iterator found = edge_map.find(key);
+            if(found == edge_map.end())
+              edge_map[key] = 3 * i + e;
+            else
+            {
+              tri_neighbors[3 * i + e] = found->second / 3;
+              tri_neighbors[found->second] = i;
+              edge_map.erase(found);
+            }
+          }
+      }
+
+      int StreamView::find_triangle_walk(double x, double y, double3& bar)
+      {
+        if(tri_neighbors != NULL && last_tri >= 0)
+        {
+          int t = last_tri;
+          int num_tris = vec->get_num_triangles();
+          for (int steps = 0; steps < num_tris; steps++)
+          {
+            // is_in_triangle() leaves the signed barycentric coordinates in bar
+            // also on a miss - the most negative one points away from the target.
+            if(is_in_triangle(t, x, y, bar))
+            {
+              last_tri = t;
+              return t;
+            }
+            int worst = 0;
+            if(bar[1] < bar[worst]) worst = 1;
+            if(bar[2] < bar[worst]) worst = 2;
+            // The edge opposite vertex 'worst' connects the two other vertices.
+            int next = tri_neighbors[3 * t + (worst + 1) % 3];
+            if(next < 0)
+              break;  // left the domain (or a non-convex pocket), let the tree decide
+            t = next;
+          }
+        }
+
+        int found = find_triangle_in_tree(x, y, root, root_x_min, root_x_max, root_y_min, root_y_max, bar);
+        if(found >= 0)
+          last_tri = found;
+        return found;
+      }
+
       bool StreamView::get_solution_values(double x, double y, double& xval, double& yval)
       {
         double4* vert = vec->get_vertices();
         int3* xtris = vec->get_triangles();
         double3 bar;
         int e_idx;
-        if((e_idx = find_triangle_in_tree(x, y, root, root_x_min, root_x_max, root_y_min, root_y_max, bar)) == -1) return false;
+        if((e_idx = find_triangle_walk(x, y, bar)) == -1) return false;
         int3& tri = xtris[e_idx];
         xval = bar[0] * vert[tri[0]][2] + bar[1] * vert[tri[1]][2] + bar[2] * vert[tri[2]][2];
         yval = bar[0] * vert[tri[0]][3] + bar[1] * vert[tri[1]][3] + bar[2] * vert[tri[2]][3];
@@ -187,6 +255,10 @@ namespace Hermes
 
       int StreamView::create_streamline(double x_start, double y_start, int idx)
       {
+        // A new starting point is unrelated to the previous streamline,
+        // locate it through the tree and walk from there.
+        last_tri = -1;
+
         double ODE_EPS = 1e-5;
         double tau = initial_tau;
         double x = x_start;
@@ -407,6 +479,7 @@ namespace Hermes
         this->tick();
         root = new Node;
         build_tree();
+        build_neighbors();
 
         double2* initial_points;
         find_initial_points(marker, step, initial_points);
@@ -608,6 +681,7 @@ namespace Hermes
       StreamView::~StreamView()
       {
         delete_tree(root);
+        delete [] tri_neighbors;
         for (int i = 0; i < num_stream; i++)
           delete [] streamlines[i];
         delete [] streamlines;
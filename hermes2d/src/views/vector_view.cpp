@@ -75,10 +75,16 @@ namespace Hermes
         
         vec->set_displacement(xdisp, ydisp, dmult);
 
-        vec->lock_data();
+        // With double buffering the vectorizer publishes its data itself and the lock
+        // is needed just for reading the published arrays below, so a renderer running
+        // on another thread is not blocked while process_solution() works.
+        if(!vec->get_double_buffering())
+          vec->lock_data();
         vec->process_solution(xsln, ysln, xitem, yitem, eps);
-        
-        if(range_auto) 
+
+        if(vec->get_double_buffering())
+          vec->lock_data();
+        if(range_auto)
         { 
           range_min = vec->get_min_value();
           range_max = vec->get_max_value(); 
@@ -39,6 +39,12 @@ namespace Hermes
         dashes_count = dashes_size = 0;
         xdisp = NULL;
         ydisp = NULL;
+        reuse_topology = false;
+        topology_valid = false;
+        front_verts = NULL;
+        front_vertex_size = 0;
+        front_dashes = NULL;
+        front_dashes_count = front_dashes_size = 0;
       }
 
       int Vectorizer::get_vertex(int p1, int p2, double x, double y, double xvalue, double yvalue)
@@ -482,6 +488,11 @@ namespace Hermes
         return this->curvature_epsilon;
       }
 
+      void Vectorizer::set_topology_reuse(bool to_set)
+      {
+        this->reuse_topology = to_set;
+      }
+
       void Vectorizer::process_solution(MeshFunction<double>* xsln, MeshFunction<double>* ysln, int xitem_orig, int yitem_orig, double eps)
       {
         // Important, sets the current caughtException to NULL.
@@ -491,9 +502,75 @@ namespace Hermes
         if(xsln == NULL || ysln == NULL) 
           throw Hermes::Exceptions::Exception("One of the solutions is NULL in Vectorizer:process_solution().");
 
-        lock_data();
+        // With double buffering the build works on arrays no reader touches, the
+        // data lock is only taken for the publishing copy at the end.
+        if(!this->double_buffering)
+          lock_data();
         this->tick();
 
+        // When the stored triangulation was built for the same meshes, items and accuracy,
+        // keep it and only re-evaluate the vertex values - typically in a time-dependent
+        // calculation on a fixed mesh, where the adaptive refinement walk below would
+        // arrive at the very same triangulation again.
+        if(this->reuse_topology && this->topology_valid && !this->empty
+          && this->xdisp == NULL && this->ydisp == NULL
+          && xsln->get_mesh()->get_seq() == this->last_xsln_seq
+          && ysln->get_mesh()->get_seq() == this->last_ysln_seq
+          && this->last_eps == eps && this->last_xitem == xitem_orig && this->last_yitem == yitem_orig)
+        {
+          double* px = new double[this->vertex_count];
+          double* py = new double[this->vertex_count];
+          double* xv = new double[this->vertex_count];
+          double* yv = new double[this->vertex_count];
+          for (int i = 0; i < this->vertex_count; i++)
+          {
+            px[i] = verts[i][0];
+            py[i] = verts[i][1];
+          }
+
+          try
+          {
+            xsln->eval_points(px, py, this->vertex_count, xv, xitem_orig);
+            ysln->eval_points(px, py, this->vertex_count, yv, yitem_orig);
+          }
+          catch(...)
+          {
+            delete [] px;
+            delete [] py;
+            delete [] xv;
+            delete [] yv;
+            this->topology_valid = false;
+            if(!this->double_buffering)
+              unlock_data();
+            throw;
+          }
+
+          for (int i = 0; i < this->vertex_count; i++)
+          {
+            verts[i][2] = xv[i];
+            verts[i][3] = yv[i];
+            double m = sqrt(sqr(xv[i]) + sqr(yv[i]));
+            if(finite(m) && fabs(m) > max)
+              max = fabs(m);
+          }
+
+          delete [] px;
+          delete [] py;
+          delete [] xv;
+          delete [] yv;
+
+          find_min_max();
+          if(this->double_buffering)
+            this->publish_buffers();
+          else
+            unlock_data();
+          return;
+        }
+
+        // the stored topology is clobbered by the full rebuild below; it becomes valid
+        // again only once the rebuild finishes.
+        this->topology_valid = false;
+
         // initialization
         this->xitem = xitem_orig;
         this->yitem = yitem_orig;
@@ -625,7 +702,7 @@ namespace Hermes
         int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
 #pragma omp parallel shared(trav_masterMax) private(state_i) num_threads(num_threads_used)
         {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
           for(state_i = 0; state_i < num_states; state_i++)
           {
             try
@@ -679,9 +756,13 @@ namespace Hermes
           trav[i].stack = trav_master.stack;
         }
 
+        // per-thread triangle and edge buffers, as in the Linearizer - the threads append
+        // locally and the buffers are merged once the traversal is finished.
+        this->init_thread_buffers(num_threads_used);
+
 #pragma omp parallel shared(trav_master) private(state_i) num_threads(num_threads_used)
         {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
           for(state_i = 0; state_i < num_states; state_i++)
           {
             if(this->caughtException != NULL)
@@ -770,6 +851,11 @@ namespace Hermes
         delete [] trfs;
         delete [] trav;
 
+        // move the buffered triangles and edges into the shared arrays; the
+        // regularization below runs serially on the shared arrays again.
+        this->merge_thread_buffers();
+        this->free_thread_buffers();
+
         // regularize the linear mesh
         for (int i = 0; i < this->triangle_count; i++)
         {
@@ -788,7 +874,10 @@ namespace Hermes
         find_min_max();
 
         //if(verbose_mode) print_hash_stats();
-        unlock_data();
+        if(this->double_buffering)
+          this->publish_buffers();
+        else
+          unlock_data();
 
         // select old quadratrues
         xsln->set_quad_2d(old_quad_x);
@@ -801,6 +890,14 @@ namespace Hermes
         // clean up
         ::free(this->hash_table);
         ::free(this->info);
+
+        // remember what the triangulation was built for, for set_topology_reuse().
+        this->last_xsln_seq = xsln->get_mesh()->get_seq();
+        this->last_ysln_seq = ysln->get_mesh()->get_seq();
+        this->last_eps = eps;
+        this->last_xitem = xitem_orig;
+        this->last_yitem = yitem_orig;
+        this->topology_valid = (this->caughtException == NULL);
       }
 
       void Vectorizer::free()
@@ -815,6 +912,19 @@ namespace Hermes
           ::free(dashes);
           dashes = NULL;
         }
+        if(front_verts != NULL)
+        {
+          ::free(front_verts);
+          front_verts = NULL;
+          front_vertex_size = 0;
+        }
+        if(front_dashes != NULL)
+        {
+          ::free(front_dashes);
+          front_dashes = NULL;
+          front_dashes_count = front_dashes_size = 0;
+        }
+        topology_valid = false;
 
         LinearizerBase::free();
       }
@@ -826,27 +936,60 @@ namespace Hermes
 
       void Vectorizer::calc_vertices_aabb(double* min_x, double* max_x, double* min_y, double* max_y) const
       {
-        if(verts == NULL)
+        double4* v = this->double_buffering ? this->front_verts : this->verts;
+        int count = this->double_buffering ? this->front_vertex_count : this->vertex_count;
+        if(v == NULL)
           throw Exceptions::Exception("Cannot calculate AABB from NULL vertices");
 
-        LinearizerBase::calc_aabb(&verts[0][0], &verts[0][1], sizeof(double4), this->vertex_count, min_x, max_x, min_y, max_y);
+        LinearizerBase::calc_aabb(&v[0][0], &v[0][1], sizeof(double4), count, min_x, max_x, min_y, max_y);
+      }
+
+      void Vectorizer::publish_buffers()
+      {
+        lock_data();
+        publish_base_buffers();
+
+        if(this->vertex_count > this->front_vertex_size)
+        {
+          this->front_vertex_size = this->vertex_size;
+          this->front_verts = (double4*) realloc(this->front_verts, sizeof(double4) * this->front_vertex_size);
+        }
+        memcpy(this->front_verts, this->verts, sizeof(double4) * this->vertex_count);
+
+        if(this->dashes_count > this->front_dashes_size)
+        {
+          this->front_dashes_size = this->dashes_size;
+          this->front_dashes = (int2*) realloc(this->front_dashes, sizeof(int2) * this->front_dashes_size);
+        }
+        memcpy(this->front_dashes, this->dashes, sizeof(int2) * this->dashes_count);
+        this->front_dashes_count = this->dashes_count;
+
+        unlock_data();
       }
 
       int2* Vectorizer::get_dashes()
       {
+        if(this->double_buffering)
+          return this->front_dashes;
         return this->dashes;
       }
       int Vectorizer::get_num_dashes()
       {
+        if(this->double_buffering)
+          return this->front_dashes_count;
         return this->dashes_size;
       }
 
       double4* Vectorizer::get_vertices()
       {
+        if(this->double_buffering)
+          return this->front_verts;
         return this->verts;
       }
       int Vectorizer::get_num_vertices()
       {
+        if(this->double_buffering)
+          return this->front_vertex_count;
         return this->vertex_count;
       }
 
@@ -123,10 +123,24 @@ namespace Hermes
         this->forms.back()->set_ext(newExt);
         this->forms.back()->wf = this;
 
+        // User-provided clone() implementations do not necessarily copy the
+        // assembling metadata.
+        this->forms.back()->is_linear = otherWf->forms[i]->is_linear;
+        this->forms.back()->depends_on_time = otherWf->forms[i]->depends_on_time;
+        this->forms.back()->depends_on_ext = otherWf->forms[i]->depends_on_ext;
+
         if(dynamic_cast<MatrixFormVol<Scalar>*>(otherWf->forms[i]) != NULL)
+        {
           this->mfvol.push_back(dynamic_cast<MatrixFormVol<Scalar>*>(this->forms.back()));
+          // User-provided clone() implementations do not necessarily copy this flag.
+          this->mfvol.back()->const_coefficient = (dynamic_cast<MatrixFormVol<Scalar>*>(otherWf->forms[i]))->const_coefficient;
+        }
         if(dynamic_cast<MatrixFormSurf<Scalar>*>(otherWf->forms[i]) != NULL)
+        {
           this->mfsurf.push_back(dynamic_cast<MatrixFormSurf<Scalar>*>(this->forms.back()));
+          // User-provided clone() implementations do not necessarily copy this flag.
+          this->mfsurf.back()->const_coefficient = (dynamic_cast<MatrixFormSurf<Scalar>*>(otherWf->forms[i]))->const_coefficient;
+        }
         if(dynamic_cast<MatrixFormDG<Scalar>*>(otherWf->forms[i]) != NULL)
           this->mfDG.push_back(dynamic_cast<MatrixFormDG<Scalar>*>(this->forms.back()));
 
@@ -183,6 +197,11 @@ namespace Hermes
     {
       areas.push_back(HERMES_ANY);
       stage_time = 0.0;
+      any_area = true;
+      is_linear = false;
+      depends_on_time = true;
+      depends_on_ext = true;
+      material_coefficient = Scalar(0.);
     }
 
     template<typename Scalar>
@@ -202,6 +221,48 @@ namespace Hermes
       return stage_time;
     }
 
+    template<typename Scalar>
+    void Form<Scalar>::set_linear(bool to_set)
+    {
+      this->is_linear = to_set;
+    }
+
+    template<typename Scalar>
+    bool Form<Scalar>::get_linear() const
+    {
+      return this->is_linear;
+    }
+
+    template<typename Scalar>
+    void Form<Scalar>::set_time_dependent(bool to_set)
+    {
+      this->depends_on_time = to_set;
+    }
+
+    template<typename Scalar>
+    bool Form<Scalar>::get_time_dependent() const
+    {
+      return this->depends_on_time;
+    }
+
+    template<typename Scalar>
+    void Form<Scalar>::set_ext_dependent(bool to_set)
+    {
+      this->depends_on_ext = to_set;
+    }
+
+    template<typename Scalar>
+    bool Form<Scalar>::get_ext_dependent() const
+    {
+      return this->depends_on_ext;
+    }
+
+    template<typename Scalar>
+    void Form<Scalar>::set_material_coefficient(std::string area, Scalar value)
+    {
+      this->material_coefficients[area] = value;
+    }
+
     template<typename Scalar>
     void Form<Scalar>::set_area(std::string area)
     {
@@ -280,7 +341,7 @@ namespace Hermes
 
     template<typename Scalar>
     MatrixFormVol<Scalar>::MatrixFormVol(unsigned int i, unsigned int j) :
-    MatrixForm<Scalar>(i, j)
+    MatrixForm<Scalar>(i, j), const_coefficient(false)
     {
     }
 
@@ -301,6 +362,25 @@ namespace Hermes
       return this->sym;
     }
 
+    template<typename Scalar>
+    void MatrixFormVol<Scalar>::set_const_coefficient(bool to_set)
+    {
+      this->const_coefficient = to_set;
+    }
+
+    template<typename Scalar>
+    bool MatrixFormVol<Scalar>::get_const_coefficient() const
+    {
+      return this->const_coefficient;
+    }
+
+    template<typename Scalar>
+    bool MatrixFormVol<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **base_fns, int base_cnt,
+      Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar** result) const
+    {
+      return false;
+    }
+
     template<typename Scalar>
     MatrixFormVol<Scalar>* MatrixFormVol<Scalar>::clone() const
     {
@@ -310,8 +390,27 @@ namespace Hermes
 
     template<typename Scalar>
     MatrixFormSurf<Scalar>::MatrixFormSurf(unsigned int i, unsigned int j) :
-    MatrixForm<Scalar>(i, j)
+    MatrixForm<Scalar>(i, j), const_coefficient(false)
+    {
+    }
+
+    template<typename Scalar>
+    void MatrixFormSurf<Scalar>::set_const_coefficient(bool to_set)
+    {
+      this->const_coefficient = to_set;
+    }
+
+    template<typename Scalar>
+    bool MatrixFormSurf<Scalar>::get_const_coefficient() const
     {
+      return this->const_coefficient;
+    }
+
+    template<typename Scalar>
+    bool MatrixFormSurf<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[], Func<double> **base_fns, int base_cnt,
+      Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar** result) const
+    {
+      return false;
     }
 
     template<typename Scalar>
@@ -417,6 +516,13 @@ namespace Hermes
     {
     }
 
+    template<typename Scalar>
+    bool VectorFormSurf<Scalar>::value_block(int n, double *wt, Func<Scalar> *u_ext[],
+      Func<double> **test_fns, int test_cnt, Geom<double> *e, Func<Scalar> **ext, Scalar* result) const
+    {
+      return false;
+    }
+
     template<typename Scalar>
     VectorFormSurf<Scalar>* VectorFormSurf<Scalar>::clone() const
     {
@@ -21,10 +21,84 @@ namespace Hermes
   {
     namespace WeakFormsH1
     {
+      AxisymWeightCache::AxisymWeightCache()
+        : weights(NULL), points(NULL), capacity(0), cached_id(-1), cached_n(-1),
+        cached_x0(0.), cached_y0(0.), cached_wt0(0.), np(0)
+      {
+      }
+
+      AxisymWeightCache::AxisymWeightCache(const AxisymWeightCache& other)
+        : weights(NULL), points(NULL), capacity(0), cached_id(-1), cached_n(-1),
+        cached_x0(0.), cached_y0(0.), cached_wt0(0.), np(0)
+      {
+      }
+
+      AxisymWeightCache::~AxisymWeightCache()
+      {
+        if(weights != NULL)
+          delete [] weights;
+        if(points != NULL)
+          delete [] points;
+      }
+
+      int AxisymWeightCache::prepare(int n, double *wt, Geom<double> *e, GeomType gt)
+      {
+        // The assembler calls value() once per shape-function pair of the element,
+        // always with the same quadrature data - the folded weights can be reused.
+        // The id and point count alone do not identify the data: multimesh
+        // assembling revisits the element once per union-mesh sub-element, so the
+        // first physical point and weight are compared as well.
+        if(e->id == cached_id && n == cached_n
+          && e->x[0] == cached_x0 && e->y[0] == cached_y0 && wt[0] == cached_wt0)
+          return np;
+
+        if(n > capacity)
+        {
+          if(weights != NULL)
+            delete [] weights;
+          if(points != NULL)
+            delete [] points;
+          weights = new double[n];
+          points = new int[n];
+          capacity = n;
+        }
+
+        const double* r = (gt == HERMES_AXISYM_X) ? e->y : e->x;
+
+        double max_w = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+          double w = std::abs(wt[i] * r[i]);
+          if(w > max_w)
+            max_w = w;
+        }
+
+        // Points whose radius-scaled weight cannot influence the sum at double
+        // precision are dropped; this prunes points sitting on or next to the axis.
+        double threshold = 1e-14 * max_w;
+        np = 0;
+        for (int i = 0; i < n; i++)
+        {
+          double w = wt[i] * r[i];
+          if(std::abs(w) <= threshold)
+            continue;
+          weights[np] = w;
+          points[np] = i;
+          np++;
+        }
+
+        cached_id = e->id;
+        cached_n = n;
+        cached_x0 = e->x[0];
+        cached_y0 = e->y[0];
+        cached_wt0 = wt[0];
+        return np;
+      }
+
       template<>
       DefaultMatrixFormVol<double>::DefaultMatrixFormVol
         (int i, int j, std::string area, Hermes2DFunction<double>* coeff, SymFlag sym, GeomType gt)
-        : MatrixFormVol<double>(i, j), coeff(coeff), gt(gt)
+        : MatrixFormVol<double>(i, j), coeff(coeff), gt(gt), axisym_weight_caching(false)
       {
         this->set_area(area);
         this->setSymFlag(sym);
@@ -35,7 +109,7 @@ namespace Hermes
       template<>
       DefaultMatrixFormVol<std::complex<double> >::DefaultMatrixFormVol
         (int i, int j, std::string area, Hermes2DFunction<std::complex<double> >* coeff, SymFlag sym, GeomType gt)
-        : MatrixFormVol<std::complex<double> >(i, j), coeff(coeff), gt(gt)
+        : MatrixFormVol<std::complex<double> >(i, j), coeff(coeff), gt(gt), axisym_weight_caching(false)
       {
         this->set_area(area);
         this->setSymFlag(sym);
@@ -49,7 +123,7 @@ namespace Hermes
       DefaultMatrixFormVol<double>::DefaultMatrixFormVol
         (int i, int j, Hermes::vector<std::string> areas,
         Hermes2DFunction<double>* coeff, SymFlag sym, GeomType gt)
-        : MatrixFormVol<double>(i, j), coeff(coeff), gt(gt)
+        : MatrixFormVol<double>(i, j), coeff(coeff), gt(gt), axisym_weight_caching(false)
       {
         this->set_areas(areas);
         this->setSymFlag(sym);
@@ -62,7 +136,7 @@ namespace Hermes
       DefaultMatrixFormVol<std::complex<double> >::DefaultMatrixFormVol
         (int i, int j, Hermes::vector<std::string> areas,
         Hermes2DFunction<std::complex<double> >* coeff, SymFlag sym, GeomType gt)
-        : MatrixFormVol<std::complex<double> >(i, j), coeff(coeff), gt(gt)
+        : MatrixFormVol<std::complex<double> >(i, j), coeff(coeff), gt(gt), axisym_weight_caching(false)
       {
         this->set_areas(areas);
         this->setSymFlag(sym);
@@ -85,11 +159,22 @@ namespace Hermes
       {
         Scalar result = 0;
         if(gt == HERMES_PLANAR) {
+          // Constant coefficient: use the vectorized kernel.
+          if(coeff->is_constant())
+            return coeff->value(0.0, 0.0) * quadrature_product(n, wt, u->val, v->val);
           for (int i = 0; i < n; i++) {
             result += wt[i] * coeff->value(e->x[i], e->y[i]) * u->val[i] * v->val[i];
           }
         }
         else {
+          if(axisym_weight_caching) {
+            int np = axisym_cache.prepare(n, wt, e, gt);
+            for (int k = 0; k < np; k++) {
+              int i = axisym_cache.points[k];
+              result += axisym_cache.weights[k] * coeff->value(e->x[i], e->y[i]) * u->val[i] * v->val[i];
+            }
+            return result;
+          }
           if(gt == HERMES_AXISYM_X) {
             for (int i = 0; i < n; i++) {
               result += wt[i] * e->y[i] * coeff->value(e->x[i], e->y[i]) * u->val[i] * v->val[i];
@@ -105,6 +190,12 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      void DefaultMatrixFormVol<Scalar>::set_axisym_weight_caching(bool to_set)
+      {
+        this->axisym_weight_caching = to_set;
+      }
+
       template<typename Scalar>
       Ord DefaultMatrixFormVol<Scalar>::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u,
         Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const
@@ -141,26 +232,34 @@ namespace Hermes
       DefaultJacobianDiffusion<Scalar>::DefaultJacobianDiffusion(int i, int j, std::string area,
         Hermes1DFunction<Scalar>* coeff,
         SymFlag sym, GeomType gt)
-        : MatrixFormVol<Scalar>(i, j), idx_j(j), coeff(coeff), gt(gt)
+        : MatrixFormVol<Scalar>(i, j), idx_j(j), coeff(coeff), gt(gt), axisym_weight_caching(false)
       {
         this->set_area(area);
         this->setSymFlag(sym);
-        
+
         // If coeff is HERMES_ONE, initialize it to be constant 1.0.
         if(coeff == HERMES_ONE)
           this->coeff = new Hermes1DFunction<Scalar>(1.0);
+
+        // A constant coefficient makes the local matrices cacheable.
+        if(this->coeff->is_constant() && gt == HERMES_PLANAR)
+          this->set_const_coefficient(true);
       };
 
       template<typename Scalar>
       DefaultJacobianDiffusion<Scalar>::DefaultJacobianDiffusion(int i, int j, Hermes::vector<std::string> areas,
         Hermes1DFunction<Scalar>* coeff, SymFlag sym, GeomType gt)
-        : MatrixFormVol<Scalar>(i, j), idx_j(j), coeff(coeff), gt(gt)
+        : MatrixFormVol<Scalar>(i, j), idx_j(j), coeff(coeff), gt(gt), axisym_weight_caching(false)
       {
         this->set_areas(areas);
         this->setSymFlag(sym);
-        
+
         // If coeff is HERMES_ONE, initialize it to be constant 1.0.
         if(coeff == HERMES_ONE) this->coeff = new Hermes1DFunction<Scalar>(1.0);
+
+        // A constant coefficient makes the local matrices cacheable.
+        if(this->coeff->is_constant() && gt == HERMES_PLANAR)
+          this->set_const_coefficient(true);
       }
 
       template<typename Scalar>
@@ -175,6 +274,9 @@ namespace Hermes
       {
         Scalar result = 0;
         if(gt == HERMES_PLANAR) {
+          // Constant coefficient: the derivative term vanishes, use the vectorized kernel.
+          if(coeff->is_constant())
+            return coeff->value(Scalar(0.0)) * quadrature_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy);
           for (int i = 0; i < n; i++) {
             result += wt[i] * (coeff->derivative(u_ext[idx_j]->val[i]) * u->val[i] *
               (u_ext[idx_j]->dx[i] * v->dx[i] + u_ext[idx_j]->dy[i] * v->dy[i])
@@ -183,6 +285,17 @@ namespace Hermes
           }
         }
         else {
+          if(axisym_weight_caching) {
+            int np = axisym_cache.prepare(n, wt, e, gt);
+            for (int k = 0; k < np; k++) {
+              int i = axisym_cache.points[k];
+              result += axisym_cache.weights[k] * (coeff->derivative(u_ext[idx_j]->val[i]) * u->val[i] *
+                (u_ext[idx_j]->dx[i] * v->dx[i] + u_ext[idx_j]->dy[i] * v->dy[i])
+                + coeff->value(u_ext[idx_j]->val[i])
+                * (u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i]));
+            }
+            return result;
+          }
           if(gt == HERMES_AXISYM_X) {
             for (int i = 0; i < n; i++) {
               result += wt[i] * e->y[i] * (coeff->derivative(u_ext[idx_j]->val[i]) * u->val[i] *
@@ -204,6 +317,12 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      void DefaultJacobianDiffusion<Scalar>::set_axisym_weight_caching(bool to_set)
+      {
+        this->axisym_weight_caching = to_set;
+      }
+
       template<typename Scalar>
       Ord DefaultJacobianDiffusion<Scalar>::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
         Geom<Ord> *e, Func<Ord> **ext) const
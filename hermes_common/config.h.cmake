@@ -32,6 +32,9 @@
 #cmakedefine HAVE_NOX
 #cmakedefine HAVE_KOMPLEX
 
+// hot-path instrumentation counters
+#cmakedefine WITH_INSTRUMENTATION
+
 // no logo
 #cmakedefine HERMES_NO_LOGO
 
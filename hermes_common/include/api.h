@@ -24,6 +24,8 @@
 
 #include "compat.h"
 #include <map>
+#include <vector>
+#include <string>
 
 namespace Hermes
 {
@@ -31,7 +33,24 @@ namespace Hermes
   enum HermesCommonApiParam
   {
     exceptionsPrintCallstack,
-    matrixSolverType
+    matrixSolverType,
+    /// Number of threads a threaded matrix solver backend (currently
+    /// SuperLU_MT) may use. The default 0 means "decide in the backend",
+    /// which falls back to the OMP_NUM_THREADS environment variable.
+    numSolverThreads
+  };
+
+  /// Interface of objects able to report their deep memory usage, i.e. the
+  /// bytes of the structures they own, not just their sizeof. Implemented by
+  /// Mesh, Space, Solution, PrecalcShapeset and CSCMatrix; instances may be
+  /// registered with Api::register_memory_report() to appear in the global
+  /// snapshot.
+  class HERMES_API MemoryAccounted
+  {
+  public:
+    virtual ~MemoryAccounted() {}
+    /// Returns the deep memory usage of this object, in bytes.
+    virtual size_t get_memory_bytes() const = 0;
   };
 
   /// API Class containing settings for the whole HermesCommon.
@@ -40,6 +59,19 @@ namespace Hermes
   public:
     Api();
     ~Api();
+
+    /// Memory telemetry: adds the object to the global registry under the
+    /// given label. Several objects may share a label, their sizes are then
+    /// summed in the snapshot. Only a plain pointer is stored - unregister
+    /// the object before destroying it.
+    void register_memory_report(const std::string& label, const MemoryAccounted* object);
+
+    /// Removes the object from the memory registry; unknown objects are ignored.
+    void unregister_memory_report(const MemoryAccounted* object);
+
+    /// Queries all registered objects and fills label -> bytes into the
+    /// snapshot (cleared first). Returns the overall total in bytes.
+    size_t get_memory_snapshot(std::map<std::string, size_t>& snapshot) const;
   protected:
     /// Parameter class, representing one parameter.
     /// Its identifier is a string identifier according to which, the instance is inserted into Api::parameters.
@@ -58,6 +90,9 @@ namespace Hermes
     /// There should not be any parameters, values of which are sought very often, because of the above reason.
     std::map<HermesCommonApiParam, Parameter*> parameters;
 
+    /// The memory registry, \sa register_memory_report().
+    std::vector<std::pair<std::string, const MemoryAccounted*> > memory_reports;
+
   public:
     int get_integral_param_value(HermesCommonApiParam);
     void set_integral_param_value(HermesCommonApiParam, int value);
@@ -19,6 +19,7 @@
 #define __HERMES_COMMON_ARRAY_H
 
 #include <vector>
+#include <algorithm>
 #include <limits.h>
 
 #ifndef INVALID_IDX
@@ -80,6 +81,19 @@ namespace Hermes
         }
       }
 
+      /// Exchanges the contents with another array in O(1): only the page
+      /// pointers and the bookkeeping are swapped, no items are copied.
+      /// Used e.g. when replacing an array riddled with unused slots by a
+      /// freshly built compact one.
+      void swap(Array& array)
+      {
+        pages.swap(array.pages);
+        unused.swap(array.unused);
+        std::swap(size, array.size);
+        std::swap(nitems, array.nitems);
+        std::swap(append_only, array.append_only);
+      }
+
       /// Removes all elements from the array.
       void free()
       {
@@ -274,6 +288,14 @@ namespace Hermes
       int get_size() const { return size; }
       int get_num_items() const { return nitems; }
 
+      /// Bytes held by the array: the pages with the items themselves plus
+      /// the page pointers and the unused-id list.
+      size_t get_memory_bytes() const
+      {
+        return pages.size() * (sizeof(TYPE*) + HERMES_PAGE_SIZE * sizeof(TYPE))
+          + unused.capacity() * sizeof(int);
+      }
+
       TYPE& get(int id) const { return pages[id >> HERMES_PAGE_BITS][id & HERMES_PAGE_MASK]; }
       TYPE& operator[] (int id) const { return get(id); }
 
@@ -281,53 +303,100 @@ namespace Hermes
 
     /// \brief A light version of the array.
     /// For ordinal types or pointers, does not provide memory handling.
+    ///
+    /// Safe for concurrent readers with a single (externally serialized) writer:
+    /// add() fully builds any new page tables before publishing them with a plain
+    /// pointer store and retires the replaced ones until destruction, and it bumps
+    /// 'size' only after the item and its presence flag have been stored, so that
+    /// present() / get() never see a partially initialized entry.
     template<class TYPE>
     class LightArray
     {
     protected:
-      Hermes::vector<TYPE*> pages; //\todo standard array for maximum access speed
-      Hermes::vector<bool*> presence; //\todo standard array for maximum access speed
+      TYPE** pages;
+      bool** presence;
+      unsigned int page_count;
       unsigned int size;
 
       const unsigned int page_bits;
       const unsigned int page_size;
       const unsigned int page_mask;
 
+      /// Page tables replaced on growth, kept until destruction so that
+      /// concurrent readers still holding them stay valid.
+      struct RetiredTable
+      {
+        TYPE** pages;
+        bool** presence;
+        RetiredTable* next;
+      };
+      RetiredTable* retired;
+
     public:
 
       LightArray(unsigned int page_bits = 9) : page_bits(page_bits), page_size(1 << page_bits), page_mask((1 << page_bits) - 1)
       {
         size = 0;
+        page_count = 0;
+        pages = NULL;
+        presence = NULL;
+        retired = NULL;
       }
 
       ~LightArray()
       {
-        for(unsigned int i = 0; i < pages.size(); i++)
+        for(unsigned int i = 0; i < page_count; i++)
         {
           delete [] pages[i];
           delete [] presence[i];
         }
-        pages.clear();
-        presence.clear();
+        delete [] pages;
+        delete [] presence;
+        while(retired != NULL)
+        {
+          // the pages themselves are shared with the current tables and were
+          // freed above, only the retired page tables are released here
+          RetiredTable* r = retired;
+          retired = r->next;
+          delete [] r->pages;
+          delete [] r->presence;
+          delete r;
+        }
       }
 
       /// Adds a new item to the array.
       void add(TYPE item, unsigned int id)
       {
-        TYPE* temp;
-        while(id >= pages.size() * page_size)
+        if(id >= page_count * page_size)
         {
-          TYPE* new_page = new TYPE[page_size];
-          pages.push_back(new_page);
-
-          bool* new_page_presence = new bool[page_size];
-          memset(new_page_presence, 0, page_size * sizeof(bool));
-          presence.push_back(new_page_presence);
+          unsigned int new_count = (id >> page_bits) + 1;
+          TYPE** new_pages = new TYPE*[new_count];
+          bool** new_presence = new bool*[new_count];
+          for(unsigned int i = 0; i < page_count; i++)
+          {
+            new_pages[i] = pages[i];
+            new_presence[i] = presence[i];
+          }
+          for(unsigned int i = page_count; i < new_count; i++)
+          {
+            new_pages[i] = new TYPE[page_size];
+            new_presence[i] = new bool[page_size];
+            memset(new_presence[i], 0, page_size * sizeof(bool));
+          }
+          if(pages != NULL)
+          {
+            RetiredTable* r = new RetiredTable;
+            r->pages = pages;
+            r->presence = presence;
+            r->next = retired;
+            retired = r;
+          }
+          pages = new_pages;
+          presence = new_presence;
+          page_count = new_count;
         }
 
-        temp = pages[id >> page_bits] + (id & page_mask);
-        *temp = item;
-
+        pages[id >> page_bits][id & page_mask] = item;
         presence[id >> page_bits][id & page_mask] = true;
 
         if(id >= size)
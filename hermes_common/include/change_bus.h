@@ -0,0 +1,112 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file change_bus.h
+\brief Central change-notification bus the generation-stamped caches hang off.
+*/
+#ifndef __HERMES_COMMON_CHANGE_BUS_H
+#define __HERMES_COMMON_CHANGE_BUS_H
+
+#include "compat.h"
+#include <vector>
+
+namespace Hermes
+{
+  /// Channels on which the core data structures publish their changes.
+  enum ChangeChannel
+  {
+    HERMES_CHANGE_MESH = 0,
+    HERMES_CHANGE_SPACE = 1,
+    HERMES_CHANGE_SOLUTION = 2,
+    HERMES_CHANGE_CHANNEL_COUNT = 3
+  };
+
+  /// Interface of objects wanting to be told about changes published on the
+  /// bus. Typical implementors are caches that prefer eager invalidation over
+  /// comparing sequence numbers lazily on every access.
+  class HERMES_API ChangeListener
+  {
+  public:
+    virtual ~ChangeListener() {}
+    /// Called on every publication on a subscribed channel. 'publisher' is
+    /// the object that changed (a Mesh, Space or Solution, depending on the
+    /// channel); a listener caching data of one particular instance can
+    /// compare the pointer and ignore foreign publications.
+    virtual void changed(ChangeChannel channel, const void* publisher) = 0;
+  };
+
+  /// \brief Central change-notification bus.
+  ///
+  /// The individual caches in the library key on the sequence numbers of
+  /// meshes, spaces and solutions independently. The bus complements that
+  /// with one central view of "something changed": Mesh, Space and Solution
+  /// publish every bump of their sequence numbers here, which advances a
+  /// bus-wide generation per channel and notifies the subscribed listeners.
+  ///
+  /// A cache can therefore either subscribe (eager invalidation), or stamp
+  /// its contents with get_generation() when filling them and later verify
+  /// the stamp with check_generation(). The latter is the debugging aid for
+  /// the caching infrastructure: with set_generation_checking() turned on, a
+  /// failed check throws instead of returning false, so a stale read that
+  /// crosses a generation is caught at the point of use.
+  ///
+  /// Publications are expected from serial code (the structures do not
+  /// mutate inside parallel assembly loops); the subscription bookkeeping is
+  /// nevertheless guarded so listeners may come and go from worker threads.
+  class HERMES_API ChangeBus
+  {
+  public:
+    ChangeBus();
+
+    /// Publishes a change of 'publisher' on 'channel': advances the channel
+    /// generation and notifies the subscribed listeners.
+    void publish(ChangeChannel channel, const void* publisher);
+
+    /// Subscribes the listener to one channel. Subscribing twice is allowed
+    /// and means two notifications per publication.
+    void subscribe(ChangeChannel channel, ChangeListener* listener);
+
+    /// Removes the listener from all channels; unknown listeners are ignored.
+    void unsubscribe(ChangeListener* listener);
+
+    /// Returns the current generation of the channel. The value increases by
+    /// one with every publication and never otherwise, so equality of two
+    /// stamps implies nothing was published in between.
+    unsigned int get_generation(ChangeChannel channel) const;
+
+    /// Returns true when the stamp is current for the channel. When the
+    /// generation checking debug mode is on, a stale stamp throws instead,
+    /// identifying the offending cache read.
+    bool check_generation(ChangeChannel channel, unsigned int stamp) const;
+
+    /// Turns the debug mode of check_generation() on / off (default: off).
+    void set_generation_checking(bool to_set = true);
+
+  protected:
+    std::vector<ChangeListener*> listeners[HERMES_CHANGE_CHANNEL_COUNT];
+
+    unsigned int generations[HERMES_CHANGE_CHANNEL_COUNT];
+
+    /// \sa set_generation_checking().
+    bool generation_checking;
+  };
+
+  /// Global instance used by the whole library, following HermesCommonApi.
+  extern HERMES_API Hermes::ChangeBus HermesChangeBus;
+}
+#endif
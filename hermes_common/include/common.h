@@ -21,6 +21,7 @@
 
 #include <complex>
 
+#include <new>
 #include <stdexcept>
 #include <cstdarg>
 #include <stdio.h>
@@ -54,6 +55,7 @@
 #include <signal.h>
 
 #include "config.h"
+#include "compat.h"
 
 #ifdef WITH_OPENMP
   #include <omp.h>
@@ -62,6 +64,62 @@
   inline int omp_get_thread_num( ) { return 0; }
 #endif
 
+/// Alignment (in bytes) of quadrature-point data arrays, sufficient for SSE / AVX loads.
+#define HERMES_SIMD_ALIGNMENT 32
+
+/// Non-aliasing pointer qualifier, allows the compiler to vectorize loops over
+/// quadrature-point data arrays.
+#ifdef _MSC_VER
+  #define HERMES_RESTRICT __restrict
+#else
+  #define HERMES_RESTRICT __restrict__
+#endif
+
+namespace Hermes
+{
+  /// Allocates an aligned block from the thread-local memory pool.
+  /// The Func / Geom quadrature arrays are allocated and released thousands of
+  /// times per assembling pass; the pool keeps the released blocks in per-thread
+  /// free lists bucketed by size, taking malloc / free out of the hot path.
+  HERMES_API void* pool_allocate(size_t size);
+  /// Returns a block obtained from pool_allocate() to the thread-local pool.
+  HERMES_API void pool_free(void* ptr);
+}
+
+/// Allocates an array of count entries of the type T, aligned to HERMES_SIMD_ALIGNMENT.
+/// To be released with free_with_alignment(). The entries are not initialized.
+template<typename T>
+T* new_with_alignment(unsigned int count)
+{
+  return (T*) Hermes::pool_allocate(count * sizeof(T));
+}
+
+/// Releases an array obtained from new_with_alignment(). NULL is allowed.
+template<typename T>
+void free_with_alignment(T* ptr)
+{
+  if(ptr == NULL)
+    return;
+  Hermes::pool_free(ptr);
+}
+
+/// Zeroes a freshly allocated array with a statically scheduled parallel loop.
+/// On NUMA systems the operating system places each page on the socket of the
+/// thread that touches it first; zeroing with memset() from the allocating
+/// thread therefore commits the whole array on one socket and the solver
+/// threads on the other socket(s) pay for every access. The static schedule
+/// matches the partitioning of the solver loops, so each thread first-touches
+/// the part of the array it will later stream through. Reduces to a plain loop
+/// in serial builds and inside an already parallel region.
+template<typename T>
+void zero_with_first_touch(T* buffer, unsigned int count)
+{
+  int n = (int) count;
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++)
+    buffer[i] = T(0);
+}
+
 typedef int int2[2];
 typedef int int3[3];
 typedef int int4[4];
@@ -70,6 +128,7 @@ typedef int int5[5];
 typedef double double2[2];
 typedef double double3[3];
 typedef double double4[4];
+typedef float float3[3];
 typedef double double2x2[2][2];
 typedef double double3x2[3][2];
 typedef double double3x3[3][3];
@@ -146,6 +205,213 @@ namespace Hermes
   inline double pow(double x, double y) { return std::pow(x, y); }
   inline double log(double x) { return std::log(x); }
 
+/// Minimum length from which the dense vector kernels below fork an OpenMP team.
+/// Below it the per-vector work is a few microseconds and the fork / join costs more
+/// than the loop; above it the loops are memory bound and scale with the sockets.
+#define HERMES_PARALLEL_VECTOR_OPS_LIMIT 16384
+
+  /// y := y + alpha * x over count entries. The arrays must not overlap - the
+  /// restrict qualification lets the compiler issue SIMD loads / stores.
+  template<typename T>
+  void vector_axpy(unsigned int count, T alpha, const T* HERMES_RESTRICT x, T* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < n; i++)
+        y[i] += alpha * x[i];
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+        y[i] += alpha * x[i];
+    }
+  }
+
+  /// x := alpha * x over count entries.
+  template<typename T>
+  void vector_scale(unsigned int count, T alpha, T* HERMES_RESTRICT x)
+  {
+    int n = (int) count;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < n; i++)
+        x[i] *= alpha;
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+        x[i] *= alpha;
+    }
+  }
+
+  /// y := y + alpha * x with the applied increment recorded as s := alpha * x,
+  /// in one pass. Lets a damping search roll the update back later without
+  /// keeping a copy of y.
+  template<typename T>
+  void vector_axpy_rec(unsigned int count, T alpha, const T* HERMES_RESTRICT x, T* HERMES_RESTRICT y, T* HERMES_RESTRICT s)
+  {
+    int n = (int) count;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < n; i++)
+      {
+        T inc = alpha * x[i];
+        s[i] = inc;
+        y[i] += inc;
+      }
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+      {
+        T inc = alpha * x[i];
+        s[i] = inc;
+        y[i] += inc;
+      }
+    }
+  }
+
+  /// y := y + (alpha - 1) * s and s := alpha * s in one pass - rescales the last
+  /// increment recorded by vector_axpy_rec() to a new coefficient alpha, rolling
+  /// the rejected part of the update back in place.
+  template<typename T>
+  void vector_step_rescale(unsigned int count, T alpha, T* HERMES_RESTRICT s, T* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    T alpha_m1 = alpha - T(1.0);
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < n; i++)
+      {
+        y[i] += alpha_m1 * s[i];
+        s[i] *= alpha;
+      }
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+      {
+        y[i] += alpha_m1 * s[i];
+        s[i] *= alpha;
+      }
+    }
+  }
+
+  /// Sum of squared magnitudes of the count entries of x (the squared Euclidean norm).
+  /// The accumulator is a real number for both scalar types, so the parallel branch
+  /// can use a plain OpenMP reduction.
+  template<typename T>
+  double vector_norm_squared(unsigned int count, const T* HERMES_RESTRICT x)
+  {
+    int n = (int) count;
+    double sum = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static) reduction(+:sum)
+      for (int i = 0; i < n; i++)
+        sum += Hermes::sqr(x[i]);
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+        sum += Hermes::sqr(x[i]);
+    }
+    return sum;
+  }
+
+  /// Squared Euclidean norm of the difference x - y, without forming the difference.
+  template<typename T>
+  double vector_diff_norm_squared(unsigned int count, const T* HERMES_RESTRICT x, const T* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    double sum = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static) reduction(+:sum)
+      for (int i = 0; i < n; i++)
+        sum += Hermes::sqr(x[i] - y[i]);
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+        sum += Hermes::sqr(x[i] - y[i]);
+    }
+    return sum;
+  }
+
+/// Runtime CPU dispatch of the double-precision vector kernels. On x86-64 ELF
+/// builds with GCC the double specializations below are compiled out of line
+/// in several instruction-set versions (baseline, AVX2, AVX-512) and the
+/// dynamic loader binds the widest one the executing machine supports, so a
+/// single binary serves a mixed fleet at full SIMD width. Other scalar types
+/// and toolchains keep the inline templates above.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__ELF__)
+#define HERMES_SIMD_RUNTIME_DISPATCH
+  template<> HERMES_API void vector_axpy<double>(unsigned int count, double alpha, const double* HERMES_RESTRICT x, double* HERMES_RESTRICT y);
+  template<> HERMES_API void vector_scale<double>(unsigned int count, double alpha, double* HERMES_RESTRICT x);
+  template<> HERMES_API double vector_norm_squared<double>(unsigned int count, const double* HERMES_RESTRICT x);
+  template<> HERMES_API double vector_diff_norm_squared<double>(unsigned int count, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y);
+  /// The dispatched body of the double vector_dot() overload.
+  HERMES_API double vector_dot_dispatched(unsigned int count, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y);
+#endif
+
+  /// Inner product of x and y, sum x_i * y_i.
+  inline double vector_dot(unsigned int count, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y)
+  {
+#ifdef HERMES_SIMD_RUNTIME_DISPATCH
+    return vector_dot_dispatched(count, x, y);
+#else
+    int n = (int) count;
+    double sum = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static) reduction(+:sum)
+      for (int i = 0; i < n; i++)
+        sum += x[i] * y[i];
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+        sum += x[i] * y[i];
+    }
+    return sum;
+#endif
+  }
+
+  /// Inner product conjugated in the first argument, sum conj(x_i) * y_i.
+  /// OpenMP reductions do not accept std::complex, hence the split real / imaginary
+  /// accumulators instead of a single template shared with the real version.
+  inline std::complex<double> vector_dot(unsigned int count, const std::complex<double>* HERMES_RESTRICT x, const std::complex<double>* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    double sum_re = 0.0, sum_im = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel for schedule(static) reduction(+:sum_re, sum_im)
+      for (int i = 0; i < n; i++)
+      {
+        std::complex<double> p = std::conj(x[i]) * y[i];
+        sum_re += p.real();
+        sum_im += p.imag();
+      }
+    }
+    else
+    {
+      for (int i = 0; i < n; i++)
+      {
+        std::complex<double> p = std::conj(x[i]) * y[i];
+        sum_re += p.real();
+        sum_im += p.imag();
+      }
+    }
+    return std::complex<double>(sum_re, sum_im);
+  }
+
   /* log file */
   #undef HERMES_LOG_FILE
   #ifdef HERMES_REPORT_NO_FILE
@@ -20,6 +20,7 @@
     \brief File containing includes of all HermesCommon functionality + solvers. Intended to be included.
 */
 #include "common.h"
+#include "thread_pool.h"
 #include "solvers/linear_matrix_solver.h"
 #include "solvers/nonlinear_solver.h"
 #include "solvers/amesos_solver.h"
@@ -29,6 +30,9 @@
 #include "solvers/newton_solver_nox.h"
 #include "solvers/petsc_solver.h"
 #include "solvers/umfpack_solver.h"
+#include "solvers/ooc_matrix.h"
+#include "solvers/block_diagonal_matrix.h"
+#include "solvers/iterative_solver.h"
 #include "solvers/superlu_solver.h"
 #include "solvers/precond.h"
 #include "solvers/precond_ifpack.h"
@@ -43,4 +47,5 @@
 #include "qsort.h"
 #include "ord.h"
 #include "mixins.h"
-#include "api.h"
\ No newline at end of file
+#include "api.h"
+#include "change_bus.h"
\ No newline at end of file
@@ -0,0 +1,117 @@
+// This file is part of HermesCommon.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+/*! \file instrumentation.h
+    \brief Hot-path instrumentation counters, compiled out unless WITH_INSTRUMENTATION is set.
+*/
+#ifndef __HERMES_COMMON_INSTRUMENTATION_H_
+#define __HERMES_COMMON_INSTRUMENTATION_H_
+
+#include "compat.h"
+#include "config.h"
+#include <map>
+#include <string>
+
+namespace Hermes
+{
+  namespace Instrumentation
+  {
+    /// One set of hot-path counters. Each thread increments its own instance
+    /// (see thread_counters()), so counting needs no synchronization; the
+    /// instances of all threads are summed on demand by aggregate().
+    struct HERMES_API Counters
+    {
+      Counters();
+
+      unsigned long elements_assembled;   ///< Assembly states processed by DiscreteProblem.
+      unsigned long states_traversed;     ///< States handed out by Traverse.
+      unsigned long pss_cache_hits;       ///< PrecalcShapeset value tables found precalculated.
+      unsigned long pss_cache_misses;     ///< PrecalcShapeset value tables that had to be computed.
+      unsigned long pattern_rebuilds;     ///< Sparse matrix structure (re)allocations.
+      unsigned long factorization_reuses; ///< Direct solver calls reusing an existing factorization.
+      unsigned long state_stream_replays; ///< Multimesh traversals replayed from the Traverse states cache.
+      unsigned long candidate_score_reuses; ///< Refinement candidate errors served from the selector cache.
+
+      /// Zeroes all the counters.
+      void reset();
+    };
+
+    /// Returns the counters of the calling thread, creating them on first use.
+    HERMES_API Counters& thread_counters();
+
+    /// Sums the counters of all threads that have counted so far into the result.
+    /// Meant to be called between computations, not concurrently with them.
+    HERMES_API void aggregate(Counters& result);
+
+    /// Resets the counters of all threads.
+    /// Meant to be called between computations, not concurrently with them.
+    HERMES_API void reset_all();
+
+    /// Aggregated timing samples of one named phase collected by the
+    /// profiling session, \sa start_profiling_session().
+    struct HERMES_API PhaseStats
+    {
+      PhaseStats();
+
+      unsigned long count; ///< Number of samples recorded.
+      double total;        ///< Sum of all the samples (in seconds).
+      double min_sample;   ///< Shortest recorded sample (in seconds).
+      double max_sample;   ///< Longest recorded sample (in seconds).
+    };
+
+    /// Process-wide profiling session. While a session is active, every
+    /// accumulating Mixins::TimeMeasurable::tick() registers the measured
+    /// period under the timer's name, so named phases (assembling, solving,
+    /// adaptivity, ...) accumulate statistics across the whole run without
+    /// any log scraping. Starting a session discards the samples of the
+    /// previous one. Off by default and then entirely without cost.
+    HERMES_API void start_profiling_session();
+
+    /// Stops recording; the collected statistics stay available for dumping.
+    HERMES_API void stop_profiling_session();
+
+    /// Whether a profiling session is currently recording.
+    HERMES_API bool profiling_session_active();
+
+    /// Records one timing sample of the named phase. Called by
+    /// Mixins::TimeMeasurable, but usable directly for custom phases. Safe
+    /// to call from parallel sections.
+    HERMES_API void profiling_add_sample(const std::string& phase, double seconds);
+
+    /// Per-phase statistics collected so far, keyed by the phase name.
+    /// Meant to be read between computations, not concurrently with them.
+    HERMES_API const std::map<std::string, PhaseStats>& get_profiling_phases();
+
+    /// Writes the collected per-phase statistics (count, total, min, max)
+    /// as a JSON object keyed by the phase names.
+    HERMES_API void dump_profiling_json(const char* filename);
+
+    /// Writes the collected per-phase statistics as CSV, one phase per row.
+    HERMES_API void dump_profiling_csv(const char* filename);
+  }
+}
+
+/// Counter increments for the library hot paths. With WITH_INSTRUMENTATION
+/// unset (the default) both macros expand to nothing, so the instrumented
+/// code costs nothing in production builds.
+#ifdef WITH_INSTRUMENTATION
+  #define HERMES_PROFILE_INCREMENT(counter) Hermes::Instrumentation::thread_counters().counter++
+  #define HERMES_PROFILE_ADD(counter, amount) Hermes::Instrumentation::thread_counters().counter += (amount)
+#else
+  #define HERMES_PROFILE_INCREMENT(counter) ((void) 0)
+  #define HERMES_PROFILE_ADD(counter, amount) ((void) 0)
+#endif
+
+#endif
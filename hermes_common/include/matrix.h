@@ -36,7 +36,8 @@ namespace Hermes
     SOLVER_MUMPS,
     SOLVER_SUPERLU,
     SOLVER_AMESOS,
-    SOLVER_AZTECOO
+    SOLVER_AZTECOO,
+    SOLVER_ITERATIVE
   };
 
   /// \brief Namespace containing classes for vector / matrix operations.
@@ -71,6 +71,10 @@ namespace Hermes
         static void warn(const char* msg, ...);
         static void error(const char* msg, ...);
       };
+
+      /// Writes out, in deposit order, the messages collected by info_buffered() /
+      /// warn_buffered() and empties the buffer. Call from a serial region.
+      static void flush_log_buffer();
     protected:
       Loggable(bool verbose_output = false, callbackFn verbose_callback = NULL);
 
@@ -80,7 +84,17 @@ namespace Hermes
       void warn_if(bool cond, const char* msg, ...) const;
       void error(const char* msg, ...) const;
       void error_if(bool cond, const char* msg, ...) const;
-      
+
+      /// Formats the message into the shared ring buffer instead of writing it
+      /// out immediately. Depositing is lock-free (a single atomic ticket per
+      /// message), so these variants can be called from parallel regions without
+      /// serializing on the logger monitor; the buffer holds the most recent
+      /// messages (the oldest are overwritten when it fills up) until
+      /// flush_log_buffer() writes them out.
+      void info_buffered(const char* msg, ...) const;
+      /// \sa info_buffered().
+      void warn_buffered(const char* msg, ...) const;
+
       /* file operations */
       void hermes_fwrite(const void* ptr, size_t size, size_t nitems, FILE* stream) const;
       void hermes_fread(void* ptr, size_t size, size_t nitems, FILE* stream) const;
@@ -156,6 +170,17 @@ namespace Hermes
       callbackFn verbose_callback;
     };
 
+/// Calls info() / warn() on 'loggable' only after testing its verbose output
+/// flag at the call site. The member functions test the flag too, but by then
+/// the caller has already evaluated the arguments; in inner loops where the
+/// formatting arguments themselves are expensive (norms, counters obtained by
+/// traversals, ...) these guards make a silenced logger cost a single branch.
+#define HERMES_LOG_INFO(loggable, ...) \
+  do { if((loggable)->get_verbose_output()) (loggable)->info(__VA_ARGS__); } while(0)
+/// \sa HERMES_LOG_INFO().
+#define HERMES_LOG_WARN(loggable, ...) \
+  do { if((loggable)->get_verbose_output()) (loggable)->warn(__VA_ARGS__); } while(0)
+
     /// \brief Class using time measurement
     /// Can be used directly (is not abstract), so one can use e.g. this in a program:
     /// Mixins::TimeMeasurable time;
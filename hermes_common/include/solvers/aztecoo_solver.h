@@ -58,6 +58,20 @@ namespace Hermes
       virtual ~AztecOOSolver();
       virtual bool solve();
       virtual int get_matrix_size();
+
+      /// For an iterative solver the factorization scheme controls the reuse of the
+      /// preconditioner: \c HERMES_REUSE_MATRIX_REORDERING keeps the IFPACK object
+      /// and its symbolic setup across value updates (only the factors are recomputed),
+      /// \c HERMES_REUSE_FACTORIZATION_COMPLETELY also keeps the numeric factors,
+      /// subject to the staleness policy, \sa set_precond_iter_growth().
+      virtual void set_factorization_scheme(FactorizationScheme reuse_scheme);
+
+      /// Staleness policy for completely reused preconditioner factors: when a solve
+      /// takes more than iter_growth times the iterations of the first solve made with
+      /// the current factors, the factors are marked stale and recomputed by the next
+      /// compute(). Default: 2.
+      /// @param[in] iter_growth allowed growth of the iteration count (> 1)
+      void set_precond_iter_growth(double iter_growth);
     protected:
       virtual int get_num_iters();
       virtual double get_residual();
@@ -78,6 +92,17 @@ namespace Hermes
 
       Precond<Scalar> *pc;
 
+      /// \sa set_factorization_scheme().
+      FactorizationScheme precond_reuse_scheme;
+      /// \sa set_precond_iter_growth().
+      double precond_iter_growth;
+      /// Iterations of the first solve made with the current factors (-1 = none yet).
+      int precond_baseline_iters;
+
+      /// Iteration-count regression test driving the staleness of reused factors.
+      /// Called after every solve.
+      void update_precond_staleness();
+
       template<typename T> friend LinearMatrixSolver<T>* create_linear_solver(Matrix<T>* matrix, Vector<T>* rhs);
     };
   }
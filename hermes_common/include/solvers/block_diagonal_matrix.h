@@ -0,0 +1,92 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file block_diagonal_matrix.h
+\brief Block-diagonal matrix with dense per-block storage.
+*/
+#ifndef __HERMES_COMMON_BLOCK_DIAGONAL_MATRIX_H_
+#define __HERMES_COMMON_BLOCK_DIAGONAL_MATRIX_H_
+#include "matrix.h"
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    /// \brief Block-diagonal matrix stored as contiguous dense blocks.
+    ///
+    /// For systems whose DOFs only couple within disjoint contiguous index
+    /// ranges - typically mass matrices on discontinuous (L2) spaces, where
+    /// the basis functions of different elements never overlap. The blocks
+    /// are derived in alloc() from the coupling pattern recorded through
+    /// pre_add_ij(): consecutive DOF ranges closed under coupling become one
+    /// block each; alloc() throws when the pattern is not block diagonal.
+    ///
+    /// The blocks are stored column-major, one after another in a single
+    /// array, so the whole matrix is one contiguous allocation. factorize()
+    /// replaces the values by the LU factors of every block (dense, partial
+    /// pivoting, one independent factorization per block run in parallel)
+    /// and solve() back-substitutes per block. After factorize() the entries
+    /// hold the factors - refill the matrix through zero() and add() before
+    /// reusing it for a different system.
+    template<typename Scalar>
+    class HERMES_API BlockDiagonalMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      BlockDiagonalMatrix();
+      virtual ~BlockDiagonalMatrix();
+
+      virtual void alloc();
+      virtual void free();
+      virtual Scalar get(unsigned int m, unsigned int n);
+      virtual void zero();
+      virtual void add(unsigned int m, unsigned int n, Scalar v);
+      virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols);
+      virtual void add_to_diagonal(Scalar v);
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE, char* number_format = (char*)"%lf");
+      virtual unsigned int get_matrix_size() const;
+      virtual unsigned int get_nnz() const;
+      virtual double get_fill_in() const;
+      virtual void multiply_with_vector(Scalar* vector_in, Scalar* vector_out);
+      virtual void multiply_with_Scalar(Scalar value);
+
+      /// Replaces every block by its LU factors (partial pivoting). The
+      /// factorizations are independent and run in parallel. Throws on a
+      /// singular block.
+      void factorize();
+
+      /// Solves the system for the given right-hand side, factorizing first
+      /// when that has not happened yet. The blocks are solved in parallel.
+      /// @param[in] rhs right-hand side, get_size() entries
+      /// @param[out] sln solution, get_size() entries (may alias rhs)
+      void solve(const Scalar* rhs, Scalar* sln);
+
+      /// Number of diagonal blocks.
+      int get_num_blocks() const;
+
+    protected:
+      int num_blocks;       ///< Number of diagonal blocks.
+      int* block_start;     ///< First DOF of each block, num_blocks + 1 entries.
+      int* block_offset;    ///< Start of each block in values, num_blocks + 1 entries.
+      int* block_of_dof;    ///< Block index of every DOF, size entries.
+      Scalar* values;       ///< Dense blocks, column-major, one after another.
+      int* pivot;           ///< Row permutations of the LU factors, size entries.
+      bool factorized;      ///< True once values holds the LU factors.
+    };
+  }
+}
+#endif
@@ -0,0 +1,121 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file iterative_solver.h
+\brief Native preconditioned CG / GMRES solver.
+*/
+#ifndef __HERMES_COMMON_ITERATIVE_SOLVER_H_
+#define __HERMES_COMMON_ITERATIVE_SOLVER_H_
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "linear_matrix_solver.h"
+#include "umfpack_solver.h"
+
+using namespace Hermes::Algebra;
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    /// \brief Native preconditioned iterative solver.
+    ///
+    /// Operates directly on the CSC storage of the system matrix and calls no
+    /// external package. Conjugate gradients (for symmetric positive definite
+    /// systems) and restarted GMRES are provided, both optionally preconditioned
+    /// by Jacobi or ILU(0) on the matrix pattern. Convergence is tested on the
+    /// preconditioned residual norm relative to the right-hand side norm,
+    /// against the tolerance of IterSolver.
+    ///
+    /// @ingroup Solvers
+    template <typename Scalar>
+    class HERMES_API IterativeLinearMatrixSolver : public IterSolver<Scalar>
+    {
+    public:
+      /// Constructor.
+      /// @param[in] m pointer to matrix
+      /// @param[in] rhs pointer to right hand side vector
+      IterativeLinearMatrixSolver(CSCMatrix<Scalar> *m, UMFPackVector<Scalar> *rhs);
+      virtual ~IterativeLinearMatrixSolver();
+
+      virtual bool solve();
+      virtual int get_matrix_size();
+      virtual int get_num_iters();
+      virtual double get_residual();
+
+      /// Set the type of the solver.
+      /// @param[in] solver name of the solver[ gmres | cg ]
+      void set_solver(const char *solver);
+
+      /// Set the restart length of GMRES. Ignored by CG.
+      /// @param[in] restart restart length, the default is 50
+      void set_gmres_restart(int restart);
+
+      /// Set the preconditioner.
+      /// @param[in] name name of the preconditioner[ none | jacobi | ilu ]
+      virtual void set_precond(const char *name);
+
+      /// External preconditioner objects are not supported by this solver,
+      /// the call only issues a warning. Use set_precond(const char*).
+      virtual void set_precond(Precond<Scalar> *pc);
+
+      /// Matrix to solve.
+      CSCMatrix<Scalar> *m;
+      /// Right hand side vector.
+      UMFPackVector<Scalar> *rhs;
+
+    protected:
+      enum IterativeMethodType
+      {
+        IterativeMethodGMRES,
+        IterativeMethodCG
+      };
+
+      enum PreconditionerType
+      {
+        PreconditionerNone,
+        PreconditionerJacobi,
+        PreconditionerILU
+      };
+
+      /// Builds the selected preconditioner for the current matrix values.
+      void build_precond();
+      /// Frees the preconditioner data.
+      void free_precond();
+      /// Applies the preconditioner, out = M^{-1} in.
+      void apply_precond(const Scalar* in, Scalar* out) const;
+
+      /// The conjugate gradient loop. \param[in,out] x initial guess / solution.
+      bool solve_cg(Scalar* x);
+      /// The restarted GMRES loop. \param[in,out] x initial guess / solution.
+      bool solve_gmres(Scalar* x);
+
+      IterativeMethodType method;
+      PreconditionerType precond_type;
+      int gmres_restart;
+
+      int num_iters;          ///< Iteration count of the last solve.
+      double residual_norm;   ///< Relative residual norm of the last solve.
+
+      Scalar* jacobi_diag;    ///< Inverted matrix diagonal for the Jacobi preconditioner.
+      Scalar* ilu_values;     ///< Values of the ILU(0) factors on the matrix pattern.
+      int* diag_pos;          ///< Positions of the diagonal entries in the value array.
+    };
+  }
+}
+#endif
+#endif
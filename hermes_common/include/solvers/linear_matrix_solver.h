@@ -100,6 +100,27 @@ namespace Hermes
       /// @return true on succes
       virtual bool solve() = 0;
 
+      /// Solve against a block of right-hand sides using a single factorization.
+      /// The block stores the right-hand sides consecutively by columns, i.e. it has
+      /// get_matrix_size() * nrhs entries, and the solutions are returned the same way
+      /// through get_sln_vector(). Direct solvers factorize once and back-substitute
+      /// the whole block; backends without a block path throw.
+      /// @param[in] rhs_block block of right-hand sides, stored by columns
+      /// @param[in] nrhs number of right-hand sides in the block
+      /// @return true on succes
+      virtual bool solve(Scalar* rhs_block, int nrhs);
+
+      /// Re-target the solver to a new matrix / right-hand side pair.
+      /// The internal workspace of the backend (UMFPACK symbolic / numeric objects,
+      /// the MUMPS instance and its communicator, ...) is kept alive; whether it is
+      /// actually reused for the next solve is governed by the factorization scheme,
+      /// exactly as if the original matrix had been refilled in place. Pass
+      /// \c HERMES_FACTORIZE_FROM_SCRATCH unless the new matrix shares the sparsity
+      /// pattern of the previous one. Backends without a re-targeting path throw.
+      /// @param[in] matrix new matrix to solve
+      /// @param[in] rhs new right hand side vector
+      virtual void retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs);
+
       /// Get solution vector.
       /// @return solution vector ( #sln )
       Scalar *get_sln_vector();
@@ -113,6 +134,11 @@ namespace Hermes
       virtual int get_matrix_size() = 0;
 
       /// Set factorization scheme.
+      /// This is the reuse contract between the caller and the backend: by passing
+      /// \c HERMES_REUSE_MATRIX_REORDERING the caller states that the sparsity pattern
+      /// did not change since the last solve (symbolic analysis is skipped), by passing
+      /// \c HERMES_REUSE_FACTORIZATION_COMPLETELY that the values did not change either
+      /// (numeric factorization is skipped as well). Iterative solvers ignore the call.
       /// @param[in] reuse_scheme factoriztion scheme to set
       virtual void set_factorization_scheme(FactorizationScheme reuse_scheme) { };
 
@@ -136,9 +162,9 @@ namespace Hermes
       DirectSolver(unsigned int factorization_scheme = HERMES_FACTORIZE_FROM_SCRATCH)
         : LinearMatrixSolver<Scalar>(), factorization_scheme(factorization_scheme) {};
 
-    protected:
       virtual void set_factorization_scheme(FactorizationScheme reuse_scheme);
 
+    protected:
       unsigned int factorization_scheme;
     };
 
@@ -171,7 +197,45 @@ namespace Hermes
       bool precond_yes;
     };
 
+    /// \brief Registry of linear solver backends.
+    /// Each backend registers a constructor function at load time (\sa RegisterLinearMatrixSolver),
+    /// create_linear_solver() then picks the backend per call according to the current
+    /// value of the Hermes::matrixSolverType parameter of Hermes::HermesCommonApi. This
+    /// makes the backend a runtime choice: switching between two solvers only means
+    /// changing the parameter between the calls, not rebuilding with different flags.
+    template<typename Scalar>
+    class HERMES_API LinearMatrixSolverRegistry
+    {
+    public:
+      typedef LinearMatrixSolver<Scalar>* (*SolverConstructor)(Matrix<Scalar>* matrix, Vector<Scalar>* rhs);
+
+      /// Register a backend. A repeated registration for the same solver type
+      /// replaces the previous entry, so an application may override a built-in
+      /// backend with its own.
+      /// @param[in] type solver type the backend handles
+      /// @param[in] constructor function constructing the solver for a matrix / rhs pair
+      static void add(MatrixSolverType type, SolverConstructor constructor);
+
+      /// @return the registered constructor, NULL when no backend handles the type.
+      static SolverConstructor get(MatrixSolverType type);
+    };
+
+    /// \brief Load-time registration helper.
+    /// A file-scope static instance in the backend's translation unit registers
+    /// the backend before main() is entered.
+    template<typename Scalar>
+    class RegisterLinearMatrixSolver
+    {
+    public:
+      RegisterLinearMatrixSolver(MatrixSolverType type, typename LinearMatrixSolverRegistry<Scalar>::SolverConstructor constructor)
+      {
+        LinearMatrixSolverRegistry<Scalar>::add(type, constructor);
+      }
+    };
+
     /// \brief Function returning a solver according to the users's choice.
+    /// The choice is read from Hermes::HermesCommonApi on every call and resolved
+    /// through LinearMatrixSolverRegistry.
     /// @param[in] matrix matrix
     /// @param[in] rhs right hand side vector
     /// @return created linear solver
@@ -114,10 +114,16 @@ namespace Hermes
       MumpsMatrix* duplicate();
 
     protected:
+      /// Builds the coordinate-format index arrays irn / jcn the MUMPS calls
+      /// take, from the CSC structure. Deferred until a consumer (the solver,
+      /// dump()) actually needs them, so the assembling itself carries the CSC
+      /// arrays only. A no-op when the arrays exist already.
+      void build_coordinate_indices();
+
       /// MUMPS specific data structures for storing the system matrix (CSC format).
       unsigned int nnz;          ///< Number of non-zero elements.
-      int *irn;         ///< Row indices.
-      int *jcn;         ///< Column indices.
+      int *irn;         ///< Row indices (coordinate format), built on demand, \sa build_coordinate_indices().
+      int *jcn;         ///< Column indices (coordinate format), built on demand.
       typename mumps_type<Scalar>::mumps_Scalar *Ax; ///< Matrix entries (column-wise).
       int *Ai;          ///< Row indices of values in Ax.
       unsigned int *Ap;          ///< Index to Ax/Ai, where each column starts.
@@ -171,8 +177,15 @@ namespace Hermes
       virtual ~MumpsSolver();
 
       virtual bool solve();
+      /// Block solve mapped to the native multiple right-hand side support of MUMPS.
+      virtual bool solve(Scalar* rhs_block, int nrhs);
       virtual int get_matrix_size();
 
+      /// Re-target the solver to a new system, keeping the initialized MUMPS
+      /// instance (and its communicator) alive. Reuse of the analysis / factorization
+      /// for the next solve follows the factorization scheme.
+      virtual void retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs);
+
       /// Matrix to solve.
       MumpsMatrix<Scalar> *m;
       /// Right hand side.
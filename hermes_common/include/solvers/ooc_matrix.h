@@ -0,0 +1,146 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file ooc_matrix.h
+\brief Out-of-core sparse matrix storage.
+*/
+#ifndef __HERMES_COMMON_OOC_MATRIX_H_
+#define __HERMES_COMMON_OOC_MATRIX_H_
+#include "config.h"
+#ifndef _WIN32
+#include "matrix.h"
+#include <string>
+#include <vector>
+#include <list>
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    /// \brief Out-of-core sparse matrix in compressed-column order.
+    ///
+    /// For assembling systems whose coefficient array does not fit in RAM.
+    /// Only the column pointers stay resident; the row indices and the values
+    /// live in a backing file split into panels of consecutive columns, which
+    /// are mapped into memory on demand (mmap) and evicted in
+    /// least-recently-used order once the configured residency budget is
+    /// exceeded. The backing file is created in the configured directory and
+    /// unlinked right away, so it never outlives the process.
+    ///
+    /// The add() path used by the assembling is fully supported (at the cost
+    /// of serializing concurrent insertions), and get_num_panels() /
+    /// map_panel() let a consumer stream the finished matrix panel by panel
+    /// without ever materializing a second full-size copy - e.g. when feeding
+    /// an out-of-core factorization.
+    template<typename Scalar>
+    class HERMES_API OOCMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      OOCMatrix();
+      virtual ~OOCMatrix();
+
+      /// Directory where the backing file is created (default: the current
+      /// working directory). Has to be set before alloc(); point it at the
+      /// fastest local drive available.
+      void set_storage_path(const char* path);
+      /// Approximate panel size in bytes (default 64 MB). Each panel covers a
+      /// range of consecutive columns whose indices and values together
+      /// amount to roughly this many bytes.
+      void set_panel_size(size_t bytes);
+      /// Budget in bytes for panels kept mapped at a time (default 256 MB).
+      /// At least one panel is always resident.
+      void set_memory_budget(size_t bytes);
+
+      virtual void alloc();
+      virtual void free();
+      virtual Scalar get(unsigned int m, unsigned int n);
+      virtual void zero();
+      virtual void add(unsigned int m, unsigned int n, Scalar v);
+      virtual void add_to_diagonal(Scalar v);
+      virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols);
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE, char* number_format = "%lf");
+      virtual unsigned int get_matrix_size() const;
+      virtual unsigned int get_nnz() const;
+      virtual double get_fill_in() const;
+
+      /// Applies the matrix to vector_in and saves result to vector_out,
+      /// streaming the panels sequentially.
+      virtual void multiply_with_vector(Scalar* vector_in, Scalar* vector_out);
+
+      /// Number of column panels the matrix is split into.
+      int get_num_panels() const;
+      /// Maps the given panel in (subject to the residency budget) and
+      /// exposes its column range and its row-index / value arrays. The
+      /// arrays are indexed by entry position relative to
+      /// get_Ap()[col_begin]; they stay valid until the panel is evicted by
+      /// a later map_panel() / add() call, so a streaming consumer should
+      /// finish with one panel before asking for the next.
+      void map_panel(int panel, int& col_begin, int& col_end, const int*& ai, const Scalar*& ax);
+      /// Column pointers (resident, size + 1 entries).
+      int *get_Ap();
+
+    protected:
+      /// A range of consecutive columns backed by one region of the file.
+      struct Panel
+      {
+        int col_begin;        ///< first column of the panel
+        int col_end;          ///< one past the last column of the panel
+        int entry_begin;      ///< Ap[col_begin]
+        int entry_end;        ///< Ap[col_end]
+        bool resident;        ///< whether the panel is currently mapped
+        int *ai;              ///< mapped row indices (entry_end - entry_begin of them)
+        Scalar *ax;           ///< mapped values
+        void *ai_base;        ///< page-aligned mapping base of ai
+        void *ax_base;        ///< page-aligned mapping base of ax
+        size_t ai_length;     ///< length of the ai mapping
+        size_t ax_length;     ///< length of the ax mapping
+      };
+
+      /// Makes the panel resident and moves it to the front of the LRU list,
+      /// evicting the least recently used panels beyond the budget.
+      void touch(int panel);
+      /// Unmaps the panel.
+      void evict(int panel);
+
+      /// Column pointers, kept in memory.
+      int *Ap;
+      /// Number of nonzero entries.
+      unsigned int nnz;
+      /// File descriptor of the (unlinked) backing file, -1 when not allocated.
+      int fd;
+      /// Byte size of the row-index region at the start of the backing file;
+      /// the value region follows it.
+      size_t index_region_size;
+      /// The panels.
+      std::vector<Panel> panels;
+      /// Panel index for every column.
+      std::vector<int> panel_of_col;
+      /// Resident panels, most recently used first.
+      std::list<int> lru;
+      /// Maximum number of resident panels, derived from the memory budget.
+      int max_resident;
+
+      /// Settings, \sa the setters above.
+      std::string storage_path;
+      size_t panel_size;
+      size_t memory_budget;
+    };
+  }
+}
+#endif
+#endif
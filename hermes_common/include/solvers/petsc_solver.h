@@ -158,6 +158,12 @@ namespace Hermes
       PetscMatrix<Scalar> *m;
       /// Right hand side vector.
       PetscVector<Scalar> *rhs;
+    protected:
+      /// The KSP context is kept across solves, so that the factorization scheme
+      /// can carry the preconditioner over to subsequent solves.
+      KSP ksp;
+      /// Has the KSP context been created?
+      bool ksp_inited;
     };
   }
 }
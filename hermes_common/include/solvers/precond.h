@@ -52,6 +52,18 @@ namespace Hermes
       virtual void destroy() = 0;
       virtual void compute() = 0;
 
+      /// Reuse control, mirroring the factorization reuse of the direct solvers.
+      /// With pattern reuse on, create() keeps the backend object and its symbolic
+      /// setup alive across value updates of the same matrix; with factor reuse on,
+      /// compute() additionally keeps the numeric factors until they are marked
+      /// stale. Backends without a reuse path ignore the calls.
+      virtual void set_reuse_pattern(bool to_set) { }
+      virtual void set_reuse_factors(bool to_set) { }
+      /// Forces the next compute() to re-run the numeric setup.
+      /// Typically called by the owning solver when the iteration counts regress,
+      /// i.e. the reused factors no longer match the matrix well.
+      virtual void mark_factors_stale() { }
+
 #ifdef HAVE_EPETRA
       virtual Epetra_Operator *get_obj() = 0;
 
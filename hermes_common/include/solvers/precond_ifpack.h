@@ -57,6 +57,16 @@ namespace Hermes
       void set_param(const char *name, const char *value);
       void set_param(const char *name, int value);
       void set_param(const char *name, double value);
+
+      /// With pattern reuse on, a repeated create() with the same matrix keeps the
+      /// IFPACK object and its symbolic setup (Initialize()), so that only Compute()
+      /// has to be re-run after a value update.
+      virtual void set_reuse_pattern(bool to_set);
+      /// With factor reuse on, compute() also keeps the numeric factors until they
+      /// are marked stale, \sa mark_factors_stale().
+      virtual void set_reuse_factors(bool to_set);
+      /// Forces the next compute() to re-run Compute().
+      virtual void mark_factors_stale();
     protected:
 
       virtual Epetra_Operator *get_obj() { return prec; }
@@ -84,6 +94,13 @@ namespace Hermes
       const char *type;
       int overlap;
 
+      /// \sa set_reuse_pattern().
+      bool reuse_pattern;
+      /// \sa set_reuse_factors().
+      bool reuse_factors;
+      /// \sa mark_factors_stale().
+      bool factors_stale;
+
       friend class AztecOOSolver<Scalar>;
     };
   }
@@ -0,0 +1,108 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+/*! \file segregated_solver.h
+\brief Block Gauss-Seidel driver for coupled multi-space systems.
+*/
+#ifndef __HERMES_COMMON_SEGREGATED_SOLVER_H_
+#define __HERMES_COMMON_SEGREGATED_SOLVER_H_
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "linear_matrix_solver.h"
+#include "umfpack_solver.h"
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    /// \brief Segregated (block Gauss-Seidel) solution of a monolithic system.
+    ///
+    /// Takes the monolithic matrix of a coupled problem assembled over several
+    /// spaces and the sizes of the diagonal blocks (the numbers of degrees of
+    /// freedom of the spaces, in their order), and solves the system by a block
+    /// Gauss-Seidel outer iteration: in each sweep, every block unknown is
+    /// corrected by solving its diagonal block against the current global
+    /// residual. Only the diagonal blocks are ever factorized - with direct
+    /// solvers and weakly coupled systems this replaces one large factorization
+    /// by a few small ones, which is superlinearly cheaper in both memory and
+    /// time. The block factorizations are computed once and reused across all
+    /// the sweeps (HERMES_REUSE_FACTORIZATION_COMPLETELY).
+    ///
+    /// The inner solvers and block structures are created through
+    /// create_linear_solver() / create_matrix(), so the backend follows the
+    /// matrixSolverType api parameter the same way a monolithic solve does.
+    ///
+    /// The iteration converges for diagonally dominant couplings (in the block
+    /// sense); the number of sweeps taken is available from get_num_sweeps()
+    /// and solve() returns false when the tolerance was not reached.
+    ///
+    /// @ingroup Solvers
+    template <typename Scalar>
+    class HERMES_API SegregatedSolver : public Hermes::Mixins::Loggable, public Hermes::Mixins::TimeMeasurable
+    {
+    public:
+      /// Constructor.
+      /// @param[in] matrix the assembled monolithic matrix
+      /// @param[in] rhs the assembled monolithic right-hand side
+      /// @param[in] block_sizes numbers of dofs of the blocks, in the order
+      /// of the spaces the system was assembled over; they have to sum up to
+      /// the matrix size
+      SegregatedSolver(Hermes::Algebra::CSCMatrix<Scalar>* matrix, Hermes::Algebra::Vector<Scalar>* rhs,
+        Hermes::vector<int> block_sizes);
+      virtual ~SegregatedSolver();
+
+      /// Runs the block Gauss-Seidel iteration, starting from a zero vector.
+      /// @return true when the relative residual dropped below the tolerance
+      bool solve();
+
+      /// The computed solution, of the monolithic size.
+      Scalar* get_sln_vector();
+
+      /// Number of sweeps the last solve() took.
+      int get_num_sweeps() const;
+
+      /// Relative residual tolerance stopping the sweeps (default 1e-8).
+      void set_tolerance(double tolerance);
+
+      /// Maximal number of sweeps (default 100).
+      void set_max_sweeps(int max_sweeps);
+
+    protected:
+      /// Extracts the diagonal blocks out of the monolithic matrix and sets up
+      /// the per-block solvers. Called once, from the first solve().
+      void init_blocks();
+
+      Hermes::Algebra::CSCMatrix<Scalar>* matrix;
+      Hermes::Algebra::Vector<Scalar>* rhs;
+
+      Hermes::vector<int> block_sizes;
+      Hermes::vector<int> block_offsets;
+
+      Hermes::vector<Hermes::Algebra::SparseMatrix<Scalar>*> block_matrices;
+      Hermes::vector<Hermes::Algebra::Vector<Scalar>*> block_rhs;
+      Hermes::vector<LinearMatrixSolver<Scalar>*> block_solvers;
+
+      Scalar* sln;
+      double tolerance;
+      int max_sweeps;
+      int num_sweeps;
+    };
+  }
+}
+#endif
+#endif
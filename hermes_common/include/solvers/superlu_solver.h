@@ -27,29 +27,89 @@
 typedef int int_t;
 #include "linear_matrix_solver.h"
 #include "matrix.h"
+#include "api.h"
 
 #include <supermatrix.h>
+#ifdef SLU_MT
+#include <slu_mt_util.h>
+#else
 #include <slu_util.h>
+#endif
 namespace Hermes
 {
   namespace Solvers
   {
     template <typename Scalar> class SuperLUSolver;
+
+    /** Type for storing number in SuperLU structures */
+    template<typename Scalar> struct SuperLuType;
+
+    /** Type for storing number in SuperLU real structures */
+    template<>
+    struct SuperLuType<double>
+    {
+    /** Type for storing scalar number in SuperLU real structures */
+      typedef double Scalar;
+    };
+
+    /** Type for storing number in SuperLU complex structures */
+    template<>
+    struct SuperLuType<std::complex<double> >
+    {
+    /** Type for storing scalar number in SuperLU complex structures */
+      typedef struct { double r, i; } Scalar;
+    };
+
 #ifdef SLU_MT
+    typedef superlumt_options_t       slu_options_t;
+    typedef Gstat_t                   slu_stat_t;
+    typedef superlu_memusage_t        slu_memusage_t;
+
+    /// Dispatch of the type-prefixed SuperLU_MT routines (d* / z*) according
+    /// to the scalar type, specialized in superlu_solver_real.cpp and
+    /// superlu_solver_cplx.cpp. The factorization itself (gstrf) is the
+    /// threaded p*gstrf kernel running on options->nprocs threads; the
+    /// helpers around it are the sequential routines shipped with the
+    /// library.
     template <typename Scalar>
     class SuperLu
     {
     public:
-      void gsequ (SuperMatrix *A, double *r, double *c, double *rowcnd, double *colcnd, double *amax, int *info);
-      void laqgs (SuperMatrix *A, float *r, float *c, float rowcnd, float colcnd, float amax, char *equed);
-      int gstrf (superlu_options_t *options, int m, int n, double anorm, LUstruct_t *LUstruct, gridinfo_t *grid, SuperLUStat_t *stat, int *info);
-      float pivotGrowth (int ncols, SuperMatrix *A, int *perm_c, SuperMatrix *L, SuperMatrix *U);
-      float langs (char *norm, SuperMatrix *A);
-      void  gscon (char *norm, SuperMatrix *L, SuperMatrix *U, float anorm, float *rcond, SuperLUStat_t *stat, int *info);
-      void  gstrs (trans_t trans, SuperMatrix *L, SuperMatrix *U, int *perm_c, int *perm_r, SuperMatrix *B, SuperLUStat_t *stat, int *info);
-      double lamch_ (char *cmach);
-      int querySpace (SuperMatrix *, SuperMatrix *, slu_memusage_t *);
-    }
+      static void gsequ (SuperMatrix *A, double *r, double *c, double *rowcnd, double *colcnd, double *amax, int *info);
+      static void laqgs (SuperMatrix *A, double *r, double *c, double rowcnd, double colcnd, double amax, equed_t *equed);
+      static void gstrf (superlumt_options_t *options, SuperMatrix *AC, int *perm_r, SuperMatrix *L, SuperMatrix *U, Gstat_t *stat, int *info);
+      static double pivot_growth (int ncols, SuperMatrix *A, int *perm_c, SuperMatrix *L, SuperMatrix *U);
+      static double langs (char *norm, SuperMatrix *A);
+      static void gscon (char *norm, SuperMatrix *L, SuperMatrix *U, double anorm, double *rcond, int *info);
+      static void gstrs (trans_t trans, SuperMatrix *L, SuperMatrix *U, int *perm_r, int *perm_c, SuperMatrix *B, Gstat_t *stat, int *info);
+      static void gsrfs (trans_t trans, SuperMatrix *A, SuperMatrix *L, SuperMatrix *U, int *perm_r, int *perm_c, equed_t equed,
+        double *R, double *C, SuperMatrix *B, SuperMatrix *X, double *ferr, double *berr, Gstat_t *stat, int *info);
+      static double lamch (char *cmach);
+      static int query_space (int nprocs, SuperMatrix *L, SuperMatrix *U, int panel_size, superlu_memusage_t *memusage);
+    };
+
+#define SLU_DESTROY_L             Destroy_SuperNode_SCP
+#define SLU_DESTROY_U             Destroy_CompCol_NCP
+#define SLU_INIT_STAT(stat_ptr)   { StatAlloc(m->size, options.nprocs, options.panel_size, options.relax, stat_ptr); StatInit(m->size, options.nprocs, stat_ptr); }
+/// SuperLU_MT has no counterpart of the sequential StatPrint.
+#define SLU_PRINT_STAT(stat_ptr)  {}
+
+#define SLU_DTYPE                 SLU_D
+
+#define SLU_GSEQU                 SuperLu<Scalar>::gsequ
+#define SLU_LAQGS                 SuperLu<Scalar>::laqgs
+#define SLU_SP_COLORDER           sp_colorder
+#define SLU_GSTRF                 SuperLu<Scalar>::gstrf
+#define SLU_PIVOT_GROWTH          SuperLu<Scalar>::pivot_growth
+#define SLU_LANGS                 SuperLu<Scalar>::langs
+#define SLU_GSCON                 SuperLu<Scalar>::gscon
+#define SLU_GSTRS                 SuperLu<Scalar>::gstrs
+#define SLU_GSRFS                 SuperLu<Scalar>::gsrfs
+#define SLU_LAMCH_                SuperLu<Scalar>::lamch
+#define SLU_QUERY_SPACE           SuperLu<Scalar>::query_space
+/// Scaling of a solution / rhs entry by an equilibration factor; works for
+/// both the real and the complex scalar type.
+#define SLU_MULT(a, b)            ((a) *= (b))
 #else //SLU_MT
 
     typedef superlu_options_t         slu_options_t;
@@ -68,25 +128,6 @@ namespace Hermes
 
 #define SLU_PRINT_CSC_MATRIX    zPrint_CompCol_Matrix
 #define Scalar_MALLOC       doublecomplexMalloc
-
-    /** Type for storing number in SuperLU structures */
-    template<typename Scalar> struct SuperLuType;
-
-    /** Type for storing number in SuperLU real structures */
-    template<>
-    struct SuperLuType<double>
-    {
-    /** Type for storing scalar number in SuperLU real structures */
-      typedef double Scalar;
-    };
-
-    /** Type for storing number in SuperLU complex structures */
-    template<>
-    struct SuperLuType<std::complex<double> >
-    {
-    /** Type for storing scalar number in SuperLU complex structures */
-      typedef struct { double r, i; } Scalar;
-    };
 #endif //SLU_MT
   }
 }
@@ -201,8 +242,40 @@ namespace Hermes
       virtual ~SuperLUSolver();
 
       virtual bool solve();
+      /// Block solve - the factorization from the first column is reused for the rest.
+      virtual bool solve(Scalar* rhs_block, int nrhs);
       virtual int get_matrix_size();
 
+      /// Re-target the solver to a new system. The native copies of the previous
+      /// matrix / rhs are dropped, the factorization structures stay allocated and
+      /// the factorization scheme decides their reuse for the next solve.
+      virtual void retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs);
+
+      /// Turns the row/column equilibration (scaling) of the matrix on / off
+      /// (default: on). Turning it off saves the scaling passes over the matrix
+      /// and the rhs for systems that are known to be well scaled.
+      /// The setting is persistent - it survives setup_factorization() and thus
+      /// applies to every subsequent solve.
+      void set_equilibration(bool to_set);
+
+      /// Sets the diagonal pivoting threshold, between 0.0 and 1.0
+      /// (default: 1.0 = classical partial pivoting). Smaller values bias the
+      /// pivot choice towards the diagonal, which preserves more of the
+      /// fill-reducing column ordering (and with SuperLU_MT also more of the
+      /// inter-column parallelism) at the price of a possibly less stable
+      /// factorization; 0.0 forces the diagonal pivots.
+      /// @param[in] threshold pivoting threshold.
+      void set_pivot_threshold(double threshold);
+
+      /// Selects the fill-reducing column ordering, using SuperLU's numbering:
+      /// 0 = natural ordering, 1 = minimum degree on A'*A, 2 = minimum degree
+      /// on A' + A, 3 = approximate minimum degree. By default the ordering is
+      /// left at the backend's present behavior (minimum degree on A'*A with
+      /// SuperLU_MT, the ordering chosen by set_default_options() with the
+      /// sequential library).
+      /// @param[in] ordering ordering number as above.
+      void set_column_ordering(int ordering);
+
     protected:
       /// Matrix to solve.
       SuperLUMatrix<Scalar> *m;
@@ -237,14 +310,18 @@ namespace Hermes
       int *etree;                   ///< Elimination tree of Pc'*A'*A*Pc.
       slu_options_t options;        ///< Structure holding the input options for the solver.
 
+      bool use_equilibration;       ///< Equilibrate the matrix before factorizing, see set_equilibration().
+      double pivot_threshold;       ///< Diagonal pivoting threshold, see set_pivot_threshold().
+      int column_ordering;          ///< Column ordering number, -1 = backend default. See set_column_ordering().
+
       private:
-#ifndef SLU_MT
       void create_csc_matrix (SuperMatrix *A, int m, int n, int nnz, typename SuperLuType<Scalar>::Scalar *nzval, int *rowind, int *colptr,
         Stype_t stype, Dtype_t dtype, Mtype_t mtype);
+      void create_dense_matrix (SuperMatrix *X, int m, int n, typename SuperLuType<Scalar>::Scalar *x, int ldx, Stype_t stype, Dtype_t dtype, Mtype_t mtype);
+#ifndef SLU_MT
       void  solver_driver (superlu_options_t *options, SuperMatrix *A, int *perm_c, int *perm_r, int *etree, char *equed, double *R,
         double *C, SuperMatrix *L, SuperMatrix *U, void *work, int lwork, SuperMatrix *B, SuperMatrix *X, double *recip_pivot_growth,
         double *rcond, double *ferr, double *berr, slu_memusage_t *mem_usage, SuperLUStat_t *stat, int *info);
-      void create_dense_matrix (SuperMatrix *X, int m, int n, typename SuperLuType<Scalar>::Scalar *x, int ldx, Stype_t stype, Dtype_t dtype, Mtype_t mtype);
 #endif  //SLU_MT
 
 #ifndef SLU_MT
@@ -25,6 +25,7 @@
 #ifdef WITH_UMFPACK
 #include "linear_matrix_solver.h"
 #include "matrix.h"
+#include "api.h"
 
 using namespace Hermes::Algebra;
 
@@ -43,7 +44,7 @@ namespace Hermes
     /// (can be used in umfpack, in that case use the
     /// UMFPackMatrix subclass, or with EigenSolver, or anything else).
     template <typename Scalar>
-    class HERMES_API CSCMatrix : public SparseMatrix<Scalar>
+    class HERMES_API CSCMatrix : public SparseMatrix<Scalar>, public Hermes::MemoryAccounted
     {
     public:
       /// Creates matrix in CSC format using size, nnz, and the three arrays.
@@ -70,6 +71,10 @@ namespace Hermes
       /// Add matrix.
       /// @param[in] mat matrix to be added
       virtual void add_matrix(CSCMatrix<Scalar>* mat);
+      /// Add matrix through the abstract interface.
+      /// The matrix has to be a CSCMatrix with the same sparsity structure.
+      /// @param[in] mat matrix to be added
+      virtual void add_sparse_matrix(SparseMatrix<Scalar>* mat);
       /// Add matrix to diagonal.
       /// @param[in] num_stages matrix is added to num_stages positions. num_stages * size(added matrix) = size(target matrix)
       /// @param[in] mat added matrix
@@ -81,18 +86,124 @@ namespace Hermes
       /// @param[in] mat added matrix
       virtual void add_as_block(unsigned int i, unsigned int j, CSCMatrix<Scalar>* mat);
       virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols);
+
+      /// Precompute the positions of a local matrix in the value array.
+      /// @param[out] positions array of m * n entries, -1 is stored for Dirichlet dofs
+      void precalculate_positions(unsigned int m, unsigned int n, int *rows, int *cols, int *positions) const;
+
+      /// Add a local matrix at positions precomputed by precalculate_positions().
+      /// No searching is performed, repeated assemblies into an unchanged structure
+      /// should prefer this path.
+      void add_at_positions(unsigned int m, unsigned int n, Scalar **mat, const int *positions);
+
+      /// Precompute the positions of all entries of another matrix in this
+      /// matrix's value array. Both patterns have to be allocated and every
+      /// entry of mat must exist in this pattern (this pattern is a superset,
+      /// e.g. the union pattern of the matrices to be combined), otherwise an
+      /// exception is thrown. The map has mat->get_nnz() entries, stays valid
+      /// as long as neither pattern changes, and is owned by the caller.
+      /// Built in O(nnz) - both patterns are column-sorted.
+      int* precalculate_sparse_map(CSCMatrix<Scalar>* mat) const;
+
+      /// Scaled matrix addition: this += factor * mat, at positions precomputed
+      /// by precalculate_sparse_map(). A NULL map declares the patterns
+      /// identical and reduces the operation to one contiguous pass over the
+      /// value arrays. No searching is performed either way - combining the
+      /// same matrices every time step should build the maps once and reuse them.
+      void add_matrix_at_map(CSCMatrix<Scalar>* mat, const int* map, Scalar factor);
+
+      /// Value-level combination this = alpha*A + beta*B over a precomputed
+      /// union pattern: zeroes the values and scatters both operands through
+      /// their maps (\sa precalculate_sparse_map()). The pattern of this
+      /// matrix is left untouched. For in-place scaling of a single matrix
+      /// see multiply_with_Scalar().
+      void combine(Scalar alpha, CSCMatrix<Scalar>* A, const int* map_A, Scalar beta, CSCMatrix<Scalar>* B, const int* map_B);
+
       virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE, char* number_format = "%lf");
       virtual unsigned int get_matrix_size() const;
       virtual unsigned int get_nnz() const;
       virtual double get_fill_in() const;
 
+      /// Deep memory usage: the CSC arrays, the CSR mirror if built, and the
+      /// pre-allocation pages if alloc() has not run yet.
+      /// \sa Hermes::Api::register_memory_report().
+      virtual size_t get_memory_bytes() const;
+
       // Applies the matrix to vector_in and saves result to vector_out.
       void multiply_with_vector(Scalar* vector_in, Scalar* vector_out);
       // Multiplies matrix with a Scalar.
       void multiply_with_Scalar(Scalar value);
 
+      /// Turns the split-complex storage mode on / off (default: off). Complex
+      /// matrices only, the real instantiation throws. When on,
+      /// multiply_with_vector() keeps the values additionally as two plain
+      /// double arrays (real and imaginary parts), refreshed lazily whenever
+      /// the values changed, and runs its row kernels on them - with the
+      /// interleaved std::complex layout the compiler cannot vectorize the
+      /// four real multiplies of a complex product, with the split layout it
+      /// can. The CSC arrays stay authoritative, so the (packed) UMFPACK
+      /// interface and all other consumers are unaffected.
+      void set_split_complex_storage(bool to_set = true);
+
+      /// Builds a CSR mirror of the sparsity pattern, so that multiply_with_vector()
+      /// can parallelize row-wise without write conflicts. The mirror stores only the
+      /// pattern and a permutation into #Ax, hence it stays valid when the values
+      /// change and is rebuilt only together with the pattern. Built lazily by
+      /// multiply_with_vector(), may be called up front to keep the first multiply cheap.
+      void build_csr_mirror();
+
       // Duplicates a matrix (including allocation).
-      CSCMatrix* duplicate();
+      virtual CSCMatrix* duplicate();
+
+      /// Zero-copy view of a column: sets the pointers directly into #Ai / #Ax and
+      /// returns the number of entries. The view is invalidated when the pattern
+      /// changes (alloc(), create(), free()), the values may change freely.
+      /// @param[in] col - column to view
+      /// @param[out] rows - global row indices of the column entries
+      /// @param[out] vals - the corresponding values
+      unsigned int extract_col_view(unsigned int col, int*& rows, Scalar*& vals);
+
+      /// Zero-copy view of a row, backed by the lazily built CSR mirror of the
+      /// pattern (\sa build_csr_mirror). Since the values are stored column-wise,
+      /// the view consists of the column indices and of the positions of the row
+      /// entries in #Ax: the value of the k-th entry is get_Ax()[positions[k]].
+      /// Returns the number of entries; validity as with extract_col_view().
+      /// @param[in] row - row to view
+      /// @param[out] cols - global column indices of the row entries
+      /// @param[out] positions - positions of the corresponding values in #Ax
+      unsigned int extract_row_view(unsigned int row, int*& cols, int*& positions);
+
+      /// Principal submatrix extraction for subdomain solves: returns a new matrix
+      /// holding the rows and columns of the given dof subset, with the subset
+      /// renumbered to 0 .. sub_size-1 in the order of sub_dofs. The subset has to
+      /// be strictly increasing (as e.g. collected from the assembly lists of an
+      /// element set) and only the entries of the selected columns are ever
+      /// visited, so the cost is proportional to their count, not to the full nnz.
+      /// When glob_to_sub is non-NULL, the inverse index map (global dof ->
+      /// subset position, -1 outside the subset) is returned through it; it has
+      /// get_size() entries and is owned by the caller.
+      /// @param[in] sub_size number of dofs in the subset
+      /// @param[in] sub_dofs the global dof indices of the subset, strictly increasing
+      /// @param[out] glob_to_sub optional inverse index map, see above
+      CSCMatrix<Scalar>* extract_submatrix(unsigned int sub_size, const int* sub_dofs, int** glob_to_sub = NULL) const;
+
+      /// Restriction of a global vector to a dof subset, the right-hand side
+      /// counterpart of extract_submatrix(): v_sub[i] = v[sub_dofs[i]].
+      static void gather_sub_vector(unsigned int sub_size, const int* sub_dofs, const Scalar* v, Scalar* v_sub);
+
+      /// Scatter of a sub-solution back into the global numbering:
+      /// v[sub_dofs[i]] = v_sub[i]; entries outside the subset are left untouched.
+      static void scatter_sub_vector(unsigned int sub_size, const int* sub_dofs, const Scalar* v_sub, Scalar* v);
+
+      virtual int get_num_col_entries(unsigned int col);
+      virtual int get_num_row_entries(unsigned int row);
+
+      /// The copying extractors of the SparseMatrix interface pass double values,
+      /// so they are only available for real matrices - the complex instantiations
+      /// throw. Use the view counterparts for Scalar-typed access.
+      virtual void extract_col_copy(unsigned int col, unsigned int len, unsigned int &n_entries, double *vals, unsigned int *idxs);
+      virtual void extract_row_copy(unsigned int row, unsigned int len, unsigned int &n_entries, double *vals, unsigned int *idxs);
+
       // Exposes pointers to the CSC arrays.
       /// @return pointer to #Ap
       int *get_Ap();
@@ -113,6 +224,31 @@ namespace Hermes
       int *Ap;
       /// Number of non-zero entries ( =  Ap[size]).
       unsigned int nnz;
+
+      // CSR mirror of the pattern for the parallel matrix-vector multiply.
+      /// Index to Ci/Cperm, where each row starts.
+      int *Cp;
+      /// Column indices of the entries in each row.
+      int *Ci;
+      /// Positions of the row-wise entries in #Ax.
+      int *Cperm;
+      /// Frees the CSR mirror, called whenever the pattern changes.
+      void free_csr_mirror();
+
+      // Split-complex mirror of #Ax for the vectorized complex multiply.
+      /// Real parts of the values. \sa set_split_complex_storage().
+      double *Ax_re;
+      /// Imaginary parts of the values.
+      double *Ax_im;
+      /// True when #Ax may have changed since the split arrays were filled.
+      bool split_values_stale;
+      /// \sa set_split_complex_storage().
+      bool split_complex_storage;
+      /// (Re)fills the split arrays from #Ax.
+      void build_split_values();
+      /// Frees the split arrays, called whenever the pattern changes.
+      void free_split_values();
+
       template <typename T> friend class Hermes::Solvers::UMFPackLinearMatrixSolver;
       template <typename T> friend class Hermes::Solvers::UMFPackIterator;
       template<typename T> friend SparseMatrix<T>*  create_matrix();
@@ -177,8 +313,56 @@ namespace Hermes
       UMFPackLinearMatrixSolver(UMFPackMatrix<Scalar> *m, UMFPackVector<Scalar> *rhs);
       virtual ~UMFPackLinearMatrixSolver();
       virtual bool solve();
+      /// Block solve - one factorization, one back-substitution per column.
+      virtual bool solve(Scalar* rhs_block, int nrhs);
       virtual int get_matrix_size();
 
+      /// Re-target the solver to a new system. The symbolic and numeric objects are
+      /// kept; whether they are reused for the next solve is decided by the
+      /// factorization scheme, exactly as if the original matrix had been refilled.
+      virtual void retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs);
+
+      /// Turn on iterative refinement of the computed solution (default: off).
+      /// After the back-substitution the residual is evaluated in full precision
+      /// through the sparse matrix-vector product of #m and corrected by another
+      /// back-substitution against the existing factorization, until the relative
+      /// residual drops below the tolerance or max_steps steps were taken. An
+      /// approximate factorization then suffices for a fully accurate solution -
+      /// pair with set_drop_tolerance() or with aggressive factorization reuse.
+      /// @param[in] max_steps maximal number of refinement steps
+      /// @param[in] tolerance relative residual at which to stop
+      void set_refinement(int max_steps, double tolerance);
+
+      /// Turn iterative refinement off again.
+      void disable_refinement();
+
+      /// Keep a session-persistent cache of the last few numeric factorizations
+      /// together with a fingerprint of the matrix values (default: off). Meant for
+      /// sweeps solving sequences of matrices with identical pattern and slowly
+      /// varying values: when the values of the current matrix are within the
+      /// threshold of a cached fingerprint, the cached factors are used for the back
+      /// substitution and an iterative refinement loop - whose residuals are
+      /// evaluated with the current matrix - recovers the accuracy, so the numeric
+      /// refactorization is skipped entirely. If the refinement does not reach its
+      /// tolerance, the solver falls back to a fresh factorization, hence the
+      /// threshold only trades work, never accuracy. When refinement has not been
+      /// configured through set_refinement(), the reuse path runs up to 5 steps at
+      /// relative residual 1e-12. Applies to the plain solve() only.
+      /// @param[in] capacity number of factorizations to keep (round-robin eviction)
+      /// @param[in] threshold relative value-perturbation up to which factors are reused
+      void set_factorization_cache(int capacity = 4, double threshold = 1e-2);
+
+      /// Drop the cached factorizations and turn the cache off again.
+      void disable_factorization_cache();
+
+      /// Set the drop tolerance of the numeric factorization (default 0 = exact).
+      /// Entries of the factors smaller than the tolerance are dropped, shrinking
+      /// the factorization and speeding it up at the cost of accuracy; meant to be
+      /// paired with set_refinement(), which recovers the accuracy cheaply.
+      /// Takes effect at the next numeric factorization.
+      /// @param[in] droptol the drop tolerance to pass to the factorization
+      void set_drop_tolerance(double droptol);
+
       /// Matrix to solve.
       UMFPackMatrix<Scalar> *m;
       /// Right hand side vector.
@@ -193,6 +377,53 @@ namespace Hermes
       void free_factorization_data();
       /// \todo document
       bool setup_factorization();
+
+      /// One back-substitution of b against the existing factorization, result in x.
+      /// @return false when UMFPACK reports an error
+      bool back_substitute(Scalar* x, Scalar* b);
+      /// The refinement loop ran over one solution vector. \sa set_refinement().
+      /// @return the relative residual measured last (conservative when the step limit cut the loop short)
+      double refine_solution(Scalar* x, Scalar* b);
+
+      int refinement_max_steps;     ///< 0 turns the refinement off.
+      double refinement_tolerance;  ///< \sa set_refinement().
+      double drop_tolerance;        ///< \sa set_drop_tolerance(). 0 = exact factorization.
+
+      /// One remembered numeric factorization, \sa set_factorization_cache().
+      struct CachedFactorization
+      {
+        void* numeric;        ///< The UMFPACK numeric object, owned by the cache.
+        double* fingerprint;  ///< Blockwise value magnitude sums of the factorized matrix.
+        double values_norm;   ///< Sum of all value magnitudes (the fingerprint scale).
+        /// Dimensions of the factorized matrix. The factors are only ever reused
+        /// for a matrix of exactly the same size and fill - the back substitution
+        /// writes a solution of the numeric object's dimension, so a dimension
+        /// mismatch would corrupt the solution buffer, not just lose accuracy.
+        unsigned int size;
+        unsigned int nnz;
+      };
+
+      /// Number of blocks the matrix values are condensed into when fingerprinting.
+      static const int fingerprint_size = 64;
+
+      /// Condense the values of #m into blockwise magnitude sums.
+      void compute_fingerprint(double* fingerprint, double& values_norm) const;
+      /// Index of a cached factorization within the perturbation threshold, -1 for none.
+      int find_compatible_factorization(const double* fingerprint, double values_norm) const;
+      /// Hand the current #numeric over to the cache, evicting round-robin.
+      void store_factorization(const double* fingerprint, double values_norm);
+      /// Whether the pointer is owned by the cache (and must not be freed elsewhere).
+      bool numeric_is_cached(void* numeric_object) const;
+      /// Release one cached numeric object.
+      void free_cached_numeric(void*& numeric_object);
+      /// \sa disable_factorization_cache().
+      void free_factorization_cache();
+
+      CachedFactorization* factorization_cache; ///< NULL while the cache is off.
+      int factorization_cache_capacity;         ///< 0 turns the cache off.
+      int factorization_cache_size;
+      int factorization_cache_next;             ///< Round-robin eviction position.
+      double factorization_cache_threshold;     ///< \sa set_factorization_cache().
       template <typename T> friend class Hermes::Algebra::CSCMatrix;
       template <typename T> friend class Hermes::Algebra::UMFPackMatrix;
       template <typename T> friend class Hermes::Algebra::UMFPackVector;
@@ -0,0 +1,47 @@
+// This file is part of HermesCommon.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+/*! \file thread_pool.h
+    \brief Control over the shared worker thread pool of the parallel phases.
+*/
+#ifndef __HERMES_THREAD_POOL_H_
+#define __HERMES_THREAD_POOL_H_
+
+#include "compat.h"
+
+namespace Hermes
+{
+  /* All the parallel phases of the library - assembling, linearization for
+  visualization and export, adaptivity - run through OpenMP parallel regions,
+  which are served by the runtime's single persistent worker pool: the threads
+  are created once per process and reused across the phases, never per call.
+  The functions below manage that shared pool. The thread count to pass is the
+  one the parallel regions are sized with, i.e. in Hermes2D the numThreads
+  value of Hermes2DApi.
+  */
+
+  /// Forces the creation of the worker threads up front by entering a trivial
+  /// parallel region of the given size. Without it the threads are started
+  /// lazily by the first parallel region, so a small (and often timed) first
+  /// assembling would pay for the pool start-up.
+  HERMES_API void warm_up_thread_pool(int num_threads);
+
+  /// Binds the worker threads to consecutive logical processors, starting at
+  /// first_processor. Pinned workers stay on their NUMA node, together with
+  /// the buffer pages they first-touched, instead of being migrated by the
+  /// scheduler. Available on Linux and Windows, elsewhere it does nothing.
+  HERMES_API void pin_thread_pool(int num_threads, int first_processor = 0);
+}
+#endif
@@ -42,6 +42,7 @@ namespace Hermes
 
     this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*> (Hermes::exceptionsPrintCallstack,new Parameter(0)));
     this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*> (Hermes::matrixSolverType,new Parameter(SOLVER_UMFPACK)));
+    this->parameters.insert(std::pair<HermesCommonApiParam, Parameter*> (Hermes::numSolverThreads,new Parameter(0)));
   }
 
   Api::~Api()
@@ -59,6 +60,36 @@ namespace Hermes
       return this->parameters.find(param)->second->default_val;
   }
 
+  void Api::register_memory_report(const std::string& label, const MemoryAccounted* object)
+  {
+    if(object == NULL)
+      throw Hermes::Exceptions::NullException(2);
+    memory_reports.push_back(std::pair<std::string, const MemoryAccounted*>(label, object));
+  }
+
+  void Api::unregister_memory_report(const MemoryAccounted* object)
+  {
+    for (unsigned int i = 0; i < memory_reports.size(); i++)
+      if(memory_reports[i].second == object)
+      {
+        memory_reports.erase(memory_reports.begin() + i);
+        return;
+      }
+  }
+
+  size_t Api::get_memory_snapshot(std::map<std::string, size_t>& snapshot) const
+  {
+    snapshot.clear();
+    size_t total = 0;
+    for (unsigned int i = 0; i < memory_reports.size(); i++)
+    {
+      size_t bytes = memory_reports[i].second->get_memory_bytes();
+      snapshot[memory_reports[i].first] += bytes;
+      total += bytes;
+    }
+    return total;
+  }
+
   void Api::set_integral_param_value(HermesCommonApiParam param, int value)
   {
     if(this->parameters.find(param) == parameters.end())
@@ -0,0 +1,85 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file change_bus.cpp
+\brief Central change-notification bus the generation-stamped caches hang off.
+*/
+#include "change_bus.h"
+#include "exceptions.h"
+
+namespace Hermes
+{
+  ChangeBus::ChangeBus()
+  {
+    for (int i = 0; i < HERMES_CHANGE_CHANNEL_COUNT; i++)
+      generations[i] = 0;
+    generation_checking = false;
+  }
+
+  void ChangeBus::publish(ChangeChannel channel, const void* publisher)
+  {
+#pragma omp critical (ChangeBus_listeners)
+    {
+      generations[channel]++;
+      for (unsigned int i = 0; i < listeners[channel].size(); i++)
+        listeners[channel][i]->changed(channel, publisher);
+    }
+  }
+
+  void ChangeBus::subscribe(ChangeChannel channel, ChangeListener* listener)
+  {
+#pragma omp critical (ChangeBus_listeners)
+    listeners[channel].push_back(listener);
+  }
+
+  void ChangeBus::unsubscribe(ChangeListener* listener)
+  {
+#pragma omp critical (ChangeBus_listeners)
+    for (int channel = 0; channel < HERMES_CHANGE_CHANNEL_COUNT; channel++)
+    {
+      for (unsigned int i = 0; i < listeners[channel].size();)
+      {
+        if(listeners[channel][i] == listener)
+          listeners[channel].erase(listeners[channel].begin() + i);
+        else
+          i++;
+      }
+    }
+  }
+
+  unsigned int ChangeBus::get_generation(ChangeChannel channel) const
+  {
+    return generations[channel];
+  }
+
+  bool ChangeBus::check_generation(ChangeChannel channel, unsigned int stamp) const
+  {
+    if(stamp == generations[channel])
+      return true;
+    if(generation_checking)
+      throw Hermes::Exceptions::Exception("Stale cache read: channel %d stamp %u, current generation %u.", (int)channel, stamp, generations[channel]);
+    return false;
+  }
+
+  void ChangeBus::set_generation_checking(bool to_set)
+  {
+    this->generation_checking = to_set;
+  }
+
+  Hermes::ChangeBus HermesChangeBus;
+}
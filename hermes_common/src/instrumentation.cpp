@@ -0,0 +1,186 @@
+// This file is part of HermesCommon.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+/*! \file instrumentation.cpp
+    \brief Per-thread hot-path counters and their on-demand aggregation.
+*/
+#include "common.h"
+#include "instrumentation.h"
+#include "exceptions.h"
+#include "vector.h"
+
+/// Thread-local storage qualifier.
+#ifdef _MSC_VER
+  #define HERMES_THREAD_LOCAL __declspec(thread)
+#else
+  #define HERMES_THREAD_LOCAL __thread
+#endif
+
+namespace Hermes
+{
+  namespace Instrumentation
+  {
+    namespace
+    {
+      /// The counters of the calling thread. Being thread-local, incrementing
+      /// them in the parallel assembling loop needs no locking.
+      HERMES_THREAD_LOCAL Counters* thread_instance = NULL;
+
+      /// The counter instances of all threads, for aggregate() / reset_all().
+      /// The instances are kept for the lifetime of the process, so a pointer
+      /// obtained from thread_counters() never dangles.
+      Hermes::vector<Counters*> registry;
+    }
+
+    Counters::Counters()
+    {
+      reset();
+    }
+
+    void Counters::reset()
+    {
+      elements_assembled = 0;
+      states_traversed = 0;
+      pss_cache_hits = 0;
+      pss_cache_misses = 0;
+      pattern_rebuilds = 0;
+      factorization_reuses = 0;
+      state_stream_replays = 0;
+      candidate_score_reuses = 0;
+    }
+
+    Counters& thread_counters()
+    {
+      if(thread_instance == NULL)
+      {
+        Counters* instance = new Counters();
+#pragma omp critical (instrumentation_registry)
+        registry.push_back(instance);
+        thread_instance = instance;
+      }
+      return *thread_instance;
+    }
+
+    void aggregate(Counters& result)
+    {
+      result.reset();
+#pragma omp critical (instrumentation_registry)
+      for(unsigned int i = 0; i < registry.size(); i++)
+      {
+        result.elements_assembled += registry[i]->elements_assembled;
+        result.states_traversed += registry[i]->states_traversed;
+        result.pss_cache_hits += registry[i]->pss_cache_hits;
+        result.pss_cache_misses += registry[i]->pss_cache_misses;
+        result.pattern_rebuilds += registry[i]->pattern_rebuilds;
+        result.factorization_reuses += registry[i]->factorization_reuses;
+        result.state_stream_replays += registry[i]->state_stream_replays;
+        result.candidate_score_reuses += registry[i]->candidate_score_reuses;
+      }
+    }
+
+    void reset_all()
+    {
+#pragma omp critical (instrumentation_registry)
+      for(unsigned int i = 0; i < registry.size(); i++)
+        registry[i]->reset();
+    }
+
+    namespace
+    {
+      /// Whether a profiling session is recording. Checked on every tick(),
+      /// so a plain flag - when no session runs, ticking costs one branch.
+      bool profiling_active = false;
+
+      /// The collected per-phase statistics, keyed by the phase name.
+      std::map<std::string, PhaseStats> profiling_registry;
+    }
+
+    PhaseStats::PhaseStats() : count(0), total(0.0), min_sample(0.0), max_sample(0.0)
+    {
+    }
+
+    void start_profiling_session()
+    {
+#pragma omp critical (profiling_registry)
+      profiling_registry.clear();
+      profiling_active = true;
+    }
+
+    void stop_profiling_session()
+    {
+      profiling_active = false;
+    }
+
+    bool profiling_session_active()
+    {
+      return profiling_active;
+    }
+
+    void profiling_add_sample(const std::string& phase, double seconds)
+    {
+#pragma omp critical (profiling_registry)
+      {
+        PhaseStats& stats = profiling_registry[phase];
+        if(stats.count == 0 || seconds < stats.min_sample)
+          stats.min_sample = seconds;
+        if(stats.count == 0 || seconds > stats.max_sample)
+          stats.max_sample = seconds;
+        stats.count++;
+        stats.total += seconds;
+      }
+    }
+
+    const std::map<std::string, PhaseStats>& get_profiling_phases()
+    {
+      return profiling_registry;
+    }
+
+    void dump_profiling_json(const char* filename)
+    {
+      FILE* f = fopen(filename, "w");
+      if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
+#pragma omp critical (profiling_registry)
+      {
+        fprintf(f, "{\n");
+        std::map<std::string, PhaseStats>::const_iterator it;
+        bool first = true;
+        for(it = profiling_registry.begin(); it != profiling_registry.end(); ++it)
+        {
+          fprintf(f, "%s  \"%s\": { \"count\": %lu, \"total\": %.9g, \"min\": %.9g, \"max\": %.9g }",
+            first ? "" : ",\n", it->first.c_str(), it->second.count,
+            it->second.total, it->second.min_sample, it->second.max_sample);
+          first = false;
+        }
+        fprintf(f, "\n}\n");
+      }
+      fclose(f);
+    }
+
+    void dump_profiling_csv(const char* filename)
+    {
+      FILE* f = fopen(filename, "w");
+      if(f == NULL) throw Hermes::Exceptions::Exception("Could not open %s for writing.", filename);
+#pragma omp critical (profiling_registry)
+      {
+        fprintf(f, "phase,count,total,min,max\n");
+        std::map<std::string, PhaseStats>::const_iterator it;
+        for(it = profiling_registry.begin(); it != profiling_registry.end(); ++it)
+          fprintf(f, "%s,%lu,%.9g,%.9g,%.9g\n", it->first.c_str(), it->second.count,
+            it->second.total, it->second.min_sample, it->second.max_sample);
+      }
+      fclose(f);
+    }
+  }
+}
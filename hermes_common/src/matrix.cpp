@@ -260,6 +260,15 @@ SparseMatrix<Scalar>* Hermes::Algebra::create_matrix()
       return new SuperLUMatrix<Scalar>;
 #else
       throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+#endif
+      break;
+    }
+  case Hermes::SOLVER_ITERATIVE:
+    {
+#ifdef WITH_UMFPACK
+      return new UMFPackMatrix<Scalar>;
+#else
+      throw Hermes::Exceptions::Exception("The iterative solver requires the CSC matrix classes, UMFPACK was not installed.");
 #endif
       break;
     }
@@ -325,6 +334,15 @@ Vector<Scalar>* Hermes::Algebra::create_vector()
       return new SuperLUVector<Scalar>;
 #else
       throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+#endif
+      break;
+    }
+  case Hermes::SOLVER_ITERATIVE:
+    {
+#ifdef WITH_UMFPACK
+      return new UMFPackVector<Scalar>;
+#else
+      throw Hermes::Exceptions::Exception("The iterative solver requires the CSC matrix classes, UMFPACK was not installed.");
 #endif
       break;
     }
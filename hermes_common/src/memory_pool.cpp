@@ -0,0 +1,118 @@
+// This file is part of HermesCommon.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+/*! \file memory_pool.cpp
+    \brief Thread-local pooled allocator backing new_with_alignment() / free_with_alignment().
+*/
+#include "common.h"
+
+/// Thread-local storage qualifier.
+#ifdef _MSC_VER
+  #define HERMES_THREAD_LOCAL __declspec(thread)
+#else
+  #define HERMES_THREAD_LOCAL __thread
+#endif
+
+namespace Hermes
+{
+  namespace
+  {
+    /// Block sizes are rounded up to multiples of this granularity, so that blocks
+    /// released for one Func array can be recycled for another of a similar size.
+    const size_t POOL_GRANULARITY = 256;
+
+    /// Number of size classes kept in the pool; larger blocks bypass the pool.
+    const int POOL_BUCKET_COUNT = 32;
+
+    /// Marker stored in the header of blocks that bypass the pool.
+    const size_t POOL_BUCKET_NONE = (size_t) -1;
+
+    /// Free blocks are linked through their first bytes.
+    struct PoolBlock
+    {
+      PoolBlock* next;
+    };
+
+    /// Per-thread free lists, one per size class. Being thread-local, they need
+    /// no locking in the parallel assembling loop.
+    HERMES_THREAD_LOCAL PoolBlock* pool_buckets[POOL_BUCKET_COUNT] = { };
+
+    /// Allocates an aligned block of the passed size from the system allocator.
+    void* system_allocate(size_t size)
+    {
+#ifdef _MSC_VER
+      void* ptr = _aligned_malloc(size, HERMES_SIMD_ALIGNMENT);
+      if(ptr == NULL)
+        throw std::bad_alloc();
+#else
+      void* ptr;
+      if(posix_memalign(&ptr, HERMES_SIMD_ALIGNMENT, size) != 0)
+        throw std::bad_alloc();
+#endif
+      return ptr;
+    }
+
+    /// Returns a block to the system allocator.
+    void system_free(void* ptr)
+    {
+#ifdef _MSC_VER
+      _aligned_free(ptr);
+#else
+      free(ptr);
+#endif
+    }
+  }
+
+  void* pool_allocate(size_t size)
+  {
+    // The bucket index is stored in a header preceding the user data. The header
+    // occupies a full HERMES_SIMD_ALIGNMENT so that the user data stays aligned.
+    size_t bucket = (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY;
+    if(bucket < (size_t) POOL_BUCKET_COUNT)
+    {
+      if(pool_buckets[bucket] != NULL)
+      {
+        PoolBlock* block = pool_buckets[bucket];
+        pool_buckets[bucket] = block->next;
+        return (char*) block + HERMES_SIMD_ALIGNMENT;
+      }
+      void* raw = system_allocate(HERMES_SIMD_ALIGNMENT + bucket * POOL_GRANULARITY);
+      *(size_t*) raw = bucket;
+      return (char*) raw + HERMES_SIMD_ALIGNMENT;
+    }
+    else
+    {
+      void* raw = system_allocate(HERMES_SIMD_ALIGNMENT + size);
+      *(size_t*) raw = POOL_BUCKET_NONE;
+      return (char*) raw + HERMES_SIMD_ALIGNMENT;
+    }
+  }
+
+  void pool_free(void* ptr)
+  {
+    if(ptr == NULL)
+      return;
+    void* raw = (char*) ptr - HERMES_SIMD_ALIGNMENT;
+    size_t bucket = *(size_t*) raw;
+    if(bucket == POOL_BUCKET_NONE)
+      system_free(raw);
+    else
+    {
+      PoolBlock* block = (PoolBlock*) raw;
+      block->next = pool_buckets[bucket];
+      pool_buckets[bucket] = block;
+    }
+  }
+}
@@ -16,6 +16,7 @@
 #include <map>
 #include <string>
 #include "common.h"
+#include "instrumentation.h"
 
 namespace Hermes
 {
@@ -328,6 +329,76 @@ namespace Hermes
       }
     }
 
+    // Shared ring buffer the *_buffered() variants deposit into. Depositing
+    // takes one atomic ticket and formats straight into the claimed slot, so
+    // no lock is held; the buffer keeps the most recent HERMES_LOG_RING_SIZE
+    // messages until flush_log_buffer() writes them out.
+    static const long HERMES_LOG_RING_SIZE = 1024;   // must be a power of two.
+    static const int HERMES_LOG_RING_MSG_SZ = 256;
+    static char log_ring[HERMES_LOG_RING_SIZE][HERMES_LOG_RING_MSG_SZ];
+    static volatile long log_ring_head = 0;
+    static long log_ring_flushed = 0;
+
+    static inline long log_ring_ticket()
+    {
+#if defined(__GNUC__)
+      return __sync_fetch_and_add(&log_ring_head, 1);
+#elif defined(WIN32)
+      return InterlockedExchangeAdd((volatile LONG*)&log_ring_head, 1);
+#else
+      return log_ring_head++;
+#endif
+    }
+
+    static void log_ring_deposit(const char code, const char* msg, va_list arglist)
+    {
+      char* slot = log_ring[log_ring_ticket() & (HERMES_LOG_RING_SIZE - 1)];
+      slot[0] = code;
+#ifdef _MSC_VER
+      _vsnprintf(slot + 1, HERMES_LOG_RING_MSG_SZ - 2, msg, arglist);
+#else
+      vsnprintf(slot + 1, HERMES_LOG_RING_MSG_SZ - 2, msg, arglist);
+#endif
+      slot[HERMES_LOG_RING_MSG_SZ - 1] = '\0';
+    }
+
+    void Loggable::info_buffered(const char* msg, ...) const
+    {
+      if(!this->verbose_output)
+        return;
+
+      va_list arglist;
+      va_start(arglist, msg);
+      log_ring_deposit(HERMES_EC_INFO, msg, arglist);
+      va_end(arglist);
+    }
+
+    void Loggable::warn_buffered(const char* msg, ...) const
+    {
+      if(!this->verbose_output)
+        return;
+
+      va_list arglist;
+      va_start(arglist, msg);
+      log_ring_deposit(HERMES_EC_WARNING, msg, arglist);
+      va_end(arglist);
+    }
+
+    void Loggable::flush_log_buffer()
+    {
+      long head = log_ring_head;
+      long start = (head - log_ring_flushed > HERMES_LOG_RING_SIZE) ? head - HERMES_LOG_RING_SIZE : log_ring_flushed;
+      for (long i = start; i < head; i++)
+      {
+        char* slot = log_ring[i & (HERMES_LOG_RING_SIZE - 1)];
+        if(slot[0] == HERMES_EC_WARNING)
+          Loggable::Static::warn("%s", slot + 1);
+        else
+          Loggable::Static::info("%s", slot + 1);
+      }
+      log_ring_flushed = head;
+    }
+
     bool Loggable::write_console(const char code, const char* text) const
     {
       //Windows platform
@@ -556,6 +627,9 @@ namespace Hermes
         double secs = period_in_seconds(last_time, cur_time);
         accum += secs;
         last_period = secs;
+        // Feed the measured period into the profiling session, if one runs.
+        if(Instrumentation::profiling_session_active())
+          Instrumentation::profiling_add_sample(period_name, secs);
       }
       else
         last_period = 0.0;
@@ -0,0 +1,176 @@
+// This file is part of HermesCommon.
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file simd_dispatch.cpp
+\brief Runtime CPU dispatch of the double-precision vector kernels, \sa common.h.
+*/
+#include "common.h"
+
+#ifdef HERMES_SIMD_RUNTIME_DISPATCH
+
+namespace Hermes
+{
+  // The range kernels below are compiled in a baseline, an AVX2 and an
+  // AVX-512 version; the dynamic loader resolves each call site to the
+  // widest version the executing CPU supports (the GNU ifunc mechanism),
+  // which replaces an explicit function-pointer table filled at startup.
+  // The exported kernels keep the OpenMP team handling of the inline
+  // templates in common.h and hand each thread its contiguous range.
+
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+  static void axpy_range(int begin, int end, double alpha, const double* HERMES_RESTRICT x, double* HERMES_RESTRICT y)
+  {
+    for (int i = begin; i < end; i++)
+      y[i] += alpha * x[i];
+  }
+
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+  static void scale_range(int begin, int end, double alpha, double* HERMES_RESTRICT x)
+  {
+    for (int i = begin; i < end; i++)
+      x[i] *= alpha;
+  }
+
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+  static double norm_squared_range(int begin, int end, const double* HERMES_RESTRICT x)
+  {
+    double sum = 0.0;
+    for (int i = begin; i < end; i++)
+      sum += x[i] * x[i];
+    return sum;
+  }
+
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+  static double diff_norm_squared_range(int begin, int end, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y)
+  {
+    double sum = 0.0;
+    for (int i = begin; i < end; i++)
+      sum += (x[i] - y[i]) * (x[i] - y[i]);
+    return sum;
+  }
+
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+  static double dot_range(int begin, int end, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y)
+  {
+    double sum = 0.0;
+    for (int i = begin; i < end; i++)
+      sum += x[i] * y[i];
+    return sum;
+  }
+
+  /// The contiguous range of thread tid out of nth when splitting n entries.
+  static inline void thread_range(int n, int& begin, int& end)
+  {
+    int tid = omp_get_thread_num();
+    int nth = omp_get_num_threads();
+    begin = (int) ((long long) n * tid / nth);
+    end = (int) ((long long) n * (tid + 1) / nth);
+  }
+
+  template<>
+  HERMES_API void vector_axpy<double>(unsigned int count, double alpha, const double* HERMES_RESTRICT x, double* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel
+      {
+        int begin, end;
+        thread_range(n, begin, end);
+        axpy_range(begin, end, alpha, x, y);
+      }
+    }
+    else
+      axpy_range(0, n, alpha, x, y);
+  }
+
+  template<>
+  HERMES_API void vector_scale<double>(unsigned int count, double alpha, double* HERMES_RESTRICT x)
+  {
+    int n = (int) count;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel
+      {
+        int begin, end;
+        thread_range(n, begin, end);
+        scale_range(begin, end, alpha, x);
+      }
+    }
+    else
+      scale_range(0, n, alpha, x);
+  }
+
+  template<>
+  HERMES_API double vector_norm_squared<double>(unsigned int count, const double* HERMES_RESTRICT x)
+  {
+    int n = (int) count;
+    double sum = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel reduction(+:sum)
+      {
+        int begin, end;
+        thread_range(n, begin, end);
+        sum += norm_squared_range(begin, end, x);
+      }
+    }
+    else
+      sum = norm_squared_range(0, n, x);
+    return sum;
+  }
+
+  template<>
+  HERMES_API double vector_diff_norm_squared<double>(unsigned int count, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    double sum = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel reduction(+:sum)
+      {
+        int begin, end;
+        thread_range(n, begin, end);
+        sum += diff_norm_squared_range(begin, end, x, y);
+      }
+    }
+    else
+      sum = diff_norm_squared_range(0, n, x, y);
+    return sum;
+  }
+
+  HERMES_API double vector_dot_dispatched(unsigned int count, const double* HERMES_RESTRICT x, const double* HERMES_RESTRICT y)
+  {
+    int n = (int) count;
+    double sum = 0.0;
+    if(n >= HERMES_PARALLEL_VECTOR_OPS_LIMIT)
+    {
+      #pragma omp parallel reduction(+:sum)
+      {
+        int begin, end;
+        thread_range(n, begin, end);
+        sum += dot_range(begin, end, x, y);
+      }
+    }
+    else
+      sum = dot_range(0, n, x, y);
+    return sum;
+  }
+}
+
+#endif
@@ -34,6 +34,9 @@ namespace Hermes
       : IterSolver<Scalar>(), m(m), rhs(rhs)
     {
       pc = NULL;
+      precond_reuse_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
+      precond_iter_growth = 2.;
+      precond_baseline_iters = -1;
     }
 
     template<typename Scalar>
@@ -80,6 +83,45 @@ namespace Hermes
     {
       this->precond_yes = true;
       this->pc = pc;
+      // Apply the reuse contract of the current factorization scheme.
+      set_factorization_scheme(precond_reuse_scheme);
+    }
+
+    template<typename Scalar>
+    void AztecOOSolver<Scalar>::set_factorization_scheme(FactorizationScheme reuse_scheme)
+    {
+      precond_reuse_scheme = reuse_scheme;
+      precond_baseline_iters = -1;
+      if(pc != NULL)
+      {
+        pc->set_reuse_pattern(reuse_scheme != HERMES_FACTORIZE_FROM_SCRATCH);
+        pc->set_reuse_factors(reuse_scheme == HERMES_REUSE_FACTORIZATION_COMPLETELY);
+      }
+    }
+
+    template<typename Scalar>
+    void AztecOOSolver<Scalar>::set_precond_iter_growth(double iter_growth)
+    {
+      if(iter_growth <= 1.)
+        throw Hermes::Exceptions::ValueException("iter_growth", iter_growth, 1.);
+      this->precond_iter_growth = iter_growth;
+    }
+
+    template<typename Scalar>
+    void AztecOOSolver<Scalar>::update_precond_staleness()
+    {
+      if(pc == NULL || precond_reuse_scheme != HERMES_REUSE_FACTORIZATION_COMPLETELY)
+        return;
+
+      int iters = get_num_iters();
+      if(precond_baseline_iters < 0)
+        precond_baseline_iters = iters;
+      else if(iters > precond_iter_growth * precond_baseline_iters)
+      {
+        // The factors no longer match the matrix well - have them recomputed.
+        pc->mark_factors_stale();
+        precond_baseline_iters = -1;
+      }
     }
 
     template<typename Scalar>
@@ -153,6 +195,8 @@ namespace Hermes
       this->tick();
       this->time = this->accumulated();
 
+      update_precond_staleness();
+
       delete [] this->sln;
       this->sln = new double[m->size];
       memset(this->sln, 0, m->size * sizeof(double));
@@ -0,0 +1,385 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file block_diagonal_matrix.cpp
+\brief Block-diagonal matrix with dense per-block storage.
+*/
+#include "solvers/block_diagonal_matrix.h"
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    template<typename Scalar>
+    BlockDiagonalMatrix<Scalar>::BlockDiagonalMatrix() : SparseMatrix<Scalar>()
+    {
+      num_blocks = 0;
+      block_start = NULL;
+      block_offset = NULL;
+      block_of_dof = NULL;
+      values = NULL;
+      pivot = NULL;
+      factorized = false;
+    }
+
+    template<typename Scalar>
+    BlockDiagonalMatrix<Scalar>::~BlockDiagonalMatrix()
+    {
+      free();
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::alloc()
+    {
+      assert(this->pages != NULL);
+
+      // The coupling extent of every column; the diagonal always belongs to
+      // the block.
+      int* min_row = new int[this->size];
+      int* max_row = new int[this->size];
+      int* buffer = new int[this->size];
+      for (unsigned int j = 0; j < this->size; j++)
+      {
+        min_row[j] = max_row[j] = j;
+        if(this->pages[j] != NULL)
+        {
+          int n = this->sort_and_store_indices(this->pages[j], buffer, buffer + this->size);
+          for (int k = 0; k < n; k++)
+          {
+            if(buffer[k] < min_row[j])
+              min_row[j] = buffer[k];
+            if(buffer[k] > max_row[j])
+              max_row[j] = buffer[k];
+          }
+        }
+      }
+      delete [] this->pages;
+      this->pages = NULL;
+
+      // Close consecutive DOF ranges under coupling - each becomes one block.
+      block_start = new int[this->size + 1];
+      num_blocks = 0;
+      unsigned int start = 0;
+      while(start < this->size)
+      {
+        unsigned int end = (unsigned int) max_row[start];
+        for (unsigned int j = start; j <= end; j++)
+        {
+          if(min_row[j] < (int) start)
+            throw Hermes::Exceptions::Exception("BlockDiagonalMatrix: the coupling pattern is not block diagonal (dof %d).", j);
+          if((unsigned int) max_row[j] > end)
+            end = max_row[j];
+        }
+        block_start[num_blocks++] = start;
+        start = end + 1;
+      }
+      block_start[num_blocks] = this->size;
+      delete [] min_row;
+      delete [] max_row;
+      delete [] buffer;
+
+      block_offset = new int[num_blocks + 1];
+      block_of_dof = new int[this->size];
+      int offset = 0;
+      for (int b = 0; b < num_blocks; b++)
+      {
+        block_offset[b] = offset;
+        int nb = block_start[b + 1] - block_start[b];
+        offset += nb * nb;
+        for (int i = block_start[b]; i < block_start[b + 1]; i++)
+          block_of_dof[i] = b;
+      }
+      block_offset[num_blocks] = offset;
+
+      values = new Scalar[offset];
+      zero_with_first_touch(values, offset);
+      pivot = new int[this->size];
+      factorized = false;
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::free()
+    {
+      num_blocks = 0;
+      if(block_start != NULL)
+      {
+        delete [] block_start;
+        block_start = NULL;
+      }
+      if(block_offset != NULL)
+      {
+        delete [] block_offset;
+        block_offset = NULL;
+      }
+      if(block_of_dof != NULL)
+      {
+        delete [] block_of_dof;
+        block_of_dof = NULL;
+      }
+      if(values != NULL)
+      {
+        delete [] values;
+        values = NULL;
+      }
+      if(pivot != NULL)
+      {
+        delete [] pivot;
+        pivot = NULL;
+      }
+      factorized = false;
+    }
+
+    template<typename Scalar>
+    Scalar BlockDiagonalMatrix<Scalar>::get(unsigned int m, unsigned int n)
+    {
+      int b = block_of_dof[n];
+      if((int) m < block_start[b] || (int) m >= block_start[b + 1])
+        return Scalar(0.);
+      int nb = block_start[b + 1] - block_start[b];
+      return values[block_offset[b] + (n - block_start[b]) * nb + (m - block_start[b])];
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::zero()
+    {
+      memset(values, 0, block_offset[num_blocks] * sizeof(Scalar));
+      factorized = false;
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar v)
+    {
+      if(v == Scalar(0.))
+        return;
+      if(factorized)
+        throw Hermes::Exceptions::Exception("BlockDiagonalMatrix: the matrix holds LU factors - call zero() before refilling it.");
+      int b = block_of_dof[n];
+      if((int) m < block_start[b] || (int) m >= block_start[b + 1])
+        throw Hermes::Exceptions::Exception("BlockDiagonalMatrix: entry (%d, %d) lies outside the diagonal blocks.", m, n);
+      int nb = block_start[b + 1] - block_start[b];
+#pragma omp critical (BlockDiagonalMatrix_add)
+      values[block_offset[b] + (n - block_start[b]) * nb + (m - block_start[b])] += v;
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
+    {
+      for (unsigned int i = 0; i < m; i++)
+      {
+        if(rows[i] < 0) // skip Dir. dofs.
+          continue;
+        for (unsigned int j = 0; j < n; j++)
+          if(cols[j] >= 0 && mat[i][j] != Scalar(0.))
+            add(rows[i], cols[j], mat[i][j]);
+      }
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::add_to_diagonal(Scalar v)
+    {
+      for (unsigned int i = 0; i < this->size; i++)
+        add(i, i, v);
+    }
+
+    template<typename Scalar>
+    bool BlockDiagonalMatrix<Scalar>::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt, char* number_format)
+    {
+      switch (fmt)
+      {
+      case DF_MATLAB_SPARSE:
+        fprintf(file, "%% Size: %dx%d\n%% Nonzeros: %d\ntemp = zeros(%d, 3);\ntemp =[\n",
+          this->size, this->size, get_nnz(), get_nnz());
+        for (int b = 0; b < num_blocks; b++)
+        {
+          int nb = block_start[b + 1] - block_start[b];
+          for (int j = 0; j < nb; j++)
+            for (int i = 0; i < nb; i++)
+            {
+              fprintf(file, "%d %d ", block_start[b] + i + 1, block_start[b] + j + 1);
+              Hermes::Helpers::fprint_num(file, values[block_offset[b] + j * nb + i], number_format);
+              fprintf(file, "\n");
+            }
+        }
+        fprintf(file, "];\n%s = spconvert(temp);\n", var_name);
+        return true;
+
+      default:
+        return false;
+      }
+    }
+
+    template<typename Scalar>
+    unsigned int BlockDiagonalMatrix<Scalar>::get_matrix_size() const
+    {
+      return this->size;
+    }
+
+    template<typename Scalar>
+    unsigned int BlockDiagonalMatrix<Scalar>::get_nnz() const
+    {
+      return (block_offset == NULL) ? 0 : block_offset[num_blocks];
+    }
+
+    template<typename Scalar>
+    double BlockDiagonalMatrix<Scalar>::get_fill_in() const
+    {
+      return get_nnz() / (double) (this->size * this->size);
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar* vector_out)
+    {
+      if(factorized)
+        throw Hermes::Exceptions::Exception("BlockDiagonalMatrix: the matrix holds LU factors, multiplication is not available.");
+      int b;
+#pragma omp parallel for private(b)
+      for (b = 0; b < num_blocks; b++)
+      {
+        int base = block_start[b];
+        int nb = block_start[b + 1] - base;
+        Scalar* block = values + block_offset[b];
+        for (int i = 0; i < nb; i++)
+          vector_out[base + i] = Scalar(0.);
+        for (int j = 0; j < nb; j++)
+        {
+          Scalar x = vector_in[base + j];
+          for (int i = 0; i < nb; i++)
+            vector_out[base + i] += block[j * nb + i] * x;
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::multiply_with_Scalar(Scalar value)
+    {
+      int total = block_offset[num_blocks];
+      for (int k = 0; k < total; k++)
+        values[k] *= value;
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::factorize()
+    {
+      if(factorized)
+        return;
+
+      // One independent dense LU factorization with partial pivoting per
+      // block, run in parallel; the factors overwrite the values in place and
+      // the row permutation goes to pivot.
+      int b;
+      bool singular = false;
+#pragma omp parallel for private(b) schedule(dynamic)
+      for (b = 0; b < num_blocks; b++)
+      {
+        int base = block_start[b];
+        int nb = block_start[b + 1] - base;
+        Scalar* block = values + block_offset[b];
+        int* perm = pivot + base;
+
+        for (int k = 0; k < nb; k++)
+        {
+          int p = k;
+          double p_mag = std::abs(block[k * nb + k]);
+          for (int i = k + 1; i < nb; i++)
+          {
+            double mag = std::abs(block[k * nb + i]);
+            if(mag > p_mag)
+            {
+              p = i;
+              p_mag = mag;
+            }
+          }
+          if(p_mag == 0.0)
+          {
+            singular = true;
+            break;
+          }
+          perm[k] = p;
+          if(p != k)
+            for (int j = 0; j < nb; j++)
+            {
+              Scalar tmp = block[j * nb + k];
+              block[j * nb + k] = block[j * nb + p];
+              block[j * nb + p] = tmp;
+            }
+          Scalar d = block[k * nb + k];
+          for (int i = k + 1; i < nb; i++)
+          {
+            Scalar l = block[k * nb + i] / d;
+            block[k * nb + i] = l;
+            for (int j = k + 1; j < nb; j++)
+              block[j * nb + i] -= l * block[j * nb + k];
+          }
+        }
+      }
+      if(singular)
+        throw Hermes::Exceptions::Exception("BlockDiagonalMatrix: a diagonal block is singular.");
+
+      factorized = true;
+    }
+
+    template<typename Scalar>
+    void BlockDiagonalMatrix<Scalar>::solve(const Scalar* rhs, Scalar* sln)
+    {
+      if(!factorized)
+        factorize();
+
+      int b;
+#pragma omp parallel for private(b) schedule(dynamic)
+      for (b = 0; b < num_blocks; b++)
+      {
+        int base = block_start[b];
+        int nb = block_start[b + 1] - base;
+        Scalar* block = values + block_offset[b];
+        int* perm = pivot + base;
+        Scalar* x = sln + base;
+
+        if(x != rhs + base)
+          for (int i = 0; i < nb; i++)
+            x[i] = rhs[base + i];
+
+        // apply the row permutation, then the two triangular sweeps
+        for (int k = 0; k < nb; k++)
+          if(perm[k] != k)
+          {
+            Scalar tmp = x[k];
+            x[k] = x[perm[k]];
+            x[perm[k]] = tmp;
+          }
+        for (int k = 0; k < nb; k++)
+          for (int i = k + 1; i < nb; i++)
+            x[i] -= block[k * nb + i] * x[k];
+        for (int k = nb - 1; k >= 0; k--)
+        {
+          x[k] /= block[k * nb + k];
+          for (int i = 0; i < k; i++)
+            x[i] -= block[k * nb + i] * x[k];
+        }
+      }
+    }
+
+    template<typename Scalar>
+    int BlockDiagonalMatrix<Scalar>::get_num_blocks() const
+    {
+      return num_blocks;
+    }
+
+    template class HERMES_API BlockDiagonalMatrix<double>;
+    template class HERMES_API BlockDiagonalMatrix<std::complex<double> >;
+  }
+}
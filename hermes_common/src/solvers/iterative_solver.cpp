@@ -0,0 +1,488 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file iterative_solver.cpp
+\brief IterativeLinearMatrixSolver - native preconditioned CG / GMRES.
+*/
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "iterative_solver.h"
+#include "callstack.h"
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    // Conjugation helpers - common.h provides Hermes::conj only for double.
+    static double scalar_conj(double a) { return a; }
+    static std::complex<double> scalar_conj(std::complex<double> a) { return std::conj(a); }
+
+    /// Inner product conjugated in the first argument, sum conj(a_i) * b_i.
+    template<typename Scalar>
+    static Scalar vec_dot(const Scalar* a, const Scalar* b, int n)
+    {
+      return Hermes::vector_dot((unsigned int) n, a, b);
+    }
+
+    /// Euclidean norm.
+    template<typename Scalar>
+    static double vec_norm(const Scalar* a, int n)
+    {
+      return std::sqrt(Hermes::vector_norm_squared((unsigned int) n, a));
+    }
+
+    template<typename Scalar>
+    IterativeLinearMatrixSolver<Scalar>::IterativeLinearMatrixSolver(CSCMatrix<Scalar> *m, UMFPackVector<Scalar> *rhs)
+      : IterSolver<Scalar>(), m(m), rhs(rhs),
+      method(IterativeMethodGMRES), precond_type(PreconditionerJacobi), gmres_restart(50),
+      num_iters(0), residual_norm(0.0), jacobi_diag(NULL), ilu_values(NULL), diag_pos(NULL)
+    {
+      this->precond_yes = true;
+    }
+
+    template<typename Scalar>
+    IterativeLinearMatrixSolver<Scalar>::~IterativeLinearMatrixSolver()
+    {
+      free_precond();
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::set_solver(const char *solver)
+    {
+      if(solver && strcasecmp(solver, "cg") == 0)
+        method = IterativeMethodCG;
+      else
+        method = IterativeMethodGMRES;
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::set_gmres_restart(int restart)
+    {
+      if(restart < 1)
+        throw Hermes::Exceptions::ValueException("restart", restart, 1);
+      gmres_restart = restart;
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::set_precond(const char *name)
+    {
+      if(name && strcasecmp(name, "jacobi") == 0)
+        precond_type = PreconditionerJacobi;
+      else if(name && strcasecmp(name, "ilu") == 0)
+        precond_type = PreconditionerILU;
+      else
+        precond_type = PreconditionerNone;
+
+      this->precond_yes = (precond_type != PreconditionerNone);
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::set_precond(Precond<Scalar> *pc)
+    {
+      this->warn("External preconditioner objects are not supported by IterativeLinearMatrixSolver, use set_precond(const char*).");
+    }
+
+    template<typename Scalar>
+    int IterativeLinearMatrixSolver<Scalar>::get_matrix_size()
+    {
+      return m->get_size();
+    }
+
+    template<typename Scalar>
+    int IterativeLinearMatrixSolver<Scalar>::get_num_iters()
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    double IterativeLinearMatrixSolver<Scalar>::get_residual()
+    {
+      return residual_norm;
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::free_precond()
+    {
+      if(jacobi_diag != NULL)
+      {
+        delete [] jacobi_diag;
+        jacobi_diag = NULL;
+      }
+      if(ilu_values != NULL)
+      {
+        delete [] ilu_values;
+        ilu_values = NULL;
+      }
+      if(diag_pos != NULL)
+      {
+        delete [] diag_pos;
+        diag_pos = NULL;
+      }
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::build_precond()
+    {
+      free_precond();
+
+      if(precond_type == PreconditionerNone)
+        return;
+
+      int size = m->get_size();
+      int *Ap = m->get_Ap();
+      int *Ai = m->get_Ai();
+      Scalar *Ax = m->get_Ax();
+
+      if(precond_type == PreconditionerJacobi)
+      {
+        jacobi_diag = new Scalar[size];
+        for (int j = 0; j < size; j++)
+        {
+          Scalar diag = 0.0;
+          for (int pos = Ap[j]; pos < Ap[j + 1]; pos++)
+            if(Ai[pos] == j)
+            {
+              diag = Ax[pos];
+              break;
+            }
+          if(diag == Scalar(0.0))
+            throw Hermes::Exceptions::Exception("IterativeLinearMatrixSolver: zero diagonal entry in row %d, the Jacobi preconditioner cannot be built.", j);
+          jacobi_diag[j] = Scalar(1.0) / diag;
+        }
+        return;
+      }
+
+      // ILU(0). The CSC arrays of A are the CSR arrays of B = A^T, so the standard
+      // row-wise factorization B = L_B * U_B is run on them directly. The factors of A
+      // follow by transposition, A ~ U_B^T * L_B^T, and the triangular solves in
+      // apply_precond() scatter along the same arrays.
+      int nnz = m->get_nnz();
+      ilu_values = new Scalar[nnz];
+      memcpy(ilu_values, Ax, nnz * sizeof(Scalar));
+      diag_pos = new int[size];
+
+      for (int i = 0; i < size; i++)
+      {
+        diag_pos[i] = -1;
+        for (int pos = Ap[i]; pos < Ap[i + 1]; pos++)
+          if(Ai[pos] == i)
+          {
+            diag_pos[i] = pos;
+            break;
+          }
+        if(diag_pos[i] == -1)
+          throw Hermes::Exceptions::Exception("IterativeLinearMatrixSolver: missing diagonal entry in row %d, the ILU(0) preconditioner cannot be built.", i);
+      }
+
+      for (int i = 0; i < size; i++)
+      {
+        for (int pos = Ap[i]; pos < Ap[i + 1] && Ai[pos] < i; pos++)
+        {
+          int k = Ai[pos];
+          if(ilu_values[diag_pos[k]] == Scalar(0.0))
+            throw Hermes::Exceptions::Exception("IterativeLinearMatrixSolver: zero pivot in row %d of the ILU(0) factorization.", k);
+          ilu_values[pos] = ilu_values[pos] / ilu_values[diag_pos[k]];
+          Scalar factor = ilu_values[pos];
+
+          // Update the remainder of row i, but only on the existing pattern.
+          int pos_i = pos + 1;
+          for (int pos_k = diag_pos[k] + 1; pos_k < Ap[k + 1]; pos_k++)
+          {
+            int j = Ai[pos_k];
+            while (pos_i < Ap[i + 1] && Ai[pos_i] < j)
+              pos_i++;
+            if(pos_i < Ap[i + 1] && Ai[pos_i] == j)
+              ilu_values[pos_i] -= factor * ilu_values[pos_k];
+          }
+        }
+        if(ilu_values[diag_pos[i]] == Scalar(0.0))
+          throw Hermes::Exceptions::Exception("IterativeLinearMatrixSolver: zero pivot in row %d of the ILU(0) factorization.", i);
+      }
+    }
+
+    template<typename Scalar>
+    void IterativeLinearMatrixSolver<Scalar>::apply_precond(const Scalar* in, Scalar* out) const
+    {
+      int size = m->get_size();
+
+      switch (precond_type)
+      {
+      case PreconditionerNone:
+        memcpy(out, in, size * sizeof(Scalar));
+        break;
+
+      case PreconditionerJacobi:
+        for (int i = 0; i < size; i++)
+          out[i] = jacobi_diag[i] * in[i];
+        break;
+
+      case PreconditionerILU:
+        {
+          int *Ap = m->get_Ap();
+          int *Ai = m->get_Ai();
+
+          memcpy(out, in, size * sizeof(Scalar));
+
+          // Forward solve with U_B^T (lower triangular, columns stored as rows of U_B).
+          for (int i = 0; i < size; i++)
+          {
+            out[i] = out[i] / ilu_values[diag_pos[i]];
+            for (int pos = diag_pos[i] + 1; pos < Ap[i + 1]; pos++)
+              out[Ai[pos]] -= ilu_values[pos] * out[i];
+          }
+
+          // Backward solve with L_B^T (unit upper triangular, columns stored as rows of L_B).
+          for (int j = size - 1; j >= 0; j--)
+            for (int pos = Ap[j]; pos < Ap[j + 1] && Ai[pos] < j; pos++)
+              out[Ai[pos]] -= ilu_values[pos] * out[j];
+        }
+        break;
+      }
+    }
+
+    template<typename Scalar>
+    bool IterativeLinearMatrixSolver<Scalar>::solve_cg(Scalar* x)
+    {
+      int size = m->get_size();
+
+      Scalar *r = new Scalar[size];
+      Scalar *z = new Scalar[size];
+      Scalar *p = new Scalar[size];
+      Scalar *Ap_vec = new Scalar[size];
+
+      // The initial guess is zero, hence r = b.
+      memcpy(r, rhs->get_c_array(), size * sizeof(Scalar));
+      double b_norm = vec_norm(r, size);
+      if(b_norm == 0.0)
+      {
+        num_iters = 0;
+        residual_norm = 0.0;
+        delete [] r; delete [] z; delete [] p; delete [] Ap_vec;
+        return true;
+      }
+
+      apply_precond(r, z);
+      memcpy(p, z, size * sizeof(Scalar));
+      Scalar rho = vec_dot(r, z, size);
+
+      bool converged = false;
+      for (int iter = 1; iter <= this->max_iters; iter++)
+      {
+        m->multiply_with_vector(p, Ap_vec);
+        Scalar p_Ap = vec_dot(p, Ap_vec, size);
+        if(p_Ap == Scalar(0.0))
+        {
+          this->warn("IterativeLinearMatrixSolver: breakdown in CG, the matrix is probably not symmetric positive definite.");
+          break;
+        }
+
+        Scalar alpha = rho / p_Ap;
+        for (int i = 0; i < size; i++)
+        {
+          x[i] += alpha * p[i];
+          r[i] -= alpha * Ap_vec[i];
+        }
+
+        num_iters = iter;
+        residual_norm = vec_norm(r, size) / b_norm;
+        if(residual_norm <= this->tolerance)
+        {
+          converged = true;
+          break;
+        }
+
+        apply_precond(r, z);
+        Scalar rho_new = vec_dot(r, z, size);
+        Scalar beta = rho_new / rho;
+        rho = rho_new;
+        for (int i = 0; i < size; i++)
+          p[i] = z[i] + beta * p[i];
+      }
+
+      delete [] r; delete [] z; delete [] p; delete [] Ap_vec;
+      return converged;
+    }
+
+    template<typename Scalar>
+    bool IterativeLinearMatrixSolver<Scalar>::solve_gmres(Scalar* x)
+    {
+      int size = m->get_size();
+      int mr = gmres_restart;
+
+      Scalar *r = new Scalar[size];
+      Scalar *z = new Scalar[size];
+      Scalar *w = new Scalar[size];
+      Scalar **V = new Scalar*[mr + 1];
+      for (int i = 0; i < mr + 1; i++)
+        V[i] = new Scalar[size];
+      // Hessenberg matrix of the Arnoldi process, stored by columns.
+      Scalar *H = new Scalar[(mr + 1) * mr];
+      Scalar *cs = new Scalar[mr];
+      Scalar *sn = new Scalar[mr];
+      Scalar *g = new Scalar[mr + 1];
+      Scalar *y = new Scalar[mr];
+
+      // Left preconditioning, convergence is measured on M^{-1}(b - A*x).
+      apply_precond(rhs->get_c_array(), z);
+      double b_norm = vec_norm(z, size);
+
+      bool converged = false;
+      bool breakdown = false;
+      num_iters = 0;
+      residual_norm = 0.0;
+
+      if(b_norm == 0.0)
+        converged = true;
+
+      while (!converged && !breakdown && num_iters < this->max_iters)
+      {
+        m->multiply_with_vector(x, r);
+        for (int i = 0; i < size; i++)
+          r[i] = rhs->get_c_array()[i] - r[i];
+        apply_precond(r, z);
+        double beta = vec_norm(z, size);
+
+        residual_norm = beta / b_norm;
+        if(residual_norm <= this->tolerance)
+        {
+          converged = true;
+          break;
+        }
+
+        for (int i = 0; i < size; i++)
+          V[0][i] = z[i] / beta;
+        g[0] = beta;
+        for (int i = 1; i < mr + 1; i++)
+          g[i] = 0.0;
+
+        int k;
+        for (k = 0; k < mr; k++)
+        {
+          m->multiply_with_vector(V[k], r);
+          apply_precond(r, w);
+
+          // Modified Gram-Schmidt orthogonalization.
+          for (int i = 0; i <= k; i++)
+          {
+            H[i + k * (mr + 1)] = vec_dot(V[i], w, size);
+            for (int j = 0; j < size; j++)
+              w[j] -= H[i + k * (mr + 1)] * V[i][j];
+          }
+          H[(k + 1) + k * (mr + 1)] = vec_norm(w, size);
+          if(vec_norm(w, size) != 0.0)
+            for (int j = 0; j < size; j++)
+              V[k + 1][j] = w[j] / H[(k + 1) + k * (mr + 1)];
+
+          // Previously computed Givens rotations applied to the new column.
+          for (int i = 0; i < k; i++)
+          {
+            Scalar temp = scalar_conj(cs[i]) * H[i + k * (mr + 1)] + scalar_conj(sn[i]) * H[(i + 1) + k * (mr + 1)];
+            H[(i + 1) + k * (mr + 1)] = -sn[i] * H[i + k * (mr + 1)] + cs[i] * H[(i + 1) + k * (mr + 1)];
+            H[i + k * (mr + 1)] = temp;
+          }
+
+          // The new rotation annihilating the subdiagonal entry.
+          double denom = std::sqrt(Hermes::sqr(H[k + k * (mr + 1)]) + Hermes::sqr(H[(k + 1) + k * (mr + 1)]));
+          if(denom == 0.0)
+          {
+            this->warn("IterativeLinearMatrixSolver: breakdown in GMRES, the matrix is probably singular.");
+            breakdown = true;
+            break;
+          }
+          cs[k] = H[k + k * (mr + 1)] / denom;
+          sn[k] = H[(k + 1) + k * (mr + 1)] / denom;
+          H[k + k * (mr + 1)] = scalar_conj(cs[k]) * H[k + k * (mr + 1)] + scalar_conj(sn[k]) * H[(k + 1) + k * (mr + 1)];
+          H[(k + 1) + k * (mr + 1)] = 0.0;
+          g[k + 1] = -sn[k] * g[k];
+          g[k] = scalar_conj(cs[k]) * g[k];
+
+          num_iters++;
+          residual_norm = std::abs(g[k + 1]) / b_norm;
+          if(residual_norm <= this->tolerance)
+          {
+            converged = true;
+            k++;
+            break;
+          }
+          if(num_iters >= this->max_iters)
+          {
+            k++;
+            break;
+          }
+        }
+        if(breakdown)
+          break;
+        if(k == 0)
+          continue;
+
+        // Back substitution in the triangularized Hessenberg system and solution update.
+        for (int i = k - 1; i >= 0; i--)
+        {
+          y[i] = g[i];
+          for (int j = i + 1; j < k; j++)
+            y[i] -= H[i + j * (mr + 1)] * y[j];
+          y[i] = y[i] / H[i + i * (mr + 1)];
+        }
+        for (int i = 0; i < k; i++)
+          for (int j = 0; j < size; j++)
+            x[j] += y[i] * V[i][j];
+      }
+
+      delete [] r; delete [] z; delete [] w;
+      for (int i = 0; i < mr + 1; i++)
+        delete [] V[i];
+      delete [] V;
+      delete [] H; delete [] cs; delete [] sn; delete [] g; delete [] y;
+      return converged;
+    }
+
+    template<typename Scalar>
+    bool IterativeLinearMatrixSolver<Scalar>::solve()
+    {
+      assert(m != NULL);
+      assert(rhs != NULL);
+      assert(m->get_size() == rhs->length());
+
+      this->tick();
+
+      build_precond();
+
+      delete [] this->sln;
+      this->sln = new Scalar[m->get_size()];
+      memset(this->sln, 0, m->get_size() * sizeof(Scalar));
+
+      bool converged;
+      if(method == IterativeMethodCG)
+        converged = solve_cg(this->sln);
+      else
+        converged = solve_gmres(this->sln);
+
+      this->tick();
+      this->time = this->accumulated();
+
+      if(!converged)
+        this->warn("IterativeLinearMatrixSolver did not converge in %d iterations (relative residual %g).", num_iters, residual_norm);
+
+      return true;
+    }
+
+    template class HERMES_API IterativeLinearMatrixSolver<double>;
+    template class HERMES_API IterativeLinearMatrixSolver<std::complex<double> >;
+  }
+}
+#endif
@@ -27,6 +27,7 @@
 #include "mumps_solver.h"
 #include "newton_solver_nox.h"
 #include "aztecoo_solver.h"
+#include "iterative_solver.h"
 #include "api.h"
 
 using namespace Hermes::Algebra;
@@ -49,6 +50,19 @@ namespace Hermes
         delete [] sln;
     }
 
+    template<typename Scalar>
+    bool LinearMatrixSolver<Scalar>::solve(Scalar* rhs_block, int nrhs)
+    {
+      throw Hermes::Exceptions::MethodNotOverridenException("LinearMatrixSolver<Scalar>::solve(Scalar*, int)");
+      return false;
+    }
+
+    template<typename Scalar>
+    void LinearMatrixSolver<Scalar>::retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      throw Hermes::Exceptions::MethodNotOverridenException("LinearMatrixSolver<Scalar>::retarget(Matrix<Scalar>*, Vector<Scalar>*)");
+    }
+
     template<typename Scalar>
     Scalar *LinearMatrixSolver<Scalar>::get_sln_vector()
     {
@@ -73,72 +87,124 @@ namespace Hermes
       set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
     }
 
+    /// The registry itself is a function-local static, so that backends registering
+    /// from static initializers of other translation units never see it unconstructed.
     template<typename Scalar>
-    LinearMatrixSolver<Scalar>* create_linear_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    static std::map<int, typename LinearMatrixSolverRegistry<Scalar>::SolverConstructor>& registered_solver_constructors()
     {
-      Vector<Scalar>* rhs_dummy = NULL;
-      switch (Hermes::HermesCommonApi.get_integral_param_value(Hermes::matrixSolverType))
-      {
-      case Hermes::SOLVER_AZTECOO:
-        {
+      static std::map<int, typename LinearMatrixSolverRegistry<Scalar>::SolverConstructor> registry;
+      return registry;
+    }
+
+    template<typename Scalar>
+    void LinearMatrixSolverRegistry<Scalar>::add(MatrixSolverType type, SolverConstructor constructor)
+    {
+      registered_solver_constructors<Scalar>()[type] = constructor;
+    }
+
+    template<typename Scalar>
+    typename LinearMatrixSolverRegistry<Scalar>::SolverConstructor LinearMatrixSolverRegistry<Scalar>::get(MatrixSolverType type)
+    {
+      typename std::map<int, SolverConstructor>::iterator it = registered_solver_constructors<Scalar>().find(type);
+      if(it == registered_solver_constructors<Scalar>().end())
+        return NULL;
+      return it->second;
+    }
+
+    // Load-time registration of the built-in backends.
 #if defined HAVE_AZTECOO && defined HAVE_EPETRA
-          if(rhs != NULL) return new AztecOOSolver<Scalar>(static_cast<EpetraMatrix<Scalar>*>(matrix), static_cast<EpetraVector<Scalar>*>(rhs));
-          else return new AztecOOSolver<Scalar>(static_cast<EpetraMatrix<Scalar>*>(matrix), static_cast<EpetraVector<Scalar>*>(rhs_dummy));
-#else
-          throw Hermes::Exceptions::Exception("AztecOO not installed.");
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_aztecoo_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new AztecOOSolver<Scalar>(static_cast<EpetraMatrix<Scalar>*>(matrix), static_cast<EpetraVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> aztecoo_registered_real(Hermes::SOLVER_AZTECOO, construct_aztecoo_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > aztecoo_registered_cplx(Hermes::SOLVER_AZTECOO, construct_aztecoo_solver<std::complex<double> >);
 #endif
-          break;
-        }
-      case Hermes::SOLVER_AMESOS:
-        {
+
 #if defined HAVE_AMESOS && defined HAVE_EPETRA
-          if(rhs != NULL) return new AmesosSolver<Scalar>("Amesos_Klu", static_cast<EpetraMatrix<Scalar>*>(matrix), static_cast<EpetraVector<Scalar>*>(rhs));
-          else return new AmesosSolver<Scalar>("Amesos_Klu", static_cast<EpetraMatrix<Scalar>*>(matrix), static_cast<EpetraVector<Scalar>*>(rhs_dummy));
-#else
-          throw Hermes::Exceptions::Exception("Amesos not installed.");
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_amesos_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new AmesosSolver<Scalar>("Amesos_Klu", static_cast<EpetraMatrix<Scalar>*>(matrix), static_cast<EpetraVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> amesos_registered_real(Hermes::SOLVER_AMESOS, construct_amesos_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > amesos_registered_cplx(Hermes::SOLVER_AMESOS, construct_amesos_solver<std::complex<double> >);
 #endif
-          break;
-        }
-      case Hermes::SOLVER_MUMPS:
-        {
+
 #ifdef WITH_MUMPS
-          if(rhs != NULL) return new MumpsSolver<Scalar>(static_cast<MumpsMatrix<Scalar>*>(matrix), static_cast<MumpsVector<Scalar>*>(rhs));
-          else return new MumpsSolver<Scalar>(static_cast<MumpsMatrix<Scalar>*>(matrix), static_cast<MumpsVector<Scalar>*>(rhs_dummy));
-#else
-          throw Hermes::Exceptions::Exception("MUMPS was not installed.");
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_mumps_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new MumpsSolver<Scalar>(static_cast<MumpsMatrix<Scalar>*>(matrix), static_cast<MumpsVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> mumps_registered_real(Hermes::SOLVER_MUMPS, construct_mumps_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > mumps_registered_cplx(Hermes::SOLVER_MUMPS, construct_mumps_solver<std::complex<double> >);
 #endif
-          break;
-        }
-      case Hermes::SOLVER_PETSC:
-        {
+
 #ifdef WITH_PETSC
-          if(rhs != NULL) return new PetscLinearMatrixSolver<Scalar>(static_cast<PetscMatrix<Scalar>*>(matrix), static_cast<PetscVector<Scalar>*>(rhs));
-          else return new PetscLinearMatrixSolver<Scalar>(static_cast<PetscMatrix<Scalar>*>(matrix), static_cast<PetscVector<Scalar>*>(rhs_dummy));
-#else
-          throw Hermes::Exceptions::Exception("PETSc not installed.");
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_petsc_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new PetscLinearMatrixSolver<Scalar>(static_cast<PetscMatrix<Scalar>*>(matrix), static_cast<PetscVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> petsc_registered_real(Hermes::SOLVER_PETSC, construct_petsc_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > petsc_registered_cplx(Hermes::SOLVER_PETSC, construct_petsc_solver<std::complex<double> >);
 #endif
-          break;
-        }
-      case Hermes::SOLVER_UMFPACK:
-        {
+
 #ifdef WITH_UMFPACK
-          if(rhs != NULL) return new UMFPackLinearMatrixSolver<Scalar>(static_cast<UMFPackMatrix<Scalar>*>(matrix), static_cast<UMFPackVector<Scalar>*>(rhs));
-          else return new UMFPackLinearMatrixSolver<Scalar>(static_cast<UMFPackMatrix<Scalar>*>(matrix), static_cast<UMFPackVector<Scalar>*>(rhs_dummy));
-#else
-          throw Hermes::Exceptions::Exception("UMFPACK was not installed.");
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_umfpack_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new UMFPackLinearMatrixSolver<Scalar>(static_cast<UMFPackMatrix<Scalar>*>(matrix), static_cast<UMFPackVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> umfpack_registered_real(Hermes::SOLVER_UMFPACK, construct_umfpack_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > umfpack_registered_cplx(Hermes::SOLVER_UMFPACK, construct_umfpack_solver<std::complex<double> >);
+
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_iterative_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new IterativeLinearMatrixSolver<Scalar>(static_cast<CSCMatrix<Scalar>*>(matrix), static_cast<UMFPackVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> iterative_registered_real(Hermes::SOLVER_ITERATIVE, construct_iterative_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > iterative_registered_cplx(Hermes::SOLVER_ITERATIVE, construct_iterative_solver<std::complex<double> >);
 #endif
-          break;
-        }
-      case Hermes::SOLVER_SUPERLU:
-        {
+
 #ifdef WITH_SUPERLU
-          if(rhs != NULL) return new SuperLUSolver<Scalar>(static_cast<SuperLUMatrix<Scalar>*>(matrix), static_cast<SuperLUVector<Scalar>*>(rhs));
-          else return new SuperLUSolver<Scalar>(static_cast<SuperLUMatrix<Scalar>*>(matrix), static_cast<SuperLUVector<Scalar>*>(rhs_dummy));
-#else
-          throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+    template<typename Scalar>
+    static LinearMatrixSolver<Scalar>* construct_superlu_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      return new SuperLUSolver<Scalar>(static_cast<SuperLUMatrix<Scalar>*>(matrix), static_cast<SuperLUVector<Scalar>*>(rhs));
+    }
+    static RegisterLinearMatrixSolver<double> superlu_registered_real(Hermes::SOLVER_SUPERLU, construct_superlu_solver<double>);
+    static RegisterLinearMatrixSolver<std::complex<double> > superlu_registered_cplx(Hermes::SOLVER_SUPERLU, construct_superlu_solver<std::complex<double> >);
 #endif
-          break;
-        }
+
+    template<typename Scalar>
+    LinearMatrixSolver<Scalar>* create_linear_solver(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      MatrixSolverType type = static_cast<MatrixSolverType>(Hermes::HermesCommonApi.get_integral_param_value(Hermes::matrixSolverType));
+      typename LinearMatrixSolverRegistry<Scalar>::SolverConstructor constructor = LinearMatrixSolverRegistry<Scalar>::get(type);
+      if(constructor != NULL)
+        return constructor(matrix, rhs);
+
+      // No backend registered for the requested type - report why.
+      switch (type)
+      {
+      case Hermes::SOLVER_AZTECOO:
+        throw Hermes::Exceptions::Exception("AztecOO not installed.");
+      case Hermes::SOLVER_AMESOS:
+        throw Hermes::Exceptions::Exception("Amesos not installed.");
+      case Hermes::SOLVER_MUMPS:
+        throw Hermes::Exceptions::Exception("MUMPS was not installed.");
+      case Hermes::SOLVER_PETSC:
+        throw Hermes::Exceptions::Exception("PETSc not installed.");
+      case Hermes::SOLVER_UMFPACK:
+        throw Hermes::Exceptions::Exception("UMFPACK was not installed.");
+      case Hermes::SOLVER_SUPERLU:
+        throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+      case Hermes::SOLVER_ITERATIVE:
+        throw Hermes::Exceptions::Exception("The iterative solver requires the CSC matrix classes, UMFPACK was not installed.");
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_linear_solver().");
       }
@@ -169,6 +235,8 @@ namespace Hermes
 
     template class HERMES_API LinearMatrixSolver<double>;
     template class HERMES_API LinearMatrixSolver<std::complex<double> >;
+    template class HERMES_API LinearMatrixSolverRegistry<double>;
+    template class HERMES_API LinearMatrixSolverRegistry<std::complex<double> >;
     template class HERMES_API DirectSolver<double>;
     template class HERMES_API DirectSolver<std::complex<double> >;
     template class HERMES_API IterSolver<double>;
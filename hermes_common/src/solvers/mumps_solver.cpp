@@ -112,13 +112,25 @@ namespace Hermes
       Ax = new typename mumps_type<Scalar>::mumps_Scalar[nnz];
       memset(Ax, 0, sizeof(Scalar) * nnz);
 
+      // The coordinate-format mirror (irn / jcn) is built on demand by
+      // build_coordinate_indices() - the assembling works with the CSC
+      // arrays only.
+    }
+
+    template<typename Scalar>
+    void MumpsMatrix<Scalar>::build_coordinate_indices()
+    {
+      if(irn != NULL)
+        return;
+
       irn = new int[nnz];
       jcn = new int[nnz];
-      for (unsigned int i = 0; i < nnz; i++)
-      {
-        irn[i] = 1;
-        jcn[i] = 1;
-      }
+      for (unsigned int j = 0; j < this->size; j++)
+        for (unsigned int i = Ap[j]; i < Ap[j + 1]; i++)
+        {
+          irn[i] = Ai[i] + 1;  // MUMPS is indexing from 1
+          jcn[i] = j + 1;
+        }
     }
 
     template<typename Scalar>
@@ -181,8 +193,6 @@ namespace Hermes
       pos += Ap[n];
 #pragma omp critical (MumpsMatrix_add)
       Ax[pos] += v;
-      irn[pos] = m + 1;  // MUMPS is indexing from 1
-      jcn[pos] = n + 1;
     }
 
     template<typename Scalar>
@@ -214,6 +224,7 @@ namespace Hermes
       switch (fmt)
       {
       case DF_PLAIN_ASCII:
+        build_coordinate_indices();
         fprintf(file, "%d\n", this->size);
         fprintf(file, "%d\n", nnz);
         for (unsigned int i = 0; i < nnz; i++)
@@ -331,11 +342,12 @@ namespace Hermes
         vector_out[i] = 0;
       }
       Scalar a;
-      for (unsigned int i = 0;i<nnz;i++)
-      {
-        a = mumps_to_Scalar(Ax[i]);
-        vector_out[jcn[i]-1] +=vector_in[irn[i]-1]*a;
-      }
+      for (unsigned int j = 0;j<this->size;j++)
+        for (unsigned int i = Ap[j];i<Ap[j + 1];i++)
+        {
+          a = mumps_to_Scalar(Ax[i]);
+          vector_out[j] +=vector_in[Ai[i]]*a;
+        }
     }
     // Multiplies matrix with a Scalar.
     template<>
@@ -382,20 +394,13 @@ namespace Hermes
       this->Ap = new unsigned int[this->size + 1]; assert(this->Ap != NULL);
       this->Ai = new int[nnz];    assert(this->Ai != NULL);
       this->Ax = new typename mumps_type<Scalar>::mumps_Scalar[nnz]; assert(this->Ax != NULL);
-      irn = new int[nnz];           assert(this->irn !=NULL);     // Row indices.
-      jcn = new int[nnz];           assert(this->jcn !=NULL);     // Column indices.
 
-      for (unsigned int i = 0; i < this->size; i++)
-      {
+      for (unsigned int i = 0; i < this->size + 1; i++)
         this->Ap[i] = ap[i];
-        for (int j = ap[i];j<ap[i + 1];j++) jcn[j] = i;
-      }
-      this->Ap[this->size] = ap[this->size];
       for (unsigned int i = 0; i < nnz; i++)
       {
         mumps_assign_Scalar(this->Ax[i], ax[i]);
         this->Ai[i] = ai[i];
-        irn[i] = ai[i];
       }
     }
     // Duplicates a matrix (including allocation).
@@ -409,14 +414,10 @@ namespace Hermes
       nmat->Ap = new unsigned int[this->size + 1]; assert(nmat->Ap != NULL);
       nmat->Ai = new int[nnz];    assert(nmat->Ai != NULL);
       nmat->Ax = new typename mumps_type<Scalar>::mumps_Scalar[nnz]; assert(nmat->Ax != NULL);
-      nmat->irn = new int[nnz];           assert(nmat->irn !=NULL);     // Row indices.
-      nmat->jcn = new int[nnz];           assert(nmat->jcn !=NULL);     // Column indices.
       for (unsigned int i = 0;i<nnz;i++)
       {
         nmat->Ai[i] = Ai[i];
         nmat->Ax[i] = Ax[i];
-        nmat->irn[i] = irn[i];
-        nmat->jcn[i] = jcn[i];
       }
       for (unsigned int i = 0;i<this->size + 1;i++)
       {
@@ -629,7 +630,9 @@ namespace Hermes
         param.ICNTL(20) = 0; // centralized dense RHS
         param.ICNTL(21) = 0; // centralized dense solution
 
-        // Specify the matrix.
+        // Specify the matrix. The coordinate-format indices are derived from
+        // the CSC structure here, right before MUMPS needs them.
+        m->build_coordinate_indices();
         param.n = m->size;
         param.nz = m->nnz;
         param.irn = m->irn;
@@ -672,6 +675,15 @@ namespace Hermes
       return m->size;
     }
 
+    template<typename Scalar>
+    void MumpsSolver<Scalar>::retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      if(matrix == NULL)
+        throw Exceptions::NullException(1);
+      this->m = static_cast<MumpsMatrix<Scalar>*>(matrix);
+      this->rhs = static_cast<MumpsVector<Scalar>*>(rhs);
+    }
+
     template<typename Scalar>
     bool MumpsSolver<Scalar>::solve()
     {
@@ -715,6 +727,49 @@ namespace Hermes
       return ret;
     }
 
+    template<typename Scalar>
+    bool MumpsSolver<Scalar>::solve(Scalar* rhs_block, int nrhs)
+    {
+      bool ret = false;
+      assert(m != NULL);
+      assert(rhs_block != NULL);
+
+      this->tick();
+
+      if( !setup_factorization() )
+      {
+        throw Hermes::Exceptions::LinearMatrixSolverException("LU factorization could not be completed.");
+      }
+
+      // Specify the block of right-hand sides (will be replaced by the solutions).
+      param.nrhs = nrhs;
+      param.lrhs = m->size;
+      param.rhs = new typename mumps_type<Scalar>::mumps_Scalar[m->size * nrhs];
+      memcpy(param.rhs, rhs_block, m->size * nrhs * sizeof(Scalar));
+
+      // Do the jobs specified in setup_factorization().
+      mumps_c(&param);
+
+      ret = check_status();
+
+      if(ret)
+      {
+        delete [] this->sln;
+        this->sln = new Scalar[m->size * nrhs];
+        for (unsigned int i = 0; i < m->size * nrhs; i++)
+          this->sln[i] = mumps_to_Scalar(param.rhs[i]);
+      }
+
+      this->tick();
+      this->time = this->accumulated();
+
+      delete [] param.rhs;
+      param.rhs = NULL;
+      param.nrhs = 1;
+
+      return ret;
+    }
+
     template<typename Scalar>
     bool MumpsSolver<Scalar>::setup_factorization()
     {
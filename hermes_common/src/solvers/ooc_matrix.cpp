@@ -0,0 +1,437 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file ooc_matrix.cpp
+\brief Out-of-core sparse matrix storage.
+*/
+#include "config.h"
+#ifndef _WIN32
+#include "ooc_matrix.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    static int find_position(const int *Ai, int Alen, int idx)
+    {
+      assert(Ai != NULL);
+      assert(Alen > 0);
+      assert(idx >= 0);
+
+      register int lo = 0, hi = Alen - 1, mid;
+
+      while (true)
+      {
+        mid = (lo + hi) >> 1;
+
+        if(idx < Ai[mid]) hi = mid - 1;
+        else if(idx > Ai[mid]) lo = mid + 1;
+        else break;
+
+        // Sparse matrix entry not found (raise an error when trying to add
+        // value to this position, return 0 when obtaining value there).
+        if(lo > hi)
+        {
+          mid = -1;
+          break;
+        }
+      }
+      return mid;
+    }
+
+    template<typename Scalar>
+    OOCMatrix<Scalar>::OOCMatrix()
+    {
+      this->size = 0;
+      nnz = 0;
+      Ap = NULL;
+      fd = -1;
+      index_region_size = 0;
+      max_resident = 1;
+      storage_path = ".";
+      panel_size = 64u * 1024u * 1024u;
+      memory_budget = 256u * 1024u * 1024u;
+    }
+
+    template<typename Scalar>
+    OOCMatrix<Scalar>::~OOCMatrix()
+    {
+      free();
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::set_storage_path(const char* path)
+    {
+      this->storage_path = path;
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::set_panel_size(size_t bytes)
+    {
+      if(bytes == 0)
+        throw Hermes::Exceptions::ValueException("panel size", 0.0, 1.0);
+      this->panel_size = bytes;
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::set_memory_budget(size_t bytes)
+    {
+      if(bytes == 0)
+        throw Hermes::Exceptions::ValueException("memory budget", 0.0, 1.0);
+      this->memory_budget = bytes;
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::alloc()
+    {
+      assert(this->pages != NULL);
+
+      free();
+
+      // Create the backing file and unlink it right away - the descriptor
+      // keeps it alive, and it cannot be left behind by a crash.
+      std::string file_template = storage_path + "/hermes_ooc_XXXXXX";
+      char* file_name = new char[file_template.length() + 1];
+      strcpy(file_name, file_template.c_str());
+      fd = mkstemp(file_name);
+      if(fd < 0)
+      {
+        delete [] file_name;
+        throw Hermes::Exceptions::Exception("OOCMatrix: could not create a backing file in \"%s\".", storage_path.c_str());
+      }
+      unlink(file_name);
+      delete [] file_name;
+
+      // Build the column pointers and stream the sorted row indices of each
+      // column straight into the file, so that no nnz-sized array is ever
+      // held in memory.
+      Ap = new int[this->size + 1];
+      int aisize = this->get_num_indices();
+      int* column_buffer = new int[this->size];
+
+      unsigned int i;
+      int pos = 0;
+      for (i = 0; i < this->size; i++)
+      {
+        Ap[i] = pos;
+        int count = this->sort_and_store_indices(this->pages[i], column_buffer, column_buffer + this->size);
+        if(pos + count > aisize)
+          throw Hermes::Exceptions::Exception("OOCMatrix: internal error, index count mismatch.");
+        if(pwrite(fd, column_buffer, count * sizeof(int), (off_t)pos * sizeof(int)) != (ssize_t)(count * sizeof(int)))
+          throw Hermes::Exceptions::Exception("OOCMatrix: writing the backing file failed, is there enough space in \"%s\"?", storage_path.c_str());
+        pos += count;
+      }
+      Ap[i] = pos;
+      delete [] column_buffer;
+
+      delete [] this->pages;
+      this->pages = NULL;
+
+      nnz = Ap[this->size];
+      index_region_size = (size_t)nnz * sizeof(int);
+
+      // The value region is a hole in the sparse file; the kernel serves it
+      // zero-filled, which doubles as the initial zeroing of the matrix.
+      if(ftruncate(fd, index_region_size + (size_t)nnz * sizeof(Scalar)) != 0)
+        throw Hermes::Exceptions::Exception("OOCMatrix: sizing the backing file failed, is there enough space in \"%s\"?", storage_path.c_str());
+
+      // Split the columns into panels of roughly panel_size bytes.
+      const size_t entry_bytes = sizeof(int) + sizeof(Scalar);
+      panel_of_col.resize(this->size);
+      unsigned int col = 0;
+      while (col < this->size)
+      {
+        Panel panel;
+        panel.col_begin = col;
+        size_t bytes = 0;
+        while (col < this->size && (bytes == 0 || bytes + (Ap[col + 1] - Ap[col]) * entry_bytes <= panel_size))
+        {
+          bytes += (Ap[col + 1] - Ap[col]) * entry_bytes;
+          panel_of_col[col] = panels.size();
+          col++;
+        }
+        panel.col_end = col;
+        panel.entry_begin = Ap[panel.col_begin];
+        panel.entry_end = Ap[panel.col_end];
+        panel.resident = false;
+        panel.ai = NULL;
+        panel.ax = NULL;
+        panel.ai_base = NULL;
+        panel.ax_base = NULL;
+        panel.ai_length = 0;
+        panel.ax_length = 0;
+        panels.push_back(panel);
+      }
+
+      max_resident = (int)(memory_budget / panel_size);
+      if(max_resident < 1)
+        max_resident = 1;
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::free()
+    {
+      for (unsigned int i = 0; i < panels.size(); i++)
+        if(panels[i].resident)
+          evict(i);
+      panels.clear();
+      panel_of_col.clear();
+      lru.clear();
+      nnz = 0;
+      index_region_size = 0;
+      if(Ap != NULL)
+      {
+        delete [] Ap;
+        Ap = NULL;
+      }
+      if(fd >= 0)
+      {
+        close(fd);
+        fd = -1;
+      }
+    }
+
+    /// Maps a region of the backing file, aligning the offset down to a page
+    /// boundary as mmap requires.
+    static void* map_region(int fd, size_t offset, size_t bytes, void*& base, size_t& length)
+    {
+      size_t page = (size_t)sysconf(_SC_PAGESIZE);
+      size_t aligned = offset & ~(page - 1);
+      size_t shift = offset - aligned;
+      length = bytes + shift;
+      base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)aligned);
+      if(base == MAP_FAILED)
+      {
+        base = NULL;
+        throw Hermes::Exceptions::Exception("OOCMatrix: mapping a panel of the backing file failed.");
+      }
+      return (char*)base + shift;
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::touch(int panel)
+    {
+      Panel& p = panels[panel];
+      if(p.resident)
+      {
+        if(lru.front() != panel)
+        {
+          lru.remove(panel);
+          lru.push_front(panel);
+        }
+        return;
+      }
+
+      size_t entries = p.entry_end - p.entry_begin;
+      if(entries > 0)
+      {
+        p.ai = (int*)map_region(fd, (size_t)p.entry_begin * sizeof(int), entries * sizeof(int), p.ai_base, p.ai_length);
+        p.ax = (Scalar*)map_region(fd, index_region_size + (size_t)p.entry_begin * sizeof(Scalar), entries * sizeof(Scalar), p.ax_base, p.ax_length);
+      }
+      p.resident = true;
+      lru.push_front(panel);
+
+      while ((int)lru.size() > max_resident)
+      {
+        evict(lru.back());
+        lru.pop_back();
+      }
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::evict(int panel)
+    {
+      Panel& p = panels[panel];
+      if(p.ai_base != NULL)
+        munmap(p.ai_base, p.ai_length);
+      if(p.ax_base != NULL)
+        munmap(p.ax_base, p.ax_length);
+      p.ai = NULL;
+      p.ax = NULL;
+      p.ai_base = NULL;
+      p.ax_base = NULL;
+      p.ai_length = 0;
+      p.ax_length = 0;
+      p.resident = false;
+    }
+
+    template<typename Scalar>
+    Scalar OOCMatrix<Scalar>::get(unsigned int m, unsigned int n)
+    {
+      Scalar result = 0.0;
+      #pragma omp critical (OOCMatrix_add)
+      {
+        Panel& p = panels[panel_of_col[n]];
+        touch(panel_of_col[n]);
+
+        if(Ap[n + 1] > Ap[n])
+        {
+          int mid = find_position(p.ai + (Ap[n] - p.entry_begin), Ap[n + 1] - Ap[n], m);
+          if(mid >= 0)
+            result = p.ax[Ap[n] - p.entry_begin + mid];
+        }
+      }
+      return result;
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::zero()
+    {
+      for (unsigned int i = 0; i < panels.size(); i++)
+      {
+        touch(i);
+        Panel& p = panels[i];
+        if(p.entry_end > p.entry_begin)
+          memset(p.ax, 0, (size_t)(p.entry_end - p.entry_begin) * sizeof(Scalar));
+      }
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar v)
+    {
+      if(v != 0.0)   // ignore zero values.
+      {
+        // The panel of the touched column has to be resident and must not be
+        // evicted under our hands, hence the whole update is serialized.
+        #pragma omp critical (OOCMatrix_add)
+        {
+          Panel& p = panels[panel_of_col[n]];
+          touch(panel_of_col[n]);
+
+          int pos = find_position(p.ai + (Ap[n] - p.entry_begin), Ap[n + 1] - Ap[n], m);
+          if(pos < 0)
+            throw Hermes::Exceptions::Exception("Sparse matrix entry not found");
+          p.ax[Ap[n] - p.entry_begin + pos] += v;
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::add_to_diagonal(Scalar v)
+    {
+      for (unsigned int i = 0; i < this->size; i++)
+        add(i, i, v);
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
+    {
+      for (unsigned int i = 0; i < m; i++)       // rows
+        for (unsigned int j = 0; j < n; j++)     // cols
+          if(rows[i] >= 0 && cols[j] >= 0)       // not Dir. dofs.
+            add(rows[i], cols[j], mat[i][j]);
+    }
+
+    template<typename Scalar>
+    bool OOCMatrix<Scalar>::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt, char* number_format)
+    {
+      switch (fmt)
+      {
+      case DF_MATLAB_SPARSE:
+        fprintf(file, "%% Size: %dx%d\n%% Nonzeros: %d\ntemp = zeros(%d, 3);\ntemp =[\n",
+          this->size, this->size, nnz, nnz);
+        for (unsigned int k = 0; k < panels.size(); k++)
+        {
+          touch(k);
+          Panel& p = panels[k];
+          for (int j = p.col_begin; j < p.col_end; j++)
+            for (int i = Ap[j]; i < Ap[j + 1]; i++)
+            {
+              fprintf(file, "%d %d ", p.ai[i - p.entry_begin] + 1, j + 1);
+              Hermes::Helpers::fprint_num(file, p.ax[i - p.entry_begin], number_format);
+              fprintf(file, "\n");
+            }
+        }
+        fprintf(file, "];\n%s = spconvert(temp);\n", var_name);
+
+        return true;
+
+      default:
+        return false;
+      }
+    }
+
+    template<typename Scalar>
+    unsigned int OOCMatrix<Scalar>::get_matrix_size() const
+    {
+      return this->size;
+    }
+
+    template<typename Scalar>
+    unsigned int OOCMatrix<Scalar>::get_nnz() const
+    {
+      return nnz;
+    }
+
+    template<typename Scalar>
+    double OOCMatrix<Scalar>::get_fill_in() const
+    {
+      return nnz / (double) (this->size * this->size);
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar* vector_out)
+    {
+      for (unsigned int i = 0; i < this->size; i++)
+        vector_out[i] = Scalar(0.);
+      for (unsigned int k = 0; k < panels.size(); k++)
+      {
+        touch(k);
+        Panel& p = panels[k];
+        for (int j = p.col_begin; j < p.col_end; j++)
+          for (int i = Ap[j]; i < Ap[j + 1]; i++)
+            vector_out[p.ai[i - p.entry_begin]] += vector_in[j] * p.ax[i - p.entry_begin];
+      }
+    }
+
+    template<typename Scalar>
+    int OOCMatrix<Scalar>::get_num_panels() const
+    {
+      return panels.size();
+    }
+
+    template<typename Scalar>
+    void OOCMatrix<Scalar>::map_panel(int panel, int& col_begin, int& col_end, const int*& ai, const Scalar*& ax)
+    {
+      if(panel < 0 || panel >= (int)panels.size())
+        throw Hermes::Exceptions::ValueException("panel", panel, 0, panels.size() - 1);
+      touch(panel);
+      Panel& p = panels[panel];
+      col_begin = p.col_begin;
+      col_end = p.col_end;
+      ai = p.ai;
+      ax = p.ax;
+    }
+
+    template<typename Scalar>
+    int *OOCMatrix<Scalar>::get_Ap()
+    {
+      return Ap;
+    }
+
+    template class HERMES_API OOCMatrix<double>;
+    template class HERMES_API OOCMatrix<std::complex<double> >;
+  }
+}
+#endif
@@ -468,7 +468,7 @@ namespace Hermes
   {
     template<typename Scalar>
     PetscLinearMatrixSolver<Scalar>::PetscLinearMatrixSolver(PetscMatrix<Scalar> *mat, PetscVector<Scalar> *rhs)
-      : DirectSolver<Scalar>(), m(mat), rhs(rhs)
+      : DirectSolver<Scalar>(), m(mat), rhs(rhs), ksp_inited(false)
     {
       add_petsc_object();
     }
@@ -476,6 +476,8 @@ namespace Hermes
     template<typename Scalar>
     PetscLinearMatrixSolver<Scalar>::~PetscLinearMatrixSolver()
     {
+      if(ksp_inited)
+        KSPDestroy(ksp);
       remove_petsc_object();
     }
 
@@ -492,14 +494,33 @@ namespace Hermes
       assert(rhs != NULL);
 
       PetscErrorCode ec;
-      KSP ksp;
       Vec x;
 
       this->tick();
 
-      KSPCreate(PETSC_COMM_WORLD, &ksp);
+      if(!ksp_inited)
+      {
+        KSPCreate(PETSC_COMM_WORLD, &ksp);
+        ksp_inited = true;
+      }
+
+      // Translate the factorization scheme into the amount of preconditioner setup
+      // PETSc may skip for the updated operator.
+      MatStructure mat_structure;
+      switch(this->factorization_scheme)
+      {
+      case HERMES_REUSE_MATRIX_REORDERING:
+      case HERMES_REUSE_MATRIX_REORDERING_AND_SCALING:
+        mat_structure = SAME_NONZERO_PATTERN;
+        break;
+      case HERMES_REUSE_FACTORIZATION_COMPLETELY:
+        mat_structure = SAME_PRECONDITIONER;
+        break;
+      default:
+        mat_structure = DIFFERENT_NONZERO_PATTERN;
+      }
 
-      KSPSetOperators(ksp, m->matrix, m->matrix, DIFFERENT_NONZERO_PATTERN);
+      KSPSetOperators(ksp, m->matrix, m->matrix, mat_structure);
       KSPSetFromOptions(ksp);
       VecDuplicate(rhs->vec, &x);
 
@@ -522,7 +543,6 @@ namespace Hermes
       vec_get_value(x, m->size, idx, this->sln);
       delete [] idx;
 
-      KSPDestroy(ksp);
       VecDestroy(x);
 
       return true;
@@ -18,6 +18,7 @@
 #include "config.h"
 #ifdef HAVE_IFPACK
 #include "precond_ifpack.h"
+#include "instrumentation.h"
 #include "Ifpack_PointRelaxation.h"
 #include "Ifpack_BlockRelaxation.h"
 #include "Ifpack_DenseContainer.h"
@@ -41,6 +42,10 @@ namespace Hermes
 
       this->cls = cls;
       this->type = type;
+
+      this->reuse_pattern = false;
+      this->reuse_factors = false;
+      this->factors_stale = true;
     }
 
     template<typename Scalar>
@@ -53,6 +58,10 @@ namespace Hermes
       this->cls = cls;
       this->type = type;
       this->overlap = overlap;
+
+      this->reuse_pattern = false;
+      this->reuse_factors = false;
+      this->factors_stale = true;
     }
 
     template<typename Scalar>
@@ -61,6 +70,10 @@ namespace Hermes
       this->prec = ipc;
       this->owner = false;
       this->mat = NULL;    // FIXME: take the matrix from ipc
+
+      this->reuse_pattern = false;
+      this->reuse_factors = false;
+      this->factors_stale = true;
     }
 
     template<typename Scalar>
@@ -87,12 +100,50 @@ namespace Hermes
       ilist.set(name, value);
     }
 
+    template<typename Scalar>
+    void IfpackPrecond<Scalar>::set_reuse_pattern(bool to_set)
+    {
+      this->reuse_pattern = to_set;
+    }
+
+    template<typename Scalar>
+    void IfpackPrecond<Scalar>::set_reuse_factors(bool to_set)
+    {
+      this->reuse_factors = to_set;
+    }
+
+    template<typename Scalar>
+    void IfpackPrecond<Scalar>::mark_factors_stale()
+    {
+      this->factors_stale = true;
+    }
+
     template<typename Scalar>
     void IfpackPrecond<Scalar>::create(Matrix<Scalar> *m)
     {
       EpetraMatrix<Scalar> *mt = static_cast<EpetraMatrix<Scalar> *>(m);
       assert(mt != NULL);
+
+      // With pattern reuse on, a value update of the same matrix keeps the IFPACK
+      // object - the symbolic setup made by Initialize() stays valid, only the
+      // numeric factors become stale.
+      if(reuse_pattern && prec != NULL && mat == mt)
+      {
+        // With factor reuse also on, the factors stay valid until the owning solver
+        // marks them stale; otherwise a value update means recomputing them.
+        if(!reuse_factors)
+          factors_stale = true;
+        return;
+      }
+
+      if(owner && prec != NULL)
+      {
+        delete prec;
+        prec = NULL;
+      }
+
       mat = mt;
+      factors_stale = true;
       if(strcmp(cls, "point-relax") == 0)
       {
         create_point_relax(mat, type);
@@ -172,7 +223,13 @@ namespace Hermes
     void IfpackPrecond<Scalar>::compute()
     {
       assert(prec != NULL);
+      if(reuse_factors && !factors_stale && prec->IsComputed())
+      {
+        HERMES_PROFILE_INCREMENT(factorization_reuses);
+        return;
+      }
       prec->Compute();
+      factors_stale = false;
     }
 
     template<typename Scalar>
@@ -0,0 +1,212 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+/*! \file segregated_solver.cpp
+\brief Block Gauss-Seidel driver for coupled multi-space systems.
+*/
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "segregated_solver.h"
+
+using namespace Hermes::Algebra;
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    template<typename Scalar>
+    SegregatedSolver<Scalar>::SegregatedSolver(CSCMatrix<Scalar>* matrix, Vector<Scalar>* rhs,
+      Hermes::vector<int> block_sizes)
+      : matrix(matrix), rhs(rhs), block_sizes(block_sizes)
+    {
+      if(matrix == NULL)
+        throw Hermes::Exceptions::NullException(1);
+      if(rhs == NULL)
+        throw Hermes::Exceptions::NullException(2);
+      if(block_sizes.size() < 2)
+        throw Hermes::Exceptions::Exception("SegregatedSolver needs at least two blocks.");
+
+      sln = new Scalar[matrix->get_matrix_size()];
+      tolerance = 1e-8;
+      max_sweeps = 100;
+      num_sweeps = 0;
+    }
+
+    template<typename Scalar>
+    SegregatedSolver<Scalar>::~SegregatedSolver()
+    {
+      for (unsigned int b = 0; b < block_solvers.size(); b++)
+        delete block_solvers[b];
+      for (unsigned int b = 0; b < block_matrices.size(); b++)
+        delete block_matrices[b];
+      for (unsigned int b = 0; b < block_rhs.size(); b++)
+        delete block_rhs[b];
+      delete [] sln;
+    }
+
+    template<typename Scalar>
+    void SegregatedSolver<Scalar>::init_blocks()
+    {
+      int offset = 0;
+      for (unsigned int b = 0; b < block_sizes.size(); b++)
+      {
+        block_offsets.push_back(offset);
+        offset += block_sizes[b];
+      }
+      if(offset != (int) matrix->get_matrix_size())
+        throw Hermes::Exceptions::Exception("Block sizes sum up to %d, the matrix size is %d.",
+          offset, matrix->get_matrix_size());
+
+      int* Ap = matrix->get_Ap();
+      int* Ai = matrix->get_Ai();
+      Scalar* Ax = matrix->get_Ax();
+
+      for (unsigned int b = 0; b < block_sizes.size(); b++)
+      {
+        int off = block_offsets[b];
+        int nb = block_sizes[b];
+
+        // Extract the diagonal block. The block matrix and vector come from
+        // the generic factories, so the solver backend stays a runtime choice
+        // exactly as for the monolithic solve.
+        SparseMatrix<Scalar>* m = create_matrix<Scalar>();
+        m->prealloc(nb);
+        for (int j = off; j < off + nb; j++)
+          for (int k = Ap[j]; k < Ap[j + 1]; k++)
+            if(Ai[k] >= off && Ai[k] < off + nb)
+              m->pre_add_ij(Ai[k] - off, j - off);
+        m->alloc();
+        for (int j = off; j < off + nb; j++)
+          for (int k = Ap[j]; k < Ap[j + 1]; k++)
+            if(Ai[k] >= off && Ai[k] < off + nb)
+              m->add(Ai[k] - off, j - off, Ax[k]);
+
+        Vector<Scalar>* v = create_vector<Scalar>();
+        v->alloc(nb);
+
+        LinearMatrixSolver<Scalar>* solver = create_linear_solver<Scalar>(m, v);
+        // The block values never change during the sweeps - factorize once,
+        // back-substitute from then on.
+        solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+
+        block_matrices.push_back(m);
+        block_rhs.push_back(v);
+        block_solvers.push_back(solver);
+      }
+    }
+
+    template<typename Scalar>
+    bool SegregatedSolver<Scalar>::solve()
+    {
+      this->tick();
+
+      if(block_solvers.empty())
+        init_blocks();
+
+      int n = matrix->get_matrix_size();
+      memset(sln, 0, n * sizeof(Scalar));
+
+      double rhs_norm = 0.0;
+      for (int i = 0; i < n; i++)
+        rhs_norm += sqr(std::abs(rhs->get(i)));
+      rhs_norm = sqrt(rhs_norm);
+      if(rhs_norm == 0.0)
+      {
+        // Zero right-hand side, the zero vector solves the system.
+        num_sweeps = 0;
+        this->tick();
+        return true;
+      }
+
+      Scalar* residual = new Scalar[n];
+      bool converged = false;
+
+      for (num_sweeps = 1; num_sweeps <= max_sweeps; num_sweeps++)
+      {
+        // One Gauss-Seidel sweep: every block is corrected against the
+        // residual of the current iterate, updated blocks included.
+        for (unsigned int b = 0; b < block_solvers.size(); b++)
+        {
+          int off = block_offsets[b];
+          int nb = block_sizes[b];
+
+          matrix->multiply_with_vector(sln, residual);
+          for (int i = 0; i < nb; i++)
+            block_rhs[b]->set(i, rhs->get(off + i) - residual[off + i]);
+
+          if(!block_solvers[b]->solve())
+          {
+            delete [] residual;
+            throw Hermes::Exceptions::Exception("The solver of diagonal block %d failed.", b);
+          }
+
+          Scalar* correction = block_solvers[b]->get_sln_vector();
+          for (int i = 0; i < nb; i++)
+            sln[off + i] += correction[i];
+        }
+
+        matrix->multiply_with_vector(sln, residual);
+        double residual_norm = 0.0;
+        for (int i = 0; i < n; i++)
+          residual_norm += sqr(std::abs(rhs->get(i) - residual[i]));
+        residual_norm = sqrt(residual_norm);
+
+        if(residual_norm <= tolerance * rhs_norm)
+        {
+          converged = true;
+          break;
+        }
+      }
+
+      if(num_sweeps > max_sweeps)
+        num_sweeps = max_sweeps;
+
+      delete [] residual;
+      this->tick();
+      return converged;
+    }
+
+    template<typename Scalar>
+    Scalar* SegregatedSolver<Scalar>::get_sln_vector()
+    {
+      return sln;
+    }
+
+    template<typename Scalar>
+    int SegregatedSolver<Scalar>::get_num_sweeps() const
+    {
+      return num_sweeps;
+    }
+
+    template<typename Scalar>
+    void SegregatedSolver<Scalar>::set_tolerance(double tolerance)
+    {
+      this->tolerance = tolerance;
+    }
+
+    template<typename Scalar>
+    void SegregatedSolver<Scalar>::set_max_sweeps(int max_sweeps)
+    {
+      this->max_sweeps = max_sweeps;
+    }
+
+    template class HERMES_API SegregatedSolver<double>;
+    template class HERMES_API SegregatedSolver<std::complex<double> >;
+  }
+}
+#endif
@@ -27,63 +27,9 @@
 
 namespace Hermes
 {
-  namespace Solvers
-  {
-#ifdef SLU_MT
-    template <>
-    void SuperLu<double>::sequ(SuperMatrix *A, double *r, double *c, double *rowcnd, double *colcnd, double *amax, int *info)
-    {
-      dsequ (A, r, c, rowcnd, colcnd, amax, info);
-    }
-
-    template <>
-    void SuperLu<double>::laqgs (SuperMatrix *A, float *r, float *c, float rowcnd, float colcnd, float amax, char *equed)
-    {
-      dlaqgs (A, r, c, rowcnd, colcnd, amax, equed);
-    }
-
-    template <>
-    int SuperLu<double>::gstrf (superlu_options_t *options, int m, int n, double anorm, LUstruct_t *LUstruct, gridinfo_t *grid, SuperLUStat_t *stat, int *info)
-    {
-      return dgstrf (options, m, n, anorm, LUstruct, grid, stat, info);
-    }
-
-    template <>
-    float SuperLu<double>::pivotGrowth (int ncols, SuperMatrix *A, int *perm_c, SuperMatrix *L, SuperMatrix *U)
-    {
-      return dPivotGrowth (ncols, A, perm_c, L, U);
-    }
-
-    template <>
-    float SuperLu<double>::langs (char *norm, SuperMatrix *A)
-    {
-      return dlangs (norm, A);
-    }
-    template <>
-    void  SuperLu<double>::gscon (char *norm, SuperMatrix *L, SuperMatrix *U, float anorm, float *rcond, SuperLUStat_t *stat, int *info)
-    {
-      dgscon (norm, L, U, anorm, rcond, stat, info);
-    }
-
-    template <>
-    void  SuperLu<double>::gstrs (trans_t trans, SuperMatrix *L, SuperMatrix *U, int *perm_c, int *perm_r, SuperMatrix *B, SuperLUStat_t *stat, int *info)
-    {
-      dgstrs (trans, L, U, perm_c, perm_r, B, stat, info);
-    }
-
-    template <>
-    double SuperLu<double>::lamch_ (char *cmach)
-    {
-      return dlamch_ (cmach);
-    }
-
-    template <>
-    int SuperLu<double>::querySpace (SuperMatrix *a, SuperMatrix *b, mem_usage_t *mu)
-    {
-      return dquerySpace (a, b, mu);
-    }
-#endif
-  }
+  // The specializations of the SuperLu<Scalar> routine dispatch for the
+  // multithreaded library live in superlu_solver_real.cpp / superlu_solver_cplx.cpp
+  // next to the sequential ones.
   namespace Algebra
   {
     /// Binary search for the location of a particular CSC/CSR matrix entry.
@@ -528,6 +474,20 @@ namespace Hermes
   }
   namespace Solvers
   {
+#ifdef SLU_MT
+    // Defined at the end of this file.
+    template <typename Scalar>
+    void slu_mt_solver_driver(slu_options_t *options, SuperMatrix *A,
+      int *perm_c, int *perm_r, SuperMatrix *AC,
+      equed_t *equed, double *R, double *C,
+      SuperMatrix *L, SuperMatrix *U,
+      SuperMatrix *B, SuperMatrix *X,
+      double *recip_pivot_growth, double *rcond,
+      double *ferr, double *berr,
+      slu_stat_t *stat, slu_memusage_t *memusage,
+      int *info);
+#endif
+
     template<typename Scalar>
     bool SuperLUSolver<Scalar>::check_status(unsigned int info)
     {
@@ -571,15 +531,27 @@ namespace Hermes
       *equed = '\0';
 #endif
 
+      use_equilibration = true;
+      pivot_threshold = 1.0;
+      column_ordering = -1;
+
       // Set the default input options:
 #ifdef SLU_MT
-      // I am not sure if this will work well on Windows:
+      // The thread count comes from the API; when it is left at the default,
+      // fall back to the OMP_NUM_THREADS environment variable.
+      // I am not sure if the latter will work well on Windows:
       // http://stackoverflow.com/questions/631664/accessing-environment-variables-in-c
-      char *nt_var = getenv("OMP_NUM_THREADS");
-      if(nt_var)
-        options.nprocs          = std::max(1, atoi(nt_var));
+      int nt = HermesCommonApi.get_integral_param_value(Hermes::numSolverThreads);
+      if(nt > 0)
+        options.nprocs          = nt;
       else
-        options.nprocs          = 1;
+      {
+        char *nt_var = getenv("OMP_NUM_THREADS");
+        if(nt_var)
+          options.nprocs        = std::max(1, atoi(nt_var));
+        else
+          options.nprocs        = 1;
+      }
 
       options.fact              = EQUILIBRATE;  // Rescale the matrix if neccessary.
       options.trans             = NOTRANS;      // Not solving the transposed problem.
@@ -645,6 +617,40 @@ namespace Hermes
       return m->size;
     }
 
+    template<typename Scalar>
+    void SuperLUSolver<Scalar>::retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      if(matrix == NULL)
+        throw Exceptions::NullException(1);
+      free_matrix();
+      free_rhs();
+      this->m = static_cast<SuperLUMatrix<Scalar>*>(matrix);
+      this->rhs = static_cast<SuperLUVector<Scalar>*>(rhs);
+      A_changed = true;
+    }
+
+    template<typename Scalar>
+    void SuperLUSolver<Scalar>::set_equilibration(bool to_set)
+    {
+      use_equilibration = to_set;
+    }
+
+    template<typename Scalar>
+    void SuperLUSolver<Scalar>::set_pivot_threshold(double threshold)
+    {
+      if(threshold < 0.0 || threshold > 1.0)
+        throw Hermes::Exceptions::ValueException("threshold", threshold, 0.0, 1.0);
+      pivot_threshold = threshold;
+    }
+
+    template<typename Scalar>
+    void SuperLUSolver<Scalar>::set_column_ordering(int ordering)
+    {
+      if(ordering < 0 || ordering > 3)
+        throw Hermes::Exceptions::ValueException("ordering", (double)ordering, 0.0, 3.0);
+      column_ordering = ordering;
+    }
+
     template<typename Scalar>
     bool SuperLUSolver<Scalar>::solve()
     {
@@ -744,7 +750,7 @@ namespace Hermes
         //  1: minimum degree ordering on structure of A'*A
         //  2: minimum degree ordering on structure of A' + A
         //  3: approximate minimum degree for unsymmetric matrices
-        get_perm_c(1, &A, perm_c);
+        get_perm_c(column_ordering >= 0 ? column_ordering : 1, &A, perm_c);
       }
 
       /*
@@ -752,7 +758,7 @@ namespace Hermes
       // perform iterative refinement of the solution and estimate forward and backward error.
       // Memory usage will be acquired at the end. If A is singular, info will be set to A->ncol + 1.
       //
-      slu_mt_solver_driver( &options, &A, perm_c, perm_r, &AC, &equed, R, C,
+      slu_mt_solver_driver<Scalar>( &options, &A, perm_c, perm_r, &AC, &equed, R, C,
       &L, &U, &B, &X, &rpivot_growth, &rcond, &ferr, &berr,
       &stat, &memusage, &info );
       */
@@ -762,7 +768,7 @@ namespace Hermes
       // Estimate reciprocal condition number of A and solve the system. If A is singular, info
       // will be set to A->ncol + 1.
       //
-      slu_mt_solver_driver( &options, &A, perm_c, perm_r, &AC, &equed, R, C,
+      slu_mt_solver_driver<Scalar>( &options, &A, perm_c, perm_r, &AC, &equed, R, C,
         &L, &U, &B, &X, NULL, &rcond, NULL, NULL,
         &stat, NULL, &info );
 
@@ -771,7 +777,7 @@ namespace Hermes
       /*
       // Do not check the regularity of A and just solve the system.
       //
-      slu_mt_solver_driver( &options, &A, perm_c, perm_r, &AC, &equed, R, C,
+      slu_mt_solver_driver<Scalar>( &options, &A, perm_c, perm_r, &AC, &equed, R, C,
       &L, &U, &B, &X, NULL, NULL, NULL, NULL,
       &stat, NULL, &info );
       */
@@ -819,6 +825,46 @@ namespace Hermes
       return factorized;
     }
 
+    template<typename Scalar>
+    bool SuperLUSolver<Scalar>::solve(Scalar* rhs_block, int nrhs)
+    {
+      assert(m != NULL);
+      assert(rhs_block != NULL);
+
+      // The columns are solved through solve(); after the first one the factorization
+      // is reused completely, whatever the user-selected scheme is. Both the scheme
+      // and the contents of the rhs vector are restored afterwards.
+      unsigned int factorization_scheme_backup = this->factorization_scheme;
+      Scalar* rhs_backup = new Scalar[m->size];
+      memcpy(rhs_backup, rhs->v, m->size * sizeof(Scalar));
+
+      Scalar* block_sln = new Scalar[m->size * nrhs];
+
+      for(int k = 0; k < nrhs; k++)
+      {
+        memcpy(rhs->v, rhs_block + k * m->size, m->size * sizeof(Scalar));
+        if(!solve())
+        {
+          memcpy(rhs->v, rhs_backup, m->size * sizeof(Scalar));
+          delete [] rhs_backup;
+          delete [] block_sln;
+          this->factorization_scheme = factorization_scheme_backup;
+          return false;
+        }
+        this->factorization_scheme = HERMES_REUSE_FACTORIZATION_COMPLETELY;
+        memcpy(block_sln + k * m->size, this->sln, m->size * sizeof(Scalar));
+      }
+
+      memcpy(rhs->v, rhs_backup, m->size * sizeof(Scalar));
+      delete [] rhs_backup;
+      this->factorization_scheme = factorization_scheme_backup;
+
+      delete [] this->sln;
+      this->sln = block_sln;
+
+      return true;
+    }
+
     template<typename Scalar>
     bool SuperLUSolver<Scalar>::setup_factorization()
     {
@@ -836,6 +882,17 @@ namespace Hermes
       else
         eff_fact_scheme = this->factorization_scheme;
 
+      // Apply the persistent user settings; the reuse scheme handling below
+      // only switches the factorization stage flags.
+#ifdef SLU_MT
+      options.diag_pivot_thresh = pivot_threshold;
+#else
+      options.Equil = use_equilibration ? YES : NO;
+      options.DiagPivotThresh = pivot_threshold;
+      if(column_ordering >= 0)
+        options.ColPerm = (colperm_t) column_ordering;
+#endif
+
       // Prepare factorization structures. In case of a particular reuse scheme, comments are given
       // to clarify which arguments will be reused and which will be reset by the dgssvx (zgssvx) routine.
       // It was determined empirically by running the dlinsolx2 example from SuperLU, setting options.Fact
@@ -867,7 +924,7 @@ namespace Hermes
           throw Hermes::Exceptions::Exception("SUPERLU_MALLOC fails for C[].");
 
 #ifdef SLU_MT
-        options.fact = EQUILIBRATE;
+        options.fact = use_equilibration ? EQUILIBRATE : DOFACT;
         options.refact = NO;
         options.perm_c = perm_c;
         options.perm_r = perm_r;
@@ -885,7 +942,7 @@ namespace Hermes
         // needed from previous:      etree, perm_c
         // not needed from previous:  perm_r, R, C, L, U, equed
 #ifdef SLU_MT
-        options.fact = EQUILIBRATE;
+        options.fact = use_equilibration ? EQUILIBRATE : DOFACT;
         options.refact = YES;
 #else
         options.Fact = SamePattern;
@@ -900,7 +957,7 @@ namespace Hermes
 #ifdef SLU_MT
         // MT version of SLU cannot reuse the equilibration factors (R, C), so
         // this is the same as the previous case.
-        options.fact = EQUILIBRATE;
+        options.fact = use_equilibration ? EQUILIBRATE : DOFACT;
         options.refact = YES;
 #else
         options.Fact = SamePattern_SameRowPerm;
@@ -992,6 +1049,7 @@ namespace Hermes
     //                          estimates of the computed solution;
     //  * memusage            - memory usage during the factorization/solution will not be queried.
     //
+    template <typename Scalar>
     void slu_mt_solver_driver(slu_options_t *options, SuperMatrix *A,
       int *perm_c, int *perm_r, SuperMatrix *AC,
       equed_t *equed, double *R, double *C,
@@ -23,12 +23,79 @@
 #ifdef WITH_SUPERLU
 #include "superlu_solver.h"
 #include "callstack.h"
+#ifdef SLU_MT
+#include <pzsp_defs.h>
+#else
 #include <slu_zdefs.h>
+#endif
 
 namespace Hermes
 {
   namespace Solvers
   {
+#ifdef SLU_MT
+    template <>
+    void SuperLu<std::complex<double> >::gsequ (SuperMatrix *A, double *r, double *c, double *rowcnd, double *colcnd, double *amax, int *info)
+    {
+      zgsequ (A, r, c, rowcnd, colcnd, amax, info);
+    }
+
+    template <>
+    void SuperLu<std::complex<double> >::laqgs (SuperMatrix *A, double *r, double *c, double rowcnd, double colcnd, double amax, equed_t *equed)
+    {
+      zlaqgs (A, r, c, rowcnd, colcnd, amax, equed);
+    }
+
+    template <>
+    void SuperLu<std::complex<double> >::gstrf (superlumt_options_t *options, SuperMatrix *AC, int *perm_r, SuperMatrix *L, SuperMatrix *U, Gstat_t *stat, int *info)
+    {
+      pzgstrf (options, AC, perm_r, L, U, stat, info);
+    }
+
+    template <>
+    double SuperLu<std::complex<double> >::pivot_growth (int ncols, SuperMatrix *A, int *perm_c, SuperMatrix *L, SuperMatrix *U)
+    {
+      return zPivotGrowth (ncols, A, perm_c, L, U);
+    }
+
+    template <>
+    double SuperLu<std::complex<double> >::langs (char *norm, SuperMatrix *A)
+    {
+      return zlangs (norm, A);
+    }
+
+    template <>
+    void SuperLu<std::complex<double> >::gscon (char *norm, SuperMatrix *L, SuperMatrix *U, double anorm, double *rcond, int *info)
+    {
+      zgscon (norm, L, U, anorm, rcond, info);
+    }
+
+    template <>
+    void SuperLu<std::complex<double> >::gstrs (trans_t trans, SuperMatrix *L, SuperMatrix *U, int *perm_r, int *perm_c, SuperMatrix *B, Gstat_t *stat, int *info)
+    {
+      zgstrs (trans, L, U, perm_r, perm_c, B, stat, info);
+    }
+
+    template <>
+    void SuperLu<std::complex<double> >::gsrfs (trans_t trans, SuperMatrix *A, SuperMatrix *L, SuperMatrix *U, int *perm_r, int *perm_c, equed_t equed,
+      double *R, double *C, SuperMatrix *B, SuperMatrix *X, double *ferr, double *berr, Gstat_t *stat, int *info)
+    {
+      zgsrfs (trans, A, L, U, perm_r, perm_c, equed, R, C, B, X, ferr, berr, stat, info);
+    }
+
+    template <>
+    double SuperLu<std::complex<double> >::lamch (char *cmach)
+    {
+      return dlamch_ (cmach);
+    }
+
+    template <>
+    int SuperLu<std::complex<double> >::query_space (int nprocs, SuperMatrix *L, SuperMatrix *U, int panel_size, superlu_memusage_t *memusage)
+    {
+      return superlu_zQuerySpace (nprocs, L, U, panel_size, memusage);
+    }
+#endif
+
     template <>
     void SuperLUSolver<std::complex<double> >::create_csc_matrix (SuperMatrix *A, int m, int n, int nnz,
       SuperLuType<std::complex<double> >::Scalar *nzval,
@@ -44,6 +111,7 @@ namespace Hermes
       zCreate_Dense_Matrix (X, m, n, (doublecomplex *) x, ldx, stype, dtype, mtype);
     }
 
+#ifndef SLU_MT
     template <>
     void  SuperLUSolver<std::complex<double> >::solver_driver (superlu_options_t *options, SuperMatrix *A, int *perm_c, int *perm_r, int *etree, char *equed, double *R,
       double *C, SuperMatrix *L, SuperMatrix *U, void *work, int lwork, SuperMatrix *B, SuperMatrix *X,
@@ -52,6 +120,7 @@ namespace Hermes
     {
       zgssvx(options, A, perm_c, perm_r, etree, equed, R, C, L, U, work, lwork, B, X, recip_pivot_growth, rcond, ferr, berr, (mem_usage_t*) mem_usage, stat, info);
     }
+#endif
   }
 }
 #endif
\ No newline at end of file
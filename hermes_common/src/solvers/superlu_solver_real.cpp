@@ -23,12 +23,78 @@
 #ifdef WITH_SUPERLU
 #include "superlu_solver.h"
 #include "callstack.h"
+#ifdef SLU_MT
+#include <pdsp_defs.h>
+#else
 #include <slu_ddefs.h>
+#endif
 
 namespace Hermes
 {
   namespace Solvers
   {
+#ifdef SLU_MT
+    template <>
+    void SuperLu<double>::gsequ (SuperMatrix *A, double *r, double *c, double *rowcnd, double *colcnd, double *amax, int *info)
+    {
+      dgsequ (A, r, c, rowcnd, colcnd, amax, info);
+    }
+
+    template <>
+    void SuperLu<double>::laqgs (SuperMatrix *A, double *r, double *c, double rowcnd, double colcnd, double amax, equed_t *equed)
+    {
+      dlaqgs (A, r, c, rowcnd, colcnd, amax, equed);
+    }
+
+    template <>
+    void SuperLu<double>::gstrf (superlumt_options_t *options, SuperMatrix *AC, int *perm_r, SuperMatrix *L, SuperMatrix *U, Gstat_t *stat, int *info)
+    {
+      pdgstrf (options, AC, perm_r, L, U, stat, info);
+    }
+
+    template <>
+    double SuperLu<double>::pivot_growth (int ncols, SuperMatrix *A, int *perm_c, SuperMatrix *L, SuperMatrix *U)
+    {
+      return dPivotGrowth (ncols, A, perm_c, L, U);
+    }
+
+    template <>
+    double SuperLu<double>::langs (char *norm, SuperMatrix *A)
+    {
+      return dlangs (norm, A);
+    }
+
+    template <>
+    void SuperLu<double>::gscon (char *norm, SuperMatrix *L, SuperMatrix *U, double anorm, double *rcond, int *info)
+    {
+      dgscon (norm, L, U, anorm, rcond, info);
+    }
+
+    template <>
+    void SuperLu<double>::gstrs (trans_t trans, SuperMatrix *L, SuperMatrix *U, int *perm_r, int *perm_c, SuperMatrix *B, Gstat_t *stat, int *info)
+    {
+      dgstrs (trans, L, U, perm_r, perm_c, B, stat, info);
+    }
+
+    template <>
+    void SuperLu<double>::gsrfs (trans_t trans, SuperMatrix *A, SuperMatrix *L, SuperMatrix *U, int *perm_r, int *perm_c, equed_t equed,
+      double *R, double *C, SuperMatrix *B, SuperMatrix *X, double *ferr, double *berr, Gstat_t *stat, int *info)
+    {
+      dgsrfs (trans, A, L, U, perm_r, perm_c, equed, R, C, B, X, ferr, berr, stat, info);
+    }
+
+    template <>
+    double SuperLu<double>::lamch (char *cmach)
+    {
+      return dlamch_ (cmach);
+    }
+
+    template <>
+    int SuperLu<double>::query_space (int nprocs, SuperMatrix *L, SuperMatrix *U, int panel_size, superlu_memusage_t *memusage)
+    {
+      return superlu_dQuerySpace (nprocs, L, U, panel_size, memusage);
+    }
+#else
     template <>
     void  SuperLUSolver<double>::solver_driver (superlu_options_t *options, SuperMatrix *A, int *perm_c, int *perm_r, int *etree, char *equed, double *R,
       double *C, SuperMatrix *L, SuperMatrix *U, void *work, int lwork, SuperMatrix *B, SuperMatrix *X,
@@ -37,6 +103,7 @@ namespace Hermes
     {
       dgssvx(options, A, perm_c, perm_r, etree, equed, R, C, L, U, work, lwork, B, X, recip_pivot_growth, rcond, ferr, berr, (mem_usage_t*) mem_usage, stat, info);
     }
+#endif
 
     template <>
     void SuperLUSolver<double>::create_csc_matrix (SuperMatrix *A, int m, int n, int nnz, SuperLuType<double>::Scalar *nzval,
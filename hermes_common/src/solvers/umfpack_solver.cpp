@@ -22,6 +22,7 @@
 #include "config.h"
 #ifdef WITH_UMFPACK
 #include "umfpack_solver.h"
+#include "instrumentation.h"
 
 extern "C"
 {
@@ -66,12 +67,26 @@ namespace Hermes
       Ap = NULL;
       Ai = NULL;
       Ax = NULL;
+      Cp = NULL;
+      Ci = NULL;
+      Cperm = NULL;
+      Ax_re = NULL;
+      Ax_im = NULL;
+      split_values_stale = true;
+      split_complex_storage = false;
     }
 
     template<typename Scalar>
     CSCMatrix<Scalar>::CSCMatrix(unsigned int size)
     {
       this->size = size;
+      Cp = NULL;
+      Ci = NULL;
+      Cperm = NULL;
+      Ax_re = NULL;
+      Ax_im = NULL;
+      split_values_stale = true;
+      split_complex_storage = false;
       this->alloc();
     }
 
@@ -81,17 +96,174 @@ namespace Hermes
       free();
     }
 
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::set_split_complex_storage(bool to_set)
+    {
+      if(to_set)
+        throw Hermes::Exceptions::Exception("Split-complex storage is only available for complex matrices.");
+    }
+
+    template<>
+    void CSCMatrix<std::complex<double> >::set_split_complex_storage(bool to_set)
+    {
+      this->split_complex_storage = to_set;
+      if(!to_set)
+        free_split_values();
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::free_split_values()
+    {
+      if(Ax_re != NULL)
+      {
+        delete [] Ax_re;
+        Ax_re = NULL;
+      }
+      if(Ax_im != NULL)
+      {
+        delete [] Ax_im;
+        Ax_im = NULL;
+      }
+      split_values_stale = true;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::build_split_values()
+    {
+      throw Hermes::Exceptions::Exception("Internal error: split storage of a real matrix.");
+    }
+
+    template<>
+    void CSCMatrix<std::complex<double> >::build_split_values()
+    {
+      if(Ax_re == NULL)
+      {
+        Ax_re = new double[nnz];
+        Ax_im = new double[nnz];
+      }
+      for (unsigned int i = 0; i < nnz; i++)
+      {
+        Ax_re[i] = Ax[i].real();
+        Ax_im[i] = Ax[i].imag();
+      }
+      split_values_stale = false;
+    }
+
     template<typename Scalar>
     void CSCMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar* vector_out)
     {
+      if(Cp == NULL)
+        build_csr_mirror();
+
       int n = this->size;
-      for (int j = 0; j<n; j++) vector_out[j] = 0;
-      for (int j = 0; j<n; j++)
+#pragma omp parallel for
+      for (int i = 0; i < n; i++)
+      {
+        Scalar sum = 0.0;
+        for (int pos = Cp[i]; pos < Cp[i + 1]; pos++)
+          sum += vector_in[Ci[pos]] * Ax[Cperm[pos]];
+        vector_out[i] = sum;
+      }
+    }
+
+    template<>
+    void CSCMatrix<std::complex<double> >::multiply_with_vector(std::complex<double>* vector_in, std::complex<double>* vector_out)
+    {
+      if(Cp == NULL)
+        build_csr_mirror();
+
+      int n = this->size;
+
+      if(split_complex_storage)
+      {
+        if(split_values_stale)
+          build_split_values();
+
+        // Split the input vector once, the row kernels then run on plain
+        // double arrays only.
+        double* x_re = new double[n];
+        double* x_im = new double[n];
+        for (int i = 0; i < n; i++)
+        {
+          x_re[i] = vector_in[i].real();
+          x_im[i] = vector_in[i].imag();
+        }
+
+#pragma omp parallel for
+        for (int i = 0; i < n; i++)
+        {
+          double sum_re = 0.0, sum_im = 0.0;
+          for (int pos = Cp[i]; pos < Cp[i + 1]; pos++)
+          {
+            int j = Ci[pos];
+            int p = Cperm[pos];
+            sum_re += Ax_re[p] * x_re[j] - Ax_im[p] * x_im[j];
+            sum_im += Ax_re[p] * x_im[j] + Ax_im[p] * x_re[j];
+          }
+          vector_out[i] = std::complex<double>(sum_re, sum_im);
+        }
+
+        delete [] x_re;
+        delete [] x_im;
+        return;
+      }
+
+#pragma omp parallel for
+      for (int i = 0; i < n; i++)
       {
-        for (int i = Ap[j]; i < Ap[j + 1]; i++)
+        std::complex<double> sum = 0.0;
+        for (int pos = Cp[i]; pos < Cp[i + 1]; pos++)
+          sum += vector_in[Ci[pos]] * Ax[Cperm[pos]];
+        vector_out[i] = sum;
+      }
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::build_csr_mirror()
+    {
+      free_csr_mirror();
+
+      Cp = new int[this->size + 1];
+      Ci = new int[nnz];
+      Cperm = new int[nnz];
+
+      // Count the entries in each row and turn the counts into row pointers.
+      memset(Cp, 0, (this->size + 1) * sizeof(int));
+      for (unsigned int pos = 0; pos < nnz; pos++)
+        Cp[Ai[pos] + 1]++;
+      for (unsigned int i = 0; i < this->size; i++)
+        Cp[i + 1] += Cp[i];
+
+      // Scatter the columns, next[] tracks the first unused slot of each row.
+      int* next = new int[this->size];
+      memcpy(next, Cp, this->size * sizeof(int));
+      for (unsigned int j = 0; j < this->size; j++)
+        for (int pos = Ap[j]; pos < Ap[j + 1]; pos++)
         {
-          vector_out[Ai[i]] += vector_in[j]*Ax[i];
+          int p = next[Ai[pos]]++;
+          Ci[p] = j;
+          Cperm[p] = pos;
         }
+      delete [] next;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::free_csr_mirror()
+    {
+      if(Cp != NULL)
+      {
+        delete [] Cp;
+        Cp = NULL;
+      }
+      if(Ci != NULL)
+      {
+        delete [] Ci;
+        Ci = NULL;
+      }
+      if(Cperm != NULL)
+      {
+        delete [] Cperm;
+        Cperm = NULL;
       }
     }
 
@@ -99,6 +271,7 @@ namespace Hermes
     void CSCMatrix<Scalar>::multiply_with_Scalar(Scalar value)
     {
       for (unsigned int i = 0; i < this->nnz; i++) Ax[i] *= value;
+      split_values_stale = true;
     }
 
     template<typename Scalar>
@@ -106,6 +279,11 @@ namespace Hermes
     {
       assert(this->pages != NULL);
 
+      HERMES_PROFILE_INCREMENT(pattern_rebuilds);
+
+      free_csr_mirror();
+      free_split_values();
+
       // initialize the arrays Ap and Ai
       Ap = new int[this->size + 1];
       int aisize = this->get_num_indices();
@@ -127,12 +305,16 @@ namespace Hermes
       nnz = Ap[this->size];
 
       Ax = new Scalar[nnz];
-      memset(Ax, 0, sizeof(Scalar) * nnz);
+      // First-touch the coefficient array in parallel, distributing its pages
+      // over the sockets the way the solver threads will access them.
+      zero_with_first_touch(Ax, nnz);
     }
 
     template<typename Scalar>
     void CSCMatrix<Scalar>::free()
     {
+      free_csr_mirror();
+      free_split_values();
       nnz = 0;
       if(Ap != NULL)
       {
@@ -166,7 +348,8 @@ namespace Hermes
     template<typename Scalar>
     void CSCMatrix<Scalar>::zero()
     {
-      memset(Ax, 0, sizeof(Scalar) * nnz);
+      zero_with_first_touch(Ax, nnz);
+      split_values_stale = true;
     }
 
     template<>
@@ -174,6 +357,7 @@ namespace Hermes
     {
       if(v != 0.0)   // ignore zero values.
       {
+        split_values_stale = true;
         // Find m-th row in the n-th column.
         int pos = find_position(Ai + Ap[n], Ap[n + 1] - Ap[n], m);
         // Make sure we are adding to an existing non-zero entry.
@@ -193,6 +377,7 @@ namespace Hermes
     {
       if(v != 0.0)   // ignore zero values.
       {
+        split_values_stale = true;
         // Find m-th row in the n-th column.
         int pos = find_position(Ai + Ap[n], Ap[n + 1] - Ap[n], m);
         // Make sure we are adding to an existing non-zero entry.
@@ -235,6 +420,7 @@ namespace Hermes
     template<typename Scalar>
     void CSCMatrix<Scalar>::add_as_block(unsigned int offset_i, unsigned int offset_j, CSCMatrix<Scalar>* mat)
     {
+      split_values_stale = true;
       UMFPackIterator<Scalar> mat_it(mat);
       UMFPackIterator<Scalar> this_it(this);
 
@@ -261,10 +447,82 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    int* CSCMatrix<Scalar>::precalculate_sparse_map(CSCMatrix<Scalar>* mat) const
+    {
+      assert(this->size == mat->get_size());
+
+      int* map = new int[mat->nnz];
+      for (unsigned int j = 0; j < this->size; j++)
+      {
+        int pos = Ap[j];
+        for (int mat_pos = mat->Ap[j]; mat_pos < mat->Ap[j + 1]; mat_pos++)
+        {
+          int row = mat->Ai[mat_pos];
+          // both columns are sorted by row index, so the scan through this
+          // column resumes where the previous entry left it
+          while (pos < Ap[j + 1] && Ai[pos] < row)
+            pos++;
+          if(pos == Ap[j + 1] || Ai[pos] != row)
+          {
+            delete [] map;
+            throw Hermes::Exceptions::Exception("Nonzero matrix entry at %d, %d not found in CSCMatrix<Scalar>::precalculate_sparse_map().", row, j);
+          }
+          map[mat_pos] = pos;
+        }
+      }
+      return map;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::add_matrix_at_map(CSCMatrix<Scalar>* mat, const int* map, Scalar factor)
+    {
+      split_values_stale = true;
+      if(map == NULL)
+      {
+        // identical patterns - one contiguous axpy over the value arrays
+        assert(this->nnz == mat->nnz);
+        for (unsigned int i = 0; i < this->nnz; i++)
+          Ax[i] += factor * mat->Ax[i];
+      }
+      else
+        for (unsigned int i = 0; i < mat->nnz; i++)
+          Ax[map[i]] += factor * mat->Ax[i];
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::combine(Scalar alpha, CSCMatrix<Scalar>* A, const int* map_A, Scalar beta, CSCMatrix<Scalar>* B, const int* map_B)
+    {
+      this->zero();
+      this->add_matrix_at_map(A, map_A, alpha);
+      this->add_matrix_at_map(B, map_B, beta);
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::add_sparse_matrix(SparseMatrix<Scalar>* mat)
+    {
+      CSCMatrix<Scalar>* csc_mat = dynamic_cast<CSCMatrix<Scalar>*>(mat);
+      if(csc_mat == NULL)
+        throw Hermes::Exceptions::Exception("Matrix type mismatch in CSCMatrix<Scalar>::add_sparse_matrix().");
+      this->add_matrix(csc_mat);
+    }
+
     template<typename Scalar>
     void CSCMatrix<Scalar>::add_matrix(CSCMatrix<Scalar>* mat)
     {
+      split_values_stale = true;
       assert(this->get_size() == mat->get_size());
+
+      // Identical sparsity structures - the common case for matrices duplicated from
+      // one another - reduce the merge to a single pass over the value arrays.
+      if(this->nnz == mat->nnz && memcmp(this->Ap, mat->Ap, (this->get_size() + 1) * sizeof(int)) == 0
+        && memcmp(this->Ai, mat->Ai, this->nnz * sizeof(int)) == 0)
+      {
+        for (unsigned int i = 0; i < this->nnz; i++)
+          this->Ax[i] += mat->Ax[i];
+        return;
+      }
+
       // Create iterators for both matrices.
       UMFPackIterator<Scalar> mat_it(mat);
       UMFPackIterator<Scalar> this_it(this);
@@ -309,13 +567,104 @@ namespace Hermes
       }
     };
 
+    static inline void add_entry(double* target, double v)
+    {
+#pragma omp atomic
+      *target += v;
+    }
+
+    static inline void add_entry(std::complex<double>* target, std::complex<double> v)
+    {
+#pragma omp critical
+      *target += v;
+    }
+
     template<typename Scalar>
     void CSCMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
+    {
+      split_values_stale = true;
+      // Sort the row dofs once per local matrix (insertion sort, the lists are
+      // short); every target column is then walked linearly in one pass instead
+      // of one binary search per entry.
+      int* order = new int[m];
+      int cnt = 0;
+      for (unsigned int i = 0; i < m; i++)
+      {
+        if(rows[i] < 0) // skip Dir. dofs.
+          continue;
+        int k = cnt++;
+        while(k > 0 && rows[order[k - 1]] > rows[i])
+        {
+          order[k] = order[k - 1];
+          k--;
+        }
+        order[k] = i;
+      }
+
+      for (unsigned int j = 0; j < n; j++)     // cols
+      {
+        if(cols[j] < 0) // skip Dir. dofs.
+          continue;
+
+        int* col_Ai = Ai + Ap[cols[j]];
+        Scalar* col_Ax = Ax + Ap[cols[j]];
+        int col_len = Ap[cols[j] + 1] - Ap[cols[j]];
+
+        int pos = 0;
+        for (int k = 0; k < cnt; k++)
+        {
+          Scalar v = mat[order[k]][j];
+          if(v == 0.0)   // ignore zero values.
+            continue;
+
+          int row = rows[order[k]];
+          while(pos < col_len && col_Ai[pos] < row)
+            pos++;
+          // Make sure we are adding to an existing non-zero entry.
+          if(pos >= col_len || col_Ai[pos] != row)
+          {
+            this->info("CSCMatrix<Scalar>::add(): i = %d, j = %d.", row, cols[j]);
+            throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", row, cols[j]);
+          }
+
+          add_entry(col_Ax + pos, v);
+        }
+      }
+
+      delete [] order;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::precalculate_positions(unsigned int m, unsigned int n, int *rows, int *cols, int *positions) const
     {
       for (unsigned int i = 0; i < m; i++)       // rows
         for (unsigned int j = 0; j < n; j++)     // cols
+        {
           if(rows[i] >= 0 && cols[j] >= 0) // not Dir. dofs.
-            add(rows[i], cols[j], mat[i][j]);
+          {
+            int pos = find_position(Ai + Ap[cols[j]], Ap[cols[j] + 1] - Ap[cols[j]], rows[i]);
+            if(pos < 0)
+              throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", rows[i], cols[j]);
+            positions[i * n + j] = Ap[cols[j]] + pos;
+          }
+          else
+            positions[i * n + j] = -1;
+        }
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::add_at_positions(unsigned int m, unsigned int n, Scalar **mat, const int *positions)
+    {
+      split_values_stale = true;
+      for (unsigned int i = 0; i < m; i++)       // rows
+        for (unsigned int j = 0; j < n; j++)     // cols
+        {
+          if(positions[i * n + j] < 0)
+            continue;
+          if(mat[i][j] == 0.0)   // ignore zero values.
+            continue;
+          add_entry(Ax + positions[i * n + j], mat[i][j]);
+        }
     }
 
     double inline real(double x)
@@ -359,25 +708,36 @@ namespace Hermes
 
       case DF_MATRIX_MARKET:
         {
-          fprintf(file, "%%%%Matrix<Scalar>Market matrix coordinate real symmetric\n");
+          fprintf(file, "%%%%MatrixMarket matrix coordinate real symmetric\n");
           int nnz_sym = 0;
           for (unsigned int j = 0; j < this->size; j++)
             for (int i = Ap[j]; i < Ap[j + 1]; i++)
               if((int)j <= Ai[i]) nnz_sym++;
           fprintf(file, "%d %d %d\n", this->size, this->size, nnz_sym);
+
+          // Format the entries into one large buffer and write it out in blocks;
+          // a stdio call per nonzero dominates the dump time for large matrices.
+          const int buffer_size = 1 << 20;
+          char* buffer = new char[buffer_size];
+          int buffered = 0;
           for (unsigned int j = 0; j < this->size; j++)
             for (int i = Ap[j]; i < Ap[j + 1]; i++)
-              // The following line was replaced with the one below, because it gave a warning
-              // to cause code abort at runtime.
-              //if(j <= Ai[i]) fprintf(file, "%d %d %24.15e\n", Ai[i] + 1, j + 1, Ax[i]);
               if((int)j <= Ai[i])
               {
-                fprintf(file, "%d %d ", Ai[i] + 1, (int)j + 1);
-                Hermes::Helpers::fprint_num(file, Ax[i], number_format);
-                fprintf(file, "\n");
+                buffered += sprintf(buffer + buffered, "%d %d ", Ai[i] + 1, (int)j + 1);
+                buffered += sprintf(buffer + buffered, number_format, Ax[i]);
+                buffer[buffered++] = '\n';
+                if(buffered > buffer_size - 128)
+                {
+                  fwrite(buffer, 1, buffered, file);
+                  buffered = 0;
+                }
               }
+          if(buffered > 0)
+            fwrite(buffer, 1, buffered, file);
+          delete [] buffer;
 
-              return true;
+          return true;
         }
 
       case DF_HERMES_BIN:
@@ -464,25 +824,38 @@ namespace Hermes
 
       case DF_MATRIX_MARKET:
         {
-          fprintf(file, "%%%%Matrix<Scalar>Market matrix coordinate real symmetric\n");
+          fprintf(file, "%%%%MatrixMarket matrix coordinate complex symmetric\n");
           int nnz_sym = 0;
           for (unsigned int j = 0; j < this->size; j++)
             for (int i = Ap[j]; i < Ap[j + 1]; i++)
               if((int)j <= Ai[i]) nnz_sym++;
           fprintf(file, "%d %d %d\n", this->size, this->size, nnz_sym);
+
+          // Format the entries into one large buffer and write it out in blocks;
+          // a stdio call per nonzero dominates the dump time for large matrices.
+          const int buffer_size = 1 << 20;
+          char* buffer = new char[buffer_size];
+          int buffered = 0;
           for (unsigned int j = 0; j < this->size; j++)
             for (int i = Ap[j]; i < Ap[j + 1]; i++)
-              // The following line was replaced with the one below, because it gave a warning
-              // to cause code abort at runtime.
-              //if(j <= Ai[i]) fprintf(file, "%d %d %24.15e\n", Ai[i] + 1, j + 1, Ax[i]);
               if((int)j <= Ai[i])
               {
-                fprintf(file, "%d %d ", Ai[i] + 1, (int)j + 1);
-                Hermes::Helpers::fprint_num(file, Ax[i], number_format);
-                fprintf(file, "\n");
+                buffered += sprintf(buffer + buffered, "%d %d ", Ai[i] + 1, (int)j + 1);
+                buffered += sprintf(buffer + buffered, number_format, Ax[i].real());
+                buffer[buffered++] = ' ';
+                buffered += sprintf(buffer + buffered, number_format, Ax[i].imag());
+                buffer[buffered++] = '\n';
+                if(buffered > buffer_size - 256)
+                {
+                  fwrite(buffer, 1, buffered, file);
+                  buffered = 0;
+                }
               }
+          if(buffered > 0)
+            fwrite(buffer, 1, buffered, file);
+          delete [] buffer;
 
-              return true;
+          return true;
         }
 
       case DF_HERMES_BIN:
@@ -560,9 +933,33 @@ namespace Hermes
       return nnz / (double) (this->size * this->size);
     }
 
+    template<typename Scalar>
+    size_t CSCMatrix<Scalar>::get_memory_bytes() const
+    {
+      size_t bytes = sizeof(*this);
+      if(Ap != NULL)
+        bytes += (size_t) (this->size + 1) * sizeof(int);
+      if(Ai != NULL)
+        bytes += (size_t) nnz * sizeof(int);
+      if(Ax != NULL)
+        bytes += (size_t) nnz * sizeof(Scalar);
+      if(Cp != NULL)
+        bytes += (size_t) (this->size + 1) * sizeof(int) + 2 * (size_t) nnz * sizeof(int);
+      if(this->pages != NULL)
+      {
+        bytes += (size_t) this->size * sizeof(typename SparseMatrix<Scalar>::Page*);
+        for (unsigned int i = 0; i < this->size; i++)
+          for (typename SparseMatrix<Scalar>::Page* page = this->pages[i]; page != NULL; page = page->next)
+            bytes += sizeof(typename SparseMatrix<Scalar>::Page);
+      }
+      return bytes;
+    }
+
     template<typename Scalar>
     void CSCMatrix<Scalar>::create(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax)
     {
+      free_csr_mirror();
+      free_split_values();
       this->nnz = nnz;
       this->size = size;
       this->Ap = new int[this->size + 1]; assert(this->Ap != NULL);
@@ -599,9 +996,158 @@ namespace Hermes
     template<typename Scalar>
     Scalar *CSCMatrix<Scalar>::get_Ax()
     {
+      // The caller may write through this pointer.
+      split_values_stale = true;
       return this->Ax;
     }
 
+    template<typename Scalar>
+    CSCMatrix<Scalar>* CSCMatrix<Scalar>::extract_submatrix(unsigned int sub_size, const int* sub_dofs, int** glob_to_sub_out) const
+    {
+      if(sub_size == 0 || sub_size > this->size)
+        throw Hermes::Exceptions::ValueException("sub_size", sub_size, 1, this->size);
+
+      // Inverse index map: global dof -> position in the subset, -1 outside.
+      int* glob_to_sub = new int[this->size];
+      for(unsigned int i = 0; i < this->size; i++)
+        glob_to_sub[i] = -1;
+      for(unsigned int i = 0; i < sub_size; i++)
+      {
+        if(sub_dofs[i] < 0 || sub_dofs[i] >= (int)this->size)
+        {
+          delete [] glob_to_sub;
+          throw Hermes::Exceptions::ValueException("sub_dofs", sub_dofs[i], 0, this->size - 1);
+        }
+        if(i > 0 && sub_dofs[i] <= sub_dofs[i - 1])
+        {
+          delete [] glob_to_sub;
+          throw Hermes::Exceptions::Exception("The dof subset of extract_submatrix() must be strictly increasing.");
+        }
+        glob_to_sub[sub_dofs[i]] = i;
+      }
+
+      // Count the kept entries of every selected column, then fill. Since the
+      // subset is increasing and the columns are row-sorted, the submatrix
+      // columns come out row-sorted as well.
+      int* sub_Ap = new int[sub_size + 1];
+      sub_Ap[0] = 0;
+      for(unsigned int j = 0; j < sub_size; j++)
+      {
+        int cnt = 0;
+        for(int k = Ap[sub_dofs[j]]; k < Ap[sub_dofs[j] + 1]; k++)
+          if(glob_to_sub[Ai[k]] >= 0)
+            cnt++;
+        sub_Ap[j + 1] = sub_Ap[j] + cnt;
+      }
+
+      int sub_nnz = sub_Ap[sub_size];
+      int* sub_Ai = new int[sub_nnz];
+      Scalar* sub_Ax = new Scalar[sub_nnz];
+      int pos = 0;
+      for(unsigned int j = 0; j < sub_size; j++)
+        for(int k = Ap[sub_dofs[j]]; k < Ap[sub_dofs[j] + 1]; k++)
+          if(glob_to_sub[Ai[k]] >= 0)
+          {
+            sub_Ai[pos] = glob_to_sub[Ai[k]];
+            sub_Ax[pos++] = Ax[k];
+          }
+
+      CSCMatrix<Scalar>* sub = new CSCMatrix<Scalar>();
+      sub->create(sub_size, sub_nnz, sub_Ap, sub_Ai, sub_Ax);
+      delete [] sub_Ap;
+      delete [] sub_Ai;
+      delete [] sub_Ax;
+
+      if(glob_to_sub_out != NULL)
+        *glob_to_sub_out = glob_to_sub;
+      else
+        delete [] glob_to_sub;
+
+      return sub;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::gather_sub_vector(unsigned int sub_size, const int* sub_dofs, const Scalar* v, Scalar* v_sub)
+    {
+      for(unsigned int i = 0; i < sub_size; i++)
+        v_sub[i] = v[sub_dofs[i]];
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::scatter_sub_vector(unsigned int sub_size, const int* sub_dofs, const Scalar* v_sub, Scalar* v)
+    {
+      for(unsigned int i = 0; i < sub_size; i++)
+        v[sub_dofs[i]] = v_sub[i];
+    }
+
+    template<typename Scalar>
+    unsigned int CSCMatrix<Scalar>::extract_col_view(unsigned int col, int*& rows, Scalar*& vals)
+    {
+      rows = this->Ai + this->Ap[col];
+      vals = this->Ax + this->Ap[col];
+      return this->Ap[col + 1] - this->Ap[col];
+    }
+
+    template<typename Scalar>
+    unsigned int CSCMatrix<Scalar>::extract_row_view(unsigned int row, int*& cols, int*& positions)
+    {
+      if(this->Cp == NULL)
+        this->build_csr_mirror();
+      cols = this->Ci + this->Cp[row];
+      positions = this->Cperm + this->Cp[row];
+      return this->Cp[row + 1] - this->Cp[row];
+    }
+
+    template<typename Scalar>
+    int CSCMatrix<Scalar>::get_num_col_entries(unsigned int col)
+    {
+      return this->Ap[col + 1] - this->Ap[col];
+    }
+
+    template<typename Scalar>
+    int CSCMatrix<Scalar>::get_num_row_entries(unsigned int row)
+    {
+      if(this->Cp == NULL)
+        this->build_csr_mirror();
+      return this->Cp[row + 1] - this->Cp[row];
+    }
+
+    template<>
+    void CSCMatrix<double>::extract_col_copy(unsigned int col, unsigned int len, unsigned int &n_entries, double *vals, unsigned int *idxs)
+    {
+      n_entries = 0;
+      for (int i = this->Ap[col]; i < this->Ap[col + 1] && n_entries < len; i++)
+      {
+        vals[n_entries] = this->Ax[i];
+        idxs[n_entries++] = this->Ai[i];
+      }
+    }
+
+    template<>
+    void CSCMatrix<std::complex<double> >::extract_col_copy(unsigned int col, unsigned int len, unsigned int &n_entries, double *vals, unsigned int *idxs)
+    {
+      throw Hermes::Exceptions::Exception("CSCMatrix<std::complex<double> >::extract_col_copy() not available, use extract_col_view().");
+    }
+
+    template<>
+    void CSCMatrix<double>::extract_row_copy(unsigned int row, unsigned int len, unsigned int &n_entries, double *vals, unsigned int *idxs)
+    {
+      if(this->Cp == NULL)
+        this->build_csr_mirror();
+      n_entries = 0;
+      for (int i = this->Cp[row]; i < this->Cp[row + 1] && n_entries < len; i++)
+      {
+        vals[n_entries] = this->Ax[this->Cperm[i]];
+        idxs[n_entries++] = this->Ci[i];
+      }
+    }
+
+    template<>
+    void CSCMatrix<std::complex<double> >::extract_row_copy(unsigned int row, unsigned int len, unsigned int &n_entries, double *vals, unsigned int *idxs)
+    {
+      throw Hermes::Exceptions::Exception("CSCMatrix<std::complex<double> >::extract_row_copy() not available, use extract_row_view().");
+    }
+
     template<typename Scalar>
     UMFPackVector<Scalar>::UMFPackVector()
     {
@@ -628,26 +1174,28 @@ namespace Hermes
     {
       free();
       this->size = n;
-      v = new Scalar[n];
+      // Aligned allocation - the entry loops below and the kernels of common.h
+      // then run on SIMD-aligned buffers.
+      v = new_with_alignment<Scalar>(n);
       this->zero();
     }
 
     template<typename Scalar>
     void UMFPackVector<Scalar>::zero()
     {
-      memset(v, 0, this->size * sizeof(Scalar));
+      zero_with_first_touch(v, this->size);
     }
 
     template<typename Scalar>
     void UMFPackVector<Scalar>::change_sign()
     {
-      for (unsigned int i = 0; i < this->size; i++) v[i] *= -1.;
+      vector_scale(this->size, Scalar(-1.0), v);
     }
 
     template<typename Scalar>
     void UMFPackVector<Scalar>::free()
     {
-      delete [] v;
+      free_with_alignment(v);
       v = NULL;
       this->size = 0;
     }
@@ -695,13 +1243,17 @@ namespace Hermes
     void UMFPackVector<Scalar>::add_vector(Vector<Scalar>* vec)
     {
       assert(this->length() == vec->length());
-      for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec->get(i);
+      UMFPackVector<Scalar>* umfpack_vec = dynamic_cast<UMFPackVector<Scalar>*>(vec);
+      if(umfpack_vec != NULL)
+        vector_axpy(this->length(), Scalar(1.0), umfpack_vec->v, this->v);
+      else
+        for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec->get(i);
     }
 
     template<typename Scalar>
     void UMFPackVector<Scalar>::add_vector(Scalar* vec)
     {
-      for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec[i];
+      vector_axpy(this->length(), Scalar(1.0), vec, this->v);
     }
 
     template<typename Scalar>
@@ -725,6 +1277,18 @@ namespace Hermes
         fprintf(file, " ];\n");
         return true;
 
+      case DF_MATRIX_MARKET:
+        {
+          fprintf(file, "%%%%MatrixMarket matrix array real general\n");
+          fprintf(file, "%d 1\n", this->size);
+          for (unsigned int i = 0; i < this->size; i++)
+          {
+            Hermes::Helpers::fprint_num(file, v[i], number_format);
+            fprintf(file, "\n");
+          }
+          return true;
+        }
+
       case DF_HERMES_BIN:
         {
           hermes_fwrite("HERMESR\001", 1, 8, file);
@@ -767,6 +1331,20 @@ namespace Hermes
         fprintf(file, " ];\n");
         return true;
 
+      case DF_MATRIX_MARKET:
+        {
+          fprintf(file, "%%%%MatrixMarket matrix array complex general\n");
+          fprintf(file, "%d 1\n", this->size);
+          for (unsigned int i = 0; i < this->size; i++)
+          {
+            fprintf(file, number_format, v[i].real());
+            fprintf(file, " ");
+            fprintf(file, number_format, v[i].imag());
+            fprintf(file, "\n");
+          }
+          return true;
+        }
+
       case DF_HERMES_BIN:
         {
           hermes_fwrite("HERMESR\001", 1, 8, file);
@@ -874,6 +1452,9 @@ namespace Hermes
       else
         eff_fact_scheme = factorization_scheme;
 
+      if(eff_fact_scheme != HERMES_FACTORIZE_FROM_SCRATCH)
+        HERMES_PROFILE_INCREMENT(factorization_reuses);
+
       int status;
       switch(eff_fact_scheme)
       {
@@ -892,10 +1473,27 @@ namespace Hermes
 
       case HERMES_REUSE_MATRIX_REORDERING:
       case HERMES_REUSE_MATRIX_REORDERING_AND_SCALING:
-        if(numeric != NULL) umfpack_di_free_numeric(&numeric);
+        if(numeric != NULL)
+        {
+          // An object owned by the factorization cache must stay alive there.
+          if(numeric_is_cached(numeric))
+            numeric = NULL;
+          else
+            umfpack_di_free_numeric(&numeric);
+        }
 
         //debug_log("Factorizing numerically.");
-        status = umfpack_di_numeric(m->get_Ap(), m->get_Ai(), m->get_Ax(), symbolic, &numeric, NULL, NULL);
+        if(drop_tolerance > 0.)
+        {
+          // Approximate factorization - small entries of the factors are dropped,
+          // the accuracy is recovered by the iterative refinement during solve().
+          double control[UMFPACK_CONTROL];
+          umfpack_di_defaults(control);
+          control[UMFPACK_DROPTOL] = drop_tolerance;
+          status = umfpack_di_numeric(m->get_Ap(), m->get_Ai(), m->get_Ax(), symbolic, &numeric, control, NULL);
+        }
+        else
+          status = umfpack_di_numeric(m->get_Ap(), m->get_Ai(), m->get_Ax(), symbolic, &numeric, NULL, NULL);
         if(status != UMFPACK_OK)
         {
           check_status("umfpack_di_numeric", status);
@@ -910,14 +1508,211 @@ namespace Hermes
 
     template<typename Scalar>
     UMFPackLinearMatrixSolver<Scalar>::UMFPackLinearMatrixSolver(UMFPackMatrix<Scalar> *m, UMFPackVector<Scalar> *rhs)
-      : DirectSolver<Scalar>(HERMES_FACTORIZE_FROM_SCRATCH), m(m), rhs(rhs), symbolic(NULL), numeric(NULL)
+      : DirectSolver<Scalar>(HERMES_FACTORIZE_FROM_SCRATCH), m(m), rhs(rhs), symbolic(NULL), numeric(NULL),
+      refinement_max_steps(0), refinement_tolerance(0.), drop_tolerance(0.),
+      factorization_cache(NULL), factorization_cache_capacity(0), factorization_cache_size(0),
+      factorization_cache_next(0), factorization_cache_threshold(0.)
+    {
+      }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::set_refinement(int max_steps, double tolerance)
+    {
+      if(max_steps < 1)
+        throw Exceptions::ValueException("max_steps", max_steps, 1);
+      refinement_max_steps = max_steps;
+      refinement_tolerance = tolerance;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::disable_refinement()
+    {
+      refinement_max_steps = 0;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::set_drop_tolerance(double droptol)
     {
+      drop_tolerance = droptol;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::set_factorization_cache(int capacity, double threshold)
+    {
+      if(capacity < 1)
+        throw Exceptions::ValueException("capacity", capacity, 1);
+      if(threshold <= 0.)
+        throw Exceptions::ValueException("threshold", threshold, 0.0);
+      free_factorization_cache();
+      factorization_cache = new CachedFactorization[capacity];
+      for (int i = 0; i < capacity; i++)
+      {
+        factorization_cache[i].numeric = NULL;
+        factorization_cache[i].fingerprint = NULL;
+        factorization_cache[i].values_norm = 0.;
+        factorization_cache[i].size = 0;
+        factorization_cache[i].nnz = 0;
       }
+      factorization_cache_capacity = capacity;
+      factorization_cache_threshold = threshold;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::disable_factorization_cache()
+    {
+      free_factorization_cache();
+    }
+
+    template<>
+    void UMFPackLinearMatrixSolver<double>::free_cached_numeric(void*& numeric_object)
+    {
+      if(numeric_object != NULL)
+        umfpack_di_free_numeric(&numeric_object);
+      numeric_object = NULL;
+    }
+
+    template<>
+    void UMFPackLinearMatrixSolver<std::complex<double> >::free_cached_numeric(void*& numeric_object)
+    {
+      if(numeric_object != NULL)
+        umfpack_zi_free_numeric(&numeric_object);
+      numeric_object = NULL;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::free_factorization_cache()
+    {
+      if(factorization_cache == NULL)
+        return;
+      for (int i = 0; i < factorization_cache_size; i++)
+      {
+        // The solver itself may still point at a cached object - do not leave it dangling.
+        if(factorization_cache[i].numeric == numeric)
+          numeric = NULL;
+        free_cached_numeric(factorization_cache[i].numeric);
+        delete [] factorization_cache[i].fingerprint;
+      }
+      delete [] factorization_cache;
+      factorization_cache = NULL;
+      factorization_cache_capacity = 0;
+      factorization_cache_size = 0;
+      factorization_cache_next = 0;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::compute_fingerprint(double* fingerprint, double& values_norm) const
+    {
+      unsigned int nnz = m->get_nnz();
+      Scalar* values = m->get_Ax();
+      for (int b = 0; b < fingerprint_size; b++)
+        fingerprint[b] = 0.;
+      values_norm = 0.;
+      if(nnz == 0)
+        return;
+      // Contiguous blocks of the value array - the pattern is fixed within a sweep,
+      // so corresponding blocks of successive matrices condense the same entries.
+      for (unsigned int i = 0; i < nnz; i++)
+      {
+        double magnitude = std::abs(values[i]);
+        fingerprint[(int)((long long) i * fingerprint_size / nnz)] += magnitude;
+        values_norm += magnitude;
+      }
+    }
+
+    template<typename Scalar>
+    int UMFPackLinearMatrixSolver<Scalar>::find_compatible_factorization(const double* fingerprint, double values_norm) const
+    {
+      for (int i = 0; i < factorization_cache_size; i++)
+      {
+        // The factors belong to a matrix of a fixed dimension - anything but an
+        // exact size and fill match disqualifies the entry outright.
+        if(factorization_cache[i].size != m->get_size() || factorization_cache[i].nnz != m->get_nnz())
+          continue;
+        double difference = 0.;
+        for (int b = 0; b < fingerprint_size; b++)
+          difference += std::abs(fingerprint[b] - factorization_cache[i].fingerprint[b]);
+        double scale = std::max(values_norm, factorization_cache[i].values_norm);
+        if(difference <= factorization_cache_threshold * scale)
+          return i;
+      }
+      return -1;
+    }
+
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::store_factorization(const double* fingerprint, double values_norm)
+    {
+      if(numeric == NULL || numeric_is_cached(numeric))
+        return;
+      CachedFactorization& entry = factorization_cache[factorization_cache_next];
+      if(factorization_cache_size < factorization_cache_capacity)
+        factorization_cache_size++;
+      else
+        free_cached_numeric(entry.numeric);
+      if(entry.fingerprint == NULL)
+        entry.fingerprint = new double[fingerprint_size];
+      memcpy(entry.fingerprint, fingerprint, fingerprint_size * sizeof(double));
+      entry.values_norm = values_norm;
+      entry.size = m->get_size();
+      entry.nnz = m->get_nnz();
+      // The cache takes the ownership; #numeric keeps pointing at the object and
+      // the guarded frees elsewhere leave it alone.
+      entry.numeric = numeric;
+      factorization_cache_next = (factorization_cache_next + 1) % factorization_cache_capacity;
+    }
+
+    template<typename Scalar>
+    bool UMFPackLinearMatrixSolver<Scalar>::numeric_is_cached(void* numeric_object) const
+    {
+      for (int i = 0; i < factorization_cache_size; i++)
+        if(factorization_cache[i].numeric == numeric_object)
+          return true;
+      return false;
+    }
+
+    template<typename Scalar>
+    double UMFPackLinearMatrixSolver<Scalar>::refine_solution(Scalar* x, Scalar* b)
+    {
+      unsigned int size = m->get_size();
+      Scalar* residual = new Scalar[size];
+      Scalar* correction = new Scalar[size];
+
+      double rhs_norm = 0.;
+      for (unsigned int i = 0; i < size; i++)
+        rhs_norm += std::abs(b[i]) * std::abs(b[i]);
+      rhs_norm = sqrt(rhs_norm);
+
+      double relative_residual = (rhs_norm > 0.) ? 1.0 : 0.;
+      for (int step = 0; rhs_norm > 0. && step < refinement_max_steps; step++)
+      {
+        // The residual is accumulated in full precision by the sparse
+        // matrix-vector product, independently of the factorization.
+        m->multiply_with_vector(x, residual);
+        double residual_norm = 0.;
+        for (unsigned int i = 0; i < size; i++)
+        {
+          residual[i] = b[i] - residual[i];
+          residual_norm += std::abs(residual[i]) * std::abs(residual[i]);
+        }
+        relative_residual = sqrt(residual_norm) / rhs_norm;
+        if(relative_residual < refinement_tolerance)
+          break;
+
+        if(!back_substitute(correction, residual))
+          break;
+        for (unsigned int i = 0; i < size; i++)
+          x[i] += correction[i];
+      }
+
+      delete [] residual;
+      delete [] correction;
+      return relative_residual;
+    }
 
     template<typename Scalar>
     UMFPackLinearMatrixSolver<Scalar>::~UMFPackLinearMatrixSolver()
     {
       free_factorization_data();
+      free_factorization_cache();
     }
 
     template<typename Scalar>
@@ -926,6 +1721,15 @@ namespace Hermes
       return m->get_size();
     }
 
+    template<typename Scalar>
+    void UMFPackLinearMatrixSolver<Scalar>::retarget(Matrix<Scalar>* matrix, Vector<Scalar>* rhs)
+    {
+      if(matrix == NULL)
+        throw Exceptions::NullException(1);
+      this->m = static_cast<UMFPackMatrix<Scalar>*>(matrix);
+      this->rhs = static_cast<UMFPackVector<Scalar>*>(rhs);
+    }
+
     template<>
     bool UMFPackLinearMatrixSolver<std::complex<double> >::setup_factorization()
     {
@@ -936,6 +1740,9 @@ namespace Hermes
       else
         eff_fact_scheme = factorization_scheme;
 
+      if(eff_fact_scheme != HERMES_FACTORIZE_FROM_SCRATCH)
+        HERMES_PROFILE_INCREMENT(factorization_reuses);
+
       int status;
       switch(eff_fact_scheme)
       {
@@ -955,9 +1762,25 @@ namespace Hermes
         case HERMES_REUSE_MATRIX_REORDERING:
         case HERMES_REUSE_MATRIX_REORDERING_AND_SCALING:
           if(numeric != NULL)
-            umfpack_zi_free_numeric(&numeric);
+          {
+            // An object owned by the factorization cache must stay alive there.
+            if(numeric_is_cached(numeric))
+              numeric = NULL;
+            else
+              umfpack_zi_free_numeric(&numeric);
+          }
 
-        status = umfpack_zi_numeric(m->get_Ap(), m->get_Ai(), (double *) m->get_Ax(), NULL, symbolic, &numeric, NULL, NULL);
+        if(drop_tolerance > 0.)
+        {
+          // Approximate factorization - small entries of the factors are dropped,
+          // the accuracy is recovered by the iterative refinement during solve().
+          double control[UMFPACK_CONTROL];
+          umfpack_zi_defaults(control);
+          control[UMFPACK_DROPTOL] = drop_tolerance;
+          status = umfpack_zi_numeric(m->get_Ap(), m->get_Ai(), (double *) m->get_Ax(), NULL, symbolic, &numeric, control, NULL);
+        }
+        else
+          status = umfpack_zi_numeric(m->get_Ap(), m->get_Ai(), (double *) m->get_Ax(), NULL, symbolic, &numeric, NULL, NULL);
         if(status != UMFPACK_OK)
         {
           check_status("umfpack_di_numeric", status);
@@ -975,7 +1798,8 @@ namespace Hermes
     {
       if(symbolic != NULL) umfpack_di_free_symbolic(&symbolic);
       symbolic = NULL;
-      if(numeric != NULL) umfpack_di_free_numeric(&numeric);
+      if(numeric != NULL && !numeric_is_cached(numeric))
+        umfpack_di_free_numeric(&numeric);
       numeric = NULL;
     }
 
@@ -984,10 +1808,35 @@ namespace Hermes
     {
       if(symbolic != NULL) umfpack_zi_free_symbolic(&symbolic);
       symbolic = NULL;
-      if(numeric != NULL) umfpack_zi_free_numeric(&numeric);
+      if(numeric != NULL && !numeric_is_cached(numeric))
+        umfpack_zi_free_numeric(&numeric);
       numeric = NULL;
     }
 
+    template<>
+    bool UMFPackLinearMatrixSolver<double>::back_substitute(double* x, double* b)
+    {
+      int status = umfpack_di_solve(UMFPACK_A, m->get_Ap(), m->get_Ai(), m->get_Ax(), x, b, numeric, NULL, NULL);
+      if(status != UMFPACK_OK)
+      {
+        check_status("umfpack_di_solve", status);
+        return false;
+      }
+      return true;
+    }
+
+    template<>
+    bool UMFPackLinearMatrixSolver<std::complex<double> >::back_substitute(std::complex<double>* x, std::complex<double>* b)
+    {
+      int status = umfpack_zi_solve(UMFPACK_A, m->get_Ap(), m->get_Ai(), (double *)m->get_Ax(), NULL, (double*) x, NULL, (double *) b, NULL, numeric, NULL, NULL);
+      if(status != UMFPACK_OK)
+      {
+        check_status("umfpack_zi_solve", status);
+        return false;
+      }
+      return true;
+    }
+
     template<>
     bool UMFPackLinearMatrixSolver<double>::solve()
     {
@@ -997,6 +1846,49 @@ namespace Hermes
 
       this->tick();
 
+      // With the factorization cache on, try the factors of a nearby cached matrix
+      // first: a back substitution plus refinement against the current matrix then
+      // replaces the numeric refactorization, \sa set_factorization_cache().
+      double fingerprint[fingerprint_size];
+      double values_norm = 0.;
+      if(factorization_cache_capacity > 0)
+      {
+        compute_fingerprint(fingerprint, values_norm);
+        int slot = find_compatible_factorization(fingerprint, values_norm);
+        if(slot >= 0)
+        {
+          if(sln != NULL)
+            delete [] sln;
+          sln = new double[m->get_size()];
+          memset(sln, 0, m->get_size() * sizeof(double));
+          int status = umfpack_di_solve(UMFPACK_A, m->get_Ap(), m->get_Ai(), m->get_Ax(), sln, rhs->get_c_array(), factorization_cache[slot].numeric, NULL, NULL);
+          if(status == UMFPACK_OK)
+          {
+            void* own_numeric = numeric;
+            int own_max_steps = refinement_max_steps;
+            double own_tolerance = refinement_tolerance;
+            numeric = factorization_cache[slot].numeric;
+            if(refinement_max_steps == 0)
+            {
+              refinement_max_steps = 5;
+              refinement_tolerance = 1e-12;
+            }
+            bool accurate = refine_solution(sln, rhs->get_c_array()) <= refinement_tolerance;
+            numeric = own_numeric;
+            refinement_max_steps = own_max_steps;
+            refinement_tolerance = own_tolerance;
+            if(accurate)
+            {
+              HERMES_PROFILE_INCREMENT(factorization_reuses);
+              this->tick();
+              time = this->accumulated();
+              return true;
+            }
+            // The cached factors did not reach the tolerance - refactorize below.
+          }
+        }
+      }
+
       if( !setup_factorization() )
         throw Exceptions::LinearMatrixSolverException("LU factorization could not be completed.");
 
@@ -1011,6 +1903,12 @@ namespace Hermes
         return false;
       }
 
+      if(refinement_max_steps > 0)
+        refine_solution(sln, rhs->get_c_array());
+
+      if(factorization_cache_capacity > 0)
+        store_factorization(fingerprint, values_norm);
+
       this->tick();
       time = this->accumulated();
 
@@ -1025,6 +1923,50 @@ namespace Hermes
       assert(m->get_size() == rhs->length());
 
       this->tick();
+
+      // With the factorization cache on, try the factors of a nearby cached matrix
+      // first: a back substitution plus refinement against the current matrix then
+      // replaces the numeric refactorization, \sa set_factorization_cache().
+      double fingerprint[fingerprint_size];
+      double values_norm = 0.;
+      if(factorization_cache_capacity > 0)
+      {
+        compute_fingerprint(fingerprint, values_norm);
+        int slot = find_compatible_factorization(fingerprint, values_norm);
+        if(slot >= 0)
+        {
+          if(sln)
+            delete [] sln;
+          sln = new std::complex<double>[m->get_size()];
+          memset(sln, 0, m->get_size() * sizeof(std::complex<double>));
+          int status = umfpack_zi_solve(UMFPACK_A, m->get_Ap(), m->get_Ai(), (double *)m->get_Ax(), NULL, (double*) sln, NULL, (double *)rhs->get_c_array(), NULL, factorization_cache[slot].numeric, NULL, NULL);
+          if(status == UMFPACK_OK)
+          {
+            void* own_numeric = numeric;
+            int own_max_steps = refinement_max_steps;
+            double own_tolerance = refinement_tolerance;
+            numeric = factorization_cache[slot].numeric;
+            if(refinement_max_steps == 0)
+            {
+              refinement_max_steps = 5;
+              refinement_tolerance = 1e-12;
+            }
+            bool accurate = refine_solution(sln, rhs->get_c_array()) <= refinement_tolerance;
+            numeric = own_numeric;
+            refinement_max_steps = own_max_steps;
+            refinement_tolerance = own_tolerance;
+            if(accurate)
+            {
+              HERMES_PROFILE_INCREMENT(factorization_reuses);
+              this->tick();
+              time = this->accumulated();
+              return true;
+            }
+            // The cached factors did not reach the tolerance - refactorize below.
+          }
+        }
+      }
+
       if( !setup_factorization() )
       {
         this->warn("LU factorization could not be completed.");
@@ -1042,6 +1984,87 @@ namespace Hermes
         return false;
       }
 
+      if(refinement_max_steps > 0)
+        refine_solution(sln, rhs->get_c_array());
+
+      if(factorization_cache_capacity > 0)
+        store_factorization(fingerprint, values_norm);
+
+      this->tick();
+      time = this->accumulated();
+
+      return true;
+    }
+
+    template<>
+    bool UMFPackLinearMatrixSolver<double>::solve(double* rhs_block, int nrhs)
+    {
+      assert(m != NULL);
+      assert(rhs_block != NULL);
+
+      this->tick();
+
+      if( !setup_factorization() )
+        throw Exceptions::LinearMatrixSolverException("LU factorization could not be completed.");
+
+      if(sln != NULL)
+        delete [] sln;
+      sln = new double[m->get_size() * nrhs];
+      memset(sln, 0, m->get_size() * nrhs * sizeof(double));
+
+      // UMFPACK has no blocked back-substitution, the columns are passed one by one
+      // against the single factorization computed above.
+      for(int k = 0; k < nrhs; k++)
+      {
+        int status = umfpack_di_solve(UMFPACK_A, m->get_Ap(), m->get_Ai(), m->get_Ax(), sln + k * m->get_size(), rhs_block + k * m->get_size(), numeric, NULL, NULL);
+        if(status != UMFPACK_OK)
+        {
+          check_status("umfpack_di_solve", status);
+          return false;
+        }
+        if(refinement_max_steps > 0)
+          refine_solution(sln + k * m->get_size(), rhs_block + k * m->get_size());
+      }
+
+      this->tick();
+      time = this->accumulated();
+
+      return true;
+    }
+
+    template<>
+    bool UMFPackLinearMatrixSolver<std::complex<double> >::solve(std::complex<double>* rhs_block, int nrhs)
+    {
+      assert(m != NULL);
+      assert(rhs_block != NULL);
+
+      this->tick();
+
+      if( !setup_factorization() )
+      {
+        this->warn("LU factorization could not be completed.");
+        return false;
+      }
+
+      if(sln)
+        delete [] sln;
+      sln = new std::complex<double>[m->get_size() * nrhs];
+      memset(sln, 0, m->get_size() * nrhs * sizeof(std::complex<double>));
+
+      // UMFPACK has no blocked back-substitution, the columns are passed one by one
+      // against the single factorization computed above.
+      for(int k = 0; k < nrhs; k++)
+      {
+        int status = umfpack_zi_solve(UMFPACK_A, m->get_Ap(), m->get_Ai(), (double *)m->get_Ax(), NULL, (double*) (sln + k * m->get_size()), NULL, (double *)(rhs_block + k * m->get_size()), NULL, numeric, NULL, NULL);
+        if(status != UMFPACK_OK)
+        {
+          check_status("umfpack_di_solve", status);
+          return false;
+        }
+        if(refinement_max_steps > 0)
+          refine_solution(sln + k * m->get_size(), rhs_block + k * m->get_size());
+      }
+
       this->tick();
       time = this->accumulated();
 
@@ -0,0 +1,76 @@
+// This file is part of HermesCommon.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+/*! \file thread_pool.cpp
+    \brief Warm-up and affinity pinning of the shared OpenMP worker pool.
+*/
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#endif
+
+#include "thread_pool.h"
+#include "common.h"
+#include "exceptions.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace Hermes
+{
+  void warm_up_thread_pool(int num_threads)
+  {
+    if(num_threads < 1)
+      throw Hermes::Exceptions::ValueException("num_threads", num_threads, 1);
+
+    // An empty region is enough - on the way in, the runtime creates any
+    // workers it does not have yet and keeps them for all later regions.
+    int started = 0;
+#pragma omp parallel num_threads(num_threads) reduction(+:started)
+    {
+      started = 1;
+    }
+    (void) started;
+  }
+
+  void pin_thread_pool(int num_threads, int first_processor)
+  {
+    if(num_threads < 1)
+      throw Hermes::Exceptions::ValueException("num_threads", num_threads, 1);
+    if(first_processor < 0)
+      throw Hermes::Exceptions::ValueException("first_processor", first_processor, 0);
+
+    // Each worker pins itself; the region is sized like the computational
+    // regions, so exactly the threads serving those get bound.
+#pragma omp parallel num_threads(num_threads)
+    {
+      int processor = first_processor + omp_get_thread_num();
+#if defined(_WIN32)
+      SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << processor);
+#elif defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(processor, &set);
+      // Pid 0 binds the calling thread.
+      sched_setaffinity(0, sizeof(set), &set);
+#else
+      (void) processor;
+#endif
+    }
+  }
+}